@@ -0,0 +1,1157 @@
+/*
+ * FreeRTOS V202112.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://aws.amazon.com/freertos
+ *
+ */
+
+
+/*
+ * Measures the cost of the kernel primitives used most often by the
+ * application so changes to the kernel can be tracked release to release.
+ *
+ * Each benchmark is a round trip between the benchmark task and an echo task.
+ * The benchmark task signals the echo task through the primitive under test,
+ * and the echo task signals back through a second object of the same type.
+ * The time recorded for one iteration therefore covers two operations and two
+ * context switches.  The taskYIELD() benchmark uses an echo task of the same
+ * priority that yields straight back.  Every other benchmark uses an echo task
+ * one priority above the benchmark task, so each signal causes an immediate
+ * switch.
+ *
+ * Samples go into a log2 histogram.  When every benchmark has run, one CSV
+ * line per primitive is written with benchOUTPUT_STRING() in the form:
+ *
+ * bench,<name>,<samples>,<min>,<mean>,<max>,<p50>,<p99>,<bucket 0>,...
+ *
+ * All times are in benchGET_CYCLE_COUNT() units.  Bucket n counts samples in
+ * the range [2^n, 2^(n+1)).  The percentiles give the upper bound of the
+ * bucket that holds them, clipped to the maximum.
+ *
+ * When configUSE_TIMERS is 1 the cost of a timer command is also measured
+ * against the number of active timers, so the active list implementation
+ * (sorted lists or the timer wheel selected by configUSE_TIMER_WHEEL) can be
+ * compared.  Each iteration is one xTimerReset() on a timer whose expiry time
+ * is later than that of every other active timer, which is the worst case for
+ * a sorted list.  configTIMER_TASK_PRIORITY must be above the priority of the
+ * benchmark task so the timer service task processes the command before
+ * xTimerReset() returns, and configTIMER_QUEUE_LENGTH must be large enough to
+ * hold the commands that create and delete benchTIMER_COUNT_MAX timers.
+ * Running the timer benchmarks with configUSE_TIMER_DIRECT_COMMANDS set to 0
+ * and then 1 gives the time saved per command by not sending it through the
+ * timer command queue.
+ *
+ * The cost of blocking with a timeout is measured with 8, 32 and 128 other
+ * tasks already in the Blocked state, so the delayed task list implementation
+ * (sorted lists or the buckets selected by configUSE_DELAYED_TASK_BUCKETS)
+ * can be compared.  Each iteration is one ulTaskNotifyTake() with a timeout
+ * later than the wake time of every other blocked task, which is the worst
+ * case for a sorted list, and the notification from an echo task of the same
+ * priority that ends it.  The blocked tasks are created from the FreeRTOS heap
+ * while the benchmark runs.  A benchmark for which they cannot all be created
+ * is skipped and reported with zero samples.
+ *
+ * The cost of pvPortMalloc() and vPortFree() is measured once the heap has
+ * become fragmented.  benchHEAP_BLOCKS blocks of pseudo random sizes are kept
+ * allocated, and each iteration frees the oldest and allocates a replacement
+ * of a new size, timing one of the two calls.  Building the demo with heap_4.c
+ * and then heap_6.c compares the first fit free list with the segregated size
+ * classes.
+ *
+ * Frames of 64 and 256 bytes are passed round trip through a pair of queues,
+ * by copy with xQueueSend() and xQueueReceive(), and, when
+ * configUSE_QUEUE_ZERO_COPY is 1, in place with the acquire/commit and
+ * borrow/release functions.  The frame queues are created from the FreeRTOS
+ * heap while the benchmark runs.
+ *
+ * Bursts of 4 and 16 items are passed to an echo task of a higher priority,
+ * once with one xQueueSend() per item and once with a single
+ * xQueueSendMultiple(), to compare the throughput of the two.  Sent one at a
+ * time, every item makes the echo task run to receive it.  Sent as a batch,
+ * the echo task runs once and takes the whole burst with
+ * xQueueReceiveMultiple().  Each iteration ends when the echo task notifies
+ * the benchmark task that it has the whole burst.
+ *
+ * Drivers and libraries outside the kernel time their own operations with
+ * the same histograms and output by starting a suite of cases with
+ * vStartBenchmarkSuite(), as spi_flash_bench.c does.  Suites run one at a
+ * time, in the order they are started.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* Scheduler include files. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
+#include "stream_buffer.h"
+#include "timers.h"
+
+/* Demo program include files. */
+#include "serial.h"
+#include "KernelBench.h"
+
+/* Allow parameters to be overridden on a demo by demo basis. */
+#ifndef benchITERATIONS
+    #define benchITERATIONS            ( 1000UL )
+#endif
+
+#ifndef benchSTACK_SIZE
+    #define benchSTACK_SIZE            ( configMINIMAL_STACK_SIZE * 2 )
+#endif
+
+#ifndef benchOUTPUT_STRING
+    #define benchOUTPUT_STRING( pcString )    vSerialPutString( NULL, ( const signed char * ) ( pcString ), ( unsigned short ) strlen( pcString ) )
+#endif
+
+/* Time allowed for one output line to drain before the next is written. */
+#ifndef benchOUTPUT_LINE_DELAY
+    #define benchOUTPUT_LINE_DELAY     pdMS_TO_TICKS( 20 )
+#endif
+
+/* Iterations run before sampling starts so every code path is warm. */
+#define benchWARM_UP_ITERATIONS        ( 8UL )
+
+/* Number of bytes moved through the stream buffers on each iteration. */
+#define benchSTREAM_BYTES              ( 16 )
+
+/* Event group bits used for the ping and the pong directions. */
+#define benchPING_BIT                  ( ( EventBits_t ) 0x01 )
+#define benchPONG_BIT                  ( ( EventBits_t ) 0x02 )
+
+/* The largest number of active timers used by the timer benchmarks.  Each timer
+ * is allocated from the FreeRTOS heap while its benchmark runs. */
+#ifndef benchTIMER_COUNT_MAX
+    #define benchTIMER_COUNT_MAX       ( 64UL )
+#endif
+
+/* Expiry times are spread from this base so no timer expires while the
+ * benchmark runs. */
+#define benchTIMER_PERIOD_BASE         pdMS_TO_TICKS( 60000UL )
+
+/* The largest number of blocked tasks used by the delayed list benchmarks. */
+#ifndef benchBLOCKED_TASKS_MAX
+    #define benchBLOCKED_TASKS_MAX     ( 128UL )
+#endif
+
+/* Wake times of the blocked tasks are spread from this base.  The benchmark
+ * task blocks for twice as long so its wake time is after all of theirs. */
+#define benchBLOCK_TIME_BASE           pdMS_TO_TICKS( 60000UL )
+
+/* The number of blocks kept allocated by the heap benchmarks, and the range
+ * of their sizes in bytes. */
+#ifndef benchHEAP_BLOCKS
+    #define benchHEAP_BLOCKS           ( 16UL )
+#endif
+
+#define benchHEAP_BLOCK_SIZE_MIN       ( 8UL )
+#define benchHEAP_BLOCK_SIZE_RANGE     ( 120UL )
+
+/* The largest frame passed by the frame queue benchmarks. */
+#define benchFRAME_SIZE_MAX            ( 256UL )
+
+/* The longest burst sent by the burst queue benchmarks. */
+#define benchBURST_LENGTH_MAX          ( 16UL )
+
+/* Long enough for the CSV line of one benchmark. */
+#define benchLINE_LENGTH               ( 40 + ( benchHISTOGRAM_BUCKETS * 11 ) )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The task that runs each suite started in turn.  Each benchmark of a suite is
+ * run, and then the results of the suite are reported.
+ */
+static void prvBenchmarkTask( void * pvParameters );
+
+/*
+ * The task that answers each signal sent by the benchmark task.  The
+ * parameter is the BenchCase_t being run.
+ */
+static void prvEchoTask( void * pvParameters );
+
+/*
+ * Runs one benchmark and accumulates its samples into pxHistogram.
+ */
+static void prvRunCase( const BenchCase_t * pxCase,
+                        BenchHistogram_t * pxHistogram );
+
+/*
+ * Histogram helpers.
+ */
+static void prvRecordSample( BenchHistogram_t * pxHistogram,
+                             uint32_t ulCycles );
+static uint32_t prvPercentile( const BenchHistogram_t * pxHistogram,
+                               uint32_t ulPerMille );
+static void prvReportCase( const BenchCase_t * pxCase,
+                           const BenchHistogram_t * pxHistogram );
+
+/*
+ * The per iteration functions of each benchmark.
+ */
+static uint32_t prvYieldIteration( void );
+static void prvYieldEcho( void );
+static uint32_t prvQueueIteration( void );
+static void prvQueueEcho( void );
+static uint32_t prvSemaphoreIteration( void );
+static void prvSemaphoreEcho( void );
+static uint32_t prvNotifyIteration( void );
+static void prvNotifyEcho( void );
+static uint32_t prvStreamBufferIteration( void );
+static void prvStreamBufferEcho( void );
+static uint32_t prvEventGroupIteration( void );
+static void prvEventGroupEcho( void );
+static BaseType_t prvBlockedTasksSetUp( uint32_t ulTaskCount );
+static void prvBlockedTasksTearDown( void );
+static uint32_t prvTimedBlockIteration( void );
+static void prvTimedBlockEcho( void );
+static void prvBlockedTask( void * pvParameters );
+static BaseType_t prvHeapSetUp( uint32_t ulTimeFree );
+static void prvHeapTearDown( void );
+static uint32_t prvHeapIteration( void );
+static size_t prvHeapBlockSize( void );
+static BaseType_t prvFrameQueueSetUp( uint32_t ulFrameSize );
+static void prvFrameQueueTearDown( void );
+static uint32_t prvFrameCopyIteration( void );
+static void prvFrameCopyEcho( void );
+
+static BaseType_t prvBurstQueueSetUp( uint32_t ulBurstLength );
+static void prvBurstQueueTearDown( void );
+static uint32_t prvBurstLoopIteration( void );
+static void prvBurstLoopEcho( void );
+static uint32_t prvBurstMultipleIteration( void );
+static void prvBurstMultipleEcho( void );
+
+#if ( configUSE_QUEUE_ZERO_COPY == 1 )
+    static uint32_t prvFrameZeroCopyIteration( void );
+    static void prvFrameZeroCopyEcho( void );
+#endif
+
+#if ( configUSE_TIMERS == 1 )
+    static BaseType_t prvTimerSetUp( uint32_t ulTimerCount );
+    static void prvTimerTearDown( void );
+    static uint32_t prvTimerIteration( void );
+    static void prvTimerCallback( TimerHandle_t xTimer );
+#endif
+
+/*-----------------------------------------------------------*/
+
+static const BenchCase_t xBenchCases[] =
+{
+    { "taskYIELD",                  prvYieldIteration,        prvYieldEcho,        0, NULL,                 NULL,                    0   },
+    { "xQueueSend/xQueueReceive",   prvQueueIteration,        prvQueueEcho,        1, NULL,                 NULL,                    0   },
+    { "xSemaphoreGive/Take",        prvSemaphoreIteration,    prvSemaphoreEcho,    1, NULL,                 NULL,                    0   },
+    { "xTaskNotifyGive",            prvNotifyIteration,       prvNotifyEcho,       1, NULL,                 NULL,                    0   },
+    { "xStreamBufferSend/Receive",  prvStreamBufferIteration, prvStreamBufferEcho, 1, NULL,                 NULL,                    0   },
+    { "xEventGroupSetBits",         prvEventGroupIteration,   prvEventGroupEcho,   1, NULL,                 NULL,                    0   },
+    { "ulTaskNotifyTake timeout/8",   prvTimedBlockIteration, prvTimedBlockEcho,   0, prvBlockedTasksSetUp, prvBlockedTasksTearDown, 8   },
+    { "ulTaskNotifyTake timeout/32",  prvTimedBlockIteration, prvTimedBlockEcho,   0, prvBlockedTasksSetUp, prvBlockedTasksTearDown, 32  },
+    { "ulTaskNotifyTake timeout/128", prvTimedBlockIteration, prvTimedBlockEcho,   0, prvBlockedTasksSetUp, prvBlockedTasksTearDown, 128 },
+    { "pvPortMalloc fragmented",    prvHeapIteration,         NULL,                0, prvHeapSetUp,         prvHeapTearDown,         0   },
+    { "vPortFree fragmented",       prvHeapIteration,         NULL,                0, prvHeapSetUp,         prvHeapTearDown,         1   },
+    { "xQueueSend/Receive frame/64",  prvFrameCopyIteration,  prvFrameCopyEcho,    1, prvFrameQueueSetUp,   prvFrameQueueTearDown,   64  },
+    { "xQueueSend/Receive frame/256", prvFrameCopyIteration,  prvFrameCopyEcho,    1, prvFrameQueueSetUp,   prvFrameQueueTearDown,   256 },
+    #if ( configUSE_QUEUE_ZERO_COPY == 1 )
+        { "zero copy frame/64",     prvFrameZeroCopyIteration, prvFrameZeroCopyEcho, 1, prvFrameQueueSetUp, prvFrameQueueTearDown,   64  },
+        { "zero copy frame/256",    prvFrameZeroCopyIteration, prvFrameZeroCopyEcho, 1, prvFrameQueueSetUp, prvFrameQueueTearDown,   256 },
+    #endif
+    { "xQueueSend burst/4",         prvBurstLoopIteration,     prvBurstLoopEcho,     1, prvBurstQueueSetUp, prvBurstQueueTearDown, 4   },
+    { "xQueueSend burst/16",        prvBurstLoopIteration,     prvBurstLoopEcho,     1, prvBurstQueueSetUp, prvBurstQueueTearDown, 16  },
+    { "xQueueSendMultiple burst/4", prvBurstMultipleIteration, prvBurstMultipleEcho, 1, prvBurstQueueSetUp, prvBurstQueueTearDown, 4   },
+    { "xQueueSendMultiple burst/16", prvBurstMultipleIteration, prvBurstMultipleEcho, 1, prvBurstQueueSetUp, prvBurstQueueTearDown, 16  },
+    #if ( configUSE_TIMERS == 1 )
+        { "xTimerReset/4",          prvTimerIteration,        NULL,                0, prvTimerSetUp,        prvTimerTearDown,        4   },
+        { "xTimerReset/16",         prvTimerIteration,        NULL,                0, prvTimerSetUp,        prvTimerTearDown,        16  },
+        { "xTimerReset/64",         prvTimerIteration,        NULL,                0, prvTimerSetUp,        prvTimerTearDown,        64  },
+    #endif
+};
+
+#define benchNUM_CASES    ( sizeof( xBenchCases ) / sizeof( xBenchCases[ 0 ] ) )
+
+/* The objects through which the two tasks signal each other. */
+static QueueHandle_t xPingQueue = NULL, xPongQueue = NULL;
+static SemaphoreHandle_t xPingSemaphore = NULL, xPongSemaphore = NULL;
+static StreamBufferHandle_t xPingStreamBuffer = NULL, xPongStreamBuffer = NULL;
+static EventGroupHandle_t xEventGroup = NULL;
+static TaskHandle_t xBenchmarkTask = NULL, xEchoTask = NULL;
+
+/* The tasks that are kept in the Blocked state by the delayed list
+ * benchmarks. */
+static TaskHandle_t xBlockedTasks[ benchBLOCKED_TASKS_MAX ];
+static uint32_t ulBlockedTasksCreated = 0;
+
+/* Set by the benchmark task before each timed block, and cleared by the echo
+ * task as it answers. */
+static volatile BaseType_t xTimedBlockWaiting = pdFALSE;
+
+/* The blocks kept allocated by the heap benchmarks, the next to be replaced,
+ * the state of the generator for their sizes, and which call is timed. */
+static void * pvHeapBlocks[ benchHEAP_BLOCKS ];
+static uint32_t ulNextHeapBlock = 0, ulHeapSizeSeed = 0;
+static BaseType_t xTimeHeapFree = pdFALSE;
+
+/* The queues and buffers used by the frame queue benchmarks.  The buffers are
+ * not on the task stacks as the echo task has a minimal stack. */
+static QueueHandle_t xPingFrameQueue = NULL, xPongFrameQueue = NULL;
+static uint8_t ucBenchFrame[ benchFRAME_SIZE_MAX ], ucEchoFrame[ benchFRAME_SIZE_MAX ];
+
+/* The queue, items and burst length used by the burst queue benchmarks. */
+static QueueHandle_t xBurstQueue = NULL;
+static uint32_t ulBenchBurst[ benchBURST_LENGTH_MAX ], ulEchoBurst[ benchBURST_LENGTH_MAX ];
+static UBaseType_t uxBurstLength = 0;
+
+#if ( configUSE_TIMERS == 1 )
+    /* The timers used by the timer benchmarks.  The last one created is the
+     * one reset on each iteration. */
+    static TimerHandle_t xTimers[ benchTIMER_COUNT_MAX ];
+    static uint32_t ulTimersCreated = 0;
+#endif
+
+/* One histogram per benchmark.  Static as they are too large for the stack. */
+static BenchHistogram_t xHistograms[ benchNUM_CASES ];
+
+static BenchSuite_t xKernelSuite = { xBenchCases, xHistograms, ( UBaseType_t ) benchNUM_CASES, pdFALSE, NULL };
+
+/* The suites started that have not been run yet, in the order they were
+ * started, and the number that have not been reported yet. */
+static BenchSuite_t * pxFirstSuite = NULL, * pxLastSuite = NULL;
+static volatile UBaseType_t uxSuitesRunning = 0;
+
+/*-----------------------------------------------------------*/
+
+void vStartKernelBenchmarkTask( UBaseType_t uxPriority )
+{
+    xPingQueue = xQueueCreate( 1, sizeof( uint32_t ) );
+    xPongQueue = xQueueCreate( 1, sizeof( uint32_t ) );
+    xPingSemaphore = xSemaphoreCreateBinary();
+    xPongSemaphore = xSemaphoreCreateBinary();
+    xPingStreamBuffer = xStreamBufferCreate( benchSTREAM_BYTES, 1 );
+    xPongStreamBuffer = xStreamBufferCreate( benchSTREAM_BYTES, 1 );
+    xEventGroup = xEventGroupCreate();
+
+    configASSERT( xPingQueue );
+    configASSERT( xPongQueue );
+    configASSERT( xPingSemaphore );
+    configASSERT( xPongSemaphore );
+    configASSERT( xPingStreamBuffer );
+    configASSERT( xPongStreamBuffer );
+    configASSERT( xEventGroup );
+
+    vStartBenchmarkSuite( &xKernelSuite, uxPriority );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIsKernelBenchmarkComplete( void )
+{
+    return xKernelSuite.xComplete;
+}
+/*-----------------------------------------------------------*/
+
+void vStartBenchmarkSuite( BenchSuite_t * pxSuite,
+                           UBaseType_t uxPriority )
+{
+    BaseType_t xCreateTask;
+
+    pxSuite->xComplete = pdFALSE;
+    pxSuite->pxNext = NULL;
+
+    taskENTER_CRITICAL();
+    {
+        /* The task is only running while there are suites it has not
+         * reported. */
+        xCreateTask = ( uxSuitesRunning == 0U ) ? pdTRUE : pdFALSE;
+        uxSuitesRunning++;
+
+        if( pxFirstSuite == NULL )
+        {
+            pxFirstSuite = pxSuite;
+        }
+        else
+        {
+            pxLastSuite->pxNext = pxSuite;
+        }
+
+        pxLastSuite = pxSuite;
+    }
+    taskEXIT_CRITICAL();
+
+    if( xCreateTask != pdFALSE )
+    {
+        xTaskCreate( prvBenchmarkTask, "Bench", benchSTACK_SIZE, NULL, uxPriority, &xBenchmarkTask );
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xAreBenchmarksComplete( void )
+{
+    return ( uxSuitesRunning == 0U ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchmarkTask( void * pvParameters )
+{
+    BenchSuite_t * pxSuite;
+    BaseType_t xMoreSuites;
+    UBaseType_t x;
+
+    ( void ) pvParameters;
+
+    benchINIT_CYCLE_COUNTER();
+
+    do
+    {
+        taskENTER_CRITICAL();
+        {
+            pxSuite = pxFirstSuite;
+            pxFirstSuite = pxSuite->pxNext;
+        }
+        taskEXIT_CRITICAL();
+
+        for( x = 0; x < pxSuite->uxCases; x++ )
+        {
+            prvRunCase( &( pxSuite->pxCases[ x ] ), &( pxSuite->pxHistograms[ x ] ) );
+        }
+
+        for( x = 0; x < pxSuite->uxCases; x++ )
+        {
+            prvReportCase( &( pxSuite->pxCases[ x ] ), &( pxSuite->pxHistograms[ x ] ) );
+            vTaskDelay( benchOUTPUT_LINE_DELAY );
+        }
+
+        pxSuite->xComplete = pdTRUE;
+
+        taskENTER_CRITICAL();
+        {
+            uxSuitesRunning--;
+            xMoreSuites = ( uxSuitesRunning != 0U ) ? pdTRUE : pdFALSE;
+        }
+        taskEXIT_CRITICAL();
+    } while( xMoreSuites != pdFALSE );
+
+    vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunCase( const BenchCase_t * pxCase,
+                        BenchHistogram_t * pxHistogram )
+{
+    uint32_t ulIteration, ulCycles;
+    BaseType_t xReturned;
+
+    memset( pxHistogram, 0x00, sizeof( BenchHistogram_t ) );
+    pxHistogram->ulMin = UINT32_MAX;
+
+    if( pxCase->pxSetUp != NULL )
+    {
+        if( pxCase->pxSetUp( pxCase->ulParameter ) != pdPASS )
+        {
+            /* Report the benchmark with no samples. */
+            pxHistogram->ulMin = 0;
+            return;
+        }
+    }
+
+    if( pxCase->pxEchoIteration != NULL )
+    {
+        xReturned = xTaskCreate( prvEchoTask,
+                                 "Echo",
+                                 configMINIMAL_STACK_SIZE,
+                                 ( void * ) pxCase,
+                                 uxTaskPriorityGet( NULL ) + pxCase->uxEchoPriorityOffset,
+                                 &xEchoTask );
+
+        if( xReturned != pdPASS )
+        {
+            /* The set-up function may have used the remaining heap. */
+            if( pxCase->pxTearDown != NULL )
+            {
+                pxCase->pxTearDown();
+            }
+
+            pxHistogram->ulMin = 0;
+            vTaskDelay( 2 );
+            return;
+        }
+    }
+
+    for( ulIteration = 0; ulIteration < ( benchWARM_UP_ITERATIONS + benchITERATIONS ); ulIteration++ )
+    {
+        ulCycles = pxCase->pxRunIteration();
+
+        if( ulIteration >= benchWARM_UP_ITERATIONS )
+        {
+            prvRecordSample( pxHistogram, ulCycles );
+        }
+    }
+
+    if( pxCase->pxTearDown != NULL )
+    {
+        pxCase->pxTearDown();
+    }
+
+    /* Let the echo task finish its last iteration and delete itself, and let
+     * the idle task free its memory before the next benchmark. */
+    vTaskDelay( 2 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEchoTask( void * pvParameters )
+{
+    const BenchCase_t * pxCase = ( const BenchCase_t * ) pvParameters;
+    uint32_t ulIteration;
+
+    for( ulIteration = 0; ulIteration < ( benchWARM_UP_ITERATIONS + benchITERATIONS ); ulIteration++ )
+    {
+        pxCase->pxEchoIteration();
+    }
+
+    vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecordSample( BenchHistogram_t * pxHistogram,
+                             uint32_t ulCycles )
+{
+    uint32_t ulBucket = 0, ulValue = ulCycles;
+
+    while( ( ulValue > 1UL ) && ( ulBucket < ( benchHISTOGRAM_BUCKETS - 1 ) ) )
+    {
+        ulValue >>= 1UL;
+        ulBucket++;
+    }
+
+    pxHistogram->ulBuckets[ ulBucket ]++;
+    pxHistogram->ulSamples++;
+    pxHistogram->ullTotal += ulCycles;
+
+    if( ulCycles < pxHistogram->ulMin )
+    {
+        pxHistogram->ulMin = ulCycles;
+    }
+
+    if( ulCycles > pxHistogram->ulMax )
+    {
+        pxHistogram->ulMax = ulCycles;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvPercentile( const BenchHistogram_t * pxHistogram,
+                               uint32_t ulPerMille )
+{
+    uint32_t ulBucket, ulSeen = 0, ulTarget, ulUpperBound = pxHistogram->ulMax;
+
+    /* The number of samples at or below the percentile, rounded up. */
+    ulTarget = ( uint32_t ) ( ( ( ( unsigned long long ) pxHistogram->ulSamples * ulPerMille ) + 999ULL ) / 1000ULL );
+
+    for( ulBucket = 0; ulBucket < benchHISTOGRAM_BUCKETS; ulBucket++ )
+    {
+        ulSeen += pxHistogram->ulBuckets[ ulBucket ];
+
+        if( ( ulSeen >= ulTarget ) && ( ulSeen > 0UL ) )
+        {
+            if( ulBucket < ( benchHISTOGRAM_BUCKETS - 1 ) )
+            {
+                ulUpperBound = ( 2UL << ulBucket ) - 1UL;
+            }
+
+            break;
+        }
+    }
+
+    if( ulUpperBound > pxHistogram->ulMax )
+    {
+        ulUpperBound = pxHistogram->ulMax;
+    }
+
+    return ulUpperBound;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReportCase( const BenchCase_t * pxCase,
+                           const BenchHistogram_t * pxHistogram )
+{
+    static char cLine[ benchLINE_LENGTH ];
+    size_t xLength;
+    uint32_t ulBucket, ulMean = 0;
+
+    if( pxHistogram->ulSamples > 0UL )
+    {
+        ulMean = ( uint32_t ) ( pxHistogram->ullTotal / pxHistogram->ulSamples );
+    }
+
+    xLength = ( size_t ) sprintf( cLine,
+                                  "bench,%s,%lu,%lu,%lu,%lu,%lu,%lu",
+                                  pxCase->pcName,
+                                  ( unsigned long ) pxHistogram->ulSamples,
+                                  ( unsigned long ) pxHistogram->ulMin,
+                                  ( unsigned long ) ulMean,
+                                  ( unsigned long ) pxHistogram->ulMax,
+                                  ( unsigned long ) prvPercentile( pxHistogram, 500UL ),
+                                  ( unsigned long ) prvPercentile( pxHistogram, 990UL ) );
+
+    for( ulBucket = 0; ulBucket < benchHISTOGRAM_BUCKETS; ulBucket++ )
+    {
+        xLength += ( size_t ) sprintf( &( cLine[ xLength ] ), ",%lu", ( unsigned long ) pxHistogram->ulBuckets[ ulBucket ] );
+    }
+
+    sprintf( &( cLine[ xLength ] ), "\r\n" );
+    benchOUTPUT_STRING( cLine );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvYieldIteration( void )
+{
+    uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+    taskYIELD();
+
+    return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static void prvYieldEcho( void )
+{
+    taskYIELD();
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvQueueIteration( void )
+{
+    uint32_t ulValue = 0, ulStart = benchGET_CYCLE_COUNT();
+
+    xQueueSend( xPingQueue, &ulValue, portMAX_DELAY );
+    xQueueReceive( xPongQueue, &ulValue, portMAX_DELAY );
+
+    return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static void prvQueueEcho( void )
+{
+    uint32_t ulValue;
+
+    xQueueReceive( xPingQueue, &ulValue, portMAX_DELAY );
+    xQueueSend( xPongQueue, &ulValue, portMAX_DELAY );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSemaphoreIteration( void )
+{
+    uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+    xSemaphoreGive( xPingSemaphore );
+    xSemaphoreTake( xPongSemaphore, portMAX_DELAY );
+
+    return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSemaphoreEcho( void )
+{
+    xSemaphoreTake( xPingSemaphore, portMAX_DELAY );
+    xSemaphoreGive( xPongSemaphore );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvNotifyIteration( void )
+{
+    uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+    xTaskNotifyGive( xEchoTask );
+    ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+    return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static void prvNotifyEcho( void )
+{
+    ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+    xTaskNotifyGive( xBenchmarkTask );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvStreamBufferIteration( void )
+{
+    uint8_t ucData[ benchSTREAM_BYTES ];
+    uint32_t ulStart;
+
+    memset( ucData, 0x00, sizeof( ucData ) );
+    ulStart = benchGET_CYCLE_COUNT();
+
+    xStreamBufferSend( xPingStreamBuffer, ucData, sizeof( ucData ), portMAX_DELAY );
+    xStreamBufferReceive( xPongStreamBuffer, ucData, sizeof( ucData ), portMAX_DELAY );
+
+    return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static void prvStreamBufferEcho( void )
+{
+    uint8_t ucData[ benchSTREAM_BYTES ];
+    size_t xReceived;
+
+    xReceived = xStreamBufferReceive( xPingStreamBuffer, ucData, sizeof( ucData ), portMAX_DELAY );
+    xStreamBufferSend( xPongStreamBuffer, ucData, xReceived, portMAX_DELAY );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvEventGroupIteration( void )
+{
+    uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+    xEventGroupSetBits( xEventGroup, benchPING_BIT );
+    xEventGroupWaitBits( xEventGroup, benchPONG_BIT, pdTRUE, pdTRUE, portMAX_DELAY );
+
+    return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventGroupEcho( void )
+{
+    xEventGroupWaitBits( xEventGroup, benchPING_BIT, pdTRUE, pdTRUE, portMAX_DELAY );
+    xEventGroupSetBits( xEventGroup, benchPONG_BIT );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvBlockedTasksSetUp( uint32_t ulTaskCount )
+{
+    BaseType_t xReturn = pdPASS;
+
+    configASSERT( ulTaskCount <= benchBLOCKED_TASKS_MAX );
+
+    /* Each task runs as soon as it is created, as it has a priority above
+     * this task, and blocks until one tick after the task created before it. */
+    for( ulBlockedTasksCreated = 0; ulBlockedTasksCreated < ulTaskCount; ulBlockedTasksCreated++ )
+    {
+        if( xTaskCreate( prvBlockedTask,
+                         "Blocked",
+                         configMINIMAL_STACK_SIZE,
+                         ( void * ) ( size_t ) ulBlockedTasksCreated,
+                         uxTaskPriorityGet( NULL ) + 1,
+                         &( xBlockedTasks[ ulBlockedTasksCreated ] ) ) != pdPASS )
+        {
+            xReturn = pdFAIL;
+            break;
+        }
+    }
+
+    if( xReturn != pdPASS )
+    {
+        prvBlockedTasksTearDown();
+
+        /* Let the idle task free the memory of the deleted tasks. */
+        vTaskDelay( 2 );
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBlockedTasksTearDown( void )
+{
+    uint32_t ul;
+
+    for( ul = 0; ul < ulBlockedTasksCreated; ul++ )
+    {
+        vTaskDelete( xBlockedTasks[ ul ] );
+        xBlockedTasks[ ul ] = NULL;
+    }
+
+    ulBlockedTasksCreated = 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBlockedTask( void * pvParameters )
+{
+    const TickType_t xBlockTime = benchBLOCK_TIME_BASE + ( TickType_t ) ( size_t ) pvParameters;
+
+    for( ; ; )
+    {
+        vTaskDelay( xBlockTime );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTimedBlockIteration( void )
+{
+    uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+    /* The echo task runs once this task blocks, and ends the block straight
+     * away. */
+    xTimedBlockWaiting = pdTRUE;
+    ulTaskNotifyTake( pdTRUE, benchBLOCK_TIME_BASE * 2 );
+
+    return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTimedBlockEcho( void )
+{
+    /* The echo task has the same priority as the benchmark task, so it
+     * normally only runs while the benchmark task is blocked, and must yield
+     * to let the benchmark task run again.  The tick can also switch to it
+     * while the benchmark task is still running, so it only answers once the
+     * benchmark task is waiting.  Otherwise it could give one notification
+     * too many and end first, leaving the last iteration to time out. */
+    while( xTimedBlockWaiting == pdFALSE )
+    {
+        taskYIELD();
+    }
+
+    xTimedBlockWaiting = pdFALSE;
+    xTaskNotifyGive( xBenchmarkTask );
+    taskYIELD();
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvHeapSetUp( uint32_t ulTimeFree )
+{
+    BaseType_t xReturn = pdPASS;
+    uint32_t ul;
+
+    xTimeHeapFree = ( ulTimeFree != 0 ) ? pdTRUE : pdFALSE;
+
+    /* Both heap benchmarks use the same sequence of sizes. */
+    ulHeapSizeSeed = 1UL;
+    ulNextHeapBlock = 0;
+
+    for( ul = 0; ul < benchHEAP_BLOCKS; ul++ )
+    {
+        pvHeapBlocks[ ul ] = pvPortMalloc( prvHeapBlockSize() );
+
+        if( pvHeapBlocks[ ul ] == NULL )
+        {
+            xReturn = pdFAIL;
+        }
+    }
+
+    if( xReturn != pdPASS )
+    {
+        prvHeapTearDown();
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapTearDown( void )
+{
+    uint32_t ul;
+
+    for( ul = 0; ul < benchHEAP_BLOCKS; ul++ )
+    {
+        vPortFree( pvHeapBlocks[ ul ] );
+        pvHeapBlocks[ ul ] = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvHeapIteration( void )
+{
+    uint32_t ulStart, ulCycles;
+    size_t xSize = prvHeapBlockSize();
+
+    /* Replace the oldest block.  A failed allocation leaves a NULL entry,
+     * which vPortFree() ignores when it comes round again. */
+    if( xTimeHeapFree != pdFALSE )
+    {
+        ulStart = benchGET_CYCLE_COUNT();
+        vPortFree( pvHeapBlocks[ ulNextHeapBlock ] );
+        ulCycles = benchGET_CYCLE_COUNT() - ulStart;
+
+        pvHeapBlocks[ ulNextHeapBlock ] = pvPortMalloc( xSize );
+    }
+    else
+    {
+        vPortFree( pvHeapBlocks[ ulNextHeapBlock ] );
+
+        ulStart = benchGET_CYCLE_COUNT();
+        pvHeapBlocks[ ulNextHeapBlock ] = pvPortMalloc( xSize );
+        ulCycles = benchGET_CYCLE_COUNT() - ulStart;
+    }
+
+    ulNextHeapBlock = ( ulNextHeapBlock + 1UL ) % benchHEAP_BLOCKS;
+
+    return ulCycles;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvHeapBlockSize( void )
+{
+    /* A linear congruential generator, so the sequence of sizes is the same
+     * whichever heap implementation is used. */
+    ulHeapSizeSeed = ( ulHeapSizeSeed * 1103515245UL ) + 12345UL;
+
+    return ( size_t ) ( benchHEAP_BLOCK_SIZE_MIN + ( ( ulHeapSizeSeed >> 16 ) % benchHEAP_BLOCK_SIZE_RANGE ) );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFrameQueueSetUp( uint32_t ulFrameSize )
+{
+    BaseType_t xReturn = pdPASS;
+
+    configASSERT( ulFrameSize <= benchFRAME_SIZE_MAX );
+
+    xPingFrameQueue = xQueueCreate( 1, ( UBaseType_t ) ulFrameSize );
+    xPongFrameQueue = xQueueCreate( 1, ( UBaseType_t ) ulFrameSize );
+
+    if( ( xPingFrameQueue == NULL ) || ( xPongFrameQueue == NULL ) )
+    {
+        prvFrameQueueTearDown();
+        xReturn = pdFAIL;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFrameQueueTearDown( void )
+{
+    if( xPingFrameQueue != NULL )
+    {
+        vQueueDelete( xPingFrameQueue );
+        xPingFrameQueue = NULL;
+    }
+
+    if( xPongFrameQueue != NULL )
+    {
+        vQueueDelete( xPongFrameQueue );
+        xPongFrameQueue = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvFrameCopyIteration( void )
+{
+    uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+    ucBenchFrame[ 0 ]++;
+    xQueueSend( xPingFrameQueue, ucBenchFrame, portMAX_DELAY );
+    xQueueReceive( xPongFrameQueue, ucBenchFrame, portMAX_DELAY );
+
+    return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFrameCopyEcho( void )
+{
+    xQueueReceive( xPingFrameQueue, ucEchoFrame, portMAX_DELAY );
+    xQueueSend( xPongFrameQueue, ucEchoFrame, portMAX_DELAY );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvBurstQueueSetUp( uint32_t ulBurstLength )
+{
+    BaseType_t xReturn = pdPASS;
+
+    configASSERT( ulBurstLength <= benchBURST_LENGTH_MAX );
+
+    uxBurstLength = ( UBaseType_t ) ulBurstLength;
+    xBurstQueue = xQueueCreate( uxBurstLength, sizeof( uint32_t ) );
+
+    if( xBurstQueue == NULL )
+    {
+        xReturn = pdFAIL;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBurstQueueTearDown( void )
+{
+    if( xBurstQueue != NULL )
+    {
+        vQueueDelete( xBurstQueue );
+        xBurstQueue = NULL;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvBurstLoopIteration( void )
+{
+    UBaseType_t ux;
+    uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+    for( ux = 0; ux < uxBurstLength; ux++ )
+    {
+        xQueueSend( xBurstQueue, &( ulBenchBurst[ ux ] ), portMAX_DELAY );
+    }
+
+    ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+    return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBurstLoopEcho( void )
+{
+    UBaseType_t ux;
+
+    for( ux = 0; ux < uxBurstLength; ux++ )
+    {
+        xQueueReceive( xBurstQueue, &( ulEchoBurst[ ux ] ), portMAX_DELAY );
+    }
+
+    xTaskNotifyGive( xBenchmarkTask );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvBurstMultipleIteration( void )
+{
+    uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+    /* The queue is as long as the burst, and empty, so the whole burst is
+     * sent by the one call. */
+    xQueueSendMultiple( xBurstQueue, ulBenchBurst, uxBurstLength, portMAX_DELAY );
+    ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+    return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBurstMultipleEcho( void )
+{
+    UBaseType_t uxReceived = 0;
+
+    while( uxReceived < uxBurstLength )
+    {
+        uxReceived += ( UBaseType_t ) xQueueReceiveMultiple( xBurstQueue,
+                                                             &( ulEchoBurst[ uxReceived ] ),
+                                                             uxBurstLength - uxReceived,
+                                                             portMAX_DELAY );
+    }
+
+    xTaskNotifyGive( xBenchmarkTask );
+}
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_QUEUE_ZERO_COPY == 1 )
+
+    static uint32_t prvFrameZeroCopyIteration( void )
+    {
+        uint8_t * pucFrame;
+        uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+        xQueueAcquireSlot( xPingFrameQueue, ( void ** ) &pucFrame, portMAX_DELAY );
+        pucFrame[ 0 ] = ++ucBenchFrame[ 0 ];
+        vQueueCommitSlot( xPingFrameQueue );
+
+        xQueueBorrowSlot( xPongFrameQueue, ( void ** ) &pucFrame, portMAX_DELAY );
+        ucBenchFrame[ 0 ] = pucFrame[ 0 ];
+        vQueueReleaseSlot( xPongFrameQueue );
+
+        return benchGET_CYCLE_COUNT() - ulStart;
+    }
+    /*-----------------------------------------------------------*/
+
+    static void prvFrameZeroCopyEcho( void )
+    {
+        uint8_t * pucPing, * pucPong;
+
+        /* Answer with a frame built from the one received, without copying
+         * either of them. */
+        xQueueBorrowSlot( xPingFrameQueue, ( void ** ) &pucPing, portMAX_DELAY );
+        xQueueAcquireSlot( xPongFrameQueue, ( void ** ) &pucPong, portMAX_DELAY );
+        pucPong[ 0 ] = pucPing[ 0 ];
+        vQueueReleaseSlot( xPingFrameQueue );
+        vQueueCommitSlot( xPongFrameQueue );
+    }
+
+#endif /* configUSE_QUEUE_ZERO_COPY */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TIMERS == 1 )
+
+    static BaseType_t prvTimerSetUp( uint32_t ulTimerCount )
+    {
+        BaseType_t xReturn = pdPASS;
+
+        configASSERT( ulTimerCount <= benchTIMER_COUNT_MAX );
+
+        for( ulTimersCreated = 0; ulTimersCreated < ulTimerCount; ulTimersCreated++ )
+        {
+            /* Each timer expires one tick after the timer created before it. */
+            xTimers[ ulTimersCreated ] = xTimerCreate( "Bench",
+                                                       benchTIMER_PERIOD_BASE + ( TickType_t ) ulTimersCreated,
+                                                       pdFALSE,
+                                                       NULL,
+                                                       prvTimerCallback );
+
+            if( xTimers[ ulTimersCreated ] == NULL )
+            {
+                xReturn = pdFAIL;
+                break;
+            }
+
+            xTimerStart( xTimers[ ulTimersCreated ], portMAX_DELAY );
+        }
+
+        if( xReturn != pdPASS )
+        {
+            prvTimerTearDown();
+        }
+
+        return xReturn;
+    }
+    /*-----------------------------------------------------------*/
+
+    static void prvTimerTearDown( void )
+    {
+        uint32_t ul;
+
+        for( ul = 0; ul < ulTimersCreated; ul++ )
+        {
+            xTimerDelete( xTimers[ ul ], portMAX_DELAY );
+            xTimers[ ul ] = NULL;
+        }
+
+        ulTimersCreated = 0;
+    }
+    /*-----------------------------------------------------------*/
+
+    static uint32_t prvTimerIteration( void )
+    {
+        uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+        /* Resetting the timer with the latest expiry time moves it back to the
+         * end of the active timers. */
+        xTimerReset( xTimers[ ulTimersCreated - 1UL ], portMAX_DELAY );
+
+        return benchGET_CYCLE_COUNT() - ulStart;
+    }
+    /*-----------------------------------------------------------*/
+
+    static void prvTimerCallback( TimerHandle_t xTimer )
+    {
+        /* The timers are never expected to expire. */
+        ( void ) xTimer;
+    }
+
+#endif /* configUSE_TIMERS */
+/*-----------------------------------------------------------*/
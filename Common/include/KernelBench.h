@@ -0,0 +1,116 @@
+/*
+ * FreeRTOS V202112.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://aws.amazon.com/freertos
+ *
+ */
+
+#ifndef KERNEL_BENCH_H
+#define KERNEL_BENCH_H
+
+/*
+ * Cycle counter used to time each benchmarked operation.  By default this is
+ * the Cortex-M3 DWT CYCCNT register.  A build that runs on another target (for
+ * example a host simulation) can define both macros to read a monotonic clock
+ * instead.
+ */
+#ifndef benchGET_CYCLE_COUNT
+    #define benchDEMCR_REG                ( *( ( volatile uint32_t * ) 0xe000edfc ) )
+    #define benchDWT_CTRL_REG             ( *( ( volatile uint32_t * ) 0xe0001000 ) )
+    #define benchDWT_CYCCNT_REG           ( *( ( volatile uint32_t * ) 0xe0001004 ) )
+    #define benchDEMCR_TRCENA_BIT         ( 1UL << 24UL )
+    #define benchDWT_CYCCNTENA_BIT        ( 1UL << 0UL )
+
+    #define benchINIT_CYCLE_COUNTER()                        \
+    {                                                        \
+        benchDEMCR_REG |= benchDEMCR_TRCENA_BIT;             \
+        benchDWT_CYCCNT_REG = 0UL;                           \
+        benchDWT_CTRL_REG |= benchDWT_CYCCNTENA_BIT;         \
+    }
+    #define benchGET_CYCLE_COUNT()        ( benchDWT_CYCCNT_REG )
+#endif
+
+/* Bucket n holds samples in the range [2^n, 2^(n+1)).  Bucket 0 also holds
+ * samples of zero, and the last bucket also holds everything larger. */
+#define benchHISTOGRAM_BUCKETS    ( 24 )
+
+typedef struct BENCH_HISTOGRAM
+{
+    uint32_t ulSamples;
+    uint32_t ulMin;
+    uint32_t ulMax;
+    unsigned long long ullTotal;
+    uint32_t ulBuckets[ benchHISTOGRAM_BUCKETS ];
+} BenchHistogram_t;
+
+typedef struct BENCH_CASE
+{
+    const char * pcName;
+    uint32_t ( * pxRunIteration )( void ); /* Executed by the benchmark task, returns the cycles taken. */
+    void ( * pxEchoIteration )( void );    /* Optional, executed by the echo task. */
+    UBaseType_t uxEchoPriorityOffset;      /* Echo task priority relative to the benchmark task. */
+    BaseType_t ( * pxSetUp )( uint32_t ulParameter ); /* Optional, executed before the first iteration.  The benchmark is skipped if it fails. */
+    void ( * pxTearDown )( void );                    /* Optional, executed after the last iteration. */
+    uint32_t ulParameter;                             /* Passed to pxSetUp(). */
+} BenchCase_t;
+
+/* A set of benchmarks run and reported together.  Drivers and libraries
+ * outside the kernel define their own, so the kernel benchmarks do not depend
+ * on them. */
+typedef struct BENCH_SUITE
+{
+    const BenchCase_t * pxCases;
+    BenchHistogram_t * pxHistograms; /* One per case.  Static, as they are too large for a stack. */
+    UBaseType_t uxCases;
+    volatile BaseType_t xComplete;   /* Set once the results have been written. */
+    struct BENCH_SUITE * pxNext;     /* Used by the benchmark task. */
+} BenchSuite_t;
+
+/*
+ * Creates the task that times each kernel primitive benchITERATIONS times
+ * and then writes one CSV line per primitive through benchOUTPUT_STRING().
+ */
+void vStartKernelBenchmarkTask( UBaseType_t uxPriority );
+
+/*
+ * Returns pdTRUE once every kernel benchmark has run and its results have
+ * been written out.
+ */
+BaseType_t xIsKernelBenchmarkComplete( void );
+
+/*
+ * Queues pxSuite to be run.  Each of its cases is run benchITERATIONS times,
+ * as the kernel benchmarks are, and then written out as one CSV line in the
+ * same form.  The suites are run one at a time, in the order they are
+ * started, by a task created with uxPriority when there is none running, so
+ * they do not disturb each other's times.
+ */
+void vStartBenchmarkSuite( BenchSuite_t * pxSuite,
+                           UBaseType_t uxPriority );
+
+/*
+ * Returns pdTRUE once every suite started, including the kernel benchmarks,
+ * has been written out.
+ */
+BaseType_t xAreBenchmarksComplete( void );
+
+#endif /* KERNEL_BENCH_H */
@@ -85,6 +85,15 @@ typedef enum
     ser115200
 } eBaud;
 
+/* The error counters returned by vSerialGetStats().  They count from when the
+ * port was opened. */
+typedef struct xSERIAL_STATS
+{
+    uint32_t ulRxDroppedBytes; /* Received bytes discarded because the receive buffer was full. */
+    uint32_t ulRxOverruns;     /* Overrun errors reported by the UART, each of which lost at least one received byte. */
+    uint32_t ulTxDroppedBytes; /* Bytes passed to vSerialPutString() that were discarded because the transmit buffer was full, or another task was writing. */
+} SerialStats_t;
+
 xComPortHandle xSerialPortInitMinimal( unsigned long ulWantedBaud,
                                        unsigned portBASE_TYPE uxQueueLength );
 xComPortHandle xSerialPortInit( eCOMPort ePort,
@@ -93,6 +102,14 @@ xComPortHandle xSerialPortInit( eCOMPort ePort,
                                 eDataBits eWantedDataBits,
                                 eStopBits eWantedStopBits,
                                 unsigned portBASE_TYPE uxBufferLength );
+
+/*
+ * Opens a port for 8 data bits, no parity and 1 stop bit at any baud rate,
+ * including those above ser115200.
+ */
+xComPortHandle xSerialPortInitBaud( eCOMPort ePort,
+                                    unsigned long ulWantedBaud,
+                                    unsigned portBASE_TYPE uxBufferLength );
 void vSerialPutString( xComPortHandle pxPort,
                        const signed char * const pcString,
                        unsigned short usStringLength );
@@ -103,6 +120,47 @@ signed portBASE_TYPE xSerialPutChar( xComPortHandle pxPort,
                                      signed char cOutChar,
                                      TickType_t xBlockTime );
 portBASE_TYPE xSerialWaitForSemaphore( xComPortHandle xPort );
+
+/*
+ * Writes xLength bytes to the port, blocking for up to xBlockTime ticks in
+ * total for any other task writing to the port to finish, and for space in the
+ * transmit buffer.  Returns the number of bytes written, which is less than
+ * xLength only if the block time expired.
+ *
+ * Any number of tasks can write to a port.  Each write is sent whole, without
+ * the bytes of other writes in the middle of it.  Must not be called from an
+ * interrupt.
+ */
+size_t xSerialWrite( xComPortHandle pxPort,
+                     const void * pvBuffer,
+                     size_t xLength,
+                     TickType_t xBlockTime );
+
+/*
+ * Reads up to xLength bytes from the port.  Blocks for up to xBlockTime ticks
+ * until the number of bytes set by xSerialSetRxTriggerLevel() is available,
+ * then returns as many as are available, up to xLength.  Returns the number
+ * of bytes read, which is 0 if none arrived before the block time expired.
+ */
+size_t xSerialRead( xComPortHandle pxPort,
+                    void * pvBuffer,
+                    size_t xLength,
+                    TickType_t xBlockTime );
+
+/*
+ * Sets how many received bytes must be available before a task blocked in
+ * xSerialRead() is unblocked.  The default is 1.  Returns pdFAIL if the
+ * level is larger than the receive buffer, or the driver does not support
+ * trigger levels.
+ */
+portBASE_TYPE xSerialSetRxTriggerLevel( xComPortHandle pxPort,
+                                        size_t xTriggerLevel );
+
+/*
+ * Copies the error counters of the port into *pxStats.
+ */
+void vSerialGetStats( xComPortHandle pxPort,
+                      SerialStats_t * pxStats );
 void vSerialClose( xComPortHandle xPort );
 
 #endif /* ifndef SERIAL_COMMS_H */
@@ -232,6 +232,44 @@
     #define configUSE_TIMERS    0
 #endif
 
+#ifndef configUSE_TIMER_WHEEL
+    #define configUSE_TIMER_WHEEL    0
+#endif
+
+#ifndef configTIMER_WHEEL_SLOT_BITS
+    #define configTIMER_WHEEL_SLOT_BITS    4
+#endif
+
+#ifndef configUSE_TIMER_DIRECT_COMMANDS
+    #define configUSE_TIMER_DIRECT_COMMANDS    0
+#endif
+
+#ifndef configUSE_DELAYED_TASK_BUCKETS
+    #define configUSE_DELAYED_TASK_BUCKETS    0
+#endif
+
+#ifndef configDELAYED_TASK_BUCKET_BITS
+    #define configDELAYED_TASK_BUCKET_BITS    5
+#endif
+
+#ifndef configDELAYED_TASK_BUCKET_WIDTH_BITS
+    #define configDELAYED_TASK_BUCKET_WIDTH_BITS    3
+#endif
+
+#if ( configUSE_DELAYED_TASK_BUCKETS == 1 )
+    #if ( configDELAYED_TASK_BUCKET_BITS < 1 ) || ( configDELAYED_TASK_BUCKET_BITS > 5 )
+        #error configDELAYED_TASK_BUCKET_BITS must be between 1 and 5 when configUSE_DELAYED_TASK_BUCKETS is set to 1.
+    #endif
+
+    #if ( configDELAYED_TASK_BUCKET_WIDTH_BITS > 8 )
+        #error configDELAYED_TASK_BUCKET_WIDTH_BITS must not be greater than 8.
+    #endif
+#endif
+
+#ifndef configUSE_QUEUE_ZERO_COPY
+    #define configUSE_QUEUE_ZERO_COPY    0
+#endif
+
 #ifndef configUSE_COUNTING_SEMAPHORES
     #define configUSE_COUNTING_SEMAPHORES    0
 #endif
@@ -298,6 +336,14 @@
         #error If configUSE_TIMERS is set to 1 then configTIMER_TASK_STACK_DEPTH must also be defined.
     #endif /* configTIMER_TASK_STACK_DEPTH */
 
+    #if ( configUSE_TIMER_WHEEL == 1 ) && ( configTIMER_WHEEL_SLOT_BITS != 2 ) && ( configTIMER_WHEEL_SLOT_BITS != 4 )
+        #error configTIMER_WHEEL_SLOT_BITS must be set to 2 or 4 when configUSE_TIMER_WHEEL is set to 1.
+    #endif
+
+    #if ( configUSE_TIMER_DIRECT_COMMANDS == 1 ) && ( INCLUDE_xTaskAbortDelay != 1 )
+        #error INCLUDE_xTaskAbortDelay must be set to 1 when configUSE_TIMER_DIRECT_COMMANDS is set to 1.
+    #endif
+
 #endif /* configUSE_TIMERS */
 
 #ifndef portSET_INTERRUPT_MASK_FROM_ISR
@@ -1251,6 +1297,10 @@ typedef struct xSTATIC_QUEUE
         UBaseType_t uxDummy8;
         uint8_t ucDummy9;
     #endif
+
+    #if ( configUSE_QUEUE_ZERO_COPY == 1 )
+        uint8_t ucDummy10;
+    #endif
 } StaticQueue_t;
 typedef StaticQueue_t StaticSemaphore_t;
 
@@ -1336,6 +1386,18 @@ typedef struct xSTATIC_STREAM_BUFFER
 /* Message buffers are built on stream buffers. */
 typedef StaticStreamBuffer_t StaticMessageBuffer_t;
 
+/*
+ * In line with the other Static* types, StaticMemPool_t has the size and
+ * alignment of the memory pool structure, which is not accessible to
+ * application code.  See mem_pool.h.
+ */
+typedef struct xSTATIC_MEM_POOL
+{
+    void * pvDummy1[ 3 ];
+    size_t xDummy2;
+    UBaseType_t uxDummy3[ 4 ];
+} StaticMemPool_t;
+
 /* *INDENT-OFF* */
 #ifdef __cplusplus
     }
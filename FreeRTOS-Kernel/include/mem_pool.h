@@ -0,0 +1,282 @@
+/*
+ * FreeRTOS Kernel V10.4.3 LTS Patch 2
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * Memory pools hand out fixed size blocks from a buffer provided by the
+ * application.  Allocating and freeing a block takes constant time and never
+ * blocks, and the same functions can be called from tasks and interrupts.
+ * Each operation runs inside a short critical section entered in the same way
+ * as the functions in atomic.h.  On ports that support interrupt nesting only
+ * interrupts at or below configMAX_SYSCALL_INTERRUPT_PRIORITY are masked, and
+ * only for the few instructions needed to unlink or link a block.
+ *
+ * A pool can be the backing store of other objects.  For example, the blocks
+ * of a pool created with a block size of sizeof( Message_t ) can be sent by
+ * reference through a queue of Message_t pointers, so interrupts can pass
+ * messages to tasks without copying them, or a block can be passed as the
+ * storage area of xQueueCreateStatic() or xMessageBufferCreateStatic().
+ */
+
+#ifndef MEM_POOL_H
+#define MEM_POOL_H
+
+#ifndef INC_FREERTOS_H
+    #error "include FreeRTOS.h must appear in source files before include mem_pool.h"
+#endif
+
+/* *INDENT-OFF* */
+#if defined( __cplusplus )
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * Type by which memory pools are referenced.  For example, a call to
+ * xMemPoolCreateStatic() returns a MemPoolHandle_t variable that can then be
+ * used as a parameter to pvMemPoolAlloc(), vMemPoolFree(), etc.
+ */
+struct MemPoolDef_t;
+typedef struct MemPoolDef_t * MemPoolHandle_t;
+
+/**
+ * The statistics returned by vMemPoolGetStats().
+ */
+typedef struct xMEM_POOL_STATS
+{
+    size_t xBlockSize;                       /* The size of each block, after it was rounded up to a multiple of memPOOL_BLOCK_ALIGNMENT. */
+    UBaseType_t uxNumberOfBlocks;            /* The total number of blocks in the pool. */
+    UBaseType_t uxFreeBlocks;                /* The number of blocks that are not allocated. */
+    UBaseType_t uxMinimumEverFreeBlocks;     /* The fewest free blocks there have been since the pool was created - the high water mark of its use. */
+    UBaseType_t uxNumberOfFailedAllocations; /* The number of calls to pvMemPoolAlloc() that found the pool empty. */
+} MemPoolStats_t;
+
+/* Every block is aligned to, and a multiple of, memPOOL_BLOCK_ALIGNMENT
+ * bytes. */
+#define memPOOL_BLOCK_ALIGNMENT    portBYTE_ALIGNMENT
+
+/**
+ * mem_pool.h
+ *
+ * <pre>
+ * memPOOL_STORAGE_SIZE( xBlockSize, uxNumberOfBlocks )
+ * </pre>
+ *
+ * The size, in bytes, of the storage area needed by a pool of uxNumberOfBlocks
+ * blocks of xBlockSize bytes each.  Blocks smaller than a pointer are enlarged
+ * to hold one, as the free blocks are linked through their first bytes.
+ *
+ * \defgroup memPOOL_STORAGE_SIZE memPOOL_STORAGE_SIZE
+ * \ingroup MemPoolManagement
+ */
+#define memPOOL_BLOCK_SIZE( xBlockSize )                                                        \
+    ( ( ( ( ( xBlockSize ) < sizeof( void * ) ) ? sizeof( void * ) : ( size_t ) ( xBlockSize ) ) \
+        + ( ( size_t ) memPOOL_BLOCK_ALIGNMENT - 1U ) ) & ~( ( size_t ) memPOOL_BLOCK_ALIGNMENT - 1U ) )
+
+#define memPOOL_STORAGE_SIZE( xBlockSize, uxNumberOfBlocks )    ( memPOOL_BLOCK_SIZE( xBlockSize ) * ( size_t ) ( uxNumberOfBlocks ) )
+
+/**
+ * mem_pool.h
+ *
+ * <pre>
+ * MemPoolHandle_t xMemPoolCreateStatic( size_t xBlockSize,
+ *                                       UBaseType_t uxNumberOfBlocks,
+ *                                       uint8_t * pucPoolStorageArea,
+ *                                       StaticMemPool_t * pxStaticMemPool );
+ * </pre>
+ *
+ * Creates a memory pool using statically allocated memory.  The blocks are
+ * linked into the pool as they are first allocated, so creating a pool takes
+ * the same time however many blocks it has.
+ *
+ * @param xBlockSize The size of each block in bytes.  It is rounded up to a
+ * multiple of memPOOL_BLOCK_ALIGNMENT.
+ *
+ * @param uxNumberOfBlocks The number of blocks in the pool.
+ *
+ * @param pucPoolStorageArea Must point to a buffer of at least
+ * memPOOL_STORAGE_SIZE( xBlockSize, uxNumberOfBlocks ) bytes, aligned to
+ * memPOOL_BLOCK_ALIGNMENT.  This is the memory the blocks are allocated from.
+ *
+ * @param pxStaticMemPool Must point to a variable of type StaticMemPool_t,
+ * which will be used to hold the pool's data structure.
+ *
+ * @return If the parameters are valid then a handle to the created pool is
+ * returned.  Otherwise NULL is returned.
+ *
+ * Example use:
+ * <pre>
+ *
+ * typedef struct
+ * {
+ *  uint32_t ulTimestamp;
+ *  uint8_t ucData[ 12 ];
+ * } Message_t;
+ *
+ * #define POOL_BLOCKS 8
+ *
+ * // The storage is declared as an array of the block type so it is aligned.
+ * static Message_t xMessages[ POOL_BLOCKS ];
+ * static StaticMemPool_t xMessagePoolStruct;
+ *
+ * void MyFunction( void )
+ * {
+ * MemPoolHandle_t xMessagePool;
+ *
+ *  configASSERT( sizeof( xMessages ) >= memPOOL_STORAGE_SIZE( sizeof( Message_t ), POOL_BLOCKS ) );
+ *
+ *  xMessagePool = xMemPoolCreateStatic( sizeof( Message_t ),
+ *                                       POOL_BLOCKS,
+ *                                       ( uint8_t * ) xMessages,
+ *                                       &xMessagePoolStruct );
+ * }
+ * </pre>
+ * \defgroup xMemPoolCreateStatic xMemPoolCreateStatic
+ * \ingroup MemPoolManagement
+ */
+MemPoolHandle_t xMemPoolCreateStatic( size_t xBlockSize,
+                                      UBaseType_t uxNumberOfBlocks,
+                                      uint8_t * pucPoolStorageArea,
+                                      StaticMemPool_t * pxStaticMemPool ) PRIVILEGED_FUNCTION;
+
+/**
+ * mem_pool.h
+ *
+ * <pre>
+ * void * pvMemPoolAlloc( MemPoolHandle_t xMemPool );
+ * </pre>
+ *
+ * Allocates a block from a memory pool.  The function never blocks, and can be
+ * called from a task or from an interrupt service routine.
+ *
+ * @param xMemPool The handle of the pool to allocate from.
+ *
+ * @return A pointer to a block of the size the pool was created with, or NULL
+ * if every block is already allocated.
+ *
+ * \defgroup pvMemPoolAlloc pvMemPoolAlloc
+ * \ingroup MemPoolManagement
+ */
+void * pvMemPoolAlloc( MemPoolHandle_t xMemPool ) PRIVILEGED_FUNCTION;
+
+/**
+ * mem_pool.h
+ *
+ * <pre>
+ * void * pvMemPoolAllocFromISR( MemPoolHandle_t xMemPool );
+ * </pre>
+ *
+ * A version of pvMemPoolAlloc() named for use from an interrupt service
+ * routine.  pvMemPoolAlloc() is already interrupt safe, so this is the same
+ * function.
+ *
+ * \defgroup pvMemPoolAllocFromISR pvMemPoolAllocFromISR
+ * \ingroup MemPoolManagement
+ */
+#define pvMemPoolAllocFromISR( xMemPool )    pvMemPoolAlloc( ( xMemPool ) )
+
+/**
+ * mem_pool.h
+ *
+ * <pre>
+ * void vMemPoolFree( MemPoolHandle_t xMemPool, void * pvBlock );
+ * </pre>
+ *
+ * Returns a block to the memory pool it was allocated from.  The function
+ * never blocks, and can be called from a task or from an interrupt service
+ * routine.
+ *
+ * @param xMemPool The handle of the pool the block was allocated from.
+ *
+ * @param pvBlock The block being freed, as returned by pvMemPoolAlloc().
+ * Passing NULL has no effect.
+ *
+ * \defgroup vMemPoolFree vMemPoolFree
+ * \ingroup MemPoolManagement
+ */
+void vMemPoolFree( MemPoolHandle_t xMemPool,
+                   void * pvBlock ) PRIVILEGED_FUNCTION;
+
+/**
+ * mem_pool.h
+ *
+ * <pre>
+ * void vMemPoolFreeFromISR( MemPoolHandle_t xMemPool, void * pvBlock );
+ * </pre>
+ *
+ * A version of vMemPoolFree() named for use from an interrupt service routine.
+ * vMemPoolFree() is already interrupt safe, so this is the same function.
+ *
+ * \defgroup vMemPoolFreeFromISR vMemPoolFreeFromISR
+ * \ingroup MemPoolManagement
+ */
+#define vMemPoolFreeFromISR( xMemPool, pvBlock )    vMemPoolFree( ( xMemPool ), ( pvBlock ) )
+
+/**
+ * mem_pool.h
+ *
+ * <pre>
+ * UBaseType_t uxMemPoolGetFreeBlocks( MemPoolHandle_t xMemPool );
+ * </pre>
+ *
+ * Queries how many blocks of a memory pool are not allocated.
+ *
+ * @param xMemPool The handle of the pool being queried.
+ *
+ * @return The number of blocks pvMemPoolAlloc() can return before the pool is
+ * empty.
+ *
+ * \defgroup uxMemPoolGetFreeBlocks uxMemPoolGetFreeBlocks
+ * \ingroup MemPoolManagement
+ */
+UBaseType_t uxMemPoolGetFreeBlocks( MemPoolHandle_t xMemPool ) PRIVILEGED_FUNCTION;
+
+/**
+ * mem_pool.h
+ *
+ * <pre>
+ * void vMemPoolGetStats( MemPoolHandle_t xMemPool, MemPoolStats_t * pxPoolStats );
+ * </pre>
+ *
+ * Returns the statistics of a memory pool.  uxMinimumEverFreeBlocks shows how
+ * close the pool has come to running out, so can be used to size it.
+ *
+ * @param xMemPool The handle of the pool being queried.
+ *
+ * @param pxPoolStats The structure the statistics are written to.
+ *
+ * \defgroup vMemPoolGetStats vMemPoolGetStats
+ * \ingroup MemPoolManagement
+ */
+void vMemPoolGetStats( MemPoolHandle_t xMemPool,
+                       MemPoolStats_t * pxPoolStats ) PRIVILEGED_FUNCTION;
+
+/* *INDENT-OFF* */
+#if defined( __cplusplus )
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* !defined( MEM_POOL_H ) */
@@ -1416,6 +1416,377 @@ BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue,
                                  void * const pvBuffer,
                                  BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
 
+/**
+ * queue. h
+ * <pre>
+ * BaseType_t xQueueSendMultiple(
+ *                                QueueHandle_t xQueue,
+ *                                const void * pvItemsToQueue,
+ *                                UBaseType_t uxItemCount,
+ *                                TickType_t xTicksToWait
+ *                            );
+ * </pre>
+ *
+ * Posts up to uxItemCount items to the back of a queue in one operation.  The
+ * items are copied into the queue with at most two memcpy() calls, inside a
+ * single critical section, and any tasks that were waiting for the data are
+ * unblocked with at most one context switch.  That costs much less than
+ * calling xQueueSend() once per item.
+ *
+ * If the queue does not have room for all the items then as many as fit are
+ * posted, starting with the first, and the number posted is returned.  The
+ * calling task only blocks if the queue is full, and returns as soon as any
+ * items can be posted, so the caller should send the remaining items again.
+ *
+ * This function must not be called from an interrupt service routine.  See
+ * xQueueSendMultipleFromISR() for an alternative which may be used in an ISR.
+ *
+ * @param xQueue The handle to the queue on which the items are to be posted.
+ *
+ * @param pvItemsToQueue A pointer to an array of uxItemCount items, each the
+ * size the queue was created with.
+ *
+ * @param uxItemCount The number of items in the array, which must be at least
+ * 1.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block waiting
+ * for space to become available on the queue, should it be full.
+ *
+ * @return The number of items posted to the queue, which is 0 only if the
+ * queue remained full for the whole block time.
+ *
+ * Example usage:
+ * <pre>
+ * void vSendSamples( QueueHandle_t xQueue, const uint16_t *pusSamples, UBaseType_t uxCount )
+ * {
+ * BaseType_t xSent;
+ *
+ *  while( uxCount > 0 )
+ *  {
+ *      xSent = xQueueSendMultiple( xQueue, pusSamples, uxCount, portMAX_DELAY );
+ *      pusSamples += xSent;
+ *      uxCount -= ( UBaseType_t ) xSent;
+ *  }
+ * }
+ * </pre>
+ * \defgroup xQueueSendMultiple xQueueSendMultiple
+ * \ingroup QueueManagement
+ */
+BaseType_t xQueueSendMultiple( QueueHandle_t xQueue,
+                               const void * const pvItemsToQueue,
+                               UBaseType_t uxItemCount,
+                               TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ * BaseType_t xQueueSendMultipleFromISR(
+ *                                       QueueHandle_t xQueue,
+ *                                       const void * pvItemsToQueue,
+ *                                       UBaseType_t uxItemCount,
+ *                                       BaseType_t *pxHigherPriorityTaskWoken
+ *                                   );
+ * </pre>
+ *
+ * A version of xQueueSendMultiple() that can be used from an interrupt service
+ * routine.  As many of the items as fit are posted and the number posted is
+ * returned.  A DMA or FIFO interrupt can use it to hand over everything it
+ * received in one call, rather than one call per item.
+ *
+ * @param xQueue The handle to the queue on which the items are to be posted.
+ *
+ * @param pvItemsToQueue A pointer to an array of uxItemCount items.
+ *
+ * @param uxItemCount The number of items in the array, which must be at least
+ * 1.
+ *
+ * @param pxHigherPriorityTaskWoken xQueueSendMultipleFromISR() will set
+ * *pxHigherPriorityTaskWoken to pdTRUE if posting the items unblocked a task
+ * with a priority higher than the currently running task.  However many tasks
+ * are unblocked, a context switch only needs to be requested once, before the
+ * interrupt is exited.
+ *
+ * @return The number of items posted to the queue, which is 0 only if the
+ * queue was full.
+ *
+ * \defgroup xQueueSendMultipleFromISR xQueueSendMultipleFromISR
+ * \ingroup QueueManagement
+ */
+BaseType_t xQueueSendMultipleFromISR( QueueHandle_t xQueue,
+                                      const void * const pvItemsToQueue,
+                                      UBaseType_t uxItemCount,
+                                      BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ * BaseType_t xQueueReceiveMultiple(
+ *                                   QueueHandle_t xQueue,
+ *                                   void * pvBuffer,
+ *                                   UBaseType_t uxMaxItems,
+ *                                   TickType_t xTicksToWait
+ *                               );
+ * </pre>
+ *
+ * Receives up to uxMaxItems items from a queue in one operation.  If the queue
+ * holds fewer items then all of them are received, and the number received is
+ * returned.  The calling task only blocks if the queue is empty, and returns as
+ * soon as any items are available.
+ *
+ * The items are removed from the queue in the order they were posted, with at
+ * most two memcpy() calls, and tasks that were waiting for space are unblocked
+ * with at most one context switch.
+ *
+ * This function must not be called from an interrupt service routine.  See
+ * xQueueReceiveMultipleFromISR() for an alternative that can.
+ *
+ * @param xQueue The handle to the queue from which the items are to be
+ * received.
+ *
+ * @param pvBuffer Pointer to a buffer with room for uxMaxItems items.
+ *
+ * @param uxMaxItems The most items to receive, which must be at least 1.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block waiting
+ * for an item to receive should the queue be empty at the time of the call.
+ *
+ * @return The number of items received, which is 0 only if the queue remained
+ * empty for the whole block time.
+ *
+ * \defgroup xQueueReceiveMultiple xQueueReceiveMultiple
+ * \ingroup QueueManagement
+ */
+BaseType_t xQueueReceiveMultiple( QueueHandle_t xQueue,
+                                  void * const pvBuffer,
+                                  UBaseType_t uxMaxItems,
+                                  TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ * BaseType_t xQueueReceiveMultipleFromISR(
+ *                                          QueueHandle_t xQueue,
+ *                                          void * pvBuffer,
+ *                                          UBaseType_t uxMaxItems,
+ *                                          BaseType_t *pxHigherPriorityTaskWoken
+ *                                      );
+ * </pre>
+ *
+ * A version of xQueueReceiveMultiple() that can be used from an interrupt
+ * service routine.  Receives as many items as are available, up to
+ * uxMaxItems, and returns the number received.
+ *
+ * @param xQueue The handle to the queue from which the items are to be
+ * received.
+ *
+ * @param pvBuffer Pointer to a buffer with room for uxMaxItems items.
+ *
+ * @param uxMaxItems The most items to receive, which must be at least 1.
+ *
+ * @param pxHigherPriorityTaskWoken xQueueReceiveMultipleFromISR() will set
+ * *pxHigherPriorityTaskWoken to pdTRUE if removing the items unblocked a task
+ * with a priority higher than the currently running task.
+ *
+ * @return The number of items received, which is 0 only if the queue was
+ * empty.
+ *
+ * \defgroup xQueueReceiveMultipleFromISR xQueueReceiveMultipleFromISR
+ * \ingroup QueueManagement
+ */
+BaseType_t xQueueReceiveMultipleFromISR( QueueHandle_t xQueue,
+                                         void * const pvBuffer,
+                                         UBaseType_t uxMaxItems,
+                                         BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+#if ( configUSE_QUEUE_ZERO_COPY == 1 )
+
+/**
+ * queue. h
+ * <pre>
+ * BaseType_t xQueueAcquireSlot(
+ *                               QueueHandle_t xQueue,
+ *                               void **ppvSlot,
+ *                               TickType_t xTicksToWait
+ *                             );
+ * </pre>
+ *
+ * Obtains the storage of the next item at the back of a queue so the item can
+ * be written in place, instead of being built in a buffer that xQueueSend()
+ * then copies into the queue.  The item is not visible to receivers until it
+ * is passed to vQueueCommitSlot().  The slot is not counted as an item until
+ * it is committed, so it only stays free because nothing else writes to the
+ * back of the queue in the meantime.
+ *
+ * The zero copy functions exchange the same items as xQueueSend() and
+ * xQueueReceive(), but must not be mixed with them on the same queue while a
+ * slot is acquired or borrowed - configASSERT() fails if the copying send and
+ * receive functions are called then.  Only one slot can be acquired, and only one
+ * slot borrowed, at any one time - so there should be a single writer and a
+ * single reader, or calls must be serialised by the application.
+ *
+ * configUSE_QUEUE_ZERO_COPY must be set to 1 in FreeRTOSConfig.h for this
+ * function to be available.
+ *
+ * @param xQueue The handle to the queue on which the item is to be posted.
+ *
+ * @param ppvSlot Set to the start of the item's storage, which is
+ * uxItemSize bytes long.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block
+ * waiting for space to become available on the queue, should it already be
+ * full.  Tasks blocked here are unblocked in priority order as slots are
+ * released.
+ *
+ * @return pdTRUE if a slot was acquired, otherwise errQUEUE_FULL.
+ *
+ * Example usage:
+ * <pre>
+ * void vSensorTask( void *pvParameters )
+ * {
+ * Frame_t *pxFrame;
+ *
+ *  for( ;; )
+ *  {
+ *      if( xQueueAcquireSlot( xFrameQueue, ( void ** ) &pxFrame, portMAX_DELAY ) == pdPASS )
+ *      {
+ *          vFillFrame( pxFrame );
+ *          vQueueCommitSlot( xFrameQueue );
+ *      }
+ *  }
+ * }
+ *
+ * void vProcessingTask( void *pvParameters )
+ * {
+ * Frame_t *pxFrame;
+ *
+ *  for( ;; )
+ *  {
+ *      if( xQueueBorrowSlot( xFrameQueue, ( void ** ) &pxFrame, portMAX_DELAY ) == pdPASS )
+ *      {
+ *          vProcessFrame( pxFrame );
+ *          vQueueReleaseSlot( xFrameQueue );
+ *      }
+ *  }
+ * }
+ * </pre>
+ * \defgroup xQueueAcquireSlot xQueueAcquireSlot
+ * \ingroup QueueManagement
+ */
+    BaseType_t xQueueAcquireSlot( QueueHandle_t xQueue,
+                                  void ** const ppvSlot,
+                                  TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ * BaseType_t xQueueAcquireSlotFromISR(
+ *                                      QueueHandle_t xQueue,
+ *                                      void **ppvSlot
+ *                                    );
+ * </pre>
+ *
+ * A version of xQueueAcquireSlot() that can be called from an interrupt
+ * service routine.  It does not block if the queue is full.
+ *
+ * \defgroup xQueueAcquireSlotFromISR xQueueAcquireSlotFromISR
+ * \ingroup QueueManagement
+ */
+    BaseType_t xQueueAcquireSlotFromISR( QueueHandle_t xQueue,
+                                         void ** const ppvSlot ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ * void vQueueCommitSlot( QueueHandle_t xQueue );
+ * </pre>
+ *
+ * Adds the slot obtained from xQueueAcquireSlot() to the back of the queue,
+ * and unblocks the highest priority task waiting to receive from the queue, if
+ * any.  The slot must not be accessed again by the writer.
+ *
+ * @param xQueue The handle of the queue the slot was acquired from.
+ *
+ * \defgroup vQueueCommitSlot vQueueCommitSlot
+ * \ingroup QueueManagement
+ */
+    void vQueueCommitSlot( QueueHandle_t xQueue ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ * void vQueueCommitSlotFromISR(
+ *                               QueueHandle_t xQueue,
+ *                               BaseType_t *pxHigherPriorityTaskWoken
+ *                             );
+ * </pre>
+ *
+ * A version of vQueueCommitSlot() that can be called from an interrupt service
+ * routine.
+ *
+ * @param xQueue The handle of the queue the slot was acquired from.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if committing the slot
+ * unblocked a task with a priority higher than the currently running task, in
+ * which case a context switch should be requested before the interrupt exits.
+ *
+ * \defgroup vQueueCommitSlotFromISR vQueueCommitSlotFromISR
+ * \ingroup QueueManagement
+ */
+    void vQueueCommitSlotFromISR( QueueHandle_t xQueue,
+                                  BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ * BaseType_t xQueueBorrowSlot(
+ *                              QueueHandle_t xQueue,
+ *                              void **ppvSlot,
+ *                              TickType_t xTicksToWait
+ *                            );
+ * </pre>
+ *
+ * Obtains the item at the front of a queue so it can be read in place, instead
+ * of xQueueReceive() copying it into a buffer.  The item is removed from the
+ * queue, but its storage is not reused until it is passed to
+ * vQueueReleaseSlot().  See xQueueAcquireSlot() for the restrictions on the
+ * zero copy functions.
+ *
+ * @param xQueue The handle to the queue from which the item is to be received.
+ *
+ * @param ppvSlot Set to the start of the item, which is uxItemSize bytes long.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block
+ * waiting for an item to receive should the queue be empty.  Tasks blocked
+ * here are unblocked in priority order as slots are committed.
+ *
+ * @return pdTRUE if an item was borrowed, otherwise errQUEUE_EMPTY.
+ *
+ * \defgroup xQueueBorrowSlot xQueueBorrowSlot
+ * \ingroup QueueManagement
+ */
+    BaseType_t xQueueBorrowSlot( QueueHandle_t xQueue,
+                                 void ** const ppvSlot,
+                                 TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ * void vQueueReleaseSlot( QueueHandle_t xQueue );
+ * </pre>
+ *
+ * Returns the storage of the item obtained from xQueueBorrowSlot() to the
+ * queue, and unblocks the highest priority task waiting for space, if any.
+ * The slot must not be accessed again by the reader.
+ *
+ * @param xQueue The handle of the queue the slot was borrowed from.
+ *
+ * \defgroup vQueueReleaseSlot vQueueReleaseSlot
+ * \ingroup QueueManagement
+ */
+    void vQueueReleaseSlot( QueueHandle_t xQueue ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_QUEUE_ZERO_COPY */
+
 /*
  * Utilities to query queues that are safe to use from an ISR.  These utilities
  * should be used only from witin an ISR, or within a critical section.
@@ -0,0 +1,246 @@
+/*
+ * FreeRTOS Kernel V10.4.3 LTS Patch 2
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+ * all the API functions to use the MPU wrappers.  That should only be done when
+ * task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "mem_pool.h"
+
+/* Lint e961, e9021 and e750 are suppressed as a MISRA exception justified
+ * because the MPU ports require MPU_WRAPPERS_INCLUDED_FROM_API_FILE to be defined
+ * for the header files above, but not in this file, in order to generate the
+ * correct privileged Vs unprivileged linkage and placement. */
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE /*lint !e961 !e750 !e9021. */
+
+/* Each pool operation runs in a short critical section entered in the same way
+ * as ATOMIC_ENTER_CRITICAL() in atomic.h, so the same function is safe to call
+ * from tasks and from interrupts.  The saved interrupt state is passed in so it
+ * can be declared with the other variables of the function. */
+#if defined( portSET_INTERRUPT_MASK_FROM_ISR )
+    #define poolENTER_CRITICAL( uxSavedState )    ( uxSavedState ) = portSET_INTERRUPT_MASK_FROM_ISR()
+    #define poolEXIT_CRITICAL( uxSavedState )     portCLEAR_INTERRUPT_MASK_FROM_ISR( ( uxSavedState ) )
+#else
+    #define poolENTER_CRITICAL( uxSavedState )    ( uxSavedState ) = 0; portENTER_CRITICAL()
+    #define poolEXIT_CRITICAL( uxSavedState )     ( void ) ( uxSavedState ); portEXIT_CRITICAL()
+#endif
+
+/* A free block holds a pointer to the next free block in its first bytes. */
+typedef struct MemPoolBlock_t
+{
+    struct MemPoolBlock_t * pxNextFreeBlock;
+} MemPoolBlock_t;
+
+/* Structure that hold state information on the memory pool. */
+typedef struct MemPoolDef_t /*lint !e9058 Style convention uses tag. */
+{
+    MemPoolBlock_t * pxFreeList;                /* Blocks that have been allocated and freed again. */
+    uint8_t * pucNextUnusedBlock;               /* The first block that has never been allocated. */
+    uint8_t * pucStorageEnd;                    /* One past the last byte of the storage area. */
+    size_t xBlockSize;                          /* The size of each block, a multiple of memPOOL_BLOCK_ALIGNMENT. */
+    UBaseType_t uxNumberOfBlocks;               /* The total number of blocks. */
+    UBaseType_t uxFreeBlocks;                   /* The number of blocks not allocated. */
+    UBaseType_t uxMinimumEverFreeBlocks;        /* The low water mark of uxFreeBlocks. */
+    UBaseType_t uxNumberOfFailedAllocations;    /* Allocations attempted while uxFreeBlocks was 0. */
+} MemPool_t;
+
+/*-----------------------------------------------------------*/
+
+MemPoolHandle_t xMemPoolCreateStatic( size_t xBlockSize,
+                                      UBaseType_t uxNumberOfBlocks,
+                                      uint8_t * pucPoolStorageArea,
+                                      StaticMemPool_t * pxStaticMemPool )
+{
+    MemPool_t * const pxMemPool = ( MemPool_t * ) pxStaticMemPool; /*lint !e740 !e9087 Safe cast as StaticMemPool_t is opaque MemPool_t. */
+    MemPoolHandle_t xReturn;
+
+    configASSERT( pucPoolStorageArea );
+    configASSERT( pxStaticMemPool );
+    configASSERT( xBlockSize > ( size_t ) 0 );
+    configASSERT( uxNumberOfBlocks > ( UBaseType_t ) 0 );
+
+    /* Every block must be aligned, so the storage area must be too. */
+    configASSERT( ( ( ( size_t ) pucPoolStorageArea ) & ( ( size_t ) memPOOL_BLOCK_ALIGNMENT - 1U ) ) == 0 );
+
+    #if ( configASSERT_DEFINED == 1 )
+        {
+            /* Sanity check that the size of the structure used to declare a
+             * variable of type StaticMemPool_t equals the size of the real
+             * memory pool structure. */
+            volatile size_t xSize = sizeof( StaticMemPool_t );
+            configASSERT( xSize == sizeof( MemPool_t ) );
+        } /*lint !e529 xSize is referenced is configASSERT() is defined. */
+    #endif /* configASSERT_DEFINED */
+
+    if( ( pucPoolStorageArea != NULL ) && ( pxStaticMemPool != NULL ) && ( xBlockSize > ( size_t ) 0 ) && ( uxNumberOfBlocks > ( UBaseType_t ) 0 ) )
+    {
+        pxMemPool->xBlockSize = memPOOL_BLOCK_SIZE( xBlockSize );
+        pxMemPool->pxFreeList = NULL;
+        pxMemPool->pucNextUnusedBlock = pucPoolStorageArea;
+        pxMemPool->pucStorageEnd = pucPoolStorageArea + ( pxMemPool->xBlockSize * ( size_t ) uxNumberOfBlocks );
+        pxMemPool->uxNumberOfBlocks = uxNumberOfBlocks;
+        pxMemPool->uxFreeBlocks = uxNumberOfBlocks;
+        pxMemPool->uxMinimumEverFreeBlocks = uxNumberOfBlocks;
+        pxMemPool->uxNumberOfFailedAllocations = 0;
+
+        xReturn = ( MemPoolHandle_t ) pxMemPool;
+    }
+    else
+    {
+        xReturn = NULL;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void * pvMemPoolAlloc( MemPoolHandle_t xMemPool )
+{
+    MemPool_t * const pxMemPool = xMemPool;
+    void * pvReturn = NULL;
+    UBaseType_t uxSavedInterruptStatus;
+
+    configASSERT( pxMemPool );
+
+    poolENTER_CRITICAL( uxSavedInterruptStatus );
+    {
+        if( pxMemPool->pxFreeList != NULL )
+        {
+            /* Reuse the block freed most recently. */
+            pvReturn = ( void * ) pxMemPool->pxFreeList;
+            pxMemPool->pxFreeList = pxMemPool->pxFreeList->pxNextFreeBlock;
+        }
+        else if( pxMemPool->pucNextUnusedBlock != pxMemPool->pucStorageEnd )
+        {
+            /* Take the next block that has never been used.  Blocks only join
+             * the free list once they are freed, so the pool did not need to
+             * link them all when it was created. */
+            pvReturn = ( void * ) pxMemPool->pucNextUnusedBlock;
+            pxMemPool->pucNextUnusedBlock += pxMemPool->xBlockSize;
+        }
+        else
+        {
+            pxMemPool->uxNumberOfFailedAllocations++;
+        }
+
+        if( pvReturn != NULL )
+        {
+            pxMemPool->uxFreeBlocks--;
+
+            if( pxMemPool->uxFreeBlocks < pxMemPool->uxMinimumEverFreeBlocks )
+            {
+                pxMemPool->uxMinimumEverFreeBlocks = pxMemPool->uxFreeBlocks;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    poolEXIT_CRITICAL( uxSavedInterruptStatus );
+
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vMemPoolFree( MemPoolHandle_t xMemPool,
+                   void * pvBlock )
+{
+    MemPool_t * const pxMemPool = xMemPool;
+    MemPoolBlock_t * const pxBlock = ( MemPoolBlock_t * ) pvBlock; /*lint !e9079 Blocks are aligned to hold a pointer. */
+    UBaseType_t uxSavedInterruptStatus;
+
+    configASSERT( pxMemPool );
+
+    if( pxBlock != NULL )
+    {
+        /* The block must be one that was handed out by this pool.  These
+         * checks only read values that do not change after the pool is
+         * created, so are made outside of the critical section. */
+        configASSERT( ( uint8_t * ) pxBlock < pxMemPool->pucStorageEnd );
+        configASSERT( ( uint8_t * ) pxBlock >= ( pxMemPool->pucStorageEnd - ( pxMemPool->xBlockSize * ( size_t ) pxMemPool->uxNumberOfBlocks ) ) );
+        configASSERT( ( ( size_t ) ( pxMemPool->pucStorageEnd - ( uint8_t * ) pxBlock ) % pxMemPool->xBlockSize ) == 0 );
+
+        poolENTER_CRITICAL( uxSavedInterruptStatus );
+        {
+            configASSERT( pxMemPool->uxFreeBlocks < pxMemPool->uxNumberOfBlocks );
+
+            pxBlock->pxNextFreeBlock = pxMemPool->pxFreeList;
+            pxMemPool->pxFreeList = pxBlock;
+            pxMemPool->uxFreeBlocks++;
+        }
+        poolEXIT_CRITICAL( uxSavedInterruptStatus );
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxMemPoolGetFreeBlocks( MemPoolHandle_t xMemPool )
+{
+    const MemPool_t * const pxMemPool = xMemPool;
+
+    configASSERT( pxMemPool );
+
+    /* A single aligned read, so no critical section is needed. */
+    return pxMemPool->uxFreeBlocks;
+}
+/*-----------------------------------------------------------*/
+
+void vMemPoolGetStats( MemPoolHandle_t xMemPool,
+                       MemPoolStats_t * pxPoolStats )
+{
+    const MemPool_t * const pxMemPool = xMemPool;
+    UBaseType_t uxSavedInterruptStatus;
+
+    configASSERT( pxMemPool );
+    configASSERT( pxPoolStats );
+
+    pxPoolStats->xBlockSize = pxMemPool->xBlockSize;
+    pxPoolStats->uxNumberOfBlocks = pxMemPool->uxNumberOfBlocks;
+
+    /* Take a consistent snapshot of the values that change. */
+    poolENTER_CRITICAL( uxSavedInterruptStatus );
+    {
+        pxPoolStats->uxFreeBlocks = pxMemPool->uxFreeBlocks;
+        pxPoolStats->uxMinimumEverFreeBlocks = pxMemPool->uxMinimumEverFreeBlocks;
+        pxPoolStats->uxNumberOfFailedAllocations = pxMemPool->uxNumberOfFailedAllocations;
+    }
+    poolEXIT_CRITICAL( uxSavedInterruptStatus );
+}
@@ -0,0 +1,780 @@
+/*
+ * FreeRTOS Kernel V10.4.3 LTS Patch 2
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * A sample implementation of pvPortMalloc() and vPortFree() that keeps free
+ * blocks in segregated size classes, so both functions execute in constant
+ * time however fragmented the heap becomes.  Adjacent free blocks are combined
+ * (coalesced) as they are freed, as in heap_4.c.
+ *
+ * The free blocks are grouped in the manner of a two level segregated fit
+ * (TLSF) allocator.  The first level divides block sizes into powers of two.
+ * The second level divides each power of two into
+ * ( 1 << configHEAP_SUBCLASS_BITS ) equally sized classes.  Each class has its
+ * own free list, and a bitmap for each level records which classes are not
+ * empty, so a suitable class is found with two count leading zeros operations
+ * rather than a walk of the free list.
+ *
+ * The requested size is rounded up to the start of the next class before the
+ * search, so the first block on any list found is large enough.  If that search
+ * fails the first block in the class the request itself falls in is also
+ * tried, so an allocation near the size of the largest free block can still
+ * succeed.
+ *
+ * The largest block is limited to ( 1 << configHEAP_MAX_BLOCK_BITS ) bytes, and
+ * configTOTAL_HEAP_SIZE must not be larger than that.
+ *
+ * See heap_1.c, heap_2.c, heap_3.c, heap_4.c and heap_5.c for alternative
+ * implementations, and the memory management pages of https://www.FreeRTOS.org
+ * for more information.
+ */
+#include <stdlib.h>
+#include <stddef.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+ * all the API functions to use the MPU wrappers.  That should only be done when
+ * task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if ( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+    #error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+/* The number of second level classes in each power of two is
+ * ( 1 << configHEAP_SUBCLASS_BITS ).  More classes waste less memory when a
+ * block is split, at the cost of a larger table of free lists. */
+#ifndef configHEAP_SUBCLASS_BITS
+    #define configHEAP_SUBCLASS_BITS    3
+#endif
+
+/* No block can be ( 1 << configHEAP_MAX_BLOCK_BITS ) bytes or larger.  The
+ * default covers the SRAM of any STM32F10x part. */
+#ifndef configHEAP_MAX_BLOCK_BITS
+    #define configHEAP_MAX_BLOCK_BITS    16
+#endif
+
+/* log2( portBYTE_ALIGNMENT ). */
+#if portBYTE_ALIGNMENT == 32
+    #define heapALIGNMENT_BITS    5
+#elif portBYTE_ALIGNMENT == 16
+    #define heapALIGNMENT_BITS    4
+#elif portBYTE_ALIGNMENT == 8
+    #define heapALIGNMENT_BITS    3
+#elif portBYTE_ALIGNMENT == 4
+    #define heapALIGNMENT_BITS    2
+#elif portBYTE_ALIGNMENT == 2
+    #define heapALIGNMENT_BITS    1
+#else
+    #define heapALIGNMENT_BITS    0
+#endif
+
+/* Blocks smaller than heapSMALL_BLOCK_SIZE all share the first first level
+ * index, and are divided into classes portBYTE_ALIGNMENT bytes wide.  Above
+ * that each power of two has its own first level index. */
+#define heapFIRST_LEVEL_SHIFT      ( configHEAP_SUBCLASS_BITS + heapALIGNMENT_BITS )
+#define heapFIRST_LEVEL_COUNT      ( configHEAP_MAX_BLOCK_BITS - heapFIRST_LEVEL_SHIFT + 1 )
+#define heapSECOND_LEVEL_COUNT     ( 1 << configHEAP_SUBCLASS_BITS )
+#define heapSMALL_BLOCK_SIZE       ( ( size_t ) 1 << heapFIRST_LEVEL_SHIFT )
+#define heapMAXIMUM_BLOCK_SIZE     ( ( ( size_t ) 1 << configHEAP_MAX_BLOCK_BITS ) - portBYTE_ALIGNMENT )
+
+#if ( configHEAP_SUBCLASS_BITS < 1 ) || ( configHEAP_SUBCLASS_BITS > 5 )
+    #error configHEAP_SUBCLASS_BITS must be between 1 and 5
+#endif
+
+#if ( heapFIRST_LEVEL_COUNT < 2 ) || ( heapFIRST_LEVEL_COUNT > 31 )
+    #error configHEAP_MAX_BLOCK_BITS is out of range for the configured alignment and configHEAP_SUBCLASS_BITS
+#endif
+
+/* Bit scans used to index the bitmaps.  The bitmap passed in must not be 0. */
+#if defined( __GNUC__ )
+    #define heapCOUNT_LEADING_ZEROS( ulBitmap )    ( ( uint32_t ) __builtin_clz( ulBitmap ) )
+#elif defined( __CC_ARM )
+    #define heapCOUNT_LEADING_ZEROS( ulBitmap )    ( ( uint32_t ) __clz( ulBitmap ) )
+#else
+    #define heapCOUNT_LEADING_ZEROS( ulBitmap )    prvCountLeadingZeros( ulBitmap )
+#endif
+
+#define heapHIGHEST_SET_BIT( ulBitmap )            ( 31UL - heapCOUNT_LEADING_ZEROS( ulBitmap ) )
+#define heapLOWEST_SET_BIT( ulBitmap )             heapHIGHEST_SET_BIT( ( ulBitmap ) & ( 0UL - ( ulBitmap ) ) )
+
+/* Allocate the memory for the heap. */
+#if ( configAPPLICATION_ALLOCATED_HEAP == 1 )
+
+/* The application writer has already defined the array used for the RTOS
+* heap - probably so it can be placed in a special segment or address. */
+    extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#else
+    PRIVILEGED_DATA static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#endif /* configAPPLICATION_ALLOCATED_HEAP */
+
+/* The header of every block.  Only the first two members are kept while the
+ * block is allocated - the free list links occupy the start of the memory
+ * returned to the application. */
+typedef struct A_BLOCK_LINK
+{
+    struct A_BLOCK_LINK * pxPreviousPhysicalBlock; /*<< The block immediately below this one in memory, or NULL for the first block. */
+    size_t xBlockSize;                             /*<< The size of the block, including the header, with xBlockAllocatedBit set while it is allocated. */
+    struct A_BLOCK_LINK * pxNextFreeBlock;         /*<< The next block in the same free list. */
+    struct A_BLOCK_LINK * pxPreviousFreeBlock;     /*<< The previous block in the same free list. */
+} BlockLink_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Calculates the first and second level indexes of the class a block of
+ * xBlockSize bytes belongs to.
+ */
+static void prvMapSize( size_t xBlockSize,
+                        UBaseType_t * puxFirstLevel,
+                        UBaseType_t * puxSecondLevel ) PRIVILEGED_FUNCTION;
+
+/*
+ * Returns a free block of at least xWantedSize bytes, already removed from its
+ * free list, or NULL if there is none.
+ */
+static BlockLink_t * prvTakeFreeBlock( size_t xWantedSize ) PRIVILEGED_FUNCTION;
+
+/*
+ * Adds a block to, and removes a block from, the free list of its class.
+ */
+static void prvInsertBlockIntoFreeList( BlockLink_t * pxBlockToInsert ) PRIVILEGED_FUNCTION;
+static void prvRemoveBlockFromFreeList( BlockLink_t * pxBlockToRemove ) PRIVILEGED_FUNCTION;
+
+/*
+ * Called automatically to setup the required heap structures the first time
+ * pvPortMalloc() is called.
+ */
+static void prvHeapInit( void ) PRIVILEGED_FUNCTION;
+
+#if !defined( __GNUC__ ) && !defined( __CC_ARM )
+    static uint32_t prvCountLeadingZeros( uint32_t ulBitmap ) PRIVILEGED_FUNCTION;
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* The size of the part of the header kept while a block is allocated, which
+ * must be correctly byte aligned. */
+static const size_t xHeapStructSize = ( offsetof( BlockLink_t, pxNextFreeBlock ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+/* A block must be large enough to hold the whole header once it is freed. */
+static const size_t xMinimumBlockSize = ( sizeof( BlockLink_t ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+/* The heads of the free lists, and the bitmaps that record which of them are
+ * not empty.  Bit n of ulFirstLevelBitmap is set when ulSecondLevelBitmap[ n ]
+ * is not 0. */
+PRIVILEGED_DATA static BlockLink_t * pxFreeLists[ heapFIRST_LEVEL_COUNT ][ heapSECOND_LEVEL_COUNT ];
+PRIVILEGED_DATA static uint32_t ulFirstLevelBitmap = 0;
+PRIVILEGED_DATA static uint32_t ulSecondLevelBitmap[ heapFIRST_LEVEL_COUNT ];
+
+/* Marks the end of the heap.  It is always allocated so is never coalesced. */
+PRIVILEGED_DATA static BlockLink_t * pxEnd = NULL;
+
+/* Keeps track of the number of calls to allocate and free memory as well as the
+ * number of free bytes remaining, but says nothing about fragmentation. */
+PRIVILEGED_DATA static size_t xFreeBytesRemaining = 0U;
+PRIVILEGED_DATA static size_t xMinimumEverFreeBytesRemaining = 0U;
+PRIVILEGED_DATA static size_t xNumberOfSuccessfulAllocations = 0;
+PRIVILEGED_DATA static size_t xNumberOfSuccessfulFrees = 0;
+
+/* Gets set to the top bit of an size_t type.  When this bit in the xBlockSize
+ * member of an BlockLink_t structure is set then the block belongs to the
+ * application.  When the bit is free the block is still part of the free heap
+ * space. */
+PRIVILEGED_DATA static size_t xBlockAllocatedBit = 0;
+
+/*-----------------------------------------------------------*/
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    BlockLink_t * pxBlock, * pxNewBlockLink, * pxNextBlock;
+    void * pvReturn = NULL;
+
+    vTaskSuspendAll();
+    {
+        /* If this is the first call to malloc then the heap will require
+         * initialisation to setup the list of free blocks. */
+        if( pxEnd == NULL )
+        {
+            prvHeapInit();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        /* The wanted size must be increased so it can contain the block header
+         * in addition to the requested amount of bytes, and must be aligned.
+         * Sizes larger than the largest block are rejected here, which also
+         * prevents the calculations overflowing. */
+        if( ( xWantedSize > 0 ) && ( xWantedSize <= ( heapMAXIMUM_BLOCK_SIZE - xHeapStructSize ) ) )
+        {
+            xWantedSize += xHeapStructSize;
+
+            /* Ensure that blocks are always aligned. */
+            if( ( xWantedSize & portBYTE_ALIGNMENT_MASK ) != 0x00 )
+            {
+                xWantedSize += ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) );
+                configASSERT( ( xWantedSize & portBYTE_ALIGNMENT_MASK ) == 0 );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            /* The block must be able to hold the free list links once it is
+             * freed again. */
+            if( xWantedSize < xMinimumBlockSize )
+            {
+                xWantedSize = xMinimumBlockSize;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            xWantedSize = 0;
+        }
+
+        if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
+        {
+            pxBlock = prvTakeFreeBlock( xWantedSize );
+
+            if( pxBlock != NULL )
+            {
+                /* Return the memory space pointed to - jumping over the part
+                 * of the header kept while the block is allocated. */
+                pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize );
+
+                /* If the block is larger than required it can be split into
+                 * two. */
+                if( ( pxBlock->xBlockSize - xWantedSize ) >= xMinimumBlockSize )
+                {
+                    /* This block is to be split into two.  Create a new block
+                     * following the number of bytes requested. The void cast is
+                     * used to prevent byte alignment warnings from the
+                     * compiler. */
+                    pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+                    configASSERT( ( ( ( size_t ) pxNewBlockLink ) & portBYTE_ALIGNMENT_MASK ) == 0 );
+
+                    /* Calculate the sizes of two blocks split from the single
+                     * block, and link the new block into the chain of physical
+                     * blocks. */
+                    pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+                    pxNewBlockLink->pxPreviousPhysicalBlock = pxBlock;
+                    pxBlock->xBlockSize = xWantedSize;
+
+                    pxNextBlock = ( void * ) ( ( ( uint8_t * ) pxNewBlockLink ) + pxNewBlockLink->xBlockSize );
+                    pxNextBlock->pxPreviousPhysicalBlock = pxNewBlockLink;
+
+                    /* Insert the new block into the list of free blocks.  The
+                     * block after it cannot be free, as free blocks are always
+                     * coalesced, so there is nothing to merge. */
+                    prvInsertBlockIntoFreeList( pxNewBlockLink );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                xFreeBytesRemaining -= pxBlock->xBlockSize;
+
+                if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+                {
+                    xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                /* The block is being returned - it is allocated and owned by
+                 * the application. */
+                pxBlock->xBlockSize |= xBlockAllocatedBit;
+                xNumberOfSuccessfulAllocations++;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        traceMALLOC( pvReturn, xWantedSize );
+    }
+    ( void ) xTaskResumeAll();
+
+    #if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+        {
+            if( pvReturn == NULL )
+            {
+                extern void vApplicationMallocFailedHook( void );
+                vApplicationMallocFailedHook();
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+    #endif /* if ( configUSE_MALLOC_FAILED_HOOK == 1 ) */
+
+    configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void * pv )
+{
+    uint8_t * puc = ( uint8_t * ) pv;
+    BlockLink_t * pxLink, * pxNeighbour;
+
+    if( pv != NULL )
+    {
+        /* The memory being freed will have the allocated part of a
+         * BlockLink_t structure immediately before it. */
+        puc -= xHeapStructSize;
+
+        /* This casting is to keep the compiler from issuing warnings. */
+        pxLink = ( void * ) puc;
+
+        /* Check the block is actually allocated. */
+        configASSERT( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 );
+
+        if( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 )
+        {
+            vTaskSuspendAll();
+            {
+                /* The block is being returned to the heap - it is no longer
+                 * allocated. */
+                pxLink->xBlockSize &= ~xBlockAllocatedBit;
+                xFreeBytesRemaining += pxLink->xBlockSize;
+                traceFREE( pv, pxLink->xBlockSize );
+
+                /* Merge with the block after this one if it is free.  pxEnd is
+                 * always marked as allocated so is never merged. */
+                pxNeighbour = ( void * ) ( ( ( uint8_t * ) pxLink ) + pxLink->xBlockSize );
+
+                if( ( pxNeighbour->xBlockSize & xBlockAllocatedBit ) == 0 )
+                {
+                    prvRemoveBlockFromFreeList( pxNeighbour );
+                    pxLink->xBlockSize += pxNeighbour->xBlockSize;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                /* Merge with the block before this one if it is free. */
+                pxNeighbour = pxLink->pxPreviousPhysicalBlock;
+
+                if( ( pxNeighbour != NULL ) && ( ( pxNeighbour->xBlockSize & xBlockAllocatedBit ) == 0 ) )
+                {
+                    prvRemoveBlockFromFreeList( pxNeighbour );
+                    pxNeighbour->xBlockSize += pxLink->xBlockSize;
+                    pxLink = pxNeighbour;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                /* The block after the (possibly merged) block must point back
+                 * to it. */
+                pxNeighbour = ( void * ) ( ( ( uint8_t * ) pxLink ) + pxLink->xBlockSize );
+                pxNeighbour->pxPreviousPhysicalBlock = pxLink;
+
+                prvInsertBlockIntoFreeList( pxLink );
+                xNumberOfSuccessfulFrees++;
+            }
+            ( void ) xTaskResumeAll();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+    return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+    return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+    /* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void ) /* PRIVILEGED_FUNCTION */
+{
+    BlockLink_t * pxFirstFreeBlock;
+    uint8_t * pucAlignedHeap;
+    size_t uxAddress;
+    size_t xTotalHeapSize = configTOTAL_HEAP_SIZE;
+
+    /* Work out the position of the top bit in a size_t variable. */
+    xBlockAllocatedBit = ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * ( size_t ) 8 ) - 1 );
+
+    /* Ensure the heap starts on a correctly aligned boundary. */
+    uxAddress = ( size_t ) ucHeap;
+
+    if( ( uxAddress & portBYTE_ALIGNMENT_MASK ) != 0 )
+    {
+        uxAddress += ( portBYTE_ALIGNMENT - 1 );
+        uxAddress &= ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+        xTotalHeapSize -= uxAddress - ( size_t ) ucHeap;
+    }
+
+    pucAlignedHeap = ( uint8_t * ) uxAddress;
+
+    /* The whole heap must fit in one block.  If it does not then
+     * configHEAP_MAX_BLOCK_BITS must be increased - the memory past the largest
+     * block is otherwise never used. */
+    configASSERT( xTotalHeapSize <= ( heapMAXIMUM_BLOCK_SIZE + xHeapStructSize ) );
+
+    if( xTotalHeapSize > ( heapMAXIMUM_BLOCK_SIZE + xHeapStructSize ) )
+    {
+        xTotalHeapSize = heapMAXIMUM_BLOCK_SIZE + xHeapStructSize;
+    }
+
+    /* pxEnd is used to mark the end of the heap.  It is inserted at the end of
+     * the heap space and is permanently allocated. */
+    uxAddress = ( ( size_t ) pucAlignedHeap ) + xTotalHeapSize;
+    uxAddress -= xHeapStructSize;
+    uxAddress &= ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+    pxEnd = ( void * ) uxAddress;
+
+    /* To start with there is a single free block that is sized to take up the
+     * entire heap space, minus the space taken by pxEnd. */
+    pxFirstFreeBlock = ( void * ) pucAlignedHeap;
+    pxFirstFreeBlock->xBlockSize = uxAddress - ( size_t ) pxFirstFreeBlock;
+    pxFirstFreeBlock->pxPreviousPhysicalBlock = NULL;
+
+    pxEnd->xBlockSize = xBlockAllocatedBit;
+    pxEnd->pxPreviousPhysicalBlock = pxFirstFreeBlock;
+
+    prvInsertBlockIntoFreeList( pxFirstFreeBlock );
+
+    /* Only one block exists - and it covers the entire usable heap space. */
+    xMinimumEverFreeBytesRemaining = pxFirstFreeBlock->xBlockSize;
+    xFreeBytesRemaining = pxFirstFreeBlock->xBlockSize;
+}
+/*-----------------------------------------------------------*/
+
+static void prvMapSize( size_t xBlockSize,
+                        UBaseType_t * puxFirstLevel,
+                        UBaseType_t * puxSecondLevel ) /* PRIVILEGED_FUNCTION */
+{
+    uint32_t ulTopBit;
+
+    if( xBlockSize < heapSMALL_BLOCK_SIZE )
+    {
+        *puxFirstLevel = 0;
+        *puxSecondLevel = ( UBaseType_t ) ( xBlockSize >> heapALIGNMENT_BITS );
+    }
+    else
+    {
+        /* The second level index is the configHEAP_SUBCLASS_BITS bits below
+         * the top set bit. */
+        ulTopBit = heapHIGHEST_SET_BIT( ( uint32_t ) xBlockSize );
+        *puxFirstLevel = ( UBaseType_t ) ( ulTopBit - heapFIRST_LEVEL_SHIFT + 1UL );
+        *puxSecondLevel = ( UBaseType_t ) ( ( xBlockSize >> ( ulTopBit - configHEAP_SUBCLASS_BITS ) ) - heapSECOND_LEVEL_COUNT );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BlockLink_t * prvTakeFreeBlock( size_t xWantedSize ) /* PRIVILEGED_FUNCTION */
+{
+    BlockLink_t * pxBlock = NULL;
+    size_t xRoundedSize = xWantedSize;
+    UBaseType_t uxFirstLevel, uxSecondLevel;
+    uint32_t ulBitmap;
+
+    /* Round the size up to the start of the next class, so any block on the
+     * lists searched is large enough.  Classes below heapSMALL_BLOCK_SIZE are
+     * exactly one size wide so need no rounding. */
+    if( xRoundedSize >= heapSMALL_BLOCK_SIZE )
+    {
+        xRoundedSize += ( ( size_t ) 1 << ( heapHIGHEST_SET_BIT( ( uint32_t ) xRoundedSize ) - configHEAP_SUBCLASS_BITS ) ) - 1U;
+    }
+
+    prvMapSize( xRoundedSize, &uxFirstLevel, &uxSecondLevel );
+
+    if( uxFirstLevel < heapFIRST_LEVEL_COUNT )
+    {
+        /* Look for a non-empty class at or above the rounded size in the same
+         * power of two, then in the smallest larger power of two that has any
+         * free blocks. */
+        ulBitmap = ulSecondLevelBitmap[ uxFirstLevel ] & ( ~0UL << uxSecondLevel );
+
+        if( ulBitmap == 0 )
+        {
+            ulBitmap = ulFirstLevelBitmap & ( ~0UL << ( uxFirstLevel + 1 ) );
+
+            if( ulBitmap != 0 )
+            {
+                uxFirstLevel = ( UBaseType_t ) heapLOWEST_SET_BIT( ulBitmap );
+                ulBitmap = ulSecondLevelBitmap[ uxFirstLevel ];
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        if( ulBitmap != 0 )
+        {
+            uxSecondLevel = ( UBaseType_t ) heapLOWEST_SET_BIT( ulBitmap );
+            pxBlock = pxFreeLists[ uxFirstLevel ][ uxSecondLevel ];
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    if( pxBlock == NULL )
+    {
+        /* Only blocks in the class the wanted size itself falls in remain.
+         * Checking just the first of them keeps the time bounded. */
+        prvMapSize( xWantedSize, &uxFirstLevel, &uxSecondLevel );
+        pxBlock = pxFreeLists[ uxFirstLevel ][ uxSecondLevel ];
+
+        if( ( pxBlock != NULL ) && ( pxBlock->xBlockSize < xWantedSize ) )
+        {
+            pxBlock = NULL;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    if( pxBlock != NULL )
+    {
+        prvRemoveBlockFromFreeList( pxBlock );
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return pxBlock;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertBlockIntoFreeList( BlockLink_t * pxBlockToInsert ) /* PRIVILEGED_FUNCTION */
+{
+    UBaseType_t uxFirstLevel, uxSecondLevel;
+    BlockLink_t * pxHead;
+
+    prvMapSize( pxBlockToInsert->xBlockSize, &uxFirstLevel, &uxSecondLevel );
+
+    /* Blocks are added to the front of their list. */
+    pxHead = pxFreeLists[ uxFirstLevel ][ uxSecondLevel ];
+    pxBlockToInsert->pxNextFreeBlock = pxHead;
+    pxBlockToInsert->pxPreviousFreeBlock = NULL;
+
+    if( pxHead != NULL )
+    {
+        pxHead->pxPreviousFreeBlock = pxBlockToInsert;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    pxFreeLists[ uxFirstLevel ][ uxSecondLevel ] = pxBlockToInsert;
+    ulFirstLevelBitmap |= ( 1UL << uxFirstLevel );
+    ulSecondLevelBitmap[ uxFirstLevel ] |= ( 1UL << uxSecondLevel );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveBlockFromFreeList( BlockLink_t * pxBlockToRemove ) /* PRIVILEGED_FUNCTION */
+{
+    UBaseType_t uxFirstLevel, uxSecondLevel;
+
+    if( pxBlockToRemove->pxNextFreeBlock != NULL )
+    {
+        pxBlockToRemove->pxNextFreeBlock->pxPreviousFreeBlock = pxBlockToRemove->pxPreviousFreeBlock;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    if( pxBlockToRemove->pxPreviousFreeBlock != NULL )
+    {
+        pxBlockToRemove->pxPreviousFreeBlock->pxNextFreeBlock = pxBlockToRemove->pxNextFreeBlock;
+    }
+    else
+    {
+        /* The block is at the head of its list, which may now be empty. */
+        prvMapSize( pxBlockToRemove->xBlockSize, &uxFirstLevel, &uxSecondLevel );
+        pxFreeLists[ uxFirstLevel ][ uxSecondLevel ] = pxBlockToRemove->pxNextFreeBlock;
+
+        if( pxBlockToRemove->pxNextFreeBlock == NULL )
+        {
+            ulSecondLevelBitmap[ uxFirstLevel ] &= ~( 1UL << uxSecondLevel );
+
+            if( ulSecondLevelBitmap[ uxFirstLevel ] == 0 )
+            {
+                ulFirstLevelBitmap &= ~( 1UL << uxFirstLevel );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+#if !defined( __GNUC__ ) && !defined( __CC_ARM )
+
+    static uint32_t prvCountLeadingZeros( uint32_t ulBitmap ) /* PRIVILEGED_FUNCTION */
+    {
+        uint32_t ulCount = 0;
+
+        /* A binary search, so the time taken does not depend on the value. */
+        if( ( ulBitmap & 0xFFFF0000UL ) == 0 )
+        {
+            ulCount += 16;
+            ulBitmap <<= 16;
+        }
+
+        if( ( ulBitmap & 0xFF000000UL ) == 0 )
+        {
+            ulCount += 8;
+            ulBitmap <<= 8;
+        }
+
+        if( ( ulBitmap & 0xF0000000UL ) == 0 )
+        {
+            ulCount += 4;
+            ulBitmap <<= 4;
+        }
+
+        if( ( ulBitmap & 0xC0000000UL ) == 0 )
+        {
+            ulCount += 2;
+            ulBitmap <<= 2;
+        }
+
+        if( ( ulBitmap & 0x80000000UL ) == 0 )
+        {
+            ulCount += 1;
+        }
+
+        return ulCount;
+    }
+
+#endif /* if !defined( __GNUC__ ) && !defined( __CC_ARM ) */
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t * pxHeapStats )
+{
+    BlockLink_t * pxBlock;
+    UBaseType_t uxFirstLevel, uxSecondLevel;
+    size_t xBlocks = 0, xMaxSize = 0, xMinSize = portMAX_DELAY; /* portMAX_DELAY used as a portable way of getting the maximum value. */
+
+    vTaskSuspendAll();
+    {
+        /* Walk every free list.  All the lists are empty if the heap has not
+         * been initialised.  The heap is initialised automatically when the
+         * first allocation is made. */
+        for( uxFirstLevel = 0; uxFirstLevel < heapFIRST_LEVEL_COUNT; uxFirstLevel++ )
+        {
+            for( uxSecondLevel = 0; uxSecondLevel < heapSECOND_LEVEL_COUNT; uxSecondLevel++ )
+            {
+                for( pxBlock = pxFreeLists[ uxFirstLevel ][ uxSecondLevel ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+                {
+                    /* Increment the number of blocks and record the largest
+                     * and smallest blocks seen so far. */
+                    xBlocks++;
+
+                    if( pxBlock->xBlockSize > xMaxSize )
+                    {
+                        xMaxSize = pxBlock->xBlockSize;
+                    }
+
+                    if( pxBlock->xBlockSize < xMinSize )
+                    {
+                        xMinSize = pxBlock->xBlockSize;
+                    }
+                }
+            }
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+    pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xMinSize;
+    pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+
+    taskENTER_CRITICAL();
+    {
+        pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+        pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+        pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+        pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+    }
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,466 @@
+/*
+ * FreeRTOS Kernel V10.4.3 LTS Patch 2
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*-----------------------------------------------------------
+* Implementation of functions defined in portable.h for a POSIX host, so the
+* kernel and the demo can be built and run on Linux.
+*
+* Each task runs in a pthread of its own, but only one of the threads runs at
+* a time.  The others wait on an event of their own, and a context switch
+* signals the event of the thread being switched to before the thread being
+* switched from waits on its own.  The tick is the SIGALRM of an interval
+* timer.  SIGALRM is blocked in every thread other than the running one, and
+* in that one too while it is in a critical section, so the tick handler
+* always runs in the thread of the running task and can switch it out from
+* within the handler.
+*
+* The task stack allocated by the kernel only holds a pointer to the thread,
+* each thread has a stack of its own.
+*----------------------------------------------------------*/
+
+/* Standard includes. */
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* The size of the stack of each thread.  The C library needs more than the
+ * stacks sized for the target. */
+#ifndef portTHREAD_STACK_SIZE
+    #define portTHREAD_STACK_SIZE    ( 256U * 1024U )
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* A binary flag a thread can wait on. */
+typedef struct EVENT
+{
+    pthread_mutex_t xMutex;
+    pthread_cond_t xCondition;
+    BaseType_t xSignalled;
+} Event_t;
+
+/* The thread of a task. */
+typedef struct THREAD
+{
+    pthread_t xThread;
+    TaskFunction_t pxCode;
+    void * pvParameters;
+    Event_t xResume;            /* Signalled to switch to the thread. */
+    volatile BaseType_t xDying; /* Set when the task has been deleted. */
+} Thread_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Installs the tick handler.  Called once, when the first task is created.
+ */
+static void prvSetUp( void );
+
+/*
+ * The entry point of each thread, which waits to be switched to for the
+ * first time before it calls the task function.
+ */
+static void * prvThreadStart( void * pvParameters );
+
+/*
+ * Returns the thread of a task, the pointer held at the top of its stack.
+ */
+static Thread_t * prvGetThreadFromTask( void * pxTCB );
+
+/*
+ * Switches from the calling thread, pxThreadToSuspend, to pxThreadToResume,
+ * and returns once the calling thread has been switched back to.
+ */
+static void prvSwitchThread( Thread_t * pxThreadToResume,
+                             Thread_t * pxThreadToSuspend );
+
+/*
+ * Waits until the calling thread is switched to, or ends the thread if its
+ * task has been deleted in the meantime.
+ */
+static void prvSuspendSelf( Thread_t * pxThread );
+
+/*
+ * The SIGALRM handler.
+ */
+static void prvTickHandler( int iSignal );
+
+/*
+ * Event helpers.
+ */
+static void prvEventInit( Event_t * pxEvent );
+static void prvEventDelete( Event_t * pxEvent );
+static void prvEventWait( Event_t * pxEvent );
+static void prvEventSignal( Event_t * pxEvent );
+
+/*-----------------------------------------------------------*/
+
+static pthread_once_t xSetUpOnce = PTHREAD_ONCE_INIT;
+
+/* Holds SIGALRM only. */
+static sigset_t xTickSignal;
+
+/* Each task has its own nesting count, which is saved on the stack of its
+ * thread while the thread is switched out. */
+static volatile UBaseType_t uxCriticalNesting = 0;
+
+/* Set once the first task has been started. */
+static volatile BaseType_t xSchedulerStarted = pdFALSE;
+
+/* Set while the tick handler runs.  A yield requested by an interrupt the
+ * tick hook simulates is held in xYieldFromTick until the handler ends, as
+ * PendSV holds it until the interrupt returns on the target. */
+static volatile BaseType_t xInTickHandler = pdFALSE;
+static volatile BaseType_t xYieldFromTick = pdFALSE;
+
+/* Signalled by vPortEndScheduler() to return from xPortStartScheduler(). */
+static Event_t xSchedulerEnd;
+
+/*-----------------------------------------------------------*/
+
+StackType_t * pxPortInitialiseStack( StackType_t * pxTopOfStack,
+                                     TaskFunction_t pxCode,
+                                     void * pvParameters )
+{
+    Thread_t * pxThread;
+    pthread_attr_t xAttributes;
+    int iReturned;
+
+    ( void ) pthread_once( &xSetUpOnce, prvSetUp );
+
+    /* The new thread inherits the signal mask of the calling thread, so it
+     * starts with SIGALRM blocked.  The tick must not switch the calling
+     * thread out while it holds a lock of the C library either. */
+    vPortEnterCritical();
+    {
+        pxThread = ( Thread_t * ) malloc( sizeof( Thread_t ) );
+        configASSERT( pxThread != NULL );
+
+        pxThread->pxCode = pxCode;
+        pxThread->pvParameters = pvParameters;
+        pxThread->xDying = pdFALSE;
+        prvEventInit( &( pxThread->xResume ) );
+
+        ( void ) pthread_attr_init( &xAttributes );
+        ( void ) pthread_attr_setstacksize( &xAttributes, portTHREAD_STACK_SIZE );
+        ( void ) pthread_attr_setdetachstate( &xAttributes, PTHREAD_CREATE_DETACHED );
+
+        iReturned = pthread_create( &( pxThread->xThread ), &xAttributes, prvThreadStart, ( void * ) pxThread );
+        configASSERT( iReturned == 0 );
+        ( void ) iReturned;
+
+        ( void ) pthread_attr_destroy( &xAttributes );
+    }
+    vPortExitCritical();
+
+    *pxTopOfStack = ( StackType_t ) pxThread;
+
+    return pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortStartScheduler( void )
+{
+    struct itimerval xTimer;
+
+    /* vTaskStartScheduler() has masked interrupts, so SIGALRM stays blocked
+     * in this thread, which only waits for the scheduler to end. */
+    xTimer.it_interval.tv_sec = 0;
+    xTimer.it_interval.tv_usec = ( suseconds_t ) ( 1000000UL / configTICK_RATE_HZ );
+    xTimer.it_value = xTimer.it_interval;
+    ( void ) setitimer( ITIMER_REAL, &xTimer, NULL );
+
+    xSchedulerStarted = pdTRUE;
+    prvEventSignal( &( prvGetThreadFromTask( xTaskGetCurrentTaskHandle() )->xResume ) );
+
+    prvEventWait( &xSchedulerEnd );
+
+    return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+    struct itimerval xTimer;
+
+    memset( &xTimer, 0x00, sizeof( xTimer ) );
+    ( void ) setitimer( ITIMER_REAL, &xTimer, NULL );
+
+    /* Return from xPortStartScheduler() in the thread that started the
+     * scheduler.  The calling task never runs again. */
+    prvEventSignal( &xSchedulerEnd );
+
+    for( ; ; )
+    {
+        ( void ) pause();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+    Thread_t * pxThreadToSuspend;
+    Thread_t * pxThreadToResume;
+
+    if( xInTickHandler != pdFALSE )
+    {
+        xYieldFromTick = pdTRUE;
+    }
+    else if( xSchedulerStarted != pdFALSE )
+    {
+        vPortEnterCritical();
+        {
+            pxThreadToSuspend = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+            vTaskSwitchContext();
+            pxThreadToResume = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+
+            prvSwitchThread( pxThreadToResume, pxThreadToSuspend );
+        }
+        vPortExitCritical();
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortIsInsideInterrupt( void )
+{
+    return xInTickHandler;
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+    ( void ) pthread_sigmask( SIG_BLOCK, &xTickSignal, NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+    ( void ) pthread_sigmask( SIG_UNBLOCK, &xTickSignal, NULL );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortSetInterruptMask( void )
+{
+    sigset_t xPrevious;
+
+    ( void ) pthread_sigmask( SIG_BLOCK, &xTickSignal, &xPrevious );
+
+    return ( UBaseType_t ) sigismember( &xPrevious, SIGALRM );
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( UBaseType_t uxMask )
+{
+    if( uxMask == 0 )
+    {
+        vPortEnableInterrupts();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+    vPortDisableInterrupts();
+    uxCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+    configASSERT( uxCriticalNesting > 0 );
+
+    uxCriticalNesting--;
+
+    if( uxCriticalNesting == 0 )
+    {
+        vPortEnableInterrupts();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortCleanUpTCB( void * pxTCB )
+{
+    Thread_t * pxThread = prvGetThreadFromTask( pxTCB );
+
+    /* The thread is waiting to be switched to, and ends instead. */
+    pxThread->xDying = pdTRUE;
+    prvEventSignal( &( pxThread->xResume ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetUp( void )
+{
+    struct sigaction xAction;
+
+    ( void ) sigemptyset( &xTickSignal );
+    ( void ) sigaddset( &xTickSignal, SIGALRM );
+
+    /* SA_RESTART so the tick does not make the system calls of the C library
+     * fail with EINTR. */
+    memset( &xAction, 0x00, sizeof( xAction ) );
+    xAction.sa_handler = prvTickHandler;
+    xAction.sa_flags = SA_RESTART;
+    ( void ) sigfillset( &( xAction.sa_mask ) );
+    ( void ) sigaction( SIGALRM, &xAction, NULL );
+
+    prvEventInit( &xSchedulerEnd );
+}
+/*-----------------------------------------------------------*/
+
+static void * prvThreadStart( void * pvParameters )
+{
+    Thread_t * pxThread = ( Thread_t * ) pvParameters;
+
+    prvSuspendSelf( pxThread );
+
+    /* Switched to for the first time, from a yield, from the tick handler or
+     * by xPortStartScheduler(). */
+    uxCriticalNesting = 0;
+    vPortEnableInterrupts();
+
+    pxThread->pxCode( pxThread->pvParameters );
+
+    /* A task must not return from its function, it must delete itself. */
+    configASSERT( pdFALSE );
+    vTaskDelete( NULL );
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static Thread_t * prvGetThreadFromTask( void * pxTCB )
+{
+    /* The first member of a TCB is the top of its stack. */
+    StackType_t * pxTopOfStack = *( ( StackType_t ** ) pxTCB );
+
+    return ( Thread_t * ) *pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSwitchThread( Thread_t * pxThreadToResume,
+                             Thread_t * pxThreadToSuspend )
+{
+    UBaseType_t uxSavedCriticalNesting;
+
+    if( pxThreadToResume != pxThreadToSuspend )
+    {
+        uxSavedCriticalNesting = uxCriticalNesting;
+
+        prvEventSignal( &( pxThreadToResume->xResume ) );
+        prvSuspendSelf( pxThreadToSuspend );
+
+        uxCriticalNesting = uxSavedCriticalNesting;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvSuspendSelf( Thread_t * pxThread )
+{
+    prvEventWait( &( pxThread->xResume ) );
+
+    if( pxThread->xDying != pdFALSE )
+    {
+        prvEventDelete( &( pxThread->xResume ) );
+        free( pxThread );
+        pthread_exit( NULL );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvTickHandler( int iSignal )
+{
+    Thread_t * pxThreadToSuspend;
+    Thread_t * pxThreadToResume;
+    BaseType_t xSwitchRequired;
+
+    ( void ) iSignal;
+
+    /* SIGALRM is blocked while the handler runs. */
+    uxCriticalNesting++;
+
+    pxThreadToSuspend = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+
+    xInTickHandler = pdTRUE;
+    xYieldFromTick = pdFALSE;
+    xSwitchRequired = xTaskIncrementTick();
+    xInTickHandler = pdFALSE;
+
+    if( ( xSwitchRequired != pdFALSE ) || ( xYieldFromTick != pdFALSE ) )
+    {
+        vTaskSwitchContext();
+        pxThreadToResume = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+
+        prvSwitchThread( pxThreadToResume, pxThreadToSuspend );
+    }
+
+    uxCriticalNesting--;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventInit( Event_t * pxEvent )
+{
+    ( void ) pthread_mutex_init( &( pxEvent->xMutex ), NULL );
+    ( void ) pthread_cond_init( &( pxEvent->xCondition ), NULL );
+    pxEvent->xSignalled = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventDelete( Event_t * pxEvent )
+{
+    ( void ) pthread_cond_destroy( &( pxEvent->xCondition ) );
+    ( void ) pthread_mutex_destroy( &( pxEvent->xMutex ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventWait( Event_t * pxEvent )
+{
+    ( void ) pthread_mutex_lock( &( pxEvent->xMutex ) );
+
+    while( pxEvent->xSignalled == pdFALSE )
+    {
+        ( void ) pthread_cond_wait( &( pxEvent->xCondition ), &( pxEvent->xMutex ) );
+    }
+
+    pxEvent->xSignalled = pdFALSE;
+
+    ( void ) pthread_mutex_unlock( &( pxEvent->xMutex ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventSignal( Event_t * pxEvent )
+{
+    ( void ) pthread_mutex_lock( &( pxEvent->xMutex ) );
+    pxEvent->xSignalled = pdTRUE;
+    ( void ) pthread_cond_signal( &( pxEvent->xCondition ) );
+    ( void ) pthread_mutex_unlock( &( pxEvent->xMutex ) );
+}
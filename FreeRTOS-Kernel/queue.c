@@ -81,6 +81,21 @@ typedef struct SemaphoreData
 #define queueSEMAPHORE_QUEUE_ITEM_LENGTH    ( ( UBaseType_t ) 0 )
 #define queueMUTEX_GIVE_BLOCK_TIME          ( ( TickType_t ) 0U )
 
+/* Bits of ucZeroCopySlots.  A slot is acquired between xQueueAcquireSlot()
+ * and vQueueCommitSlot(), and borrowed between xQueueBorrowSlot() and
+ * vQueueReleaseSlot(). */
+#define queueSLOT_ACQUIRED                  ( ( uint8_t ) 0x01U )
+#define queueSLOT_BORROWED                  ( ( uint8_t ) 0x02U )
+
+/* The copying send and receive functions must not be used on a queue while a
+ * slot is acquired or borrowed, as they would write to the acquired slot or
+ * skip over the borrowed one. */
+#if ( configUSE_QUEUE_ZERO_COPY == 1 )
+    #define queueASSERT_NO_ZERO_COPY_SLOTS( pxQueue )    configASSERT( ( pxQueue )->ucZeroCopySlots == 0U )
+#else
+    #define queueASSERT_NO_ZERO_COPY_SLOTS( pxQueue )
+#endif
+
 #if ( configUSE_PREEMPTION == 0 )
 
 /* If the cooperative scheduler is being used then a yield should not be
@@ -128,6 +143,10 @@ typedef struct QueueDefinition /* The old naming convention is used to prevent b
         UBaseType_t uxQueueNumber;
         uint8_t ucQueueType;
     #endif
+
+    #if ( configUSE_QUEUE_ZERO_COPY == 1 )
+        uint8_t ucZeroCopySlots; /*< queueSLOT_ACQUIRED and queueSLOT_BORROWED bits recording the slots handed out by the zero copy functions. */
+    #endif
 } xQUEUE;
 
 /* The old xQUEUE name is maintained above then typedefed to the new Queue_t
@@ -201,6 +220,47 @@ static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue,
 static void prvCopyDataFromQueue( Queue_t * const pxQueue,
                                   void * const pvBuffer ) PRIVILEGED_FUNCTION;
 
+/*
+ * Copy uxItemCount items to the back of, or out of the front of, a queue that
+ * is known to have the space or the items.
+ */
+static void prvCopyItemsToQueue( Queue_t * const pxQueue,
+                                 const int8_t * pcItems,
+                                 const UBaseType_t uxItemCount ) PRIVILEGED_FUNCTION;
+static void prvCopyItemsFromQueue( Queue_t * const pxQueue,
+                                   int8_t * pcBuffer,
+                                   const UBaseType_t uxItemCount ) PRIVILEGED_FUNCTION;
+
+/*
+ * Removes up to uxMaxTasks tasks from an event list.  Returns pdTRUE if any of
+ * them has a priority above that of the calling task.
+ */
+static BaseType_t prvUnblockTasks( List_t * const pxEventList,
+                                   UBaseType_t uxMaxTasks ) PRIVILEGED_FUNCTION;
+
+/*
+ * Informs the tasks waiting to receive from a queue, or the queue set that
+ * contains it, that uxItemCount items were sent to the queue.  Returns pdTRUE
+ * if a context switch is required.
+ */
+static BaseType_t prvNotifyItemsSent( Queue_t * const pxQueue,
+                                      UBaseType_t uxItemCount ) PRIVILEGED_FUNCTION;
+
+/*
+ * Adds uxItemCount to the lock count of a locked queue, saturating at
+ * queueINT8_MAX.
+ */
+static int8_t prvAddToLockCount( const int8_t cLockCount,
+                                 const UBaseType_t uxItemCount ) PRIVILEGED_FUNCTION;
+
+#if ( configUSE_QUEUE_ZERO_COPY == 1 )
+
+/*
+ * Adds the acquired slot to the back of the queue.
+ */
+    static void prvCommitSlot( Queue_t * const pxQueue ) PRIVILEGED_FUNCTION;
+#endif
+
 #if ( configUSE_QUEUE_SETS == 1 )
 
 /*
@@ -277,6 +337,13 @@ BaseType_t xQueueGenericReset( QueueHandle_t xQueue,
         pxQueue->cRxLock = queueUNLOCKED;
         pxQueue->cTxLock = queueUNLOCKED;
 
+        #if ( configUSE_QUEUE_ZERO_COPY == 1 )
+            {
+                /* Any slots handed out are forgotten. */
+                pxQueue->ucZeroCopySlots = 0U;
+            }
+        #endif
+
         if( xNewQueue == pdFALSE )
         {
             /* If there are tasks blocked waiting to read from the queue, then
@@ -778,6 +845,7 @@ BaseType_t xQueueGenericSend( QueueHandle_t xQueue,
     Queue_t * const pxQueue = xQueue;
 
     configASSERT( pxQueue );
+    queueASSERT_NO_ZERO_COPY_SLOTS( pxQueue );
     configASSERT( !( ( pvItemToQueue == NULL ) && ( pxQueue->uxItemSize != ( UBaseType_t ) 0U ) ) );
     configASSERT( !( ( xCopyPosition == queueOVERWRITE ) && ( pxQueue->uxLength != 1 ) ) );
     #if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
@@ -990,6 +1058,7 @@ BaseType_t xQueueGenericSendFromISR( QueueHandle_t xQueue,
     Queue_t * const pxQueue = xQueue;
 
     configASSERT( pxQueue );
+    queueASSERT_NO_ZERO_COPY_SLOTS( pxQueue );
     configASSERT( !( ( pvItemToQueue == NULL ) && ( pxQueue->uxItemSize != ( UBaseType_t ) 0U ) ) );
     configASSERT( !( ( xCopyPosition == queueOVERWRITE ) && ( pxQueue->uxLength != 1 ) ) );
 
@@ -1325,6 +1394,7 @@ BaseType_t xQueueReceive( QueueHandle_t xQueue,
 
     /* Check the pointer is not NULL. */
     configASSERT( ( pxQueue ) );
+    queueASSERT_NO_ZERO_COPY_SLOTS( pxQueue );
 
     /* The buffer into which data is received can only be NULL if the data size
      * is zero (so no data is copied into the buffer). */
@@ -1837,6 +1907,7 @@ BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue,
     Queue_t * const pxQueue = xQueue;
 
     configASSERT( pxQueue );
+    queueASSERT_NO_ZERO_COPY_SLOTS( pxQueue );
     configASSERT( !( ( pvBuffer == NULL ) && ( pxQueue->uxItemSize != ( UBaseType_t ) 0U ) ) );
 
     /* RTOS ports that support interrupt nesting have the concept of a maximum
@@ -1978,175 +2049,1078 @@ BaseType_t xQueuePeekFromISR( QueueHandle_t xQueue,
 }
 /*-----------------------------------------------------------*/
 
-UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xQueue )
-{
-    UBaseType_t uxReturn;
-
-    configASSERT( xQueue );
+#if ( configUSE_QUEUE_ZERO_COPY == 1 )
 
-    taskENTER_CRITICAL();
+    BaseType_t xQueueAcquireSlot( QueueHandle_t xQueue,
+                                  void ** const ppvSlot,
+                                  TickType_t xTicksToWait )
     {
-        uxReturn = ( ( Queue_t * ) xQueue )->uxMessagesWaiting;
-    }
-    taskEXIT_CRITICAL();
+        BaseType_t xEntryTimeSet = pdFALSE;
+        TimeOut_t xTimeOut;
+        Queue_t * const pxQueue = xQueue;
 
-    return uxReturn;
-} /*lint !e818 Pointer cannot be declared const as xQueue is a typedef not pointer. */
-/*-----------------------------------------------------------*/
+        configASSERT( pxQueue );
+        configASSERT( ppvSlot );
+        configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U ); /* Semaphores have no storage. */
+        #if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+            {
+                configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+            }
+        #endif
 
-UBaseType_t uxQueueSpacesAvailable( const QueueHandle_t xQueue )
-{
-    UBaseType_t uxReturn;
-    Queue_t * const pxQueue = xQueue;
+        /*lint -save -e904 This function relaxes the coding standard somewhat to
+         * allow return statements within the function itself.  This is done in the
+         * interest of execution time efficiency. */
+        for( ; ; )
+        {
+            taskENTER_CRITICAL();
+            {
+                /* Only one slot can be acquired at a time. */
+                configASSERT( ( pxQueue->ucZeroCopySlots & queueSLOT_ACQUIRED ) == 0U );
 
-    configASSERT( pxQueue );
+                /* Is there room on the queue now?  The slot is the one the next
+                 * item sent to the back of the queue would be copied into. */
+                if( pxQueue->uxMessagesWaiting < pxQueue->uxLength )
+                {
+                    *ppvSlot = ( void * ) pxQueue->pcWriteTo;
+                    pxQueue->ucZeroCopySlots |= queueSLOT_ACQUIRED;
 
-    taskENTER_CRITICAL();
-    {
-        uxReturn = pxQueue->uxLength - pxQueue->uxMessagesWaiting;
-    }
-    taskEXIT_CRITICAL();
+                    taskEXIT_CRITICAL();
+                    return pdPASS;
+                }
+                else
+                {
+                    if( xTicksToWait == ( TickType_t ) 0 )
+                    {
+                        /* The queue was full and no block time is specified (or
+                         * the block time has expired) so leave now. */
+                        taskEXIT_CRITICAL();
+                        traceQUEUE_SEND_FAILED( pxQueue );
+                        return errQUEUE_FULL;
+                    }
+                    else if( xEntryTimeSet == pdFALSE )
+                    {
+                        /* The queue was full and a block time was specified so
+                         * configure the timeout structure. */
+                        vTaskInternalSetTimeOutState( &xTimeOut );
+                        xEntryTimeSet = pdTRUE;
+                    }
+                    else
+                    {
+                        /* Entry time was already set. */
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+            }
+            taskEXIT_CRITICAL();
 
-    return uxReturn;
-} /*lint !e818 Pointer cannot be declared const as xQueue is a typedef not pointer. */
-/*-----------------------------------------------------------*/
+            /* Block in the same way as xQueueGenericSend(), so the task is
+             * unblocked by vQueueReleaseSlot() in priority order. */
+            vTaskSuspendAll();
+            prvLockQueue( pxQueue );
 
-UBaseType_t uxQueueMessagesWaitingFromISR( const QueueHandle_t xQueue )
-{
-    UBaseType_t uxReturn;
-    Queue_t * const pxQueue = xQueue;
+            if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+            {
+                if( prvIsQueueFull( pxQueue ) != pdFALSE )
+                {
+                    traceBLOCKING_ON_QUEUE_SEND( pxQueue );
+                    vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToSend ), xTicksToWait );
+                    prvUnlockQueue( pxQueue );
 
-    configASSERT( pxQueue );
-    uxReturn = pxQueue->uxMessagesWaiting;
+                    if( xTaskResumeAll() == pdFALSE )
+                    {
+                        portYIELD_WITHIN_API();
+                    }
+                }
+                else
+                {
+                    /* Try again. */
+                    prvUnlockQueue( pxQueue );
+                    ( void ) xTaskResumeAll();
+                }
+            }
+            else
+            {
+                /* The timeout has expired. */
+                prvUnlockQueue( pxQueue );
+                ( void ) xTaskResumeAll();
 
-    return uxReturn;
-} /*lint !e818 Pointer cannot be declared const as xQueue is a typedef not pointer. */
+                traceQUEUE_SEND_FAILED( pxQueue );
+                return errQUEUE_FULL;
+            }
+        } /*lint -restore */
+    }
+
+#endif /* configUSE_QUEUE_ZERO_COPY */
 /*-----------------------------------------------------------*/
 
-void vQueueDelete( QueueHandle_t xQueue )
-{
-    Queue_t * const pxQueue = xQueue;
+#if ( configUSE_QUEUE_ZERO_COPY == 1 )
 
-    configASSERT( pxQueue );
-    traceQUEUE_DELETE( pxQueue );
+    BaseType_t xQueueAcquireSlotFromISR( QueueHandle_t xQueue,
+                                         void ** const ppvSlot )
+    {
+        BaseType_t xReturn;
+        UBaseType_t uxSavedInterruptStatus;
+        Queue_t * const pxQueue = xQueue;
 
-    #if ( configQUEUE_REGISTRY_SIZE > 0 )
-        {
-            vQueueUnregisterQueue( pxQueue );
-        }
-    #endif
+        configASSERT( pxQueue );
+        configASSERT( ppvSlot );
+        configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
 
-    #if ( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 0 ) )
-        {
-            /* The queue can only have been allocated dynamically - free it
-             * again. */
-            vPortFree( pxQueue );
-        }
-    #elif ( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 1 ) )
+        /* See the comment in xQueueGenericSendFromISR(). */
+        portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
+
+        uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
         {
-            /* The queue could have been allocated statically or dynamically, so
-             * check before attempting to free the memory. */
-            if( pxQueue->ucStaticallyAllocated == ( uint8_t ) pdFALSE )
+            configASSERT( ( pxQueue->ucZeroCopySlots & queueSLOT_ACQUIRED ) == 0U );
+
+            if( pxQueue->uxMessagesWaiting < pxQueue->uxLength )
             {
-                vPortFree( pxQueue );
+                *ppvSlot = ( void * ) pxQueue->pcWriteTo;
+                pxQueue->ucZeroCopySlots |= queueSLOT_ACQUIRED;
+                xReturn = pdPASS;
             }
             else
             {
-                mtCOVERAGE_TEST_MARKER();
+                traceQUEUE_SEND_FROM_ISR_FAILED( pxQueue );
+                xReturn = errQUEUE_FULL;
             }
         }
-    #else /* if ( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 0 ) ) */
-        {
-            /* The queue must have been statically allocated, so is not going to be
-             * deleted.  Avoid compiler warnings about the unused parameter. */
-            ( void ) pxQueue;
-        }
-    #endif /* configSUPPORT_DYNAMIC_ALLOCATION */
-}
-/*-----------------------------------------------------------*/
-
-#if ( configUSE_TRACE_FACILITY == 1 )
+        portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
 
-    UBaseType_t uxQueueGetQueueNumber( QueueHandle_t xQueue )
-    {
-        return ( ( Queue_t * ) xQueue )->uxQueueNumber;
+        return xReturn;
     }
 
-#endif /* configUSE_TRACE_FACILITY */
+#endif /* configUSE_QUEUE_ZERO_COPY */
 /*-----------------------------------------------------------*/
 
-#if ( configUSE_TRACE_FACILITY == 1 )
+#if ( configUSE_QUEUE_ZERO_COPY == 1 )
 
-    void vQueueSetQueueNumber( QueueHandle_t xQueue,
-                               UBaseType_t uxQueueNumber )
+    void vQueueCommitSlot( QueueHandle_t xQueue )
     {
-        ( ( Queue_t * ) xQueue )->uxQueueNumber = uxQueueNumber;
-    }
+        Queue_t * const pxQueue = xQueue;
 
-#endif /* configUSE_TRACE_FACILITY */
-/*-----------------------------------------------------------*/
+        configASSERT( pxQueue );
 
-#if ( configUSE_TRACE_FACILITY == 1 )
+        taskENTER_CRITICAL();
+        {
+            traceQUEUE_SEND( pxQueue );
+            prvCommitSlot( pxQueue );
 
-    uint8_t ucQueueGetQueueType( QueueHandle_t xQueue )
-    {
-        return ( ( Queue_t * ) xQueue )->ucQueueType;
+            #if ( configUSE_QUEUE_SETS == 1 )
+                {
+                    if( pxQueue->pxQueueSetContainer != NULL )
+                    {
+                        if( prvNotifyQueueSetContainer( pxQueue ) != pdFALSE )
+                        {
+                            /* The queue is a member of a queue set, and posting
+                             * to the queue set caused a higher priority task to
+                             * unblock. A context switch is required. */
+                            queueYIELD_IF_USING_PREEMPTION();
+                        }
+                        else
+                        {
+                            mtCOVERAGE_TEST_MARKER();
+                        }
+                    }
+                    else if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE )
+                    {
+                        if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE )
+                        {
+                            queueYIELD_IF_USING_PREEMPTION();
+                        }
+                        else
+                        {
+                            mtCOVERAGE_TEST_MARKER();
+                        }
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+            #else /* configUSE_QUEUE_SETS */
+                {
+                    /* If there was a task waiting for data to arrive on the
+                     * queue then unblock it now. */
+                    if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE )
+                    {
+                        if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE )
+                        {
+                            queueYIELD_IF_USING_PREEMPTION();
+                        }
+                        else
+                        {
+                            mtCOVERAGE_TEST_MARKER();
+                        }
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+            #endif /* configUSE_QUEUE_SETS */
+        }
+        taskEXIT_CRITICAL();
     }
 
-#endif /* configUSE_TRACE_FACILITY */
+#endif /* configUSE_QUEUE_ZERO_COPY */
 /*-----------------------------------------------------------*/
 
-#if ( configUSE_MUTEXES == 1 )
+#if ( configUSE_QUEUE_ZERO_COPY == 1 )
 
-    static UBaseType_t prvGetDisinheritPriorityAfterTimeout( const Queue_t * const pxQueue )
+    void vQueueCommitSlotFromISR( QueueHandle_t xQueue,
+                                  BaseType_t * const pxHigherPriorityTaskWoken )
     {
-        UBaseType_t uxHighestPriorityOfWaitingTasks;
-
-        /* If a task waiting for a mutex causes the mutex holder to inherit a
-         * priority, but the waiting task times out, then the holder should
-         * disinherit the priority - but only down to the highest priority of any
-         * other tasks that are waiting for the same mutex.  For this purpose,
-         * return the priority of the highest priority task that is waiting for the
-         * mutex. */
-        if( listCURRENT_LIST_LENGTH( &( pxQueue->xTasksWaitingToReceive ) ) > 0U )
-        {
-            uxHighestPriorityOfWaitingTasks = ( UBaseType_t ) configMAX_PRIORITIES - ( UBaseType_t ) listGET_ITEM_VALUE_OF_HEAD_ENTRY( &( pxQueue->xTasksWaitingToReceive ) );
-        }
-        else
-        {
-            uxHighestPriorityOfWaitingTasks = tskIDLE_PRIORITY;
-        }
-
-        return uxHighestPriorityOfWaitingTasks;
-    }
+        UBaseType_t uxSavedInterruptStatus;
+        Queue_t * const pxQueue = xQueue;
 
-#endif /* configUSE_MUTEXES */
-/*-----------------------------------------------------------*/
+        configASSERT( pxQueue );
 
-static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue,
-                                      const void * pvItemToQueue,
-                                      const BaseType_t xPosition )
-{
-    BaseType_t xReturn = pdFALSE;
-    UBaseType_t uxMessagesWaiting;
+        /* See the comment in xQueueGenericSendFromISR(). */
+        portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
 
-    /* This function is called from a critical section. */
+        uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+        {
+            const int8_t cTxLock = pxQueue->cTxLock;
 
-    uxMessagesWaiting = pxQueue->uxMessagesWaiting;
+            traceQUEUE_SEND_FROM_ISR( pxQueue );
+            prvCommitSlot( pxQueue );
 
-    if( pxQueue->uxItemSize == ( UBaseType_t ) 0 )
-    {
-        #if ( configUSE_MUTEXES == 1 )
+            /* The event list is not altered if the queue is locked.  This will
+             * be done when the queue is unlocked later. */
+            if( cTxLock == queueUNLOCKED )
             {
-                if( pxQueue->uxQueueType == queueQUEUE_IS_MUTEX )
-                {
-                    /* The mutex is no longer being held. */
-                    xReturn = xTaskPriorityDisinherit( pxQueue->u.xSemaphore.xMutexHolder );
-                    pxQueue->u.xSemaphore.xMutexHolder = NULL;
-                }
-                else
-                {
-                    mtCOVERAGE_TEST_MARKER();
+                #if ( configUSE_QUEUE_SETS == 1 )
+                    {
+                        if( pxQueue->pxQueueSetContainer != NULL )
+                        {
+                            if( ( prvNotifyQueueSetContainer( pxQueue ) != pdFALSE ) && ( pxHigherPriorityTaskWoken != NULL ) )
+                            {
+                                *pxHigherPriorityTaskWoken = pdTRUE;
+                            }
+                            else
+                            {
+                                mtCOVERAGE_TEST_MARKER();
+                            }
+                        }
+                        else if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE )
+                        {
+                            if( ( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE ) && ( pxHigherPriorityTaskWoken != NULL ) )
+                            {
+                                *pxHigherPriorityTaskWoken = pdTRUE;
+                            }
+                            else
+                            {
+                                mtCOVERAGE_TEST_MARKER();
+                            }
+                        }
+                        else
+                        {
+                            mtCOVERAGE_TEST_MARKER();
+                        }
+                    }
+                #else /* configUSE_QUEUE_SETS */
+                    {
+                        if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE )
+                        {
+                            if( ( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE ) && ( pxHigherPriorityTaskWoken != NULL ) )
+                            {
+                                /* The task waiting has a higher priority so
+                                 * record that a context switch is required. */
+                                *pxHigherPriorityTaskWoken = pdTRUE;
+                            }
+                            else
+                            {
+                                mtCOVERAGE_TEST_MARKER();
+                            }
+                        }
+                        else
+                        {
+                            mtCOVERAGE_TEST_MARKER();
+                        }
+                    }
+                #endif /* configUSE_QUEUE_SETS */
+            }
+            else
+            {
+                /* Increment the lock count so the task that unlocks the queue
+                 * knows that data was posted while it was locked. */
+                configASSERT( cTxLock != queueINT8_MAX );
+
+                pxQueue->cTxLock = ( int8_t ) ( cTxLock + 1 );
+            }
+        }
+        portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+    }
+
+#endif /* configUSE_QUEUE_ZERO_COPY */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_QUEUE_ZERO_COPY == 1 )
+
+    BaseType_t xQueueBorrowSlot( QueueHandle_t xQueue,
+                                 void ** const ppvSlot,
+                                 TickType_t xTicksToWait )
+    {
+        BaseType_t xEntryTimeSet = pdFALSE;
+        TimeOut_t xTimeOut;
+        Queue_t * const pxQueue = xQueue;
+
+        configASSERT( pxQueue );
+        configASSERT( ppvSlot );
+        configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U ); /* Semaphores have no storage. */
+        #if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+            {
+                configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+            }
+        #endif
+
+        /*lint -save -e904  This function relaxes the coding standard somewhat to
+         * allow return statements within the function itself.  This is done in the
+         * interest of execution time efficiency. */
+        for( ; ; )
+        {
+            taskENTER_CRITICAL();
+            {
+                /* Only one slot can be borrowed at a time, so every item counted
+                 * in uxMessagesWaiting is still to be read. */
+                configASSERT( ( pxQueue->ucZeroCopySlots & queueSLOT_BORROWED ) == 0U );
+
+                if( pxQueue->uxMessagesWaiting > ( UBaseType_t ) 0 )
+                {
+                    /* Move the read position on as prvCopyDataFromQueue() would,
+                     * but leave the item counted until the slot is released so
+                     * it cannot be overwritten while it is being read. */
+                    pxQueue->u.xQueue.pcReadFrom += pxQueue->uxItemSize; /*lint !e9016 Pointer arithmetic on char types ok, especially in this use case where it is the clearest way of conveying intent. */
+
+                    if( pxQueue->u.xQueue.pcReadFrom >= pxQueue->u.xQueue.pcTail ) /*lint !e946 MISRA exception justified as use of the relational operator is the cleanest solutions. */
+                    {
+                        pxQueue->u.xQueue.pcReadFrom = pxQueue->pcHead;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+
+                    *ppvSlot = ( void * ) pxQueue->u.xQueue.pcReadFrom;
+                    pxQueue->ucZeroCopySlots |= queueSLOT_BORROWED;
+                    traceQUEUE_RECEIVE( pxQueue );
+
+                    taskEXIT_CRITICAL();
+                    return pdPASS;
+                }
+                else
+                {
+                    if( xTicksToWait == ( TickType_t ) 0 )
+                    {
+                        /* The queue was empty and no block time is specified (or
+                         * the block time has expired) so leave now. */
+                        taskEXIT_CRITICAL();
+                        traceQUEUE_RECEIVE_FAILED( pxQueue );
+                        return errQUEUE_EMPTY;
+                    }
+                    else if( xEntryTimeSet == pdFALSE )
+                    {
+                        /* The queue was empty and a block time was specified so
+                         * configure the timeout structure. */
+                        vTaskInternalSetTimeOutState( &xTimeOut );
+                        xEntryTimeSet = pdTRUE;
+                    }
+                    else
+                    {
+                        /* Entry time was already set. */
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+            }
+            taskEXIT_CRITICAL();
+
+            /* Block in the same way as xQueueReceive(), so the task is
+             * unblocked by vQueueCommitSlot() in priority order. */
+            vTaskSuspendAll();
+            prvLockQueue( pxQueue );
+
+            if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+            {
+                if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+                {
+                    traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue );
+                    vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait );
+                    prvUnlockQueue( pxQueue );
+
+                    if( xTaskResumeAll() == pdFALSE )
+                    {
+                        portYIELD_WITHIN_API();
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+                else
+                {
+                    /* The queue contains data again.  Loop back to try and
+                     * borrow it. */
+                    prvUnlockQueue( pxQueue );
+                    ( void ) xTaskResumeAll();
+                }
+            }
+            else
+            {
+                /* Timed out.  If there is no data in the queue exit, otherwise
+                 * loop back and attempt to borrow the data. */
+                prvUnlockQueue( pxQueue );
+                ( void ) xTaskResumeAll();
+
+                if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+                {
+                    traceQUEUE_RECEIVE_FAILED( pxQueue );
+                    return errQUEUE_EMPTY;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+        } /*lint -restore */
+    }
+
+#endif /* configUSE_QUEUE_ZERO_COPY */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_QUEUE_ZERO_COPY == 1 )
+
+    void vQueueReleaseSlot( QueueHandle_t xQueue )
+    {
+        Queue_t * const pxQueue = xQueue;
+
+        configASSERT( pxQueue );
+
+        taskENTER_CRITICAL();
+        {
+            configASSERT( ( pxQueue->ucZeroCopySlots & queueSLOT_BORROWED ) != 0U );
+
+            pxQueue->ucZeroCopySlots &= ( uint8_t ) ~queueSLOT_BORROWED;
+            pxQueue->uxMessagesWaiting--;
+
+            /* There is now space in the queue, were any tasks waiting to
+             * acquire a slot?  If so, unblock the highest priority waiting
+             * task. */
+            if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToSend ) ) == pdFALSE )
+            {
+                if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToSend ) ) != pdFALSE )
+                {
+                    queueYIELD_IF_USING_PREEMPTION();
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+
+#endif /* configUSE_QUEUE_ZERO_COPY */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_QUEUE_ZERO_COPY == 1 )
+
+    static void prvCommitSlot( Queue_t * const pxQueue )
+    {
+        /* The slot is the one pcWriteTo points to, so commit it in the same
+         * way prvCopyDataToQueue() adds an item to the back of the queue, but
+         * without the copy. */
+        configASSERT( ( pxQueue->ucZeroCopySlots & queueSLOT_ACQUIRED ) != 0U );
+
+        pxQueue->ucZeroCopySlots &= ( uint8_t ) ~queueSLOT_ACQUIRED;
+        pxQueue->pcWriteTo += pxQueue->uxItemSize; /*lint !e9016 Pointer arithmetic on char types ok, especially in this use case where it is the clearest way of conveying intent. */
+
+        if( pxQueue->pcWriteTo >= pxQueue->u.xQueue.pcTail ) /*lint !e946 MISRA exception justified as comparison of pointers is the cleanest solution. */
+        {
+            pxQueue->pcWriteTo = pxQueue->pcHead;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        pxQueue->uxMessagesWaiting++;
+    }
+
+#endif /* configUSE_QUEUE_ZERO_COPY */
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueSendMultiple( QueueHandle_t xQueue,
+                               const void * const pvItemsToQueue,
+                               UBaseType_t uxItemCount,
+                               TickType_t xTicksToWait )
+{
+    BaseType_t xEntryTimeSet = pdFALSE;
+    TimeOut_t xTimeOut;
+    UBaseType_t uxItemsToSend;
+    Queue_t * const pxQueue = xQueue;
+
+    configASSERT( pxQueue );
+    queueASSERT_NO_ZERO_COPY_SLOTS( pxQueue );
+    configASSERT( pvItemsToQueue );
+    configASSERT( uxItemCount > ( UBaseType_t ) 0U ); /* A return of 0 means the queue stayed full. */
+    configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U ); /* Semaphores are given one at a time. */
+    #if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+        {
+            configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+        }
+    #endif
+
+    /*lint -save -e904 This function relaxes the coding standard somewhat to
+     * allow return statements within the function itself.  This is done in the
+     * interest of execution time efficiency. */
+    for( ; ; )
+    {
+        taskENTER_CRITICAL();
+        {
+            /* Send as many of the items as there is room for.  The task only
+             * blocks if there is no room for any of them. */
+            uxItemsToSend = pxQueue->uxLength - pxQueue->uxMessagesWaiting;
+
+            if( uxItemsToSend > ( UBaseType_t ) 0 )
+            {
+                if( uxItemsToSend > uxItemCount )
+                {
+                    uxItemsToSend = uxItemCount;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                traceQUEUE_SEND( pxQueue );
+                prvCopyItemsToQueue( pxQueue, ( const int8_t * ) pvItemsToQueue, uxItemsToSend );
+
+                /* One task waiting to receive can be unblocked for each item
+                 * sent, but at most one yield is needed. */
+                if( prvNotifyItemsSent( pxQueue, uxItemsToSend ) != pdFALSE )
+                {
+                    queueYIELD_IF_USING_PREEMPTION();
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                taskEXIT_CRITICAL();
+                return ( BaseType_t ) uxItemsToSend;
+            }
+            else
+            {
+                if( xTicksToWait == ( TickType_t ) 0 )
+                {
+                    /* The queue was full and no block time is specified (or
+                     * the block time has expired) so leave now. */
+                    taskEXIT_CRITICAL();
+                    traceQUEUE_SEND_FAILED( pxQueue );
+                    return 0;
+                }
+                else if( xEntryTimeSet == pdFALSE )
+                {
+                    /* The queue was full and a block time was specified so
+                     * configure the timeout structure. */
+                    vTaskInternalSetTimeOutState( &xTimeOut );
+                    xEntryTimeSet = pdTRUE;
+                }
+                else
+                {
+                    /* Entry time was already set. */
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        /* Block in the same way as xQueueGenericSend(). */
+        vTaskSuspendAll();
+        prvLockQueue( pxQueue );
+
+        if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+        {
+            if( prvIsQueueFull( pxQueue ) != pdFALSE )
+            {
+                traceBLOCKING_ON_QUEUE_SEND( pxQueue );
+                vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToSend ), xTicksToWait );
+                prvUnlockQueue( pxQueue );
+
+                if( xTaskResumeAll() == pdFALSE )
+                {
+                    portYIELD_WITHIN_API();
+                }
+            }
+            else
+            {
+                /* Try again. */
+                prvUnlockQueue( pxQueue );
+                ( void ) xTaskResumeAll();
+            }
+        }
+        else
+        {
+            /* The timeout has expired. */
+            prvUnlockQueue( pxQueue );
+            ( void ) xTaskResumeAll();
+
+            traceQUEUE_SEND_FAILED( pxQueue );
+            return 0;
+        }
+    } /*lint -restore */
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueSendMultipleFromISR( QueueHandle_t xQueue,
+                                      const void * const pvItemsToQueue,
+                                      UBaseType_t uxItemCount,
+                                      BaseType_t * const pxHigherPriorityTaskWoken )
+{
+    UBaseType_t uxSavedInterruptStatus, uxItemsToSend;
+    Queue_t * const pxQueue = xQueue;
+
+    configASSERT( pxQueue );
+    queueASSERT_NO_ZERO_COPY_SLOTS( pxQueue );
+    configASSERT( pvItemsToQueue );
+    configASSERT( uxItemCount > ( UBaseType_t ) 0U );
+    configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+
+    /* See the comment in xQueueGenericSendFromISR(). */
+    portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
+
+    uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+    {
+        uxItemsToSend = pxQueue->uxLength - pxQueue->uxMessagesWaiting;
+
+        if( uxItemsToSend > uxItemCount )
+        {
+            uxItemsToSend = uxItemCount;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        if( uxItemsToSend > ( UBaseType_t ) 0 )
+        {
+            const int8_t cTxLock = pxQueue->cTxLock;
+
+            traceQUEUE_SEND_FROM_ISR( pxQueue );
+            prvCopyItemsToQueue( pxQueue, ( const int8_t * ) pvItemsToQueue, uxItemsToSend );
+
+            /* The event list is not altered if the queue is locked.  This will
+             * be done when the queue is unlocked later. */
+            if( cTxLock == queueUNLOCKED )
+            {
+                if( ( prvNotifyItemsSent( pxQueue, uxItemsToSend ) != pdFALSE ) && ( pxHigherPriorityTaskWoken != NULL ) )
+                {
+                    *pxHigherPriorityTaskWoken = pdTRUE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                /* Add the number of items to the lock count so the task that
+                 * unlocks the queue knows how many tasks may need to be
+                 * unblocked. */
+                pxQueue->cTxLock = prvAddToLockCount( cTxLock, uxItemsToSend );
+            }
+        }
+        else
+        {
+            traceQUEUE_SEND_FROM_ISR_FAILED( pxQueue );
+        }
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+    return ( BaseType_t ) uxItemsToSend;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueReceiveMultiple( QueueHandle_t xQueue,
+                                  void * const pvBuffer,
+                                  UBaseType_t uxMaxItems,
+                                  TickType_t xTicksToWait )
+{
+    BaseType_t xEntryTimeSet = pdFALSE;
+    TimeOut_t xTimeOut;
+    UBaseType_t uxItemsToReceive;
+    Queue_t * const pxQueue = xQueue;
+
+    configASSERT( pxQueue );
+    queueASSERT_NO_ZERO_COPY_SLOTS( pxQueue );
+    configASSERT( pvBuffer );
+    configASSERT( uxMaxItems > ( UBaseType_t ) 0U ); /* A return of 0 means the queue stayed empty. */
+    configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U ); /* Semaphores are taken one at a time. */
+    #if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+        {
+            configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+        }
+    #endif
+
+    /*lint -save -e904  This function relaxes the coding standard somewhat to
+     * allow return statements within the function itself.  This is done in the
+     * interest of execution time efficiency. */
+    for( ; ; )
+    {
+        taskENTER_CRITICAL();
+        {
+            /* Receive as many items as are available, up to uxMaxItems.  The
+             * task only blocks if there are none. */
+            uxItemsToReceive = pxQueue->uxMessagesWaiting;
+
+            if( uxItemsToReceive > ( UBaseType_t ) 0 )
+            {
+                if( uxItemsToReceive > uxMaxItems )
+                {
+                    uxItemsToReceive = uxMaxItems;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                prvCopyItemsFromQueue( pxQueue, ( int8_t * ) pvBuffer, uxItemsToReceive );
+                traceQUEUE_RECEIVE( pxQueue );
+
+                /* One task waiting to send can be unblocked for each item
+                 * removed, but at most one yield is needed. */
+                if( prvUnblockTasks( &( pxQueue->xTasksWaitingToSend ), uxItemsToReceive ) != pdFALSE )
+                {
+                    queueYIELD_IF_USING_PREEMPTION();
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                taskEXIT_CRITICAL();
+                return ( BaseType_t ) uxItemsToReceive;
+            }
+            else
+            {
+                if( xTicksToWait == ( TickType_t ) 0 )
+                {
+                    /* The queue was empty and no block time is specified (or
+                     * the block time has expired) so leave now. */
+                    taskEXIT_CRITICAL();
+                    traceQUEUE_RECEIVE_FAILED( pxQueue );
+                    return 0;
+                }
+                else if( xEntryTimeSet == pdFALSE )
+                {
+                    /* The queue was empty and a block time was specified so
+                     * configure the timeout structure. */
+                    vTaskInternalSetTimeOutState( &xTimeOut );
+                    xEntryTimeSet = pdTRUE;
+                }
+                else
+                {
+                    /* Entry time was already set. */
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        /* Block in the same way as xQueueReceive(). */
+        vTaskSuspendAll();
+        prvLockQueue( pxQueue );
+
+        if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+        {
+            if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+            {
+                traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue );
+                vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait );
+                prvUnlockQueue( pxQueue );
+
+                if( xTaskResumeAll() == pdFALSE )
+                {
+                    portYIELD_WITHIN_API();
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                /* The queue contains data again.  Loop back to try and read the
+                 * data. */
+                prvUnlockQueue( pxQueue );
+                ( void ) xTaskResumeAll();
+            }
+        }
+        else
+        {
+            /* Timed out.  If there is no data in the queue exit, otherwise loop
+             * back and attempt to read the data. */
+            prvUnlockQueue( pxQueue );
+            ( void ) xTaskResumeAll();
+
+            if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+            {
+                traceQUEUE_RECEIVE_FAILED( pxQueue );
+                return 0;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+    } /*lint -restore */
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueueReceiveMultipleFromISR( QueueHandle_t xQueue,
+                                         void * const pvBuffer,
+                                         UBaseType_t uxMaxItems,
+                                         BaseType_t * const pxHigherPriorityTaskWoken )
+{
+    UBaseType_t uxSavedInterruptStatus, uxItemsToReceive;
+    Queue_t * const pxQueue = xQueue;
+
+    configASSERT( pxQueue );
+    queueASSERT_NO_ZERO_COPY_SLOTS( pxQueue );
+    configASSERT( pvBuffer );
+    configASSERT( uxMaxItems > ( UBaseType_t ) 0U );
+    configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+
+    /* See the comment in xQueueGenericSendFromISR(). */
+    portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
+
+    uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+    {
+        uxItemsToReceive = pxQueue->uxMessagesWaiting;
+
+        if( uxItemsToReceive > uxMaxItems )
+        {
+            uxItemsToReceive = uxMaxItems;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        if( uxItemsToReceive > ( UBaseType_t ) 0 )
+        {
+            const int8_t cRxLock = pxQueue->cRxLock;
+
+            traceQUEUE_RECEIVE_FROM_ISR( pxQueue );
+            prvCopyItemsFromQueue( pxQueue, ( int8_t * ) pvBuffer, uxItemsToReceive );
+
+            /* If the queue is locked the event list will not be modified.
+             * Instead update the lock count so the task that unlocks the queue
+             * will know that ISRs have removed data while the queue was
+             * locked. */
+            if( cRxLock == queueUNLOCKED )
+            {
+                if( ( prvUnblockTasks( &( pxQueue->xTasksWaitingToSend ), uxItemsToReceive ) != pdFALSE ) && ( pxHigherPriorityTaskWoken != NULL ) )
+                {
+                    *pxHigherPriorityTaskWoken = pdTRUE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                pxQueue->cRxLock = prvAddToLockCount( cRxLock, uxItemsToReceive );
+            }
+        }
+        else
+        {
+            traceQUEUE_RECEIVE_FROM_ISR_FAILED( pxQueue );
+        }
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+    return ( BaseType_t ) uxItemsToReceive;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xQueue )
+{
+    UBaseType_t uxReturn;
+
+    configASSERT( xQueue );
+
+    taskENTER_CRITICAL();
+    {
+        uxReturn = ( ( Queue_t * ) xQueue )->uxMessagesWaiting;
+    }
+    taskEXIT_CRITICAL();
+
+    return uxReturn;
+} /*lint !e818 Pointer cannot be declared const as xQueue is a typedef not pointer. */
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueSpacesAvailable( const QueueHandle_t xQueue )
+{
+    UBaseType_t uxReturn;
+    Queue_t * const pxQueue = xQueue;
+
+    configASSERT( pxQueue );
+
+    taskENTER_CRITICAL();
+    {
+        uxReturn = pxQueue->uxLength - pxQueue->uxMessagesWaiting;
+    }
+    taskEXIT_CRITICAL();
+
+    return uxReturn;
+} /*lint !e818 Pointer cannot be declared const as xQueue is a typedef not pointer. */
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueMessagesWaitingFromISR( const QueueHandle_t xQueue )
+{
+    UBaseType_t uxReturn;
+    Queue_t * const pxQueue = xQueue;
+
+    configASSERT( pxQueue );
+    uxReturn = pxQueue->uxMessagesWaiting;
+
+    return uxReturn;
+} /*lint !e818 Pointer cannot be declared const as xQueue is a typedef not pointer. */
+/*-----------------------------------------------------------*/
+
+void vQueueDelete( QueueHandle_t xQueue )
+{
+    Queue_t * const pxQueue = xQueue;
+
+    configASSERT( pxQueue );
+    traceQUEUE_DELETE( pxQueue );
+
+    #if ( configQUEUE_REGISTRY_SIZE > 0 )
+        {
+            vQueueUnregisterQueue( pxQueue );
+        }
+    #endif
+
+    #if ( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 0 ) )
+        {
+            /* The queue can only have been allocated dynamically - free it
+             * again. */
+            vPortFree( pxQueue );
+        }
+    #elif ( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 1 ) )
+        {
+            /* The queue could have been allocated statically or dynamically, so
+             * check before attempting to free the memory. */
+            if( pxQueue->ucStaticallyAllocated == ( uint8_t ) pdFALSE )
+            {
+                vPortFree( pxQueue );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+    #else /* if ( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 0 ) ) */
+        {
+            /* The queue must have been statically allocated, so is not going to be
+             * deleted.  Avoid compiler warnings about the unused parameter. */
+            ( void ) pxQueue;
+        }
+    #endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+}
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TRACE_FACILITY == 1 )
+
+    UBaseType_t uxQueueGetQueueNumber( QueueHandle_t xQueue )
+    {
+        return ( ( Queue_t * ) xQueue )->uxQueueNumber;
+    }
+
+#endif /* configUSE_TRACE_FACILITY */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TRACE_FACILITY == 1 )
+
+    void vQueueSetQueueNumber( QueueHandle_t xQueue,
+                               UBaseType_t uxQueueNumber )
+    {
+        ( ( Queue_t * ) xQueue )->uxQueueNumber = uxQueueNumber;
+    }
+
+#endif /* configUSE_TRACE_FACILITY */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TRACE_FACILITY == 1 )
+
+    uint8_t ucQueueGetQueueType( QueueHandle_t xQueue )
+    {
+        return ( ( Queue_t * ) xQueue )->ucQueueType;
+    }
+
+#endif /* configUSE_TRACE_FACILITY */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_MUTEXES == 1 )
+
+    static UBaseType_t prvGetDisinheritPriorityAfterTimeout( const Queue_t * const pxQueue )
+    {
+        UBaseType_t uxHighestPriorityOfWaitingTasks;
+
+        /* If a task waiting for a mutex causes the mutex holder to inherit a
+         * priority, but the waiting task times out, then the holder should
+         * disinherit the priority - but only down to the highest priority of any
+         * other tasks that are waiting for the same mutex.  For this purpose,
+         * return the priority of the highest priority task that is waiting for the
+         * mutex. */
+        if( listCURRENT_LIST_LENGTH( &( pxQueue->xTasksWaitingToReceive ) ) > 0U )
+        {
+            uxHighestPriorityOfWaitingTasks = ( UBaseType_t ) configMAX_PRIORITIES - ( UBaseType_t ) listGET_ITEM_VALUE_OF_HEAD_ENTRY( &( pxQueue->xTasksWaitingToReceive ) );
+        }
+        else
+        {
+            uxHighestPriorityOfWaitingTasks = tskIDLE_PRIORITY;
+        }
+
+        return uxHighestPriorityOfWaitingTasks;
+    }
+
+#endif /* configUSE_MUTEXES */
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue,
+                                      const void * pvItemToQueue,
+                                      const BaseType_t xPosition )
+{
+    BaseType_t xReturn = pdFALSE;
+    UBaseType_t uxMessagesWaiting;
+
+    /* This function is called from a critical section. */
+
+    uxMessagesWaiting = pxQueue->uxMessagesWaiting;
+
+    if( pxQueue->uxItemSize == ( UBaseType_t ) 0 )
+    {
+        #if ( configUSE_MUTEXES == 1 )
+            {
+                if( pxQueue->uxQueueType == queueQUEUE_IS_MUTEX )
+                {
+                    /* The mutex is no longer being held. */
+                    xReturn = xTaskPriorityDisinherit( pxQueue->u.xSemaphore.xMutexHolder );
+                    pxQueue->u.xSemaphore.xMutexHolder = NULL;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
                 }
             }
         #endif /* configUSE_MUTEXES */
@@ -2227,6 +3201,167 @@ static void prvCopyDataFromQueue( Queue_t * const pxQueue,
 }
 /*-----------------------------------------------------------*/
 
+static void prvCopyItemsToQueue( Queue_t * const pxQueue,
+                                 const int8_t * pcItems,
+                                 const UBaseType_t uxItemCount )
+{
+    const size_t xBytes = ( size_t ) uxItemCount * ( size_t ) pxQueue->uxItemSize;
+    const size_t xBytesToTail = ( size_t ) ( pxQueue->u.xQueue.pcTail - pxQueue->pcWriteTo ); /*lint !e946 !e9016 Pointer arithmetic on char types ok. */
+
+    /* The items are copied in at most two blocks - up to the end of the
+     * storage area, then from its start. */
+    if( xBytes < xBytesToTail )
+    {
+        ( void ) memcpy( ( void * ) pxQueue->pcWriteTo, ( const void * ) pcItems, xBytes ); /*lint !e961 !e418 !e9087 MISRA exception as the casts are only redundant for some ports. */
+        pxQueue->pcWriteTo += xBytes;                                                      /*lint !e9016 Pointer arithmetic on char types ok, especially in this use case where it is the clearest way of conveying intent. */
+    }
+    else
+    {
+        ( void ) memcpy( ( void * ) pxQueue->pcWriteTo, ( const void * ) pcItems, xBytesToTail );                          /*lint !e961 !e418 !e9087 MISRA exception as the casts are only redundant for some ports. */
+        ( void ) memcpy( ( void * ) pxQueue->pcHead, ( const void * ) ( pcItems + xBytesToTail ), xBytes - xBytesToTail ); /*lint !e961 !e418 !e9087 MISRA exception as the casts are only redundant for some ports. */
+        pxQueue->pcWriteTo = pxQueue->pcHead + ( xBytes - xBytesToTail );                                                 /*lint !e9016 Pointer arithmetic on char types ok. */
+    }
+
+    pxQueue->uxMessagesWaiting += uxItemCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCopyItemsFromQueue( Queue_t * const pxQueue,
+                                   int8_t * pcBuffer,
+                                   const UBaseType_t uxItemCount )
+{
+    const size_t xBytes = ( size_t ) uxItemCount * ( size_t ) pxQueue->uxItemSize;
+    int8_t * pcReadFrom = pxQueue->u.xQueue.pcReadFrom + pxQueue->uxItemSize; /*lint !e9016 Pointer arithmetic on char types ok. */
+    size_t xBytesToTail;
+
+    if( uxItemCount > ( UBaseType_t ) 0 )
+    {
+        /* pcReadFrom points to the last item read, so the first item to read
+         * is the one after it. */
+        if( pcReadFrom >= pxQueue->u.xQueue.pcTail ) /*lint !e946 MISRA exception justified as use of the relational operator is the cleanest solutions. */
+        {
+            pcReadFrom = pxQueue->pcHead;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        xBytesToTail = ( size_t ) ( pxQueue->u.xQueue.pcTail - pcReadFrom ); /*lint !e946 !e9016 Pointer arithmetic on char types ok. */
+
+        /* The items are copied out in at most two blocks, and pcReadFrom is
+         * left pointing to the last of them. */
+        if( xBytes < xBytesToTail )
+        {
+            ( void ) memcpy( ( void * ) pcBuffer, ( const void * ) pcReadFrom, xBytes ); /*lint !e961 !e418 !e9087 MISRA exception as the casts are only redundant for some ports. */
+            pxQueue->u.xQueue.pcReadFrom = pcReadFrom + ( xBytes - pxQueue->uxItemSize ); /*lint !e9016 Pointer arithmetic on char types ok. */
+        }
+        else
+        {
+            ( void ) memcpy( ( void * ) pcBuffer, ( const void * ) pcReadFrom, xBytesToTail );                          /*lint !e961 !e418 !e9087 MISRA exception as the casts are only redundant for some ports. */
+            ( void ) memcpy( ( void * ) ( pcBuffer + xBytesToTail ), ( const void * ) pxQueue->pcHead, xBytes - xBytesToTail ); /*lint !e961 !e418 !e9087 MISRA exception as the casts are only redundant for some ports. */
+
+            if( xBytes == xBytesToTail )
+            {
+                pxQueue->u.xQueue.pcReadFrom = pxQueue->u.xQueue.pcTail - pxQueue->uxItemSize; /*lint !e9016 Pointer arithmetic on char types ok. */
+            }
+            else
+            {
+                pxQueue->u.xQueue.pcReadFrom = pxQueue->pcHead + ( ( xBytes - xBytesToTail ) - pxQueue->uxItemSize ); /*lint !e9016 Pointer arithmetic on char types ok. */
+            }
+        }
+
+        pxQueue->uxMessagesWaiting -= uxItemCount;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvUnblockTasks( List_t * const pxEventList,
+                                   UBaseType_t uxMaxTasks )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    while( ( uxMaxTasks > ( UBaseType_t ) 0 ) && ( listLIST_IS_EMPTY( pxEventList ) == pdFALSE ) )
+    {
+        if( xTaskRemoveFromEventList( pxEventList ) != pdFALSE )
+        {
+            xHigherPriorityTaskWoken = pdTRUE;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        uxMaxTasks--;
+    }
+
+    return xHigherPriorityTaskWoken;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvNotifyItemsSent( Queue_t * const pxQueue,
+                                      UBaseType_t uxItemCount )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    #if ( configUSE_QUEUE_SETS == 1 )
+        {
+            if( pxQueue->pxQueueSetContainer != NULL )
+            {
+                /* The queue set holds one entry for each item. */
+                while( uxItemCount > ( UBaseType_t ) 0 )
+                {
+                    if( prvNotifyQueueSetContainer( pxQueue ) != pdFALSE )
+                    {
+                        xHigherPriorityTaskWoken = pdTRUE;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+
+                    uxItemCount--;
+                }
+            }
+            else
+            {
+                xHigherPriorityTaskWoken = prvUnblockTasks( &( pxQueue->xTasksWaitingToReceive ), uxItemCount );
+            }
+        }
+    #else /* configUSE_QUEUE_SETS */
+        {
+            xHigherPriorityTaskWoken = prvUnblockTasks( &( pxQueue->xTasksWaitingToReceive ), uxItemCount );
+        }
+    #endif /* configUSE_QUEUE_SETS */
+
+    return xHigherPriorityTaskWoken;
+}
+/*-----------------------------------------------------------*/
+
+static int8_t prvAddToLockCount( const int8_t cLockCount,
+                                 const UBaseType_t uxItemCount )
+{
+    int8_t cReturn;
+
+    /* No more tasks can need unblocking than there are tasks, so saturating
+     * the count loses nothing in practice. */
+    if( uxItemCount >= ( UBaseType_t ) ( queueINT8_MAX - cLockCount ) )
+    {
+        cReturn = queueINT8_MAX;
+    }
+    else
+    {
+        cReturn = ( int8_t ) ( cLockCount + ( int8_t ) uxItemCount );
+    }
+
+    return cReturn;
+}
+/*-----------------------------------------------------------*/
+
 static void prvUnlockQueue( Queue_t * const pxQueue )
 {
     /* THIS FUNCTION MUST BE CALLED WITH THE SCHEDULER SUSPENDED. */
@@ -194,14 +194,59 @@
 
 /*-----------------------------------------------------------*/
 
+/* When configUSE_DELAYED_TASK_BUCKETS is 1 each delayed task list is a
+ * calendar queue rather than a single list sorted by wake time.  The tasks are
+ * spread over taskDELAYED_BUCKETS lists, selected by bits of the wake time, so
+ * each bucket covers 2^configDELAYED_TASK_BUCKET_WIDTH_BITS consecutive ticks
+ * and the buckets repeat every taskDELAYED_BUCKETS of those.  Each bucket is
+ * still sorted by wake time, so inserting a task only walks the tasks that
+ * share its bucket.  A bit is set in ulBucketsInUse for each bucket that may
+ * hold a task.  Tasks leave the Blocked state through uxListRemove() in many
+ * places, so a bit is only cleared when a search finds its bucket empty.
+ *
+ * Both representations are accessed through the taskDELAYED_LIST_ macros. */
+#if ( configUSE_DELAYED_TASK_BUCKETS == 1 )
+
+    #define taskDELAYED_BUCKETS               ( 1U << configDELAYED_TASK_BUCKET_BITS )
+    #define taskDELAYED_BUCKET_MASK           ( ( UBaseType_t ) ( taskDELAYED_BUCKETS - 1U ) )
+    #define taskDELAYED_BUCKETS_IN_USE_MASK   ( 0xffffffffUL >> ( 32U - taskDELAYED_BUCKETS ) )
+    #define taskDELAYED_BUCKET_INDEX( xTime ) ( ( UBaseType_t ) ( ( xTime ) >> configDELAYED_TASK_BUCKET_WIDTH_BITS ) & taskDELAYED_BUCKET_MASK )
+
+    typedef struct xDELAYED_TASK_LIST
+    {
+        List_t xBuckets[ taskDELAYED_BUCKETS ];
+        uint32_t ulBucketsInUse; /*< Bit n is set if xBuckets[ n ] may hold a task. */
+    } DelayedTaskList_t;
+
+    #define taskDELAYED_LIST_INITIALISE( pxList )                  prvDelayedListInitialise( pxList )
+    #define taskDELAYED_LIST_INSERT( pxList, pxNewListItem )       prvDelayedListInsert( ( pxList ), ( pxNewListItem ) )
+    #define taskDELAYED_LIST_IS_EMPTY( pxList )                    prvDelayedListIsEmpty( pxList )
+    #define taskDELAYED_LIST_HEAD_ENTRY( pxList )                  prvDelayedListGetHeadEntry( pxList )
+    #define taskDELAYED_LIST_CONTAINS_LIST( pxDelayedList, pxList ) \
+    ( ( ( pxList ) >= &( ( pxDelayedList )->xBuckets[ 0 ] ) ) && ( ( pxList ) < &( ( pxDelayedList )->xBuckets[ taskDELAYED_BUCKETS ] ) ) )
+
+#else /* if ( configUSE_DELAYED_TASK_BUCKETS == 1 ) */
+
+    typedef List_t DelayedTaskList_t;
+
+    #define taskDELAYED_LIST_INITIALISE( pxList )                  vListInitialise( pxList )
+    #define taskDELAYED_LIST_INSERT( pxList, pxNewListItem )       vListInsert( ( pxList ), ( pxNewListItem ) )
+    #define taskDELAYED_LIST_IS_EMPTY( pxList )                    listLIST_IS_EMPTY( pxList )
+    #define taskDELAYED_LIST_HEAD_ENTRY( pxList )                  listGET_HEAD_ENTRY( pxList )
+    #define taskDELAYED_LIST_CONTAINS_LIST( pxDelayedList, pxList ) ( ( pxList ) == ( pxDelayedList ) )
+
+#endif /* configUSE_DELAYED_TASK_BUCKETS */
+
+/*-----------------------------------------------------------*/
+
 /* pxDelayedTaskList and pxOverflowDelayedTaskList are switched when the tick
  * count overflows. */
 #define taskSWITCH_DELAYED_LISTS()                                                \
     {                                                                             \
-        List_t * pxTemp;                                                          \
+        DelayedTaskList_t * pxTemp;                                               \
                                                                                   \
         /* The delayed tasks list should be empty when the lists are switched. */ \
-        configASSERT( ( listLIST_IS_EMPTY( pxDelayedTaskList ) ) );               \
+        configASSERT( ( taskDELAYED_LIST_IS_EMPTY( pxDelayedTaskList ) ) );       \
                                                                                   \
         pxTemp = pxDelayedTaskList;                                               \
         pxDelayedTaskList = pxOverflowDelayedTaskList;                            \
@@ -342,10 +387,10 @@ PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB = NULL;
  * doing so breaks some kernel aware debuggers and debuggers that rely on removing
  * the static qualifier. */
 PRIVILEGED_DATA static List_t pxReadyTasksLists[ configMAX_PRIORITIES ]; /*< Prioritised ready tasks. */
-PRIVILEGED_DATA static List_t xDelayedTaskList1;                         /*< Delayed tasks. */
-PRIVILEGED_DATA static List_t xDelayedTaskList2;                         /*< Delayed tasks (two lists are used - one for delays that have overflowed the current tick count. */
-PRIVILEGED_DATA static List_t * volatile pxDelayedTaskList;              /*< Points to the delayed task list currently being used. */
-PRIVILEGED_DATA static List_t * volatile pxOverflowDelayedTaskList;      /*< Points to the delayed task list currently being used to hold tasks that have overflowed the current tick count. */
+PRIVILEGED_DATA static DelayedTaskList_t xDelayedTaskList1;                    /*< Delayed tasks. */
+PRIVILEGED_DATA static DelayedTaskList_t xDelayedTaskList2;                    /*< Delayed tasks (two lists are used - one for delays that have overflowed the current tick count. */
+PRIVILEGED_DATA static DelayedTaskList_t * volatile pxDelayedTaskList;         /*< Points to the delayed task list currently being used. */
+PRIVILEGED_DATA static DelayedTaskList_t * volatile pxOverflowDelayedTaskList; /*< Points to the delayed task list currently being used to hold tasks that have overflowed the current tick count. */
 PRIVILEGED_DATA static List_t xPendingReadyList;                         /*< Tasks that have been readied while the scheduler was suspended.  They will be moved to the ready list when the scheduler is resumed. */
 
 #if ( INCLUDE_vTaskDelete == 1 )
@@ -525,6 +570,27 @@ static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait,
  */
 static void prvResetNextTaskUnblockTime( void ) PRIVILEGED_FUNCTION;
 
+#if ( configUSE_DELAYED_TASK_BUCKETS == 1 )
+
+/*
+ * Delayed task list operations used when each delayed task list is a set of
+ * buckets.  prvDelayedListGetHeadEntry() returns the list item of the task
+ * with the earliest wake time, which must be at or after the current tick
+ * count, or NULL if the list is empty.
+ */
+    static void prvDelayedListInitialise( DelayedTaskList_t * const pxDelayedList ) PRIVILEGED_FUNCTION;
+    static void prvDelayedListInsert( DelayedTaskList_t * const pxDelayedList,
+                                      ListItem_t * const pxNewListItem ) PRIVILEGED_FUNCTION;
+    static BaseType_t prvDelayedListIsEmpty( DelayedTaskList_t * const pxDelayedList ) PRIVILEGED_FUNCTION;
+    static ListItem_t * prvDelayedListGetHeadEntry( DelayedTaskList_t * const pxDelayedList ) PRIVILEGED_FUNCTION;
+
+/*
+ * Returns the index of the lowest bit set in ulBits, which must not be zero.
+ */
+    static UBaseType_t prvDelayedListLowestBit( uint32_t ulBits ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_DELAYED_TASK_BUCKETS */
+
 #if ( ( configUSE_TRACE_FACILITY == 1 ) && ( configUSE_STATS_FORMATTING_FUNCTIONS > 0 ) )
 
 /*
@@ -1388,7 +1454,8 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
     eTaskState eTaskGetState( TaskHandle_t xTask )
     {
         eTaskState eReturn;
-        List_t const * pxStateList, * pxDelayedList, * pxOverflowedDelayedList;
+        List_t const * pxStateList;
+        DelayedTaskList_t const * pxDelayedList, * pxOverflowedDelayedList;
         const TCB_t * const pxTCB = xTask;
 
         configASSERT( pxTCB );
@@ -1408,7 +1475,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
             }
             taskEXIT_CRITICAL();
 
-            if( ( pxStateList == pxDelayedList ) || ( pxStateList == pxOverflowedDelayedList ) )
+            if( ( taskDELAYED_LIST_CONTAINS_LIST( pxDelayedList, pxStateList ) ) || ( taskDELAYED_LIST_CONTAINS_LIST( pxOverflowedDelayedList, pxStateList ) ) )
             {
                 /* The task being queried is referenced from one of the Blocked
                  * lists. */
@@ -2486,15 +2553,31 @@ char * pcTaskGetName( TaskHandle_t xTaskToQuery ) /*lint !e971 Unqualified char
             } while( uxQueue > ( UBaseType_t ) tskIDLE_PRIORITY ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
 
             /* Search the delayed lists. */
-            if( pxTCB == NULL )
-            {
-                pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxDelayedTaskList, pcNameToQuery );
-            }
+            #if ( configUSE_DELAYED_TASK_BUCKETS == 1 )
+                {
+                    for( uxQueue = 0; ( uxQueue < ( UBaseType_t ) taskDELAYED_BUCKETS ) && ( pxTCB == NULL ); uxQueue++ )
+                    {
+                        pxTCB = prvSearchForNameWithinSingleList( &( pxDelayedTaskList->xBuckets[ uxQueue ] ), pcNameToQuery );
+                    }
 
-            if( pxTCB == NULL )
-            {
-                pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxOverflowDelayedTaskList, pcNameToQuery );
-            }
+                    for( uxQueue = 0; ( uxQueue < ( UBaseType_t ) taskDELAYED_BUCKETS ) && ( pxTCB == NULL ); uxQueue++ )
+                    {
+                        pxTCB = prvSearchForNameWithinSingleList( &( pxOverflowDelayedTaskList->xBuckets[ uxQueue ] ), pcNameToQuery );
+                    }
+                }
+            #else /* if ( configUSE_DELAYED_TASK_BUCKETS == 1 ) */
+                {
+                    if( pxTCB == NULL )
+                    {
+                        pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxDelayedTaskList, pcNameToQuery );
+                    }
+
+                    if( pxTCB == NULL )
+                    {
+                        pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxOverflowDelayedTaskList, pcNameToQuery );
+                    }
+                }
+            #endif /* configUSE_DELAYED_TASK_BUCKETS */
 
             #if ( INCLUDE_vTaskSuspend == 1 )
                 {
@@ -2547,8 +2630,20 @@ char * pcTaskGetName( TaskHandle_t xTaskToQuery ) /*lint !e971 Unqualified char
 
                 /* Fill in an TaskStatus_t structure with information on each
                  * task in the Blocked state. */
-                uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxDelayedTaskList, eBlocked );
-                uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxOverflowDelayedTaskList, eBlocked );
+                #if ( configUSE_DELAYED_TASK_BUCKETS == 1 )
+                    {
+                        for( uxQueue = 0; uxQueue < ( UBaseType_t ) taskDELAYED_BUCKETS; uxQueue++ )
+                        {
+                            uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &( pxDelayedTaskList->xBuckets[ uxQueue ] ), eBlocked );
+                            uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &( pxOverflowDelayedTaskList->xBuckets[ uxQueue ] ), eBlocked );
+                        }
+                    }
+                #else
+                    {
+                        uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxDelayedTaskList, eBlocked );
+                        uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxOverflowDelayedTaskList, eBlocked );
+                    }
+                #endif /* configUSE_DELAYED_TASK_BUCKETS */
 
                 #if ( INCLUDE_vTaskDelete == 1 )
                     {
@@ -2767,7 +2862,7 @@ BaseType_t xTaskIncrementTick( void )
         {
             for( ; ; )
             {
-                if( listLIST_IS_EMPTY( pxDelayedTaskList ) != pdFALSE )
+                if( taskDELAYED_LIST_IS_EMPTY( pxDelayedTaskList ) != pdFALSE )
                 {
                     /* The delayed list is empty.  Set xNextTaskUnblockTime
                      * to the maximum possible value so it is extremely
@@ -2783,7 +2878,7 @@ BaseType_t xTaskIncrementTick( void )
                      * item at the head of the delayed list.  This is the time
                      * at which the task at the head of the delayed list must
                      * be removed from the Blocked state. */
-                    pxTCB = listGET_OWNER_OF_HEAD_ENTRY( pxDelayedTaskList ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+                    pxTCB = listGET_LIST_ITEM_OWNER( taskDELAYED_LIST_HEAD_ENTRY( pxDelayedTaskList ) ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
                     xItemValue = listGET_LIST_ITEM_VALUE( &( pxTCB->xStateListItem ) );
 
                     if( xConstTickCount < xItemValue )
@@ -3661,8 +3756,8 @@ static void prvInitialiseTaskLists( void )
         vListInitialise( &( pxReadyTasksLists[ uxPriority ] ) );
     }
 
-    vListInitialise( &xDelayedTaskList1 );
-    vListInitialise( &xDelayedTaskList2 );
+    taskDELAYED_LIST_INITIALISE( &xDelayedTaskList1 );
+    taskDELAYED_LIST_INITIALISE( &xDelayedTaskList2 );
     vListInitialise( &xPendingReadyList );
 
     #if ( INCLUDE_vTaskDelete == 1 )
@@ -3994,7 +4089,7 @@ static void prvCheckTasksWaitingTermination( void )
 
 static void prvResetNextTaskUnblockTime( void )
 {
-    if( listLIST_IS_EMPTY( pxDelayedTaskList ) != pdFALSE )
+    if( taskDELAYED_LIST_IS_EMPTY( pxDelayedTaskList ) != pdFALSE )
     {
         /* The new current delayed list is empty.  Set xNextTaskUnblockTime to
          * the maximum possible value so it is  extremely unlikely that the
@@ -4008,11 +4103,135 @@ static void prvResetNextTaskUnblockTime( void )
          * the item at the head of the delayed list.  This is the time at
          * which the task at the head of the delayed list should be removed
          * from the Blocked state. */
-        xNextTaskUnblockTime = listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxDelayedTaskList );
+        xNextTaskUnblockTime = listGET_LIST_ITEM_VALUE( taskDELAYED_LIST_HEAD_ENTRY( pxDelayedTaskList ) );
     }
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_DELAYED_TASK_BUCKETS == 1 )
+
+    static void prvDelayedListInitialise( DelayedTaskList_t * const pxDelayedList )
+    {
+        UBaseType_t uxBucket;
+
+        for( uxBucket = ( UBaseType_t ) 0U; uxBucket < ( UBaseType_t ) taskDELAYED_BUCKETS; uxBucket++ )
+        {
+            vListInitialise( &( pxDelayedList->xBuckets[ uxBucket ] ) );
+        }
+
+        pxDelayedList->ulBucketsInUse = 0UL;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvDelayedListInsert( DelayedTaskList_t * const pxDelayedList,
+                                      ListItem_t * const pxNewListItem )
+    {
+        const UBaseType_t uxBucket = taskDELAYED_BUCKET_INDEX( listGET_LIST_ITEM_VALUE( pxNewListItem ) );
+
+        vListInsert( &( pxDelayedList->xBuckets[ uxBucket ] ), pxNewListItem );
+        pxDelayedList->ulBucketsInUse |= ( 1UL << uxBucket );
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvDelayedListIsEmpty( DelayedTaskList_t * const pxDelayedList )
+    {
+        UBaseType_t uxBucket;
+        BaseType_t xReturn = pdTRUE;
+
+        while( pxDelayedList->ulBucketsInUse != 0UL )
+        {
+            uxBucket = prvDelayedListLowestBit( pxDelayedList->ulBucketsInUse );
+
+            if( listLIST_IS_EMPTY( &( pxDelayedList->xBuckets[ uxBucket ] ) ) == pdFALSE )
+            {
+                xReturn = pdFALSE;
+                break;
+            }
+
+            /* The last task in the bucket was removed since the bit was set. */
+            pxDelayedList->ulBucketsInUse &= ~( 1UL << uxBucket );
+        }
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static ListItem_t * prvDelayedListGetHeadEntry( DelayedTaskList_t * const pxDelayedList )
+    {
+        const UBaseType_t uxFirstBucket = taskDELAYED_BUCKET_INDEX( xTickCount );
+        const TickType_t xFirstBucketStart = ( xTickCount >> configDELAYED_TASK_BUCKET_WIDTH_BITS ) << configDELAYED_TASK_BUCKET_WIDTH_BITS;
+        uint32_t ulBuckets = pxDelayedList->ulBucketsInUse;
+        UBaseType_t uxOffset, uxBucket;
+        List_t * pxBucket;
+        ListItem_t * pxHead, * pxReturn = NULL;
+
+        /* Rotate the bits so bit 0 is the bucket that holds the current tick
+         * count, then visit the buckets in the order their time ranges
+         * follow on from the current tick count. */
+        if( uxFirstBucket != ( UBaseType_t ) 0U )
+        {
+            ulBuckets = ( ( ulBuckets >> uxFirstBucket ) | ( ulBuckets << ( taskDELAYED_BUCKETS - uxFirstBucket ) ) ) & taskDELAYED_BUCKETS_IN_USE_MASK;
+        }
+
+        while( ulBuckets != 0UL )
+        {
+            uxOffset = prvDelayedListLowestBit( ulBuckets );
+            ulBuckets &= ulBuckets - 1UL;
+            uxBucket = ( uxFirstBucket + uxOffset ) & taskDELAYED_BUCKET_MASK;
+            pxBucket = &( pxDelayedList->xBuckets[ uxBucket ] );
+
+            if( listLIST_IS_EMPTY( pxBucket ) != pdFALSE )
+            {
+                /* The last task in the bucket was removed since the bit was
+                 * set. */
+                pxDelayedList->ulBucketsInUse &= ~( 1UL << uxBucket );
+            }
+            else
+            {
+                pxHead = listGET_HEAD_ENTRY( pxBucket );
+
+                /* If the first task in the bucket wakes within the range the
+                 * bucket covers on this pass round the buckets, then no task
+                 * in a bucket visited later can wake before it. */
+                if( ( TickType_t ) ( listGET_LIST_ITEM_VALUE( pxHead ) - xFirstBucketStart ) < ( ( ( TickType_t ) uxOffset + ( TickType_t ) 1U ) << configDELAYED_TASK_BUCKET_WIDTH_BITS ) )
+                {
+                    pxReturn = pxHead;
+                    break;
+                }
+
+                /* Otherwise remember the earliest first task in case no task
+                 * wakes on this pass round the buckets. */
+                if( ( pxReturn == NULL ) || ( listGET_LIST_ITEM_VALUE( pxHead ) < listGET_LIST_ITEM_VALUE( pxReturn ) ) )
+                {
+                    pxReturn = pxHead;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+        }
+
+        return pxReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static UBaseType_t prvDelayedListLowestBit( uint32_t ulBits )
+    {
+        /* Found with a de Bruijn sequence. */
+        static const uint8_t ucBitPosition[ 32 ] =
+        {
+            0U,  1U,  28U, 2U,  29U, 14U, 24U, 3U, 30U, 22U, 20U, 15U, 25U, 17U, 4U,  8U,
+            31U, 27U, 13U, 23U, 21U, 19U, 16U, 7U, 26U, 12U, 18U, 6U,  11U, 5U,  10U, 9U
+        };
+        const uint32_t ulLowestBit = ulBits & ( ( uint32_t ) 0U - ulBits );
+
+        return ( UBaseType_t ) ucBitPosition[ ( ( uint32_t ) ( ulLowestBit * 0x077CB531UL ) ) >> 27 ];
+    }
+
+#endif /* configUSE_DELAYED_TASK_BUCKETS */
+/*-----------------------------------------------------------*/
+
 #if ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) )
 
     TaskHandle_t xTaskGetCurrentTaskHandle( void )
@@ -5318,13 +5537,13 @@ static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait,
                 {
                     /* Wake time has overflowed.  Place this item in the overflow
                      * list. */
-                    vListInsert( pxOverflowDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+                    taskDELAYED_LIST_INSERT( pxOverflowDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
                 }
                 else
                 {
                     /* The wake time has not overflowed, so the current block list
                      * is used. */
-                    vListInsert( pxDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+                    taskDELAYED_LIST_INSERT( pxDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
 
                     /* If the task entering the blocked state was placed at the
                      * head of the list of blocked tasks then xNextTaskUnblockTime
@@ -5353,12 +5572,12 @@ static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait,
             if( xTimeToWake < xConstTickCount )
             {
                 /* Wake time has overflowed.  Place this item in the overflow list. */
-                vListInsert( pxOverflowDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+                taskDELAYED_LIST_INSERT( pxOverflowDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
             }
             else
             {
                 /* The wake time has not overflowed, so the current block list is used. */
-                vListInsert( pxDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+                taskDELAYED_LIST_INSERT( pxDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
 
                 /* If the task entering the blocked state was placed at the head of the
                  * list of blocked tasks then xNextTaskUnblockTime needs to be updated
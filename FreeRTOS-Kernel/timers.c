@@ -57,6 +57,32 @@
 /* Misc definitions. */
     #define tmrNO_DELAY    ( TickType_t ) 0U
 
+/* Whether xTime has been reached when the time is xTimeNow.  The timing wheel
+ * compares distances from xWheelTime so the test also holds across a tick
+ * count overflow.  The sorted lists are switched on each overflow instead. */
+    #if ( configUSE_TIMER_WHEEL == 1 )
+        #define tmrTIME_HAS_BEEN_REACHED( xTime, xTimeNow )    ( ( ( TickType_t ) ( ( xTimeNow ) - xWheelTime ) >= ( TickType_t ) ( ( xTime ) - xWheelTime ) ) ? pdTRUE : pdFALSE )
+    #else
+        #define tmrTIME_HAS_BEEN_REACHED( xTime, xTimeNow )    ( ( ( xTime ) <= ( xTimeNow ) ) ? pdTRUE : pdFALSE )
+    #endif
+
+/* When configUSE_TIMER_DIRECT_COMMANDS is 1, tasks start, reset, stop and
+ * change the period of timers by accessing the active timers directly with
+ * the scheduler suspended.  The command does not go through xTimerQueue, so
+ * the timer service task is only unblocked when the command brings the next
+ * expiry time forward.  Commands from interrupts, deletes, and any command
+ * issued while other commands are still queued are sent to the timer service
+ * task as normal, so commands are always processed in the order issued.  As
+ * tasks can then access the active timers, the timer service task also
+ * accesses them with the scheduler suspended. */
+    #if ( configUSE_TIMER_DIRECT_COMMANDS == 1 )
+        #define tmrLOCK_ACTIVE_TIMERS()      vTaskSuspendAll()
+        #define tmrUNLOCK_ACTIVE_TIMERS()    ( void ) xTaskResumeAll()
+    #else
+        #define tmrLOCK_ACTIVE_TIMERS()
+        #define tmrUNLOCK_ACTIVE_TIMERS()
+    #endif
+
 /* The name assigned to the timer service task.  This can be overridden by
  * defining trmTIMER_SERVICE_TASK_NAME in FreeRTOSConfig.h. */
     #ifndef configTIMER_SERVICE_TASK_NAME
@@ -131,15 +157,46 @@
  * xActiveTimerList1 and xActiveTimerList2 could be at function scope but that
  * breaks some kernel aware debuggers, and debuggers that reply on removing the
  * static qualifier. */
-    PRIVILEGED_DATA static List_t xActiveTimerList1;
-    PRIVILEGED_DATA static List_t xActiveTimerList2;
-    PRIVILEGED_DATA static List_t * pxCurrentTimerList;
-    PRIVILEGED_DATA static List_t * pxOverflowTimerList;
+    #if ( configUSE_TIMER_WHEEL == 0 )
+        PRIVILEGED_DATA static List_t xActiveTimerList1;
+        PRIVILEGED_DATA static List_t xActiveTimerList2;
+        PRIVILEGED_DATA static List_t * pxCurrentTimerList;
+        PRIVILEGED_DATA static List_t * pxOverflowTimerList;
+    #else
+
+/* When configUSE_TIMER_WHEEL is 1 the active timers are held in a hierarchical
+ * timing wheel instead of the two sorted lists above, so starting, resetting
+ * and stopping a timer does not depend on the number of active timers.
+ *
+ * The wheel has tmrWHEEL_LEVELS levels of tmrWHEEL_SLOTS slots.  A timer that
+ * expires less than tmrWHEEL_SLOTS ticks after xWheelTime is held in level 0,
+ * in the slot selected by the low bits of its expiry time.  A timer that
+ * expires further ahead is held in the level whose slots span its distance,
+ * and is moved ("cascaded") to a lower level when the tick count reaches the
+ * start of its slot.  Only the timer service task accesses the wheel.
+ *
+ * Every distance is computed relative to xWheelTime using unsigned
+ * arithmetic, so tick count overflows need no special handling and the
+ * overflow list is not used. */
+        #define tmrWHEEL_SLOTS        ( 1U << configTIMER_WHEEL_SLOT_BITS )
+        #define tmrWHEEL_SLOT_MASK    ( ( TickType_t ) ( tmrWHEEL_SLOTS - 1U ) )
+        #define tmrWHEEL_LEVELS       ( ( sizeof( TickType_t ) * 8U ) / configTIMER_WHEEL_SLOT_BITS )
+        #define tmrWHEEL_SHIFT( uxLevel )    ( ( UBaseType_t ) ( uxLevel ) * ( UBaseType_t ) configTIMER_WHEEL_SLOT_BITS )
+
+        PRIVILEGED_DATA static List_t xTimerWheel[ tmrWHEEL_LEVELS * tmrWHEEL_SLOTS ];
+        PRIVILEGED_DATA static uint32_t ulWheelSlotsInUse[ tmrWHEEL_LEVELS ]; /*<< Bit n is set when slot n of the level holds at least one timer. */
+        PRIVILEGED_DATA static TickType_t xWheelTime = ( TickType_t ) 0U;     /*<< The time up to which the wheel has been processed. */
+        PRIVILEGED_DATA static UBaseType_t uxWheelTimerCount = 0U;            /*<< The number of timers in the wheel. */
+    #endif /* configUSE_TIMER_WHEEL */
 
 /* A queue that is used to send commands to the timer service task. */
     PRIVILEGED_DATA static QueueHandle_t xTimerQueue = NULL;
     PRIVILEGED_DATA static TaskHandle_t xTimerTaskHandle = NULL;
 
+/* The tick count when prvSampleTimeNow() was last called, used to detect
+ * tick count overflows. */
+    PRIVILEGED_DATA static TickType_t xLastTime = ( TickType_t ) 0U;
+
 /*lint -restore */
 
 /*-----------------------------------------------------------*/
@@ -183,7 +240,9 @@
  * The tick count has overflowed.  Switch the timer lists after ensuring the
  * current timer list does not still reference some timers.
  */
-    static void prvSwitchTimerLists( void ) PRIVILEGED_FUNCTION;
+    #if ( configUSE_TIMER_WHEEL == 0 )
+        static void prvSwitchTimerLists( void ) PRIVILEGED_FUNCTION;
+    #endif
 
 /*
  * Obtain the current tick count, setting *pxTimerListsWereSwitched to pdTRUE
@@ -203,9 +262,60 @@
  * If a timer has expired, process it.  Otherwise, block the timer service task
  * until either a timer does expire or a command is received.
  */
-    static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime,
+    static void prvProcessTimerOrBlockTask( TickType_t xNextExpireTime,
                                             BaseType_t xListWasEmpty ) PRIVILEGED_FUNCTION;
 
+/*
+ * Remove the timer from whichever active list or wheel slot holds it.
+ */
+    static void prvRemoveTimerFromActiveList( Timer_t * const pxTimer ) PRIVILEGED_FUNCTION;
+
+/*
+ * Perform a command sent from a task without going through the timer queue.
+ * Returns pdFAIL if the command must be sent to the timer service task
+ * instead.
+ */
+    #if ( configUSE_TIMER_DIRECT_COMMANDS == 1 )
+        static BaseType_t prvExecuteCommandDirectly( Timer_t * const pxTimer,
+                                                     const BaseType_t xCommandID,
+                                                     const TickType_t xOptionalValue ) PRIVILEGED_FUNCTION;
+    #endif
+
+    #if ( configUSE_TIMER_WHEEL == 1 )
+
+/*
+ * Add the timer to the wheel slot for its expiry time, which is already
+ * stored in its list item.  prvWheelInsert() also counts the timer, while
+ * prvWheelPlace() is used to move timers that are already counted.
+ */
+        static void prvWheelInsert( Timer_t * const pxTimer,
+                                    const TickType_t xTimeNow ) PRIVILEGED_FUNCTION;
+        static void prvWheelPlace( Timer_t * const pxTimer ) PRIVILEGED_FUNCTION;
+
+/*
+ * Return the time at which the wheel next needs attention.  That is either
+ * the expiry time of a timer in level 0 or the time at which an occupied slot
+ * of a higher level must be cascaded, whichever comes first.  Must only be
+ * called when the wheel is not empty.
+ */
+        static TickType_t prvWheelGetNextEventTime( void ) PRIVILEGED_FUNCTION;
+
+/*
+ * Move the wheel on to xEventTime, which must have been returned by
+ * prvWheelGetNextEventTime(), cascading any slots that start at that time.
+ */
+        static void prvWheelAdvance( const TickType_t xEventTime ) PRIVILEGED_FUNCTION;
+
+/*
+ * Return the number of slots from uxSlot to the first occupied slot in
+ * ulSlotsInUse, counting round the end of the level.  0 means uxSlot itself
+ * is occupied.
+ */
+        static UBaseType_t prvWheelSlotsToNextInUse( const uint32_t ulSlotsInUse,
+                                                     const UBaseType_t uxSlot ) PRIVILEGED_FUNCTION;
+
+    #endif /* configUSE_TIMER_WHEEL */
+
 /*
  * Called after a Timer_t structure has been allocated either statically or
  * dynamically to fill in the structure's members.
@@ -396,7 +506,24 @@
 
             if( xCommandID < tmrFIRST_FROM_ISR_COMMAND )
             {
-                if( xTaskGetSchedulerState() == taskSCHEDULER_RUNNING )
+                #if ( configUSE_TIMER_DIRECT_COMMANDS == 1 )
+                    {
+                        if( xTaskGetSchedulerState() == taskSCHEDULER_RUNNING )
+                        {
+                            xReturn = prvExecuteCommandDirectly( xTimer, xCommandID, xOptionalValue );
+                        }
+                        else
+                        {
+                            mtCOVERAGE_TEST_MARKER();
+                        }
+                    }
+                #endif /* configUSE_TIMER_DIRECT_COMMANDS */
+
+                if( xReturn != pdFAIL )
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+                else if( xTaskGetSchedulerState() == taskSCHEDULER_RUNNING )
                 {
                     xReturn = xQueueSendToBack( xTimerQueue, &xMessage, xTicksToWait );
                 }
@@ -509,42 +636,94 @@
                                         const TickType_t xTimeNow )
     {
         BaseType_t xResult;
-        Timer_t * const pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList ); /*lint !e9087 !e9079 void * is used as this macro is used with tasks and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+        Timer_t * pxTimer;
+
+        #if ( configUSE_TIMER_WHEEL == 1 )
+            {
+                List_t * pxSlot;
+
+                /* The event may be a cascade rather than an expiry, in which case
+                 * level 0 has nothing due once the wheel has moved on. */
+                if( xNextExpireTime != xWheelTime )
+                {
+                    prvWheelAdvance( xNextExpireTime );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
 
-        /* Remove the timer from the list of active timers.  A check has already
-         * been performed to ensure the list is not empty. */
+                /* Every timer in the current level 0 slot expires now. */
+                pxSlot = &( xTimerWheel[ xWheelTime & tmrWHEEL_SLOT_MASK ] );
 
-        ( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
-        traceTIMER_EXPIRED( pxTimer );
+                if( listLIST_IS_EMPTY( pxSlot ) == pdFALSE )
+                {
+                    pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxSlot ); /*lint !e9087 !e9079 void * is used as this macro is used with tasks and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+                }
+                else
+                {
+                    pxTimer = NULL;
+                }
+            }
+        #else /* if ( configUSE_TIMER_WHEEL == 1 ) */
+            {
+                /* A check has already been performed to ensure the list is not
+                 * empty. */
+                pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList ); /*lint !e9087 !e9079 void * is used as this macro is used with tasks and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+            }
+        #endif /* configUSE_TIMER_WHEEL */
 
-        /* If the timer is an auto-reload timer then calculate the next
-         * expiry time and re-insert the timer in the list of active timers. */
-        if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
+        if( pxTimer != NULL )
         {
-            /* The timer is inserted into a list using a time relative to anything
-             * other than the current time.  It will therefore be inserted into the
-             * correct list relative to the time this task thinks it is now. */
-            if( prvInsertTimerInActiveList( pxTimer, ( xNextExpireTime + pxTimer->xTimerPeriodInTicks ), xTimeNow, xNextExpireTime ) != pdFALSE )
+            /* Remove the timer from the list of active timers. */
+            prvRemoveTimerFromActiveList( pxTimer );
+            traceTIMER_EXPIRED( pxTimer );
+
+            /* If the timer is an auto-reload timer then calculate the next
+             * expiry time and re-insert the timer in the list of active timers. */
+            if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
             {
-                /* The timer expired before it was added to the active timer
-                 * list.  Reload it now.  */
-                xResult = xTimerGenericCommand( pxTimer, tmrCOMMAND_START_DONT_TRACE, xNextExpireTime, NULL, tmrNO_DELAY );
-                configASSERT( xResult );
-                ( void ) xResult;
+                /* The timer is inserted into a list using a time relative to anything
+                 * other than the current time.  It will therefore be inserted into the
+                 * correct list relative to the time this task thinks it is now. */
+                if( prvInsertTimerInActiveList( pxTimer, ( xNextExpireTime + pxTimer->xTimerPeriodInTicks ), xTimeNow, xNextExpireTime ) != pdFALSE )
+                {
+                    /* The timer expired before it was added to the active timer
+                     * list.  Reload it now.  */
+                    xResult = xTimerGenericCommand( pxTimer, tmrCOMMAND_START_DONT_TRACE, xNextExpireTime, NULL, tmrNO_DELAY );
+                    configASSERT( xResult );
+                    ( void ) xResult;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
             }
             else
             {
+                pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
                 mtCOVERAGE_TEST_MARKER();
             }
         }
         else
         {
-            pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
             mtCOVERAGE_TEST_MARKER();
         }
 
-        /* Call the timer callback. */
-        pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
+        /* prvProcessTimerOrBlockTask() leaves the scheduler suspended when
+         * tasks can access the active timers directly.  Resume it before calling
+         * the callback. */
+        tmrUNLOCK_ACTIVE_TIMERS();
+
+        if( pxTimer != NULL )
+        {
+            /* Call the timer callback. */
+            pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
     }
 /*-----------------------------------------------------------*/
 
@@ -584,7 +763,7 @@
     }
 /*-----------------------------------------------------------*/
 
-    static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime,
+    static void prvProcessTimerOrBlockTask( TickType_t xNextExpireTime,
                                             BaseType_t xListWasEmpty )
     {
         TickType_t xTimeNow;
@@ -599,12 +778,28 @@
              * prvSampleTimeNow() function. */
             xTimeNow = prvSampleTimeNow( &xTimerListsWereSwitched );
 
+            #if ( configUSE_TIMER_DIRECT_COMMANDS == 1 )
+                {
+                    /* A task may have changed the active timers since the next
+                     * expire time was obtained, so obtain it again now that the
+                     * scheduler is suspended. */
+                    xNextExpireTime = prvGetNextExpireTime( &xListWasEmpty );
+                }
+            #endif
+
             if( xTimerListsWereSwitched == pdFALSE )
             {
                 /* The tick count has not overflowed, has the timer expired? */
-                if( ( xListWasEmpty == pdFALSE ) && ( xNextExpireTime <= xTimeNow ) )
+                if( ( xListWasEmpty == pdFALSE ) && ( tmrTIME_HAS_BEEN_REACHED( xNextExpireTime, xTimeNow ) != pdFALSE ) )
                 {
-                    ( void ) xTaskResumeAll();
+                    /* When tasks can access the active timers directly the
+                     * scheduler remains suspended until the expired timer has
+                     * been removed, and prvProcessExpiredTimer() resumes it. */
+                    #if ( configUSE_TIMER_DIRECT_COMMANDS == 0 )
+                        {
+                            ( void ) xTaskResumeAll();
+                        }
+                    #endif
                     prvProcessExpiredTimer( xNextExpireTime, xTimeNow );
                 }
                 else
@@ -615,12 +810,16 @@
                      * received - whichever comes first.  The following line cannot
                      * be reached unless xNextExpireTime > xTimeNow, except in the
                      * case when the current timer list is empty. */
-                    if( xListWasEmpty != pdFALSE )
-                    {
-                        /* The current timer list is empty - is the overflow list
-                         * also empty? */
-                        xListWasEmpty = listLIST_IS_EMPTY( pxOverflowTimerList );
-                    }
+                    #if ( configUSE_TIMER_WHEEL == 0 )
+                        {
+                            if( xListWasEmpty != pdFALSE )
+                            {
+                                /* The current timer list is empty - is the overflow list
+                                 * also empty? */
+                                xListWasEmpty = listLIST_IS_EMPTY( pxOverflowTimerList );
+                            }
+                        }
+                    #endif /* configUSE_TIMER_WHEEL */
 
                     vQueueWaitForMessageRestricted( xTimerQueue, ( xNextExpireTime - xTimeNow ), xListWasEmpty );
 
@@ -657,17 +856,36 @@
          * this task to unblock when the tick count overflows, at which point the
          * timer lists will be switched and the next expiry time can be
          * re-assessed.  */
-        *pxListWasEmpty = listLIST_IS_EMPTY( pxCurrentTimerList );
+        #if ( configUSE_TIMER_WHEEL == 1 )
+            {
+                /* The timing wheel has no overflow list, so when it is empty
+                 * the task can wait indefinitely for a command. */
+                if( uxWheelTimerCount == 0U )
+                {
+                    *pxListWasEmpty = pdTRUE;
+                    xNextExpireTime = ( TickType_t ) 0U;
+                }
+                else
+                {
+                    *pxListWasEmpty = pdFALSE;
+                    xNextExpireTime = prvWheelGetNextEventTime();
+                }
+            }
+        #else /* if ( configUSE_TIMER_WHEEL == 1 ) */
+            {
+                *pxListWasEmpty = listLIST_IS_EMPTY( pxCurrentTimerList );
 
-        if( *pxListWasEmpty == pdFALSE )
-        {
-            xNextExpireTime = listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxCurrentTimerList );
-        }
-        else
-        {
-            /* Ensure the task unblocks when the tick count rolls over. */
-            xNextExpireTime = ( TickType_t ) 0U;
-        }
+                if( *pxListWasEmpty == pdFALSE )
+                {
+                    xNextExpireTime = listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxCurrentTimerList );
+                }
+                else
+                {
+                    /* Ensure the task unblocks when the tick count rolls over. */
+                    xNextExpireTime = ( TickType_t ) 0U;
+                }
+            }
+        #endif /* configUSE_TIMER_WHEEL */
 
         return xNextExpireTime;
     }
@@ -676,14 +894,23 @@
     static TickType_t prvSampleTimeNow( BaseType_t * const pxTimerListsWereSwitched )
     {
         TickType_t xTimeNow;
-        PRIVILEGED_DATA static TickType_t xLastTime = ( TickType_t ) 0U; /*lint !e956 Variable is only accessible to one task. */
 
         xTimeNow = xTaskGetTickCount();
 
         if( xTimeNow < xLastTime )
         {
-            prvSwitchTimerLists();
-            *pxTimerListsWereSwitched = pdTRUE;
+            #if ( configUSE_TIMER_WHEEL == 0 )
+                {
+                    prvSwitchTimerLists();
+                    *pxTimerListsWereSwitched = pdTRUE;
+                }
+            #else
+                {
+                    /* The wheel measures every time relative to xWheelTime, so
+                     * an overflow does not need any processing. */
+                    *pxTimerListsWereSwitched = pdFALSE;
+                }
+            #endif
         }
         else
         {
@@ -718,7 +945,11 @@
             }
             else
             {
-                vListInsert( pxOverflowTimerList, &( pxTimer->xTimerListItem ) );
+                #if ( configUSE_TIMER_WHEEL == 1 )
+                    prvWheelInsert( pxTimer, xTimeNow );
+                #else
+                    vListInsert( pxOverflowTimerList, &( pxTimer->xTimerListItem ) );
+                #endif
             }
         }
         else
@@ -732,7 +963,11 @@
             }
             else
             {
-                vListInsert( pxCurrentTimerList, &( pxTimer->xTimerListItem ) );
+                #if ( configUSE_TIMER_WHEEL == 1 )
+                    prvWheelInsert( pxTimer, xTimeNow );
+                #else
+                    vListInsert( pxCurrentTimerList, &( pxTimer->xTimerListItem ) );
+                #endif
             }
         }
 
@@ -744,6 +979,7 @@
     {
         DaemonTaskMessage_t xMessage;
         Timer_t * pxTimer;
+        Timer_t * pxExpiredTimer;
         BaseType_t xTimerListsWereSwitched, xResult;
         TickType_t xTimeNow;
 
@@ -775,14 +1011,17 @@
              * function calls. */
             if( xMessage.xMessageID >= ( BaseType_t ) 0 )
             {
+                tmrLOCK_ACTIVE_TIMERS();
+
                 /* The messages uses the xTimerParameters member to work on a
                  * software timer. */
                 pxTimer = xMessage.u.xTimerParameters.pxTimer;
+                pxExpiredTimer = NULL;
 
                 if( listIS_CONTAINED_WITHIN( NULL, &( pxTimer->xTimerListItem ) ) == pdFALSE ) /*lint !e961. The cast is only redundant when NULL is passed into the macro. */
                 {
                     /* The timer is in a list, remove it. */
-                    ( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+                    prvRemoveTimerFromActiveList( pxTimer );
                 }
                 else
                 {
@@ -812,8 +1051,11 @@
                         if( prvInsertTimerInActiveList( pxTimer, xMessage.u.xTimerParameters.xMessageValue + pxTimer->xTimerPeriodInTicks, xTimeNow, xMessage.u.xTimerParameters.xMessageValue ) != pdFALSE )
                         {
                             /* The timer expired before it was added to the active
-                             * timer list.  Process it now. */
-                            pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
+                             * timer list.  Process it now, but only call the
+                             * callback once the active timers are unlocked, as
+                             * prvProcessExpiredTimer() does, so the callback runs
+                             * with the scheduler running whichever way commands
+                             * are processed. */
                             traceTIMER_EXPIRED( pxTimer );
 
                             if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
@@ -824,8 +1066,13 @@
                             }
                             else
                             {
-                                mtCOVERAGE_TEST_MARKER();
+                                /* A one shot timer is not active once it has
+                                 * expired, as prvProcessExpiredTimer() also
+                                 * records. */
+                                pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
                             }
+
+                            pxExpiredTimer = pxTimer;
                         }
                         else
                         {
@@ -885,69 +1132,380 @@
                         /* Don't expect to get here. */
                         break;
                 }
+
+                tmrUNLOCK_ACTIVE_TIMERS();
+
+                if( pxExpiredTimer != NULL )
+                {
+                    /* Call the timer callback. */
+                    pxExpiredTimer->pxCallbackFunction( ( TimerHandle_t ) pxExpiredTimer );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
             }
         }
     }
 /*-----------------------------------------------------------*/
 
-    static void prvSwitchTimerLists( void )
-    {
-        TickType_t xNextExpireTime, xReloadTime;
-        List_t * pxTemp;
-        Timer_t * pxTimer;
-        BaseType_t xResult;
+    #if ( configUSE_TIMER_WHEEL == 0 )
 
-        /* The tick count has overflowed.  The timer lists must be switched.
-         * If there are any timers still referenced from the current timer list
-         * then they must have expired and should be processed before the lists
-         * are switched. */
-        while( listLIST_IS_EMPTY( pxCurrentTimerList ) == pdFALSE )
+        static void prvSwitchTimerLists( void )
         {
-            xNextExpireTime = listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxCurrentTimerList );
+            TickType_t xNextExpireTime, xReloadTime;
+            List_t * pxTemp;
+            Timer_t * pxTimer;
+            BaseType_t xResult;
+
+            /* The tick count has overflowed.  The timer lists must be switched.
+             * If there are any timers still referenced from the current timer list
+             * then they must have expired and should be processed before the lists
+             * are switched. */
+            while( listLIST_IS_EMPTY( pxCurrentTimerList ) == pdFALSE )
+            {
+                xNextExpireTime = listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxCurrentTimerList );
 
-            /* Remove the timer from the list. */
-            pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList ); /*lint !e9087 !e9079 void * is used as this macro is used with tasks and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
-            ( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
-            traceTIMER_EXPIRED( pxTimer );
+                /* Remove the timer from the list. */
+                pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList ); /*lint !e9087 !e9079 void * is used as this macro is used with tasks and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+                ( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+                traceTIMER_EXPIRED( pxTimer );
 
-            /* Execute its callback, then send a command to restart the timer if
-             * it is an auto-reload timer.  It cannot be restarted here as the lists
-             * have not yet been switched. */
-            pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
+                /* Execute its callback, then send a command to restart the timer if
+                 * it is an auto-reload timer.  It cannot be restarted here as the lists
+                 * have not yet been switched. */
+                pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
 
-            if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
+                if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
+                {
+                    /* Calculate the reload value, and if the reload value results in
+                     * the timer going into the same timer list then it has already expired
+                     * and the timer should be re-inserted into the current list so it is
+                     * processed again within this loop.  Otherwise a command should be sent
+                     * to restart the timer to ensure it is only inserted into a list after
+                     * the lists have been swapped. */
+                    xReloadTime = ( xNextExpireTime + pxTimer->xTimerPeriodInTicks );
+
+                    if( xReloadTime > xNextExpireTime )
+                    {
+                        listSET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ), xReloadTime );
+                        listSET_LIST_ITEM_OWNER( &( pxTimer->xTimerListItem ), pxTimer );
+                        vListInsert( pxCurrentTimerList, &( pxTimer->xTimerListItem ) );
+                    }
+                    else
+                    {
+                        xResult = xTimerGenericCommand( pxTimer, tmrCOMMAND_START_DONT_TRACE, xNextExpireTime, NULL, tmrNO_DELAY );
+                        configASSERT( xResult );
+                        ( void ) xResult;
+                    }
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+
+            pxTemp = pxCurrentTimerList;
+            pxCurrentTimerList = pxOverflowTimerList;
+            pxOverflowTimerList = pxTemp;
+        }
+
+    #endif /* configUSE_TIMER_WHEEL */
+/*-----------------------------------------------------------*/
+
+    static void prvRemoveTimerFromActiveList( Timer_t * const pxTimer )
+    {
+        #if ( configUSE_TIMER_WHEEL == 1 )
             {
-                /* Calculate the reload value, and if the reload value results in
-                 * the timer going into the same timer list then it has already expired
-                 * and the timer should be re-inserted into the current list so it is
-                 * processed again within this loop.  Otherwise a command should be sent
-                 * to restart the timer to ensure it is only inserted into a list after
-                 * the lists have been swapped. */
-                xReloadTime = ( xNextExpireTime + pxTimer->xTimerPeriodInTicks );
-
-                if( xReloadTime > xNextExpireTime )
+                List_t * const pxSlot = ( List_t * ) listLIST_ITEM_CONTAINER( &( pxTimer->xTimerListItem ) );
+                const UBaseType_t uxIndex = ( UBaseType_t ) ( pxSlot - &( xTimerWheel[ 0 ] ) );
+
+                if( uxListRemove( &( pxTimer->xTimerListItem ) ) == ( UBaseType_t ) 0U )
                 {
-                    listSET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ), xReloadTime );
-                    listSET_LIST_ITEM_OWNER( &( pxTimer->xTimerListItem ), pxTimer );
-                    vListInsert( pxCurrentTimerList, &( pxTimer->xTimerListItem ) );
+                    ulWheelSlotsInUse[ uxIndex / tmrWHEEL_SLOTS ] &= ~( 1UL << ( uxIndex % tmrWHEEL_SLOTS ) );
                 }
                 else
                 {
-                    xResult = xTimerGenericCommand( pxTimer, tmrCOMMAND_START_DONT_TRACE, xNextExpireTime, NULL, tmrNO_DELAY );
-                    configASSERT( xResult );
-                    ( void ) xResult;
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                uxWheelTimerCount--;
+            }
+        #else
+            {
+                ( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+            }
+        #endif /* configUSE_TIMER_WHEEL */
+    }
+/*-----------------------------------------------------------*/
+
+    #if ( configUSE_TIMER_DIRECT_COMMANDS == 1 )
+
+        static BaseType_t prvExecuteCommandDirectly( Timer_t * const pxTimer,
+                                                     const BaseType_t xCommandID,
+                                                     const TickType_t xOptionalValue )
+        {
+            BaseType_t xReturn = pdFAIL, xWasIdle, xListWasEmptyBefore, xListWasEmptyAfter;
+            TickType_t xTimeNow, xNextExpireTimeBefore, xNextExpireTimeAfter;
+
+            vTaskSuspendAll();
+            {
+                xTimeNow = xTaskGetTickCount();
+
+                /* Commands that are already queued must be processed first.  The
+                 * tick count must not have overflowed since the timer service
+                 * task last sampled it, as only that task switches the timer
+                 * lists.  Deleting a timer, and restarting an auto-reload timer
+                 * from within the timer service task, are always left to the
+                 * timer service task. */
+                if( ( uxQueueMessagesWaiting( xTimerQueue ) == ( UBaseType_t ) 0U ) &&
+                    ( xTimeNow >= xLastTime ) &&
+                    ( xCommandID != tmrCOMMAND_DELETE ) &&
+                    ( xCommandID != tmrCOMMAND_START_DONT_TRACE ) )
+                {
+                    #if ( configUSE_TIMER_WHEEL == 1 )
+                        xWasIdle = ( uxWheelTimerCount == 0U ) ? pdTRUE : pdFALSE;
+                    #else
+                        xWasIdle = ( ( listLIST_IS_EMPTY( pxCurrentTimerList ) != pdFALSE ) && ( listLIST_IS_EMPTY( pxOverflowTimerList ) != pdFALSE ) ) ? pdTRUE : pdFALSE;
+                    #endif
+
+                    xNextExpireTimeBefore = prvGetNextExpireTime( &xListWasEmptyBefore );
+
+                    if( listIS_CONTAINED_WITHIN( NULL, &( pxTimer->xTimerListItem ) ) == pdFALSE ) /*lint !e961. The cast is only redundant when NULL is passed into the macro. */
+                    {
+                        prvRemoveTimerFromActiveList( pxTimer );
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+
+                    switch( xCommandID )
+                    {
+                        case tmrCOMMAND_START:
+                        case tmrCOMMAND_RESET:
+
+                            /* If the timer has already expired it is left to the
+                             * timer service task, which calls its callback. */
+                            if( prvInsertTimerInActiveList( pxTimer, xOptionalValue + pxTimer->xTimerPeriodInTicks, xTimeNow, xOptionalValue ) == pdFALSE )
+                            {
+                                pxTimer->ucStatus |= tmrSTATUS_IS_ACTIVE;
+                                xReturn = pdPASS;
+                            }
+                            else
+                            {
+                                mtCOVERAGE_TEST_MARKER();
+                            }
+
+                            break;
+
+                        case tmrCOMMAND_STOP:
+                            pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
+                            xReturn = pdPASS;
+                            break;
+
+                        case tmrCOMMAND_CHANGE_PERIOD:
+                            pxTimer->ucStatus |= tmrSTATUS_IS_ACTIVE;
+                            pxTimer->xTimerPeriodInTicks = xOptionalValue;
+                            configASSERT( ( pxTimer->xTimerPeriodInTicks > 0 ) );
+                            ( void ) prvInsertTimerInActiveList( pxTimer, ( xTimeNow + pxTimer->xTimerPeriodInTicks ), xTimeNow, xTimeNow );
+                            xReturn = pdPASS;
+                            break;
+
+                        default:
+                            /* Don't expect to get here. */
+                            break;
+                    }
+
+                    if( xReturn != pdFAIL )
+                    {
+                        traceTIMER_COMMAND_RECEIVED( pxTimer, xCommandID, xOptionalValue );
+
+                        /* The timer service task is blocked until the expire time
+                         * it last obtained, or indefinitely if there were no active
+                         * timers.  Unblock it if the next expire time is now earlier.
+                         * A later expire time does not need it to unblock, as it
+                         * finds nothing to process when it does. */
+                        xNextExpireTimeAfter = prvGetNextExpireTime( &xListWasEmptyAfter );
+
+                        if( ( xWasIdle != pdFALSE ) ||
+                            ( ( xListWasEmptyAfter == pdFALSE ) &&
+                              ( ( xListWasEmptyBefore != pdFALSE ) || ( tmrTIME_HAS_BEEN_REACHED( xNextExpireTimeBefore, xNextExpireTimeAfter ) == pdFALSE ) ) ) )
+                        {
+                            ( void ) xTaskAbortDelay( xTimerTaskHandle );
+                        }
+                        else
+                        {
+                            mtCOVERAGE_TEST_MARKER();
+                        }
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
                 }
             }
+            ( void ) xTaskResumeAll();
+
+            return xReturn;
+        }
+
+    #endif /* configUSE_TIMER_DIRECT_COMMANDS */
+/*-----------------------------------------------------------*/
+
+    #if ( configUSE_TIMER_WHEEL == 1 )
+
+        static void prvWheelInsert( Timer_t * const pxTimer,
+                                    const TickType_t xTimeNow )
+        {
+            /* An empty wheel has nothing left to process, so it can be moved
+             * straight to the current time.  This keeps the distances that
+             * prvWheelPlace() computes smaller than the tick count range. */
+            if( uxWheelTimerCount == 0U )
+            {
+                xWheelTime = xTimeNow;
+            }
             else
             {
                 mtCOVERAGE_TEST_MARKER();
             }
+
+            prvWheelPlace( pxTimer );
+            uxWheelTimerCount++;
         }
+/*-----------------------------------------------------------*/
 
-        pxTemp = pxCurrentTimerList;
-        pxCurrentTimerList = pxOverflowTimerList;
-        pxOverflowTimerList = pxTemp;
-    }
+        static void prvWheelPlace( Timer_t * const pxTimer )
+        {
+            const TickType_t xExpiryTime = listGET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ) );
+            const TickType_t xDistance = ( TickType_t ) ( xExpiryTime - xWheelTime );
+            UBaseType_t uxLevel = 0U, uxSlot;
+
+            /* Use the lowest level that spans the distance to the expiry time.
+             * The top level spans the rest of the tick count range. */
+            while( ( uxLevel < ( UBaseType_t ) ( tmrWHEEL_LEVELS - 1U ) ) &&
+                   ( ( xDistance >> tmrWHEEL_SHIFT( uxLevel + 1U ) ) != ( TickType_t ) 0U ) )
+            {
+                uxLevel++;
+            }
+
+            uxSlot = ( UBaseType_t ) ( ( xExpiryTime >> tmrWHEEL_SHIFT( uxLevel ) ) & tmrWHEEL_SLOT_MASK );
+
+            listSET_LIST_ITEM_OWNER( &( pxTimer->xTimerListItem ), pxTimer );
+            vListInsertEnd( &( xTimerWheel[ ( uxLevel * tmrWHEEL_SLOTS ) + uxSlot ] ), &( pxTimer->xTimerListItem ) );
+            ulWheelSlotsInUse[ uxLevel ] |= ( 1UL << uxSlot );
+        }
+/*-----------------------------------------------------------*/
+
+        static TickType_t prvWheelGetNextEventTime( void )
+        {
+            TickType_t xShortest = portMAX_DELAY, xDistance, xOffsetInSlot;
+            UBaseType_t uxLevel, uxSteps, uxCurrentSlot;
+
+            for( uxLevel = 0U; uxLevel < ( UBaseType_t ) tmrWHEEL_LEVELS; uxLevel++ )
+            {
+                if( ulWheelSlotsInUse[ uxLevel ] != 0UL )
+                {
+                    uxCurrentSlot = ( UBaseType_t ) ( ( xWheelTime >> tmrWHEEL_SHIFT( uxLevel ) ) & tmrWHEEL_SLOT_MASK );
+
+                    if( uxLevel == 0U )
+                    {
+                        /* Level 0 slots are one tick wide.  A timer in the
+                         * current slot is due now. */
+                        xDistance = ( TickType_t ) prvWheelSlotsToNextInUse( ulWheelSlotsInUse[ uxLevel ], uxCurrentSlot );
+                    }
+                    else
+                    {
+                        /* Higher level slots are cascaded when the tick count
+                         * reaches their start.  The start of the current slot has
+                         * already passed, so the search starts at the next slot and
+                         * the current slot only comes round again a full level
+                         * later. */
+                        uxSteps = prvWheelSlotsToNextInUse( ulWheelSlotsInUse[ uxLevel ], ( uxCurrentSlot + 1U ) & tmrWHEEL_SLOT_MASK ) + 1U;
+                        xOffsetInSlot = xWheelTime & ( ( TickType_t ) ( ( ( TickType_t ) 1U << tmrWHEEL_SHIFT( uxLevel ) ) - 1U ) );
+                        xDistance = ( TickType_t ) ( ( TickType_t ) ( ( TickType_t ) uxSteps << tmrWHEEL_SHIFT( uxLevel ) ) - xOffsetInSlot );
+                    }
+
+                    if( xDistance < xShortest )
+                    {
+                        xShortest = xDistance;
+                    }
+                }
+            }
+
+            return ( TickType_t ) ( xWheelTime + xShortest );
+        }
+/*-----------------------------------------------------------*/
+
+        static void prvWheelAdvance( const TickType_t xEventTime )
+        {
+            UBaseType_t uxLevel, uxSlot;
+            List_t * pxSlot;
+            Timer_t * pxTimer;
+
+            /* No timer expires and no slot needs cascading before xEventTime, so
+             * the ticks in between can be skipped. */
+            xWheelTime = xEventTime;
+
+            /* A slot of a higher level is cascaded when the tick count reaches its
+             * start, i.e. when every lower digit of the time is zero.  Its timers
+             * expire within the width of the slot, so each moves to a lower
+             * level. */
+            for( uxLevel = ( UBaseType_t ) ( tmrWHEEL_LEVELS - 1U ); uxLevel > 0U; uxLevel-- )
+            {
+                if( ( xWheelTime & ( ( TickType_t ) ( ( ( TickType_t ) 1U << tmrWHEEL_SHIFT( uxLevel ) ) - 1U ) ) ) == ( TickType_t ) 0U )
+                {
+                    uxSlot = ( UBaseType_t ) ( ( xWheelTime >> tmrWHEEL_SHIFT( uxLevel ) ) & tmrWHEEL_SLOT_MASK );
+
+                    if( ( ulWheelSlotsInUse[ uxLevel ] & ( 1UL << uxSlot ) ) != 0UL )
+                    {
+                        ulWheelSlotsInUse[ uxLevel ] &= ~( 1UL << uxSlot );
+                        pxSlot = &( xTimerWheel[ ( uxLevel * tmrWHEEL_SLOTS ) + uxSlot ] );
+
+                        while( listLIST_IS_EMPTY( pxSlot ) == pdFALSE )
+                        {
+                            pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxSlot ); /*lint !e9087 !e9079 void * is used as this macro is used with tasks and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+                            ( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+                            prvWheelPlace( pxTimer );
+                        }
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+        }
+/*-----------------------------------------------------------*/
+
+        static UBaseType_t prvWheelSlotsToNextInUse( const uint32_t ulSlotsInUse,
+                                                     const UBaseType_t uxSlot )
+        {
+            /* Index of the lowest set bit, found with a de Bruijn sequence. */
+            static const uint8_t ucBitPosition[ 32 ] =
+            {
+                0U,  1U,  28U, 2U,  29U, 14U, 24U, 3U, 30U, 22U, 20U, 15U, 25U, 17U, 4U,  8U,
+                31U, 27U, 13U, 23U, 21U, 19U, 16U, 7U, 26U, 12U, 18U, 6U,  11U, 5U,  10U, 9U
+            };
+            uint32_t ulRotated, ulLowestBit;
+
+            /* Rotate the level so uxSlot becomes bit 0. */
+            ulRotated = ( ulSlotsInUse >> uxSlot ) | ( ulSlotsInUse << ( tmrWHEEL_SLOTS - uxSlot ) );
+            ulRotated &= ( uint32_t ) ( ( 1UL << tmrWHEEL_SLOTS ) - 1UL );
+            ulLowestBit = ulRotated & ( ( uint32_t ) 0U - ulRotated );
+
+            return ( UBaseType_t ) ucBitPosition[ ( ( uint32_t ) ( ulLowestBit * 0x077CB531UL ) ) >> 27 ];
+        }
+
+    #endif /* configUSE_TIMER_WHEEL */
 /*-----------------------------------------------------------*/
 
     static void prvCheckForValidListAndQueue( void )
@@ -959,10 +1517,23 @@
         {
             if( xTimerQueue == NULL )
             {
-                vListInitialise( &xActiveTimerList1 );
-                vListInitialise( &xActiveTimerList2 );
-                pxCurrentTimerList = &xActiveTimerList1;
-                pxOverflowTimerList = &xActiveTimerList2;
+                #if ( configUSE_TIMER_WHEEL == 1 )
+                    {
+                        UBaseType_t uxSlot;
+
+                        for( uxSlot = 0U; uxSlot < ( UBaseType_t ) ( tmrWHEEL_LEVELS * tmrWHEEL_SLOTS ); uxSlot++ )
+                        {
+                            vListInitialise( &( xTimerWheel[ uxSlot ] ) );
+                        }
+                    }
+                #else
+                    {
+                        vListInitialise( &xActiveTimerList1 );
+                        vListInitialise( &xActiveTimerList2 );
+                        pxCurrentTimerList = &xActiveTimerList1;
+                        pxOverflowTimerList = &xActiveTimerList2;
+                    }
+                #endif /* configUSE_TIMER_WHEEL */
 
                 #if ( configSUPPORT_STATIC_ALLOCATION == 1 )
                     {
@@ -0,0 +1,140 @@
+/*
+ * FreeRTOS Kernel V10.4.3 LTS Patch 2
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://aws.amazon.com/freertos
+ *
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/*-----------------------------------------------------------
+ * Application specific definitions for the host build of the demo, which runs
+ * on the POSIX port.  See ../FreeRTOSConfig.h for the target.
+ *
+ * The settings that change how the kernel behaves are those of the target,
+ * so that results on the host carry over.  The heap is larger, as each task
+ * also allocates a thread, timers and the tick hook are used by the standard
+ * demo tasks, and the kernel options can be overridden from the compiler
+ * command line to compare them.
+ *
+ * See http://www.freertos.org/a00110.html
+ *----------------------------------------------------------*/
+
+#define configUSE_PREEMPTION		1
+#define configUSE_IDLE_HOOK			0
+#define configUSE_TICK_HOOK			1
+#define configCPU_CLOCK_HZ			( 72000000UL )	/* Without a cast, so #if can test it. */
+#define configTICK_RATE_HZ			( ( TickType_t ) 1000 )
+#define configMAX_PRIORITIES		( 5 )
+#define configMINIMAL_STACK_SIZE	( ( unsigned short ) 128 )
+#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 512 * 1024 ) )
+#define configHEAP_MAX_BLOCK_BITS	20	/* heap_6 must hold the whole heap in one block. */
+#define configMAX_TASK_NAME_LEN		( 16 )
+#define configUSE_TRACE_FACILITY	0
+#define configUSE_16_BIT_TICKS		0
+#define configIDLE_SHOULD_YIELD		1
+#define configUSE_MUTEXES			1
+#define configUSE_RECURSIVE_MUTEXES	1
+#define configUSE_COUNTING_SEMAPHORES	1
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES 		0
+#define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
+
+/* Software timer definitions.  The timer service task runs above the tasks
+that use it, so the kernel benchmarks time each command to completion. */
+#define configUSE_TIMERS				1
+#define configTIMER_TASK_PRIORITY		( configMAX_PRIORITIES - 1 )
+#define configTIMER_QUEUE_LENGTH		20
+#define configTIMER_TASK_STACK_DEPTH	( configMINIMAL_STACK_SIZE * 2 )
+
+/* Kernel options compared by the benchmarks, 0 unless set on the command
+line. */
+#ifndef configUSE_TIMER_WHEEL
+	#define configUSE_TIMER_WHEEL			0
+#endif
+
+#ifndef configUSE_TIMER_DIRECT_COMMANDS
+	#define configUSE_TIMER_DIRECT_COMMANDS	0
+#endif
+
+#ifndef configUSE_DELAYED_TASK_BUCKETS
+	#define configUSE_DELAYED_TASK_BUCKETS	0
+#endif
+
+#define configUSE_QUEUE_ZERO_COPY		1
+
+/* The queue tests build the kernel with configUSE_QUEUE_BLOCKING_HOOK set to 1
+so vQueueBlockingHook() is called as a task blocks on a queue, while the queue
+is locked, where it can call the FromISR functions as an interrupt might. */
+#ifndef configUSE_QUEUE_BLOCKING_HOOK
+	#define configUSE_QUEUE_BLOCKING_HOOK	0
+#endif
+
+#if ( configUSE_QUEUE_BLOCKING_HOOK == 1 )
+	void vQueueBlockingHook( void *pvQueue );
+	#define traceBLOCKING_ON_QUEUE_SEND( pxQueue )		vQueueBlockingHook( pxQueue )
+	#define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue )	vQueueBlockingHook( pxQueue )
+#endif
+
+/* The NVIC priority the drivers give their interrupts, as on the target.  The
+simulated interrupts all run from the tick, so it is only written to the
+NVIC registers held in RAM. */
+#define configLIBRARY_KERNEL_INTERRUPT_PRIORITY	15
+
+/* The tick is a signal, which the host can deliver late, so the stream buffer
+demo can see a byte more than the trigger level of its interrupt test. */
+#define configSTREAM_BUFFER_TRIGGER_LEVEL_TEST_MARGIN	2
+
+/* Set the following definitions to 1 to include the API function, or zero
+to exclude the API function.  The port needs xTaskGetCurrentTaskHandle() and
+vTaskDelete(). */
+
+#define INCLUDE_xTaskGetCurrentTaskHandle		1
+#define INCLUDE_vTaskPrioritySet		1
+#define INCLUDE_uxTaskPriorityGet		1
+#define INCLUDE_vTaskDelete				1
+#define INCLUDE_vTaskCleanUpResources	0
+#define INCLUDE_vTaskSuspend			1
+#define INCLUDE_vTaskDelayUntil			1
+#define INCLUDE_vTaskDelay				1
+#define INCLUDE_xTaskGetSchedulerState	1
+#define INCLUDE_xTaskAbortDelay			1
+#define INCLUDE_eTaskGetState			1
+#define INCLUDE_xSemaphoreGetMutexHolder	1
+#define INCLUDE_xTimerPendFunctionCall	1
+
+/* A failed assertion reports where it failed and ends the program. */
+void vAssertCalled( const char *pcFile, unsigned long ulLine );
+#define configASSERT( x ) if( ( x ) == 0 ) vAssertCalled( __FILE__, __LINE__ )
+
+/* The kernel benchmarks are timed in nanoseconds of the monotonic clock. */
+uint32_t ulGetHostNanoseconds( void );
+#define benchINIT_CYCLE_COUNTER()
+#define benchGET_CYCLE_COUNT()		ulGetHostNanoseconds()
+
+//Milliseconds to OS Ticks
+#define M2T(X) ((unsigned int)(X*(configTICK_RATE_HZ/1000.0)))
+#define assert_param(X)
+
+#endif /* FREERTOS_CONFIG_H */
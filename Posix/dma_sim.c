@@ -0,0 +1,374 @@
+/*
+	SIMULATED DMA CONTROLLER FOR THE HOST BUILD.
+
+	Implements the DMAServiceHardware_t of dma_service.h with seven simulated
+	channels, so the DMA service, and the drivers that use it, can be tested
+	on the host.  A started channel moves data only when told to, by
+	vDMASimRun(), or by vDMASimTick() from the tick hook at the rate set for
+	it, so a test decides exactly when each transfer gets to each point.
+
+	Each item moved is read from the source address and written to the
+	destination address, of the sizes and with the increments of the channel
+	configuration, as the channel would.  An item read from a peripheral can
+	instead come from a function connected to the channel, which stands in
+	for the peripheral.  The buffers must be below 4GB, as the addresses are
+	32 bits, which the host build arranges.
+
+	As the channel moves items the half transfer and transfer complete
+	events occur at the points they do on the target, a circular channel
+	starting again from the beginning at the end of each lap and any other
+	channel stopping.  The events that occur in one call are reported to the
+	service by one call of vDMAServiceInterrupt(), as they would be if the
+	interrupt were held off while they occurred.
+*/
+
+/* Standard includes. */
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Library includes. */
+#include "stm32f10x_lib.h"
+
+/* Demo application includes. */
+#include "dma_service.h"
+#include "dma_sim.h"
+
+#define simNUM_CHANNELS			7
+
+/* The fields of the channel configuration register. */
+#define simCCR_DIR				( ( uint32_t ) 0x0010 )
+#define simCCR_CIRC				( ( uint32_t ) 0x0020 )
+#define simCCR_PINC				( ( uint32_t ) 0x0040 )
+#define simCCR_MINC				( ( uint32_t ) 0x0080 )
+#define simCCR_PSIZE_SHIFT		8
+#define simCCR_MSIZE_SHIFT		10
+#define simCCR_M2M				( ( uint32_t ) 0x4000 )
+
+/*-----------------------------------------------------------*/
+
+typedef struct xDMA_SIM_CHANNEL
+{
+	BaseType_t xEnabled;
+	BaseType_t xRunning;
+	const DMATransfer_t *pxTransfer;
+	uint32_t ulConfig;
+	uint32_t ulPeripheralAddress;	/* The next address on each side. */
+	uint32_t ulMemoryAddress;
+	uint16_t usRemaining;
+	uint32_t ulStarts;
+	uint32_t ulStops;
+	uint32_t ulItemsPerTick;
+	DMASimReadFunction_t pxReadFunction;
+} DMASimChannel_t;
+
+/*-----------------------------------------------------------*/
+
+static void prvEnable( UBaseType_t uxChannel, BaseType_t xEnable );
+static void prvStart( UBaseType_t uxChannel, const DMATransfer_t *pxTransfer, uint32_t ulConfig );
+static void prvStop( UBaseType_t uxChannel );
+static uint16_t prvRemaining( UBaseType_t uxChannel );
+
+/*
+ * Moves one item on pxChannel, and returns the events that causes.
+ */
+static uint32_t prvMoveItem( UBaseType_t uxChannel, DMASimChannel_t *pxChannel );
+
+/*
+ * Reads and writes an item of 2 to the power uxSize bytes at ulAddress.
+ */
+static uint32_t prvRead( uint32_t ulAddress, UBaseType_t uxSize );
+static void prvWrite( uint32_t ulAddress, UBaseType_t uxSize, uint32_t ulValue );
+
+/*
+ * Reports ulEvents to the service, if they are enabled.
+ */
+static void prvInterrupt( UBaseType_t uxChannel, uint32_t ulEvents );
+
+/*-----------------------------------------------------------*/
+
+const DMAServiceHardware_t xDMASimHardware =
+{
+	prvEnable,
+	prvStart,
+	prvStop,
+	prvRemaining
+};
+
+static DMASimChannel_t xChannels[ simNUM_CHANNELS ];
+
+/*-----------------------------------------------------------*/
+
+void vDMASimReset( void )
+{
+	memset( ( void * ) xChannels, 0x00, sizeof( xChannels ) );
+}
+/*-----------------------------------------------------------*/
+
+void vDMASimConnect( UBaseType_t uxChannel, DMASimReadFunction_t pxReadFunction )
+{
+	configASSERT( ( uxChannel >= 1 ) && ( uxChannel <= simNUM_CHANNELS ) );
+
+	xChannels[ uxChannel - 1 ].pxReadFunction = pxReadFunction;
+}
+/*-----------------------------------------------------------*/
+
+void vDMASimSetRate( UBaseType_t uxChannel, uint32_t ulItemsPerTick )
+{
+	configASSERT( ( uxChannel >= 1 ) && ( uxChannel <= simNUM_CHANNELS ) );
+
+	xChannels[ uxChannel - 1 ].ulItemsPerTick = ulItemsPerTick;
+}
+/*-----------------------------------------------------------*/
+
+void vDMASimRun( UBaseType_t uxChannel, uint32_t ulItems )
+{
+DMASimChannel_t *pxChannel;
+uint32_t ulEvents = 0;
+UBaseType_t uxSavedInterruptStatus;
+
+	configASSERT( ( uxChannel >= 1 ) && ( uxChannel <= simNUM_CHANNELS ) );
+	pxChannel = &( xChannels[ uxChannel - 1 ] );
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		while( ( ulItems > 0UL ) && ( pxChannel->xRunning != pdFALSE ) )
+		{
+			ulEvents |= prvMoveItem( uxChannel, pxChannel );
+			ulItems--;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	prvInterrupt( uxChannel, ulEvents );
+}
+/*-----------------------------------------------------------*/
+
+void vDMASimError( UBaseType_t uxChannel )
+{
+UBaseType_t uxSavedInterruptStatus;
+
+	configASSERT( ( uxChannel >= 1 ) && ( uxChannel <= simNUM_CHANNELS ) );
+
+	/* The channel disables itself on an error. */
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		xChannels[ uxChannel - 1 ].xRunning = pdFALSE;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	prvInterrupt( uxChannel, dmaserviceEVENT_ERROR );
+}
+/*-----------------------------------------------------------*/
+
+void vDMASimTick( void )
+{
+UBaseType_t x;
+
+	for( x = 1; x <= simNUM_CHANNELS; x++ )
+	{
+		if( xChannels[ x - 1 ].ulItemsPerTick != 0UL )
+		{
+			vDMASimRun( x, xChannels[ x - 1 ].ulItemsPerTick );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDMASimEnabled( UBaseType_t uxChannel )
+{
+	return xChannels[ uxChannel - 1 ].xEnabled;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDMASimRunning( UBaseType_t uxChannel )
+{
+	return xChannels[ uxChannel - 1 ].xRunning;
+}
+/*-----------------------------------------------------------*/
+
+const DMATransfer_t *pxDMASimTransfer( UBaseType_t uxChannel )
+{
+	return xChannels[ uxChannel - 1 ].pxTransfer;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulDMASimConfig( UBaseType_t uxChannel )
+{
+	return xChannels[ uxChannel - 1 ].ulConfig;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulDMASimStarts( UBaseType_t uxChannel )
+{
+	return xChannels[ uxChannel - 1 ].ulStarts;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulDMASimStops( UBaseType_t uxChannel )
+{
+	return xChannels[ uxChannel - 1 ].ulStops;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEnable( UBaseType_t uxChannel, BaseType_t xEnable )
+{
+	configASSERT( ( uxChannel >= 1 ) && ( uxChannel <= simNUM_CHANNELS ) );
+
+	if( xEnable == pdFALSE )
+	{
+		prvStop( uxChannel );
+	}
+
+	xChannels[ uxChannel - 1 ].xEnabled = xEnable;
+}
+/*-----------------------------------------------------------*/
+
+static void prvStart( UBaseType_t uxChannel, const DMATransfer_t *pxTransfer, uint32_t ulConfig )
+{
+DMASimChannel_t *pxChannel;
+
+	configASSERT( ( uxChannel >= 1 ) && ( uxChannel <= simNUM_CHANNELS ) );
+	pxChannel = &( xChannels[ uxChannel - 1 ] );
+
+	pxChannel->pxTransfer = pxTransfer;
+	pxChannel->ulConfig = ulConfig;
+	pxChannel->ulPeripheralAddress = pxTransfer->ulPeripheralAddress;
+	pxChannel->ulMemoryAddress = pxTransfer->ulMemoryAddress;
+	pxChannel->usRemaining = pxTransfer->usCount;
+	pxChannel->xRunning = pdTRUE;
+	pxChannel->ulStarts++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvStop( UBaseType_t uxChannel )
+{
+	configASSERT( ( uxChannel >= 1 ) && ( uxChannel <= simNUM_CHANNELS ) );
+
+	xChannels[ uxChannel - 1 ].xRunning = pdFALSE;
+	xChannels[ uxChannel - 1 ].ulStops++;
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t prvRemaining( UBaseType_t uxChannel )
+{
+	configASSERT( ( uxChannel >= 1 ) && ( uxChannel <= simNUM_CHANNELS ) );
+
+	return xChannels[ uxChannel - 1 ].usRemaining;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvMoveItem( UBaseType_t uxChannel, DMASimChannel_t *pxChannel )
+{
+const UBaseType_t uxPeripheralSize = ( UBaseType_t ) ( ( pxChannel->ulConfig >> simCCR_PSIZE_SHIFT ) & 0x03UL );
+const UBaseType_t uxMemorySize = ( UBaseType_t ) ( ( pxChannel->ulConfig >> simCCR_MSIZE_SHIFT ) & 0x03UL );
+const uint16_t usCount = pxChannel->pxTransfer->usCount;
+uint32_t ulValue, ulEvents = 0;
+
+	/* The peripheral address is the source of a memory to memory transfer. */
+	if( ( pxChannel->ulConfig & simCCR_DIR ) == 0UL )
+	{
+		if( ( pxChannel->pxReadFunction != NULL ) && ( ( pxChannel->ulConfig & simCCR_M2M ) == 0UL ) )
+		{
+			ulValue = pxChannel->pxReadFunction( uxChannel );
+		}
+		else
+		{
+			ulValue = prvRead( pxChannel->ulPeripheralAddress, uxPeripheralSize );
+		}
+
+		prvWrite( pxChannel->ulMemoryAddress, uxMemorySize, ulValue );
+	}
+	else
+	{
+		ulValue = prvRead( pxChannel->ulMemoryAddress, uxMemorySize );
+		prvWrite( pxChannel->ulPeripheralAddress, uxPeripheralSize, ulValue );
+	}
+
+	if( ( pxChannel->ulConfig & simCCR_PINC ) != 0UL )
+	{
+		pxChannel->ulPeripheralAddress += 1UL << uxPeripheralSize;
+	}
+
+	if( ( pxChannel->ulConfig & simCCR_MINC ) != 0UL )
+	{
+		pxChannel->ulMemoryAddress += 1UL << uxMemorySize;
+	}
+
+	pxChannel->usRemaining--;
+
+	if( pxChannel->usRemaining == ( usCount / 2U ) )
+	{
+		ulEvents |= dmaserviceEVENT_HALF;
+	}
+
+	if( pxChannel->usRemaining == 0U )
+	{
+		ulEvents |= dmaserviceEVENT_COMPLETE;
+
+		if( ( pxChannel->ulConfig & simCCR_CIRC ) != 0UL )
+		{
+			pxChannel->ulPeripheralAddress = pxChannel->pxTransfer->ulPeripheralAddress;
+			pxChannel->ulMemoryAddress = pxChannel->pxTransfer->ulMemoryAddress;
+			pxChannel->usRemaining = usCount;
+		}
+		else
+		{
+			pxChannel->xRunning = pdFALSE;
+		}
+	}
+
+	return ulEvents;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRead( uint32_t ulAddress, UBaseType_t uxSize )
+{
+uint32_t ulValue;
+
+	switch( uxSize )
+	{
+		case 0 :	ulValue = *( ( volatile uint8_t * ) ulAddress );
+					break;
+
+		case 1 :	ulValue = *( ( volatile uint16_t * ) ulAddress );
+					break;
+
+		default :	ulValue = *( ( volatile uint32_t * ) ulAddress );
+					break;
+	}
+
+	return ulValue;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWrite( uint32_t ulAddress, UBaseType_t uxSize, uint32_t ulValue )
+{
+	switch( uxSize )
+	{
+		case 0 :	*( ( volatile uint8_t * ) ulAddress ) = ( uint8_t ) ulValue;
+					break;
+
+		case 1 :	*( ( volatile uint16_t * ) ulAddress ) = ( uint16_t ) ulValue;
+					break;
+
+		default :	*( ( volatile uint32_t * ) ulAddress ) = ulValue;
+					break;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvInterrupt( UBaseType_t uxChannel, uint32_t ulEvents )
+{
+	/* The interrupt enable bits of the configuration are the bits of the
+	events they enable. */
+	ulEvents &= xChannels[ uxChannel - 1 ].ulConfig;
+
+	if( ( ulEvents != 0UL ) && ( xChannels[ uxChannel - 1 ].xEnabled != pdFALSE ) )
+	{
+		vDMAServiceInterrupt( uxChannel, ulEvents );
+	}
+}
+/*-----------------------------------------------------------*/
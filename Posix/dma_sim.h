@@ -0,0 +1,68 @@
+/*
+	Simulated DMA controller for the host build.  See dma_sim.c.
+*/
+
+#ifndef DMA_SIM_H
+#define DMA_SIM_H
+
+#include "dma_service.h"
+
+/* The function a simulated channel reads each item from, in place of the
+peripheral register, when it moves data from a peripheral.  Called from
+vDMASimRun(). */
+typedef uint32_t ( *DMASimReadFunction_t )( UBaseType_t uxChannel );
+
+/* The simulation, to pass to vDMAServiceInit(). */
+extern const DMAServiceHardware_t xDMASimHardware;
+
+/*
+ * Resets every channel and clears the counts.
+ */
+void vDMASimReset( void );
+
+/*
+ * Makes uxChannel (1 to 7) read each item it moves from a peripheral from
+ * pxReadFunction, or, if it is NULL, from the peripheral address.
+ */
+void vDMASimConnect( UBaseType_t uxChannel, DMASimReadFunction_t pxReadFunction );
+
+/*
+ * Sets the number of items uxChannel moves each tick, 0 (the default) to only
+ * move those passed to vDMASimRun().
+ */
+void vDMASimSetRate( UBaseType_t uxChannel, uint32_t ulItemsPerTick );
+
+/*
+ * Moves up to ulItems items on uxChannel, stopping at the end of a transfer
+ * that is not circular, then calls vDMAServiceInterrupt() with the events
+ * that have occurred, if the channel's interrupt is enabled and the events
+ * are enabled in its configuration.  Called by the test, as the peripheral
+ * makes its requests, or from the tick hook through vDMASimTick().
+ */
+void vDMASimRun( UBaseType_t uxChannel, uint32_t ulItems );
+
+/*
+ * Raises a transfer error on uxChannel, which stops it, and calls
+ * vDMAServiceInterrupt() as vDMASimRun() does.
+ */
+void vDMASimError( UBaseType_t uxChannel );
+
+/*
+ * Moves a tick's worth of items on each channel with a rate set.  Called from
+ * the tick hook.
+ */
+void vDMASimTick( void );
+
+/*
+ * The state of uxChannel: whether its interrupt is enabled, whether it is
+ * moving data, the descriptor and configuration it was last started with,
+ * and the number of times it has been started and stopped.
+ */
+BaseType_t xDMASimEnabled( UBaseType_t uxChannel );
+BaseType_t xDMASimRunning( UBaseType_t uxChannel );
+const DMATransfer_t *pxDMASimTransfer( UBaseType_t uxChannel );
+uint32_t ulDMASimConfig( UBaseType_t uxChannel );
+uint32_t ulDMASimStarts( UBaseType_t uxChannel );
+uint32_t ulDMASimStops( UBaseType_t uxChannel );
+
+#endif /* DMA_SIM_H */
@@ -0,0 +1,273 @@
+/*
+	SIMULATED NOR FLASH FOR THE HOST BUILD.
+
+	Holds the contents of a NOR flash with the pages and sectors of the M25P64
+	in a file mapped into memory, so what is stored survives the program ending
+	and can be opened again, as the flash survives a reset of the target.
+
+	The flash behaves as the chip does:
+
+	+ programming can only clear bits, so a byte programmed twice holds the AND
+	  of the two values;
+
+	+ a page program that runs past the end of its page wraps to the start of
+	  the same page, and vFlashSimProgram() splits its data at page boundaries
+	  as SPI_FLASH_BufferWrite() does, so never causes this;
+
+	+ a sector erase sets every byte of the sector to 0xFF.
+
+	A power failure can be arranged to happen after a given number of bytes
+	have been programmed or pages erased.  The operation it interrupts is left
+	part done - the bytes before it programmed and those after it untouched, or
+	the pages of the sector before it erased and those after it holding what
+	they held - and nothing more is programmed or erased until the power is
+	restored.  Reading works throughout, so the code under test runs on to the
+	end of what it was doing, and is then opened again on what the flash
+	holds, as it would be after the target is reset.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+
+/* Demo application includes. */
+#include "flash_sim.h"
+
+/* The most sectors whose erases are counted. */
+#define simMAX_SECTORS				128UL
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Programs up to a page of data, wrapping within the page as the chip does.
+ */
+static void prvPageProgram( uint32_t ulAddress, const uint8_t *pucData, uint32_t ulLength );
+
+/*
+ * Returns pdTRUE if the power is on for another step, counting the step, or
+ * pdFALSE if the power has failed.
+ */
+static BaseType_t prvStep( void );
+
+/*-----------------------------------------------------------*/
+
+static uint8_t *pucFlash = NULL;
+static uint32_t ulFlashSize = 0;
+
+static uint32_t ulSteps = 0;
+static uint32_t ulStepsToFailure = 0;
+static BaseType_t xFailureArranged = pdFALSE;
+static BaseType_t xPowerFailed = pdFALSE;
+
+static uint32_t ulErases[ simMAX_SECTORS ];
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xFlashSimOpen( const char *pcFileName, uint32_t ulSize )
+{
+struct stat xStat;
+void *pvMapped;
+int iFile;
+BaseType_t xCreated = pdFALSE;
+
+	configASSERT( pucFlash == NULL );
+	configASSERT( ( ulSize > 0UL ) && ( ( ulSize % flashsimSECTOR_SIZE ) == 0UL ) && ( ( ulSize / flashsimSECTOR_SIZE ) <= simMAX_SECTORS ) );
+
+	iFile = open( pcFileName, O_RDWR | O_CREAT, 0644 );
+
+	if( iFile < 0 )
+	{
+		return pdFAIL;
+	}
+
+	if( ( fstat( iFile, &xStat ) != 0 ) || ( xStat.st_size != ( off_t ) ulSize ) )
+	{
+		/* New, or the size of a different flash, so start erased. */
+		if( ftruncate( iFile, ( off_t ) ulSize ) != 0 )
+		{
+			close( iFile );
+			return pdFAIL;
+		}
+
+		xCreated = pdTRUE;
+	}
+
+	pvMapped = mmap( NULL, ulSize, PROT_READ | PROT_WRITE, MAP_SHARED, iFile, 0 );
+	close( iFile );
+
+	if( pvMapped == MAP_FAILED )
+	{
+		return pdFAIL;
+	}
+
+	pucFlash = ( uint8_t * ) pvMapped;
+	ulFlashSize = ulSize;
+
+	if( xCreated != pdFALSE )
+	{
+		memset( ( void * ) pucFlash, 0xff, ulSize );
+	}
+
+	ulSteps = 0;
+	xFailureArranged = pdFALSE;
+	xPowerFailed = pdFALSE;
+	memset( ( void * ) ulErases, 0x00, sizeof( ulErases ) );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vFlashSimClose( void )
+{
+	configASSERT( pucFlash != NULL );
+
+	( void ) msync( ( void * ) pucFlash, ulFlashSize, MS_SYNC );
+	( void ) munmap( ( void * ) pucFlash, ulFlashSize );
+	pucFlash = NULL;
+	ulFlashSize = 0;
+}
+/*-----------------------------------------------------------*/
+
+void vFlashSimRead( uint32_t ulAddress, uint8_t *pucBuffer, uint32_t ulLength )
+{
+	configASSERT( ( pucFlash != NULL ) && ( ulAddress <= ulFlashSize ) && ( ulLength <= ( ulFlashSize - ulAddress ) ) );
+
+	memcpy( ( void * ) pucBuffer, ( const void * ) &( pucFlash[ ulAddress ] ), ulLength );
+}
+/*-----------------------------------------------------------*/
+
+void vFlashSimProgram( uint32_t ulAddress, const uint8_t *pucData, uint32_t ulLength )
+{
+uint32_t ulChunk;
+
+	configASSERT( ( pucFlash != NULL ) && ( ulAddress <= ulFlashSize ) && ( ulLength <= ( ulFlashSize - ulAddress ) ) );
+
+	/* As SPI_FLASH_BufferWrite(), a page program for each page touched. */
+	while( ulLength > 0UL )
+	{
+		ulChunk = flashsimPAGE_SIZE - ( ulAddress % flashsimPAGE_SIZE );
+
+		if( ulChunk > ulLength )
+		{
+			ulChunk = ulLength;
+		}
+
+		prvPageProgram( ulAddress, pucData, ulChunk );
+		ulAddress += ulChunk;
+		pucData += ulChunk;
+		ulLength -= ulChunk;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vFlashSimEraseSector( uint32_t ulAddress )
+{
+uint32_t ulPage;
+
+	configASSERT( ( pucFlash != NULL ) && ( ulAddress < ulFlashSize ) );
+
+	ulAddress -= ulAddress % flashsimSECTOR_SIZE;
+
+	/* An erase interrupted by a power failure leaves the pages not yet
+	reached as they were. */
+	for( ulPage = 0; ulPage < ( flashsimSECTOR_SIZE / flashsimPAGE_SIZE ); ulPage++ )
+	{
+		if( prvStep() == pdFALSE )
+		{
+			return;
+		}
+
+		memset( ( void * ) &( pucFlash[ ulAddress + ( ulPage * flashsimPAGE_SIZE ) ] ), 0xff, flashsimPAGE_SIZE );
+	}
+
+	ulErases[ ulAddress / flashsimSECTOR_SIZE ]++;
+}
+/*-----------------------------------------------------------*/
+
+void vFlashSimPowerFailAfter( uint32_t ulStepsFromNow )
+{
+	ulStepsToFailure = ulStepsFromNow;
+	xFailureArranged = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vFlashSimPowerOn( void )
+{
+	xFailureArranged = pdFALSE;
+	xPowerFailed = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xFlashSimPowerFailed( void )
+{
+	return xPowerFailed;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulFlashSimSteps( void )
+{
+	return ulSteps;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulFlashSimErases( uint32_t ulAddress )
+{
+	configASSERT( ulAddress < ulFlashSize );
+
+	return ulErases[ ulAddress / flashsimSECTOR_SIZE ];
+}
+/*-----------------------------------------------------------*/
+
+static void prvPageProgram( uint32_t ulAddress, const uint8_t *pucData, uint32_t ulLength )
+{
+uint32_t ulPage = ulAddress - ( ulAddress % flashsimPAGE_SIZE );
+uint32_t ulOffset = ulAddress % flashsimPAGE_SIZE;
+
+	configASSERT( ulLength <= flashsimPAGE_SIZE );
+
+	while( ulLength > 0UL )
+	{
+		if( prvStep() == pdFALSE )
+		{
+			return;
+		}
+
+		/* Programming can only clear bits. */
+		pucFlash[ ulPage + ulOffset ] &= *pucData;
+		ulOffset = ( ulOffset + 1UL ) % flashsimPAGE_SIZE;
+		pucData++;
+		ulLength--;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvStep( void )
+{
+	if( xFailureArranged != pdFALSE )
+	{
+		if( ulStepsToFailure == 0UL )
+		{
+			xPowerFailed = pdTRUE;
+		}
+		else
+		{
+			ulStepsToFailure--;
+		}
+	}
+
+	if( xPowerFailed != pdFALSE )
+	{
+		return pdFALSE;
+	}
+
+	ulSteps++;
+
+	return pdTRUE;
+}
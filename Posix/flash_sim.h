@@ -0,0 +1,59 @@
+/*
+	Simulated NOR flash for the host build.  See flash_sim.c.
+*/
+
+#ifndef FLASH_SIM_H
+#define FLASH_SIM_H
+
+/* The page and sector sizes of the M25P64 driven by spi_flash.c. */
+#define flashsimPAGE_SIZE			256UL
+#define flashsimSECTOR_SIZE			0x10000UL
+
+/*
+ * Maps the file pcFileName as a flash of ulSize bytes, a multiple of the
+ * sector size.  A file that does not exist is created erased, one that does
+ * keeps what was programmed into it.  Returns pdFAIL if the file cannot be
+ * mapped.
+ */
+BaseType_t xFlashSimOpen( const char *pcFileName, uint32_t ulSize );
+
+/*
+ * Writes the flash back to its file and unmaps it.
+ */
+void vFlashSimClose( void );
+
+/*
+ * Read, program and erase the flash as SPI_FLASH_BufferRead(),
+ * SPI_FLASH_BufferWrite() and SPI_FLASH_SectorErase() do, so they can be
+ * the functions of a FlashKVDevice_t.
+ */
+void vFlashSimRead( uint32_t ulAddress, uint8_t *pucBuffer, uint32_t ulLength );
+void vFlashSimProgram( uint32_t ulAddress, const uint8_t *pucData, uint32_t ulLength );
+void vFlashSimEraseSector( uint32_t ulAddress );
+
+/*
+ * Makes the power fail once ulSteps more bytes have been programmed or pages
+ * erased.  Nothing is programmed or erased after that until the power is
+ * restored by vFlashSimPowerOn().
+ */
+void vFlashSimPowerFailAfter( uint32_t ulSteps );
+void vFlashSimPowerOn( void );
+
+/*
+ * Returns pdTRUE if the power has failed since it was last restored.
+ */
+BaseType_t xFlashSimPowerFailed( void );
+
+/*
+ * The bytes programmed and pages erased since the flash was opened, which is
+ * how far vFlashSimPowerFailAfter() counts.
+ */
+uint32_t ulFlashSimSteps( void );
+
+/*
+ * The number of times the sector holding ulAddress has been erased since the
+ * flash was opened.
+ */
+uint32_t ulFlashSimErases( uint32_t ulAddress );
+
+#endif /* FLASH_SIM_H */
@@ -0,0 +1,40 @@
+/*
+	The functions the host build of the demo needs that the target gets from
+	its hardware or does not need.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*-----------------------------------------------------------*/
+
+void vAssertCalled( const char *pcFile, unsigned long ulLine )
+{
+	taskDISABLE_INTERRUPTS();
+	fprintf( stderr, "ASSERT: %s:%lu\n", pcFile, ulLine );
+	abort();
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulGetHostNanoseconds( void )
+{
+struct timespec xNow;
+
+	/* Only the difference between two readings is used, so the count can
+	wrap. */
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+	return ( uint32_t ) ( ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec );
+}
+/*-----------------------------------------------------------*/
+
+__attribute__( ( weak ) ) void vApplicationTickHook( void )
+{
+	/* Programs that have work for the tick hook replace this one. */
+}
@@ -0,0 +1,478 @@
+/*
+	SIMULATED SPI2 AND LCD CONTROLLER FOR THE HOST BUILD.
+
+	Runs SPI2, the DMA channel 5 that serves it, and the controller of the
+	AM-240320LTNQW00H LCD on its control lines, so lcd.c can be tested on the
+	host without changes.  The LCD is held as lcdsimROWS rows of lcdsimCOLUMNS
+	pixels.
+
+	As in spi_sim.c, the registers are plain RAM, so the functions of
+	stm32f10x_spi.c that lcd.c calls are provided here, in place of the
+	library, and SPI_SendData() hands the frame to the controller at once.  The
+	control lines are read from the BSRR and BRR registers of GPIOB and GPIOD,
+	which GPIO_WriteBit() writes, before each frame.  lcd.c drives RS at most
+	once between two frames, so a pin set in either register gives its level.
+	NCS set in BSRR deselects the LCD, and set in BRR selects it, so a frame
+	with both set starts a new stream.  NWR is not read, so LCD_ReadReg() and
+	LCD_ReadRAM() are not supported.
+
+	DMA channel 5 moves pixels from vLCDSimTick(), called from the tick hook,
+	as many each tick as the SPI clock set by the RCC registers and the baud
+	rate prescaler carries, once it is enabled with SPI2 DR as its peripheral
+	and the Tx DMA request of SPI2 is enabled.  At the end of a transfer the
+	transfer complete flag of the channel is raised, and
+	DMAChannel5_IRQHandler() called if its interrupt is enabled.  The flags
+	written to IFCR are cleared once it returns and before each tick's pixels
+	are moved.
+
+	The controller carries out the 16 bit frames it receives as the driver
+	expects:
+
+	+ with RS low a frame writes its low byte to the register in its high
+	  byte, and R66, R67 and R68 set the row and column of the RAM address;
+
+	+ with RS high a frame writes a pixel to the RAM address, which then moves
+	  one column towards column 0, or from column 0 to the last column of the
+	  next row, wrapping after the last row, as with the entry mode LCD_Init()
+	  sets.  The entry modes set by LCD_SetDisplayWindow() and LCD_DrawBMP()
+	  are not simulated.
+*/
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Library includes. */
+#include "stm32f10x_lib.h"
+#include "lcd.h"
+
+/* Demo application includes. */
+#include "lcd_sim.h"
+
+/* Bits of the SPI CR1 and CR2 registers. */
+#define simCR1_CLEAR_MASK		( ( u16 ) 0x3040 )
+#define simCR1_SPE				( ( u16 ) 0x0040 )
+#define simCR1_BR_SHIFT			3
+#define simCR1_BR_MASK			( ( u16 ) 0x0007 )
+
+/* Bits of the DMA channel CCR register. */
+#define simCCR_EN				( ( u32 ) 0x0001 )
+#define simCCR_TCIE				( ( u32 ) 0x0002 )
+#define simCCR_DIR				( ( u32 ) 0x0010 )
+#define simCCR_MINC				( ( u32 ) 0x0080 )
+#define simCCR_MSIZE_16			( ( u32 ) 0x0400 )
+
+/* The flags of one channel in the DMA ISR register, shifted by four bits for
+each channel. */
+#define simISR_GIF				( ( u32 ) 0x0001 )
+#define simISR_TCIF				( ( u32 ) 0x0002 )
+#define simISR_CHANNEL_FLAGS	( ( u32 ) 0x000F )
+#define simDMA_CHANNELS			7
+
+/* The shift of the flags of channel 5. */
+#define simTX_SHIFT				16U
+
+/* The registers that set the RAM address. */
+#define simREG_ROW				R66
+#define simREG_COLUMN_HIGH		R67
+#define simREG_COLUMN_LOW		R68
+
+/* The bits of one frame on the bus. */
+#define simBITS_PER_FRAME		16UL
+
+/*-----------------------------------------------------------*/
+
+/* The handler of the DMA interrupt, which the polled driver does not
+define. */
+extern void DMAChannel5_IRQHandler( void ) __attribute__( ( weak ) );
+
+/*
+ * Reads the control lines as they have been driven since they were last
+ * read.
+ */
+static void prvControlLines( void );
+
+/*
+ * Carries out one frame sent to the LCD.
+ */
+static void prvFrame( u16 usFrame );
+
+/*
+ * Clears the DMA flags written to IFCR.
+ */
+static void prvClearFlags( void );
+
+/*-----------------------------------------------------------*/
+
+/* The pixels of the LCD, and the RAM address. */
+static uint16_t usPixels[ lcdsimROWS ][ lcdsimCOLUMNS ];
+static uint32_t ulRow = 0;
+static uint32_t ulColumn = 0;
+
+/* The levels of the control lines, and whether the LCD has been selected
+since the last pixel was written. */
+static BaseType_t xSelected = pdFALSE;
+static BaseType_t xRegisterSelect = pdFALSE;
+static BaseType_t xNewStream = pdFALSE;
+
+/* The SPI clock set by SPI_Init(), in Hz. */
+static uint32_t ulClock = 0;
+
+/* The state of the DMA transfer, which the registers do not hold. */
+static BaseType_t xTransferActive = pdFALSE;
+static u32 ulTxCount = 0;
+
+/* The counts returned by the functions of lcd_sim.h. */
+static uint32_t ulPixelsWritten = 0;
+static uint32_t ulStreams = 0;
+static uint32_t ulTransfers = 0;
+static uint32_t ulInterrupts = 0;
+static uint32_t ulFaults = 0;
+
+/*-----------------------------------------------------------*/
+
+void vLCDSimTick( void )
+{
+DMA_Channel_TypeDef * const pxTx = DMA_Channel5;
+const u32 ulDataRegister = ( u32 ) ( uintptr_t ) &( SPI2->DR );
+uint32_t ulFrames;
+u32 ulOffset;
+
+	prvClearFlags();
+
+	if( ( pxTx->CCR & simCCR_EN ) == 0 )
+	{
+		/* A transfer ends when the channel is disabled. */
+		xTransferActive = pdFALSE;
+		return;
+	}
+
+	if( ( ( SPI2->CR2 & SPI_DMAReq_Tx ) == 0 ) || ( ( pxTx->CCR & simCCR_DIR ) == 0 ) || ( pxTx->CPAR != ulDataRegister ) )
+	{
+		return;
+	}
+
+	configASSERT( ( pxTx->CCR & simCCR_MSIZE_16 ) != 0 );
+
+	if( xTransferActive == pdFALSE )
+	{
+		if( pxTx->CNDTR == 0 )
+		{
+			return;
+		}
+
+		/* The channel has been enabled with a new count since the last
+		transfer ended. */
+		xTransferActive = pdTRUE;
+		ulTxCount = pxTx->CNDTR;
+		ulTransfers++;
+	}
+
+	for( ulFrames = ulClock / ( simBITS_PER_FRAME * configTICK_RATE_HZ ); ( ulFrames > 0UL ) && ( pxTx->CNDTR != 0 ); ulFrames-- )
+	{
+		ulOffset = ( ( pxTx->CCR & simCCR_MINC ) != 0 ) ? ( ulTxCount - pxTx->CNDTR ) : 0;
+
+		prvControlLines();
+		prvFrame( ( ( const u16 * ) ( uintptr_t ) pxTx->CMAR )[ ulOffset ] );
+		pxTx->CNDTR--;
+	}
+
+	if( pxTx->CNDTR == 0 )
+	{
+		xTransferActive = pdFALSE;
+		DMA->ISR |= ( simISR_TCIF | simISR_GIF ) << simTX_SHIFT;
+
+		if( ( ( pxTx->CCR & simCCR_TCIE ) != 0 ) && ( DMAChannel5_IRQHandler != NULL ) )
+		{
+			ulInterrupts++;
+			DMAChannel5_IRQHandler();
+			prvClearFlags();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vLCDSimGetFrame( uint16_t *pusFrame )
+{
+	taskENTER_CRITICAL();
+	{
+		memcpy( ( void * ) pusFrame, ( const void * ) usPixels, sizeof( usPixels ) );
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vLCDSimSetFrame( uint16_t usColor )
+{
+uint32_t ulPixel;
+
+	taskENTER_CRITICAL();
+	{
+		for( ulPixel = 0; ulPixel < ( lcdsimROWS * lcdsimCOLUMNS ); ulPixel++ )
+		{
+			usPixels[ ulPixel / lcdsimCOLUMNS ][ ulPixel % lcdsimCOLUMNS ] = usColor;
+		}
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulLCDSimPixels( void )
+{
+uint32_t ulReturn;
+
+	taskENTER_CRITICAL();
+	{
+		ulReturn = ulPixelsWritten;
+	}
+	taskEXIT_CRITICAL();
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulLCDSimStreams( void )
+{
+uint32_t ulReturn;
+
+	taskENTER_CRITICAL();
+	{
+		ulReturn = ulStreams;
+	}
+	taskEXIT_CRITICAL();
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulLCDSimTransfers( void )
+{
+uint32_t ulReturn;
+
+	taskENTER_CRITICAL();
+	{
+		ulReturn = ulTransfers;
+	}
+	taskEXIT_CRITICAL();
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulLCDSimInterrupts( void )
+{
+uint32_t ulReturn;
+
+	taskENTER_CRITICAL();
+	{
+		ulReturn = ulInterrupts;
+	}
+	taskEXIT_CRITICAL();
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulLCDSimFaults( void )
+{
+uint32_t ulReturn;
+
+	taskENTER_CRITICAL();
+	{
+		ulReturn = ulFaults;
+	}
+	taskEXIT_CRITICAL();
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+void SPI_Init( SPI_TypeDef *SPIx, SPI_InitTypeDef *SPI_InitStruct )
+{
+RCC_ClocksTypeDef xClocks;
+u16 usCR1;
+
+	configASSERT( ( SPIx == SPI2 ) && ( SPI_InitStruct->SPI_DataSize == SPI_DataSize_16b ) );
+
+	/* As the library does. */
+	usCR1 = SPIx->CR1 & simCR1_CLEAR_MASK;
+	usCR1 |= ( u16 ) ( ( u32 ) SPI_InitStruct->SPI_Direction | SPI_InitStruct->SPI_Mode |
+						SPI_InitStruct->SPI_DataSize | SPI_InitStruct->SPI_CPOL |
+						SPI_InitStruct->SPI_CPHA | SPI_InitStruct->SPI_NSS |
+						SPI_InitStruct->SPI_BaudRatePrescaler | SPI_InitStruct->SPI_FirstBit );
+	SPIx->CR1 = usCR1;
+	SPIx->CRCPR = SPI_InitStruct->SPI_CRCPolynomial;
+
+	/* SPI2 is clocked by PCLK1, divided by 2 to the power BR + 1. */
+	RCC_GetClocksFreq( &xClocks );
+	ulClock = xClocks.PCLK1_Frequency >> ( ( ( usCR1 >> simCR1_BR_SHIFT ) & simCR1_BR_MASK ) + 1U );
+}
+/*-----------------------------------------------------------*/
+
+void SPI_Cmd( SPI_TypeDef *SPIx, FunctionalState NewState )
+{
+	if( NewState != DISABLE )
+	{
+		SPIx->CR1 |= simCR1_SPE;
+		SPIx->SR |= SPI_FLAG_TXE;
+	}
+	else
+	{
+		SPIx->CR1 &= ( u16 ) ~simCR1_SPE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void SPI_DMACmd( SPI_TypeDef *SPIx, u16 SPI_DMAReq, FunctionalState NewState )
+{
+	if( NewState != DISABLE )
+	{
+		SPIx->CR2 |= SPI_DMAReq;
+	}
+	else
+	{
+		SPIx->CR2 &= ( u16 ) ~SPI_DMAReq;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void SPI_SendData( SPI_TypeDef *SPIx, u16 Data )
+{
+	configASSERT( ( SPIx == SPI2 ) && ( ( SPIx->CR1 & simCR1_SPE ) != 0 ) && ( ulClock != 0UL ) );
+
+	/* The tick must not move pixels part way through this frame. */
+	taskENTER_CRITICAL();
+	{
+		prvControlLines();
+		prvFrame( Data );
+		SPIx->DR = 0;
+		SPIx->SR |= SPI_FLAG_RXNE;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+u16 SPI_ReceiveData( SPI_TypeDef *SPIx )
+{
+	/* Reading the data register clears RXNE. */
+	SPIx->SR &= ( u16 ) ~SPI_FLAG_RXNE;
+
+	return SPIx->DR;
+}
+/*-----------------------------------------------------------*/
+
+FlagStatus SPI_GetFlagStatus( SPI_TypeDef *SPIx, u16 SPI_FLAG )
+{
+	return ( ( SPIx->SR & SPI_FLAG ) != 0 ) ? SET : RESET;
+}
+/*-----------------------------------------------------------*/
+
+static void prvControlLines( void )
+{
+	if( ( GPIOD->BSRR & CtrlPin_RS ) != 0 )
+	{
+		GPIOD->BSRR &= ~( u32 ) CtrlPin_RS;
+		xRegisterSelect = pdTRUE;
+	}
+
+	if( ( GPIOD->BRR & CtrlPin_RS ) != 0 )
+	{
+		GPIOD->BRR &= ~( u32 ) CtrlPin_RS;
+		xRegisterSelect = pdFALSE;
+	}
+
+	if( ( GPIOB->BSRR & CtrlPin_NCS ) != 0 )
+	{
+		GPIOB->BSRR &= ~( u32 ) CtrlPin_NCS;
+		xSelected = pdFALSE;
+	}
+
+	if( ( GPIOB->BRR & CtrlPin_NCS ) != 0 )
+	{
+		GPIOB->BRR &= ~( u32 ) CtrlPin_NCS;
+		xSelected = pdTRUE;
+		xNewStream = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvFrame( u16 usFrame )
+{
+const uint8_t ucValue = ( uint8_t ) usFrame;
+
+	if( xSelected == pdFALSE )
+	{
+		ulFaults++;
+		return;
+	}
+
+	if( xRegisterSelect == pdFALSE )
+	{
+		switch( usFrame >> 8 )
+		{
+			case simREG_ROW:
+				ulRow = ucValue;
+				break;
+
+			case simREG_COLUMN_HIGH:
+				ulColumn = ( ( uint32_t ) ( ucValue & 0x01U ) << 8 ) | ( ulColumn & 0xFFUL );
+				break;
+
+			case simREG_COLUMN_LOW:
+				ulColumn = ( ulColumn & 0x100UL ) | ucValue;
+				break;
+
+			default:
+				break;
+		}
+
+		return;
+	}
+
+	if( xNewStream != pdFALSE )
+	{
+		xNewStream = pdFALSE;
+		ulStreams++;
+	}
+
+	/* An address outside the LCD writes nothing, but still moves on. */
+	if( ( ulRow < lcdsimROWS ) && ( ulColumn < lcdsimCOLUMNS ) )
+	{
+		usPixels[ ulRow ][ ulColumn ] = usFrame;
+	}
+
+	ulPixelsWritten++;
+
+	if( ulColumn == 0UL )
+	{
+		ulColumn = lcdsimCOLUMNS - 1UL;
+		ulRow = ( ulRow + 1UL ) % lcdsimROWS;
+	}
+	else
+	{
+		ulColumn--;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvClearFlags( void )
+{
+unsigned int uxShift;
+
+	/* Clearing the global flag of a channel clears each of its flags. */
+	for( uxShift = 0; uxShift < ( simDMA_CHANNELS * 4U ); uxShift += 4U )
+	{
+		if( ( DMA->IFCR & ( simISR_GIF << uxShift ) ) != 0 )
+		{
+			DMA->ISR &= ~( simISR_CHANNEL_FLAGS << uxShift );
+		}
+	}
+
+	DMA->ISR &= ~( DMA->IFCR );
+	DMA->IFCR = 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,39 @@
+/*
+	Simulated SPI2 and LCD controller for the host build.  See lcd_sim.c.
+*/
+
+#ifndef LCD_SIM_H
+#define LCD_SIM_H
+
+/* The rows, addressed by R66, and the columns, addressed by R67 and R68, of
+the LCD. */
+#define lcdsimROWS					240UL
+#define lcdsimCOLUMNS				320UL
+
+/*
+ * Moves one tick's worth of pixels on DMA channel 5, which serves SPI2, at the
+ * SPI clock, and runs the DMA interrupt when a transfer ends.  Called from the
+ * tick hook.
+ */
+void vLCDSimTick( void );
+
+/*
+ * vLCDSimGetFrame() copies the pixels of the LCD into pusFrame, lcdsimROWS
+ * rows of lcdsimCOLUMNS columns, and vLCDSimSetFrame() sets every pixel to
+ * usColor.
+ */
+void vLCDSimGetFrame( uint16_t *pusFrame );
+void vLCDSimSetFrame( uint16_t usColor );
+
+/*
+ * The pixels written to the LCD RAM, the streams of pixels written with the
+ * LCD selected once, the DMA transfers started on SPI2 and the interrupts
+ * taken at their ends, and the frames sent with the LCD not selected.
+ */
+uint32_t ulLCDSimPixels( void );
+uint32_t ulLCDSimStreams( void );
+uint32_t ulLCDSimTransfers( void );
+uint32_t ulLCDSimInterrupts( void );
+uint32_t ulLCDSimFaults( void );
+
+#endif /* LCD_SIM_H */
@@ -0,0 +1,445 @@
+/*
+	Tests the ADC sampling pipeline of adc_sample.c on the host build, with
+	DMA channel 1 simulated by dma_sim.c and the ADC replaced by a function
+	that returns the number of samples converted before, so every sample
+	shows where it was taken.
+
+	+ The blocks test moves one half of the buffer at a time, and each half
+	  must be received in turn holding the samples moved into it.
+
+	+ The overwritten test holds a block while the DMA fills the other half,
+	  so starts to refill the one held, which must then fail to be released.
+
+	+ The dropped test holds a block for more than a lap of the DMA, so the
+	  halves are not sent again and are counted as dropped, each overwritten
+	  block only once, and the gap must show in the sequence numbers.
+
+	+ The error test raises a transfer error, after which the sampling must
+	  stop and can be started again.
+
+	+ The pipeline test moves the samples in steps, filling a half every
+	  mainSTEPS_PER_BLOCK steps, and between steps receives the blocks and
+	  releases each a number of steps later, as a processing task would.
+	  Processing faster than that nothing must be lost, and slower the counts
+	  of dropped and overwritten blocks must match the gaps in the sequence
+	  numbers and the releases that failed.  The steps are taken by the test
+	  rather than the tick, so the result does not depend on how the host
+	  schedules the threads of the tasks.
+
+	The program ends the scheduler once the tests have run, and exits with 0 if
+	every check passed, or 1 after naming those that failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Library includes. */
+#include "stm32f10x_lib.h"
+
+/* Demo application includes. */
+#include "dma_service.h"
+#include "dma_sim.h"
+#include "adc_sample.h"
+
+/* The priority of the task that runs the tests. */
+#define mainTEST_TASK_PRIORITY			( tskIDLE_PRIORITY + 2 )
+
+/* The DMA channel that serves ADC1. */
+#define mainADC_CHANNEL					( 1 )
+
+/* The steps the simulated DMA takes to fill a half of the buffer in the
+pipeline test, and the blocks it is run for at each speed of processing. */
+#define mainSTEPS_PER_BLOCK				( 4 )
+#define mainPIPELINE_BLOCKS				( 40 )
+
+/* The longest a test waits for a block that should arrive. */
+#define mainMAX_WAIT					( pdMS_TO_TICKS( 100 ) )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Runs the tests.
+ */
+static void prvTestTask( void *pvParameters );
+
+/*
+ * The tests.
+ */
+static void prvBlocksTest( void );
+static void prvOverwrittenTest( void );
+static void prvDroppedTest( void );
+static void prvErrorTest( void );
+static void prvPipelineTest( uint32_t ulProcessingSteps );
+
+/*
+ * Starts the sampling, from the first sample.
+ */
+static void prvStart( void );
+
+/*
+ * Moves a half of the buffer of samples.
+ */
+static void prvFillBlock( void );
+
+/*
+ * Receives a block without waiting, checks it holds the samples moved into
+ * it, and that it has the sequence number ulSequence.
+ */
+static void prvReceive( ADCSampleBlock_t *pxBlock, uint32_t ulSequence );
+
+/*
+ * Returns pdTRUE if the samples of pxBlock are those converted for it.
+ */
+static BaseType_t prvSamplesCorrect( const ADCSampleBlock_t *pxBlock );
+
+/*
+ * Checks the counts returned by vADCSampleGetStats().
+ */
+static void prvCheckStats( uint32_t ulFilled, uint32_t ulDropped, uint32_t ulOverwritten, uint32_t ulErrors );
+
+/*
+ * Stands in for ADC1, returning the number of samples converted before.
+ */
+static uint32_t prvConvert( UBaseType_t uxChannel );
+
+/*
+ * Records a failed check.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* The samples prvConvert() has returned. */
+static volatile uint32_t ulConversions = 0;
+
+/* Whether any check failed. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE * 2, NULL, mainTEST_TASK_PRIORITY, NULL );
+
+	vTaskStartScheduler();
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All ADC sampling tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	vDMASimReset();
+	vDMASimConnect( mainADC_CHANNEL, prvConvert );
+	vDMAServiceInit( &xDMASimHardware );
+
+	prvBlocksTest();
+	prvOverwrittenTest();
+	prvDroppedTest();
+	prvErrorTest();
+
+	/* Processing a block in less than the time to fill one, and in more than
+	the time to fill both halves. */
+	prvPipelineTest( mainSTEPS_PER_BLOCK / 2 );
+	prvPipelineTest( ( mainSTEPS_PER_BLOCK * 2 ) + 2 );
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvBlocksTest( void )
+{
+ADCSampleBlock_t xFirst, xSecond, xThird;
+
+	prvStart();
+	prvCheck( xADCSampleReceive( &xFirst, 0 ) == pdFAIL, "no block before a half is filled", 0 );
+
+	prvFillBlock();
+	prvReceive( &xFirst, 1 );
+	prvCheck( xADCSampleRelease( &xFirst ), "first block released", 0 );
+
+	prvFillBlock();
+	prvReceive( &xSecond, 2 );
+	prvCheck( xSecond.pusSamples == ( xFirst.pusSamples + adcsampleBLOCK_SAMPLES ), "second block in the second half", 0 );
+	prvCheck( xADCSampleRelease( &xSecond ), "second block released", 0 );
+
+	/* The DMA returns to the first half. */
+	prvFillBlock();
+	prvReceive( &xThird, 3 );
+	prvCheck( xThird.pusSamples == xFirst.pusSamples, "third block in the first half", 0 );
+	prvCheck( xADCSampleRelease( &xThird ), "third block released", 0 );
+
+	prvCheckStats( 3, 0, 0, 0 );
+	vADCSampleStop();
+}
+/*-----------------------------------------------------------*/
+
+static void prvOverwrittenTest( void )
+{
+ADCSampleBlock_t xHeld, xOther;
+
+	prvStart();
+
+	prvFillBlock();
+	prvReceive( &xHeld, 1 );
+
+	/* The end of the other half starts the DMA on the half held. */
+	prvFillBlock();
+	prvCheckStats( 2, 0, 1, 0 );
+	prvCheck( xADCSampleRelease( &xHeld ) == pdFAIL, "overwritten block released", 0 );
+
+	prvReceive( &xOther, 2 );
+	prvCheck( xADCSampleRelease( &xOther ), "other block released", 0 );
+
+	/* Released in time, the next block is not counted. */
+	prvFillBlock();
+	prvReceive( &xHeld, 3 );
+	prvCheck( xADCSampleRelease( &xHeld ), "next block released", 0 );
+	prvFillBlock();
+	prvReceive( &xOther, 4 );
+	prvCheck( xADCSampleRelease( &xOther ), "block after released", 0 );
+
+	prvCheckStats( 4, 0, 1, 0 );
+	vADCSampleStop();
+}
+/*-----------------------------------------------------------*/
+
+static void prvDroppedTest( void )
+{
+ADCSampleBlock_t xHeld, xOther, xNext;
+
+	prvStart();
+
+	prvFillBlock();
+	prvReceive( &xHeld, 1 );
+
+	/* The second half is sent, and overwrites the first.  The first is then
+	filled again while still held, so is dropped, and the DMA moves on to the
+	second half, which has not been released either.  The second half is then
+	filled again, and dropped, starting the DMA on the first half a second
+	time, which does not count it as overwritten again. */
+	prvFillBlock();
+	prvFillBlock();
+	prvCheckStats( 3, 1, 2, 0 );
+	prvFillBlock();
+	prvCheckStats( 4, 2, 2, 0 );
+
+	prvCheck( xADCSampleRelease( &xHeld ) == pdFAIL, "held block released", 0 );
+	prvCheck( xADCSampleReceive( &xOther, 0 ), "second half sent", 0 );
+	prvCheck( xOther.ulSequence == 2, "second half sequence", xOther.ulSequence );
+	prvCheck( xADCSampleRelease( &xOther ) == pdFAIL, "unreceived block released", 0 );
+	prvCheck( xADCSampleReceive( &xNext, 0 ) == pdFAIL, "dropped blocks not sent", 0 );
+
+	/* The gap in the sequence shows the blocks dropped. */
+	prvFillBlock();
+	prvReceive( &xNext, 5 );
+	prvCheck( xADCSampleRelease( &xNext ), "block after the dropped ones released", 0 );
+
+	prvCheckStats( 5, 2, 2, 0 );
+	vADCSampleStop();
+}
+/*-----------------------------------------------------------*/
+
+static void prvErrorTest( void )
+{
+ADCSampleBlock_t xBlock;
+
+	prvStart();
+
+	prvFillBlock();
+	prvReceive( &xBlock, 1 );
+	( void ) xADCSampleRelease( &xBlock );
+
+	vDMASimError( mainADC_CHANNEL );
+	prvCheckStats( 1, 0, 0, 1 );
+	prvCheck( xDMASimRunning( mainADC_CHANNEL ) == pdFALSE, "sampling stopped by the error", 0 );
+
+	prvFillBlock();
+	prvCheck( xADCSampleReceive( &xBlock, 0 ) == pdFAIL, "no block after the error", 0 );
+
+	vADCSampleStop();
+	prvCheck( xDMASimEnabled( mainADC_CHANNEL ) == pdFALSE, "channel closed", 0 );
+
+	/* The stop closed the channel, so the sampling can start again. */
+	prvStart();
+	prvCheckStats( 0, 0, 0, 0 );
+	prvFillBlock();
+	prvReceive( &xBlock, 1 );
+	( void ) xADCSampleRelease( &xBlock );
+	vADCSampleStop();
+}
+/*-----------------------------------------------------------*/
+
+static void prvPipelineTest( uint32_t ulProcessingSteps )
+{
+ADCSampleBlock_t xBlock;
+ADCSampleStats_t xStats;
+uint32_t ulBlocks = 0, ulLastSequence = 0, ulGaps = 0, ulFailedReleases = 0, ulWrongSamples = 0;
+uint32_t ulStep, ulStepsLeft = 0;
+BaseType_t xHeld = pdFALSE;
+BaseType_t xSlow = ( ulProcessingSteps > mainSTEPS_PER_BLOCK ) ? pdTRUE : pdFALSE;
+
+	prvStart();
+
+	/* Enough steps for every block to be filled at the slowest speed of
+	processing tested. */
+	for( ulStep = 0; ( ulBlocks < mainPIPELINE_BLOCKS ) && ( ulStep < ( mainPIPELINE_BLOCKS * mainSTEPS_PER_BLOCK * 4UL ) ); ulStep++ )
+	{
+		vDMASimRun( mainADC_CHANNEL, adcsampleBLOCK_SAMPLES / mainSTEPS_PER_BLOCK );
+
+		if( xHeld != pdFALSE )
+		{
+			ulStepsLeft--;
+
+			if( ulStepsLeft == 0UL )
+			{
+				/* Check the samples as the processing ends, which is when
+				they would have been overwritten. */
+				if( prvSamplesCorrect( &xBlock ) == pdFALSE )
+				{
+					ulWrongSamples++;
+				}
+
+				if( xADCSampleRelease( &xBlock ) == pdFAIL )
+				{
+					ulFailedReleases++;
+				}
+
+				xHeld = pdFALSE;
+				ulBlocks++;
+			}
+		}
+
+		if( ( xHeld == pdFALSE ) && ( xADCSampleReceive( &xBlock, 0 ) != pdFAIL ) )
+		{
+			ulGaps += xBlock.ulSequence - ulLastSequence - 1UL;
+			ulLastSequence = xBlock.ulSequence;
+			ulStepsLeft = ulProcessingSteps;
+			xHeld = pdTRUE;
+		}
+	}
+
+	prvCheck( ulBlocks == mainPIPELINE_BLOCKS, "pipeline blocks received", ulBlocks );
+
+	if( xHeld != pdFALSE )
+	{
+		( void ) xADCSampleRelease( &xBlock );
+	}
+
+	vADCSampleGetStats( &xStats );
+	vADCSampleStop();
+
+	if( xSlow == pdFALSE )
+	{
+		prvCheck( ( xStats.ulBlocksDropped == 0 ) && ( ulGaps == 0 ), "nothing dropped by fast processing", xStats.ulBlocksDropped );
+		prvCheck( ( xStats.ulBlocksOverwritten == 0 ) && ( ulFailedReleases == 0 ), "nothing overwritten by fast processing", xStats.ulBlocksOverwritten );
+		prvCheck( ulWrongSamples == 0, "samples of fast processing", ulWrongSamples );
+	}
+	else
+	{
+		prvCheck( xStats.ulBlocksDropped > 0, "blocks dropped by slow processing", xStats.ulBlocksDropped );
+		prvCheck( xStats.ulBlocksOverwritten > 0, "blocks overwritten by slow processing", xStats.ulBlocksOverwritten );
+
+		/* A block holds its own samples if, and only if, it was released
+		in time. */
+		prvCheck( ulWrongSamples == ulFailedReleases, "samples of slow processing", ulWrongSamples );
+	}
+
+	/* Every block filled was received, dropped, or is one of the two the
+	message buffer holds, and the blocks dropped before the last received
+	are the gaps in the sequence.  Every block that failed to be released was
+	counted as overwritten. */
+	prvCheck( ( ( ulBlocks + xStats.ulBlocksDropped ) <= xStats.ulBlocksFilled ) && ( xStats.ulBlocksFilled <= ( ulBlocks + xStats.ulBlocksDropped + 2UL ) ), "blocks filled accounted for", xStats.ulBlocksFilled );
+	prvCheck( ulGaps <= xStats.ulBlocksDropped, "sequence gaps are dropped blocks", ulGaps );
+	prvCheck( ulFailedReleases <= xStats.ulBlocksOverwritten, "failed releases are overwritten blocks", ulFailedReleases );
+	prvCheck( xStats.ulErrors == 0, "no pipeline errors", xStats.ulErrors );
+}
+/*-----------------------------------------------------------*/
+
+static void prvStart( void )
+{
+	ulConversions = 0;
+	prvCheck( xADCSampleStart(), "sampling started", 0 );
+	prvCheck( ( pxDMASimTransfer( mainADC_CHANNEL ) != NULL ) && ( xDMASimRunning( mainADC_CHANNEL ) != pdFALSE ), "DMA started", 0 );
+	prvCheck( ( ulDMASimConfig( mainADC_CHANNEL ) & DMA_IT_HT ) != 0UL, "half transfer interrupt enabled", ulDMASimConfig( mainADC_CHANNEL ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFillBlock( void )
+{
+	vDMASimRun( mainADC_CHANNEL, adcsampleBLOCK_SAMPLES );
+}
+/*-----------------------------------------------------------*/
+
+static void prvReceive( ADCSampleBlock_t *pxBlock, uint32_t ulSequence )
+{
+	if( xADCSampleReceive( pxBlock, 0 ) == pdFAIL )
+	{
+		prvCheck( pdFALSE, "block received", ulSequence );
+	}
+	else
+	{
+		prvCheck( pxBlock->ulSequence == ulSequence, "block sequence", pxBlock->ulSequence );
+		prvCheck( prvSamplesCorrect( pxBlock ), "block samples", pxBlock->ulSequence );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSamplesCorrect( const ADCSampleBlock_t *pxBlock )
+{
+const uint32_t ulFirst = ( pxBlock->ulSequence - 1UL ) * adcsampleBLOCK_SAMPLES;
+UBaseType_t x;
+
+	for( x = 0; x < adcsampleBLOCK_SAMPLES; x++ )
+	{
+		if( pxBlock->pusSamples[ x ] != ( uint16_t ) ( ulFirst + x ) )
+		{
+			return pdFALSE;
+		}
+	}
+
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckStats( uint32_t ulFilled, uint32_t ulDropped, uint32_t ulOverwritten, uint32_t ulErrors )
+{
+ADCSampleStats_t xStats;
+
+	vADCSampleGetStats( &xStats );
+	prvCheck( xStats.ulBlocksFilled == ulFilled, "blocks filled", xStats.ulBlocksFilled );
+	prvCheck( xStats.ulBlocksDropped == ulDropped, "blocks dropped", xStats.ulBlocksDropped );
+	prvCheck( xStats.ulBlocksOverwritten == ulOverwritten, "blocks overwritten", xStats.ulBlocksOverwritten );
+	prvCheck( xStats.ulErrors == ulErrors, "transfer errors", xStats.ulErrors );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvConvert( UBaseType_t uxChannel )
+{
+	( void ) uxChannel;
+
+	return ulConversions++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		printf( "Failed %s (%lu)\n", pcCheck, ulValue );
+		xFailed = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,241 @@
+/*
+	Runs the standard demo tasks of Common/Minimal on the host build, as a
+	regression test of the kernel.
+
+	Each set of demo tasks checks its own results and reports whether it has
+	found an error, or stopped making progress, when asked.  The check task asks
+	every set each mainCHECK_PERIOD, and once mainRUN_TIME has passed ends the
+	scheduler.  The program then exits with 0 if no set failed, or 1 after
+	naming those that did.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo application includes. */
+#include "stm32f10x_lib.h"
+#include "partest.h"
+#include "BlockQ.h"
+#include "blocktim.h"
+#include "countsem.h"
+#include "death.h"
+#include "dynamic.h"
+#include "EventGroupsDemo.h"
+#include "flash.h"
+#include "GenQTest.h"
+#include "integer.h"
+#include "MessageBufferDemo.h"
+#include "PollQ.h"
+#include "QPeek.h"
+#include "QueueOverwrite.h"
+#include "recmutex.h"
+#include "semtest.h"
+#include "StreamBufferDemo.h"
+#include "TaskNotify.h"
+#include "TimerDemo.h"
+
+/* Task priorities. */
+#define mainQUEUE_POLL_PRIORITY			( tskIDLE_PRIORITY + 2 )
+#define mainSEM_TEST_PRIORITY			( tskIDLE_PRIORITY + 1 )
+#define mainBLOCK_Q_PRIORITY			( tskIDLE_PRIORITY + 2 )
+#define mainCREATOR_TASK_PRIORITY		( tskIDLE_PRIORITY + 3 )
+#define mainFLASH_TASK_PRIORITY			( tskIDLE_PRIORITY + 1 )
+#define mainINTEGER_TASK_PRIORITY		( tskIDLE_PRIORITY )
+#define mainGEN_QUEUE_TASK_PRIORITY		( tskIDLE_PRIORITY )
+#define mainQUEUE_OVERWRITE_PRIORITY	( tskIDLE_PRIORITY )
+#define mainCHECK_TASK_PRIORITY			( configMAX_PRIORITIES - 1 )
+
+/* The base period of the timer demo, and how often the check task looks at
+the demo tasks and for how long they run. */
+#define mainTIMER_TEST_PERIOD			pdMS_TO_TICKS( 50 )
+#define mainCHECK_PERIOD				pdMS_TO_TICKS( 2000 )
+#define mainRUN_TIME					pdMS_TO_TICKS( 20000 )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Looks at every set of demo tasks in turn.
+ */
+static void prvCheckTask( void *pvParameters );
+
+/*
+ * Prints the name of a set of tasks that failed, and records the failure.
+ */
+static void prvReportError( const char *pcSet );
+
+/*-----------------------------------------------------------*/
+
+/* The sets that failed, and whether any did. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	debug();
+	vParTestInitialise();
+
+	vStartBlockingQueueTasks( mainBLOCK_Q_PRIORITY );
+	vCreateBlockTimeTasks();
+	vStartCountingSemaphoreTasks();
+	vStartDynamicPriorityTasks();
+	vStartEventGroupTasks();
+	vStartLEDFlashTasks( mainFLASH_TASK_PRIORITY );
+	vStartGenericQueueTasks( mainGEN_QUEUE_TASK_PRIORITY );
+	vStartIntegerMathTasks( mainINTEGER_TASK_PRIORITY );
+	vStartMessageBufferTasks( configMINIMAL_STACK_SIZE );
+	vStartPolledQueueTasks( mainQUEUE_POLL_PRIORITY );
+	vStartQueuePeekTasks();
+	vStartQueueOverwriteTask( mainQUEUE_OVERWRITE_PRIORITY );
+	vStartRecursiveMutexTasks();
+	vStartSemaphoreTasks( mainSEM_TEST_PRIORITY );
+	vStartStreamBufferTasks();
+	vStartTaskNotifyTask();
+	vStartTimerDemoTask( mainTIMER_TEST_PERIOD );
+
+	xTaskCreate( prvCheckTask, "Check", configMINIMAL_STACK_SIZE, NULL, mainCHECK_TASK_PRIORITY, NULL );
+
+	/* The suicidal tasks count the tasks that exist when they start, so are
+	created last. */
+	vCreateSuicidalTasks( mainCREATOR_TASK_PRIORITY );
+
+	vTaskStartScheduler();
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All standard demo tasks passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckTask( void *pvParameters )
+{
+TickType_t xLastWakeTime = xTaskGetTickCount();
+const TickType_t xStart = xLastWakeTime;
+
+	( void ) pvParameters;
+
+	do
+	{
+		vTaskDelayUntil( &xLastWakeTime, mainCHECK_PERIOD );
+
+		if( xAreBlockingQueuesStillRunning() != pdTRUE )
+		{
+			prvReportError( "BlockQ" );
+		}
+
+		if( xAreBlockTimeTestTasksStillRunning() != pdTRUE )
+		{
+			prvReportError( "blocktim" );
+		}
+
+		if( xAreCountingSemaphoreTasksStillRunning() != pdTRUE )
+		{
+			prvReportError( "countsem" );
+		}
+
+		if( xAreDynamicPriorityTasksStillRunning() != pdTRUE )
+		{
+			prvReportError( "dynamic" );
+		}
+
+		if( xAreEventGroupTasksStillRunning() != pdTRUE )
+		{
+			prvReportError( "EventGroupsDemo" );
+		}
+
+		if( xAreGenericQueueTasksStillRunning() != pdTRUE )
+		{
+			prvReportError( "GenQTest" );
+		}
+
+		if( xAreIntegerMathsTaskStillRunning() != pdTRUE )
+		{
+			prvReportError( "integer" );
+		}
+
+		if( xAreMessageBufferTasksStillRunning() != pdTRUE )
+		{
+			prvReportError( "MessageBufferDemo" );
+		}
+
+		if( xArePollingQueuesStillRunning() != pdTRUE )
+		{
+			prvReportError( "PollQ" );
+		}
+
+		if( xAreQueuePeekTasksStillRunning() != pdTRUE )
+		{
+			prvReportError( "QPeek" );
+		}
+
+		if( xIsQueueOverwriteTaskStillRunning() != pdTRUE )
+		{
+			prvReportError( "QueueOverwrite" );
+		}
+
+		if( xAreRecursiveMutexTasksStillRunning() != pdTRUE )
+		{
+			prvReportError( "recmutex" );
+		}
+
+		if( xAreSemaphoreTasksStillRunning() != pdTRUE )
+		{
+			prvReportError( "semtest" );
+		}
+
+		if( xAreStreamBufferTasksStillRunning() != pdTRUE )
+		{
+			prvReportError( "StreamBufferDemo" );
+		}
+
+		if( xAreTaskNotificationTasksStillRunning() != pdTRUE )
+		{
+			prvReportError( "TaskNotify" );
+		}
+
+		if( xAreTimerDemoTasksStillRunning( mainCHECK_PERIOD ) != pdTRUE )
+		{
+			prvReportError( "TimerDemo" );
+		}
+
+		if( xIsCreateTaskStillRunning() != pdTRUE )
+		{
+			prvReportError( "death" );
+		}
+
+	} while( ( xTaskGetTickCount() - xStart ) < mainRUN_TIME );
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvReportError( const char *pcSet )
+{
+	taskENTER_CRITICAL();
+	{
+		printf( "Error in %s at tick %lu\n", pcSet, ( unsigned long ) xTaskGetTickCount() );
+		fflush( stdout );
+	}
+	taskEXIT_CRITICAL();
+
+	xFailed = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationTickHook( void )
+{
+	/* The parts of the demos that run in interrupts. */
+	vTimerPeriodicISRTests();
+	vQueueOverwritePeriodicISRDemo();
+	vPeriodicEventGroupsProcessing();
+	xNotifyTaskFromISR();
+	vPeriodicStreamBufferProcessing();
+}
@@ -0,0 +1,602 @@
+/*
+	Tests the DMA channel service of dma_service.c on the host build, against
+	the simulated DMA controller of dma_sim.c.
+
+	The service is built with dmaserviceCHANNELS naming channels 1 to 6, so
+	the requests wired to channel 7 must be refused.
+
+	+ The open test checks each request gets the channel it is wired to, a
+	  memory to memory request the first free channel, and that a channel
+	  can only be opened once.
+
+	+ The chain test gathers three scattered buffers into one with a chain
+	  of memory to memory descriptors, each started by the service from the
+	  interrupt that ends the one before.
+
+	+ The priority test queues chains from the test task at three
+	  priorities, and from an interrupt, behind a chain that is being moved,
+	  and they must be started in priority order, in the order they were
+	  submitted within a priority.
+
+	+ The cancel test cancels a queued chain and the active one, and the
+	  circular test runs a circular descriptor, and a chain that loops back
+	  to its first descriptor, for several laps.
+
+	+ The error test raises a transfer error part way through a chain, which
+	  must abandon the rest of the chain and start the next.
+
+	+ The wait test lets the simulated channel move data from the tick hook
+	  while the test task blocks in xDMAServiceWait().
+
+	The program ends the scheduler once the tests have run, and exits with 0 if
+	every check passed, or 1 after naming those that failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Library includes. */
+#include "stm32f10x_lib.h"
+
+/* Demo application includes. */
+#include "dma_service.h"
+#include "dma_sim.h"
+
+/* The priority of the task that runs the tests, which the priority test
+moves above and below it. */
+#define mainTEST_TASK_PRIORITY			( tskIDLE_PRIORITY + 2 )
+
+/* The configuration of the memory to memory descriptors, and of the circular
+descriptor, which reads the simulated peripheral. */
+#define mainM2M_CONFIG					( ( uint16_t ) ( DMA_DIR_PeripheralSRC | DMA_PeripheralInc_Enable | DMA_MemoryInc_Enable | \
+														 DMA_PeripheralDataSize_Byte | DMA_MemoryDataSize_Byte | \
+														 DMA_Mode_Normal | DMA_M2M_Enable ) )
+#define mainCIRCULAR_CONFIG				( ( uint16_t ) ( DMA_DIR_PeripheralSRC | DMA_PeripheralInc_Disable | DMA_MemoryInc_Enable | \
+														 DMA_PeripheralDataSize_HalfWord | DMA_MemoryDataSize_HalfWord | \
+														 DMA_Mode_Circular | DMA_M2M_Disable ) )
+
+/* The samples in the buffer of the circular test. */
+#define mainCIRCULAR_SAMPLES			( 8 )
+
+/* The most callbacks recorded by one test. */
+#define mainMAX_EVENTS					( 32 )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Runs the tests.
+ */
+static void prvTestTask( void *pvParameters );
+
+/*
+ * The tests.
+ */
+static void prvOpenTest( void );
+static void prvChainTest( void );
+static void prvPriorityTest( void );
+static void prvCancelTest( void );
+static void prvCircularTest( void );
+static void prvErrorTest( void );
+static void prvWaitTest( void );
+
+/*
+ * Opens the memory to memory channel the tests other than the open test use,
+ * which is channel 1 as all the channels are closed.
+ */
+static DMAChannelHandle_t prvOpenMemoryChannel( void );
+
+/*
+ * Fills in a memory to memory descriptor that copies ulLength bytes from
+ * pvSource to pvDestination, with prvRecordEvent() as its function.
+ */
+static void prvDescribe( DMATransfer_t *pxTransfer, const void *pvSource, void *pvDestination, uint32_t ulLength );
+
+/*
+ * Moves the items of channel 1 a few at a time until the chain that starts
+ * at pxTransfer has ended.
+ */
+static void prvRunToEnd( DMATransfer_t *pxTransfer );
+
+/*
+ * The function of every descriptor, which records each call.
+ */
+static void prvRecordEvent( DMATransfer_t *pxTransfer, uint32_t ulEvent, BaseType_t *pxHigherPriorityTaskWoken );
+
+/*
+ * Stands in for the peripheral read by the circular descriptor, returning
+ * the number of items read before.
+ */
+static uint32_t prvReadPeripheral( UBaseType_t uxChannel );
+
+/*
+ * Records a failed check.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* The calls of prvRecordEvent() since the count was last cleared. */
+static DMATransfer_t *pxEventTransfers[ mainMAX_EVENTS ];
+static uint32_t ulEvents[ mainMAX_EVENTS ];
+static volatile UBaseType_t uxEventCount = 0;
+
+/* The items prvReadPeripheral() has returned. */
+static uint32_t ulPeripheralReads = 0;
+
+/* Whether any check failed. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE * 2, NULL, mainTEST_TASK_PRIORITY, NULL );
+
+	vTaskStartScheduler();
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All DMA service tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationTickHook( void )
+{
+	vDMASimTick();
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	vDMASimReset();
+	vDMAServiceInit( &xDMASimHardware );
+
+	prvOpenTest();
+	prvChainTest();
+	prvPriorityTest();
+	prvCancelTest();
+	prvCircularTest();
+	prvErrorTest();
+	prvWaitTest();
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvOpenTest( void )
+{
+DMAChannelHandle_t xADC, xSPI, xMemory[ 5 ];
+UBaseType_t x;
+
+	xADC = xDMAServiceOpen( eDMARequestADC1, DMA_Priority_High );
+	prvCheck( ( ( xADC != NULL ) && ( xDMASimEnabled( 1 ) != pdFALSE ) ) ? pdTRUE : pdFALSE, "ADC1 opens channel 1", 0 );
+	prvCheck( ( xDMAServiceOpen( eDMARequestADC1, DMA_Priority_High ) == NULL ) ? pdTRUE : pdFALSE, "channel 1 opened twice", 0 );
+
+	xSPI = xDMAServiceOpen( eDMARequestSPI1Tx, DMA_Priority_High );
+	prvCheck( ( ( xSPI != NULL ) && ( xDMASimEnabled( 3 ) != pdFALSE ) ) ? pdTRUE : pdFALSE, "SPI1 Tx opens channel 3", 0 );
+	prvCheck( ( xDMAServiceOpen( eDMARequestUSART3Rx, DMA_Priority_High ) == NULL ) ? pdTRUE : pdFALSE, "USART3 Rx shares channel 3", 0 );
+	prvCheck( ( xDMAServiceOpen( eDMARequestUSART2Tx, DMA_Priority_High ) == NULL ) ? pdTRUE : pdFALSE, "channel 7 not in dmaserviceCHANNELS", 0 );
+
+	/* The memory requests fill the free channels in turn: 2, 4, 5 and 6. */
+	for( x = 0; x < 5; x++ )
+	{
+		xMemory[ x ] = xDMAServiceOpen( eDMARequestMemory, DMA_Priority_Low );
+	}
+
+	prvCheck( ( xMemory[ 0 ] != NULL ) && ( xDMASimEnabled( 2 ) != pdFALSE ), "memory opens channel 2", 0 );
+	prvCheck( ( xMemory[ 3 ] != NULL ) && ( xDMASimEnabled( 6 ) != pdFALSE ), "memory opens channel 6", 0 );
+	prvCheck( ( xMemory[ 4 ] == NULL ) ? pdTRUE : pdFALSE, "memory with every channel open", 0 );
+	prvCheck( xDMASimEnabled( 7 ) == pdFALSE, "channel 7 untouched", 0 );
+
+	prvCheck( xDMAServiceClose( xADC ), "ADC1 closed", 0 );
+	prvCheck( xDMAServiceClose( xSPI ), "SPI1 Tx closed", 0 );
+
+	for( x = 0; x < 4; x++ )
+	{
+		prvCheck( xDMAServiceClose( xMemory[ x ] ), "memory closed", x );
+	}
+
+	for( x = 1; x <= 7; x++ )
+	{
+		prvCheck( xDMASimEnabled( x ) == pdFALSE, "channel disabled once closed", x );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvChainTest( void )
+{
+static uint8_t ucSourceA[ 10 ], ucSourceB[ 7 ], ucSourceC[ 20 ];
+static uint8_t ucDestination[ sizeof( ucSourceA ) + sizeof( ucSourceB ) + sizeof( ucSourceC ) ];
+static DMATransfer_t xChain[ 3 ], xEmpty[ 2 ];
+DMAChannelHandle_t xChannel;
+UBaseType_t x;
+BaseType_t xGathered = pdTRUE;
+
+	xChannel = prvOpenMemoryChannel();
+
+	for( x = 0; x < sizeof( ucDestination ); x++ )
+	{
+		if( x < sizeof( ucSourceA ) )
+		{
+			ucSourceA[ x ] = ( uint8_t ) x;
+		}
+		else if( x < ( sizeof( ucSourceA ) + sizeof( ucSourceB ) ) )
+		{
+			ucSourceB[ x - sizeof( ucSourceA ) ] = ( uint8_t ) x;
+		}
+		else
+		{
+			ucSourceC[ x - sizeof( ucSourceA ) - sizeof( ucSourceB ) ] = ( uint8_t ) x;
+		}
+	}
+
+	memset( ( void * ) ucDestination, 0xff, sizeof( ucDestination ) );
+	prvDescribe( &( xChain[ 0 ] ), ucSourceA, ucDestination, sizeof( ucSourceA ) );
+	prvDescribe( &( xChain[ 1 ] ), ucSourceB, &( ucDestination[ sizeof( ucSourceA ) ] ), sizeof( ucSourceB ) );
+	prvDescribe( &( xChain[ 2 ] ), ucSourceC, &( ucDestination[ sizeof( ucSourceA ) + sizeof( ucSourceB ) ] ), sizeof( ucSourceC ) );
+	xChain[ 0 ].pxNext = &( xChain[ 1 ] );
+	xChain[ 1 ].pxNext = &( xChain[ 2 ] );
+	uxEventCount = 0;
+
+	prvCheck( xDMAServiceSubmit( xChannel, &( xChain[ 0 ] ) ), "chain submitted", 0 );
+	prvCheck( xChain[ 0 ].xStatus == dmaserviceSTATUS_ACTIVE, "chain active", xChain[ 0 ].xStatus );
+	prvCheck( pxDMASimTransfer( 1 ) == &( xChain[ 0 ] ), "first descriptor started", 0 );
+	prvCheck( ulDMASimConfig( 1 ) == ( ( uint32_t ) mainM2M_CONFIG | DMA_Priority_Medium | DMA_IT_TC | DMA_IT_TE ), "channel configuration", ulDMASimConfig( 1 ) );
+	prvCheck( xDMAServiceSubmit( xChannel, &( xChain[ 0 ] ) ) == pdFAIL, "chain submitted twice", 0 );
+	prvCheck( xDMAServiceClose( xChannel ) == pdFAIL, "channel closed with a chain queued", 0 );
+
+	vDMASimRun( 1, 3 );
+	prvCheck( usDMAServiceRemaining( xChannel ) == ( sizeof( ucSourceA ) - 3 ), "items remaining", usDMAServiceRemaining( xChannel ) );
+
+	prvRunToEnd( &( xChain[ 0 ] ) );
+
+	for( x = 0; x < sizeof( ucDestination ); x++ )
+	{
+		if( ucDestination[ x ] != ( uint8_t ) x )
+		{
+			xGathered = pdFALSE;
+		}
+	}
+
+	prvCheck( xGathered, "buffers gathered", 0 );
+	prvCheck( ulDMASimStarts( 1 ) == 3, "descriptors started", ulDMASimStarts( 1 ) );
+	prvCheck( uxEventCount == 3, "descriptor functions called", uxEventCount );
+
+	for( x = 0; ( x < 3 ) && ( x < uxEventCount ); x++ )
+	{
+		prvCheck( ( pxEventTransfers[ x ] == &( xChain[ x ] ) ) && ( ulEvents[ x ] == dmaserviceEVENT_COMPLETE ), "descriptor completed in order", x );
+	}
+
+	prvCheck( xDMAServiceWait( &( xChain[ 0 ] ), 0 ) == dmaserviceSTATUS_DONE, "chain done", xChain[ 0 ].xStatus );
+	prvCheck( usDMAServiceRemaining( xChannel ) == 0, "channel idle", 0 );
+
+	/* A descriptor with nothing to move would never end. */
+	prvDescribe( &( xEmpty[ 0 ] ), ucSourceA, ucDestination, 1 );
+	prvDescribe( &( xEmpty[ 1 ] ), ucSourceA, ucDestination, 0 );
+	xEmpty[ 0 ].pxNext = &( xEmpty[ 1 ] );
+	prvCheck( xDMAServiceSubmit( xChannel, &( xEmpty[ 0 ] ) ) == pdFAIL, "chain with an empty descriptor", 0 );
+	prvCheck( xEmpty[ 0 ].xStatus == dmaserviceSTATUS_IDLE, "chain with an empty descriptor not queued", xEmpty[ 0 ].xStatus );
+
+	/* A chain that has ended can be submitted again. */
+	prvCheck( xDMAServiceSubmit( xChannel, &( xChain[ 0 ] ) ), "chain submitted again", 0 );
+	prvRunToEnd( &( xChain[ 0 ] ) );
+	prvCheck( xChain[ 0 ].xStatus == dmaserviceSTATUS_DONE, "chain done again", xChain[ 0 ].xStatus );
+
+	prvCheck( xDMAServiceClose( xChannel ), "channel closed", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPriorityTest( void )
+{
+static uint8_t ucSource[ 4 ], ucDestination[ 4 ];
+static DMATransfer_t xActive, xLow, xHigh, xHighLater, xFromISR;
+DMATransfer_t * const pxExpected[] = { &xActive, &xFromISR, &xHigh, &xHighLater, &xLow };
+DMAChannelHandle_t xChannel;
+UBaseType_t x;
+
+	xChannel = prvOpenMemoryChannel();
+
+	prvDescribe( &xActive, ucSource, ucDestination, sizeof( ucSource ) );
+	prvDescribe( &xLow, ucSource, ucDestination, sizeof( ucSource ) );
+	prvDescribe( &xHigh, ucSource, ucDestination, sizeof( ucSource ) );
+	prvDescribe( &xHighLater, ucSource, ucDestination, sizeof( ucSource ) );
+	prvDescribe( &xFromISR, ucSource, ucDestination, sizeof( ucSource ) );
+	uxEventCount = 0;
+
+	/* The active chain is not overtaken, whatever the priority of the
+	chains queued behind it. */
+	( void ) xDMAServiceSubmit( xChannel, &xActive );
+
+	vTaskPrioritySet( NULL, mainTEST_TASK_PRIORITY - 1 );
+	( void ) xDMAServiceSubmit( xChannel, &xLow );
+	vTaskPrioritySet( NULL, mainTEST_TASK_PRIORITY + 1 );
+	( void ) xDMAServiceSubmit( xChannel, &xHigh );
+	( void ) xDMAServiceSubmit( xChannel, &xHighLater );
+	vTaskPrioritySet( NULL, mainTEST_TASK_PRIORITY );
+	( void ) xDMAServiceSubmitFromISR( xChannel, &xFromISR );
+
+	prvCheck( xLow.xStatus == dmaserviceSTATUS_QUEUED, "chain queued", xLow.xStatus );
+	prvCheck( xFromISR.xTask == NULL, "no task for a chain from an interrupt", 0 );
+
+	for( x = 0; x < 5; x++ )
+	{
+		prvCheck( pxDMASimTransfer( 1 ) == pxExpected[ x ], "chains started in priority order", x );
+		prvRunToEnd( pxExpected[ x ] );
+	}
+
+	prvCheck( uxEventCount == 5, "chains ended", uxEventCount );
+	prvCheck( ( xLow.xStatus == dmaserviceSTATUS_DONE ) && ( xFromISR.xStatus == dmaserviceSTATUS_DONE ), "queued chains done", 0 );
+	prvCheck( xDMAServiceClose( xChannel ), "channel closed", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCancelTest( void )
+{
+static uint8_t ucSource[ 16 ], ucDestination[ 16 ];
+static DMATransfer_t xFirst, xSecond, xThird;
+DMAChannelHandle_t xChannel;
+uint32_t ulStops;
+
+	xChannel = prvOpenMemoryChannel();
+
+	prvDescribe( &xFirst, ucSource, ucDestination, sizeof( ucSource ) );
+	prvDescribe( &xSecond, ucSource, ucDestination, sizeof( ucSource ) );
+	prvDescribe( &xThird, ucSource, ucDestination, sizeof( ucSource ) );
+	uxEventCount = 0;
+
+	( void ) xDMAServiceSubmit( xChannel, &xFirst );
+	( void ) xDMAServiceSubmit( xChannel, &xSecond );
+	( void ) xDMAServiceSubmit( xChannel, &xThird );
+	vDMASimRun( 1, 5 );
+	ulStops = ulDMASimStops( 1 );
+
+	/* A queued chain is taken out of the queue without touching the
+	channel. */
+	prvCheck( xDMAServiceCancel( xChannel, &xSecond ), "queued chain cancelled", 0 );
+	prvCheck( xSecond.xStatus == dmaserviceSTATUS_CANCELLED, "queued chain status", xSecond.xStatus );
+	prvCheck( ( ulDMASimStops( 1 ) == ulStops ) && ( pxDMASimTransfer( 1 ) == &xFirst ) && ( xDMASimRunning( 1 ) != pdFALSE ), "active chain kept", 0 );
+	prvCheck( xDMAServiceCancel( xChannel, &xSecond ) == pdFAIL, "chain cancelled twice", 0 );
+
+	/* The active chain is stopped, and the next started. */
+	prvCheck( xDMAServiceCancel( xChannel, &xFirst ), "active chain cancelled", 0 );
+	prvCheck( xFirst.xStatus == dmaserviceSTATUS_CANCELLED, "active chain status", xFirst.xStatus );
+	prvCheck( ulDMASimStops( 1 ) == ( ulStops + 1 ), "active chain stopped", ulDMASimStops( 1 ) - ulStops );
+	prvCheck( ( pxDMASimTransfer( 1 ) == &xThird ) && ( xThird.xStatus == dmaserviceSTATUS_ACTIVE ), "next chain started", 0 );
+
+	prvRunToEnd( &xThird );
+	prvCheck( xThird.xStatus == dmaserviceSTATUS_DONE, "next chain done", xThird.xStatus );
+	prvCheck( ( uxEventCount == 1 ) && ( pxEventTransfers[ 0 ] == &xThird ), "no function called for cancelled chains", uxEventCount );
+
+	/* The interrupt of a transfer that ended as it was cancelled finds the
+	channel idle. */
+	vDMAServiceInterrupt( 1, dmaserviceEVENT_COMPLETE );
+	prvCheck( uxEventCount == 1, "interrupt on an idle channel", uxEventCount );
+
+	prvCheck( xDMAServiceClose( xChannel ), "channel closed", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCircularTest( void )
+{
+static uint16_t usSamples[ mainCIRCULAR_SAMPLES ];
+static uint8_t ucSource[ 6 ], ucDestination[ 6 ];
+static DMATransfer_t xCircular, xLoop[ 2 ];
+DMAChannelHandle_t xChannel;
+UBaseType_t x;
+uint32_t ulStarts;
+BaseType_t xSamplesCorrect = pdTRUE;
+
+	xChannel = prvOpenMemoryChannel();
+	vDMASimConnect( 1, prvReadPeripheral );
+	ulPeripheralReads = 0;
+
+	memset( ( void * ) &xCircular, 0x00, sizeof( xCircular ) );
+	xCircular.ulMemoryAddress = ( uint32_t ) usSamples;
+	xCircular.usCount = mainCIRCULAR_SAMPLES;
+	xCircular.usConfig = mainCIRCULAR_CONFIG;
+	xCircular.pxCallback = prvRecordEvent;
+	uxEventCount = 0;
+
+	ulStarts = ulDMASimStarts( 1 );
+	( void ) xDMAServiceSubmit( xChannel, &xCircular );
+	prvCheck( ( ulDMASimConfig( 1 ) & DMA_IT_HT ) != 0UL, "half transfer interrupt enabled", ulDMASimConfig( 1 ) );
+
+	vDMASimRun( 1, mainCIRCULAR_SAMPLES / 2 );
+	prvCheck( ( uxEventCount == 1 ) && ( ulEvents[ 0 ] == dmaserviceEVENT_HALF ), "half event", uxEventCount );
+
+	vDMASimRun( 1, mainCIRCULAR_SAMPLES / 2 );
+	prvCheck( ( uxEventCount == 2 ) && ( ulEvents[ 1 ] == dmaserviceEVENT_COMPLETE ), "complete event", uxEventCount );
+	prvCheck( xCircular.xStatus == dmaserviceSTATUS_ACTIVE, "circular descriptor runs on", xCircular.xStatus );
+	prvCheck( ulDMASimStarts( 1 ) == ( ulStarts + 1 ), "circular descriptor not restarted", ulDMASimStarts( 1 ) - ulStarts );
+
+	/* A whole lap before the interrupt is taken reports both halves, the
+	first first. */
+	vDMASimRun( 1, mainCIRCULAR_SAMPLES );
+	prvCheck( ( uxEventCount == 4 ) && ( ulEvents[ 2 ] == dmaserviceEVENT_HALF ) && ( ulEvents[ 3 ] == dmaserviceEVENT_COMPLETE ), "half and complete events of one interrupt", uxEventCount );
+
+	for( x = 0; x < mainCIRCULAR_SAMPLES; x++ )
+	{
+		if( usSamples[ x ] != ( uint16_t ) ( mainCIRCULAR_SAMPLES + x ) )
+		{
+			xSamplesCorrect = pdFALSE;
+		}
+	}
+
+	prvCheck( xSamplesCorrect, "second lap written over the first", 0 );
+
+	vDMASimRun( 1, 3 );
+	prvCheck( usDMAServiceRemaining( xChannel ) == ( mainCIRCULAR_SAMPLES - 3 ), "circular items remaining", usDMAServiceRemaining( xChannel ) );
+
+	prvCheck( xDMAServiceCancel( xChannel, &xCircular ), "circular descriptor cancelled", 0 );
+	prvCheck( xDMASimRunning( 1 ) == pdFALSE, "circular descriptor stopped", 0 );
+	prvCheck( xDMAServiceWait( &xCircular, 0 ) == dmaserviceSTATUS_CANCELLED, "circular descriptor status", xCircular.xStatus );
+	vDMASimConnect( 1, NULL );
+
+	/* A chain that loops back to its first descriptor also runs until it is
+	cancelled. */
+	prvDescribe( &( xLoop[ 0 ] ), ucSource, ucDestination, 2 );
+	prvDescribe( &( xLoop[ 1 ] ), &( ucSource[ 2 ] ), &( ucDestination[ 2 ] ), 4 );
+	xLoop[ 0 ].pxNext = &( xLoop[ 1 ] );
+	xLoop[ 1 ].pxNext = &( xLoop[ 0 ] );
+	uxEventCount = 0;
+	ulStarts = ulDMASimStarts( 1 );
+
+	prvCheck( xDMAServiceSubmit( xChannel, &( xLoop[ 0 ] ) ), "loop submitted", 0 );
+
+	for( x = 0; x < 6; x++ )
+	{
+		vDMASimRun( 1, 4 );
+	}
+
+	prvCheck( ulDMASimStarts( 1 ) == ( ulStarts + 7 ), "loop descriptors started", ulDMASimStarts( 1 ) - ulStarts );
+	prvCheck( xLoop[ 0 ].xStatus == dmaserviceSTATUS_ACTIVE, "loop runs on", xLoop[ 0 ].xStatus );
+	prvCheck( ( uxEventCount == 6 ) && ( pxEventTransfers[ 4 ] == &( xLoop[ 0 ] ) ) && ( pxEventTransfers[ 5 ] == &( xLoop[ 1 ] ) ), "loop descriptors ended in turn", uxEventCount );
+	prvCheck( xDMAServiceCancel( xChannel, &( xLoop[ 0 ] ) ), "loop cancelled", 0 );
+
+	prvCheck( xDMAServiceClose( xChannel ), "channel closed", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvErrorTest( void )
+{
+static uint8_t ucSource[ 8 ], ucDestination[ 8 ];
+static DMATransfer_t xChain[ 2 ], xNext;
+DMAChannelHandle_t xChannel;
+uint32_t ulStarts;
+
+	xChannel = prvOpenMemoryChannel();
+
+	prvDescribe( &( xChain[ 0 ] ), ucSource, ucDestination, sizeof( ucSource ) );
+	prvDescribe( &( xChain[ 1 ] ), ucSource, ucDestination, sizeof( ucSource ) );
+	prvDescribe( &xNext, ucSource, ucDestination, sizeof( ucSource ) );
+	xChain[ 0 ].pxNext = &( xChain[ 1 ] );
+	uxEventCount = 0;
+
+	( void ) xDMAServiceSubmit( xChannel, &( xChain[ 0 ] ) );
+	( void ) xDMAServiceSubmit( xChannel, &xNext );
+	ulStarts = ulDMASimStarts( 1 );
+
+	vDMASimRun( 1, 2 );
+	vDMASimError( 1 );
+
+	prvCheck( xDMAServiceWait( &( xChain[ 0 ] ), 0 ) == dmaserviceSTATUS_ERROR, "chain failed", xChain[ 0 ].xStatus );
+	prvCheck( ( uxEventCount == 1 ) && ( pxEventTransfers[ 0 ] == &( xChain[ 0 ] ) ) && ( ulEvents[ 0 ] == dmaserviceEVENT_ERROR ), "error event", uxEventCount );
+	prvCheck( ( ulDMASimStarts( 1 ) == ( ulStarts + 1 ) ) && ( pxDMASimTransfer( 1 ) == &xNext ), "rest of chain abandoned for the next", 0 );
+
+	prvRunToEnd( &xNext );
+	prvCheck( xNext.xStatus == dmaserviceSTATUS_DONE, "next chain done", xNext.xStatus );
+	prvCheck( xDMAServiceClose( xChannel ), "channel closed", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWaitTest( void )
+{
+static uint8_t ucSource[ 20 ], ucDestination[ 20 ];
+static DMATransfer_t xFirst, xSecond;
+DMAChannelHandle_t xChannel;
+TickType_t xStart, xTicks;
+
+	xChannel = prvOpenMemoryChannel();
+
+	prvDescribe( &xFirst, ucSource, ucDestination, sizeof( ucSource ) );
+	prvDescribe( &xSecond, ucSource, ucDestination, sizeof( ucSource ) );
+	xFirst.pxCallback = NULL;
+	xSecond.pxCallback = NULL;
+
+	/* Nothing moves until the tick hook is let run the channel. */
+	( void ) xDMAServiceSubmit( xChannel, &xFirst );
+	xStart = xTaskGetTickCount();
+	prvCheck( xDMAServiceWait( &xFirst, 5 ) == dmaserviceSTATUS_ACTIVE, "wait timed out", xFirst.xStatus );
+	xTicks = xTaskGetTickCount() - xStart;
+	prvCheck( xTicks >= 5, "wait blocked for its time out", xTicks );
+
+	/* Two items a tick, so each chain takes ten ticks.  Waiting for the
+	second chain wakes for the end of the first, and blocks again. */
+	( void ) xDMAServiceSubmit( xChannel, &xSecond );
+	xStart = xTaskGetTickCount();
+	vDMASimSetRate( 1, 2 );
+	prvCheck( xDMAServiceWait( &xSecond, pdMS_TO_TICKS( 100 ) ) == dmaserviceSTATUS_DONE, "second chain waited for", xSecond.xStatus );
+	xTicks = xTaskGetTickCount() - xStart;
+	vDMASimSetRate( 1, 0 );
+
+	prvCheck( xFirst.xStatus == dmaserviceSTATUS_DONE, "first chain done", xFirst.xStatus );
+	prvCheck( ( xTicks >= 15 ) && ( xTicks < pdMS_TO_TICKS( 100 ) ), "wait for both chains", xTicks );
+
+	prvCheck( xDMAServiceClose( xChannel ), "channel closed", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static DMAChannelHandle_t prvOpenMemoryChannel( void )
+{
+DMAChannelHandle_t xChannel;
+
+	xChannel = xDMAServiceOpen( eDMARequestMemory, DMA_Priority_Medium );
+	prvCheck( ( ( xChannel != NULL ) && ( xDMASimEnabled( 1 ) != pdFALSE ) ) ? pdTRUE : pdFALSE, "memory opens channel 1", 0 );
+
+	return xChannel;
+}
+/*-----------------------------------------------------------*/
+
+static void prvDescribe( DMATransfer_t *pxTransfer, const void *pvSource, void *pvDestination, uint32_t ulLength )
+{
+	memset( ( void * ) pxTransfer, 0x00, sizeof( *pxTransfer ) );
+	pxTransfer->ulPeripheralAddress = ( uint32_t ) pvSource;
+	pxTransfer->ulMemoryAddress = ( uint32_t ) pvDestination;
+	pxTransfer->usCount = ( uint16_t ) ulLength;
+	pxTransfer->usConfig = mainM2M_CONFIG;
+	pxTransfer->pxCallback = prvRecordEvent;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunToEnd( DMATransfer_t *pxTransfer )
+{
+	while( ( ( pxTransfer->xStatus == dmaserviceSTATUS_QUEUED ) || ( pxTransfer->xStatus == dmaserviceSTATUS_ACTIVE ) ) &&
+		   ( xDMASimRunning( 1 ) != pdFALSE ) )
+	{
+		vDMASimRun( 1, 3 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecordEvent( DMATransfer_t *pxTransfer, uint32_t ulEvent, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	( void ) pxHigherPriorityTaskWoken;
+
+	if( uxEventCount < mainMAX_EVENTS )
+	{
+		pxEventTransfers[ uxEventCount ] = pxTransfer;
+		ulEvents[ uxEventCount ] = ulEvent;
+	}
+
+	uxEventCount++;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvReadPeripheral( UBaseType_t uxChannel )
+{
+	( void ) uxChannel;
+
+	return ulPeripheralReads++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		printf( "Failed %s (%lu)\n", pcCheck, ulValue );
+		xFailed = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,601 @@
+/*
+	Tests the fixed point signal processing of dsp_fixed.c on the host build.
+
+	Each kernel processes half scale noise, and its output is compared with
+	the same calculation done in double precision.  The FIR filter and the sums
+	of squares round down once, so may be one LSB below the reference, while
+	the CIC decimator is exact, as its integrators only wrap.  The biquad
+	filter rounds on every sample and feeds the rounding back, so must be
+	within a few tens of LSBs.  The streams are passed in pieces of
+	sizes that do not divide the block sizes, so the state carried from one
+	call to the next is tested too, and the tap and sample counts are chosen so
+	the unrolled loops have something left over.
+
+	Nothing here needs the scheduler, so the tests run straight from main(),
+	which exits with 0 if every check passed, or 1 after naming those that
+	failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+
+/* Demo application includes. */
+#include "dsp_fixed.h"
+
+/* The samples in each test stream. */
+#define mainSAMPLES						( 509 )
+
+/* The FIR filters, a tap count that is not a multiple of four, and the block
+size and decimation of the decimating one. */
+#define mainFIR_TAPS					( 31 )
+#define mainFIR_BLOCK					( 24 )
+#define mainFIR_DECIMATION				( 4 )
+
+/* The biquad cascade, and how far from the reference its output may be, in
+Q31 LSBs. */
+#define mainBIQUAD_STAGES				( 2 )
+#define mainBIQUAD_TOLERANCE			( 64.0 )
+
+/* The CIC decimator. */
+#define mainCIC_ORDER					( 3 )
+#define mainCIC_DECIMATION				( 8 )
+
+/* The window of the moving RMS. */
+#define mainRMS_WINDOW					( 50 )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The tests of each kernel.
+ */
+static void prvConversionTests( void );
+static void prvFIRTests( void );
+static void prvFIRDecimationTests( void );
+static void prvFIRSaturationTests( void );
+static void prvBiquadTests( void );
+static void prvRMSTests( void );
+static void prvMovingRMSTests( void );
+static void prvCICTests( void );
+static void prvMinMaxTests( void );
+
+/*
+ * The output of a FIR filter with the Q15 coefficients psCoefficients for
+ * sample lSample of psIn, the samples before the first being zero, in Q15
+ * LSBs.
+ */
+static double prvFIRReference( const int16_t *psCoefficients, size_t xTaps, const int16_t *psIn, long lSample );
+
+/*
+ * Returns the next of a sequence of pseudo random numbers.
+ */
+static uint32_t prvRandom( void );
+
+/*
+ * Fills psOut with half scale noise.
+ */
+static void prvNoise( int16_t *psOut, size_t xCount );
+
+/*
+ * Records a failed check.  ulValue is printed to help find the cause.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* The input of every test, and the outputs. */
+static int16_t sIn[ mainSAMPLES ], sOut[ mainSAMPLES ];
+static int32_t lIn[ mainSAMPLES ], lOut[ mainSAMPLES ], lInPlace[ mainSAMPLES ];
+
+static uint32_t ulRandomState = 0x12345678UL;
+
+/* Set to pdTRUE by any check that fails. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	prvConversionTests();
+	prvFIRTests();
+	prvFIRDecimationTests();
+	prvFIRSaturationTests();
+	prvBiquadTests();
+	prvRMSTests();
+	prvMovingRMSTests();
+	prvCICTests();
+	prvMinMaxTests();
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All DSP tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvConversionTests( void )
+{
+/* Two channels, the one tested at the bottom, the middle and the top of the
+12 bit range. */
+static const uint16_t usADC[] = { 0, 99, 2048, 99, 4095, 99 };
+int16_t sQ15[ 3 ];
+int32_t lQ31[ 3 ];
+
+	vDSPADCToQ15( usADC, 2, sQ15, 3 );
+	prvCheck( ( sQ15[ 0 ] == -32768 ) ? pdTRUE : pdFALSE, "ADC bottom to Q15", ( unsigned long ) sQ15[ 0 ] );
+	prvCheck( ( sQ15[ 1 ] == 0 ) ? pdTRUE : pdFALSE, "ADC middle to Q15", ( unsigned long ) sQ15[ 1 ] );
+	prvCheck( ( sQ15[ 2 ] == 32752 ) ? pdTRUE : pdFALSE, "ADC top to Q15", ( unsigned long ) sQ15[ 2 ] );
+
+	sQ15[ 1 ] = -1;
+	vDSPQ15ToQ31( sQ15, lQ31, 3 );
+	prvCheck( ( lQ31[ 0 ] == ( -2147483647L - 1L ) ) ? pdTRUE : pdFALSE, "Q15 to Q31 minimum", ( unsigned long ) lQ31[ 0 ] );
+	prvCheck( ( lQ31[ 1 ] == -65536L ) ? pdTRUE : pdFALSE, "Q15 to Q31 negative", ( unsigned long ) lQ31[ 1 ] );
+
+	lQ31[ 1 ] = -1L;
+	vDSPQ31ToQ15( lQ31, sQ15, 3 );
+	prvCheck( ( sQ15[ 0 ] == -32768 ) ? pdTRUE : pdFALSE, "Q31 to Q15 minimum", ( unsigned long ) sQ15[ 0 ] );
+	prvCheck( ( sQ15[ 1 ] == -1 ) ? pdTRUE : pdFALSE, "Q31 to Q15 truncates", ( unsigned long ) sQ15[ 1 ] );
+	prvCheck( ( sQ15[ 2 ] == 32752 ) ? pdTRUE : pdFALSE, "Q31 to Q15 round trip", ( unsigned long ) sQ15[ 2 ] );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFIRTests( void )
+{
+static int16_t sCoefficients[ mainFIR_TAPS ];
+static int16_t sState[ dspFIR_STATE_LENGTH( mainFIR_TAPS, mainFIR_BLOCK ) ];
+DSPFIRQ15_t xFIR;
+size_t x, xDone = 0, xPiece = 1, xOutputs = 0;
+double dReference;
+unsigned long ulErrors = 0;
+
+	/* Coefficients of both signs, which sum to more than one, so the output
+	is not just a smoothed copy of the input. */
+	for( x = 0; x < mainFIR_TAPS; x++ )
+	{
+		sCoefficients[ x ] = ( int16_t ) ( ( int32_t ) ( prvRandom() >> 20 ) - 2048L );
+	}
+
+	prvNoise( sIn, mainSAMPLES );
+	vDSPFIRInitQ15( &xFIR, sCoefficients, mainFIR_TAPS, 1, sState, mainFIR_BLOCK );
+
+	/* Pieces of 1, 8, 15 ... samples, some shorter and some longer than a
+	block. */
+	while( xDone < mainSAMPLES )
+	{
+		if( xPiece > ( mainSAMPLES - xDone ) )
+		{
+			xPiece = mainSAMPLES - xDone;
+		}
+
+		xOutputs += xDSPFIRQ15( &xFIR, &( sIn[ xDone ] ), &( sOut[ xDone ] ), xPiece );
+		xDone += xPiece;
+		xPiece += 7;
+	}
+
+	prvCheck( ( xOutputs == mainSAMPLES ) ? pdTRUE : pdFALSE, "FIR outputs", ( unsigned long ) xOutputs );
+
+	for( x = 0; x < mainSAMPLES; x++ )
+	{
+		dReference = prvFIRReference( sCoefficients, mainFIR_TAPS, sIn, ( long ) x );
+
+		/* Rounded down, so the output is at most one LSB below. */
+		if( ( ( double ) sOut[ x ] > dReference ) || ( ( double ) sOut[ x ] <= ( dReference - 1.0 ) ) )
+		{
+			ulErrors++;
+		}
+	}
+
+	prvCheck( ( ulErrors == 0 ) ? pdTRUE : pdFALSE, "FIR outputs that differ from the reference", ulErrors );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFIRDecimationTests( void )
+{
+static int16_t sCoefficients[ mainFIR_TAPS ];
+static int16_t sState[ dspFIR_STATE_LENGTH( mainFIR_TAPS, mainFIR_BLOCK ) ];
+DSPFIRQ15_t xFIR;
+size_t x, xDone = 0, xOutputs = 0;
+const size_t xSamples = ( mainSAMPLES / mainFIR_DECIMATION ) * mainFIR_DECIMATION;
+const size_t xPiece = 9 * mainFIR_DECIMATION;
+double dReference;
+unsigned long ulErrors = 0;
+
+	/* A triangular window, which sums to a little under one. */
+	for( x = 0; x < mainFIR_TAPS; x++ )
+	{
+		sCoefficients[ x ] = ( int16_t ) ( ( ( x < ( mainFIR_TAPS / 2 ) ) ? ( x + 1 ) : ( mainFIR_TAPS - x ) ) * 32767UL / ( ( ( mainFIR_TAPS + 1 ) / 2 ) * ( ( mainFIR_TAPS + 1 ) / 2 ) ) );
+	}
+
+	prvNoise( sIn, mainSAMPLES );
+	vDSPFIRInitQ15( &xFIR, sCoefficients, mainFIR_TAPS, mainFIR_DECIMATION, sState, mainFIR_BLOCK );
+
+	while( xDone < xSamples )
+	{
+		x = ( xPiece < ( xSamples - xDone ) ) ? xPiece : ( xSamples - xDone );
+		xOutputs += xDSPFIRQ15( &xFIR, &( sIn[ xDone ] ), &( sOut[ xOutputs ] ), x );
+		xDone += x;
+	}
+
+	prvCheck( ( xOutputs == ( xSamples / mainFIR_DECIMATION ) ) ? pdTRUE : pdFALSE, "decimating FIR outputs", ( unsigned long ) xOutputs );
+
+	/* Output n is the filter output for input n times the decimation. */
+	for( x = 0; x < xOutputs; x++ )
+	{
+		dReference = prvFIRReference( sCoefficients, mainFIR_TAPS, sIn, ( long ) ( x * mainFIR_DECIMATION ) );
+
+		if( ( ( double ) sOut[ x ] > dReference ) || ( ( double ) sOut[ x ] <= ( dReference - 1.0 ) ) )
+		{
+			ulErrors++;
+		}
+	}
+
+	prvCheck( ( ulErrors == 0 ) ? pdTRUE : pdFALSE, "decimating FIR outputs that differ from the reference", ulErrors );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFIRSaturationTests( void )
+{
+/* A gain of nearly four. */
+static const int16_t sCoefficients[ 4 ] = { 32767, 32767, 32767, 32767 };
+static const int16_t sSteps[ 8 ] = { 32767, 32767, 32767, 32767, -32768, -32768, -32768, -32768 };
+static int16_t sState[ dspFIR_STATE_LENGTH( 4, 8 ) ];
+DSPFIRQ15_t xFIR;
+
+	vDSPFIRInitQ15( &xFIR, sCoefficients, 4, 1, sState, 8 );
+	( void ) xDSPFIRQ15( &xFIR, sSteps, sOut, 8 );
+
+	prvCheck( ( sOut[ 3 ] == 32767 ) ? pdTRUE : pdFALSE, "FIR saturates high", ( unsigned long ) sOut[ 3 ] );
+	prvCheck( ( sOut[ 7 ] == -32768 ) ? pdTRUE : pdFALSE, "FIR saturates low", ( unsigned long ) sOut[ 7 ] );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBiquadTests( void )
+{
+/* A Butterworth low pass section with its cut off at 5% of the sample rate,
+and a peaking section with a gain above one at its centre frequency. */
+static const double dSections[ mainBIQUAD_STAGES ][ dspBIQUAD_COEFFICIENTS ] =
+{
+	{ 0.0200833656, 0.0401667311, 0.0200833656, 1.5610180758, -0.6413515381 },
+	{ 1.0570134380, -1.4922540420, 0.5745716520, 1.4922540420, -0.6315850900 }
+};
+static int32_t lCoefficients[ mainBIQUAD_STAGES * dspBIQUAD_COEFFICIENTS ];
+static int32_t lState[ mainBIQUAD_STAGES * dspBIQUAD_STATE ];
+static int32_t lInPlaceState[ mainBIQUAD_STAGES * dspBIQUAD_STATE ];
+double dCoefficients[ mainBIQUAD_STAGES ][ dspBIQUAD_COEFFICIENTS ];
+double dState[ mainBIQUAD_STAGES ][ dspBIQUAD_STATE ] = { { 0 } };
+double dX, dY, dError, dWorst = 0.0;
+DSPBiquadQ31_t xBiquad, xInPlace;
+size_t x, xDone = 0, xPiece;
+unsigned long ulDiffer = 0;
+int iStage, iCoefficient;
+
+	/* The coefficients are held halved, a post shift of one, and the
+	reference uses the values actually held. */
+	for( iStage = 0; iStage < mainBIQUAD_STAGES; iStage++ )
+	{
+		for( iCoefficient = 0; iCoefficient < dspBIQUAD_COEFFICIENTS; iCoefficient++ )
+		{
+			lCoefficients[ ( iStage * dspBIQUAD_COEFFICIENTS ) + iCoefficient ] = ( int32_t ) lrint( dSections[ iStage ][ iCoefficient ] * 1073741824.0 );
+			dCoefficients[ iStage ][ iCoefficient ] = ( double ) lCoefficients[ ( iStage * dspBIQUAD_COEFFICIENTS ) + iCoefficient ] / 1073741824.0;
+		}
+	}
+
+	prvNoise( sIn, mainSAMPLES );
+	vDSPQ15ToQ31( sIn, lIn, mainSAMPLES );
+
+	vDSPBiquadInitQ31( &xBiquad, lCoefficients, mainBIQUAD_STAGES, 1, lState );
+	vDSPBiquadInitQ31( &xInPlace, lCoefficients, mainBIQUAD_STAGES, 1, lInPlaceState );
+
+	for( x = 0; x < mainSAMPLES; x++ )
+	{
+		lInPlace[ x ] = lIn[ x ];
+	}
+
+	xPiece = 5;
+	while( xDone < mainSAMPLES )
+	{
+		if( xPiece > ( mainSAMPLES - xDone ) )
+		{
+			xPiece = mainSAMPLES - xDone;
+		}
+
+		vDSPBiquadQ31( &xBiquad, &( lIn[ xDone ] ), &( lOut[ xDone ] ), xPiece );
+		vDSPBiquadQ31( &xInPlace, &( lInPlace[ xDone ] ), &( lInPlace[ xDone ] ), xPiece );
+		xDone += xPiece;
+		xPiece += 11;
+	}
+
+	for( x = 0; x < mainSAMPLES; x++ )
+	{
+		dX = ( double ) lIn[ x ] / 2147483648.0;
+
+		for( iStage = 0; iStage < mainBIQUAD_STAGES; iStage++ )
+		{
+			dY = ( dCoefficients[ iStage ][ 0 ] * dX ) + ( dCoefficients[ iStage ][ 1 ] * dState[ iStage ][ 0 ] ) +
+				 ( dCoefficients[ iStage ][ 2 ] * dState[ iStage ][ 1 ] ) + ( dCoefficients[ iStage ][ 3 ] * dState[ iStage ][ 2 ] ) +
+				 ( dCoefficients[ iStage ][ 4 ] * dState[ iStage ][ 3 ] );
+			dState[ iStage ][ 1 ] = dState[ iStage ][ 0 ];
+			dState[ iStage ][ 0 ] = dX;
+			dState[ iStage ][ 3 ] = dState[ iStage ][ 2 ];
+			dState[ iStage ][ 2 ] = dY;
+			dX = dY;
+		}
+
+		dError = fabs( ( double ) lOut[ x ] - ( dX * 2147483648.0 ) );
+		if( dError > dWorst )
+		{
+			dWorst = dError;
+		}
+
+		if( lInPlace[ x ] != lOut[ x ] )
+		{
+			ulDiffer++;
+		}
+	}
+
+	prvCheck( ( dWorst <= mainBIQUAD_TOLERANCE ) ? pdTRUE : pdFALSE, "biquad error from the reference, in LSBs", ( unsigned long ) dWorst );
+	prvCheck( ( ulDiffer == 0 ) ? pdTRUE : pdFALSE, "biquad outputs in place that differ", ulDiffer );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRMSTests( void )
+{
+static const int16_t sFullScale[ 4 ] = { -32768, -32768, -32768, -32768 };
+double dSum = 0.0, dReference;
+int16_t sRMS;
+size_t x;
+
+	prvNoise( sIn, mainSAMPLES );
+
+	for( x = 0; x < mainSAMPLES; x++ )
+	{
+		dSum += ( double ) sIn[ x ] * ( double ) sIn[ x ];
+	}
+
+	dReference = sqrt( dSum / ( double ) mainSAMPLES );
+	sRMS = sDSPRMSQ15( sIn, mainSAMPLES );
+
+	/* The mean and the root are both rounded down. */
+	prvCheck( ( ( ( double ) sRMS <= dReference ) && ( ( double ) sRMS > ( dReference - 1.0 ) ) ) ? pdTRUE : pdFALSE, "RMS", ( unsigned long ) sRMS );
+	prvCheck( ( sDSPRMSQ15( sFullScale, 4 ) == 32767 ) ? pdTRUE : pdFALSE, "RMS of full scale saturates", 0 );
+	prvCheck( ( sDSPRMSQ15( sIn, 0 ) == 0 ) ? pdTRUE : pdFALSE, "RMS of no samples", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvMovingRMSTests( void )
+{
+static int16_t sWindow[ mainRMS_WINDOW ];
+DSPMovingRMSQ15_t xRMS;
+double dSum, dReference;
+size_t x, xDone = 0, xPiece = 3;
+unsigned long ulErrors = 0;
+int16_t sRMS;
+
+	prvNoise( sIn, mainSAMPLES );
+	vDSPMovingRMSInitQ15( &xRMS, sWindow, mainRMS_WINDOW );
+
+	/* The window starts full of zeros, so the reference includes samples
+	before the first, which are zero. */
+	while( xDone < mainSAMPLES )
+	{
+		if( xPiece > ( mainSAMPLES - xDone ) )
+		{
+			xPiece = mainSAMPLES - xDone;
+		}
+
+		sRMS = sDSPMovingRMSQ15( &xRMS, &( sIn[ xDone ] ), xPiece );
+		xDone += xPiece;
+		xPiece += 4;
+
+		dSum = 0.0;
+		for( x = ( xDone > mainRMS_WINDOW ) ? ( xDone - mainRMS_WINDOW ) : 0; x < xDone; x++ )
+		{
+			dSum += ( double ) sIn[ x ] * ( double ) sIn[ x ];
+		}
+
+		dReference = sqrt( dSum / ( double ) mainRMS_WINDOW );
+
+		if( ( ( double ) sRMS > dReference ) || ( ( double ) sRMS <= ( dReference - 1.0 ) ) )
+		{
+			ulErrors++;
+		}
+	}
+
+	prvCheck( ( ulErrors == 0 ) ? pdTRUE : pdFALSE, "moving RMS outputs that differ from the reference", ulErrors );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCICTests( void )
+{
+DSPCICQ15_t xCIC;
+double dImpulse[ ( ( mainCIC_DECIMATION - 1 ) * mainCIC_ORDER ) + 1 ] = { 0 };
+double dGain = 1.0, dReference;
+size_t x, xTap, xTaps = 1, xDone = 0, xPiece = 1, xOutputs = 0;
+long lSample;
+unsigned long ulErrors = 0;
+int iStage;
+
+	prvCheck( ( xDSPCICInitQ15( &xCIC, 0, 8 ) == pdFAIL ) ? pdTRUE : pdFALSE, "CIC of order 0 refused", 0 );
+	prvCheck( ( xDSPCICInitQ15( &xCIC, dspCIC_MAX_ORDER + 1, 2 ) == pdFAIL ) ? pdTRUE : pdFALSE, "CIC of too high an order refused", 0 );
+	prvCheck( ( xDSPCICInitQ15( &xCIC, 2, 6 ) == pdFAIL ) ? pdTRUE : pdFALSE, "CIC decimation not a power of two refused", 0 );
+	prvCheck( ( xDSPCICInitQ15( &xCIC, 4, 32 ) == pdFAIL ) ? pdTRUE : pdFALSE, "CIC gain too high refused", 0 );
+	prvCheck( ( xDSPCICInitQ15( &xCIC, mainCIC_ORDER, mainCIC_DECIMATION ) == pdPASS ) ? pdTRUE : pdFALSE, "CIC initialised", 0 );
+
+	/* The impulse response of the decimator before it decimates, a moving
+	sum of mainCIC_DECIMATION samples convolved with itself once per
+	stage. */
+	dImpulse[ 0 ] = 1.0;
+	for( iStage = 0; iStage < mainCIC_ORDER; iStage++ )
+	{
+		xTaps += mainCIC_DECIMATION - 1;
+
+		for( xTap = xTaps - 1; xTap > 0; xTap-- )
+		{
+			for( x = 1; ( x < mainCIC_DECIMATION ) && ( x <= xTap ); x++ )
+			{
+				dImpulse[ xTap ] += dImpulse[ xTap - x ];
+			}
+		}
+
+		dGain *= mainCIC_DECIMATION;
+	}
+
+	prvNoise( sIn, mainSAMPLES );
+
+	while( xDone < mainSAMPLES )
+	{
+		if( xPiece > ( mainSAMPLES - xDone ) )
+		{
+			xPiece = mainSAMPLES - xDone;
+		}
+
+		xOutputs += xDSPCICQ15( &xCIC, &( sIn[ xDone ] ), &( sOut[ xOutputs ] ), xPiece );
+		xDone += xPiece;
+		xPiece += 3;
+	}
+
+	prvCheck( ( xOutputs == ( mainSAMPLES / mainCIC_DECIMATION ) ) ? pdTRUE : pdFALSE, "CIC outputs", ( unsigned long ) xOutputs );
+
+	/* An output is made once each mainCIC_DECIMATION inputs have been taken,
+	and the sums are exact in double, so the outputs must match once the gain
+	is divided out and rounded down. */
+	for( x = 0; x < xOutputs; x++ )
+	{
+		lSample = ( long ) ( ( x * mainCIC_DECIMATION ) + mainCIC_DECIMATION - 1 );
+		dReference = 0.0;
+
+		for( xTap = 0; ( xTap < xTaps ) && ( ( long ) xTap <= lSample ); xTap++ )
+		{
+			dReference += dImpulse[ xTap ] * ( double ) sIn[ lSample - ( long ) xTap ];
+		}
+
+		if( ( double ) sOut[ x ] != floor( dReference / dGain ) )
+		{
+			ulErrors++;
+		}
+	}
+
+	prvCheck( ( ulErrors == 0 ) ? pdTRUE : pdFALSE, "CIC outputs that differ from the reference", ulErrors );
+}
+/*-----------------------------------------------------------*/
+
+static void prvMinMaxTests( void )
+{
+int16_t sMin, sMax, sExpectedMin, sExpectedMax;
+int32_t lMin, lMax, lExpectedMin, lExpectedMax;
+size_t x, xCount;
+unsigned long ulErrors = 0;
+
+	prvNoise( sIn, mainSAMPLES );
+	vDSPQ15ToQ31( sIn, lIn, mainSAMPLES );
+
+	/* Put the extremes at the ends, where the pairs start and finish. */
+	sIn[ 0 ] = -32768;
+	lIn[ 0 ] = -2147483647L - 1L;
+	sIn[ 6 ] = 32767;
+	lIn[ 6 ] = 2147483647L;
+
+	/* Every length up to 16, odd and even, and the whole stream. */
+	for( xCount = 1; xCount <= mainSAMPLES; xCount = ( xCount < 16 ) ? ( xCount + 1 ) : ( xCount + mainSAMPLES - 16 ) )
+	{
+		sExpectedMin = sIn[ 0 ];
+		sExpectedMax = sIn[ 0 ];
+		lExpectedMin = lIn[ 0 ];
+		lExpectedMax = lIn[ 0 ];
+
+		for( x = 1; x < xCount; x++ )
+		{
+			sExpectedMin = ( sIn[ x ] < sExpectedMin ) ? sIn[ x ] : sExpectedMin;
+			sExpectedMax = ( sIn[ x ] > sExpectedMax ) ? sIn[ x ] : sExpectedMax;
+			lExpectedMin = ( lIn[ x ] < lExpectedMin ) ? lIn[ x ] : lExpectedMin;
+			lExpectedMax = ( lIn[ x ] > lExpectedMax ) ? lIn[ x ] : lExpectedMax;
+		}
+
+		vDSPMinMaxQ15( sIn, xCount, &sMin, &sMax );
+		vDSPMinMaxQ31( lIn, xCount, &lMin, &lMax );
+
+		if( ( sMin != sExpectedMin ) || ( sMax != sExpectedMax ) || ( lMin != lExpectedMin ) || ( lMax != lExpectedMax ) )
+		{
+			ulErrors++;
+		}
+
+		/* The same samples reversed, so the extremes are at the other
+		end. */
+		vDSPMinMaxQ15( &( sIn[ mainSAMPLES - xCount ] ), xCount, &sMin, &sMax );
+
+		sExpectedMin = sIn[ mainSAMPLES - 1 ];
+		sExpectedMax = sIn[ mainSAMPLES - 1 ];
+		for( x = mainSAMPLES - xCount; x < mainSAMPLES; x++ )
+		{
+			sExpectedMin = ( sIn[ x ] < sExpectedMin ) ? sIn[ x ] : sExpectedMin;
+			sExpectedMax = ( sIn[ x ] > sExpectedMax ) ? sIn[ x ] : sExpectedMax;
+		}
+
+		if( ( sMin != sExpectedMin ) || ( sMax != sExpectedMax ) )
+		{
+			ulErrors++;
+		}
+	}
+
+	prvCheck( ( ulErrors == 0 ) ? pdTRUE : pdFALSE, "min/max lengths that differ from the reference", ulErrors );
+}
+/*-----------------------------------------------------------*/
+
+static double prvFIRReference( const int16_t *psCoefficients, size_t xTaps, const int16_t *psIn, long lSample )
+{
+double dAcc = 0.0;
+size_t xTap;
+
+	for( xTap = 0; ( xTap < xTaps ) && ( ( long ) xTap <= lSample ); xTap++ )
+	{
+		dAcc += ( double ) psCoefficients[ xTap ] * ( double ) psIn[ lSample - ( long ) xTap ];
+	}
+
+	dAcc /= 32768.0;
+
+	/* Saturated as the filter does. */
+	if( dAcc > 32767.0 )
+	{
+		dAcc = 32767.0;
+	}
+	else if( dAcc < -32768.0 )
+	{
+		dAcc = -32768.0;
+	}
+
+	return dAcc;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( void )
+{
+	ulRandomState = ( ulRandomState * 1664525UL ) + 1013904223UL;
+	return ulRandomState;
+}
+/*-----------------------------------------------------------*/
+
+static void prvNoise( int16_t *psOut, size_t xCount )
+{
+size_t x;
+
+	for( x = 0; x < xCount; x++ )
+	{
+		psOut[ x ] = ( int16_t ) ( ( int32_t ) ( prvRandom() >> 17 ) - 16384L );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		printf( "Failed %s (%lu)\n", pcCheck, ulValue );
+		xFailed = pdTRUE;
+	}
+}
@@ -0,0 +1,503 @@
+/*
+	Tests the write-back cache of SPI FLASH pages of flash_cache.c on the host
+	build.  SPI_FLASH_BufferRead(), SPI_FLASH_PageWrite() and
+	SPI_FLASH_SectorErase() are provided here, on the simulated NOR flash of
+	flash_sim.c, and count the reads and page programs the cache makes.
+
+	+ The coalesce test makes many small writes to a page, some to the same
+	  byte, and to a page that was already programmed.  Nothing may reach the
+	  flash until the cache is flushed, reads must return the AND of what was
+	  written and what the page held, and the flush must program each changed
+	  page once.
+
+	+ The read test changes the flash behind a cached page, which must still
+	  be read from the cache, and reads a range in which pages that are not
+	  cached surround one that is, which must be read from the flash with one
+	  read for each run of pages that are not cached, and are not cached by
+	  being read.
+
+	+ The eviction test fills every line with a changed page, then writes to
+	  other pages, and the page used least recently - by a read or a write -
+	  must be the one programmed to make room, with the others left in the
+	  cache.
+
+	+ The erase test erases a sector holding changed pages, which must be
+	  dropped from the cache and never programmed, while a changed page in
+	  another sector is kept.
+
+	+ The background test leaves a changed page to the task created by
+	  xFlashCacheInit(), which must program it once flashcacheFLUSH_DELAY has
+	  passed, and not before.
+
+	Every test checks the statistics returned by vFlashCacheGetStats() against
+	those it expects.  The program ends the scheduler once the tests have run,
+	and exits with 0 if every check passed, or 1 after naming those that
+	failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo application includes. */
+#include "spi_flash.h"
+#include "flash_cache.h"
+#include "flash_sim.h"
+
+/* The priority of the task that runs the tests.  The task that programs the
+changed pages runs below it, so only does so while the test task is blocked. */
+#define mainTEST_TASK_PRIORITY			( tskIDLE_PRIORITY + 2 )
+#define mainFLUSH_TASK_PRIORITY			( tskIDLE_PRIORITY + 1 )
+
+/* The file the flash is held in, and its size. */
+#define mainFLASH_FILE					"flash_cache.bin"
+#define mainFLASH_SIZE					( 2UL * flashsimSECTOR_SIZE )
+
+/* The address of page x of the first sector, and of the second sector. */
+#define mainPAGE( x )					( ( uint32_t ) ( x ) * flashcachePAGE_SIZE )
+#define mainSECTOR_1					flashsimSECTOR_SIZE
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Runs the tests.
+ */
+static void prvTestTask( void *pvParameters );
+
+/*
+ * The tests.
+ */
+static void prvCoalesceTest( void );
+static void prvReadTest( void );
+static void prvEvictionTest( void );
+static void prvEraseTest( void );
+static void prvBackgroundTest( void );
+
+/*
+ * Writes ucValue to ulAddress through the cache, counting the write in
+ * xExpected as a hit or a miss.
+ */
+static void prvWriteByte( uint32_t ulAddress, uint8_t ucValue, BaseType_t xHit );
+
+/*
+ * Returns the byte the simulated flash holds at ulAddress, without going
+ * through the cache.
+ */
+static uint8_t prvFlashByte( uint32_t ulAddress );
+
+/*
+ * Checks the statistics returned by vFlashCacheGetStats() against xExpected.
+ */
+static void prvCheckStats( const char *pcTest );
+
+/*
+ * Records a failed check.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* The reads and page programs made by the cache. */
+static uint32_t ulReads = 0, ulPrograms = 0;
+
+/* The statistics the cache should report. */
+static FlashCacheStats_t xExpected;
+
+static uint8_t ucBuffer[ 4 * flashcachePAGE_SIZE ];
+
+/* Whether any check failed. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	( void ) unlink( mainFLASH_FILE );
+
+	if( xFlashSimOpen( mainFLASH_FILE, mainFLASH_SIZE ) == pdFAIL )
+	{
+		printf( "Failed flash opened\n" );
+		return EXIT_FAILURE;
+	}
+
+	memset( ( void * ) &xExpected, 0x00, sizeof( xExpected ) );
+
+	if( xFlashCacheInit( mainFLUSH_TASK_PRIORITY ) == pdFAIL )
+	{
+		printf( "Failed flash cache created\n" );
+		return EXIT_FAILURE;
+	}
+
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE * 2, NULL, mainTEST_TASK_PRIORITY, NULL );
+
+	vTaskStartScheduler();
+
+	vFlashSimClose();
+	( void ) unlink( mainFLASH_FILE );
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All flash cache tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+void SPI_FLASH_BufferRead( u8 *pBuffer, u32 ReadAddr, u32 NumByteToRead )
+{
+	ulReads++;
+	vFlashSimRead( ReadAddr, pBuffer, NumByteToRead );
+}
+/*-----------------------------------------------------------*/
+
+void SPI_FLASH_PageWrite( u8 *pBuffer, u32 WriteAddr, u16 NumByteToWrite )
+{
+	/* A page program wraps within its page, so the cache must never start one
+	that crosses into the next. */
+	prvCheck( ( ( WriteAddr % flashcachePAGE_SIZE ) + NumByteToWrite ) <= flashcachePAGE_SIZE, "page program within a page", WriteAddr );
+
+	ulPrograms++;
+	vFlashSimProgram( WriteAddr, pBuffer, NumByteToWrite );
+}
+/*-----------------------------------------------------------*/
+
+void SPI_FLASH_SectorErase( u32 SectorAddr )
+{
+	prvCheck( ( SectorAddr % flashsimSECTOR_SIZE ) == 0UL, "sector erase aligned", SectorAddr );
+	vFlashSimEraseSector( SectorAddr );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	prvCoalesceTest();
+	prvReadTest();
+	prvEvictionTest();
+	prvEraseTest();
+	prvBackgroundTest();
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvCoalesceTest( void )
+{
+static const uint8_t ucPattern[ 4 ] = { 0x55, 0x55, 0x55, 0x55 };
+uint32_t ulPrograms0, ulReads0, x;
+BaseType_t xMatch;
+
+	vFlashCacheEraseSector( mainPAGE( 0 ) );
+
+	/* Page 1 already holds data where it will be written. */
+	vFlashSimProgram( mainPAGE( 1 ), ucPattern, 2 );
+	ucBuffer[ 0 ] = 0x0f;
+	vFlashSimProgram( mainPAGE( 1 ) + 2UL, ucBuffer, 1 );
+
+	/* Sixteen writes of a byte to page 0, the first of which reads the page
+	into a line, then a byte written again, setting bits that were cleared. */
+	ulPrograms0 = ulPrograms;
+	ulReads0 = ulReads;
+
+	for( x = 0; x < 16UL; x++ )
+	{
+		prvWriteByte( mainPAGE( 0 ) + x, ( uint8_t ) ( 0xf0UL | x ), ( x > 0UL ) ? pdTRUE : pdFALSE );
+	}
+
+	prvWriteByte( mainPAGE( 0 ) + 3UL, 0x3c, pdTRUE );
+
+	prvCheck( ulReads == ( ulReads0 + 1UL ), "page read once for its writes", ulReads - ulReads0 );
+	prvCheck( ulPrograms == ulPrograms0, "nothing programmed before the flush", ulPrograms - ulPrograms0 );
+	prvCheck( prvFlashByte( mainPAGE( 0 ) ) == 0xffU, "flash untouched before the flush", prvFlashByte( mainPAGE( 0 ) ) );
+
+	/* Written bytes are ANDed with what was written before. */
+	vFlashCacheRead( mainPAGE( 0 ), ucBuffer, 16 );
+	xExpected.ulReadHits++;
+	xMatch = pdTRUE;
+
+	for( x = 0; x < 16UL; x++ )
+	{
+		if( ucBuffer[ x ] != ( ( x == 3UL ) ? 0x30U : ( 0xf0U | x ) ) )
+		{
+			xMatch = pdFALSE;
+		}
+	}
+
+	prvCheck( xMatch, "cache holds the AND of the writes", ucBuffer[ 3 ] );
+
+	/* A write to a page that was already programmed, and one across the end of
+	that page, into page 2. */
+	prvWriteByte( mainPAGE( 1 ) + 2UL, 0xf3, pdFALSE );
+	vFlashCacheWrite( mainPAGE( 2 ) - 2UL, ucPattern, sizeof( ucPattern ) );
+	xExpected.ulWriteHits++;
+	xExpected.ulWriteMisses++;
+	xExpected.ulBytesWritten += sizeof( ucPattern );
+
+	vFlashCacheRead( mainPAGE( 1 ), ucBuffer, 4 );
+	xExpected.ulReadHits++;
+	prvCheck( ( ucBuffer[ 0 ] == 0x55U ) && ( ucBuffer[ 2 ] == 0x03U ) && ( ucBuffer[ 3 ] == 0xffU ), "cache holds the AND with the flash", ucBuffer[ 2 ] );
+
+	/* One program for each changed page, of the bytes changed. */
+	ulPrograms0 = ulPrograms;
+	vFlashCacheFlush();
+	xExpected.ulFlushes += 3UL;
+	xExpected.ulBytesFlushed += 16UL + ( flashcachePAGE_SIZE - 2UL ) + 2UL;
+
+	prvCheck( ulPrograms == ( ulPrograms0 + 3UL ), "one program for each page", ulPrograms - ulPrograms0 );
+	prvCheck( prvFlashByte( mainPAGE( 0 ) + 3UL ) == 0x30U, "flushed byte written twice", prvFlashByte( mainPAGE( 0 ) + 3UL ) );
+	prvCheck( prvFlashByte( mainPAGE( 0 ) + 15UL ) == 0xffU, "flushed last byte", prvFlashByte( mainPAGE( 0 ) + 15UL ) );
+	prvCheck( prvFlashByte( mainPAGE( 0 ) + 16UL ) == 0xffU, "flush stops at the bytes written", prvFlashByte( mainPAGE( 0 ) + 16UL ) );
+	prvCheck( prvFlashByte( mainPAGE( 1 ) + 2UL ) == 0x03U, "flushed onto programmed data", prvFlashByte( mainPAGE( 1 ) + 2UL ) );
+	prvCheck( prvFlashByte( mainPAGE( 2 ) - 1UL ) == 0x55U, "flushed end of page", prvFlashByte( mainPAGE( 2 ) - 1UL ) );
+	prvCheck( prvFlashByte( mainPAGE( 2 ) + 1UL ) == 0x55U, "flushed next page", prvFlashByte( mainPAGE( 2 ) + 1UL ) );
+	prvCheck( prvFlashByte( mainPAGE( 2 ) + 2UL ) == 0xffU, "next page flush stops", prvFlashByte( mainPAGE( 2 ) + 2UL ) );
+
+	/* Nothing is left to program. */
+	ulPrograms0 = ulPrograms;
+	vFlashCacheFlush();
+	prvCheck( ulPrograms == ulPrograms0, "clean pages not programmed", ulPrograms - ulPrograms0 );
+
+	prvCheckStats( "coalesce" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvReadTest( void )
+{
+static const uint8_t ucZero = 0x00;
+uint32_t ulReads0;
+
+	/* Pages 0 to 2 are cached, so a change made behind the cache is not seen
+	through it. */
+	ulReads0 = ulReads;
+	vFlashSimProgram( mainPAGE( 2 ) + 8UL, &ucZero, 1 );
+	vFlashCacheRead( mainPAGE( 2 ) + 8UL, ucBuffer, 1 );
+	xExpected.ulReadHits++;
+	prvCheck( ucBuffer[ 0 ] == 0xffU, "read served from the cache", ucBuffer[ 0 ] );
+	prvCheck( ulReads == ulReads0, "cached read not read from the flash", ulReads - ulReads0 );
+
+	/* Page 5 is changed but not programmed, and pages 3, 4 and 6 hold data
+	only in the flash. */
+	ucBuffer[ 0 ] = 0x33;
+	vFlashSimProgram( mainPAGE( 3 ), ucBuffer, 1 );
+	ucBuffer[ 0 ] = 0x44;
+	vFlashSimProgram( mainPAGE( 4 ) + flashcachePAGE_SIZE - 1UL, ucBuffer, 1 );
+	ucBuffer[ 0 ] = 0x66;
+	vFlashSimProgram( mainPAGE( 6 ) + 1UL, ucBuffer, 1 );
+	prvWriteByte( mainPAGE( 5 ), 0x55, pdFALSE );
+
+	/* Pages 3 and 4 are read with one command, page 5 from the cache, and
+	page 6 with another command. */
+	ulReads0 = ulReads;
+	memset( ucBuffer, 0x00, sizeof( ucBuffer ) );
+	vFlashCacheRead( mainPAGE( 3 ), ucBuffer, 4UL * flashcachePAGE_SIZE );
+	xExpected.ulReadHits++;
+	xExpected.ulReadMisses += 3UL;
+
+	prvCheck( ulReads == ( ulReads0 + 2UL ), "one read for each run of misses", ulReads - ulReads0 );
+	prvCheck( ucBuffer[ 0 ] == 0x33U, "first miss read", ucBuffer[ 0 ] );
+	prvCheck( ucBuffer[ 1 ] == 0xffU, "first miss erased", ucBuffer[ 1 ] );
+	prvCheck( ucBuffer[ ( 2UL * flashcachePAGE_SIZE ) - 1UL ] == 0x44U, "second miss read", ucBuffer[ ( 2UL * flashcachePAGE_SIZE ) - 1UL ] );
+	prvCheck( ucBuffer[ 2UL * flashcachePAGE_SIZE ] == 0x55U, "unprogrammed write read", ucBuffer[ 2UL * flashcachePAGE_SIZE ] );
+	prvCheck( ucBuffer[ ( 2UL * flashcachePAGE_SIZE ) + 1UL ] == 0xffU, "hit erased", ucBuffer[ ( 2UL * flashcachePAGE_SIZE ) + 1UL ] );
+	prvCheck( ucBuffer[ ( 3UL * flashcachePAGE_SIZE ) + 1UL ] == 0x66U, "miss after a hit read", ucBuffer[ ( 3UL * flashcachePAGE_SIZE ) + 1UL ] );
+
+	/* Reading a page does not cache it. */
+	ulReads0 = ulReads;
+	vFlashCacheRead( mainPAGE( 3 ), ucBuffer, 1 );
+	xExpected.ulReadMisses++;
+	prvCheck( ulReads == ( ulReads0 + 1UL ), "missed page not cached", ulReads - ulReads0 );
+
+	vFlashCacheFlush();
+	xExpected.ulFlushes++;
+	xExpected.ulBytesFlushed++;
+	prvCheck( prvFlashByte( mainPAGE( 5 ) ) == 0x55U, "read page flushed", prvFlashByte( mainPAGE( 5 ) ) );
+
+	prvCheckStats( "read" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEvictionTest( void )
+{
+uint32_t ulPrograms0, ulReads0;
+
+	/* Every line is clean, so none is programmed to make room for pages 8 to
+	11, which are each read into a line. */
+	ulPrograms0 = ulPrograms;
+	ulReads0 = ulReads;
+	prvWriteByte( mainPAGE( 8 ), 0x08, pdFALSE );
+	prvWriteByte( mainPAGE( 9 ), 0x09, pdFALSE );
+	prvWriteByte( mainPAGE( 10 ), 0x0a, pdFALSE );
+	prvWriteByte( mainPAGE( 11 ), 0x0b, pdFALSE );
+	prvCheck( ulPrograms == ulPrograms0, "clean lines reused without a program", ulPrograms - ulPrograms0 );
+	prvCheck( ulReads == ( ulReads0 + 4UL ), "each page read into a line", ulReads - ulReads0 );
+
+	/* A read of page 8 makes page 9 the one used least recently, so it is
+	programmed to make room for page 12. */
+	vFlashCacheRead( mainPAGE( 8 ), ucBuffer, 1 );
+	xExpected.ulReadHits++;
+
+	ulPrograms0 = ulPrograms;
+	prvWriteByte( mainPAGE( 12 ), 0x0c, pdFALSE );
+	xExpected.ulEvictions++;
+	xExpected.ulFlushes++;
+	xExpected.ulBytesFlushed++;
+
+	prvCheck( ulPrograms == ( ulPrograms0 + 1UL ), "one page programmed to make room", ulPrograms - ulPrograms0 );
+	prvCheck( prvFlashByte( mainPAGE( 9 ) ) == 0x09U, "least recently used page programmed", prvFlashByte( mainPAGE( 9 ) ) );
+	prvCheck( prvFlashByte( mainPAGE( 8 ) ) == 0xffU, "page read recently kept", prvFlashByte( mainPAGE( 8 ) ) );
+	prvCheck( prvFlashByte( mainPAGE( 10 ) ) == 0xffU, "third page kept", prvFlashByte( mainPAGE( 10 ) ) );
+	prvCheck( prvFlashByte( mainPAGE( 11 ) ) == 0xffU, "fourth page kept", prvFlashByte( mainPAGE( 11 ) ) );
+
+	/* A write to page 10 leaves page 11 the one used least recently. */
+	prvWriteByte( mainPAGE( 10 ) + 1UL, 0x1a, pdTRUE );
+	prvWriteByte( mainPAGE( 13 ), 0x0d, pdFALSE );
+	xExpected.ulEvictions++;
+	xExpected.ulFlushes++;
+	xExpected.ulBytesFlushed++;
+
+	prvCheck( prvFlashByte( mainPAGE( 11 ) ) == 0x0bU, "next least recently used page programmed", prvFlashByte( mainPAGE( 11 ) ) );
+	prvCheck( prvFlashByte( mainPAGE( 10 ) ) == 0xffU, "page written recently kept", prvFlashByte( mainPAGE( 10 ) ) );
+
+	/* The page programmed to make room is read back from the flash. */
+	ulReads0 = ulReads;
+	vFlashCacheRead( mainPAGE( 9 ), ucBuffer, 1 );
+	xExpected.ulReadMisses++;
+	prvCheck( ( ucBuffer[ 0 ] == 0x09U ) && ( ulReads == ( ulReads0 + 1UL ) ), "evicted page read from the flash", ucBuffer[ 0 ] );
+
+	/* Pages 8, 10, 12 and 13 are still to be programmed. */
+	ulPrograms0 = ulPrograms;
+	vFlashCacheFlush();
+	xExpected.ulFlushes += 4UL;
+	xExpected.ulBytesFlushed += 5UL;
+	prvCheck( ulPrograms == ( ulPrograms0 + 4UL ), "lines kept flushed", ulPrograms - ulPrograms0 );
+	prvCheck( prvFlashByte( mainPAGE( 10 ) + 1UL ) == 0x1aU, "kept page flushed", prvFlashByte( mainPAGE( 10 ) + 1UL ) );
+
+	prvCheckStats( "eviction" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEraseTest( void )
+{
+uint32_t ulPrograms0, ulReads0;
+
+	/* Two changed pages in the second sector, and one in the first. */
+	prvWriteByte( mainSECTOR_1, 0x01, pdFALSE );
+	prvWriteByte( mainSECTOR_1 + mainPAGE( 1 ), 0x02, pdFALSE );
+	prvWriteByte( mainPAGE( 14 ), 0x0e, pdFALSE );
+
+	/* Any address in the sector erases it. */
+	vFlashCacheEraseSector( mainSECTOR_1 + 0x1234UL );
+	prvCheck( ulFlashSimErases( mainSECTOR_1 ) == 1UL, "sector erased", ulFlashSimErases( mainSECTOR_1 ) );
+
+	/* The pages of the erased sector are no longer cached. */
+	ulReads0 = ulReads;
+	vFlashCacheRead( mainSECTOR_1, ucBuffer, 1 );
+	vFlashCacheRead( mainSECTOR_1 + mainPAGE( 1 ), &( ucBuffer[ 1 ] ), 1 );
+	xExpected.ulReadMisses += 2UL;
+	prvCheck( ( ucBuffer[ 0 ] == 0xffU ) && ( ucBuffer[ 1 ] == 0xffU ), "erased pages read erased", ucBuffer[ 0 ] );
+	prvCheck( ulReads == ( ulReads0 + 2UL ), "erased pages read from the flash", ulReads - ulReads0 );
+
+	/* So only the page of the other sector is programmed. */
+	ulPrograms0 = ulPrograms;
+	vFlashCacheFlush();
+	xExpected.ulFlushes++;
+	xExpected.ulBytesFlushed++;
+	prvCheck( ulPrograms == ( ulPrograms0 + 1UL ), "erased pages not programmed", ulPrograms - ulPrograms0 );
+	prvCheck( prvFlashByte( mainSECTOR_1 ) == 0xffU, "erased page stays erased", prvFlashByte( mainSECTOR_1 ) );
+	prvCheck( prvFlashByte( mainPAGE( 14 ) ) == 0x0eU, "page of another sector kept", prvFlashByte( mainPAGE( 14 ) ) );
+
+	vFlashCacheRead( mainPAGE( 14 ), ucBuffer, 1 );
+	xExpected.ulReadHits++;
+
+	prvCheckStats( "erase" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBackgroundTest( void )
+{
+	prvWriteByte( mainPAGE( 15 ), 0x0f, pdFALSE );
+
+	/* The task that programs the page runs while this one is delayed, but
+	waits for later writes first. */
+	vTaskDelay( flashcacheFLUSH_DELAY / 2 );
+	prvCheck( prvFlashByte( mainPAGE( 15 ) ) == 0xffU, "page not programmed before the delay", prvFlashByte( mainPAGE( 15 ) ) );
+
+	vTaskDelay( flashcacheFLUSH_DELAY * 2 );
+	xExpected.ulFlushes++;
+	xExpected.ulBytesFlushed++;
+	prvCheck( prvFlashByte( mainPAGE( 15 ) ) == 0x0fU, "page programmed after the delay", prvFlashByte( mainPAGE( 15 ) ) );
+
+	prvCheckStats( "background" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteByte( uint32_t ulAddress, uint8_t ucValue, BaseType_t xHit )
+{
+	vFlashCacheWrite( ulAddress, &ucValue, 1 );
+	xExpected.ulBytesWritten++;
+
+	if( xHit != pdFALSE )
+	{
+		xExpected.ulWriteHits++;
+	}
+	else
+	{
+		xExpected.ulWriteMisses++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvFlashByte( uint32_t ulAddress )
+{
+uint8_t ucByte;
+
+	vFlashSimRead( ulAddress, &ucByte, 1 );
+
+	return ucByte;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckStats( const char *pcTest )
+{
+FlashCacheStats_t xStats;
+
+	vFlashCacheGetStats( &xStats );
+
+	if( memcmp( ( void * ) &xStats, ( void * ) &xExpected, sizeof( xStats ) ) != 0 )
+	{
+		printf( "Statistics after the %s test: read hits %lu, misses %lu, write hits %lu, misses %lu, evictions %lu, flushes %lu, bytes written %lu, flushed %lu\n",
+				pcTest,
+				( unsigned long ) xStats.ulReadHits, ( unsigned long ) xStats.ulReadMisses,
+				( unsigned long ) xStats.ulWriteHits, ( unsigned long ) xStats.ulWriteMisses,
+				( unsigned long ) xStats.ulEvictions, ( unsigned long ) xStats.ulFlushes,
+				( unsigned long ) xStats.ulBytesWritten, ( unsigned long ) xStats.ulBytesFlushed );
+	}
+
+	prvCheck( xStats.ulReadHits == xExpected.ulReadHits, "read hits", xExpected.ulReadHits );
+	prvCheck( xStats.ulReadMisses == xExpected.ulReadMisses, "read misses", xExpected.ulReadMisses );
+	prvCheck( xStats.ulWriteHits == xExpected.ulWriteHits, "write hits", xExpected.ulWriteHits );
+	prvCheck( xStats.ulWriteMisses == xExpected.ulWriteMisses, "write misses", xExpected.ulWriteMisses );
+	prvCheck( xStats.ulEvictions == xExpected.ulEvictions, "evictions", xExpected.ulEvictions );
+	prvCheck( xStats.ulFlushes == xExpected.ulFlushes, "flushes", xExpected.ulFlushes );
+	prvCheck( xStats.ulBytesWritten == xExpected.ulBytesWritten, "bytes written", xExpected.ulBytesWritten );
+	prvCheck( xStats.ulBytesFlushed == xExpected.ulBytesFlushed, "bytes flushed", xExpected.ulBytesFlushed );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		printf( "Failed %s (%lu)\n", pcCheck, ulValue );
+		xFailed = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,660 @@
+/*
+	Tests the key-value store of flash_kv.c on the host build, against the
+	simulated NOR flash of flash_sim.c.
+
+	After checking the simulation itself behaves as NOR flash does, the store is
+	written, read and deleted from, and opened again from the file the flash is
+	held in.  Every value written is also kept in RAM, and the store must
+	always return the same.
+
+	Thousands of updates are then made, so the sectors are garbage collected
+	many times over, copying the values that are never updated each time, and
+	the sectors must have been erased evenly.  The store
+	is filled until a write fails, after which the values already held must
+	still be intact and writes that do not add to them must still succeed.
+
+	Finally the power is made to fail at every step - each byte programmed and
+	each page erased - of an update, of a deletion, and of an update that has
+	to garbage collect a sector first.  Each time the store is opened again
+	and the key must hold either its old or its new value, every other key
+	must be unchanged, and the store must still take writes.
+
+	Nothing here needs the scheduler, so the tests run straight from main(),
+	which exits with 0 if every check passed, or 1 after naming those that
+	failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+
+/* Demo application includes. */
+#include "flash_kv.h"
+#include "flash_sim.h"
+
+/* The files the flash is held in, and copied to so the power can be failed
+again and again from the same starting point. */
+#define mainFLASH_FILE					"flash_kv.bin"
+#define mainSNAPSHOT_FILE				"flash_kv_snapshot.bin"
+
+/* The store uses the whole of a flash of four sectors. */
+#define mainSECTORS						4UL
+#define mainFLASH_SIZE					( mainSECTORS * flashsimSECTOR_SIZE )
+
+/* The keys the garbage collection and power failure tests use.  The
+garbage collection test updates the live keys and writes the cold keys, which
+follow them, only once, so they have to be copied as sectors are collected. */
+#define mainLIVE_KEYS					8U
+#define mainCOLD_KEYS					8U
+
+/* The updates made by the garbage collection test. */
+#define mainUPDATES						10000UL
+
+/* The keys of the power failure tests. */
+#define mainUPDATED_KEY					3U
+#define mainDELETED_KEY					5U
+#define mainOTHER_KEY					6U
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The tests.
+ */
+static void prvSimulationTests( void );
+static void prvBasicTests( void );
+static void prvCollectionTests( void );
+static void prvFullTests( void );
+static void prvPowerFailTests( void );
+
+/*
+ * Fails the power at each step of one operation in turn, starting each time
+ * from the snapshot, and checks the store once it has been opened again.
+ * usKey is written with a value of usLength bytes, or deleted if xDelete is
+ * pdTRUE.
+ */
+static void prvPowerFailSweep( const char *pcName, uint16_t usKey, uint16_t usLength, BaseType_t xDelete );
+
+/*
+ * Writes a value of usLength bytes made from ulSeed to usKey, and to the copy
+ * kept in RAM if it was written.
+ */
+static BaseType_t prvWrite( uint16_t usKey, uint16_t usLength, uint32_t ulSeed );
+
+/*
+ * Deletes usKey from the store and the copy kept in RAM.
+ */
+static BaseType_t prvDelete( uint16_t usKey );
+
+/*
+ * Returns pdTRUE if usKey holds usLength bytes equal to pucValue, or has no
+ * value if pucValue is NULL.
+ */
+static BaseType_t prvKeyHolds( uint16_t usKey, const uint8_t *pucValue, uint16_t usLength );
+
+/*
+ * Returns the number of keys whose value differs from the copy kept in RAM.
+ */
+static unsigned long prvVerify( void );
+
+/*
+ * Starts a new store on erased flash, and clears the copy kept in RAM.
+ */
+static void prvErasedStore( void );
+
+/*
+ * Closes the flash and opens it again from its file, then opens the store.
+ */
+static void prvReopen( void );
+
+/*
+ * Copies the file pcFrom to pcTo.
+ */
+static void prvCopyFile( const char *pcFrom, const char *pcTo );
+
+/*
+ * Records a failed check.  ulValue is printed to help find the cause.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+static const FlashKVDevice_t xDevice =
+{
+	vFlashSimRead,
+	vFlashSimProgram,
+	vFlashSimEraseSector,
+	0UL,
+	flashsimSECTOR_SIZE,
+	mainSECTORS
+};
+
+/* The values the store should hold. */
+static uint8_t ucModel[ flashkvMAX_KEYS ][ flashkvMAX_VALUE_LENGTH ];
+static uint16_t usModelLength[ flashkvMAX_KEYS ];
+static BaseType_t xModelHeld[ flashkvMAX_KEYS ];
+
+static uint8_t ucBuffer[ flashkvMAX_VALUE_LENGTH ];
+
+/* Set to pdTRUE by any check that fails. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	prvSimulationTests();
+	prvBasicTests();
+	prvCollectionTests();
+	prvFullTests();
+	prvPowerFailTests();
+
+	( void ) unlink( mainFLASH_FILE );
+	( void ) unlink( mainSNAPSHOT_FILE );
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All flash key-value store tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSimulationTests( void )
+{
+static const uint8_t ucOnes[ 8 ] = { 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0 };
+static const uint8_t ucTwos[ 8 ] = { 0x0f, 0x3c, 0x0f, 0x3c, 0x0f, 0x3c, 0x0f, 0x3c };
+uint8_t ucRead[ 8 ];
+uint32_t ul;
+
+	( void ) unlink( mainFLASH_FILE );
+	prvCheck( xFlashSimOpen( mainFLASH_FILE, mainFLASH_SIZE ), "flash opened", 0 );
+
+	vFlashSimRead( mainFLASH_SIZE - 8UL, ucRead, 8 );
+	prvCheck( ( ucRead[ 7 ] == 0xffU ) ? pdTRUE : pdFALSE, "new flash erased", ucRead[ 7 ] );
+
+	/* Programming can only clear bits. */
+	vFlashSimProgram( 0, ucOnes, 8 );
+	vFlashSimProgram( 0, ucTwos, 8 );
+	vFlashSimRead( 0, ucRead, 8 );
+	prvCheck( ( ( ucRead[ 0 ] == 0x00U ) && ( ucRead[ 1 ] == 0x30U ) ) ? pdTRUE : pdFALSE, "programming clears bits", ucRead[ 1 ] );
+
+	/* Across a page boundary, which the chip would wrap to the start of the
+	first page. */
+	vFlashSimProgram( ( 2UL * flashsimSECTOR_SIZE ) + flashsimPAGE_SIZE - 4UL, ucOnes, 8 );
+	vFlashSimRead( 2UL * flashsimSECTOR_SIZE, &( ucRead[ 0 ] ), 1 );
+	vFlashSimRead( ( 2UL * flashsimSECTOR_SIZE ) + flashsimPAGE_SIZE + 3UL, &( ucRead[ 1 ] ), 1 );
+	prvCheck( ( ( ucRead[ 0 ] == 0xffU ) && ( ucRead[ 1 ] == 0xf0U ) ) ? pdTRUE : pdFALSE, "program across a page", ucRead[ 1 ] );
+
+	/* Power failing part way through a program. */
+	vFlashSimPowerFailAfter( 3 );
+	vFlashSimProgram( 0x100UL * 3UL, ucTwos, 8 );
+	vFlashSimProgram( 0x100UL * 4UL, ucTwos, 8 );
+	prvCheck( xFlashSimPowerFailed(), "power failed", 0 );
+	vFlashSimPowerOn();
+	vFlashSimRead( 0x100UL * 3UL, ucRead, 8 );
+	prvCheck( ( ( ucRead[ 2 ] == 0x0fU ) && ( ucRead[ 3 ] == 0xffU ) ) ? pdTRUE : pdFALSE, "program cut short", ucRead[ 3 ] );
+	vFlashSimRead( 0x100UL * 4UL, ucRead, 8 );
+	prvCheck( ( ucRead[ 0 ] == 0xffU ) ? pdTRUE : pdFALSE, "nothing programmed without power", ucRead[ 0 ] );
+
+	/* An erase sets every byte of the sector, and one cut short only the
+	pages it reached. */
+	vFlashSimProgram( flashsimSECTOR_SIZE - 1UL, ucOnes, 2 );
+	vFlashSimEraseSector( 0 );
+	vFlashSimRead( 0, ucRead, 8 );
+	prvCheck( ( ucRead[ 0 ] == 0xffU ) ? pdTRUE : pdFALSE, "erase sets the start of the sector", ucRead[ 0 ] );
+	vFlashSimRead( flashsimSECTOR_SIZE - 1UL, ucRead, 2 );
+	prvCheck( ( ( ucRead[ 0 ] == 0xffU ) && ( ucRead[ 1 ] == 0xf0U ) ) ? pdTRUE : pdFALSE, "erase stops at the end of the sector", ucRead[ 1 ] );
+	prvCheck( ( ulFlashSimErases( 0 ) == 1UL ) ? pdTRUE : pdFALSE, "erase counted", ulFlashSimErases( 0 ) );
+
+	for( ul = 0; ul < ( flashsimSECTOR_SIZE / flashsimPAGE_SIZE ); ul++ )
+	{
+		vFlashSimProgram( ul * flashsimPAGE_SIZE, ucOnes, 1 );
+	}
+
+	vFlashSimPowerFailAfter( 10 );
+	vFlashSimEraseSector( 0 );
+	vFlashSimPowerOn();
+	vFlashSimRead( 9UL * flashsimPAGE_SIZE, &( ucRead[ 0 ] ), 1 );
+	vFlashSimRead( 10UL * flashsimPAGE_SIZE, &( ucRead[ 1 ] ), 1 );
+	prvCheck( ( ( ucRead[ 0 ] == 0xffU ) && ( ucRead[ 1 ] == 0xf0U ) ) ? pdTRUE : pdFALSE, "erase cut short", ucRead[ 1 ] );
+	prvCheck( ( ulFlashSimErases( 0 ) == 1UL ) ? pdTRUE : pdFALSE, "erase cut short not counted", ulFlashSimErases( 0 ) );
+
+	/* What was programmed is still there once the file is opened again. */
+	vFlashSimClose();
+	prvCheck( xFlashSimOpen( mainFLASH_FILE, mainFLASH_SIZE ), "flash opened again", 0 );
+	vFlashSimRead( 10UL * flashsimPAGE_SIZE, &( ucRead[ 0 ] ), 1 );
+	prvCheck( ( ucRead[ 0 ] == 0xf0U ) ? pdTRUE : pdFALSE, "flash kept in its file", ucRead[ 0 ] );
+	vFlashSimClose();
+}
+/*-----------------------------------------------------------*/
+
+static void prvBasicTests( void )
+{
+FlashKVStats_t xStats;
+uint16_t usLength = 0;
+uint16_t usKey;
+
+	prvErasedStore();
+
+	vFlashKVGetStats( &xStats );
+	prvCheck( ( xStats.ulFreeSectors == mainSECTORS ) ? pdTRUE : pdFALSE, "erased flash holds an empty store", xStats.ulFreeSectors );
+	prvCheck( ( xFlashKVRead( 0, ucBuffer, sizeof( ucBuffer ), NULL ) == pdFAIL ) ? pdTRUE : pdFALSE, "empty store has no values", 0 );
+
+	for( usKey = 0; usKey < 20U; usKey++ )
+	{
+		prvCheck( prvWrite( usKey, ( uint16_t ) ( usKey * 5U ), usKey ), "write", usKey );
+	}
+
+	prvCheck( prvWrite( 7, flashkvMAX_VALUE_LENGTH, 1000 ), "write replacing a value", 7 );
+	prvCheck( prvDelete( 9 ), "delete", 9 );
+	prvCheck( prvDelete( 9 ), "delete a key with no value", 9 );
+	prvCheck( ( prvVerify() == 0UL ) ? pdTRUE : pdFALSE, "values held", prvVerify() );
+
+	/* A value longer than the buffer is cut short, and its length given. */
+	prvCheck( xFlashKVRead( 7, ucBuffer, 4, &usLength ), "read into a short buffer", 7 );
+	prvCheck( ( ( usLength == flashkvMAX_VALUE_LENGTH ) && ( memcmp( ucBuffer, ucModel[ 7 ], 4 ) == 0 ) ) ? pdTRUE : pdFALSE, "short buffer filled", usLength );
+
+	prvCheck( ( xFlashKVWrite( flashkvMAX_KEYS, ucBuffer, 1 ) == pdFAIL ) ? pdTRUE : pdFALSE, "key out of range refused", 0 );
+	prvCheck( ( xFlashKVWrite( 0, ucBuffer, flashkvMAX_VALUE_LENGTH + 1U ) == pdFAIL ) ? pdTRUE : pdFALSE, "value too long refused", 0 );
+	prvCheck( ( xFlashKVDelete( flashkvMAX_KEYS ) == pdFAIL ) ? pdTRUE : pdFALSE, "delete out of range refused", 0 );
+
+	/* The values survive the flash being closed and opened again. */
+	prvReopen();
+	prvCheck( ( prvVerify() == 0UL ) ? pdTRUE : pdFALSE, "values held once opened again", prvVerify() );
+
+	vFlashKVGetStats( &xStats );
+	prvCheck( ( xStats.ulTornRecords == 0UL ) ? pdTRUE : pdFALSE, "no torn records", xStats.ulTornRecords );
+	vFlashSimClose();
+}
+/*-----------------------------------------------------------*/
+
+static void prvCollectionTests( void )
+{
+FlashKVStats_t xStats;
+uint32_t ulUpdate, ulSector, ulErases, ulFewest = 0xffffffffUL, ulMost = 0;
+uint32_t ulRandom = 0x2468aceUL;
+unsigned long ulFailedWrites = 0;
+uint16_t usKey;
+
+	prvErasedStore();
+
+	for( usKey = mainLIVE_KEYS; usKey < ( mainLIVE_KEYS + mainCOLD_KEYS ); usKey++ )
+	{
+		prvCheck( prvWrite( usKey, ( uint16_t ) ( usKey * 3U ), usKey ), "cold key written", usKey );
+	}
+
+	for( ulUpdate = 0; ulUpdate < mainUPDATES; ulUpdate++ )
+	{
+		ulRandom = ( ulRandom * 1664525UL ) + 1013904223UL;
+
+		if( prvWrite( ( uint16_t ) ( ( ulRandom >> 8 ) % mainLIVE_KEYS ), ( uint16_t ) ( ( ulRandom >> 16 ) % ( flashkvMAX_VALUE_LENGTH + 1U ) ), ulUpdate ) != pdPASS )
+		{
+			ulFailedWrites++;
+		}
+	}
+
+	prvCheck( ( ulFailedWrites == 0UL ) ? pdTRUE : pdFALSE, "updates failed", ulFailedWrites );
+	prvCheck( ( prvVerify() == 0UL ) ? pdTRUE : pdFALSE, "values held after collection", prvVerify() );
+
+	vFlashKVGetStats( &xStats );
+	prvCheck( ( xStats.ulRecordsWritten == ( mainUPDATES + mainCOLD_KEYS ) ) ? pdTRUE : pdFALSE, "records written", xStats.ulRecordsWritten );
+	prvCheck( ( xStats.ulRecordsCopied > 0UL ) ? pdTRUE : pdFALSE, "records copied", xStats.ulRecordsCopied );
+	prvCheck( ( xStats.ulSectorsErased > ( 2UL * mainSECTORS ) ) ? pdTRUE : pdFALSE, "sectors erased", xStats.ulSectorsErased );
+
+	/* The sectors are erased in turn. */
+	for( ulSector = 0; ulSector < mainSECTORS; ulSector++ )
+	{
+		ulErases = ulFlashSimErases( ulSector * flashsimSECTOR_SIZE );
+		ulFewest = ( ulErases < ulFewest ) ? ulErases : ulFewest;
+		ulMost = ( ulErases > ulMost ) ? ulErases : ulMost;
+	}
+
+	prvCheck( ( ( ulMost - ulFewest ) <= 1UL ) ? pdTRUE : pdFALSE, "sectors erased evenly", ulMost - ulFewest );
+
+	prvReopen();
+	prvCheck( ( prvVerify() == 0UL ) ? pdTRUE : pdFALSE, "values held after collection once opened again", prvVerify() );
+	vFlashSimClose();
+}
+/*-----------------------------------------------------------*/
+
+static void prvFullTests( void )
+{
+uint16_t usKey, usFull = flashkvMAX_KEYS;
+uint32_t ulUpdate;
+unsigned long ulFailedWrites = 0;
+
+	prvErasedStore();
+
+	/* Fill the store with the largest values. */
+	for( usKey = 0; usKey < flashkvMAX_KEYS; usKey++ )
+	{
+		if( prvWrite( usKey, flashkvMAX_VALUE_LENGTH, usKey ) != pdPASS )
+		{
+			usFull = usKey;
+			break;
+		}
+	}
+
+	prvCheck( ( usFull < flashkvMAX_KEYS ) ? pdTRUE : pdFALSE, "full store refuses a write", usFull );
+	prvCheck( ( prvVerify() == 0UL ) ? pdTRUE : pdFALSE, "values held when full", prvVerify() );
+
+	/* Replacing values with ones of the same length does not need more
+	room, however many collections it takes. */
+	for( ulUpdate = 0; ulUpdate < ( 3UL * usFull ); ulUpdate++ )
+	{
+		if( prvWrite( ( uint16_t ) ( ( ulUpdate * 7UL ) % usFull ), flashkvMAX_VALUE_LENGTH, ulUpdate + 5000UL ) != pdPASS )
+		{
+			ulFailedWrites++;
+		}
+	}
+
+	prvCheck( ( ulFailedWrites == 0UL ) ? pdTRUE : pdFALSE, "updates of a full store failed", ulFailedWrites );
+
+	/* Deleting makes room again. */
+	prvCheck( prvDelete( 0 ), "delete from a full store", 0 );
+	prvCheck( prvWrite( usFull, flashkvMAX_VALUE_LENGTH, 9999 ), "write once room made", usFull );
+	prvCheck( ( prvVerify() == 0UL ) ? pdTRUE : pdFALSE, "values held after filling", prvVerify() );
+
+	prvReopen();
+	prvCheck( ( prvVerify() == 0UL ) ? pdTRUE : pdFALSE, "values held after filling once opened again", prvVerify() );
+	vFlashSimClose();
+}
+/*-----------------------------------------------------------*/
+
+static void prvPowerFailTests( void )
+{
+FlashKVStats_t xStats;
+uint16_t usKey;
+uint32_t ulUpdate = 0;
+
+	/* Update and delete within the sector being filled. */
+	prvErasedStore();
+
+	for( usKey = 0; usKey < mainLIVE_KEYS; usKey++ )
+	{
+		( void ) prvWrite( usKey, ( uint16_t ) ( 10U + ( usKey * 13U ) ), usKey );
+	}
+
+	vFlashSimClose();
+	prvCopyFile( mainFLASH_FILE, mainSNAPSHOT_FILE );
+
+	prvPowerFailSweep( "update", mainUPDATED_KEY, 77, pdFALSE );
+	prvPowerFailSweep( "delete", mainDELETED_KEY, 0, pdTRUE );
+
+	/* Update until the next update has to open a sector, which leaves only
+	the free one, so must first collect the oldest. */
+	prvErasedStore();
+
+	for( ;; )
+	{
+		vFlashKVGetStats( &xStats );
+
+		if( ( xStats.ulFreeSectors == 2UL ) && ( xStats.ulFreeBytes < ( 8UL + flashkvMAX_VALUE_LENGTH ) ) )
+		{
+			break;
+		}
+
+		( void ) prvWrite( ( uint16_t ) ( ulUpdate % mainLIVE_KEYS ), ( uint16_t ) ( ulUpdate % 61UL ), ulUpdate );
+		ulUpdate++;
+	}
+
+	vFlashSimClose();
+	prvCopyFile( mainFLASH_FILE, mainSNAPSHOT_FILE );
+
+	prvPowerFailSweep( "update that collects", mainUPDATED_KEY, flashkvMAX_VALUE_LENGTH, pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPowerFailSweep( const char *pcName, uint16_t usKey, uint16_t usLength, BaseType_t xDelete )
+{
+static uint8_t ucOld[ flashkvMAX_VALUE_LENGTH ], ucNew[ flashkvMAX_VALUE_LENGTH ];
+static uint8_t ucSavedModel[ flashkvMAX_KEYS ][ flashkvMAX_VALUE_LENGTH ];
+static uint16_t usSavedLength[ flashkvMAX_KEYS ];
+static BaseType_t xSavedHeld[ flashkvMAX_KEYS ];
+BaseType_t xOldHeld;
+uint16_t usOldLength;
+uint32_t ulStep, ulSteps;
+unsigned long ulNeither = 0, ulOthersChanged = 0, ulUnusable = 0, ulOld = 0, ulNew = 0;
+
+	memcpy( ( void * ) ucSavedModel, ( const void * ) ucModel, sizeof( ucModel ) );
+	memcpy( ( void * ) usSavedLength, ( const void * ) usModelLength, sizeof( usModelLength ) );
+	memcpy( ( void * ) xSavedHeld, ( const void * ) xModelHeld, sizeof( xModelHeld ) );
+
+	xOldHeld = xModelHeld[ usKey ];
+	usOldLength = usModelLength[ usKey ];
+	memcpy( ( void * ) ucOld, ( const void * ) ucModel[ usKey ], sizeof( ucOld ) );
+
+	/* Count the steps the operation takes when the power stays on. */
+	prvCopyFile( mainSNAPSHOT_FILE, mainFLASH_FILE );
+	prvCheck( xFlashSimOpen( mainFLASH_FILE, mainFLASH_SIZE ), "flash opened", 0 );
+	( void ) xFlashKVInit( &xDevice );
+	ulSteps = ulFlashSimSteps();
+	prvCheck( ( xDelete != pdFALSE ) ? prvDelete( usKey ) : prvWrite( usKey, usLength, 0x5a5aUL ), pcName, 0 );
+	ulSteps = ulFlashSimSteps() - ulSteps;
+	memcpy( ( void * ) ucNew, ( const void * ) ucModel[ usKey ], sizeof( ucNew ) );
+	vFlashSimClose();
+
+	for( ulStep = 0; ulStep < ulSteps; ulStep++ )
+	{
+		memcpy( ( void * ) ucModel, ( const void * ) ucSavedModel, sizeof( ucModel ) );
+		memcpy( ( void * ) usModelLength, ( const void * ) usSavedLength, sizeof( usModelLength ) );
+		memcpy( ( void * ) xModelHeld, ( const void * ) xSavedHeld, sizeof( xModelHeld ) );
+
+		prvCopyFile( mainSNAPSHOT_FILE, mainFLASH_FILE );
+		( void ) xFlashSimOpen( mainFLASH_FILE, mainFLASH_SIZE );
+		( void ) xFlashKVInit( &xDevice );
+
+		vFlashSimPowerFailAfter( ulStep );
+
+		if( xDelete != pdFALSE )
+		{
+			( void ) xFlashKVDelete( usKey );
+		}
+		else
+		{
+			( void ) xFlashKVWrite( usKey, ucNew, usLength );
+		}
+
+		prvCheck( xFlashSimPowerFailed(), "power failed", ulStep );
+		vFlashSimPowerOn();
+
+		/* Start again from what the flash holds. */
+		( void ) xFlashKVInit( &xDevice );
+
+		if( ( xOldHeld != pdFALSE ) && ( prvKeyHolds( usKey, ucOld, usOldLength ) != pdFALSE ) )
+		{
+			ulOld++;
+		}
+		else if( ( xOldHeld == pdFALSE ) && ( prvKeyHolds( usKey, NULL, 0 ) != pdFALSE ) )
+		{
+			ulOld++;
+		}
+		else if( prvKeyHolds( usKey, ( xDelete != pdFALSE ) ? NULL : ucNew, usLength ) != pdFALSE )
+		{
+			ulNew++;
+		}
+		else
+		{
+			ulNeither++;
+		}
+
+		/* The model still holds the old value of the key, so only the others
+		are compared. */
+		xModelHeld[ usKey ] = pdFALSE;
+		( void ) xFlashKVDelete( usKey );
+
+		if( prvVerify() != 0UL )
+		{
+			ulOthersChanged++;
+		}
+
+		/* The store must still work, and keep working once opened again. */
+		if( ( prvWrite( mainOTHER_KEY, 40, ulStep ) != pdPASS ) || ( prvVerify() != 0UL ) )
+		{
+			ulUnusable++;
+		}
+		else
+		{
+			( void ) xFlashKVInit( &xDevice );
+
+			if( prvVerify() != 0UL )
+			{
+				ulUnusable++;
+			}
+		}
+
+		vFlashSimClose();
+	}
+
+	if( ( ulNeither != 0UL ) || ( ulOthersChanged != 0UL ) || ( ulUnusable != 0UL ) )
+	{
+		printf( "Power failed %s: %lu steps, %lu old, %lu new, %lu neither, %lu others changed, %lu unusable\n", pcName, ( unsigned long ) ulSteps, ulOld, ulNew, ulNeither, ulOthersChanged, ulUnusable );
+	}
+
+	prvCheck( ( ulNeither == 0UL ) ? pdTRUE : pdFALSE, "power failure left neither value", ulNeither );
+	prvCheck( ( ulOthersChanged == 0UL ) ? pdTRUE : pdFALSE, "power failure changed other keys", ulOthersChanged );
+	prvCheck( ( ulUnusable == 0UL ) ? pdTRUE : pdFALSE, "power failure left the store unusable", ulUnusable );
+
+	/* Leave the flash as the operation left it without a power failure. */
+	memcpy( ( void * ) ucModel, ( const void * ) ucSavedModel, sizeof( ucModel ) );
+	memcpy( ( void * ) usModelLength, ( const void * ) usSavedLength, sizeof( usModelLength ) );
+	memcpy( ( void * ) xModelHeld, ( const void * ) xSavedHeld, sizeof( xModelHeld ) );
+	prvCopyFile( mainSNAPSHOT_FILE, mainFLASH_FILE );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvWrite( uint16_t usKey, uint16_t usLength, uint32_t ulSeed )
+{
+uint8_t ucValue[ flashkvMAX_VALUE_LENGTH ];
+uint16_t us;
+
+	for( us = 0; us < usLength; us++ )
+	{
+		ucValue[ us ] = ( uint8_t ) ( ( ulSeed * 31UL ) + ( us * 7U ) + usKey );
+	}
+
+	if( xFlashKVWrite( usKey, ucValue, usLength ) != pdPASS )
+	{
+		return pdFAIL;
+	}
+
+	memcpy( ( void * ) ucModel[ usKey ], ( const void * ) ucValue, usLength );
+	usModelLength[ usKey ] = usLength;
+	xModelHeld[ usKey ] = pdTRUE;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDelete( uint16_t usKey )
+{
+	if( xFlashKVDelete( usKey ) != pdPASS )
+	{
+		return pdFAIL;
+	}
+
+	xModelHeld[ usKey ] = pdFALSE;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvKeyHolds( uint16_t usKey, const uint8_t *pucValue, uint16_t usLength )
+{
+uint16_t usHeld = 0;
+
+	if( xFlashKVRead( usKey, ucBuffer, sizeof( ucBuffer ), &usHeld ) != pdPASS )
+	{
+		return ( pucValue == NULL ) ? pdTRUE : pdFALSE;
+	}
+
+	if( ( pucValue == NULL ) || ( usHeld != usLength ) || ( memcmp( ucBuffer, pucValue, usLength ) != 0 ) )
+	{
+		return pdFALSE;
+	}
+
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static unsigned long prvVerify( void )
+{
+unsigned long ulDiffer = 0;
+uint16_t usKey;
+
+	for( usKey = 0; usKey < flashkvMAX_KEYS; usKey++ )
+	{
+		if( prvKeyHolds( usKey, ( xModelHeld[ usKey ] != pdFALSE ) ? ucModel[ usKey ] : NULL, usModelLength[ usKey ] ) == pdFALSE )
+		{
+			ulDiffer++;
+		}
+	}
+
+	return ulDiffer;
+}
+/*-----------------------------------------------------------*/
+
+static void prvErasedStore( void )
+{
+	( void ) unlink( mainFLASH_FILE );
+	prvCheck( xFlashSimOpen( mainFLASH_FILE, mainFLASH_SIZE ), "flash opened", 0 );
+	prvCheck( xFlashKVInit( &xDevice ), "store opened", 0 );
+
+	memset( ( void * ) xModelHeld, 0x00, sizeof( xModelHeld ) );
+	memset( ( void * ) usModelLength, 0x00, sizeof( usModelLength ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvReopen( void )
+{
+	vFlashSimClose();
+	prvCheck( xFlashSimOpen( mainFLASH_FILE, mainFLASH_SIZE ), "flash opened again", 0 );
+	prvCheck( xFlashKVInit( &xDevice ), "store opened again", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCopyFile( const char *pcFrom, const char *pcTo )
+{
+static uint8_t ucCopy[ mainFLASH_SIZE ];
+FILE *pxFrom, *pxTo;
+size_t xRead = 0;
+
+	pxFrom = fopen( pcFrom, "rb" );
+	pxTo = fopen( pcTo, "wb" );
+
+	if( ( pxFrom != NULL ) && ( pxTo != NULL ) )
+	{
+		xRead = fread( ucCopy, 1, sizeof( ucCopy ), pxFrom );
+		prvCheck( ( fwrite( ucCopy, 1, xRead, pxTo ) == sizeof( ucCopy ) ) ? pdTRUE : pdFALSE, "flash file copied", ( unsigned long ) xRead );
+	}
+	else
+	{
+		prvCheck( pdFALSE, "flash file opened to copy", 0 );
+	}
+
+	if( pxFrom != NULL )
+	{
+		fclose( pxFrom );
+	}
+
+	if( pxTo != NULL )
+	{
+		fclose( pxTo );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		printf( "Failed %s (%lu)\n", pcCheck, ulValue );
+		xFailed = pdTRUE;
+	}
+}
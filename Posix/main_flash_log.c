@@ -0,0 +1,701 @@
+/*
+	Tests the circular telemetry log of flash_log.c on the host build.
+	SPI_FLASH_BufferRead(), SPI_FLASH_PageWrite() and SPI_FLASH_SectorErase()
+	are provided here, on the simulated NOR flash of flash_sim.c, which is held
+	in a file.
+
+	The log is opened when the program boots, so each boot of the target is a
+	child process that opens the flash from its file, runs the scheduler with a
+	task that opens the log, reads the whole log, writes records and reads them
+	back, then ends.  Each record holds its number, and its length and contents
+	follow from the number, so every record read can be checked, and the log
+	must always hold records with consecutive numbers.
+
+	+ The first boot starts a log on erased flash, which must erase the first
+	  two sectors, and writes records to it.
+
+	+ The second boot must find the end of the log from what the flash holds,
+	  without erasing anything, and the records it writes must follow on from
+	  those of the first boot.
+
+	+ The power is then made to fail at each byte programmed of a record,
+	  starting each time from a copy of the flash taken after the second boot.
+	  The boot after that must skip the record, whether its header or only its
+	  data was torn, keep every record before it, and carry on logging.  The
+	  record must be kept once every byte of it was programmed.
+
+	+ Enough records are then written to fill every sector more than once.
+	  Each time the log moves into a sector, the sector after it must already
+	  have been erased, and the oldest records are lost with it.  A last boot
+	  must find the end of the log again once its sectors have wrapped.
+
+	+ Finally the sector being filled is filled to the last record that fits,
+	  and the power is made to fail at steps of the move into the next sector
+	  the next record makes: while the header of the sector is programmed,
+	  while the sector after it is erased, and while the record is programmed.
+	  The boot after that must again skip the record, finish erasing the
+	  sector ahead of the log, and carry on logging.
+
+	The program exits with 0 if every check passed, or 1 after naming those
+	that failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo application includes. */
+#include "spi_flash.h"
+#include "flash_log.h"
+#include "flash_sim.h"
+
+/* The priority of the task that runs the boot.  The task that drains the
+records to the flash runs above it, so has always drained them by the time
+a write returns. */
+#define mainBOOT_TASK_PRIORITY			( tskIDLE_PRIORITY + 2 )
+#define mainDRAIN_TASK_PRIORITY			( tskIDLE_PRIORITY + 3 )
+
+/* The files the flash is held in, and copied to so the power can be failed
+again and again from the same starting point.  The log uses all of the
+flash. */
+#define mainFLASH_FILE					"flash_log.bin"
+#define mainSNAPSHOT_FILE				"flash_log_snapshot.bin"
+#define mainFLASH_SIZE					( flashlogSECTORS * flashsimSECTOR_SIZE )
+
+/* The records written by the first and second boots, and by the boot that
+fills every sector more than once. */
+#define mainFIRST_RECORDS				200UL
+#define mainSECOND_RECORDS				150UL
+#define mainWRAP_RECORDS				( 3UL * flashlogSECTORS * mainRECORDS_PER_SECTOR )
+
+/* The fewest records a sector holds, each record being at most the largest
+record and its four byte header, after the twelve byte sector header.  The
+records written are half that long on average. */
+#define mainRECORDS_PER_SECTOR			( ( flashsimSECTOR_SIZE - 12UL ) / ( flashlogMAX_RECORD_SIZE + 4UL ) )
+
+/* The length of record ulRecord, from four bytes, which hold its number, up to
+the largest record. */
+#define mainRECORD_LENGTH( ulRecord )	( 4UL + ( ( ( ulRecord ) * 13UL ) % ( flashlogMAX_RECORD_SIZE - 3UL ) ) )
+
+/* In place of a record number, no record, and the first record once older
+records have been erased. */
+#define mainNONE						0xffffffffUL
+#define mainWRAPPED						0xfffffffeUL
+
+/* The exit status of a boot that found the torn record had been skipped. */
+#define mainTORN_SKIPPED				2
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Boots the target in a child process with the parameters in xBoot, and
+ * returns the exit status of the child.
+ */
+static int prvBoot( const char *pcName );
+
+/*
+ * Fails the power ulFailAfter steps into writing the record after ulLast,
+ * starting from the snapshot, then boots again, when the log should hold the
+ * records from ulFirst to ulLast, and the new record if all ulBytes steps of
+ * writing it were made.  ulErases is as xBoot.ulErases for the second boot.
+ */
+static void prvPowerFail( uint32_t ulFirst, uint32_t ulLast, uint32_t ulFailAfter, uint32_t ulBytes, uint32_t ulErases );
+
+/*
+ * The task that runs a boot, which ends the scheduler.
+ */
+static void prvBootTask( void *pvParameters );
+
+/*
+ * Reads every record of the log with pxReader, checking them against xBoot.
+ */
+static void prvReadLog( FlashLogReader_t *pxReader );
+
+/*
+ * Writes the records numbered ulFirst onwards, up to but not including
+ * ulEnd, and waits for them to be programmed.
+ */
+static void prvWriteRecords( uint32_t ulFirst, uint32_t ulEnd );
+
+/*
+ * Returns the number of the record in pucRecord, or mainNONE if it is not as
+ * a record of that number should be.
+ */
+static uint32_t prvRecordNumber( const uint8_t *pucRecord, size_t xLength );
+
+/*
+ * Returns the sector the log is filling, the one with the highest sequence
+ * number, or mainNONE.
+ */
+static uint32_t prvHeadSector( void );
+
+/*
+ * Returns the offset of the end of the log in the sector it is filling, which
+ * is returned in *pulSector.  Opens the flash to read it.
+ */
+static uint32_t prvLogEnd( uint32_t *pulSector );
+
+/*
+ * Checks the sector after the one the log is filling is erased.
+ */
+static void prvCheckEraseAhead( void );
+
+/*
+ * Copies the file pcFrom to pcTo.
+ */
+static void prvCopyFile( const char *pcFrom, const char *pcTo );
+
+/*
+ * Records a failed check.  ulValue is printed to help find the cause.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* What a boot should find in the log, and what it should do. */
+static struct BOOT
+{
+	uint32_t ulFirst;			/* The first record the log holds, mainWRAPPED, or mainNONE if it is empty. */
+	uint32_t ulLast;			/* The last record the log holds. */
+	uint32_t ulTorn;			/* A record that may have been skipped, or mainNONE. */
+	uint32_t ulErases;			/* The sectors erased when the log is opened, or mainNONE. */
+	uint32_t ulWrite;			/* The records to write, numbered from ulLast + 1. */
+	BaseType_t xFailPower;		/* Whether the power fails ulFailAfter bytes into the records written. */
+	uint32_t ulFailAfter;
+	BaseType_t xWraps;			/* Whether the records written fill every sector. */
+} xBoot;
+
+/* Set by a boot that found xBoot.ulTorn had been skipped. */
+static BaseType_t xTornSkipped = pdFALSE;
+
+static uint8_t ucRecord[ flashlogMAX_RECORD_SIZE ];
+
+/* Set to pdTRUE by any check that fails. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+/* Steps into the move to the next sector that the power fails after: within
+the sector header, within the erase of the sector after it, and within the
+record. */
+static const uint32_t ulMoveFailures[] = { 0, 1, 6, 11, 12, 13, 100, 267, 268, 270, 272, 280 };
+uint32_t ulTorn, ulBytes, ulFailAfter, ulLast, ulOffset, ulSector, ulFill, ulFillSector, x;
+
+	( void ) unlink( mainFLASH_FILE );
+	( void ) unlink( mainSNAPSHOT_FILE );
+
+	/* A new log, which erases the sector it starts in and the one after. */
+	xBoot.ulFirst = mainNONE;
+	xBoot.ulLast = mainNONE;
+	xBoot.ulTorn = mainNONE;
+	xBoot.ulErases = 2;
+	xBoot.ulWrite = mainFIRST_RECORDS;
+	xBoot.xFailPower = pdFALSE;
+	xBoot.xWraps = pdFALSE;
+	prvCheck( prvBoot( "first" ) == 0, "first boot", 0 );
+
+	/* The end of the log found again. */
+	xBoot.ulFirst = 0;
+	xBoot.ulLast = mainFIRST_RECORDS - 1UL;
+	xBoot.ulErases = 0;
+	xBoot.ulWrite = mainSECOND_RECORDS;
+	prvCheck( prvBoot( "second" ) == 0, "second boot", 0 );
+	ulLast = mainFIRST_RECORDS + mainSECOND_RECORDS - 1UL;
+
+	/* The power failing at each byte programmed of the next record, which is
+	kept only once all of it has been programmed. */
+	prvCopyFile( mainFLASH_FILE, mainSNAPSHOT_FILE );
+	ulTorn = ulLast + 1UL;
+	ulBytes = 4UL + mainRECORD_LENGTH( ulTorn );
+
+	for( ulFailAfter = 0; ulFailAfter <= ulBytes; ulFailAfter++ )
+	{
+		/* A header that is not whole cannot be walked past, so the log moves
+		on to the next sector, which is erased, and erases the one after it. */
+		prvPowerFail( 0, ulLast, ulFailAfter, ulBytes, ( ( ulFailAfter > 0UL ) && ( ulFailAfter < 4UL ) ) ? 1UL : 0UL );
+	}
+
+	ulLast = ulTorn + 1UL;
+
+	/* Every sector filled more than once, from where the last boot left the
+	log, with the record that was programmed whole. */
+	xBoot.ulLast = ulLast;
+	xBoot.ulTorn = mainNONE;
+	xBoot.ulErases = 0;
+	xBoot.ulWrite = mainWRAP_RECORDS;
+	xBoot.xWraps = pdTRUE;
+	prvCheck( prvBoot( "wrap" ) == 0, "boot that wraps", 0 );
+	ulLast += mainWRAP_RECORDS;
+
+	/* The end of the log found once the sectors have wrapped. */
+	xBoot.ulFirst = mainWRAPPED;
+	xBoot.ulLast = ulLast;
+	xBoot.ulWrite = 10;
+	xBoot.xWraps = pdFALSE;
+	prvCheck( prvBoot( "after wrapping" ) == 0, "boot after wrapping", 0 );
+	ulLast += 10UL;
+
+	/* Fill the sector the log is in with as many records as fit. */
+	ulOffset = prvLogEnd( &ulSector );
+	ulFill = 0;
+
+	while( ( ulOffset + 4UL + mainRECORD_LENGTH( ulLast + 1UL + ulFill ) ) <= flashsimSECTOR_SIZE )
+	{
+		ulOffset += 4UL + mainRECORD_LENGTH( ulLast + 1UL + ulFill );
+		ulFill++;
+	}
+
+	xBoot.ulLast = ulLast;
+	xBoot.ulWrite = ulFill;
+	xBoot.ulErases = 0;
+	prvCheck( prvBoot( "fill" ) == 0, "boot that fills a sector", 0 );
+	ulLast += ulFill;
+
+	ulFill = prvLogEnd( &ulFillSector );
+	prvCheck( ( ulFillSector == ulSector ) && ( ulFill == ulOffset ), "sector filled", ulFill );
+
+	/* The power failing as the next record moves the log into the next
+	sector, while the header of that sector is programmed, while the sector
+	after it is erased, and while the record is programmed. */
+	prvCopyFile( mainFLASH_FILE, mainSNAPSHOT_FILE );
+	ulBytes = 12UL + ( flashsimSECTOR_SIZE / flashsimPAGE_SIZE ) + 4UL + mainRECORD_LENGTH( ulLast + 1UL );
+
+	for( x = 0; x < ( sizeof( ulMoveFailures ) / sizeof( ulMoveFailures[ 0 ] ) ); x++ )
+	{
+		prvPowerFail( mainWRAPPED, ulLast, ulMoveFailures[ x ], ulBytes, mainNONE );
+	}
+
+	prvPowerFail( mainWRAPPED, ulLast, ulBytes, ulBytes, mainNONE );
+
+	( void ) unlink( mainFLASH_FILE );
+	( void ) unlink( mainSNAPSHOT_FILE );
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All flash log tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+void SPI_FLASH_BufferRead( u8 *pBuffer, u32 ReadAddr, u32 NumByteToRead )
+{
+	vFlashSimRead( ReadAddr, pBuffer, NumByteToRead );
+}
+/*-----------------------------------------------------------*/
+
+void SPI_FLASH_PageWrite( u8 *pBuffer, u32 WriteAddr, u16 NumByteToWrite )
+{
+	prvCheck( ( ( WriteAddr % flashsimPAGE_SIZE ) + NumByteToWrite ) <= flashsimPAGE_SIZE, "page program within a page", WriteAddr );
+	vFlashSimProgram( WriteAddr, pBuffer, NumByteToWrite );
+}
+/*-----------------------------------------------------------*/
+
+void SPI_FLASH_SectorErase( u32 SectorAddr )
+{
+	vFlashSimEraseSector( SectorAddr );
+}
+/*-----------------------------------------------------------*/
+
+static int prvBoot( const char *pcName )
+{
+pid_t xChild;
+int iStatus = 0;
+
+	/* The child starts with nothing of the scheduler, as the target does after
+	a reset, and with the output so far already written. */
+	fflush( stdout );
+	xChild = fork();
+
+	if( xChild == 0 )
+	{
+		/* Only the checks of this boot decide its exit status. */
+		xFailed = pdFALSE;
+
+		if( xFlashSimOpen( mainFLASH_FILE, mainFLASH_SIZE ) == pdFAIL )
+		{
+			printf( "Failed flash opened in the %s boot\n", pcName );
+			exit( EXIT_FAILURE );
+		}
+
+		xTaskCreate( prvBootTask, "Boot", configMINIMAL_STACK_SIZE * 2, ( void * ) pcName, mainBOOT_TASK_PRIORITY, NULL );
+		vTaskStartScheduler();
+		vFlashSimClose();
+
+		if( xFailed != pdFALSE )
+		{
+			printf( "Failed in the %s boot\n", pcName );
+			exit( EXIT_FAILURE );
+		}
+
+		exit( ( xTornSkipped != pdFALSE ) ? mainTORN_SKIPPED : EXIT_SUCCESS );
+	}
+
+	if( ( xChild < 0 ) || ( waitpid( xChild, &iStatus, 0 ) != xChild ) || ( WIFEXITED( iStatus ) == 0 ) )
+	{
+		printf( "Failed %s boot ran\n", pcName );
+		return EXIT_FAILURE;
+	}
+
+	return WEXITSTATUS( iStatus );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPowerFail( uint32_t ulFirst, uint32_t ulLast, uint32_t ulFailAfter, uint32_t ulBytes, uint32_t ulErases )
+{
+int iStatus;
+
+	prvCopyFile( mainSNAPSHOT_FILE, mainFLASH_FILE );
+
+	xBoot.ulFirst = ulFirst;
+	xBoot.ulLast = ulLast;
+	xBoot.ulTorn = mainNONE;
+	xBoot.ulErases = 0;
+	xBoot.ulWrite = 1;
+	xBoot.xFailPower = pdTRUE;
+	xBoot.ulFailAfter = ulFailAfter;
+	prvCheck( prvBoot( "power fails" ) == 0, "boot the power fails in", ulFailAfter );
+
+	xBoot.ulLast = ulLast + 1UL;
+	xBoot.ulTorn = ulLast + 1UL;
+	xBoot.ulErases = ulErases;
+	xBoot.xFailPower = pdFALSE;
+	iStatus = prvBoot( "after the power failed" );
+
+	if( ulFailAfter < ulBytes )
+	{
+		prvCheck( iStatus == mainTORN_SKIPPED, "torn record skipped", ulFailAfter );
+	}
+	else
+	{
+		prvCheck( iStatus == 0, "whole record kept", ulFailAfter );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvBootTask( void *pvParameters )
+{
+FlashLogReader_t xReader;
+FlashLogStats_t xStats;
+uint32_t ulNext, ulErased;
+
+	( void ) pvParameters;
+
+	prvCheck( xFlashLogInit( mainDRAIN_TASK_PRIORITY ), "log opened", 0 );
+
+	vFlashLogGetStats( &xStats );
+
+	if( xBoot.ulErases != mainNONE )
+	{
+		prvCheck( xStats.ulSectorsErased == xBoot.ulErases, "sectors erased when opened", xStats.ulSectorsErased );
+	}
+
+	prvCheckEraseAhead();
+
+	/* Every record that was programmed, less any record that was torn. */
+	vFlashLogReaderInit( &xReader );
+	prvReadLog( &xReader );
+
+	ulNext = ( xBoot.ulLast == mainNONE ) ? 0UL : ( xBoot.ulLast + 1UL );
+
+	if( xBoot.xFailPower != pdFALSE )
+	{
+		vFlashSimPowerFailAfter( xBoot.ulFailAfter );
+		prvWriteRecords( ulNext, ulNext + xBoot.ulWrite );
+	}
+	else
+	{
+		ulErased = xStats.ulSectorsErased;
+		prvWriteRecords( ulNext, ulNext + xBoot.ulWrite );
+
+		/* The same reader goes on to read the records just written, or, if
+		the sector it had got to has been reused, the oldest records. */
+		vFlashLogGetStats( &xStats );
+
+		if( xBoot.xWraps != pdFALSE )
+		{
+			prvCheck( ( xStats.ulSectorsErased - ulErased ) >= flashlogSECTORS, "every sector reused", xStats.ulSectorsErased - ulErased );
+			xBoot.ulFirst = mainWRAPPED;
+		}
+		else
+		{
+			xBoot.ulFirst = ulNext;
+		}
+
+		xBoot.ulLast = ulNext + xBoot.ulWrite - 1UL;
+		xBoot.ulTorn = mainNONE;
+		prvReadLog( &xReader );
+	}
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvReadLog( FlashLogReader_t *pxReader )
+{
+uint32_t ulRecord, ulExpected = mainNONE, ulRead = 0;
+size_t xLength;
+
+	while( xFlashLogReadNext( pxReader, ucRecord, sizeof( ucRecord ), &xLength ) != pdFAIL )
+	{
+		ulRecord = prvRecordNumber( ucRecord, xLength );
+
+		if( ulRecord == mainNONE )
+		{
+			prvCheck( pdFALSE, "record read intact", ulRead );
+			break;
+		}
+
+		if( ulExpected == mainNONE )
+		{
+			/* Once sectors have been reused the oldest records are gone, but
+			those of every sector but the erased one and the one being filled
+			are kept, unless a torn record header made the log give up a
+			sector. */
+			if( xBoot.ulFirst == mainWRAPPED )
+			{
+				prvCheck( ulRecord > 0UL, "oldest records erased", ulRecord );
+				prvCheck( ( ( xBoot.ulTorn != mainNONE ) || ( ( xBoot.ulLast - ulRecord ) >= ( ( flashlogSECTORS - 2UL ) * mainRECORDS_PER_SECTOR ) ) ) ? pdTRUE : pdFALSE, "records of the full sectors kept", xBoot.ulLast - ulRecord );
+			}
+			else
+			{
+				prvCheck( ulRecord == xBoot.ulFirst, "first record", ulRecord );
+			}
+		}
+		else if( ( ulRecord == ( ulExpected + 1UL ) ) && ( ulExpected == xBoot.ulTorn ) )
+		{
+			xTornSkipped = pdTRUE;
+		}
+		else
+		{
+			prvCheck( ulRecord == ulExpected, "records in order", ulRecord );
+		}
+
+		ulExpected = ulRecord + 1UL;
+		ulRead++;
+	}
+
+	if( xBoot.ulFirst == mainNONE )
+	{
+		prvCheck( ulRead == 0UL, "new log empty", ulRead );
+	}
+	else if( ( ulExpected == xBoot.ulTorn ) && ( xBoot.ulTorn == xBoot.ulLast ) )
+	{
+		xTornSkipped = pdTRUE;
+	}
+	else
+	{
+		prvCheck( ulExpected == ( xBoot.ulLast + 1UL ), "last record", ulExpected );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteRecords( uint32_t ulFirst, uint32_t ulEnd )
+{
+FlashLogStats_t xStats;
+uint32_t ulRecord, ulErased, ulWritten, ulDropped, x;
+
+	vFlashLogGetStats( &xStats );
+	ulErased = xStats.ulSectorsErased;
+	ulWritten = xStats.ulRecordsWritten;
+	ulDropped = xStats.ulRecordsDropped;
+
+	for( ulRecord = ulFirst; ulRecord < ulEnd; ulRecord++ )
+	{
+		/* Four bytes of number, then bytes that are never erased, so a record
+		that was torn cannot pass for a whole one. */
+		for( x = 0; x < mainRECORD_LENGTH( ulRecord ); x++ )
+		{
+			ucRecord[ x ] = ( x < 4UL ) ? ( uint8_t ) ( ulRecord >> ( x * 8UL ) ) : ( uint8_t ) ( ( ulRecord + x ) & 0x7fUL );
+		}
+
+		/* The drain task runs above this one, so a record is only dropped if
+		it is waiting for the flash. */
+		while( xFlashLogWrite( ucRecord, mainRECORD_LENGTH( ulRecord ) ) == pdFAIL )
+		{
+			ulDropped++;
+			vTaskDelay( 1 );
+		}
+
+		ulWritten++;
+
+		/* Each time the log moves into a sector, the sector after it is
+		erased. */
+		vFlashLogGetStats( &xStats );
+
+		if( ( xStats.ulSectorsErased != ulErased ) && ( xFlashSimPowerFailed() == pdFALSE ) )
+		{
+			prvCheck( xStats.ulSectorsErased == ( ulErased + 1UL ), "one sector erased for each sector filled", xStats.ulSectorsErased - ulErased );
+			prvCheckEraseAhead();
+			ulErased = xStats.ulSectorsErased;
+		}
+	}
+
+	/* The last page is programmed once nothing has been written for the flush
+	delay. */
+	vTaskDelay( flashlogFLUSH_DELAY * 3 );
+
+	vFlashLogGetStats( &xStats );
+	prvCheck( xStats.ulRecordsWritten == ulWritten, "records written counted", xStats.ulRecordsWritten );
+	prvCheck( xStats.ulRecordsDropped == ulDropped, "records dropped counted", xStats.ulRecordsDropped );
+	prvCheck( xStats.ulRecordsLogged == ulWritten, "records logged", xStats.ulRecordsLogged );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRecordNumber( const uint8_t *pucRecord, size_t xLength )
+{
+uint32_t ulRecord, x;
+
+	ulRecord = ( uint32_t ) pucRecord[ 0 ] | ( ( uint32_t ) pucRecord[ 1 ] << 8 ) | ( ( uint32_t ) pucRecord[ 2 ] << 16 ) | ( ( uint32_t ) pucRecord[ 3 ] << 24 );
+
+	if( ( xLength < 4U ) || ( xLength != mainRECORD_LENGTH( ulRecord ) ) )
+	{
+		ulRecord = mainNONE;
+	}
+	else
+	{
+		for( x = 4; x < xLength; x++ )
+		{
+			if( pucRecord[ x ] != ( uint8_t ) ( ( ulRecord + x ) & 0x7fUL ) )
+			{
+				ulRecord = mainNONE;
+				break;
+			}
+		}
+	}
+
+	return ulRecord;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvHeadSector( void )
+{
+uint8_t ucHeader[ 12 ];
+uint32_t ulSector, ulSequence, ulHeadSector = mainNONE, ulHeadSequence = 0;
+
+	/* The sector the log is filling has the highest sequence number, held in
+	bytes 4 to 7 of its header, which starts with "LOG1", with their inverse
+	after them. */
+	for( ulSector = 0; ulSector < flashlogSECTORS; ulSector++ )
+	{
+		vFlashSimRead( ulSector * flashsimSECTOR_SIZE, ucHeader, sizeof( ucHeader ) );
+		ulSequence = ( uint32_t ) ucHeader[ 4 ] | ( ( uint32_t ) ucHeader[ 5 ] << 8 ) | ( ( uint32_t ) ucHeader[ 6 ] << 16 ) | ( ( uint32_t ) ucHeader[ 7 ] << 24 );
+
+		if( ( ucHeader[ 0 ] == 'L' ) && ( ucHeader[ 4 ] == ( uint8_t ) ~ucHeader[ 8 ] ) && ( ucHeader[ 7 ] == ( uint8_t ) ~ucHeader[ 11 ] ) &&
+			( ( ulHeadSector == mainNONE ) || ( ulSequence > ulHeadSequence ) ) )
+		{
+			ulHeadSector = ulSector;
+			ulHeadSequence = ulSequence;
+		}
+	}
+
+	return ulHeadSector;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvLogEnd( uint32_t *pulSector )
+{
+uint32_t ulOffset = 12UL;
+uint8_t ucLength = 0;
+
+	if( xFlashSimOpen( mainFLASH_FILE, mainFLASH_SIZE ) == pdFAIL )
+	{
+		prvCheck( pdFALSE, "flash opened to find the end of the log", 0 );
+		*pulSector = mainNONE;
+	}
+	else
+	{
+		*pulSector = prvHeadSector();
+		prvCheck( *pulSector != mainNONE, "log sector found", 0 );
+
+		/* Each record header starts with the length of the record. */
+		while( ( *pulSector != mainNONE ) && ( ulOffset < flashsimSECTOR_SIZE ) )
+		{
+			vFlashSimRead( ( *pulSector * flashsimSECTOR_SIZE ) + ulOffset, &ucLength, 1 );
+
+			if( ucLength == 0xffU )
+			{
+				break;
+			}
+
+			ulOffset += 4UL + ucLength;
+		}
+
+		vFlashSimClose();
+	}
+
+	return ulOffset;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckEraseAhead( void )
+{
+static uint8_t ucSector[ flashsimSECTOR_SIZE ];
+uint32_t ulHeadSector, x;
+
+	ulHeadSector = prvHeadSector();
+	prvCheck( ulHeadSector != mainNONE, "log sector found", 0 );
+
+	vFlashSimRead( ( ( ulHeadSector + 1UL ) % flashlogSECTORS ) * flashsimSECTOR_SIZE, ucSector, flashsimSECTOR_SIZE );
+
+	for( x = 0; x < flashsimSECTOR_SIZE; x++ )
+	{
+		if( ucSector[ x ] != 0xffU )
+		{
+			prvCheck( pdFALSE, "sector after the log erased", ulHeadSector );
+			break;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCopyFile( const char *pcFrom, const char *pcTo )
+{
+static uint8_t ucCopy[ mainFLASH_SIZE ];
+FILE *pxFrom, *pxTo;
+size_t xRead = 0;
+
+	pxFrom = fopen( pcFrom, "rb" );
+	pxTo = fopen( pcTo, "wb" );
+
+	if( ( pxFrom != NULL ) && ( pxTo != NULL ) )
+	{
+		xRead = fread( ucCopy, 1, sizeof( ucCopy ), pxFrom );
+		prvCheck( ( fwrite( ucCopy, 1, xRead, pxTo ) == sizeof( ucCopy ) ) ? pdTRUE : pdFALSE, "flash file copied", ( unsigned long ) xRead );
+	}
+	else
+	{
+		prvCheck( pdFALSE, "flash file opened to copy", 0 );
+	}
+
+	if( pxFrom != NULL )
+	{
+		fclose( pxFrom );
+	}
+
+	if( pxTo != NULL )
+	{
+		fclose( pxTo );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		printf( "Failed %s (%lu)\n", pcCheck, ulValue );
+		xFailed = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
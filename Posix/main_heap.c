@@ -0,0 +1,326 @@
+/*
+	Fuzzes the heap the kernel is built with, so heap_6.c can be checked
+	against the behaviour of heap_4.c by building this file with each.
+
+	+ Blocks of pseudo random sizes, from a few bytes to a quarter of the heap,
+	  are allocated and freed in a pseudo random order until the heap is
+	  fragmented, with the allocations that do not fit failing.
+
+	+ Each block must be aligned, and clear of every other block in use, and
+	  is filled with a pattern that must be intact when the block is freed.
+
+	+ xPortGetFreeHeapSize(), xPortGetMinimumEverFreeHeapSize() and each field
+	  of vPortGetHeapStats() are checked after every allocation and free.  A
+	  free must return exactly the bytes its allocation took, and a failed
+	  allocation must change nothing.
+
+	+ Once every block is freed the free blocks must have combined back into
+	  the single block there was before the test.
+
+	The program ends the scheduler once the test has run, and exits with 0 if
+	every check passed, or 1 after naming those that failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* The priority of the task that runs the test. */
+#define mainTEST_TASK_PRIORITY			( tskIDLE_PRIORITY + 2 )
+
+/* The blocks that can be in use at once, and the allocations and frees made
+between them. */
+#define mainHEAP_SLOTS					( 128 )
+#define mainHEAP_OPERATIONS				( 50000UL )
+
+/* The seed of the pseudo random numbers, so each heap sees the same
+sequence. */
+#define mainRANDOM_SEED					( 0x2545F491UL )
+
+/* A block in use, the bytes the heap took to allocate it, and the pattern it
+was filled with. */
+typedef struct HEAP_BLOCK
+{
+	uint8_t *pucBlock;
+	size_t xSize;
+	size_t xCost;
+	uint8_t ucPattern;
+} HeapBlock_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Runs the test.
+ */
+static void prvTestTask( void *pvParameters );
+
+/*
+ * Allocates and frees blocks, then frees whatever is left.
+ */
+static void prvFuzzHeap( void );
+
+/*
+ * Allocates a block of xSize bytes into pxBlock, or frees the block in
+ * pxBlock, checking the heap before and after.
+ */
+static void prvAllocate( HeapBlock_t *pxBlock, size_t xSize );
+static void prvFree( HeapBlock_t *pxBlock );
+
+/*
+ * Checks the statistics of the heap agree with each other, with the free
+ * bytes expected and with the lowest free bytes seen.
+ */
+static void prvCheckStats( size_t xExpectedFree );
+
+/*
+ * Returns the next pseudo random number.
+ */
+static uint32_t prvRandom( void );
+
+/*
+ * Records a failed check.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* The blocks in use. */
+static HeapBlock_t xBlocks[ mainHEAP_SLOTS ];
+
+/* The allocations and frees expected to have been counted by the heap, and
+the least free bytes there have been. */
+static size_t xAllocations = 0, xFrees = 0, xLowestFree = 0;
+
+/* The state of prvRandom(). */
+static uint32_t ulRandom = mainRANDOM_SEED;
+
+/* Whether any check failed. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE * 2, NULL, mainTEST_TASK_PRIORITY, NULL );
+
+	vTaskStartScheduler();
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All heap tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	prvFuzzHeap();
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvFuzzHeap( void )
+{
+HeapStats_t xStartStats, xEndStats;
+uint32_t ulOperation, ulChoice;
+size_t xSize;
+HeapBlock_t *pxBlock;
+UBaseType_t x;
+
+	/* The tasks and queues the kernel created when the scheduler started
+	were split from the front of the heap, which leaves one free block. */
+	vPortGetHeapStats( &xStartStats );
+	xAllocations = xStartStats.xNumberOfSuccessfulAllocations;
+	xFrees = xStartStats.xNumberOfSuccessfulFrees;
+	xLowestFree = xStartStats.xMinimumEverFreeBytesRemaining;
+	prvCheck( xStartStats.xNumberOfFreeBlocks == 1, "one free block before the test", ( unsigned long ) xStartStats.xNumberOfFreeBlocks );
+	prvCheckStats( xStartStats.xAvailableHeapSpaceInBytes );
+
+	/* Requests the heap can never meet fail without changing it. */
+	prvCheck( pvPortMalloc( 0 ) == NULL, "allocation of 0 bytes", 0 );
+	prvCheck( pvPortMalloc( configTOTAL_HEAP_SIZE ) == NULL, "allocation larger than the heap", configTOTAL_HEAP_SIZE );
+	prvCheck( pvPortMalloc( ( size_t ) -1 ) == NULL, "allocation that overflows", 0 );
+	vPortFree( NULL );
+	prvCheckStats( xStartStats.xAvailableHeapSpaceInBytes );
+
+	for( ulOperation = 0; ( ulOperation < mainHEAP_OPERATIONS ) && ( xFailed == pdFALSE ); ulOperation++ )
+	{
+		pxBlock = &( xBlocks[ prvRandom() % mainHEAP_SLOTS ] );
+
+		if( pxBlock->pucBlock != NULL )
+		{
+			prvFree( pxBlock );
+		}
+		else
+		{
+			/* Mostly small blocks, some larger, and a few large enough to
+			fail once the heap is busy. */
+			ulChoice = prvRandom() % 100UL;
+
+			if( ulChoice < 75UL )
+			{
+				xSize = 1U + ( prvRandom() % 128UL );
+			}
+			else if( ulChoice < 90UL )
+			{
+				xSize = 129U + ( prvRandom() % 4096UL );
+			}
+			else
+			{
+				xSize = 4225U + ( prvRandom() % ( configTOTAL_HEAP_SIZE / 4U ) );
+			}
+
+			prvAllocate( pxBlock, xSize );
+		}
+	}
+
+	for( x = 0; x < mainHEAP_SLOTS; x++ )
+	{
+		if( xBlocks[ x ].pucBlock != NULL )
+		{
+			prvFree( &( xBlocks[ x ] ) );
+		}
+	}
+
+	/* Every block freed combines back into the block the test started
+	with. */
+	vPortGetHeapStats( &xEndStats );
+	prvCheck( xEndStats.xNumberOfFreeBlocks == 1, "one free block after the test", ( unsigned long ) xEndStats.xNumberOfFreeBlocks );
+	prvCheck( xEndStats.xAvailableHeapSpaceInBytes == xStartStats.xAvailableHeapSpaceInBytes, "free bytes after the test", ( unsigned long ) xEndStats.xAvailableHeapSpaceInBytes );
+	prvCheck( xEndStats.xSizeOfLargestFreeBlockInBytes == xStartStats.xSizeOfLargestFreeBlockInBytes, "largest free block after the test", ( unsigned long ) xEndStats.xSizeOfLargestFreeBlockInBytes );
+	prvCheck( xEndStats.xMinimumEverFreeBytesRemaining < xStartStats.xMinimumEverFreeBytesRemaining, "heap used by the test", ( unsigned long ) xEndStats.xMinimumEverFreeBytesRemaining );
+	prvCheck( ( xEndStats.xNumberOfSuccessfulAllocations - xStartStats.xNumberOfSuccessfulAllocations ) > ( mainHEAP_OPERATIONS / 4UL ), "allocations made", ( unsigned long ) ( xEndStats.xNumberOfSuccessfulAllocations - xStartStats.xNumberOfSuccessfulAllocations ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvAllocate( HeapBlock_t *pxBlock, size_t xSize )
+{
+HeapStats_t xStats;
+size_t xFreeBefore, xFreeAfter;
+uint8_t *pucBlock;
+UBaseType_t x;
+
+	vPortGetHeapStats( &xStats );
+	xFreeBefore = xPortGetFreeHeapSize();
+	pucBlock = ( uint8_t * ) pvPortMalloc( xSize );
+	xFreeAfter = xPortGetFreeHeapSize();
+
+	if( pucBlock == NULL )
+	{
+		/* The heap finds a block in a size class at least as large as the
+		request, so only a request near the size of the largest free block
+		can fail. */
+		prvCheck( xSize > ( xStats.xSizeOfLargestFreeBlockInBytes / 2U ), "allocation that fits failed", ( unsigned long ) xSize );
+		prvCheckStats( xFreeBefore );
+		return;
+	}
+
+	xAllocations++;
+
+	prvCheck( ( ( ( size_t ) pucBlock ) & portBYTE_ALIGNMENT_MASK ) == 0, "block aligned", ( unsigned long ) xSize );
+	prvCheck( ( xFreeBefore - xFreeAfter ) >= xSize, "block takes its size from the heap", ( unsigned long ) ( xFreeBefore - xFreeAfter ) );
+	prvCheck( ( ( xFreeBefore - xFreeAfter ) & portBYTE_ALIGNMENT_MASK ) == 0, "block takes whole units from the heap", ( unsigned long ) ( xFreeBefore - xFreeAfter ) );
+
+	for( x = 0; x < mainHEAP_SLOTS; x++ )
+	{
+		if( ( xBlocks[ x ].pucBlock != NULL ) &&
+			( pucBlock < ( xBlocks[ x ].pucBlock + xBlocks[ x ].xSize ) ) &&
+			( xBlocks[ x ].pucBlock < ( pucBlock + xSize ) ) )
+		{
+			prvCheck( pdFALSE, "block clear of the blocks in use", ( unsigned long ) x );
+		}
+	}
+
+	pxBlock->pucBlock = pucBlock;
+	pxBlock->xSize = xSize;
+	pxBlock->xCost = xFreeBefore - xFreeAfter;
+	pxBlock->ucPattern = ( uint8_t ) prvRandom();
+	memset( pucBlock, pxBlock->ucPattern, xSize );
+
+	if( xFreeAfter < xLowestFree )
+	{
+		xLowestFree = xFreeAfter;
+	}
+
+	prvCheckStats( xFreeAfter );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFree( HeapBlock_t *pxBlock )
+{
+size_t xFreeBefore, x;
+unsigned long ulChanged = 0;
+
+	for( x = 0; x < pxBlock->xSize; x++ )
+	{
+		if( pxBlock->pucBlock[ x ] != pxBlock->ucPattern )
+		{
+			ulChanged++;
+		}
+	}
+
+	prvCheck( ulChanged == 0, "block intact", ulChanged );
+
+	xFreeBefore = xPortGetFreeHeapSize();
+	vPortFree( pxBlock->pucBlock );
+	xFrees++;
+
+	prvCheck( xPortGetFreeHeapSize() == ( xFreeBefore + pxBlock->xCost ), "free returns what the block took", ( unsigned long ) pxBlock->xCost );
+	prvCheckStats( xFreeBefore + pxBlock->xCost );
+
+	pxBlock->pucBlock = NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckStats( size_t xExpectedFree )
+{
+HeapStats_t xStats;
+
+	vPortGetHeapStats( &xStats );
+
+	prvCheck( xStats.xAvailableHeapSpaceInBytes == xExpectedFree, "free bytes", ( unsigned long ) xStats.xAvailableHeapSpaceInBytes );
+	prvCheck( xPortGetFreeHeapSize() == xExpectedFree, "xPortGetFreeHeapSize", ( unsigned long ) xPortGetFreeHeapSize() );
+	prvCheck( xStats.xMinimumEverFreeBytesRemaining == xLowestFree, "minimum ever free bytes", ( unsigned long ) xStats.xMinimumEverFreeBytesRemaining );
+	prvCheck( xPortGetMinimumEverFreeHeapSize() == xLowestFree, "xPortGetMinimumEverFreeHeapSize", ( unsigned long ) xPortGetMinimumEverFreeHeapSize() );
+	prvCheck( xStats.xNumberOfSuccessfulAllocations == xAllocations, "successful allocations", ( unsigned long ) xStats.xNumberOfSuccessfulAllocations );
+	prvCheck( xStats.xNumberOfSuccessfulFrees == xFrees, "successful frees", ( unsigned long ) xStats.xNumberOfSuccessfulFrees );
+
+	/* The free blocks are each no larger than the largest and no smaller than
+	the smallest, and between them hold the free bytes. */
+	prvCheck( xStats.xNumberOfFreeBlocks > 0, "free blocks", ( unsigned long ) xStats.xNumberOfFreeBlocks );
+	prvCheck( xStats.xSizeOfSmallestFreeBlockInBytes <= xStats.xSizeOfLargestFreeBlockInBytes, "smallest free block", ( unsigned long ) xStats.xSizeOfSmallestFreeBlockInBytes );
+	prvCheck( ( xStats.xSizeOfLargestFreeBlockInBytes + ( ( xStats.xNumberOfFreeBlocks - 1U ) * xStats.xSizeOfSmallestFreeBlockInBytes ) ) <= xExpectedFree, "free blocks within the free bytes", ( unsigned long ) xStats.xNumberOfFreeBlocks );
+	prvCheck( ( xStats.xSizeOfSmallestFreeBlockInBytes + ( ( xStats.xNumberOfFreeBlocks - 1U ) * xStats.xSizeOfLargestFreeBlockInBytes ) ) >= xExpectedFree, "free bytes within the free blocks", ( unsigned long ) xStats.xNumberOfFreeBlocks );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRandom( void )
+{
+	/* A 32 bit xorshift generator. */
+	ulRandom ^= ulRandom << 13;
+	ulRandom ^= ulRandom >> 17;
+	ulRandom ^= ulRandom << 5;
+
+	return ulRandom;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		printf( "Failed %s (%lu)\n", pcCheck, ulValue );
+		xFailed = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
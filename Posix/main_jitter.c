@@ -0,0 +1,421 @@
+/*
+	Tests the interrupt jitter histogram of jitter.c on the host build, by
+	calling vJitterRecordFromISR() with counter values that deviate from the
+	expected period by known amounts.
+
+	+ The bucket test records deviations on each side of the edge of every
+	  kind of bucket - the linear buckets, the buckets that double in width,
+	  and the last, open ended, bucket - each in a new histogram, and checks
+	  the one bucket each must be counted in.
+
+	+ The settle test checks the interrupts to settle are not recorded, and
+	  that a counter narrower than the deviations are measured in wraps.
+
+	+ The worst case test checks the largest deviation is kept with the
+	  sample number and counter value at which it was first seen.
+
+	+ The percentile test records ten thousand samples in four groups, and
+	  ulJitterPercentile() must give the upper bound of the bucket holding
+	  p50, p99 and p99.9, but no more than the largest deviation seen.  The
+	  CSV line written by vJitterReport() must hold the same.
+
+	+ The torn copy test places a histogram across two pages of memory, and
+	  makes reading the second page fault while vJitterSnapshot() is copying
+	  it.  The fault handler records a sample, as the interrupt would if it ran
+	  part way through the copy, and the copy must be taken again so it holds
+	  every field as they were after the sample.
+
+	Nothing here needs the scheduler, so the tests run straight from main(),
+	which exits with 0 if every check passed, or 1 after naming those that
+	failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+
+/* Demo application includes. */
+#include "serial.h"
+#include "jitter.h"
+
+/* The expected period of the histograms, the counts between interrupts of
+TIM2 in timertest.c. */
+#define mainPERIOD						3600UL
+
+/* The bucket that starts the second page in the torn copy test. */
+#define mainTORN_BUCKET					10UL
+
+/* The largest deviation counted in each linear bucket, and the first counted
+in the first bucket that doubles in width. */
+#define mainLINEAR_LIMIT				( ( unsigned long ) jitterLINEAR_BUCKETS * jitterLINEAR_WIDTH )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The tests.
+ */
+static void prvBucketTest( void );
+static void prvSettleTest( void );
+static void prvWorstCaseTest( void );
+static void prvPercentileTest( void );
+static void prvTornCopyTest( void );
+
+/*
+ * Records a sample that deviates from the period by ulDeviation, late if
+ * xLate is pdTRUE, otherwise early, and returns the counter value recorded.
+ */
+static unsigned long prvRecord( JitterHistogram_t *pxJitter, unsigned long ulDeviation, BaseType_t xLate );
+
+/*
+ * Returns the sum of the buckets of pxJitter.
+ */
+static unsigned long prvBucketTotal( const JitterHistogram_t *pxJitter );
+
+/*
+ * Records a sample in the histogram of the torn copy test when the copy
+ * faults on its second page.
+ */
+static void prvFaultHandler( int iSignal, siginfo_t *pxInfo, void *pvContext );
+
+/*
+ * Records a failed check.  ulValue is printed to help find the cause.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* The counter value each histogram was last given, by prvRecord(). */
+static unsigned long ulCount = 0;
+
+/* The line written by vJitterReport(). */
+static char cReport[ 1024 ];
+
+/* The histogram of the torn copy test, the page it faults on, and the faults
+taken. */
+static JitterHistogram_t *pxTornJitter = NULL;
+static void *pvTornPage = NULL;
+static size_t xPageSize = 0;
+static volatile unsigned long ulFaults = 0;
+
+/* Set to pdTRUE by any check that fails. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	prvBucketTest();
+	prvSettleTest();
+	prvWorstCaseTest();
+	prvPercentileTest();
+	prvTornCopyTest();
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All jitter histogram tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+void vSerialPutString( xComPortHandle pxPort, const signed char * const pcString, unsigned short usStringLength )
+{
+	( void ) pxPort;
+
+	if( usStringLength < sizeof( cReport ) )
+	{
+		memcpy( ( void * ) cReport, ( const void * ) pcString, usStringLength );
+		cReport[ usStringLength ] = 0x00;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvBucketTest( void )
+{
+static const unsigned long ulCases[][ 2 ] =
+{
+	/* Deviation, bucket. */
+	{ 0, 0 },
+	{ jitterLINEAR_WIDTH - 1, 0 },
+	{ jitterLINEAR_WIDTH, 1 },
+	{ mainLINEAR_LIMIT - 1, jitterLINEAR_BUCKETS - 1 },
+	{ mainLINEAR_LIMIT, jitterLINEAR_BUCKETS },
+	{ ( mainLINEAR_LIMIT * 2 ) - 1, jitterLINEAR_BUCKETS },
+	{ mainLINEAR_LIMIT * 2, jitterLINEAR_BUCKETS + 1 },
+	{ ( mainLINEAR_LIMIT * 4 ) - 1, jitterLINEAR_BUCKETS + 1 },
+	{ mainLINEAR_LIMIT * 4, jitterLINEAR_BUCKETS + 2 },
+	{ ( mainLINEAR_LIMIT << ( jitterLOG2_BUCKETS - 1 ) ) - 1, jitterNUM_BUCKETS - 2 },
+	{ mainLINEAR_LIMIT << ( jitterLOG2_BUCKETS - 1 ), jitterNUM_BUCKETS - 1 },
+	{ 0x7fffffffUL, jitterNUM_BUCKETS - 1 }
+};
+JitterHistogram_t xJitter;
+unsigned long x;
+
+	for( x = 0; x < ( sizeof( ulCases ) / sizeof( ulCases[ 0 ] ) ); x++ )
+	{
+		vJitterInit( &xJitter, mainPERIOD, 0xffffffffUL, 0 );
+		( void ) prvRecord( &xJitter, 0, pdTRUE );
+		( void ) prvRecord( &xJitter, ulCases[ x ][ 0 ], pdTRUE );
+
+		if( ( xJitter.ulSamples != 1UL ) || ( xJitter.ulBuckets[ ulCases[ x ][ 1 ] ] != 1UL ) || ( prvBucketTotal( &xJitter ) != 1UL ) )
+		{
+			prvCheck( pdFALSE, "deviation counted in its bucket", ulCases[ x ][ 0 ] );
+		}
+
+		/* The same deviation early, where it fits in the period. */
+		if( ulCases[ x ][ 0 ] < mainPERIOD )
+		{
+			( void ) prvRecord( &xJitter, ulCases[ x ][ 0 ], pdFALSE );
+			prvCheck( xJitter.ulBuckets[ ulCases[ x ][ 1 ] ] == 2UL, "early deviation counted in its bucket", ulCases[ x ][ 0 ] );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSettleTest( void )
+{
+JitterHistogram_t xJitter;
+unsigned long x;
+
+	/* The first five interrupts are not recorded. */
+	vJitterInit( &xJitter, mainPERIOD, 0xffffffffUL, 5 );
+
+	for( x = 0; x < 5UL; x++ )
+	{
+		( void ) prvRecord( &xJitter, 1000, pdTRUE );
+	}
+
+	prvCheck( ( xJitter.ulSamples == 0UL ) && ( xJitter.ulMaxDeviation == 0UL ) && ( xJitter.ulSequence == 0UL ), "settling interrupts not recorded", xJitter.ulSamples );
+
+	( void ) prvRecord( &xJitter, 2, pdTRUE );
+	prvCheck( ( xJitter.ulSamples == 1UL ) && ( xJitter.ulBuckets[ 0 ] == 1UL ) && ( xJitter.ulSequence == 1UL ), "first interrupt after settling recorded", xJitter.ulSamples );
+
+	/* A 16 bit counter wraps between interrupts. */
+	vJitterInit( &xJitter, mainPERIOD, 0xffffUL, 0 );
+	vJitterRecordFromISR( &xJitter, 0xff00UL );
+	vJitterRecordFromISR( &xJitter, ( 0xff00UL + mainPERIOD + 9UL ) & 0xffffUL );
+	vJitterRecordFromISR( &xJitter, ( 0xff00UL + ( 2UL * mainPERIOD ) + 9UL - 5UL ) & 0xffffUL );
+	prvCheck( ( xJitter.ulSamples == 2UL ) && ( xJitter.ulMaxDeviation == 9UL ) && ( xJitter.ulBuckets[ 1 ] == 1UL ) && ( xJitter.ulBuckets[ 2 ] == 1UL ), "16 bit counter wraps", xJitter.ulMaxDeviation );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWorstCaseTest( void )
+{
+static const unsigned long ulDeviations[] = { 5, 40, 300, 7, 300, 12, 299 };
+JitterHistogram_t xJitter;
+unsigned long x, ulWorstCount = 0, ulRecorded;
+
+	vJitterInit( &xJitter, mainPERIOD, 0xffffffffUL, 0 );
+	( void ) prvRecord( &xJitter, 0, pdTRUE );
+
+	for( x = 0; x < ( sizeof( ulDeviations ) / sizeof( ulDeviations[ 0 ] ) ); x++ )
+	{
+		ulRecorded = prvRecord( &xJitter, ulDeviations[ x ], ( ( x & 1UL ) == 0UL ) ? pdTRUE : pdFALSE );
+
+		if( x == 2UL )
+		{
+			ulWorstCount = ulRecorded;
+		}
+	}
+
+	/* The first of the two largest deviations is the one kept. */
+	prvCheck( xJitter.ulMaxDeviation == 300UL, "largest deviation", xJitter.ulMaxDeviation );
+	prvCheck( xJitter.ulWorstSample == 3UL, "sample of the largest deviation", xJitter.ulWorstSample );
+	prvCheck( xJitter.ulWorstCount == ulWorstCount, "count of the largest deviation", xJitter.ulWorstCount );
+	prvCheck( xJitter.ulSamples == ( sizeof( ulDeviations ) / sizeof( ulDeviations[ 0 ] ) ), "worst case samples", xJitter.ulSamples );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPercentileTest( void )
+{
+static JitterHistogram_t xJitter;
+char cExpected[ 128 ];
+unsigned long x, ulDeviation, ulWorstCount = 0, ulRecorded;
+size_t xLength;
+
+	/* No samples. */
+	vJitterInit( &xJitter, mainPERIOD, 0xffffffffUL, 0 );
+	prvCheck( ulJitterPercentile( &xJitter, 5000UL ) == 0UL, "percentile of no samples", ulJitterPercentile( &xJitter, 5000UL ) );
+
+	/* 9000 samples of 1, in bucket 0, 900 of 20, in bucket 5, 90 of 100, in
+	the first bucket that doubles, and 10 of 5000, in the seventh. */
+	( void ) prvRecord( &xJitter, 0, pdTRUE );
+
+	for( x = 0; x < 10000UL; x++ )
+	{
+		if( ( x % 1000UL ) == 999UL )
+		{
+			ulDeviation = 5000;
+		}
+		else if( ( x % 100UL ) == 99UL )
+		{
+			ulDeviation = 100;
+		}
+		else if( ( x % 10UL ) == 9UL )
+		{
+			ulDeviation = 20;
+		}
+		else
+		{
+			ulDeviation = 1;
+		}
+
+		/* Alternately late and early, but a deviation longer than the period
+		can only be late. */
+		ulRecorded = prvRecord( &xJitter, ulDeviation, ( ( ( x & 1UL ) == 0UL ) || ( ulDeviation > mainPERIOD ) ) ? pdTRUE : pdFALSE );
+
+		if( x == 999UL )
+		{
+			ulWorstCount = ulRecorded;
+		}
+	}
+
+	prvCheck( ( xJitter.ulBuckets[ 0 ] == 9000UL ) && ( xJitter.ulBuckets[ 5 ] == 900UL ), "linear buckets of the percentiles", xJitter.ulBuckets[ 5 ] );
+	prvCheck( ( xJitter.ulBuckets[ jitterLINEAR_BUCKETS ] == 90UL ) && ( xJitter.ulBuckets[ jitterLINEAR_BUCKETS + 6 ] == 10UL ), "doubling buckets of the percentiles", xJitter.ulBuckets[ jitterLINEAR_BUCKETS + 6 ] );
+
+	/* The 5000th, 9900th and 9990th samples are the last of their buckets. */
+	prvCheck( ulJitterPercentile( &xJitter, 5000UL ) == ( jitterLINEAR_WIDTH - 1UL ), "p50", ulJitterPercentile( &xJitter, 5000UL ) );
+	prvCheck( ulJitterPercentile( &xJitter, 9900UL ) == ( ( 6UL * jitterLINEAR_WIDTH ) - 1UL ), "p99", ulJitterPercentile( &xJitter, 9900UL ) );
+	prvCheck( ulJitterPercentile( &xJitter, 9990UL ) == ( ( 2UL * mainLINEAR_LIMIT ) - 1UL ), "p99.9", ulJitterPercentile( &xJitter, 9990UL ) );
+	prvCheck( ulJitterPercentile( &xJitter, 9991UL ) == 5000UL, "percentile no more than the largest deviation", ulJitterPercentile( &xJitter, 9991UL ) );
+
+	/* The sample one past a bucket is in the next. */
+	prvCheck( ulJitterPercentile( &xJitter, 9001UL ) == ( ( 6UL * jitterLINEAR_WIDTH ) - 1UL ), "percentile past a bucket", ulJitterPercentile( &xJitter, 9001UL ) );
+
+	vJitterReport( &xJitter, "TEST" );
+	xLength = ( size_t ) sprintf( cExpected, "jitter,TEST,10000,5000,1000,%lu,%lu,%lu,%lu,9000,0,0,0,0,900,", ulWorstCount,
+								  jitterLINEAR_WIDTH - 1UL, ( 6UL * jitterLINEAR_WIDTH ) - 1UL, ( 2UL * mainLINEAR_LIMIT ) - 1UL );
+	prvCheck( strncmp( cReport, cExpected, xLength ) == 0, "report line", 0 );
+	prvCheck( strstr( cReport, ",90,0,0,0,0,0,10,0," ) != NULL, "report buckets", 0 );
+	prvCheck( ( strlen( cReport ) > 2U ) && ( strcmp( &( cReport[ strlen( cReport ) - 2U ] ), "\r\n" ) == 0 ), "report line ended", 0 );
+
+	if( xFailed != pdFALSE )
+	{
+		printf( "%s", cReport );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTornCopyTest( void )
+{
+struct sigaction xAction;
+JitterHistogram_t xCopy;
+unsigned char *pucPages;
+unsigned long x;
+
+	/* Two pages, with the histogram placed so its buckets from mainTORN_BUCKET
+	on are in the second. */
+	xPageSize = ( size_t ) sysconf( _SC_PAGESIZE );
+	pucPages = ( unsigned char * ) mmap( NULL, 2U * xPageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+	if( pucPages == MAP_FAILED )
+	{
+		prvCheck( pdFALSE, "pages mapped", 0 );
+		return;
+	}
+
+	pvTornPage = ( void * ) &( pucPages[ xPageSize ] );
+	pxTornJitter = ( JitterHistogram_t * ) ( &( pucPages[ xPageSize - offsetof( JitterHistogram_t, ulBuckets ) - ( mainTORN_BUCKET * sizeof( unsigned long ) ) ] ) );
+
+	vJitterInit( pxTornJitter, mainPERIOD, 0xffffffffUL, 0 );
+	( void ) prvRecord( pxTornJitter, 0, pdTRUE );
+
+	for( x = 0; x < 100UL; x++ )
+	{
+		( void ) prvRecord( pxTornJitter, x, pdTRUE );
+	}
+
+	/* Reading the second page faults, and the handler records a sample whose
+	deviation is counted there, as the interrupt could part way through a
+	copy. */
+	memset( ( void * ) &xAction, 0x00, sizeof( xAction ) );
+	xAction.sa_sigaction = prvFaultHandler;
+	xAction.sa_flags = SA_SIGINFO;
+	sigemptyset( &( xAction.sa_mask ) );
+	( void ) sigaction( SIGSEGV, &xAction, NULL );
+	( void ) mprotect( pvTornPage, xPageSize, PROT_NONE );
+
+	vJitterSnapshot( pxTornJitter, &xCopy );
+
+	xAction.sa_handler = SIG_DFL;
+	xAction.sa_flags = 0;
+	( void ) sigaction( SIGSEGV, &xAction, NULL );
+
+	prvCheck( ulFaults == 1UL, "interrupt during the copy", ulFaults );
+	prvCheck( pxTornJitter->ulSamples == 101UL, "interrupt recorded a sample", pxTornJitter->ulSamples );
+	prvCheck( xCopy.ulSamples == pxTornJitter->ulSamples, "copy taken after the interrupt", xCopy.ulSamples );
+	prvCheck( prvBucketTotal( &xCopy ) == xCopy.ulSamples, "copy consistent", prvBucketTotal( &xCopy ) );
+	prvCheck( memcmp( ( void * ) &xCopy, ( void * ) pxTornJitter, sizeof( xCopy ) ) == 0, "copy equal to the histogram", 0 );
+
+	( void ) munmap( ( void * ) pucPages, 2U * xPageSize );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFaultHandler( int iSignal, siginfo_t *pxInfo, void *pvContext )
+{
+	( void ) iSignal;
+	( void ) pvContext;
+
+	if( ( ( unsigned char * ) pxInfo->si_addr < ( unsigned char * ) pvTornPage ) ||
+		( ( unsigned char * ) pxInfo->si_addr >= ( ( unsigned char * ) pvTornPage + xPageSize ) ) )
+	{
+		/* Not the fault of the test. */
+		abort();
+	}
+
+	/* The read that faulted is made again once the handler returns. */
+	( void ) mprotect( pvTornPage, xPageSize, PROT_READ | PROT_WRITE );
+	( void ) prvRecord( pxTornJitter, mainLINEAR_LIMIT * 8UL, pdTRUE );
+	ulFaults++;
+}
+/*-----------------------------------------------------------*/
+
+static unsigned long prvRecord( JitterHistogram_t *pxJitter, unsigned long ulDeviation, BaseType_t xLate )
+{
+	if( xLate != pdFALSE )
+	{
+		ulCount += mainPERIOD + ulDeviation;
+	}
+	else
+	{
+		ulCount += mainPERIOD - ulDeviation;
+	}
+
+	ulCount &= 0xffffffffUL;
+	vJitterRecordFromISR( pxJitter, ulCount );
+
+	return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+static unsigned long prvBucketTotal( const JitterHistogram_t *pxJitter )
+{
+unsigned long x, ulTotal = 0;
+
+	for( x = 0; x < jitterNUM_BUCKETS; x++ )
+	{
+		ulTotal += pxJitter->ulBuckets[ x ];
+	}
+
+	return ulTotal;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		printf( "Failed %s (%lu)\n", pcCheck, ulValue );
+		xFailed = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,860 @@
+/*
+	Tests the LCD driver of lcd.c on the host build, with SPI2, its DMA channel
+	and the LCD controller simulated by lcd_sim.c.  The RCC registers are set
+	for the 72MHz PLL clock of the target, so the SPI clock, and the rate the
+	DMA moves pixels at, is the 18MHz the driver sets.  The functions of
+	spi_flash.c that LCD_DrawBMP() reads the picture with are provided here,
+	and serve a picture that follows from the address of each byte.
+
+	Built with LCD_USE_DMA set to 1 the driver moves blocks of pixels with the
+	DMA, and with it set to 0 polls.  Each drawing function is checked against
+	the same picture drawn with LCD_WriteRAM() for each pixel, or with
+	LCD_DrawChar() for each character, both of which write a pixel at a time.
+	The LCD is set to a colour the tests never draw before each is drawn, so a
+	pixel written by one and not the other is seen.
+
+	+ The fill test clears the LCD, and fills part of a row onwards, which must
+	  each be one stream of pixels with the LCD selected once, and the clear
+	  moved in two DMA transfers as it is more than one can move.
+
+	+ The burst test writes a block of pixels that is also more than a DMA
+	  transfer can move, with and without the DMA, and a block too short for
+	  the DMA.
+
+	+ The picture test draws a monochrome picture and a bitmap from the FLASH,
+	  which are built in one pixel buffer while the other is sent.
+
+	+ The text test draws lines holding every character, in several colours,
+	  more than the glyph cache holds in one line and in turn, so characters
+	  are drawn from the cache, expanded into it in place of others, and drawn
+	  from their bits when the line needs more than the cache holds.  A whole
+	  line must be one stream, and a shorter one a stream for each row.
+
+	+ The deferred screen test sets the characters of the deferred text
+	  screen, and each update must draw the characters that changed and no
+	  others, each run of them a stream for each row.
+
+	+ The scroll test scrolls a line from a task that is stopped after each
+	  step, which must show the text one character further right and have
+	  drawn only the characters that changed.
+
+	+ The benchmark test runs the benchmarks of lcd_bench.c, which must report
+	  benchITERATIONS samples for each case.
+
+	No frame may be sent with the LCD not selected.  The program ends the
+	scheduler once the tests have run, and exits with 0 if every check passed,
+	or 1 after naming those that failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Library includes. */
+#include "stm32f10x_lib.h"
+#include "lcd.h"
+#include "spi_flash.h"
+
+/* Demo application includes. */
+#include "serial.h"
+#include "KernelBench.h"
+#include "lcd_bench.h"
+#include "lcd_sim.h"
+
+/* The priorities of the task that runs the tests, of the task that scrolls a
+line, which must draw each step as soon as its delay ends, and of the
+benchmarks. */
+#define mainTEST_TASK_PRIORITY			( tskIDLE_PRIORITY + 2 )
+#define mainSCROLL_TASK_PRIORITY		( tskIDLE_PRIORITY + 3 )
+#define mainBENCHMARK_PRIORITY			( tskIDLE_PRIORITY + 1 )
+
+/* The CFGR register of the target once it runs from the PLL: the 8MHz HSE
+multiplied by 9, with PCLK1 at half HCLK, and the switch status showing the
+PLL. */
+#define mainCFGR_PLL_72MHZ				( RCC_PLLSource_HSE_Div1 | RCC_PLLMul_9 | RCC_HCLK_Div2 | 0x00000008UL )
+
+/* The colour the LCD is set to before each drawing, which no test draws. */
+#define mainUNDRAWN						( ( uint16_t ) 0x1234 )
+
+/* The pixels of the LCD, and of a character. */
+#define mainPIXELS						( lcdsimROWS * lcdsimCOLUMNS )
+#define mainCHAR_PIXELS					( 16UL * 24UL )
+
+/* The pixels written by the burst test, more than a DMA transfer moves, and so
+the transfers the bursts and the clear take. */
+#define mainBURST_PIXELS				70000UL
+#define mainDMA_MAX_BLOCK				65535UL
+#define mainTRANSFERS( x )				( ( ( x ) + mainDMA_MAX_BLOCK - 1UL ) / mainDMA_MAX_BLOCK )
+
+/* The words of a monochrome picture, and the address of the bitmap. */
+#define mainMONO_WORDS					2400U
+#define mainBMP_ADDRESS					0x00064000UL
+
+/* The characters of a line, and the line the scroll test scrolls. */
+#define mainLINE_CHARS					20U
+#define mainSCROLL_LINE					Line6
+#define mainSCROLL_TEXT					"aaa bbb  Scroll me, one step at a time!"
+#define mainSCROLL_STEPS				25U
+
+/* The time the scroll task must go without writing a pixel to have drawn a
+step.  The simulated DMA moves pixels on every tick while a transfer is in
+progress. */
+#define mainSCROLL_IDLE_TIME			( ( TickType_t ) 2 )
+
+/* The cases of lcd_bench.c. */
+#if LCD_USE_DMA == 1
+	#define mainBENCHMARK_CASES			6U
+#else
+	#define mainBENCHMARK_CASES			4U
+#endif
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Runs the tests.
+ */
+static void prvTestTask( void *pvParameters );
+
+/*
+ * Scrolls mainSCROLL_TEXT along mainSCROLL_LINE.
+ */
+static void prvScrollTask( void *pvParameters );
+
+/*
+ * The tests.
+ */
+static void prvFillTest( void );
+static void prvBurstTest( void );
+static void prvPictureTest( void );
+static void prvTextTest( void );
+static void prvDeferredTest( void );
+static void prvScrollTest( void );
+static void prvBenchmarkTest( void );
+
+/*
+ * prvDraw() sets the LCD to mainUNDRAWN before the function tested draws.
+ * prvKeep() keeps what it drew and sets the LCD to mainUNDRAWN again, for the
+ * same picture to be drawn a pixel at a time, and prvDrawn() returns the
+ * number of pixels that differ between the two.
+ */
+static void prvDraw( void );
+static void prvKeep( void );
+static uint32_t prvDrawn( void );
+
+/*
+ * Draws a pixel at a time: ulPixels pixels of pusPixels, or of one colour if
+ * xIncrement is pdFALSE, from a row and column.
+ */
+static void prvWritePixels( u8 ucRow, u16 usColumn, const uint16_t *pusPixels, uint32_t ulPixels, BaseType_t xIncrement );
+
+/*
+ * Draws up to mainLINE_CHARS characters of pcText with LCD_DrawChar(), as
+ * LCD_DisplayStringLine() draws them.
+ */
+static void prvDrawCharLine( u8 ucLine, const char *pcText );
+
+/*
+ * Sets the colours of the text drawn from now on.
+ */
+static void prvSetColors( uint16_t usText, uint16_t usBack );
+
+/*
+ * Sets a character of the deferred text screen, and what the screen is
+ * expected to show.
+ */
+static void prvDeferChar( uint32_t ulRow, uint32_t ulIndex, char cAscii );
+
+/*
+ * Draws what the deferred text screen is expected to show with
+ * LCD_DrawChar().
+ */
+static void prvDrawExpectedScreen( void );
+
+/*
+ * The byte of the bitmap at ulOffset, and the pixel of it, low byte first.
+ */
+static uint8_t prvBMPByte( uint32_t ulOffset );
+static uint16_t prvBMPPixel( uint32_t ulPixel );
+
+/*
+ * Records a failed check.  ulValue is printed to help find the cause.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* The LCD as drawn by the function tested, and as drawn a pixel at a time. */
+static uint16_t usDrawn[ mainPIXELS ];
+static uint16_t usExpected[ mainPIXELS ];
+
+/* The pixels the burst test writes, which the DMA moves so must be static,
+and the monochrome picture. */
+static uint16_t usBurst[ mainBURST_PIXELS ];
+static uint32_t ulMonoPicture[ mainMONO_WORDS ];
+
+/* The colours text is drawn in, and what each cell of the deferred text
+screen is expected to show. */
+static uint16_t usTextColor = Black, usBackColor = White;
+static char cScreen[ 10 ][ mainLINE_CHARS ];
+static uint16_t usScreenText[ 10 ][ mainLINE_CHARS ];
+static uint16_t usScreenBack[ 10 ][ mainLINE_CHARS ];
+
+/* The next byte of the bitmap read from the FLASH. */
+static uint32_t ulBMPOffset = 0;
+
+/* The benchmark lines written, and the number. */
+static char cBenchLines[ mainBENCHMARK_CASES ][ 256 ];
+static uint32_t ulBenchLines = 0;
+
+/* Whether any check failed. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	debug();
+	RCC->CFGR = mainCFGR_PLL_72MHZ;
+
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE * 2, NULL, mainTEST_TASK_PRIORITY, NULL );
+
+	vTaskStartScheduler();
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All LCD tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationTickHook( void )
+{
+	vLCDSimTick();
+}
+/*-----------------------------------------------------------*/
+
+void vSerialPutString( xComPortHandle pxPort, const signed char * const pcString, unsigned short usStringLength )
+{
+	( void ) pxPort;
+
+	/* The benchmark lines. */
+	if( ( ulBenchLines < mainBENCHMARK_CASES ) && ( usStringLength < sizeof( cBenchLines[ 0 ] ) ) )
+	{
+		memcpy( ( void * ) cBenchLines[ ulBenchLines ], ( const void * ) pcString, usStringLength );
+		cBenchLines[ ulBenchLines ][ usStringLength ] = 0x00;
+	}
+
+	ulBenchLines++;
+	printf( "%.*s", ( int ) usStringLength, ( const char * ) pcString );
+}
+/*-----------------------------------------------------------*/
+
+void SPI_FLASH_StartReadSequence( u32 ReadAddr )
+{
+	ulBMPOffset = ReadAddr - mainBMP_ADDRESS;
+}
+/*-----------------------------------------------------------*/
+
+void SPI_FLASH_ReadStreamStart( u8 *pBuffer, u16 NumByteToRead )
+{
+	while( NumByteToRead-- > 0U )
+	{
+		*pBuffer++ = prvBMPByte( ulBMPOffset++ );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void SPI_FLASH_ReadStreamWait( void )
+{
+	/* Each block has been read as its read started. */
+}
+/*-----------------------------------------------------------*/
+
+void SPI_FLASH_EndReadSequence( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	LCD_Init();
+
+	prvFillTest();
+	prvBurstTest();
+	prvPictureTest();
+	prvTextTest();
+	prvDeferredTest();
+	prvScrollTest();
+	prvBenchmarkTest();
+
+	prvCheck( ulLCDSimFaults() == 0UL, "frames sent with the LCD selected", ulLCDSimFaults() );
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvScrollTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	LCD_ScrollText( mainSCROLL_LINE, ( u8 * ) mainSCROLL_TEXT );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFillTest( void )
+{
+const uint16_t usWhite = White, usRed = Red;
+uint32_t ulStreams, ulTransfers, ulInterrupts;
+
+	/* The whole LCD. */
+	prvDraw();
+	ulStreams = ulLCDSimStreams();
+	ulTransfers = ulLCDSimTransfers();
+	ulInterrupts = ulLCDSimInterrupts();
+	LCD_Clear();
+	ulStreams = ulLCDSimStreams() - ulStreams;
+	ulTransfers = ulLCDSimTransfers() - ulTransfers;
+	ulInterrupts = ulLCDSimInterrupts() - ulInterrupts;
+	prvKeep();
+	prvWritePixels( 0x00, 0x013F, &usWhite, mainPIXELS, pdFALSE );
+	prvCheck( prvDrawn() == 0UL, "clear", 0 );
+	prvCheck( ulStreams == 1UL, "clear in one stream", ulStreams );
+
+	#if LCD_USE_DMA == 1
+		prvCheck( ulTransfers == mainTRANSFERS( mainPIXELS ), "clear split into transfers", ulTransfers );
+		prvCheck( ulInterrupts == ulTransfers, "clear transfers ended by the interrupt", ulInterrupts );
+	#else
+		( void ) ulInterrupts;
+		prvCheck( ulTransfers == 0UL, "clear polled", ulTransfers );
+	#endif
+
+	/* Part of a row onwards, wrapping onto the rows after it. */
+	prvDraw();
+	LCD_SetCursor( 100, 200 );
+	LCD_FillRAM( Red, 1000 );
+	prvKeep();
+	prvWritePixels( 100, 200, &usRed, 1000, pdFALSE );
+	prvCheck( prvDrawn() == 0UL, "fill", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBurstTest( void )
+{
+uint32_t x, ulStreams, ulTransfers;
+
+	for( x = 0; x < mainBURST_PIXELS; x++ )
+	{
+		usBurst[ x ] = ( uint16_t ) ( ( x * 0x9E37UL ) ^ ( x >> 7 ) );
+	}
+
+	prvDraw();
+	ulStreams = ulLCDSimStreams();
+	ulTransfers = ulLCDSimTransfers();
+	LCD_SetCursor( 7, 123 );
+	LCD_WriteRAMBurst( usBurst, mainBURST_PIXELS );
+	ulStreams = ulLCDSimStreams() - ulStreams;
+	ulTransfers = ulLCDSimTransfers() - ulTransfers;
+	prvKeep();
+	prvWritePixels( 7, 123, usBurst, mainBURST_PIXELS, pdTRUE );
+	prvCheck( prvDrawn() == 0UL, "burst", 0 );
+	prvCheck( ulStreams == 1UL, "burst in one stream", ulStreams );
+
+	#if LCD_USE_DMA == 1
+		prvCheck( ulTransfers == mainTRANSFERS( mainBURST_PIXELS ), "burst split into transfers", ulTransfers );
+	#else
+		prvCheck( ulTransfers == 0UL, "burst polled", ulTransfers );
+	#endif
+
+	/* With the DMA disabled. */
+	prvDraw();
+	ulTransfers = ulLCDSimTransfers();
+	LCD_DMACmd( DISABLE );
+	LCD_SetCursor( 7, 123 );
+	LCD_WriteRAMBurst( usBurst, mainBURST_PIXELS );
+	LCD_DMACmd( ENABLE );
+	ulTransfers = ulLCDSimTransfers() - ulTransfers;
+	prvKeep();
+	prvWritePixels( 7, 123, usBurst, mainBURST_PIXELS, pdTRUE );
+	prvCheck( prvDrawn() == 0UL, "burst with the DMA disabled", 0 );
+	prvCheck( ulTransfers == 0UL, "burst polled with the DMA disabled", ulTransfers );
+
+	/* Too short for the DMA, from the last pixel of a row. */
+	prvDraw();
+	ulTransfers = ulLCDSimTransfers();
+	LCD_SetCursor( 239, 0 );
+	LCD_WriteRAMBurst( &( usBurst[ 1000 ] ), 10 );
+	ulTransfers = ulLCDSimTransfers() - ulTransfers;
+	prvKeep();
+	prvWritePixels( 239, 0, &( usBurst[ 1000 ] ), 10, pdTRUE );
+	prvCheck( prvDrawn() == 0UL, "short burst", 0 );
+	prvCheck( ulTransfers == 0UL, "short burst polled", ulTransfers );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPictureTest( void )
+{
+uint32_t x;
+uint16_t usPixel;
+
+	for( x = 0; x < mainMONO_WORDS; x++ )
+	{
+		ulMonoPicture[ x ] = ( x * 2654435761UL ) ^ ( x << 9 );
+	}
+
+	/* A monochrome picture, bit 0 of each word first. */
+	prvSetColors( Blue, Yellow );
+	prvDraw();
+	LCD_DrawMonoPict( ulMonoPicture );
+	prvKeep();
+	LCD_SetCursor( 0, 319 );
+
+	for( x = 0; x < ( mainMONO_WORDS * 32UL ); x++ )
+	{
+		LCD_WriteRAM( ( ( ulMonoPicture[ x / 32UL ] & ( 1UL << ( x % 32UL ) ) ) != 0UL ) ? Blue : Yellow );
+	}
+
+	prvCheck( prvDrawn() == 0UL, "monochrome picture", 0 );
+
+	/* A bitmap from the FLASH, from the last row. */
+	prvDraw();
+	LCD_DrawBMP( mainBMP_ADDRESS );
+	prvKeep();
+	LCD_SetCursor( 239, 0x013F );
+
+	for( x = 0; x < mainPIXELS; x++ )
+	{
+		usPixel = prvBMPPixel( x );
+		prvWritePixels( ( u8 ) ( ( 239UL + ( x / lcdsimCOLUMNS ) ) % lcdsimROWS ), ( u16 ) ( 319UL - ( x % lcdsimCOLUMNS ) ), &usPixel, 1, pdFALSE );
+	}
+
+	prvCheck( prvDrawn() == 0UL, "bitmap", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTextTest( void )
+{
+static const char * const pcLines[] =
+{
+	" !\"#$%&'()*+,-./0123",
+	"456789:;<=>?@ABCDEFG",
+	"HIJKLMNOPQRSTUVWXYZ[",
+	"\\]^_`abcdefghijklmno",
+	"pqrstuvwxyz{|}~",
+	"aaaaaaaabbbbbbbbcccc",
+	"abcdefghabcdefgh",
+	"Hi\x01\x7f\xff there"
+};
+static const uint16_t usColors[][ 2 ] =
+{
+	{ Black, White }, { Red, Green }, { Magenta, Cyan }, { White, Blue }
+};
+char cLine[ mainLINE_CHARS + 1 ];
+uint32_t ulPass, ulLine, ulStreams, ulTransfers;
+
+	/* Twice, so the second pass finds some characters in the cache, and has
+	to replace others. */
+	for( ulPass = 0; ulPass < 2UL; ulPass++ )
+	{
+		for( ulLine = 0; ulLine < ( sizeof( pcLines ) / sizeof( pcLines[ 0 ] ) ); ulLine++ )
+		{
+			prvSetColors( usColors[ ( ulLine + ulPass ) % 4UL ][ 0 ], usColors[ ( ulLine + ulPass ) % 4UL ][ 1 ] );
+
+			prvDraw();
+			ulStreams = ulLCDSimStreams();
+			ulTransfers = ulLCDSimTransfers();
+			LCD_DisplayStringLine( ( u8 ) ( ulLine * 24UL ), ( u8 * ) pcLines[ ulLine ] );
+			ulStreams = ulLCDSimStreams() - ulStreams;
+			ulTransfers = ulLCDSimTransfers() - ulTransfers;
+			prvKeep();
+			prvDrawCharLine( ( u8 ) ( ulLine * 24UL ), pcLines[ ulLine ] );
+			prvCheck( prvDrawn() == 0UL, "text line", ulLine );
+
+			/* A whole line is one stream, and a shorter one a stream for each
+			row. */
+			prvCheck( ulStreams == ( ( strlen( pcLines[ ulLine ] ) == mainLINE_CHARS ) ? 1UL : 24UL ), "text line streams", ulStreams );
+
+			#if LCD_USE_DMA == 1
+				prvCheck( ulTransfers != 0UL, "text line with the DMA", ulLine );
+			#else
+				prvCheck( ulTransfers == 0UL, "text line polled", ulTransfers );
+			#endif
+		}
+	}
+
+	/* One character, part way along a line. */
+	prvSetColors( Orange, Black );
+	prvDraw();
+	LCD_DisplayChar( Line9, 200, 'Q' );
+	prvKeep();
+	LCD_DrawChar( Line9, 200, &ASCII_Table[ ( 'Q' - 32 ) * 24 ] );
+	prvCheck( prvDrawn() == 0UL, "character", 0 );
+
+	/* Every character in turn, more than the cache holds. */
+	for( ulLine = 0; ulLine < 95UL; ulLine++ )
+	{
+		memset( ( void * ) cLine, ( int ) ( ' ' + ulLine ), mainLINE_CHARS );
+		cLine[ mainLINE_CHARS ] = 0x00;
+
+		prvDraw();
+		LCD_DisplayStringLine( Line4, ( u8 * ) cLine );
+		prvKeep();
+		prvDrawCharLine( Line4, cLine );
+		prvCheck( prvDrawn() == 0UL, "line of one character", ulLine );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvDeferredTest( void )
+{
+uint32_t ulRow, ulIndex, ulPixels, ulStreams;
+
+	/* Every character different from the last, so the screen is drawn in
+	full. */
+	prvSetColors( Black, White );
+	LCD_DeferClear();
+
+	for( ulRow = 0; ulRow < 10UL; ulRow++ )
+	{
+		if( ulRow == 5UL )
+		{
+			prvSetColors( White, Blue );
+		}
+
+		for( ulIndex = 0; ulIndex < mainLINE_CHARS; ulIndex++ )
+		{
+			prvDeferChar( ulRow, ulIndex, ( char ) ( 'A' + ( ( ulRow * 7UL + ulIndex ) % 58UL ) ) );
+		}
+	}
+
+	LCD_InvalidateScreen();
+	prvDraw();
+	ulPixels = ulLCDSimPixels();
+	ulStreams = ulLCDSimStreams();
+	LCD_UpdateScreen();
+	ulPixels = ulLCDSimPixels() - ulPixels;
+	ulStreams = ulLCDSimStreams() - ulStreams;
+	prvKeep();
+	prvDrawExpectedScreen();
+	prvCheck( prvDrawn() == 0UL, "deferred screen", 0 );
+	prvCheck( ulPixels == mainPIXELS, "deferred screen drawn in full", ulPixels );
+	prvCheck( ulStreams == 10UL, "deferred screen a stream for each line", ulStreams );
+
+	/* Nothing changed, and then set to what it already holds. */
+	ulPixels = ulLCDSimPixels();
+	LCD_UpdateScreen();
+	LCD_DeferStringLine( Line7, ( u8 * ) cScreen[ 7 ] );
+	prvSetColors( usScreenText[ 3 ][ 4 ], usScreenBack[ 3 ][ 4 ] );
+	prvDeferChar( 3, 4, cScreen[ 3 ][ 4 ] );
+	LCD_UpdateScreen();
+	prvCheck( ulLCDSimPixels() == ulPixels, "unchanged screen not drawn", ulLCDSimPixels() - ulPixels );
+
+	/* Three runs of changed characters on one line, and one on another. */
+	prvSetColors( Red, White );
+	prvDeferChar( 2, 0, '1' );
+	prvDeferChar( 2, 5, '2' );
+	prvDeferChar( 2, 6, '3' );
+	prvDeferChar( 2, 19, '4' );
+	prvDeferChar( 8, 10, '5' );
+	prvDeferChar( 8, 11, '6' );
+	prvDeferChar( 8, 12, '7' );
+
+	prvDraw();
+	ulPixels = ulLCDSimPixels();
+	ulStreams = ulLCDSimStreams();
+	LCD_UpdateScreen();
+	ulPixels = ulLCDSimPixels() - ulPixels;
+	ulStreams = ulLCDSimStreams() - ulStreams;
+	prvCheck( ulPixels == ( 7UL * mainCHAR_PIXELS ), "changed characters drawn", ulPixels );
+	prvCheck( ulStreams == ( 4UL * 24UL ), "changed characters a stream for each row of each run", ulStreams );
+
+	/* Only the changed characters were drawn, so every other pixel is still
+	undrawn. */
+	prvKeep();
+	prvDrawExpectedScreen();
+	prvCheck( prvDrawn() == ( mainPIXELS - ( 7UL * mainCHAR_PIXELS ) ), "changed characters", 0 );
+
+	/* The text colour of a space is not seen, its background is. */
+	prvSetColors( Black, White );
+	prvDeferChar( 0, 0, ' ' );
+	LCD_UpdateScreen();
+	prvSetColors( Green, White );
+	ulPixels = ulLCDSimPixels();
+	prvDeferChar( 0, 0, ' ' );
+	LCD_UpdateScreen();
+	prvCheck( ulLCDSimPixels() == ulPixels, "space recoloured", ulLCDSimPixels() - ulPixels );
+	prvSetColors( Green, Red );
+	prvDeferChar( 0, 0, ' ' );
+	LCD_UpdateScreen();
+	prvCheck( ulLCDSimPixels() == ( ulPixels + mainCHAR_PIXELS ), "space background", ulLCDSimPixels() - ulPixels );
+
+	/* A cleared line, and a character outside the font shown as a space. */
+	prvSetColors( Black, Cyan );
+	LCD_DeferClearLine( Line1 );
+
+	for( ulIndex = 0; ulIndex < mainLINE_CHARS; ulIndex++ )
+	{
+		cScreen[ 1 ][ ulIndex ] = ' ';
+		usScreenText[ 1 ][ ulIndex ] = Black;
+		usScreenBack[ 1 ][ ulIndex ] = Cyan;
+	}
+
+	LCD_DeferChar( Line9, 3, 0x07 );
+	cScreen[ 9 ][ 3 ] = ' ';
+	usScreenText[ 9 ][ 3 ] = Black;
+	usScreenBack[ 9 ][ 3 ] = Cyan;
+
+	prvDraw();
+	LCD_InvalidateScreen();
+	LCD_UpdateScreen();
+	prvKeep();
+	prvDrawExpectedScreen();
+	prvCheck( prvDrawn() == 0UL, "cleared line", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvScrollTest( void )
+{
+const char * const pcText = mainSCROLL_TEXT;
+const uint32_t ulLength = strlen( pcText );
+TaskHandle_t xScrollTask = NULL;
+char cLine[ mainLINE_CHARS + 1 ], cLast[ mainLINE_CHARS + 1 ];
+uint32_t ulStep, ulIndex, ulPixels, ulDrawn, ulChanged;
+
+	prvSetColors( Blue, White );
+	cLine[ mainLINE_CHARS ] = 0x00;
+	cLast[ mainLINE_CHARS ] = 0x00;
+
+	/* The deferred text screen already holds the first step, but the LCD
+	shows other text, so the first step must still draw the whole line. */
+	LCD_DeferStringLine( mainSCROLL_LINE, ( u8 * ) pcText );
+	LCD_UpdateScreen();
+	LCD_ClearLine( mainSCROLL_LINE );
+
+	for( ulStep = 0; ulStep < mainSCROLL_STEPS; ulStep++ )
+	{
+		/* Character i of the line shows the character of the text i - step
+		along, wrapping round. */
+		for( ulIndex = 0; ulIndex < mainLINE_CHARS; ulIndex++ )
+		{
+			cLine[ ulIndex ] = pcText[ ( ulIndex + ( ulLength * mainSCROLL_STEPS ) - ulStep ) % ulLength ];
+		}
+
+		/* Let the task draw the step, and stop it while it waits for the
+		next. */
+		ulPixels = ulLCDSimPixels();
+
+		if( xScrollTask == NULL )
+		{
+			xTaskCreate( prvScrollTask, "Scroll", configMINIMAL_STACK_SIZE * 2, NULL, mainSCROLL_TASK_PRIORITY, &xScrollTask );
+		}
+		else
+		{
+			vTaskResume( xScrollTask );
+		}
+
+		do
+		{
+			ulDrawn = ulLCDSimPixels();
+			vTaskDelay( mainSCROLL_IDLE_TIME );
+		} while( ulLCDSimPixels() != ulDrawn );
+
+		vTaskSuspend( xScrollTask );
+		ulPixels = ulLCDSimPixels() - ulPixels;
+
+		/* The first step draws the whole line, and the others only the
+		characters that changed. */
+		for( ulIndex = 0, ulChanged = 0; ulIndex < mainLINE_CHARS; ulIndex++ )
+		{
+			if( ( ulStep == 0UL ) || ( cLine[ ulIndex ] != cLast[ ulIndex ] ) )
+			{
+				ulChanged++;
+			}
+		}
+
+		prvCheck( ulPixels == ( ulChanged * mainCHAR_PIXELS ), "scroll step drew the changed characters", ulStep );
+
+		/* Drawing the line again a character at a time over it changes
+		nothing. */
+		vLCDSimGetFrame( usDrawn );
+		prvDrawCharLine( mainSCROLL_LINE, cLine );
+		prvCheck( prvDrawn() == 0UL, "scroll step", ulStep );
+		memcpy( ( void * ) cLast, ( const void * ) cLine, sizeof( cLast ) );
+	}
+
+	vTaskDelete( xScrollTask );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchmarkTest( void )
+{
+static const char * const pcCases[] =
+{
+	"LCD clear per pixel",
+	"LCD clear fill polled",
+	#if LCD_USE_DMA == 1
+		"LCD clear fill DMA",
+	#endif
+	"LCD text per char",
+	"LCD text line polled",
+	#if LCD_USE_DMA == 1
+		"LCD text line DMA",
+	#endif
+};
+char cExpected[ 64 ];
+uint32_t x;
+
+	vStartLCDBenchmarks( mainBENCHMARK_PRIORITY );
+
+	for( x = 0; ( x < 300UL ) && ( xAreBenchmarksComplete() == pdFALSE ); x++ )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 100 ) );
+	}
+
+	prvCheck( xAreBenchmarksComplete(), "benchmarks complete", ulBenchLines );
+	prvCheck( ulBenchLines == mainBENCHMARK_CASES, "benchmark lines", ulBenchLines );
+
+	for( x = 0; ( x < ulBenchLines ) && ( x < mainBENCHMARK_CASES ); x++ )
+	{
+		( void ) sprintf( cExpected, "bench,%s,%lu,", pcCases[ x ], ( unsigned long ) benchITERATIONS );
+		prvCheck( strncmp( cBenchLines[ x ], cExpected, strlen( cExpected ) ) == 0, "benchmark samples", x );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvDraw( void )
+{
+	vLCDSimSetFrame( mainUNDRAWN );
+}
+/*-----------------------------------------------------------*/
+
+static void prvKeep( void )
+{
+	vLCDSimGetFrame( usDrawn );
+	vLCDSimSetFrame( mainUNDRAWN );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvDrawn( void )
+{
+uint32_t x, ulDiffer = 0;
+
+	vLCDSimGetFrame( usExpected );
+
+	for( x = 0; x < mainPIXELS; x++ )
+	{
+		if( usDrawn[ x ] != usExpected[ x ] )
+		{
+			ulDiffer++;
+		}
+	}
+
+	return ulDiffer;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWritePixels( u8 ucRow, u16 usColumn, const uint16_t *pusPixels, uint32_t ulPixels, BaseType_t xIncrement )
+{
+uint32_t x;
+
+	LCD_SetCursor( ucRow, usColumn );
+
+	for( x = 0; x < ulPixels; x++ )
+	{
+		LCD_WriteRAM( *pusPixels );
+
+		if( xIncrement != pdFALSE )
+		{
+			pusPixels++;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvDrawCharLine( u8 ucLine, const char *pcText )
+{
+uint32_t x;
+uint8_t ucAscii;
+
+	for( x = 0; ( x < mainLINE_CHARS ) && ( pcText[ x ] != 0x00 ); x++ )
+	{
+		ucAscii = ( uint8_t ) pcText[ x ];
+
+		if( ( ucAscii < 0x20U ) || ( ucAscii > 0x7EU ) )
+		{
+			ucAscii = ' ';
+		}
+
+		LCD_DrawChar( ucLine, ( u16 ) ( 319UL - ( x * 16UL ) ), &ASCII_Table[ ( ucAscii - 32U ) * 24U ] );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetColors( uint16_t usText, uint16_t usBack )
+{
+	usTextColor = usText;
+	usBackColor = usBack;
+	LCD_SetTextColor( usText );
+	LCD_SetBackColor( usBack );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDeferChar( uint32_t ulRow, uint32_t ulIndex, char cAscii )
+{
+	LCD_DeferChar( ( u8 ) ( ulRow * 24UL ), ( u8 ) ulIndex, ( u8 ) cAscii );
+	cScreen[ ulRow ][ ulIndex ] = cAscii;
+	usScreenText[ ulRow ][ ulIndex ] = usTextColor;
+	usScreenBack[ ulRow ][ ulIndex ] = usBackColor;
+}
+/*-----------------------------------------------------------*/
+
+static void prvDrawExpectedScreen( void )
+{
+const uint16_t usText = usTextColor, usBack = usBackColor;
+uint32_t ulRow, ulIndex;
+
+	for( ulRow = 0; ulRow < 10UL; ulRow++ )
+	{
+		for( ulIndex = 0; ulIndex < mainLINE_CHARS; ulIndex++ )
+		{
+			LCD_SetTextColor( usScreenText[ ulRow ][ ulIndex ] );
+			LCD_SetBackColor( usScreenBack[ ulRow ][ ulIndex ] );
+			LCD_DrawChar( ( u8 ) ( ulRow * 24UL ), ( u16 ) ( 319UL - ( ulIndex * 16UL ) ), &ASCII_Table[ ( ( uint8_t ) cScreen[ ulRow ][ ulIndex ] - 32U ) * 24U ] );
+		}
+	}
+
+	prvSetColors( usText, usBack );
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvBMPByte( uint32_t ulOffset )
+{
+const uint16_t usPixel = prvBMPPixel( ulOffset / 2UL );
+
+	return ( ( ulOffset & 1UL ) == 0UL ) ? ( uint8_t ) usPixel : ( uint8_t ) ( usPixel >> 8 );
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t prvBMPPixel( uint32_t ulPixel )
+{
+	return ( uint16_t ) ( ( ulPixel * 0x9E37UL ) ^ ( ulPixel >> 5 ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		printf( "Failed %s (%lu)\n", pcCheck, ulValue );
+		xFailed = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
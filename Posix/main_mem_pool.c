@@ -0,0 +1,430 @@
+/*
+	Tests the fixed block memory pools of mem_pool.c on the host build.
+
+	+ The exhaust test creates a pool from a static buffer and allocates
+	  every block, each of which must be aligned, inside the buffer and
+	  clear of the others, then runs the pool dry, and each allocation that
+	  fails must be counted.
+
+	+ The water mark test checks the free block count and the fewest free
+	  blocks there have been as blocks are allocated and freed.
+
+	+ The reuse test frees blocks in one order, which must be handed out
+	  again in the reverse order, the most recently freed first, before any
+	  block that has never been used.
+
+	+ The ISR test allocates a message from the pool in the tick hook, with
+	  pvMemPoolAllocFromISR(), and sends a pointer to it through a queue of
+	  pointers to the test task, which frees it once checked.  The test task
+	  then stops receiving until the pool has run dry, and the allocations
+	  the tick hook found the pool empty for must match the failures counted
+	  by the pool, and show as nothing more than gaps in the messages.
+
+	The program ends the scheduler once the tests have run, and exits with 0 if
+	every check passed, or 1 after naming those that failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "mem_pool.h"
+
+/* The priority of the task that runs the tests. */
+#define mainTEST_TASK_PRIORITY			( tskIDLE_PRIORITY + 2 )
+
+/* The blocks of the pools. */
+#define mainPOOL_BLOCKS					( 8 )
+
+/* The allocations made once the pool is empty in the exhaust test. */
+#define mainFAILED_ALLOCATIONS			( 3 )
+
+/* The messages the ISR test receives before it stops receiving, and the
+ticks it then stops for, long enough for the tick hook to run the pool dry. */
+#define mainISR_MESSAGES				( 50 )
+#define mainISR_STALL_TICKS				( mainPOOL_BLOCKS * 3 )
+
+/* The longest a test waits for a message that should arrive. */
+#define mainMAX_WAIT					( pdMS_TO_TICKS( 100 ) )
+
+/* A message passed by reference, which is not a multiple of the alignment of
+the blocks, so the block size is rounded up. */
+typedef struct MESSAGE
+{
+	uint32_t ulSequence;
+	uint8_t ucData[ 13 ];
+} Message_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Runs the tests.
+ */
+static void prvTestTask( void *pvParameters );
+
+/*
+ * The tests.
+ */
+static void prvExhaustTest( void );
+static void prvWaterMarkTest( void );
+static void prvReuseTest( void );
+static void prvISRTest( void );
+
+/*
+ * Creates the pool of mainPOOL_BLOCKS messages in xPoolStorage.
+ */
+static MemPoolHandle_t prvCreatePool( void );
+
+/*
+ * Checks the statistics returned by vMemPoolGetStats().
+ */
+static void prvCheckStats( MemPoolHandle_t xPool, UBaseType_t uxFree, UBaseType_t uxMinimumEverFree, UBaseType_t uxFailed );
+
+/*
+ * Records a failed check.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* The buffer the pools are created in, and the structure that holds them. */
+static uint8_t ucPoolStorage[ memPOOL_STORAGE_SIZE( sizeof( Message_t ), mainPOOL_BLOCKS ) ] __attribute__( ( aligned( memPOOL_BLOCK_ALIGNMENT ) ) );
+static StaticMemPool_t xPoolStruct;
+
+/* The pool and queue of message pointers used by the tick hook, the sequence
+number of the next message it sends, and the allocations that failed.  The
+tick hook only sends while xISRSending is pdTRUE. */
+static MemPoolHandle_t xISRPool = NULL;
+static QueueHandle_t xISRQueue = NULL;
+static volatile BaseType_t xISRSending = pdFALSE;
+static volatile uint32_t ulISRSequence = 0, ulISRFailures = 0;
+
+/* Whether any check failed. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE * 2, NULL, mainTEST_TASK_PRIORITY, NULL );
+
+	vTaskStartScheduler();
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All memory pool tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationTickHook( void )
+{
+Message_t *pxMessage;
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	if( xISRSending != pdFALSE )
+	{
+		pxMessage = ( Message_t * ) pvMemPoolAllocFromISR( xISRPool );
+
+		if( pxMessage != NULL )
+		{
+			pxMessage->ulSequence = ulISRSequence;
+			memset( pxMessage->ucData, ( int ) ( ulISRSequence & 0xffUL ), sizeof( pxMessage->ucData ) );
+
+			/* The queue holds as many pointers as the pool has blocks, so
+			there is always space for a block that was allocated. */
+			if( xQueueSendFromISR( xISRQueue, &pxMessage, &xHigherPriorityTaskWoken ) == pdPASS )
+			{
+				ulISRSequence++;
+			}
+			else
+			{
+				vMemPoolFreeFromISR( xISRPool, pxMessage );
+			}
+		}
+		else
+		{
+			ulISRFailures++;
+		}
+	}
+
+	/* The tick hook is called from the tick interrupt, which switches to a
+	task that was woken when it returns. */
+	( void ) xHigherPriorityTaskWoken;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	prvExhaustTest();
+	prvWaterMarkTest();
+	prvReuseTest();
+	prvISRTest();
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvExhaustTest( void )
+{
+MemPoolHandle_t xPool;
+MemPoolStats_t xStats;
+uint8_t *pucBlocks[ mainPOOL_BLOCKS ];
+const size_t xBlockSize = memPOOL_BLOCK_SIZE( sizeof( Message_t ) );
+UBaseType_t x, y;
+size_t xOffset;
+BaseType_t xClear = pdTRUE;
+
+	/* The block size is rounded up to the alignment, and a block too small
+	to link into the free list is enlarged to hold a pointer. */
+	prvCheck( ( xBlockSize % memPOOL_BLOCK_ALIGNMENT ) == 0, "block size aligned", ( unsigned long ) xBlockSize );
+	prvCheck( ( xBlockSize >= sizeof( Message_t ) ) && ( xBlockSize < ( sizeof( Message_t ) + memPOOL_BLOCK_ALIGNMENT ) ), "block size rounded up", ( unsigned long ) xBlockSize );
+	prvCheck( memPOOL_BLOCK_SIZE( 1 ) >= sizeof( void * ), "small block holds a pointer", ( unsigned long ) memPOOL_BLOCK_SIZE( 1 ) );
+
+	xPool = prvCreatePool();
+	vMemPoolGetStats( xPool, &xStats );
+	prvCheck( xStats.xBlockSize == xBlockSize, "pool block size", ( unsigned long ) xStats.xBlockSize );
+	prvCheck( xStats.uxNumberOfBlocks == mainPOOL_BLOCKS, "pool blocks", ( unsigned long ) xStats.uxNumberOfBlocks );
+	prvCheckStats( xPool, mainPOOL_BLOCKS, mainPOOL_BLOCKS, 0 );
+
+	for( x = 0; x < mainPOOL_BLOCKS; x++ )
+	{
+		pucBlocks[ x ] = ( uint8_t * ) pvMemPoolAlloc( xPool );
+
+		if( pucBlocks[ x ] == NULL )
+		{
+			prvCheck( pdFALSE, "block allocated", ( unsigned long ) x );
+			return;
+		}
+
+		/* Each block is a whole block of the buffer. */
+		xOffset = ( size_t ) ( pucBlocks[ x ] - ucPoolStorage );
+		prvCheck( ( pucBlocks[ x ] >= ucPoolStorage ) && ( ( xOffset + xBlockSize ) <= sizeof( ucPoolStorage ) ), "block inside the buffer", ( unsigned long ) x );
+		prvCheck( ( xOffset % xBlockSize ) == 0, "block on a block boundary", ( unsigned long ) xOffset );
+		prvCheck( ( ( ( size_t ) pucBlocks[ x ] ) & ( memPOOL_BLOCK_ALIGNMENT - 1U ) ) == 0, "block aligned", ( unsigned long ) x );
+		prvCheck( uxMemPoolGetFreeBlocks( xPool ) == ( mainPOOL_BLOCKS - x - 1U ), "free blocks as allocated", ( unsigned long ) uxMemPoolGetFreeBlocks( xPool ) );
+
+		/* Mark the whole block, which must not be changed by the
+		allocation of any other. */
+		memset( pucBlocks[ x ], ( int ) x, xBlockSize );
+	}
+
+	for( x = 0; x < mainFAILED_ALLOCATIONS; x++ )
+	{
+		prvCheck( pvMemPoolAlloc( xPool ) == NULL, "allocation from an empty pool", ( unsigned long ) x );
+	}
+
+	prvCheckStats( xPool, 0, 0, mainFAILED_ALLOCATIONS );
+
+	for( x = 0; x < mainPOOL_BLOCKS; x++ )
+	{
+		for( y = 0; y < xBlockSize; y++ )
+		{
+			if( pucBlocks[ x ][ y ] != ( uint8_t ) x )
+			{
+				xClear = pdFALSE;
+			}
+		}
+	}
+
+	prvCheck( xClear, "blocks clear of each other", 0 );
+
+	for( x = 0; x < mainPOOL_BLOCKS; x++ )
+	{
+		vMemPoolFree( xPool, pucBlocks[ x ] );
+	}
+
+	/* Freeing NULL has no effect. */
+	vMemPoolFree( xPool, NULL );
+	prvCheckStats( xPool, mainPOOL_BLOCKS, 0, mainFAILED_ALLOCATIONS );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWaterMarkTest( void )
+{
+MemPoolHandle_t xPool;
+void *pvBlocks[ mainPOOL_BLOCKS ];
+UBaseType_t x;
+
+	xPool = prvCreatePool();
+
+	/* Five blocks in use at once, then two. */
+	for( x = 0; x < 5; x++ )
+	{
+		pvBlocks[ x ] = pvMemPoolAlloc( xPool );
+	}
+
+	prvCheckStats( xPool, mainPOOL_BLOCKS - 5, mainPOOL_BLOCKS - 5, 0 );
+
+	for( x = 0; x < 5; x++ )
+	{
+		vMemPoolFree( xPool, pvBlocks[ x ] );
+	}
+
+	prvCheckStats( xPool, mainPOOL_BLOCKS, mainPOOL_BLOCKS - 5, 0 );
+
+	pvBlocks[ 0 ] = pvMemPoolAlloc( xPool );
+	pvBlocks[ 1 ] = pvMemPoolAlloc( xPool );
+	prvCheckStats( xPool, mainPOOL_BLOCKS - 2, mainPOOL_BLOCKS - 5, 0 );
+
+	/* Using more blocks than before lowers the mark. */
+	for( x = 2; x < 7; x++ )
+	{
+		pvBlocks[ x ] = pvMemPoolAlloc( xPool );
+	}
+
+	prvCheckStats( xPool, mainPOOL_BLOCKS - 7, mainPOOL_BLOCKS - 7, 0 );
+
+	for( x = 0; x < 7; x++ )
+	{
+		vMemPoolFree( xPool, pvBlocks[ x ] );
+	}
+
+	prvCheckStats( xPool, mainPOOL_BLOCKS, mainPOOL_BLOCKS - 7, 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvReuseTest( void )
+{
+MemPoolHandle_t xPool;
+void *pvBlocks[ 4 ];
+const size_t xBlockSize = memPOOL_BLOCK_SIZE( sizeof( Message_t ) );
+UBaseType_t x;
+
+	xPool = prvCreatePool();
+
+	/* Blocks that have never been used are handed out in address order. */
+	for( x = 0; x < 4; x++ )
+	{
+		pvBlocks[ x ] = pvMemPoolAlloc( xPool );
+		prvCheck( pvBlocks[ x ] == ( void * ) &( ucPoolStorage[ x * xBlockSize ] ), "unused blocks in order", ( unsigned long ) x );
+	}
+
+	/* Freed 1, 3, 0, the blocks come back 0, 3, 1, then the block after the
+	last used. */
+	vMemPoolFree( xPool, pvBlocks[ 1 ] );
+	vMemPoolFree( xPool, pvBlocks[ 3 ] );
+	vMemPoolFree( xPool, pvBlocks[ 0 ] );
+
+	prvCheck( pvMemPoolAlloc( xPool ) == pvBlocks[ 0 ], "last freed reused first", 0 );
+	prvCheck( pvMemPoolAlloc( xPool ) == pvBlocks[ 3 ], "second last freed reused second", 3 );
+	prvCheck( pvMemPoolAlloc( xPool ) == pvBlocks[ 1 ], "first freed reused last", 1 );
+	prvCheck( pvMemPoolAlloc( xPool ) == ( void * ) &( ucPoolStorage[ 4 * xBlockSize ] ), "unused block once none freed", 4 );
+	prvCheckStats( xPool, mainPOOL_BLOCKS - 5, mainPOOL_BLOCKS - 5, 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvISRTest( void )
+{
+Message_t *pxMessage;
+uint32_t ulExpected = 0, ulWrongData = 0, ulOutOfOrder = 0, ulReceived = 0;
+UBaseType_t x;
+BaseType_t xPhase;
+
+	xISRPool = prvCreatePool();
+	xISRQueue = xQueueCreate( mainPOOL_BLOCKS, sizeof( Message_t * ) );
+	configASSERT( xISRQueue );
+
+	ulISRSequence = 0;
+	ulISRFailures = 0;
+	xISRSending = pdTRUE;
+
+	/* Receive promptly, then stop receiving until the pool is dry, then
+	receive what was queued while the tick hook carries on sending. */
+	for( xPhase = 0; xPhase < 2; xPhase++ )
+	{
+		while( ulReceived < ( mainISR_MESSAGES * ( uint32_t ) ( xPhase + 1 ) ) )
+		{
+			if( xQueueReceive( xISRQueue, &pxMessage, mainMAX_WAIT ) != pdPASS )
+			{
+				prvCheck( pdFALSE, "message received", ulReceived );
+				break;
+			}
+
+			if( pxMessage->ulSequence != ulExpected )
+			{
+				ulOutOfOrder++;
+			}
+
+			for( x = 0; x < sizeof( pxMessage->ucData ); x++ )
+			{
+				if( pxMessage->ucData[ x ] != ( uint8_t ) ( pxMessage->ulSequence & 0xffUL ) )
+				{
+					ulWrongData++;
+				}
+			}
+
+			ulExpected = pxMessage->ulSequence + 1UL;
+			ulReceived++;
+			vMemPoolFree( xISRPool, pxMessage );
+		}
+
+		if( xPhase == 0 )
+		{
+			vTaskDelay( mainISR_STALL_TICKS );
+			prvCheck( uxMemPoolGetFreeBlocks( xISRPool ) == 0, "pool run dry by the tick hook", ( unsigned long ) uxMemPoolGetFreeBlocks( xISRPool ) );
+		}
+	}
+
+	/* Stop the tick hook and return what it has queued since. */
+	xISRSending = pdFALSE;
+
+	while( xQueueReceive( xISRQueue, &pxMessage, 0 ) == pdPASS )
+	{
+		vMemPoolFree( xISRPool, pxMessage );
+	}
+
+	/* The sequence numbers are only given to messages that were sent, so
+	the failures leave no gaps, and the messages are checked in order. */
+	prvCheck( ulOutOfOrder == 0, "messages in order", ulOutOfOrder );
+	prvCheck( ulWrongData == 0, "message data", ulWrongData );
+	prvCheck( ulISRFailures > 0, "allocations failed in the tick hook", ulISRFailures );
+	prvCheckStats( xISRPool, mainPOOL_BLOCKS, 0, ulISRFailures );
+
+	vQueueDelete( xISRQueue );
+}
+/*-----------------------------------------------------------*/
+
+static MemPoolHandle_t prvCreatePool( void )
+{
+MemPoolHandle_t xPool;
+
+	memset( ucPoolStorage, 0xa5, sizeof( ucPoolStorage ) );
+	xPool = xMemPoolCreateStatic( sizeof( Message_t ), mainPOOL_BLOCKS, ucPoolStorage, &xPoolStruct );
+	prvCheck( xPool != NULL, "pool created", 0 );
+	configASSERT( xPool );
+
+	return xPool;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckStats( MemPoolHandle_t xPool, UBaseType_t uxFree, UBaseType_t uxMinimumEverFree, UBaseType_t uxFailed )
+{
+MemPoolStats_t xStats;
+
+	vMemPoolGetStats( xPool, &xStats );
+	prvCheck( xStats.uxFreeBlocks == uxFree, "free blocks", ( unsigned long ) xStats.uxFreeBlocks );
+	prvCheck( uxMemPoolGetFreeBlocks( xPool ) == uxFree, "uxMemPoolGetFreeBlocks", ( unsigned long ) uxMemPoolGetFreeBlocks( xPool ) );
+	prvCheck( xStats.uxMinimumEverFreeBlocks == uxMinimumEverFree, "minimum ever free blocks", ( unsigned long ) xStats.uxMinimumEverFreeBlocks );
+	prvCheck( xStats.uxNumberOfFailedAllocations == uxFailed, "failed allocations", ( unsigned long ) xStats.uxNumberOfFailedAllocations );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		printf( "Failed %s (%lu)\n", pcCheck, ulValue );
+		xFailed = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
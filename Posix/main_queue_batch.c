@@ -0,0 +1,630 @@
+/*
+	Tests sending and receiving batches of items with xQueueSendMultiple(),
+	xQueueReceiveMultiple() and their FromISR versions on the host build.
+
+	+ The partial test sends batches to a queue with room for only some of
+	  their items, which must be sent in order with the count returned, and
+	  receives from a queue holding fewer items than asked for.
+
+	+ The wrap test sends and receives batches of every size from every
+	  position in the queue, so the copies that wrap around the end of its
+	  storage are made at each offset, mixed with single items sent and
+	  received.
+
+	+ The waiters test sends one batch to a queue several tasks are waiting to
+	  receive from, from a task and from the tick hook, and each task must be
+	  unblocked.  Receiving one batch from a full queue must likewise unblock
+	  each of the tasks waiting to send to it.
+
+	+ The lock test calls the FromISR functions from vQueueBlockingHook(),
+	  while the queue is locked by a task that is blocking on it.  The items
+	  sent or received there are added to the lock count of the queue, and
+	  the task that unlocks it must then unblock a task for each item, even
+	  when there are more items than the lock count can hold.
+
+	The program ends the scheduler once the tests have run, and exits with 0 if
+	every check passed, or 1 after naming those that failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/* The priority of the task that runs the tests, and of the tasks that wait on
+the queues, which run as soon as they are unblocked. */
+#define mainTEST_TASK_PRIORITY			( tskIDLE_PRIORITY + 2 )
+#define mainWAITER_PRIORITY				( tskIDLE_PRIORITY + 3 )
+
+/* The length of the queue of the partial test. */
+#define mainPARTIAL_LENGTH				( 8 )
+
+/* The length of the queue of the wrap test, and the batches it sends. */
+#define mainWRAP_LENGTH					( 7 )
+#define mainWRAP_BATCHES				( mainWRAP_LENGTH * mainWRAP_LENGTH * 4 )
+
+/* The tasks that wait on the queues of the waiters and lock tests, and the
+first item the sender tasks send. */
+#define mainWAITERS						( 3 )
+#define mainSENDER_ITEMS				( 1000UL )
+
+/* The items sent from vQueueBlockingHook() to saturate the lock count, which
+is more than an int8_t holds. */
+#define mainSATURATING_ITEMS			( 150 )
+
+/* The longest a test waits for something that should happen. */
+#define mainMAX_WAIT					( pdMS_TO_TICKS( 100 ) )
+
+/* The ticks a task is blocked for when a send or receive should time out. */
+#define mainBLOCK_TIME					( 5 )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Runs the tests.
+ */
+static void prvTestTask( void *pvParameters );
+
+/*
+ * The tests.
+ */
+static void prvPartialTest( void );
+static void prvWrapTest( void );
+static void prvWaitersTest( void );
+static void prvLockTest( void );
+
+/*
+ * The tasks that wait to receive an item from xWaitQueue, or to send one to
+ * xFullQueue, then wait to be notified before they wait on the queue again,
+ * so each passes one item in each round of a test.
+ */
+static void prvReceiverTask( void *pvParameters );
+static void prvSenderTask( void *pvParameters );
+
+/*
+ * Creates the receiver or sender tasks, starts their next round, and deletes
+ * them again.
+ */
+static void prvCreateWaiters( TaskFunction_t pxTask );
+static void prvNextRound( void );
+static void prvDeleteWaiters( void );
+
+/*
+ * Checks each receiver or sender task passed one item in the round, and that
+ * the receiver tasks received those summing to ulSum.
+ */
+static void prvCheckWaiters( const char *pcCheck );
+static void prvCheckReceivedSum( uint32_t ulSum, const char *pcCheck );
+
+/*
+ * Checks the xCount items in pulItems follow on from *pulExpected, and
+ * updates *pulExpected to the item after them.
+ */
+static void prvCheckSequence( const uint32_t *pulItems, BaseType_t xCount, uint32_t *pulExpected, const char *pcCheck );
+
+/*
+ * Returns the sum of the items from 0 to ulCount - 1.
+ */
+static uint32_t prvSumOfItems( uint32_t ulCount );
+
+/*
+ * The actions vQueueBlockingHook() can take, as an interrupt that finds the
+ * queue locked.
+ */
+static void prvSendBatchFromISR( QueueHandle_t xQueue );
+static void prvReceiveBatchFromISR( QueueHandle_t xQueue );
+
+/*
+ * Records a failed check.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* The queues the receiver and sender tasks wait on, and the tasks. */
+static QueueHandle_t xWaitQueue = NULL, xFullQueue = NULL;
+static TaskHandle_t xWaiters[ mainWAITERS ];
+
+/* The items passed by each receiver or sender task in the round, and the sum
+of those received. */
+static volatile uint32_t ulWaiterItems[ mainWAITERS ];
+static volatile uint32_t ulReceivedSum = 0;
+
+/* The tick hook sends mainWAITERS items to xWaitQueue when xTickHookSends is
+pdTRUE, and records the number sent. */
+static volatile BaseType_t xTickHookSends = pdFALSE, xTickHookSent = 0;
+
+/* What vQueueBlockingHook() does the next time a task blocks on
+xBlockingHookQueue, the items it sends or receives, and the number it did. */
+static QueueHandle_t xBlockingHookQueue = NULL;
+static void ( * volatile pxBlockingHookAction )( QueueHandle_t xQueue ) = NULL;
+static UBaseType_t uxBlockingHookItems = 0;
+static BaseType_t xBlockingHookResult = 0;
+
+/* The items 0, 1, 2 and so on, a buffer they are received into, and one for
+the items vQueueBlockingHook() receives. */
+static uint32_t ulItems[ mainSATURATING_ITEMS ], ulBuffer[ mainSATURATING_ITEMS ], ulHookBuffer[ mainSATURATING_ITEMS ];
+
+/* Whether any check failed. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE * 2, NULL, mainTEST_TASK_PRIORITY, NULL );
+
+	vTaskStartScheduler();
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All queue batch tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationTickHook( void )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	if( xTickHookSends != pdFALSE )
+	{
+		xTickHookSends = pdFALSE;
+		xTickHookSent = xQueueSendMultipleFromISR( xWaitQueue, ulItems, mainWAITERS, &xHigherPriorityTaskWoken );
+	}
+
+	/* The tick interrupt switches to a task that was woken when it returns. */
+	( void ) xHigherPriorityTaskWoken;
+}
+/*-----------------------------------------------------------*/
+
+void vQueueBlockingHook( void *pvQueue )
+{
+void ( *pxAction )( QueueHandle_t xQueue ) = pxBlockingHookAction;
+
+	/* Only the first task to block on the queue once the action is set takes
+	it. */
+	if( ( pvQueue == ( void * ) xBlockingHookQueue ) && ( pxAction != NULL ) )
+	{
+		pxBlockingHookAction = NULL;
+		pxAction( xBlockingHookQueue );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+UBaseType_t x;
+
+	( void ) pvParameters;
+
+	for( x = 0; x < mainSATURATING_ITEMS; x++ )
+	{
+		ulItems[ x ] = ( uint32_t ) x;
+	}
+
+	prvPartialTest();
+	prvWrapTest();
+	prvWaitersTest();
+	prvLockTest();
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvPartialTest( void )
+{
+QueueHandle_t xQueue;
+BaseType_t xCount;
+uint32_t ulExpected = 0;
+TickType_t xStart;
+
+	xQueue = xQueueCreate( mainPARTIAL_LENGTH, sizeof( uint32_t ) );
+	configASSERT( xQueue );
+
+	/* An empty queue gives nothing, at once or once the block time ends. */
+	prvCheck( xQueueReceiveMultiple( xQueue, ulBuffer, mainPARTIAL_LENGTH, 0 ) == 0, "batch received from an empty queue", 0 );
+	prvCheck( xQueueReceiveMultipleFromISR( xQueue, ulBuffer, mainPARTIAL_LENGTH, NULL ) == 0, "batch received from an empty queue from an ISR", 0 );
+	xStart = xTaskGetTickCount();
+	prvCheck( xQueueReceiveMultiple( xQueue, ulBuffer, mainPARTIAL_LENGTH, mainBLOCK_TIME ) == 0, "batch received from a queue left empty", 0 );
+	prvCheck( ( xTaskGetTickCount() - xStart ) >= mainBLOCK_TIME, "blocked on an empty queue", ( unsigned long ) ( xTaskGetTickCount() - xStart ) );
+
+	/* Two of a batch of five fit behind six items. */
+	prvCheck( xQueueSendMultiple( xQueue, &( ulItems[ 0 ] ), 6, 0 ) == 6, "batch sent to an empty queue", 6 );
+	prvCheck( xQueueSendMultiple( xQueue, &( ulItems[ 6 ] ), 5, 0 ) == 2, "batch sent to a nearly full queue", 2 );
+	prvCheck( uxQueueMessagesWaiting( xQueue ) == mainPARTIAL_LENGTH, "queue filled", ( unsigned long ) uxQueueMessagesWaiting( xQueue ) );
+
+	/* A full queue takes nothing, at once or once the block time ends. */
+	prvCheck( xQueueSendMultiple( xQueue, &( ulItems[ 8 ] ), 3, 0 ) == 0, "batch sent to a full queue", 0 );
+	prvCheck( xQueueSendMultipleFromISR( xQueue, &( ulItems[ 8 ] ), 3, NULL ) == 0, "batch sent to a full queue from an ISR", 0 );
+	xStart = xTaskGetTickCount();
+	prvCheck( xQueueSendMultiple( xQueue, &( ulItems[ 8 ] ), 3, mainBLOCK_TIME ) == 0, "batch sent to a queue left full", 0 );
+	prvCheck( ( xTaskGetTickCount() - xStart ) >= mainBLOCK_TIME, "blocked on a full queue", ( unsigned long ) ( xTaskGetTickCount() - xStart ) );
+
+	/* Three received make room for three of a batch of five sent from an
+	ISR, and whatever is left is received when more is asked for. */
+	xCount = xQueueReceiveMultiple( xQueue, ulBuffer, 3, 0 );
+	prvCheck( xCount == 3, "part of a queue received", ( unsigned long ) xCount );
+	prvCheckSequence( ulBuffer, xCount, &ulExpected, "items received from part of a queue" );
+	prvCheck( xQueueSendMultipleFromISR( xQueue, &( ulItems[ 8 ] ), 5, NULL ) == 3, "batch sent to a nearly full queue from an ISR", 3 );
+
+	xCount = xQueueReceiveMultipleFromISR( xQueue, ulBuffer, 2, NULL );
+	prvCheck( xCount == 2, "part of a queue received from an ISR", ( unsigned long ) xCount );
+	prvCheckSequence( ulBuffer, xCount, &ulExpected, "items received from part of a queue from an ISR" );
+
+	xCount = xQueueReceiveMultiple( xQueue, ulBuffer, mainPARTIAL_LENGTH * 2, 0 );
+	prvCheck( xCount == ( mainPARTIAL_LENGTH - 2 ), "rest of a queue received", ( unsigned long ) xCount );
+	prvCheckSequence( ulBuffer, xCount, &ulExpected, "items received from the rest of a queue" );
+	prvCheck( ulExpected == 11UL, "items received", ulExpected );
+
+	vQueueDelete( xQueue );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWrapTest( void )
+{
+QueueHandle_t xQueue;
+uint32_t ulBatch[ mainWRAP_LENGTH ], ulNextToSend = 0, ulExpected = 0, ulPeeked;
+UBaseType_t uxBatch, uxSize, uxWaiting, uxWanted, x;
+BaseType_t xCount;
+
+	xQueue = xQueueCreate( mainWRAP_LENGTH, sizeof( uint32_t ) );
+	configASSERT( xQueue );
+
+	for( uxBatch = 0; uxBatch < mainWRAP_BATCHES; uxBatch++ )
+	{
+		/* Send each size of batch in turn, with the sizes received a
+		different sequence, so the batches start at each position. */
+		uxSize = ( uxBatch % mainWRAP_LENGTH ) + 1U;
+		uxWaiting = uxQueueMessagesWaiting( xQueue );
+		uxWanted = ( uxSize < ( mainWRAP_LENGTH - uxWaiting ) ) ? uxSize : ( mainWRAP_LENGTH - uxWaiting );
+
+		for( x = 0; x < uxSize; x++ )
+		{
+			ulBatch[ x ] = ulNextToSend + ( uint32_t ) x;
+		}
+
+		if( ( uxBatch % 5U ) == 4U )
+		{
+			xCount = ( xQueueSend( xQueue, ulBatch, 0 ) == pdPASS ) ? 1 : 0;
+			uxWanted = ( uxWanted > 0U ) ? 1U : 0U;
+		}
+		else if( ( uxBatch & 1U ) == 0U )
+		{
+			xCount = xQueueSendMultiple( xQueue, ulBatch, uxSize, 0 );
+		}
+		else
+		{
+			xCount = xQueueSendMultipleFromISR( xQueue, ulBatch, uxSize, NULL );
+		}
+
+		prvCheck( xCount == ( BaseType_t ) uxWanted, "wrapped batch sent", ( unsigned long ) uxBatch );
+		ulNextToSend += ( uint32_t ) xCount;
+
+		/* The oldest item is still the next to be received. */
+		if( xQueuePeek( xQueue, &ulPeeked, 0 ) == pdPASS )
+		{
+			prvCheck( ulPeeked == ulExpected, "item peeked after a wrapped batch", ( unsigned long ) uxBatch );
+		}
+
+		uxSize = ( ( uxBatch * 3U ) % mainWRAP_LENGTH ) + 1U;
+		uxWaiting = uxQueueMessagesWaiting( xQueue );
+		uxWanted = ( uxSize < uxWaiting ) ? uxSize : uxWaiting;
+
+		if( ( uxBatch % 7U ) == 6U )
+		{
+			xCount = ( xQueueReceive( xQueue, ulBuffer, 0 ) == pdPASS ) ? 1 : 0;
+			uxWanted = ( uxWanted > 0U ) ? 1U : 0U;
+		}
+		else if( ( uxBatch & 2U ) == 0U )
+		{
+			xCount = xQueueReceiveMultiple( xQueue, ulBuffer, uxSize, 0 );
+		}
+		else
+		{
+			xCount = xQueueReceiveMultipleFromISR( xQueue, ulBuffer, uxSize, NULL );
+		}
+
+		prvCheck( xCount == ( BaseType_t ) uxWanted, "wrapped batch received", ( unsigned long ) uxBatch );
+		prvCheckSequence( ulBuffer, xCount, &ulExpected, "items received in a wrapped batch" );
+	}
+
+	xCount = xQueueReceiveMultiple( xQueue, ulBuffer, mainWRAP_LENGTH, 0 );
+	prvCheckSequence( ulBuffer, xCount, &ulExpected, "items left after the wrapped batches" );
+	prvCheck( ulExpected == ulNextToSend, "wrapped items received", ulExpected );
+	prvCheck( ulExpected > ( mainWRAP_BATCHES * 2UL ), "wrapped items sent", ulNextToSend );
+
+	vQueueDelete( xQueue );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWaitersTest( void )
+{
+BaseType_t xCount, xHigherPriorityTaskWoken = pdFALSE;
+uint32_t ulSum = 0;
+UBaseType_t x;
+
+	/* A batch sent from a task unblocks each of the tasks waiting for it,
+	which take an item each. */
+	xWaitQueue = xQueueCreate( mainWAITERS, sizeof( uint32_t ) );
+	configASSERT( xWaitQueue );
+	prvCreateWaiters( prvReceiverTask );
+
+	xCount = xQueueSendMultiple( xWaitQueue, ulItems, mainWAITERS, 0 );
+	prvCheck( xCount == mainWAITERS, "batch sent to waiting tasks", ( unsigned long ) xCount );
+	prvCheckWaiters( "waiting task received from a batch" );
+	prvCheckReceivedSum( prvSumOfItems( mainWAITERS ), "items received from a batch" );
+
+	/* Likewise a batch sent from the tick hook. */
+	prvNextRound();
+	xTickHookSends = pdTRUE;
+	vTaskDelay( mainBLOCK_TIME );
+	prvCheck( xTickHookSent == mainWAITERS, "batch sent to waiting tasks from the tick hook", ( unsigned long ) xTickHookSent );
+	prvCheckWaiters( "waiting task received from a batch sent from the tick hook" );
+	prvCheckReceivedSum( prvSumOfItems( mainWAITERS ), "items received from a batch sent from the tick hook" );
+
+	prvDeleteWaiters();
+	vQueueDelete( xWaitQueue );
+
+	/* A batch received from a full queue unblocks each of the tasks waiting
+	to send to it, which fill it again. */
+	xFullQueue = xQueueCreate( mainWAITERS, sizeof( uint32_t ) );
+	configASSERT( xFullQueue );
+	xQueueSendMultiple( xFullQueue, ulItems, mainWAITERS, 0 );
+	prvCreateWaiters( prvSenderTask );
+
+	xCount = xQueueReceiveMultiple( xFullQueue, ulBuffer, mainWAITERS, 0 );
+	prvCheck( xCount == mainWAITERS, "batch received from waiting tasks", ( unsigned long ) xCount );
+	prvCheckWaiters( "waiting task sent after a batch was received" );
+
+	/* Likewise a batch received from an ISR, once the queue is drained and
+	filled again for the next round. */
+	xCount = xQueueReceiveMultiple( xFullQueue, ulBuffer, mainWAITERS, 0 );
+
+	for( x = 0; x < ( UBaseType_t ) xCount; x++ )
+	{
+		ulSum += ulBuffer[ x ];
+	}
+
+	prvCheck( ulSum == ( ( mainSENDER_ITEMS * mainWAITERS ) + prvSumOfItems( mainWAITERS ) ), "items sent by waiting tasks", ulSum );
+
+	xQueueSendMultiple( xFullQueue, ulItems, mainWAITERS, 0 );
+	prvNextRound();
+	xCount = xQueueReceiveMultipleFromISR( xFullQueue, ulBuffer, mainWAITERS, &xHigherPriorityTaskWoken );
+	prvCheck( xCount == mainWAITERS, "batch received from waiting tasks from an ISR", ( unsigned long ) xCount );
+	prvCheck( xHigherPriorityTaskWoken == pdTRUE, "waiting task woken from an ISR", 0 );
+	taskYIELD();
+	prvCheckWaiters( "waiting task sent after a batch was received from an ISR" );
+	prvCheck( uxQueueMessagesWaiting( xFullQueue ) == mainWAITERS, "queue filled by waiting tasks", ( unsigned long ) uxQueueMessagesWaiting( xFullQueue ) );
+
+	prvDeleteWaiters();
+	vQueueDelete( xFullQueue );
+}
+/*-----------------------------------------------------------*/
+
+static void prvLockTest( void )
+{
+BaseType_t xCount;
+TickType_t xStart;
+
+	/* A batch sent while this task is blocking on the queue adds to the lock
+	count, and this task and each receiver task are unblocked when it is
+	unlocked. */
+	xWaitQueue = xQueueCreate( mainWAITERS + 1, sizeof( uint32_t ) );
+	configASSERT( xWaitQueue );
+	prvCreateWaiters( prvReceiverTask );
+
+	xBlockingHookQueue = xWaitQueue;
+	uxBlockingHookItems = mainWAITERS + 1;
+	pxBlockingHookAction = prvSendBatchFromISR;
+	xStart = xTaskGetTickCount();
+	xCount = xQueueReceiveMultiple( xWaitQueue, ulBuffer, 1, mainMAX_WAIT );
+	prvCheck( xBlockingHookResult == ( mainWAITERS + 1 ), "batch sent to a locked queue", ( unsigned long ) xBlockingHookResult );
+	prvCheck( xCount == 1, "item received once a locked queue was unlocked", ( unsigned long ) xCount );
+	prvCheck( ( xTaskGetTickCount() - xStart ) < mainMAX_WAIT, "unblocked once a locked queue was unlocked", ( unsigned long ) ( xTaskGetTickCount() - xStart ) );
+	prvCheckWaiters( "waiting task received once a locked queue was unlocked" );
+	prvCheckReceivedSum( prvSumOfItems( mainWAITERS + 1 ) - ulBuffer[ 0 ], "items received once a locked queue was unlocked" );
+
+	prvDeleteWaiters();
+	vQueueDelete( xWaitQueue );
+
+	/* So many items sent while the queue is locked that the lock count
+	saturates still unblocks every task. */
+	xWaitQueue = xQueueCreate( mainSATURATING_ITEMS, sizeof( uint32_t ) );
+	configASSERT( xWaitQueue );
+	prvCreateWaiters( prvReceiverTask );
+
+	xBlockingHookQueue = xWaitQueue;
+	uxBlockingHookItems = mainSATURATING_ITEMS;
+	pxBlockingHookAction = prvSendBatchFromISR;
+	xStart = xTaskGetTickCount();
+	xCount = xQueueReceiveMultiple( xWaitQueue, ulBuffer, 1, mainMAX_WAIT );
+	prvCheck( xBlockingHookResult == mainSATURATING_ITEMS, "batch sent to a locked queue to saturate it", ( unsigned long ) xBlockingHookResult );
+	prvCheck( xCount == 1, "item received once a saturated queue was unlocked", ( unsigned long ) xCount );
+	prvCheck( ( xTaskGetTickCount() - xStart ) < mainMAX_WAIT, "unblocked once a saturated queue was unlocked", ( unsigned long ) ( xTaskGetTickCount() - xStart ) );
+	prvCheckWaiters( "waiting task received once a saturated queue was unlocked" );
+	prvCheck( uxQueueMessagesWaiting( xWaitQueue ) == ( mainSATURATING_ITEMS - mainWAITERS - 1 ), "items left in a saturated queue", ( unsigned long ) uxQueueMessagesWaiting( xWaitQueue ) );
+
+	prvDeleteWaiters();
+	vQueueDelete( xWaitQueue );
+
+	/* A batch received while this task is blocking on a full queue adds to
+	the other lock count, and this task and each sender task are unblocked
+	when it is unlocked. */
+	xFullQueue = xQueueCreate( mainWAITERS + 1, sizeof( uint32_t ) );
+	configASSERT( xFullQueue );
+	xQueueSendMultiple( xFullQueue, ulItems, mainWAITERS + 1, 0 );
+	prvCreateWaiters( prvSenderTask );
+
+	xBlockingHookQueue = xFullQueue;
+	uxBlockingHookItems = mainWAITERS + 1;
+	pxBlockingHookAction = prvReceiveBatchFromISR;
+	xStart = xTaskGetTickCount();
+	xCount = xQueueSendMultiple( xFullQueue, ulItems, 1, mainMAX_WAIT );
+	prvCheck( xBlockingHookResult == ( mainWAITERS + 1 ), "batch received from a locked queue", ( unsigned long ) xBlockingHookResult );
+	prvCheck( xCount == 1, "item sent once a locked queue was unlocked", ( unsigned long ) xCount );
+	prvCheck( ( xTaskGetTickCount() - xStart ) < mainMAX_WAIT, "unblocked once a locked full queue was unlocked", ( unsigned long ) ( xTaskGetTickCount() - xStart ) );
+	prvCheckWaiters( "waiting task sent once a locked queue was unlocked" );
+	prvCheck( uxQueueMessagesWaiting( xFullQueue ) == ( mainWAITERS + 1 ), "locked queue filled again", ( unsigned long ) uxQueueMessagesWaiting( xFullQueue ) );
+
+	prvDeleteWaiters();
+	vQueueDelete( xFullQueue );
+}
+/*-----------------------------------------------------------*/
+
+static void prvReceiverTask( void *pvParameters )
+{
+const UBaseType_t uxIndex = ( UBaseType_t ) pvParameters;
+uint32_t ulItem;
+
+	for( ;; )
+	{
+		if( xQueueReceive( xWaitQueue, &ulItem, portMAX_DELAY ) == pdPASS )
+		{
+			ulReceivedSum += ulItem;
+			ulWaiterItems[ uxIndex ]++;
+		}
+
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSenderTask( void *pvParameters )
+{
+const UBaseType_t uxIndex = ( UBaseType_t ) pvParameters;
+const uint32_t ulItem = mainSENDER_ITEMS + ( uint32_t ) uxIndex;
+
+	for( ;; )
+	{
+		if( xQueueSend( xFullQueue, &ulItem, portMAX_DELAY ) == pdPASS )
+		{
+			ulWaiterItems[ uxIndex ]++;
+		}
+
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCreateWaiters( TaskFunction_t pxTask )
+{
+UBaseType_t x;
+
+	ulReceivedSum = 0;
+
+	/* The tasks run above this one, so each is waiting on its queue once it
+	has been created. */
+	for( x = 0; x < mainWAITERS; x++ )
+	{
+		ulWaiterItems[ x ] = 0;
+		xTaskCreate( pxTask, "Waiter", configMINIMAL_STACK_SIZE, ( void * ) x, mainWAITER_PRIORITY, &( xWaiters[ x ] ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvNextRound( void )
+{
+UBaseType_t x;
+
+	ulReceivedSum = 0;
+
+	for( x = 0; x < mainWAITERS; x++ )
+	{
+		ulWaiterItems[ x ] = 0;
+		xTaskNotifyGive( xWaiters[ x ] );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvDeleteWaiters( void )
+{
+UBaseType_t x;
+
+	for( x = 0; x < mainWAITERS; x++ )
+	{
+		vTaskDelete( xWaiters[ x ] );
+	}
+
+	/* Let the idle task free the tasks. */
+	vTaskDelay( 1 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckWaiters( const char *pcCheck )
+{
+UBaseType_t x;
+
+	for( x = 0; x < mainWAITERS; x++ )
+	{
+		prvCheck( ulWaiterItems[ x ] == 1UL, pcCheck, ( unsigned long ) x );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckReceivedSum( uint32_t ulSum, const char *pcCheck )
+{
+	prvCheck( ulReceivedSum == ulSum, pcCheck, ( unsigned long ) ulReceivedSum );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckSequence( const uint32_t *pulItems, BaseType_t xCount, uint32_t *pulExpected, const char *pcCheck )
+{
+BaseType_t x;
+unsigned long ulWrong = 0;
+
+	for( x = 0; x < xCount; x++ )
+	{
+		if( pulItems[ x ] != *pulExpected )
+		{
+			ulWrong++;
+		}
+
+		*pulExpected = pulItems[ x ] + 1UL;
+	}
+
+	prvCheck( ulWrong == 0, pcCheck, ulWrong );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSumOfItems( uint32_t ulCount )
+{
+	return ( ulCount * ( ulCount - 1UL ) ) / 2UL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendBatchFromISR( QueueHandle_t xQueue )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	xBlockingHookResult = xQueueSendMultipleFromISR( xQueue, ulItems, uxBlockingHookItems, &xHigherPriorityTaskWoken );
+
+	/* No task is woken while the queue is locked. */
+	prvCheck( xHigherPriorityTaskWoken == pdFALSE, "task woken by a batch sent to a locked queue", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvReceiveBatchFromISR( QueueHandle_t xQueue )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	xBlockingHookResult = xQueueReceiveMultipleFromISR( xQueue, ulHookBuffer, uxBlockingHookItems, &xHigherPriorityTaskWoken );
+	prvCheck( xHigherPriorityTaskWoken == pdFALSE, "task woken by a batch received from a locked queue", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		printf( "Failed %s (%lu)\n", pcCheck, ulValue );
+		xFailed = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,326 @@
+/*
+	Tests the zero copy queue functions, which write and read items in the
+	storage of the queue, on the host build.
+
+	+ The blocking test acquires a slot on a full queue and borrows one from an
+	  empty queue, each of which must fail once its block time has passed,
+	  then borrows from an empty queue that a task of higher priority commits
+	  an item to while the borrow is blocked.
+
+	+ The release test releases a borrowed slot of a full queue that a task
+	  of higher priority is blocked acquiring a slot of, and the task must be
+	  unblocked to write its item in the storage just released.
+
+	+ The lock test acquires and commits slots from vQueueBlockingHook(),
+	  with the FromISR functions, while the queue is locked by this task as it
+	  blocks to borrow from it.  The commit adds to the lock count of the
+	  queue, and this task must be unblocked when the queue is unlocked.
+
+	Items are also sent and received with the copying functions between the
+	tests, which must see the same items as the zero copy functions.
+
+	The program ends the scheduler once the tests have run, and exits with 0 if
+	every check passed, or 1 after naming those that failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/* The priority of the task that runs the tests, and of the task that commits
+items while the tests are blocked, which runs as soon as it is unblocked. */
+#define mainTEST_TASK_PRIORITY			( tskIDLE_PRIORITY + 2 )
+#define mainPRODUCER_PRIORITY			( tskIDLE_PRIORITY + 3 )
+
+/* The length of the queue. */
+#define mainQUEUE_LENGTH				( 2 )
+
+/* The item the producer task commits, and the first of those committed from
+vQueueBlockingHook(). */
+#define mainPRODUCER_ITEM				( 0x50524F44UL )
+#define mainISR_ITEM					( 0x49535200UL )
+
+/* The slots vQueueBlockingHook() acquires and commits in the lock test. */
+#define mainISR_SLOTS					( 2 )
+
+/* The longest a test waits for something that should happen. */
+#define mainMAX_WAIT					( pdMS_TO_TICKS( 100 ) )
+
+/* The ticks a task is blocked for when an acquire or borrow should time out,
+and the producer task waits before committing its item. */
+#define mainBLOCK_TIME					( 5 )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Runs the tests.
+ */
+static void prvTestTask( void *pvParameters );
+
+/*
+ * The tests.
+ */
+static void prvBlockingTest( void );
+static void prvReleaseTest( void );
+static void prvLockTest( void );
+
+/*
+ * Waits the ticks given by its parameter, then acquires a slot of xQueue,
+ * blocking if the queue is full, and commits mainPRODUCER_ITEM to it before
+ * deleting itself.
+ */
+static void prvProducerTask( void *pvParameters );
+
+/*
+ * Acquires a slot, writes ulItem to it and commits it, from this task.
+ */
+static void prvSendItem( uint32_t ulItem );
+
+/*
+ * Borrows the item at the front of the queue, checks it is ulItem and
+ * releases it.
+ */
+static void prvReceiveItem( uint32_t ulItem, const char *pcCheck );
+
+/*
+ * Acquires mainISR_SLOTS slots of the locked queue and commits them, as an
+ * interrupt.
+ */
+static void prvCommitFromISR( QueueHandle_t xQueue );
+
+/*
+ * Records a failed check.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* The queue the tests use. */
+static QueueHandle_t xQueue = NULL;
+
+/* The slot the producer task acquired, and whether it committed its item. */
+static uint32_t * volatile pulProducerSlot = NULL;
+static volatile BaseType_t xProducerCommitted = pdFALSE;
+
+/* Whether vQueueBlockingHook() commits slots the next time a task blocks on
+xQueue, and the slots it committed. */
+static volatile BaseType_t xHookCommits = pdFALSE;
+static volatile UBaseType_t uxHookCommitted = 0;
+
+/* Whether any check failed. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE * 2, NULL, mainTEST_TASK_PRIORITY, NULL );
+
+	vTaskStartScheduler();
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All zero copy queue tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+void vQueueBlockingHook( void *pvQueue )
+{
+	if( ( pvQueue == ( void * ) xQueue ) && ( xHookCommits != pdFALSE ) )
+	{
+		xHookCommits = pdFALSE;
+		prvCommitFromISR( xQueue );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	xQueue = xQueueCreate( mainQUEUE_LENGTH, sizeof( uint32_t ) );
+	configASSERT( xQueue );
+
+	prvBlockingTest();
+	prvReleaseTest();
+	prvLockTest();
+
+	vQueueDelete( xQueue );
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvBlockingTest( void )
+{
+void *pvSlot;
+uint32_t ulItem;
+TickType_t xStart;
+
+	/* An acquire on a full queue fails once its block time has passed. */
+	prvSendItem( 1 );
+	prvSendItem( 2 );
+	xStart = xTaskGetTickCount();
+	prvCheck( xQueueAcquireSlot( xQueue, &pvSlot, mainBLOCK_TIME ) == errQUEUE_FULL, "slot acquired on a full queue", 0 );
+	prvCheck( ( xTaskGetTickCount() - xStart ) >= mainBLOCK_TIME, "blocked acquiring a slot on a full queue", ( unsigned long ) ( xTaskGetTickCount() - xStart ) );
+	prvCheck( xQueueAcquireSlotFromISR( xQueue, &pvSlot ) == errQUEUE_FULL, "slot acquired on a full queue from an ISR", 0 );
+
+	/* The items committed are received by the copying functions. */
+	prvCheck( ( xQueueReceive( xQueue, &ulItem, 0 ) == pdPASS ) && ( ulItem == 1UL ), "committed item received", ( unsigned long ) ulItem );
+	prvCheck( ( xQueueReceive( xQueue, &ulItem, 0 ) == pdPASS ) && ( ulItem == 2UL ), "second committed item received", ( unsigned long ) ulItem );
+
+	/* A borrow from an empty queue fails once its block time has passed. */
+	xStart = xTaskGetTickCount();
+	prvCheck( xQueueBorrowSlot( xQueue, &pvSlot, mainBLOCK_TIME ) == errQUEUE_EMPTY, "slot borrowed from an empty queue", 0 );
+	prvCheck( ( xTaskGetTickCount() - xStart ) >= mainBLOCK_TIME, "blocked borrowing a slot from an empty queue", ( unsigned long ) ( xTaskGetTickCount() - xStart ) );
+
+	/* A borrow blocked on an empty queue is unblocked by an item committed to
+	it. */
+	xProducerCommitted = pdFALSE;
+	xTaskCreate( prvProducerTask, "Producer", configMINIMAL_STACK_SIZE, ( void * ) mainBLOCK_TIME, mainPRODUCER_PRIORITY, NULL );
+	xStart = xTaskGetTickCount();
+	prvCheck( xQueueBorrowSlot( xQueue, &pvSlot, mainMAX_WAIT ) == pdPASS, "slot borrowed once an item was committed", 0 );
+	prvCheck( ( xTaskGetTickCount() - xStart ) >= mainBLOCK_TIME, "blocked until an item was committed", ( unsigned long ) ( xTaskGetTickCount() - xStart ) );
+	prvCheck( ( xTaskGetTickCount() - xStart ) < mainMAX_WAIT, "unblocked once an item was committed", ( unsigned long ) ( xTaskGetTickCount() - xStart ) );
+	prvCheck( xProducerCommitted == pdTRUE, "producer committed", 0 );
+	prvCheck( pvSlot == ( void * ) pulProducerSlot, "borrowed the slot committed", 0 );
+	prvCheck( *( ( uint32_t * ) pvSlot ) == mainPRODUCER_ITEM, "borrowed item", ( unsigned long ) *( ( uint32_t * ) pvSlot ) );
+	vQueueReleaseSlot( xQueue );
+	prvCheck( uxQueueMessagesWaiting( xQueue ) == 0, "queue empty once released", ( unsigned long ) uxQueueMessagesWaiting( xQueue ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvReleaseTest( void )
+{
+uint32_t *pulSlot, ulItem;
+
+	/* The producer task blocks acquiring a slot of the full queue. */
+	prvSendItem( 3 );
+	ulItem = 4;
+	xQueueSend( xQueue, &ulItem, 0 );
+	xProducerCommitted = pdFALSE;
+	xTaskCreate( prvProducerTask, "Producer", configMINIMAL_STACK_SIZE, ( void * ) 0, mainPRODUCER_PRIORITY, NULL );
+	prvCheck( xProducerCommitted == pdFALSE, "producer blocked on a full queue", 0 );
+
+	/* Releasing the item at the front unblocks the producer task, which runs
+	at once and commits its item to the storage just released. */
+	prvCheck( xQueueBorrowSlot( xQueue, ( void ** ) &pulSlot, 0 ) == pdPASS, "slot borrowed from a full queue", 0 );
+	prvCheck( *pulSlot == 3UL, "item borrowed from a full queue", ( unsigned long ) *pulSlot );
+	prvCheck( xProducerCommitted == pdFALSE, "producer blocked while a slot is borrowed", 0 );
+	vQueueReleaseSlot( xQueue );
+	prvCheck( xProducerCommitted == pdTRUE, "producer unblocked by a release", 0 );
+	prvCheck( pulProducerSlot == pulSlot, "released slot acquired", 0 );
+
+	prvReceiveItem( 4, "item sent before the release" );
+	prvReceiveItem( mainPRODUCER_ITEM, "item committed after the release" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvLockTest( void )
+{
+uint32_t *pulSlot;
+TickType_t xStart;
+
+	/* Slots committed from an ISR while this task blocks on the empty queue
+	unblock it when the queue is unlocked. */
+	uxHookCommitted = 0;
+	xHookCommits = pdTRUE;
+	xStart = xTaskGetTickCount();
+	prvCheck( xQueueBorrowSlot( xQueue, ( void ** ) &pulSlot, mainMAX_WAIT ) == pdPASS, "slot borrowed once a locked queue was unlocked", 0 );
+	prvCheck( ( xTaskGetTickCount() - xStart ) < mainMAX_WAIT, "unblocked once a locked queue was unlocked", ( unsigned long ) ( xTaskGetTickCount() - xStart ) );
+	prvCheck( uxHookCommitted == mainISR_SLOTS, "slots committed to a locked queue", ( unsigned long ) uxHookCommitted );
+	prvCheck( *pulSlot == mainISR_ITEM, "item committed to a locked queue", ( unsigned long ) *pulSlot );
+	vQueueReleaseSlot( xQueue );
+
+	prvReceiveItem( mainISR_ITEM + 1UL, "second item committed to a locked queue" );
+	prvCheck( uxQueueMessagesWaiting( xQueue ) == 0, "queue empty after the lock test", ( unsigned long ) uxQueueMessagesWaiting( xQueue ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvProducerTask( void *pvParameters )
+{
+uint32_t *pulSlot;
+
+	vTaskDelay( ( TickType_t ) ( size_t ) pvParameters );
+
+	if( xQueueAcquireSlot( xQueue, ( void ** ) &pulSlot, portMAX_DELAY ) == pdPASS )
+	{
+		pulProducerSlot = pulSlot;
+		*pulSlot = mainPRODUCER_ITEM;
+		vQueueCommitSlot( xQueue );
+		xProducerCommitted = pdTRUE;
+	}
+
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSendItem( uint32_t ulItem )
+{
+uint32_t *pulSlot;
+
+	if( xQueueAcquireSlot( xQueue, ( void ** ) &pulSlot, 0 ) == pdPASS )
+	{
+		*pulSlot = ulItem;
+		vQueueCommitSlot( xQueue );
+	}
+	else
+	{
+		prvCheck( pdFALSE, "slot acquired", ( unsigned long ) ulItem );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvReceiveItem( uint32_t ulItem, const char *pcCheck )
+{
+uint32_t *pulSlot;
+
+	if( xQueueBorrowSlot( xQueue, ( void ** ) &pulSlot, 0 ) == pdPASS )
+	{
+		prvCheck( *pulSlot == ulItem, pcCheck, ( unsigned long ) *pulSlot );
+		vQueueReleaseSlot( xQueue );
+	}
+	else
+	{
+		prvCheck( pdFALSE, pcCheck, 0 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCommitFromISR( QueueHandle_t xQueueToCommit )
+{
+uint32_t *pulSlot;
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+UBaseType_t x;
+
+	for( x = 0; x < mainISR_SLOTS; x++ )
+	{
+		if( xQueueAcquireSlotFromISR( xQueueToCommit, ( void ** ) &pulSlot ) == pdPASS )
+		{
+			*pulSlot = mainISR_ITEM + ( uint32_t ) x;
+			vQueueCommitSlotFromISR( xQueueToCommit, &xHigherPriorityTaskWoken );
+			uxHookCommitted++;
+		}
+	}
+
+	/* No task is woken while the queue is locked. */
+	prvCheck( xHigherPriorityTaskWoken == pdFALSE, "task woken by a commit to a locked queue", 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		printf( "Failed %s (%lu)\n", pcCheck, ulValue );
+		xFailed = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,440 @@
+/*
+	Tests and benchmarks the serial port driver in serial/serial.c on the host
+	build, with USART1 simulated by usart_sim.c.
+
+	Built with serUSE_DMA set to 1 the driver moves data with the DMA channels,
+	and with it set to 0 with one interrupt per character, so the two can be
+	compared.
+
+	+ The loop back test writes a pattern in blocks of varying length while a
+	  higher priority task reads it back from the receiver, to which the
+	  transmitter is looped back.  Every byte must arrive, in order, and none
+	  be dropped.  The writer keeps no more than the receive buffer ahead of
+	  the reader, as flow control would, so a reader whose thread the host
+	  runs late cannot lose bytes.
+
+	+ The writers test has two tasks write lines longer than the transmit
+	  buffer at the same time, the second, of higher priority, starting a tick
+	  after the first so it tries to write part way through a line.  Each
+	  line must be sent whole.
+
+	+ The benchmark writes mainBENCH_BYTES in blocks of each of several sizes,
+	  and once they have all been sent prints a line of
+
+		serial,<driver>,<block size>,<baud>,<bytes>,<ticks>,<line ticks>,<interrupts per KB>
+
+	  where the line ticks are the ticks the bytes take on the line at the baud
+	  rate, so the ticks taken can only be more.
+
+	The program ends the scheduler once the tests have run, and exits with 0 if
+	every check passed, or 1 after naming those that failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* Library includes. */
+#include "stm32f10x_lib.h"
+
+/* Demo application includes. */
+#include "serial.h"
+#include "usart_sim.h"
+
+#ifndef serUSE_DMA
+	#define serUSE_DMA					1
+#endif
+
+/* The priorities of the task that runs the tests, and of the tasks that write
+for it. */
+#define mainTEST_TASK_PRIORITY			( tskIDLE_PRIORITY + 3 )
+#define mainLATE_WRITER_TASK_PRIORITY	( tskIDLE_PRIORITY + 2 )
+#define mainWRITER_TASK_PRIORITY		( tskIDLE_PRIORITY + 1 )
+
+/* The baud rate USART1 is opened at.  The simulated RCC runs the USART from the
+8MHz HSI clock, so the rate set is the nearest it can divide down to. */
+#define mainBAUD_RATE					( 921600UL )
+
+/* The length of the receive and transmit buffers of the port. */
+#define mainBUFFER_LENGTH				( 256 )
+
+/* The bytes sent by the loop back test. */
+#define mainLOOP_BACK_BYTES				( 8192UL )
+
+/* The lines each task writes in the writers test, and their length, which is
+longer than the transmit buffer. */
+#define mainWRITER_LINES				( 10 )
+#define mainWRITER_LINE_LENGTH			( mainBUFFER_LENGTH + 44 )
+#define mainWRITERS						( 2 )
+
+/* The bytes each benchmark writes. */
+#define mainBENCH_BYTES					( 32768UL )
+
+/* The longest a test waits for data that should arrive. */
+#define mainMAX_WAIT					( pdMS_TO_TICKS( 100 ) )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Opens the port and runs the tests and the benchmark.
+ */
+static void prvTestTask( void *pvParameters );
+
+/*
+ * The tests.
+ */
+static void prvLoopBackTest( void );
+static void prvWritersTest( void );
+static void prvBenchmark( size_t xBlockSize );
+
+/*
+ * Writes the loop back pattern in blocks of varying length.
+ */
+static void prvLoopBackWriterTask( void *pvParameters );
+
+/*
+ * Writes the lines of the writers test, each made of the character passed as
+ * the parameter.  The task created at mainLATE_WRITER_TASK_PRIORITY waits a
+ * tick first.
+ */
+static void prvLineWriterTask( void *pvParameters );
+
+/*
+ * The byte at ulIndex of the loop back pattern.
+ */
+static unsigned char prvPattern( unsigned long ulIndex );
+
+/*
+ * Called from the tick interrupt with each character USART1 transmits.
+ */
+static void prvCapture( USART_TypeDef *pxUSART, unsigned char ucChar );
+
+/*
+ * Waits for ulBytes to have been transmitted, for up to mainMAX_WAIT ticks
+ * after the last one.
+ */
+static void prvWaitForTransmitted( unsigned long ulBytes );
+
+/*
+ * Records a failed check.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* The port under test. */
+static xComPortHandle xPort;
+
+/* Given by each writer task when it finishes.  Not a task notification, as
+those wake the test task from xSerialRead(). */
+static SemaphoreHandle_t xWriterDone;
+
+/* The bytes the loop back test has read back. */
+static volatile unsigned long ulLoopBackReceived = 0;
+
+/* The characters transmitted while prvCapture() is connected, and how many
+there were, which keeps counting once the buffer is full. */
+static unsigned char ucCaptured[ mainWRITERS * mainWRITER_LINES * mainWRITER_LINE_LENGTH ];
+static volatile unsigned long ulTransmitted = 0;
+
+/* A block of the benchmark. */
+static unsigned char ucBenchBlock[ 1024 ];
+
+/* Whether any check failed. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	debug();
+
+	xWriterDone = xSemaphoreCreateCounting( mainWRITERS, 0 );
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE * 2, NULL, mainTEST_TASK_PRIORITY, NULL );
+
+	vTaskStartScheduler();
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All serial tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationTickHook( void )
+{
+	vUSARTSimTick();
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	xPort = xSerialPortInitBaud( serCOM1, mainBAUD_RATE, mainBUFFER_LENGTH );
+	prvCheck( ( xPort != NULL ) ? pdTRUE : pdFALSE, "port opened", 0 );
+
+	if( xPort != NULL )
+	{
+		prvLoopBackTest();
+		prvWritersTest();
+		prvBenchmark( 16 );
+		prvBenchmark( 64 );
+		prvBenchmark( 256 );
+		prvBenchmark( sizeof( ucBenchBlock ) );
+	}
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvLoopBackTest( void )
+{
+unsigned char ucBuffer[ 100 ];
+unsigned long ulReceived = 0, ulErrors = 0;
+SerialStats_t xStats;
+size_t xBytes, x;
+
+	ulLoopBackReceived = 0;
+	vUSARTSimConnect( USART1, NULL, pdTRUE );
+	xTaskCreate( prvLoopBackWriterTask, "Writer", configMINIMAL_STACK_SIZE, NULL, mainWRITER_TASK_PRIORITY, NULL );
+
+	while( ulReceived < mainLOOP_BACK_BYTES )
+	{
+		xBytes = xSerialRead( xPort, ucBuffer, sizeof( ucBuffer ), mainMAX_WAIT );
+
+		if( xBytes == 0 )
+		{
+			break;
+		}
+
+		for( x = 0; x < xBytes; x++ )
+		{
+			if( ucBuffer[ x ] != prvPattern( ulReceived + x ) )
+			{
+				ulErrors++;
+			}
+		}
+
+		ulReceived += xBytes;
+		ulLoopBackReceived = ulReceived;
+	}
+
+	( void ) xSemaphoreTake( xWriterDone, mainMAX_WAIT );
+	vSerialGetStats( xPort, &xStats );
+
+	prvCheck( ( ulReceived == mainLOOP_BACK_BYTES ) ? pdTRUE : pdFALSE, "loop back bytes received", ulReceived );
+	prvCheck( ( ulErrors == 0 ) ? pdTRUE : pdFALSE, "loop back bytes that differ", ulErrors );
+	prvCheck( ( xStats.ulRxDroppedBytes == 0 ) ? pdTRUE : pdFALSE, "loop back bytes dropped", xStats.ulRxDroppedBytes );
+	prvCheck( ( xStats.ulRxOverruns == 0 ) ? pdTRUE : pdFALSE, "loop back overruns", xStats.ulRxOverruns );
+}
+/*-----------------------------------------------------------*/
+
+static void prvLoopBackWriterTask( void *pvParameters )
+{
+unsigned char ucBlock[ 200 ];
+unsigned long ulWritten = 0;
+size_t xLength = 1, x;
+
+	( void ) pvParameters;
+
+	while( ulWritten < mainLOOP_BACK_BYTES )
+	{
+		/* Lengths from 1 to the size of the block, including lengths longer
+		than the DMA buffers. */
+		xLength = ( ( xLength * 37U ) % sizeof( ucBlock ) ) + 1U;
+
+		if( xLength > ( mainLOOP_BACK_BYTES - ulWritten ) )
+		{
+			xLength = ( size_t ) ( mainLOOP_BACK_BYTES - ulWritten );
+		}
+
+		for( x = 0; x < xLength; x++ )
+		{
+			ucBlock[ x ] = prvPattern( ulWritten + x );
+		}
+
+		/* Wait until the block fits in the receive buffer with the bytes
+		not yet read back. */
+		while( ( ulWritten + xLength - ulLoopBackReceived ) > mainBUFFER_LENGTH )
+		{
+			vTaskDelay( 1 );
+		}
+
+		ulWritten += xSerialWrite( xPort, ucBlock, xLength, portMAX_DELAY );
+	}
+
+	( void ) xSemaphoreGive( xWriterDone );
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWritersTest( void )
+{
+unsigned long ulLine, ulBadLines = 0, ulCharacter;
+const unsigned char *pucLine;
+BaseType_t xWriter;
+
+	ulTransmitted = 0;
+	vUSARTSimConnect( USART1, prvCapture, pdFALSE );
+
+	xTaskCreate( prvLineWriterTask, "WriterA", configMINIMAL_STACK_SIZE, ( void * ) 'A', mainWRITER_TASK_PRIORITY, NULL );
+	xTaskCreate( prvLineWriterTask, "WriterB", configMINIMAL_STACK_SIZE, ( void * ) 'B', mainLATE_WRITER_TASK_PRIORITY, NULL );
+
+	for( xWriter = 0; xWriter < mainWRITERS; xWriter++ )
+	{
+		( void ) xSemaphoreTake( xWriterDone, portMAX_DELAY );
+	}
+
+	prvWaitForTransmitted( sizeof( ucCaptured ) );
+	prvCheck( ( ulTransmitted == sizeof( ucCaptured ) ) ? pdTRUE : pdFALSE, "writers bytes sent", ulTransmitted );
+
+	/* Each line must be one character repeated, then a new line. */
+	for( ulLine = 0; ulLine < ( mainWRITERS * mainWRITER_LINES ); ulLine++ )
+	{
+		pucLine = &( ucCaptured[ ulLine * mainWRITER_LINE_LENGTH ] );
+
+		for( ulCharacter = 1; ulCharacter < ( mainWRITER_LINE_LENGTH - 1 ); ulCharacter++ )
+		{
+			if( pucLine[ ulCharacter ] != pucLine[ 0 ] )
+			{
+				break;
+			}
+		}
+
+		if( ( ulCharacter != ( mainWRITER_LINE_LENGTH - 1 ) ) || ( pucLine[ ulCharacter ] != '\n' ) )
+		{
+			ulBadLines++;
+		}
+	}
+
+	prvCheck( ( ulBadLines == 0 ) ? pdTRUE : pdFALSE, "writers lines not sent whole", ulBadLines );
+}
+/*-----------------------------------------------------------*/
+
+static void prvLineWriterTask( void *pvParameters )
+{
+unsigned char ucLine[ mainWRITER_LINE_LENGTH ];
+unsigned long ulLine;
+size_t x;
+
+	for( x = 0; x < ( sizeof( ucLine ) - 1 ); x++ )
+	{
+		ucLine[ x ] = ( unsigned char ) ( size_t ) pvParameters;
+	}
+
+	ucLine[ x ] = '\n';
+
+	if( uxTaskPriorityGet( NULL ) == mainLATE_WRITER_TASK_PRIORITY )
+	{
+		vTaskDelay( 1 );
+	}
+
+	for( ulLine = 0; ulLine < mainWRITER_LINES; ulLine++ )
+	{
+		( void ) xSerialWrite( xPort, ucLine, sizeof( ucLine ), portMAX_DELAY );
+	}
+
+	( void ) xSemaphoreGive( xWriterDone );
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchmark( size_t xBlockSize )
+{
+RCC_ClocksTypeDef xClocks;
+unsigned long ulBaud, ulInterrupts, ulWritten = 0;
+TickType_t xStart, xLineTicks;
+
+	RCC_GetClocksFreq( &xClocks );
+	ulBaud = xClocks.PCLK2_Frequency / USART1->BRR;
+	xLineTicks = ( TickType_t ) ( ( ( unsigned long long ) mainBENCH_BYTES * 10ULL * configTICK_RATE_HZ ) / ulBaud );
+
+	ulTransmitted = 0;
+	vUSARTSimConnect( USART1, prvCapture, pdFALSE );
+
+	/* Start on a tick, so the ticks taken are not one short. */
+	vTaskDelay( 1 );
+	xStart = xTaskGetTickCount();
+	ulInterrupts = ulUSARTSimInterrupts( USART1 );
+
+	while( ulWritten < mainBENCH_BYTES )
+	{
+		ulWritten += xSerialWrite( xPort, ucBenchBlock, xBlockSize, portMAX_DELAY );
+	}
+
+	prvWaitForTransmitted( mainBENCH_BYTES );
+	ulInterrupts = ulUSARTSimInterrupts( USART1 ) - ulInterrupts;
+
+	prvCheck( ( ulTransmitted == mainBENCH_BYTES ) ? pdTRUE : pdFALSE, "benchmark bytes sent", ulTransmitted );
+
+	taskENTER_CRITICAL();
+	{
+		printf( "serial,%s,%lu,%lu,%lu,%lu,%lu,%lu\n", ( serUSE_DMA == 1 ) ? "dma" : "interrupt", ( unsigned long ) xBlockSize, ulBaud, mainBENCH_BYTES,
+				( unsigned long ) ( xTaskGetTickCount() - xStart ), ( unsigned long ) xLineTicks, ( ulInterrupts * 1024UL ) / mainBENCH_BYTES );
+		fflush( stdout );
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static void prvWaitForTransmitted( unsigned long ulBytes )
+{
+unsigned long ulLast;
+TickType_t xLastChange = xTaskGetTickCount();
+
+	ulLast = ulTransmitted;
+
+	while( ( ulTransmitted < ulBytes ) && ( ( xTaskGetTickCount() - xLastChange ) < mainMAX_WAIT ) )
+	{
+		vTaskDelay( 1 );
+
+		if( ulTransmitted != ulLast )
+		{
+			ulLast = ulTransmitted;
+			xLastChange = xTaskGetTickCount();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCapture( USART_TypeDef *pxUSART, unsigned char ucChar )
+{
+	( void ) pxUSART;
+
+	if( ulTransmitted < sizeof( ucCaptured ) )
+	{
+		ucCaptured[ ulTransmitted ] = ucChar;
+	}
+
+	ulTransmitted++;
+}
+/*-----------------------------------------------------------*/
+
+static unsigned char prvPattern( unsigned long ulIndex )
+{
+	return ( unsigned char ) ( ( ulIndex * 7UL ) + ( ulIndex >> 8 ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		taskENTER_CRITICAL();
+		{
+			printf( "Failed %s (%lu) at tick %lu\n", pcCheck, ulValue, ( unsigned long ) xTaskGetTickCount() );
+			fflush( stdout );
+		}
+		taskEXIT_CRITICAL();
+
+		xFailed = pdTRUE;
+	}
+}
@@ -0,0 +1,705 @@
+/*
+	Tests the SPI FLASH driver of spi_flash.c on the host build, with SPI1,
+	its DMA channels and the M25P64 simulated by spi_sim.c, and what the FLASH
+	holds by flash_sim.c.  The RCC registers are set for the 72MHz PLL clock
+	of the target, so the SPI clock, and the rate the DMA moves bytes at, is
+	the 18MHz the driver sets.  Each command the FLASH receives is logged, and
+	none may be refused because the FLASH was busy or not write enabled.
+
+	Built with SPI_FLASH_USE_RTOS set to 1 the driver moves blocks with the DMA
+	and waits for the FLASH by delaying, and with it set to 0 polls for both;
+	SPI_FLASH_USE_FAST_READ selects FAST_READ or READ.  The tests check
+	whichever the build selects.
+
+	+ The stopped scheduler test writes and reads the FLASH before the
+	  scheduler starts, when the driver can only poll, so the erase must be
+	  waited for by one RDSR command that reads the status register until the
+	  FLASH is no longer busy.
+
+	+ The write and read test writes a block that starts part way through a
+	  page, which must be programmed with a page program for each page it
+	  touches, and reads it back with the DMA, with the DMA disabled by
+	  SPI_FLASH_DMACmd(), and in a block too short for the DMA.
+
+	+ The long read test reads more than a DMA transfer can move in one
+	  command, which must be split into transfers of at most 65535 bytes, each
+	  ended by the DMA interrupt notifying the waiting task.
+
+	+ The stream test reads successive blocks of one read sequence, and the
+	  block started by SPI_FLASH_ReadStreamStart() must still be arriving when
+	  the function returns.
+
+	+ The back off test erases a sector, and the status register must be read
+	  with a delay between reads that starts at a tick and doubles up to 32,
+	  so the erase is seen to end within 32 ticks, and a page program 3 ticks
+	  after the first read.
+
+	+ The timeout test holds the DMA, so a read must give up after the 100ms
+	  timeout with the channels stopped, and the next read work.
+
+	+ The benchmark test runs the benchmarks of spi_flash_bench.c, which must
+	  report benchITERATIONS samples for each case.
+
+	The program ends the scheduler once the tests have run, and exits with 0 if
+	every check passed, or 1 after naming those that failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Library includes. */
+#include "stm32f10x_lib.h"
+#include "spi_flash.h"
+
+/* Demo application includes. */
+#include "serial.h"
+#include "KernelBench.h"
+#include "spi_flash_bench.h"
+#include "flash_sim.h"
+#include "spi_sim.h"
+
+/* The priorities of the task that runs the tests, and of the benchmarks. */
+#define mainTEST_TASK_PRIORITY			( tskIDLE_PRIORITY + 2 )
+#define mainBENCHMARK_PRIORITY			( tskIDLE_PRIORITY + 1 )
+
+/* The file the FLASH is held in. */
+#define mainFLASH_FILE					"spi_flash.bin"
+
+/* The CFGR register of the target once it runs from the PLL: the 8MHz HSE
+multiplied by 9, with PCLK1 at half HCLK, and the switch status showing the
+PLL. */
+#define mainCFGR_PLL_72MHZ				( RCC_PLLSource_HSE_Div1 | RCC_PLLMul_9 | RCC_HCLK_Div2 | 0x00000008UL )
+
+/* The instruction the driver reads with. */
+#if SPI_FLASH_USE_FAST_READ == 1
+	#define mainREAD					spisimFAST_READ
+#else
+	#define mainREAD					spisimREAD
+#endif
+
+/* The sectors each test uses. */
+#define mainSECTOR( x )					( ( uint32_t ) ( x ) * flashsimSECTOR_SIZE )
+
+/* The bytes read by the long read test, the most a DMA transfer moves, and so
+the transfers it takes. */
+#define mainLONG_READ					150000UL
+#define mainDMA_MAX_BLOCK				65535UL
+#define mainLONG_READ_TRANSFERS			( ( mainLONG_READ + mainDMA_MAX_BLOCK - 1UL ) / mainDMA_MAX_BLOCK )
+
+/* The bytes the DMA moves each tick at the 18MHz SPI clock, and so the most
+ticks the long read takes - each transfer ends on a tick, and the next starts
+on the tick after. */
+#define mainBYTES_PER_TICK				( 18000000UL / 8UL / configTICK_RATE_HZ )
+#define mainLONG_READ_TICKS				( ( mainLONG_READ / mainBYTES_PER_TICK ) + mainLONG_READ_TRANSFERS + 1UL )
+
+/* The bytes written by the write and read test, and the offset into a page
+they start at. */
+#define mainWRITE_BYTES					1000U
+#define mainWRITE_OFFSET				0x15UL
+
+/* The blocks read by the stream test. */
+#define mainSTREAM_BLOCK				4096U
+#define mainSTREAM_TAIL					100U
+
+/* The busy times of the FLASH, in microseconds.  Erases are shortened where
+the test does not measure them, as the polled driver reads the status
+register a byte at a time for the whole erase. */
+#define mainPROGRAM_TIME				1400UL
+#define mainERASE_TIME					1000000UL
+#define mainSHORT_ERASE_TIME			20000UL
+
+/* The longest delay between status reads, and the DMA timeout, of
+spi_flash.c. */
+#define mainMAX_STATUS_DELAY			32U
+#define mainDMA_TIMEOUT					pdMS_TO_TICKS( 100 )
+
+/* The most commands logged. */
+#define mainMAX_COMMANDS				256U
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Runs the tests.
+ */
+static void prvTestTask( void *pvParameters );
+
+/*
+ * The tests.
+ */
+static void prvStoppedSchedulerTest( void );
+static void prvWriteReadTest( void );
+static void prvLongReadTest( void );
+static void prvStreamTest( void );
+static void prvBackOffTest( void );
+static void prvTimeoutTest( void );
+static void prvBenchmarkTest( void );
+
+/*
+ * Logs each command the FLASH receives.
+ */
+static void prvLogCommand( const SPISimCommand_t *pxCommand );
+
+/*
+ * Empties the log.
+ */
+static void prvClearLog( void );
+
+/*
+ * Returns the number of commands in the log with the instruction
+ * ucInstruction, and, if ppxFirst is not NULL, sets it to the first.
+ */
+static uint32_t prvCountCommands( uint8_t ucInstruction, const SPISimCommand_t **ppxFirst );
+
+/*
+ * Checks the log holds no refused commands.
+ */
+static void prvCheckNoneRefused( const char *pcTest );
+
+/*
+ * The byte the tests store at ulAddress, which differs from those near it
+ * so a byte read from the wrong address is seen.
+ */
+static uint8_t prvPattern( uint32_t ulAddress );
+
+/*
+ * Fills ulBytes of the buffer with the pattern of ulAddress on, and returns
+ * pdTRUE if ulBytes of pucBuffer hold it.
+ */
+static void prvFillPattern( uint8_t *pucBuffer, uint32_t ulAddress, uint32_t ulBytes );
+static BaseType_t prvHoldsPattern( const uint8_t *pucBuffer, uint32_t ulAddress, uint32_t ulBytes );
+
+/*
+ * Records a failed check.  ulValue is printed to help find the cause.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* The commands logged, and the number received, which can be more. */
+static SPISimCommand_t xCommands[ mainMAX_COMMANDS ];
+static volatile uint32_t ulCommands = 0;
+
+/* The buffers the DMA moves, which must be static so they are below 4GB. */
+static uint8_t ucWriteBuffer[ mainWRITE_BYTES ];
+static uint8_t ucReadBuffer[ mainLONG_READ ];
+
+/* The benchmark lines written, and the number. */
+static char cBenchLines[ 4 ][ 256 ];
+static uint32_t ulBenchLines = 0;
+
+/* Whether any check failed. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	debug();
+	RCC->CFGR = mainCFGR_PLL_72MHZ;
+
+	( void ) unlink( mainFLASH_FILE );
+
+	if( xFlashSimOpen( mainFLASH_FILE, spisimFLASH_SIZE ) == pdFAIL )
+	{
+		printf( "Failed flash opened\n" );
+		return EXIT_FAILURE;
+	}
+
+	vSPISimConnect( prvLogCommand );
+	SPI_FLASH_Init();
+
+	prvStoppedSchedulerTest();
+
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE * 2, NULL, mainTEST_TASK_PRIORITY, NULL );
+
+	vTaskStartScheduler();
+
+	vFlashSimClose();
+	( void ) unlink( mainFLASH_FILE );
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All SPI FLASH tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationTickHook( void )
+{
+	vSPISimTick();
+}
+/*-----------------------------------------------------------*/
+
+void vSerialPutString( xComPortHandle pxPort, const signed char * const pcString, unsigned short usStringLength )
+{
+	( void ) pxPort;
+
+	/* The benchmark lines. */
+	if( ( ulBenchLines < ( sizeof( cBenchLines ) / sizeof( cBenchLines[ 0 ] ) ) ) && ( usStringLength < sizeof( cBenchLines[ 0 ] ) ) )
+	{
+		memcpy( ( void * ) cBenchLines[ ulBenchLines ], ( const void * ) pcString, usStringLength );
+		cBenchLines[ ulBenchLines ][ usStringLength ] = 0x00;
+	}
+
+	ulBenchLines++;
+	printf( "%.*s", ( int ) usStringLength, ( const char * ) pcString );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	prvWriteReadTest();
+	prvLongReadTest();
+	prvStreamTest();
+	prvBackOffTest();
+	prvTimeoutTest();
+	prvBenchmarkTest();
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvStoppedSchedulerTest( void )
+{
+const SPISimCommand_t *pxCommand;
+uint32_t x;
+
+	prvCheck( SPI_FLASH_ReadID() == spisimID, "identification read", SPI_FLASH_ReadID() );
+
+	vSPISimSetBusyTime( mainPROGRAM_TIME, mainSHORT_ERASE_TIME );
+	prvClearLog();
+	SPI_FLASH_SectorErase( mainSECTOR( 1 ) );
+
+	/* Polled while the FLASH was selected. */
+	prvCheck( prvCountCommands( spisimRDSR, &pxCommand ) == 1UL, "erase waited for by one status command", prvCountCommands( spisimRDSR, NULL ) );
+	prvCheck( ( pxCommand != NULL ) && ( pxCommand->ulBytes > 1000UL ), "status read until the erase ended", ( pxCommand != NULL ) ? pxCommand->ulBytes : 0UL );
+
+	prvFillPattern( ucWriteBuffer, mainSECTOR( 1 ) + mainWRITE_OFFSET, mainWRITE_BYTES );
+	SPI_FLASH_BufferWrite( ucWriteBuffer, mainSECTOR( 1 ) + mainWRITE_OFFSET, mainWRITE_BYTES );
+	SPI_FLASH_BufferRead( ucReadBuffer, mainSECTOR( 1 ) + mainWRITE_OFFSET, mainWRITE_BYTES );
+	prvCheck( prvHoldsPattern( ucReadBuffer, mainSECTOR( 1 ) + mainWRITE_OFFSET, mainWRITE_BYTES ), "written and read with the scheduler stopped", 0 );
+
+	vSPISimChipSelect();
+
+	for( x = 0; x < ulCommands; x++ )
+	{
+		prvCheck( xCommands[ x ].ulDMABytes == 0UL, "polled with the scheduler stopped", xCommands[ x ].ucInstruction );
+	}
+
+	prvCheckNoneRefused( "stopped scheduler" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteReadTest( void )
+{
+const uint32_t ulAddress = mainSECTOR( 2 ) + mainWRITE_OFFSET;
+const SPISimCommand_t *pxCommand;
+uint32_t x, ulPrograms = 0, ulProgrammed = 0, ulReads;
+
+	vSPISimSetBusyTime( mainPROGRAM_TIME, mainSHORT_ERASE_TIME );
+	SPI_FLASH_SectorErase( ulAddress );
+
+	prvClearLog();
+	prvFillPattern( ucWriteBuffer, ulAddress, mainWRITE_BYTES );
+	SPI_FLASH_BufferWrite( ucWriteBuffer, ulAddress, mainWRITE_BYTES );
+	vSPISimChipSelect();
+
+	/* A page program for each page touched, each enabled, each starting on
+	the page the last ended, and never past the end of its page. */
+	for( x = 0; x < ulCommands; x++ )
+	{
+		pxCommand = &( xCommands[ x ] );
+
+		if( pxCommand->ucInstruction == spisimWRITE )
+		{
+			prvCheck( pxCommand->ulAddress == ( ulAddress + ulProgrammed ), "page program address", pxCommand->ulAddress );
+			prvCheck( ( ( pxCommand->ulAddress % flashsimPAGE_SIZE ) + pxCommand->ulBytes ) <= flashsimPAGE_SIZE, "page program within its page", pxCommand->ulBytes );
+			prvCheck( ( x > 0UL ) && ( xCommands[ x - 1UL ].ucInstruction == spisimWREN ), "page program write enabled", x );
+
+			#if SPI_FLASH_USE_RTOS == 1
+				prvCheck( pxCommand->ulDMABytes == pxCommand->ulBytes, "page programmed with the DMA", pxCommand->ulDMABytes );
+			#else
+				prvCheck( pxCommand->ulDMABytes == 0UL, "page programmed polled", pxCommand->ulDMABytes );
+			#endif
+
+			ulPrograms++;
+			ulProgrammed += pxCommand->ulBytes;
+		}
+	}
+
+	prvCheck( ulPrograms == ( ( mainWRITE_OFFSET + mainWRITE_BYTES + flashsimPAGE_SIZE - 1UL ) / flashsimPAGE_SIZE ), "page programs", ulPrograms );
+	prvCheck( ulProgrammed == mainWRITE_BYTES, "bytes programmed", ulProgrammed );
+
+	/* Read back with the DMA. */
+	prvClearLog();
+	memset( ( void * ) ucReadBuffer, 0x00, mainWRITE_BYTES );
+	SPI_FLASH_BufferRead( ucReadBuffer, ulAddress, mainWRITE_BYTES );
+	prvCheck( prvHoldsPattern( ucReadBuffer, ulAddress, mainWRITE_BYTES ), "read back", 0 );
+	ulReads = prvCountCommands( mainREAD, &pxCommand );
+	prvCheck( ( ulReads == 1UL ) && ( pxCommand->ulAddress == ulAddress ) && ( pxCommand->ulBytes == mainWRITE_BYTES ), "read command", ulReads );
+
+	#if SPI_FLASH_USE_RTOS == 1
+		prvCheck( ( pxCommand != NULL ) && ( pxCommand->ulDMABytes == mainWRITE_BYTES ), "read with the DMA", ( pxCommand != NULL ) ? pxCommand->ulDMABytes : 0UL );
+	#endif
+
+	/* Read back with the DMA disabled. */
+	prvClearLog();
+	memset( ( void * ) ucReadBuffer, 0x00, mainWRITE_BYTES );
+	SPI_FLASH_DMACmd( DISABLE );
+	SPI_FLASH_BufferRead( ucReadBuffer, ulAddress, mainWRITE_BYTES );
+	SPI_FLASH_DMACmd( ENABLE );
+	prvCheck( prvHoldsPattern( ucReadBuffer, ulAddress, mainWRITE_BYTES ), "read back polled", 0 );
+	ulReads = prvCountCommands( mainREAD, &pxCommand );
+	prvCheck( ( ulReads == 1UL ) && ( pxCommand->ulDMABytes == 0UL ), "read polled with the DMA disabled", ( pxCommand != NULL ) ? pxCommand->ulDMABytes : 0UL );
+
+	/* A block too short for the DMA, from part way through. */
+	prvClearLog();
+	memset( ( void * ) ucReadBuffer, 0x00, mainWRITE_BYTES );
+	SPI_FLASH_BufferRead( ucReadBuffer, ulAddress + 301UL, 8UL );
+	prvCheck( prvHoldsPattern( ucReadBuffer, ulAddress + 301UL, 8UL ), "short block read", 0 );
+	ulReads = prvCountCommands( mainREAD, &pxCommand );
+	prvCheck( ( ulReads == 1UL ) && ( pxCommand->ulDMABytes == 0UL ), "short block polled", ( pxCommand != NULL ) ? pxCommand->ulDMABytes : 0UL );
+
+	prvCheckNoneRefused( "write and read" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvLongReadTest( void )
+{
+const uint32_t ulAddress = mainSECTOR( 3 ) + 7UL;
+const SPISimCommand_t *pxCommand;
+uint32_t ulTransfers, ulInterrupts, ulReads, x;
+TickType_t xTaken;
+
+	/* Written straight into the simulated FLASH, as only the read is
+	tested. */
+	for( x = 3; x < 6; x++ )
+	{
+		vFlashSimEraseSector( mainSECTOR( x ) );
+	}
+
+	prvFillPattern( ucReadBuffer, ulAddress, mainLONG_READ );
+	vFlashSimProgram( ulAddress, ucReadBuffer, mainLONG_READ );
+	memset( ( void * ) ucReadBuffer, 0x00, sizeof( ucReadBuffer ) );
+
+	prvClearLog();
+	ulTransfers = ulSPISimTransfers();
+	ulInterrupts = ulSPISimInterrupts();
+	xTaken = xTaskGetTickCount();
+	SPI_FLASH_BufferRead( ucReadBuffer, ulAddress, mainLONG_READ );
+	xTaken = xTaskGetTickCount() - xTaken;
+	ulTransfers = ulSPISimTransfers() - ulTransfers;
+	ulInterrupts = ulSPISimInterrupts() - ulInterrupts;
+
+	prvCheck( prvHoldsPattern( ucReadBuffer, ulAddress, mainLONG_READ ), "long read", 0 );
+	ulReads = prvCountCommands( mainREAD, &pxCommand );
+	prvCheck( ( ulReads == 1UL ) && ( pxCommand->ulBytes == mainLONG_READ ), "long read in one command", ( pxCommand != NULL ) ? pxCommand->ulBytes : 0UL );
+
+	#if SPI_FLASH_USE_RTOS == 1
+		prvCheck( ( pxCommand != NULL ) && ( pxCommand->ulDMABytes == mainLONG_READ ), "long read with the DMA", ( pxCommand != NULL ) ? pxCommand->ulDMABytes : 0UL );
+		prvCheck( ulTransfers == mainLONG_READ_TRANSFERS, "long read split into transfers", ulTransfers );
+		prvCheck( ulInterrupts == mainLONG_READ_TRANSFERS, "long read transfers ended by the interrupt", ulInterrupts );
+		prvCheck( xTaken <= mainLONG_READ_TICKS, "long read not waiting for the timeout", ( unsigned long ) xTaken );
+	#else
+		( void ) xTaken;
+		prvCheck( ulTransfers == 0UL, "long read polled", ulTransfers );
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+static void prvStreamTest( void )
+{
+const uint32_t ulAddress = mainSECTOR( 3 ) + 7UL + 1000UL;
+const SPISimCommand_t *pxCommand;
+uint32_t ulInterrupts, ulReads;
+
+	/* The long read test left its pattern in the FLASH. */
+	memset( ( void * ) ucReadBuffer, 0x00, sizeof( ucReadBuffer ) );
+	prvClearLog();
+	ulInterrupts = ulSPISimInterrupts();
+
+	SPI_FLASH_StartReadSequence( ulAddress );
+	SPI_FLASH_ReadStreamStart( ucReadBuffer, mainSTREAM_BLOCK );
+
+	#if SPI_FLASH_USE_RTOS == 1
+		/* More than a tick's worth of bytes, so still arriving. */
+		prvCheck( ( ulSPISimInterrupts() == ulInterrupts ) && ( prvHoldsPattern( ucReadBuffer, ulAddress, mainSTREAM_BLOCK ) == pdFALSE ), "stream block arriving after its start returned", 0 );
+	#else
+		prvCheck( prvHoldsPattern( ucReadBuffer, ulAddress, mainSTREAM_BLOCK ), "stream block read as its start returned", 0 );
+	#endif
+
+	SPI_FLASH_ReadStreamWait();
+	prvCheck( prvHoldsPattern( ucReadBuffer, ulAddress, mainSTREAM_BLOCK ), "first stream block", 0 );
+
+	/* Starting the next block waits for the last, so it is not waited for
+	here. */
+	SPI_FLASH_ReadStreamStart( &( ucReadBuffer[ mainSTREAM_BLOCK ] ), mainSTREAM_BLOCK );
+	SPI_FLASH_ReadStream( &( ucReadBuffer[ 2U * mainSTREAM_BLOCK ] ), mainSTREAM_TAIL );
+	SPI_FLASH_EndReadSequence();
+
+	prvCheck( prvHoldsPattern( ucReadBuffer, ulAddress, ( 2U * mainSTREAM_BLOCK ) + mainSTREAM_TAIL ), "stream blocks", 0 );
+	ulReads = prvCountCommands( mainREAD, &pxCommand );
+	prvCheck( ( ulReads == 1UL ) && ( pxCommand->ulBytes == ( ( 2U * mainSTREAM_BLOCK ) + mainSTREAM_TAIL ) ), "stream in one command", ( pxCommand != NULL ) ? pxCommand->ulBytes : 0UL );
+
+	#if SPI_FLASH_USE_RTOS == 1
+		prvCheck( ulSPISimInterrupts() - ulInterrupts == 3UL, "stream blocks moved by the DMA", ulSPISimInterrupts() - ulInterrupts );
+	#else
+		( void ) ulInterrupts;
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+static void prvBackOffTest( void )
+{
+const SPISimCommand_t *pxCommand;
+TickType_t xStart, xEnd, xExpected, xGap;
+uint32_t x, ulReads;
+
+	#if SPI_FLASH_USE_RTOS == 1
+		vSPISimSetBusyTime( mainPROGRAM_TIME, mainERASE_TIME );
+	#else
+		vSPISimSetBusyTime( mainPROGRAM_TIME, mainSHORT_ERASE_TIME );
+	#endif
+
+	prvClearLog();
+	xStart = xTaskGetTickCount();
+	SPI_FLASH_SectorErase( mainSECTOR( 6 ) );
+	xEnd = xTaskGetTickCount();
+	ulReads = prvCountCommands( spisimRDSR, &pxCommand );
+
+	#if SPI_FLASH_USE_RTOS == 1
+	{
+		/* The delay between reads doubles from a tick to mainMAX_STATUS_DELAY,
+		and the erase is seen to end no more than that after it did. */
+		xExpected = 1;
+
+		for( x = 0, pxCommand = NULL; x < ulCommands; x++ )
+		{
+			if( xCommands[ x ].ucInstruction == spisimRDSR )
+			{
+				if( pxCommand != NULL )
+				{
+					/* A read can be sent a tick late, if the host is slow to
+					run the task once its delay ends, and the next a tick
+					early. */
+					xGap = xCommands[ x ].xStartTick - pxCommand->xStartTick;
+					prvCheck( ( ( xGap + 1U ) >= xExpected ) && ( xGap <= ( xExpected + 1U ) ), "delay between status reads", ( unsigned long ) xGap );
+
+					if( xExpected < mainMAX_STATUS_DELAY )
+					{
+						xExpected <<= 1;
+					}
+				}
+
+				pxCommand = &( xCommands[ x ] );
+				prvCheck( pxCommand->ulBytes == 1UL, "status read once a command", pxCommand->ulBytes );
+			}
+		}
+
+		prvCheck( ( xEnd - xStart ) >= pdMS_TO_TICKS( mainERASE_TIME / 1000UL ), "erase waited for", ( unsigned long ) ( xEnd - xStart ) );
+		prvCheck( ( xEnd - xStart ) <= ( pdMS_TO_TICKS( mainERASE_TIME / 1000UL ) + mainMAX_STATUS_DELAY ), "erase end seen", ( unsigned long ) ( xEnd - xStart ) );
+		prvCheck( ( ulReads > 6UL ) && ( ulReads < ( 6UL + ( mainERASE_TIME / ( 1000UL * mainMAX_STATUS_DELAY ) ) + 2UL ) ), "status reads during an erase", ulReads );
+
+		/* A page program ends between the second and third reads. */
+		prvClearLog();
+		SPI_FLASH_PageWrite( ucWriteBuffer, mainSECTOR( 6 ), 64 );
+		xEnd = xTaskGetTickCount();
+
+		prvCheck( prvCountCommands( spisimRDSR, &pxCommand ) == 3UL, "status reads during a page program", prvCountCommands( spisimRDSR, NULL ) );
+		prvCheck( ( pxCommand != NULL ) && ( ( xEnd - pxCommand->xStartTick ) == 3U ), "page program end seen", ( pxCommand != NULL ) ? ( unsigned long ) ( xEnd - pxCommand->xStartTick ) : 0UL );
+	}
+	#else
+	{
+		( void ) xStart;
+		( void ) xEnd;
+		( void ) xExpected;
+		( void ) xGap;
+		( void ) x;
+
+		prvCheck( ( ulReads == 1UL ) && ( pxCommand->ulBytes > 1000UL ), "erase polled", ulReads );
+	}
+	#endif
+
+	prvCheckNoneRefused( "back off" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTimeoutTest( void )
+{
+#if SPI_FLASH_USE_RTOS == 1
+const uint32_t ulAddress = mainSECTOR( 3 ) + 7UL;
+TickType_t xStart, xTaken;
+
+	memset( ( void * ) ucReadBuffer, 0x00, mainWRITE_BYTES );
+
+	vSPISimHoldDMA( pdTRUE );
+	xStart = xTaskGetTickCount();
+	SPI_FLASH_BufferRead( ucReadBuffer, ulAddress, mainWRITE_BYTES );
+	xTaken = xTaskGetTickCount() - xStart;
+	vSPISimHoldDMA( pdFALSE );
+
+	prvCheck( ( xTaken >= mainDMA_TIMEOUT ) && ( xTaken <= ( mainDMA_TIMEOUT + 2U ) ), "read given up after the timeout", ( unsigned long ) xTaken );
+	prvCheck( ( ( DMA_Channel2->CCR & 0x0001UL ) == 0UL ) && ( ( DMA_Channel3->CCR & 0x0001UL ) == 0UL ), "channels stopped after the timeout", DMA_Channel2->CCR );
+
+	/* The next transfer is not ended early by what the one given up left. */
+	SPI_FLASH_BufferRead( ucReadBuffer, ulAddress, mainWRITE_BYTES );
+	prvCheck( prvHoldsPattern( ucReadBuffer, ulAddress, mainWRITE_BYTES ), "read after the timeout", 0 );
+#endif
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchmarkTest( void )
+{
+static const char * const pcCases[] =
+{
+	"SPI_FLASH_BufferRead 256 polled",
+	"SPI_FLASH_BufferRead 256 DMA",
+	"SPI_FLASH_BufferWrite 256 polled",
+	"SPI_FLASH_BufferWrite 256 DMA"
+};
+char cExpected[ 64 ];
+uint32_t x;
+
+	vSPISimSetBusyTime( mainPROGRAM_TIME, mainSHORT_ERASE_TIME );
+	vStartSPIFlashBenchmarks( mainBENCHMARK_PRIORITY );
+
+	for( x = 0; ( x < 100UL ) && ( xAreBenchmarksComplete() == pdFALSE ); x++ )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 100 ) );
+	}
+
+	prvCheck( xAreBenchmarksComplete(), "benchmarks complete", ulBenchLines );
+	prvCheck( ulBenchLines == ( sizeof( pcCases ) / sizeof( pcCases[ 0 ] ) ), "benchmark lines", ulBenchLines );
+
+	for( x = 0; ( x < ulBenchLines ) && ( x < ( sizeof( pcCases ) / sizeof( pcCases[ 0 ] ) ) ); x++ )
+	{
+		( void ) sprintf( cExpected, "bench,%s,%lu,", pcCases[ x ], ( unsigned long ) benchITERATIONS );
+		prvCheck( strncmp( cBenchLines[ x ], cExpected, strlen( cExpected ) ) == 0, "benchmark samples", x );
+	}
+
+	/* The last page written holds the count of the pages written. */
+	SPI_FLASH_BufferRead( ucReadBuffer, benchSPI_FLASH_ADDRESS, 1UL );
+	prvCheck( ucReadBuffer[ 0 ] != 0xffU, "benchmark pages written", ucReadBuffer[ 0 ] );
+	prvCheckNoneRefused( "benchmark" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvLogCommand( const SPISimCommand_t *pxCommand )
+{
+	if( ulCommands < mainMAX_COMMANDS )
+	{
+		xCommands[ ulCommands ] = *pxCommand;
+	}
+
+	ulCommands++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvClearLog( void )
+{
+	taskENTER_CRITICAL();
+	{
+		ulCommands = 0;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvCountCommands( uint8_t ucInstruction, const SPISimCommand_t **ppxFirst )
+{
+uint32_t x, ulCount = 0;
+
+	vSPISimChipSelect();
+
+	if( ppxFirst != NULL )
+	{
+		*ppxFirst = NULL;
+	}
+
+	for( x = 0; ( x < ulCommands ) && ( x < mainMAX_COMMANDS ); x++ )
+	{
+		if( xCommands[ x ].ucInstruction == ucInstruction )
+		{
+			if( ( ulCount == 0UL ) && ( ppxFirst != NULL ) )
+			{
+				*ppxFirst = &( xCommands[ x ] );
+			}
+
+			ulCount++;
+		}
+	}
+
+	return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckNoneRefused( const char *pcTest )
+{
+uint32_t x;
+
+	vSPISimChipSelect();
+
+	for( x = 0; ( x < ulCommands ) && ( x < mainMAX_COMMANDS ); x++ )
+	{
+		if( xCommands[ x ].xRefused != pdFALSE )
+		{
+			printf( "%s: ", pcTest );
+			prvCheck( pdFALSE, "command refused", xCommands[ x ].ucInstruction );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvPattern( uint32_t ulAddress )
+{
+	return ( uint8_t ) ( ( ulAddress * 7UL ) ^ ( ulAddress >> 8 ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFillPattern( uint8_t *pucBuffer, uint32_t ulAddress, uint32_t ulBytes )
+{
+uint32_t x;
+
+	for( x = 0; x < ulBytes; x++ )
+	{
+		pucBuffer[ x ] = prvPattern( ulAddress + x );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvHoldsPattern( const uint8_t *pucBuffer, uint32_t ulAddress, uint32_t ulBytes )
+{
+uint32_t x;
+
+	for( x = 0; x < ulBytes; x++ )
+	{
+		if( pucBuffer[ x ] != prvPattern( ulAddress + x ) )
+		{
+			return pdFALSE;
+		}
+	}
+
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		printf( "Failed %s (%lu)\n", pcCheck, ulValue );
+		xFailed = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
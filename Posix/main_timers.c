@@ -0,0 +1,422 @@
+/*
+	Tests the active timer lists of the timer service on the host build.
+
+	Built with configUSE_TIMER_WHEEL set to 1 it tests the timer wheel, and with
+	configINITIAL_TICK_COUNT set to a little below the largest tick count the
+	timers run across a tick count overflow.
+
+	One shot timers whose periods put them in each level of the wheel, and on
+	both sides of each level boundary, are started together.  Each must expire
+	once, not before its expiry time, and in the order of the expiry times.
+	Auto-reload timers run alongside them, and the expiry time each is reloaded
+	with must always be one period after the one before.
+
+	Before they start, the test task changes the period of a timer so that it
+	expires sooner, stops a timer before it expires, and keeps resetting a
+	timer, each of which must then expire when the command says.  Built with
+	configUSE_TIMER_DIRECT_COMMANDS set to 1 these commands change the active
+	timers directly, and the first has to wake the timer service task, which
+	no other timer would wake in time.
+
+	A timer is also started at a tick count that has passed by the time the
+	timer service task processes the command, so it expires as the command is
+	processed.  Its callback blocks, which it can only do if it is called with
+	the scheduler running.
+
+	The program ends the scheduler once the timers have run, and exits with 0 if
+	every check passed, or 1 after naming those that failed.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "timers.h"
+
+/* Demo application includes. */
+#include "stm32f10x_lib.h"
+
+/* The priority of the task that runs the tests, below that of the timer
+service task, so each command has been processed when it returns. */
+#define mainTEST_TASK_PRIORITY			( tskIDLE_PRIORITY + 1 )
+
+/* The number of ticks a callback may run after the expiry time of its timer.
+The host can deliver the tick late, but the tick count still advances one at a
+time, so this only covers the timer service task being switched in late. */
+#define mainLATENESS_ALLOWED			( ( TickType_t ) 20 )
+
+/* The periods of the auto-reload timers, one in level 0 and one in level 2 of
+a wheel of 16 slot levels. */
+#define mainFAST_RELOAD_PERIOD			( ( TickType_t ) 7 )
+#define mainSLOW_RELOAD_PERIOD			( ( TickType_t ) 300 )
+
+/* How long the start command of the expired timer is held back, in
+nanoseconds, which is several ticks, and how long its callback blocks for. */
+#define mainEXPIRED_HOLD_NS				( 5000000UL )
+#define mainEXPIRED_BLOCK_TIME			( ( TickType_t ) 5 )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Starts the timers, waits for them to run, and checks what they recorded.
+ */
+static void prvTestTask( void *pvParameters );
+
+/*
+ * The callback of the one shot timers, which records the order in which they
+ * expire.
+ */
+static void prvOneShotCallback( TimerHandle_t xTimer );
+
+/*
+ * The callback of the auto-reload timers, which checks each reload.
+ */
+static void prvReloadCallback( TimerHandle_t xTimer );
+
+/*
+ * Issues commands to timers that are already active, and checks they took
+ * effect.
+ */
+static void prvCommandTests( void );
+
+/*
+ * The callback of the timers used by prvCommandTests().
+ */
+static void prvCommandCallback( TimerHandle_t xTimer );
+
+/*
+ * Starts a timer whose expiry time has passed before the command is
+ * processed, and checks its callback could block.
+ */
+static void prvExpiredStartTest( void );
+
+/*
+ * The callback of the timer used by prvExpiredStartTest(), which blocks on an
+ * empty queue.
+ */
+static void prvExpiredCallback( TimerHandle_t xTimer );
+
+/*
+ * Records a failed check.
+ */
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue );
+
+/*-----------------------------------------------------------*/
+
+/* The periods of the one shot timers.  The wheel has 16 slots per level, so
+15/16, 255/256 and 4095/4096 straddle the boundaries between levels.  They
+are started longest first, so the order they expire in is not the order they
+were started in. */
+static const TickType_t xOneShotPeriods[] =
+{
+	5000, 4096, 4095, 2100, 700, 256, 255, 40, 16, 15, 9, 1
+};
+
+#define mainONE_SHOT_TIMERS				( sizeof( xOneShotPeriods ) / sizeof( xOneShotPeriods[ 0 ] ) )
+
+static TimerHandle_t xOneShotTimers[ mainONE_SHOT_TIMERS ];
+
+/* The expiry time of each one shot timer, the tick count each callback ran
+at, and the timers in the order their callbacks ran. */
+static TickType_t xOneShotExpiry[ mainONE_SHOT_TIMERS ];
+static TickType_t xOneShotCalled[ mainONE_SHOT_TIMERS ];
+static UBaseType_t uxOneShotOrder[ mainONE_SHOT_TIMERS ];
+static volatile UBaseType_t uxOneShotsCalled = 0;
+
+/* The auto-reload timers, the expiry time each was last reloaded with, and
+the number of times each has expired. */
+static TimerHandle_t xFastReloadTimer, xSlowReloadTimer;
+static TickType_t xLastFastExpiry, xLastSlowExpiry;
+static volatile uint32_t ulFastReloads = 0, ulSlowReloads = 0;
+
+/* The timers used by prvCommandTests(), the number of times each has
+expired, and the tick count it last expired at. */
+#define mainCHANGE_PERIOD_TIMER			0
+#define mainSTOP_TIMER					1
+#define mainRESET_TIMER					2
+#define mainCOMMAND_TIMERS				3
+
+static TimerHandle_t xCommandTimers[ mainCOMMAND_TIMERS ];
+static volatile uint32_t ulCommandCalls[ mainCOMMAND_TIMERS ];
+static TickType_t xCommandCalled[ mainCOMMAND_TIMERS ];
+
+/* The queue the callback of the expired timer blocks on, which is always
+empty, the number of times the callback ran, the scheduler state it ran with,
+the result of its receive and the number of ticks it blocked for. */
+static QueueHandle_t xExpiredQueue;
+static volatile uint32_t ulExpiredCalls = 0;
+static BaseType_t xExpiredSchedulerState, xExpiredReceived;
+static TickType_t xExpiredBlocked;
+
+/* The tick count the timers were started at. */
+static TickType_t xTestStart;
+
+/* Whether any check failed. */
+static BaseType_t xFailed = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+	debug();
+
+	xTaskCreate( prvTestTask, "Test", configMINIMAL_STACK_SIZE * 2, NULL, mainTEST_TASK_PRIORITY, NULL );
+
+	vTaskStartScheduler();
+
+	if( xFailed == pdFALSE )
+	{
+		printf( "All timer tests passed\n" );
+	}
+
+	return ( xFailed == pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTask( void *pvParameters )
+{
+UBaseType_t ux;
+TickType_t xRunTime, xExpected, xWakeTime;
+
+	( void ) pvParameters;
+
+	prvCommandTests();
+	prvExpiredStartTest();
+
+	/* Start every timer at the same tick count.  The commands are processed
+	once the scheduler is resumed, as the timer service task then runs. */
+	vTaskSuspendAll();
+	{
+		xTestStart = xTaskGetTickCount();
+
+		for( ux = 0; ux < mainONE_SHOT_TIMERS; ux++ )
+		{
+			xOneShotTimers[ ux ] = xTimerCreate( "OneShot", xOneShotPeriods[ ux ], pdFALSE, ( void * ) ( size_t ) ux, prvOneShotCallback );
+			configASSERT( xOneShotTimers[ ux ] );
+			xTimerStart( xOneShotTimers[ ux ], 0 );
+		}
+
+		xFastReloadTimer = xTimerCreate( "Fast", mainFAST_RELOAD_PERIOD, pdTRUE, NULL, prvReloadCallback );
+		xSlowReloadTimer = xTimerCreate( "Slow", mainSLOW_RELOAD_PERIOD, pdTRUE, NULL, prvReloadCallback );
+		configASSERT( xFastReloadTimer );
+		configASSERT( xSlowReloadTimer );
+		xTimerStart( xFastReloadTimer, 0 );
+		xTimerStart( xSlowReloadTimer, 0 );
+
+		/* The timers are started at xTestStart.  Their first expiry times
+		are set here, as the first reload can be reached before this task
+		runs again if the host is slow. */
+		xLastFastExpiry = xTestStart + mainFAST_RELOAD_PERIOD;
+		xLastSlowExpiry = xTestStart + mainSLOW_RELOAD_PERIOD;
+	}
+	xTaskResumeAll();
+
+	for( ux = 0; ux < mainONE_SHOT_TIMERS; ux++ )
+	{
+		xOneShotExpiry[ ux ] = xTimerGetExpiryTime( xOneShotTimers[ ux ] );
+	}
+
+	/* Wait for the longest one shot timer. */
+	xWakeTime = xTestStart;
+	vTaskDelayUntil( &xWakeTime, xOneShotPeriods[ 0 ] + mainLATENESS_ALLOWED );
+
+	xTimerStop( xFastReloadTimer, portMAX_DELAY );
+	xTimerStop( xSlowReloadTimer, portMAX_DELAY );
+	xRunTime = xTaskGetTickCount() - xTestStart;
+
+	/* Every one shot timer expired once, at or soon after its expiry time. */
+	prvCheck( ( uxOneShotsCalled == mainONE_SHOT_TIMERS ) ? pdTRUE : pdFALSE, "one shot callbacks", ( unsigned long ) uxOneShotsCalled );
+
+	for( ux = 0; ux < mainONE_SHOT_TIMERS; ux++ )
+	{
+		prvCheck( ( xOneShotExpiry[ ux ] == ( TickType_t ) ( xTestStart + xOneShotPeriods[ ux ] ) ) ? pdTRUE : pdFALSE, "one shot expiry time", ( unsigned long ) xOneShotPeriods[ ux ] );
+		prvCheck( ( ( TickType_t ) ( xOneShotCalled[ ux ] - xTestStart ) >= xOneShotPeriods[ ux ] ) ? pdTRUE : pdFALSE, "one shot not early", ( unsigned long ) xOneShotPeriods[ ux ] );
+		prvCheck( ( ( TickType_t ) ( xOneShotCalled[ ux ] - xOneShotExpiry[ ux ] ) <= mainLATENESS_ALLOWED ) ? pdTRUE : pdFALSE, "one shot not late", ( unsigned long ) xOneShotPeriods[ ux ] );
+	}
+
+	/* The callbacks ran in the order of the expiry times. */
+	for( ux = 1; ux < uxOneShotsCalled; ux++ )
+	{
+		prvCheck( ( xOneShotPeriods[ uxOneShotOrder[ ux - 1 ] ] <= xOneShotPeriods[ uxOneShotOrder[ ux ] ] ) ? pdTRUE : pdFALSE, "one shot order", ( unsigned long ) xOneShotPeriods[ uxOneShotOrder[ ux ] ] );
+	}
+
+	/* The auto-reload timers expired once a period for as long as they ran.
+	Each reload was checked by the callback. */
+	xExpected = xRunTime / mainFAST_RELOAD_PERIOD;
+	prvCheck( ( ( ulFastReloads + 1UL >= xExpected ) && ( ulFastReloads <= xExpected ) ) ? pdTRUE : pdFALSE, "fast reload count", ( unsigned long ) ulFastReloads );
+	xExpected = xRunTime / mainSLOW_RELOAD_PERIOD;
+	prvCheck( ( ( ulSlowReloads + 1UL >= xExpected ) && ( ulSlowReloads <= xExpected ) ) ? pdTRUE : pdFALSE, "slow reload count", ( unsigned long ) ulSlowReloads );
+
+	/* The tests are only complete if they ran across a tick count overflow. */
+	prvCheck( ( xTaskGetTickCount() < xTestStart ) ? pdTRUE : pdFALSE, "tick count overflowed", ( unsigned long ) xTestStart );
+
+	vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvCommandTests( void )
+{
+UBaseType_t ux;
+TickType_t xCommandTime, xExpiry;
+
+	for( ux = 0; ux < mainCOMMAND_TIMERS; ux++ )
+	{
+		xCommandTimers[ ux ] = xTimerCreate( "Command", pdMS_TO_TICKS( 3000 ), pdFALSE, ( void * ) ( size_t ) ux, prvCommandCallback );
+		configASSERT( xCommandTimers[ ux ] );
+	}
+
+	/* Bring the expiry time of a timer forward, so the timer service task has
+	to process it before the time it is blocked until. */
+	xTimerStart( xCommandTimers[ mainCHANGE_PERIOD_TIMER ], portMAX_DELAY );
+	vTaskDelay( 10 );
+	xCommandTime = xTaskGetTickCount();
+	xTimerChangePeriod( xCommandTimers[ mainCHANGE_PERIOD_TIMER ], 50, portMAX_DELAY );
+	xExpiry = xTimerGetExpiryTime( xCommandTimers[ mainCHANGE_PERIOD_TIMER ] );
+	prvCheck( ( ( TickType_t ) ( xExpiry - xCommandTime ) - 50U <= 1U ) ? pdTRUE : pdFALSE, "change period expiry time", ( unsigned long ) ( xExpiry - xCommandTime ) );
+	vTaskDelay( 50 + mainLATENESS_ALLOWED );
+	prvCheck( ( ulCommandCalls[ mainCHANGE_PERIOD_TIMER ] == 1UL ) ? pdTRUE : pdFALSE, "change period callbacks", ( unsigned long ) ulCommandCalls[ mainCHANGE_PERIOD_TIMER ] );
+	prvCheck( ( ( TickType_t ) ( xCommandCalled[ mainCHANGE_PERIOD_TIMER ] - xExpiry ) <= mainLATENESS_ALLOWED ) ? pdTRUE : pdFALSE, "change period expired on time", ( unsigned long ) ( xCommandCalled[ mainCHANGE_PERIOD_TIMER ] - xExpiry ) );
+
+	/* A timer stopped before its expiry time never expires. */
+	xTimerChangePeriod( xCommandTimers[ mainSTOP_TIMER ], 40, portMAX_DELAY );
+	vTaskDelay( 20 );
+	xTimerStop( xCommandTimers[ mainSTOP_TIMER ], portMAX_DELAY );
+	prvCheck( ( xTimerIsTimerActive( xCommandTimers[ mainSTOP_TIMER ] ) == pdFALSE ) ? pdTRUE : pdFALSE, "stopped timer inactive", 0UL );
+	vTaskDelay( 40 + mainLATENESS_ALLOWED );
+	prvCheck( ( ulCommandCalls[ mainSTOP_TIMER ] == 0UL ) ? pdTRUE : pdFALSE, "stopped timer callbacks", ( unsigned long ) ulCommandCalls[ mainSTOP_TIMER ] );
+
+	/* A timer reset more often than its period only expires one period after
+	the last reset. */
+	xTimerChangePeriod( xCommandTimers[ mainRESET_TIMER ], 30, portMAX_DELAY );
+
+	for( ux = 0; ux < 10; ux++ )
+	{
+		vTaskDelay( 10 );
+		xTimerReset( xCommandTimers[ mainRESET_TIMER ], portMAX_DELAY );
+	}
+
+	xExpiry = xTimerGetExpiryTime( xCommandTimers[ mainRESET_TIMER ] );
+	vTaskDelay( 30 + mainLATENESS_ALLOWED );
+	prvCheck( ( ulCommandCalls[ mainRESET_TIMER ] == 1UL ) ? pdTRUE : pdFALSE, "reset timer callbacks", ( unsigned long ) ulCommandCalls[ mainRESET_TIMER ] );
+	prvCheck( ( ( TickType_t ) ( xCommandCalled[ mainRESET_TIMER ] - xExpiry ) <= mainLATENESS_ALLOWED ) ? pdTRUE : pdFALSE, "reset timer expired on time", ( unsigned long ) ( xCommandCalled[ mainRESET_TIMER ] - xExpiry ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvExpiredStartTest( void )
+{
+TimerHandle_t xTimer;
+uint32_t ulStart;
+
+	xExpiredQueue = xQueueCreate( 1, sizeof( uint32_t ) );
+	xTimer = xTimerCreate( "Expired", 1, pdFALSE, NULL, prvExpiredCallback );
+	configASSERT( xExpiredQueue );
+	configASSERT( xTimer );
+
+	/* With the scheduler suspended the command is queued, with the current
+	tick count as its start time.  The ticks that occur before the scheduler
+	is resumed are added to the tick count before the timer service task runs,
+	so the timer's expiry time has passed when the command is processed. */
+	vTaskSuspendAll();
+	{
+		xTimerStart( xTimer, 0 );
+
+		ulStart = ulGetHostNanoseconds();
+		while( ( ulGetHostNanoseconds() - ulStart ) < mainEXPIRED_HOLD_NS )
+		{
+		}
+	}
+	xTaskResumeAll();
+
+	vTaskDelay( mainEXPIRED_BLOCK_TIME + mainLATENESS_ALLOWED );
+
+	prvCheck( ( ulExpiredCalls == 1UL ) ? pdTRUE : pdFALSE, "expired start callbacks", ( unsigned long ) ulExpiredCalls );
+	prvCheck( ( xExpiredSchedulerState == taskSCHEDULER_RUNNING ) ? pdTRUE : pdFALSE, "expired start callback scheduler running", ( unsigned long ) xExpiredSchedulerState );
+	prvCheck( ( xExpiredReceived == pdFALSE ) ? pdTRUE : pdFALSE, "expired start callback receive", ( unsigned long ) xExpiredReceived );
+	prvCheck( ( xExpiredBlocked >= mainEXPIRED_BLOCK_TIME ) ? pdTRUE : pdFALSE, "expired start callback blocked", ( unsigned long ) xExpiredBlocked );
+	prvCheck( ( xTimerIsTimerActive( xTimer ) == pdFALSE ) ? pdTRUE : pdFALSE, "expired start timer inactive", 0UL );
+
+	xTimerDelete( xTimer, portMAX_DELAY );
+	vQueueDelete( xExpiredQueue );
+}
+/*-----------------------------------------------------------*/
+
+static void prvExpiredCallback( TimerHandle_t xTimer )
+{
+uint32_t ulReceived;
+TickType_t xStart;
+
+	( void ) xTimer;
+
+	ulExpiredCalls++;
+	xExpiredSchedulerState = xTaskGetSchedulerState();
+
+	/* Receiving with a block time asserts if the scheduler is suspended. */
+	xStart = xTaskGetTickCount();
+	xExpiredReceived = xQueueReceive( xExpiredQueue, &ulReceived, mainEXPIRED_BLOCK_TIME );
+	xExpiredBlocked = xTaskGetTickCount() - xStart;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCommandCallback( TimerHandle_t xTimer )
+{
+UBaseType_t ux = ( UBaseType_t ) ( size_t ) pvTimerGetTimerID( xTimer );
+
+	xCommandCalled[ ux ] = xTaskGetTickCount();
+	ulCommandCalls[ ux ]++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvOneShotCallback( TimerHandle_t xTimer )
+{
+UBaseType_t ux = ( UBaseType_t ) ( size_t ) pvTimerGetTimerID( xTimer );
+
+	xOneShotCalled[ ux ] = xTaskGetTickCount();
+
+	if( uxOneShotsCalled < mainONE_SHOT_TIMERS )
+	{
+		uxOneShotOrder[ uxOneShotsCalled ] = ux;
+	}
+
+	uxOneShotsCalled++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReloadCallback( TimerHandle_t xTimer )
+{
+TickType_t xExpiry = xTimerGetExpiryTime( xTimer );
+
+	/* The timer has already been reloaded, with an expiry time one period
+	after the one that has just been reached. */
+	if( xTimer == xFastReloadTimer )
+	{
+		prvCheck( ( ( TickType_t ) ( xExpiry - xLastFastExpiry ) == mainFAST_RELOAD_PERIOD ) ? pdTRUE : pdFALSE, "fast reload period", ( unsigned long ) ( xExpiry - xLastFastExpiry ) );
+		xLastFastExpiry = xExpiry;
+		ulFastReloads++;
+	}
+	else
+	{
+		prvCheck( ( ( TickType_t ) ( xExpiry - xLastSlowExpiry ) == mainSLOW_RELOAD_PERIOD ) ? pdTRUE : pdFALSE, "slow reload period", ( unsigned long ) ( xExpiry - xLastSlowExpiry ) );
+		xLastSlowExpiry = xExpiry;
+		ulSlowReloads++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheck( BaseType_t xPassed, const char *pcCheck, unsigned long ulValue )
+{
+	if( xPassed == pdFALSE )
+	{
+		taskENTER_CRITICAL();
+		{
+			printf( "Failed %s (%lu) at tick %lu\n", pcCheck, ulValue, ( unsigned long ) xTaskGetTickCount() );
+			fflush( stdout );
+		}
+		taskEXIT_CRITICAL();
+
+		xFailed = pdTRUE;
+	}
+}
@@ -0,0 +1,137 @@
+/*
+	SERIAL PORT DRIVER FOR THE HOST BUILD.
+
+	Every port is the standard output of the process, so what the demo writes
+	to USART1 on the target is printed on the host.  Nothing is ever received.
+
+	Output is written from within a critical section.  The tick could
+	otherwise switch out a task while it holds the lock of stdout, and the next
+	task to write would then wait for a thread that is not running.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo application includes. */
+#include "serial.h"
+
+/*-----------------------------------------------------------*/
+
+xComPortHandle xSerialPortInitMinimal( unsigned long ulWantedBaud, unsigned portBASE_TYPE uxQueueLength )
+{
+	( void ) ulWantedBaud;
+	( void ) uxQueueLength;
+
+	return ( xComPortHandle ) stdout;
+}
+/*-----------------------------------------------------------*/
+
+xComPortHandle xSerialPortInit( eCOMPort ePort, eBaud eWantedBaud, eParity eWantedParity, eDataBits eWantedDataBits, eStopBits eWantedStopBits, unsigned portBASE_TYPE uxBufferLength )
+{
+	( void ) ePort;
+	( void ) eWantedBaud;
+	( void ) eWantedParity;
+	( void ) eWantedDataBits;
+	( void ) eWantedStopBits;
+	( void ) uxBufferLength;
+
+	return ( xComPortHandle ) stdout;
+}
+/*-----------------------------------------------------------*/
+
+xComPortHandle xSerialPortInitBaud( eCOMPort ePort, unsigned long ulWantedBaud, unsigned portBASE_TYPE uxBufferLength )
+{
+	( void ) ePort;
+	( void ) ulWantedBaud;
+	( void ) uxBufferLength;
+
+	return ( xComPortHandle ) stdout;
+}
+/*-----------------------------------------------------------*/
+
+void vSerialPutString( xComPortHandle pxPort, const signed char * const pcString, unsigned short usStringLength )
+{
+	( void ) xSerialWrite( pxPort, ( const void * ) pcString, ( size_t ) usStringLength, portMAX_DELAY );
+}
+/*-----------------------------------------------------------*/
+
+signed portBASE_TYPE xSerialGetChar( xComPortHandle pxPort, signed char *pcRxedChar, TickType_t xBlockTime )
+{
+	( void ) pxPort;
+	( void ) pcRxedChar;
+
+	vTaskDelay( xBlockTime );
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+signed portBASE_TYPE xSerialPutChar( xComPortHandle pxPort, signed char cOutChar, TickType_t xBlockTime )
+{
+	return ( signed portBASE_TYPE ) xSerialWrite( pxPort, ( const void * ) &cOutChar, 1, xBlockTime );
+}
+/*-----------------------------------------------------------*/
+
+portBASE_TYPE xSerialWaitForSemaphore( xComPortHandle xPort )
+{
+	( void ) xPort;
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+size_t xSerialWrite( xComPortHandle pxPort, const void *pvBuffer, size_t xLength, TickType_t xBlockTime )
+{
+	( void ) pxPort;
+	( void ) xBlockTime;
+
+	taskENTER_CRITICAL();
+	{
+		xLength = fwrite( pvBuffer, 1, xLength, stdout );
+		fflush( stdout );
+	}
+	taskEXIT_CRITICAL();
+
+	return xLength;
+}
+/*-----------------------------------------------------------*/
+
+size_t xSerialRead( xComPortHandle pxPort, void *pvBuffer, size_t xLength, TickType_t xBlockTime )
+{
+	( void ) pxPort;
+	( void ) pvBuffer;
+	( void ) xLength;
+
+	vTaskDelay( xBlockTime );
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+portBASE_TYPE xSerialSetRxTriggerLevel( xComPortHandle pxPort, size_t xTriggerLevel )
+{
+	( void ) pxPort;
+	( void ) xTriggerLevel;
+
+	/* Nothing is received, so there is nothing to trigger on. */
+	return pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+void vSerialGetStats( xComPortHandle pxPort, SerialStats_t *pxStats )
+{
+	( void ) pxPort;
+
+	memset( ( void * ) pxStats, 0x00, sizeof( SerialStats_t ) );
+}
+/*-----------------------------------------------------------*/
+
+void vSerialClose( xComPortHandle xPort )
+{
+	( void ) xPort;
+}
@@ -0,0 +1,604 @@
+/*
+	SIMULATED SPI1 AND M25P64 FOR THE HOST BUILD.
+
+	Runs SPI1, the DMA channels 2 and 3 that serve it, and an M25P64 on its
+	chip select, PA.4, so spi_flash.c can be tested on the host without
+	changes.  What the FLASH holds is kept by flash_sim.c, which must be
+	opened with spisimFLASH_SIZE bytes.
+
+	The registers are plain RAM, so a write to the data register cannot be
+	seen as it happens.  The functions of stm32f10x_spi.c that spi_flash.c
+	calls are therefore provided here, in place of the library, and
+	SPI_SendData() exchanges the byte with the FLASH at once, leaving the byte
+	received in the data register with RXNE set.  The chip select is read
+	from the GPIOA BSRR and BRR registers, which GPIO_WriteBit() writes, before
+	each byte is exchanged and each tick - a pin set in BSRR deselects the
+	FLASH, and one set in BRR then selects it, so a command must send at least
+	one byte, as each of the driver's does.
+
+	The DMA channels move bytes from vSPISimTick(), called from the tick hook,
+	as many each tick as the SPI clock set by the RCC registers and the baud
+	rate prescaler carries, once both channels are enabled with SPI1 DR as
+	their peripheral and the DMA requests of SPI1 are enabled.  At the end of
+	a transfer the transfer complete flags of both channels are raised, and
+	DMAChannel2_IRQHandler() called if the interrupt of channel 2 is enabled.
+	The flags written to IFCR, by the handler or DMA_DeInit(), are cleared
+	once it returns and before each tick's bytes are moved.
+
+	The FLASH carries out the instructions of spi_sim.h as the M25P64 does:
+
+	+ WREN sets the write enable latch, and WRITE, SE and BE are refused
+	  unless it is set, and clear it;
+
+	+ a page program wraps to the start of its page, and programming can only
+	  clear bits;
+
+	+ once a page program or erase has started the FLASH stays busy, with WIP
+	  set in the status register, for the time set by vSPISimSetBusyTime(),
+	  and refuses every instruction but RDSR until it has ended.  Time moves
+	  on by a tick each tick, and by the time each byte exchanged by
+	  SPI_SendData() takes on the bus, so a driver that polls the status
+	  register without the scheduler running still sees the operation end;
+
+	+ READ and FAST_READ return successive bytes from the address sent,
+	  wrapping at the end of the FLASH, FAST_READ after a dummy byte.
+
+	Each command is passed to the function connected by vSPISimConnect() once
+	the FLASH is deselected, which is seen at the next byte or tick, or when
+	vSPISimChipSelect() is called.  Only the master, full duplex, 8 bit transfers
+	the driver uses are supported.
+*/
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Library includes. */
+#include "stm32f10x_lib.h"
+
+/* Demo application includes. */
+#include "flash_sim.h"
+#include "spi_sim.h"
+
+/* Bits of the SPI CR1, CR2 and SR registers. */
+#define simCR1_CLEAR_MASK		( ( u16 ) 0x3040 )
+#define simCR1_SPE				( ( u16 ) 0x0040 )
+#define simCR1_BR_SHIFT			3
+#define simCR1_BR_MASK			( ( u16 ) 0x0007 )
+#define simCR2_DMA				( ( u16 ) ( SPI_DMAReq_Rx | SPI_DMAReq_Tx ) )
+
+/* Bits of the DMA channel CCR register. */
+#define simCCR_EN				( ( u32 ) 0x0001 )
+#define simCCR_TCIE				( ( u32 ) 0x0002 )
+#define simCCR_DIR				( ( u32 ) 0x0010 )
+#define simCCR_MINC				( ( u32 ) 0x0080 )
+
+/* The flags of one channel in the DMA ISR register, shifted by four bits for
+each channel. */
+#define simISR_GIF				( ( u32 ) 0x0001 )
+#define simISR_TCIF				( ( u32 ) 0x0002 )
+#define simISR_CHANNEL_FLAGS	( ( u32 ) 0x000F )
+#define simDMA_CHANNELS			7
+
+/* The shifts of the flags of the Rx and Tx channels. */
+#define simRX_SHIFT				4U
+#define simTX_SHIFT				8U
+
+/* The chip select of the FLASH. */
+#define simCS_PIN				GPIO_Pin_4
+
+/* Bits of the FLASH status register. */
+#define simSR_WIP				( ( uint8_t ) 0x01 )
+#define simSR_WEL				( ( uint8_t ) 0x02 )
+
+/* The bits of one byte on the bus. */
+#define simBITS_PER_BYTE		8UL
+
+#define simNANOSECONDS_PER_TICK	( 1000000000ULL / configTICK_RATE_HZ )
+
+/*-----------------------------------------------------------*/
+
+/* The handler of the DMA interrupt, which the polled driver does not
+define. */
+extern void DMAChannel2_IRQHandler( void ) __attribute__( ( weak ) );
+
+/*
+ * Selects or deselects the FLASH as the chip select has been driven since it
+ * was last read.
+ */
+static void prvChipSelect( void );
+
+/*
+ * Starts and ends a command.
+ */
+static void prvSelect( void );
+static void prvDeselect( void );
+
+/*
+ * Exchanges one byte with the FLASH, returning the byte it sends back.
+ */
+static uint8_t prvExchange( uint8_t ucOut );
+
+/*
+ * Returns the status register of the FLASH.
+ */
+static uint8_t prvStatus( void );
+
+/*
+ * Returns pdTRUE while a page program or erase has not ended.
+ */
+static BaseType_t prvBusy( void );
+
+/*
+ * Clears the DMA flags written to IFCR.
+ */
+static void prvClearFlags( void );
+
+/*
+ * Returns the address of the byte the current transfer of pxChannel is at,
+ * for a transfer that started with ulCount bytes.
+ */
+static uint8_t *prvDMAAddress( DMA_Channel_TypeDef *pxChannel, u32 ulCount );
+
+/*-----------------------------------------------------------*/
+
+/* The command in progress, and the bytes sent since it started. */
+static BaseType_t xSelected = pdFALSE;
+static SPISimCommand_t xCommand;
+static uint32_t ulCommandBytes = 0;
+
+/* The address the next byte is read from. */
+static uint32_t ulReadAddress = 0;
+
+/* The page being programmed, 0xFF where no byte has been written. */
+static uint8_t ucPage[ flashsimPAGE_SIZE ];
+
+/* The write enable latch. */
+static uint8_t ucWriteEnabled = 0;
+
+/* The time, and when the operation in progress ends, in nanoseconds. */
+static uint64_t ullTime = 0;
+static uint64_t ullBusyUntil = 0;
+static uint64_t ullProgramTime = 1400000ULL;
+static uint64_t ullEraseTime = 1000000000ULL;
+
+/* The SPI clock set by SPI_Init(), in Hz. */
+static uint32_t ulClock = 0;
+
+/* The state of the DMA transfer, which the registers do not hold. */
+static BaseType_t xTransferActive = pdFALSE;
+static u32 ulRxCount = 0;
+static u32 ulTxCount = 0;
+static BaseType_t xHoldDMA = pdFALSE;
+static uint32_t ulTransfers = 0;
+static uint32_t ulInterrupts = 0;
+
+static SPISimCommandFunction_t pxCommandFunction = NULL;
+
+/*-----------------------------------------------------------*/
+
+void vSPISimConnect( SPISimCommandFunction_t pxFunction )
+{
+	taskENTER_CRITICAL();
+	{
+		pxCommandFunction = pxFunction;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vSPISimSetBusyTime( uint32_t ulProgramMicroseconds, uint32_t ulEraseMicroseconds )
+{
+	taskENTER_CRITICAL();
+	{
+		ullProgramTime = ( uint64_t ) ulProgramMicroseconds * 1000ULL;
+		ullEraseTime = ( uint64_t ) ulEraseMicroseconds * 1000ULL;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vSPISimHoldDMA( BaseType_t xHold )
+{
+	xHoldDMA = xHold;
+}
+/*-----------------------------------------------------------*/
+
+void vSPISimChipSelect( void )
+{
+	taskENTER_CRITICAL();
+	{
+		prvChipSelect();
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulSPISimTransfers( void )
+{
+uint32_t ulReturn;
+
+	taskENTER_CRITICAL();
+	{
+		ulReturn = ulTransfers;
+	}
+	taskEXIT_CRITICAL();
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulSPISimInterrupts( void )
+{
+uint32_t ulReturn;
+
+	taskENTER_CRITICAL();
+	{
+		ulReturn = ulInterrupts;
+	}
+	taskEXIT_CRITICAL();
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vSPISimTick( void )
+{
+DMA_Channel_TypeDef * const pxRx = DMA_Channel2;
+DMA_Channel_TypeDef * const pxTx = DMA_Channel3;
+const u32 ulDataRegister = ( u32 ) ( uintptr_t ) &( SPI1->DR );
+uint32_t ulBytes;
+uint8_t ucIn;
+
+	prvClearFlags();
+	ullTime += simNANOSECONDS_PER_TICK;
+	prvChipSelect();
+
+	if( ( pxRx->CCR & simCCR_EN ) == 0 )
+	{
+		/* A transfer ends when the channel is disabled. */
+		xTransferActive = pdFALSE;
+	}
+
+	if( ( xHoldDMA != pdFALSE ) || ( xSelected == pdFALSE ) || ( ( SPI1->CR2 & simCR2_DMA ) != simCR2_DMA ) ||
+		( ( pxRx->CCR & ( simCCR_EN | simCCR_DIR ) ) != simCCR_EN ) || ( pxRx->CPAR != ulDataRegister ) ||
+		( ( pxTx->CCR & ( simCCR_EN | simCCR_DIR ) ) != ( simCCR_EN | simCCR_DIR ) ) || ( pxTx->CPAR != ulDataRegister ) )
+	{
+		return;
+	}
+
+	if( xTransferActive == pdFALSE )
+	{
+		if( pxRx->CNDTR == 0 )
+		{
+			return;
+		}
+
+		/* Both channels have been enabled with a new count since the last
+		transfer ended. */
+		xTransferActive = pdTRUE;
+		ulRxCount = pxRx->CNDTR;
+		ulTxCount = pxTx->CNDTR;
+		ulTransfers++;
+	}
+
+	for( ulBytes = ulClock / ( simBITS_PER_BYTE * configTICK_RATE_HZ ); ( ulBytes > 0UL ) && ( pxRx->CNDTR != 0 ); ulBytes-- )
+	{
+		configASSERT( pxTx->CNDTR != 0 );
+
+		ucIn = prvExchange( *prvDMAAddress( pxTx, ulTxCount ) );
+		*prvDMAAddress( pxRx, ulRxCount ) = ucIn;
+		xCommand.ulDMABytes++;
+		pxTx->CNDTR--;
+		pxRx->CNDTR--;
+	}
+
+	if( pxRx->CNDTR == 0 )
+	{
+		xTransferActive = pdFALSE;
+		DMA->ISR |= ( ( simISR_TCIF | simISR_GIF ) << simRX_SHIFT ) | ( ( simISR_TCIF | simISR_GIF ) << simTX_SHIFT );
+
+		if( ( ( pxRx->CCR & simCCR_TCIE ) != 0 ) && ( DMAChannel2_IRQHandler != NULL ) )
+		{
+			ulInterrupts++;
+			DMAChannel2_IRQHandler();
+			prvClearFlags();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void SPI_Init( SPI_TypeDef *SPIx, SPI_InitTypeDef *SPI_InitStruct )
+{
+RCC_ClocksTypeDef xClocks;
+u16 usCR1;
+
+	configASSERT( SPIx == SPI1 );
+
+	/* As the library does. */
+	usCR1 = SPIx->CR1 & simCR1_CLEAR_MASK;
+	usCR1 |= ( u16 ) ( ( u32 ) SPI_InitStruct->SPI_Direction | SPI_InitStruct->SPI_Mode |
+						SPI_InitStruct->SPI_DataSize | SPI_InitStruct->SPI_CPOL |
+						SPI_InitStruct->SPI_CPHA | SPI_InitStruct->SPI_NSS |
+						SPI_InitStruct->SPI_BaudRatePrescaler | SPI_InitStruct->SPI_FirstBit );
+	SPIx->CR1 = usCR1;
+	SPIx->CRCPR = SPI_InitStruct->SPI_CRCPolynomial;
+
+	/* SPI1 is clocked by PCLK2, divided by 2 to the power BR + 1. */
+	RCC_GetClocksFreq( &xClocks );
+	ulClock = xClocks.PCLK2_Frequency >> ( ( ( usCR1 >> simCR1_BR_SHIFT ) & simCR1_BR_MASK ) + 1U );
+}
+/*-----------------------------------------------------------*/
+
+void SPI_Cmd( SPI_TypeDef *SPIx, FunctionalState NewState )
+{
+	if( NewState != DISABLE )
+	{
+		SPIx->CR1 |= simCR1_SPE;
+		SPIx->SR |= SPI_FLAG_TXE;
+	}
+	else
+	{
+		SPIx->CR1 &= ( u16 ) ~simCR1_SPE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void SPI_DMACmd( SPI_TypeDef *SPIx, u16 SPI_DMAReq, FunctionalState NewState )
+{
+	if( NewState != DISABLE )
+	{
+		SPIx->CR2 |= SPI_DMAReq;
+	}
+	else
+	{
+		SPIx->CR2 &= ( u16 ) ~SPI_DMAReq;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void SPI_SendData( SPI_TypeDef *SPIx, u16 Data )
+{
+	configASSERT( ( SPIx == SPI1 ) && ( ( SPIx->CR1 & simCR1_SPE ) != 0 ) && ( ulClock != 0UL ) );
+
+	/* The tick must not move bytes part way through this one. */
+	taskENTER_CRITICAL();
+	{
+		prvChipSelect();
+		SPIx->DR = prvExchange( ( uint8_t ) Data );
+		SPIx->SR |= SPI_FLAG_RXNE;
+		ullTime += ( simBITS_PER_BYTE * 1000000000ULL ) / ulClock;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+u16 SPI_ReceiveData( SPI_TypeDef *SPIx )
+{
+	/* Reading the data register clears RXNE. */
+	SPIx->SR &= ( u16 ) ~SPI_FLAG_RXNE;
+
+	return SPIx->DR;
+}
+/*-----------------------------------------------------------*/
+
+FlagStatus SPI_GetFlagStatus( SPI_TypeDef *SPIx, u16 SPI_FLAG )
+{
+	return ( ( SPIx->SR & SPI_FLAG ) != 0 ) ? SET : RESET;
+}
+/*-----------------------------------------------------------*/
+
+static void prvChipSelect( void )
+{
+	if( ( GPIOA->BSRR & simCS_PIN ) != 0 )
+	{
+		GPIOA->BSRR &= ~( u32 ) simCS_PIN;
+
+		if( xSelected != pdFALSE )
+		{
+			prvDeselect();
+		}
+	}
+
+	if( ( GPIOA->BRR & simCS_PIN ) != 0 )
+	{
+		GPIOA->BRR &= ~( u32 ) simCS_PIN;
+		prvSelect();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSelect( void )
+{
+	xSelected = pdTRUE;
+	ulCommandBytes = 0;
+	memset( ( void * ) &xCommand, 0x00, sizeof( xCommand ) );
+	memset( ( void * ) ucPage, 0xff, sizeof( ucPage ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDeselect( void )
+{
+uint32_t ulSector;
+
+	xSelected = pdFALSE;
+
+	if( ulCommandBytes == 0UL )
+	{
+		return;
+	}
+
+	if( ( xCommand.ucInstruction == spisimWRITE ) || ( xCommand.ucInstruction == spisimSE ) || ( xCommand.ucInstruction == spisimBE ) )
+	{
+		if( ( ucWriteEnabled == 0 ) || ( ( xCommand.ucInstruction != spisimBE ) && ( ulCommandBytes < 4UL ) ) )
+		{
+			xCommand.xRefused = pdTRUE;
+		}
+	}
+
+	if( xCommand.xRefused == pdFALSE )
+	{
+		switch( xCommand.ucInstruction )
+		{
+			case spisimWREN:
+				ucWriteEnabled = 1;
+				break;
+
+			case spisimWRITE:
+				vFlashSimProgram( xCommand.ulAddress & ~( flashsimPAGE_SIZE - 1UL ), ucPage, flashsimPAGE_SIZE );
+				ullBusyUntil = ullTime + ullProgramTime;
+				ucWriteEnabled = 0;
+				break;
+
+			case spisimSE:
+				vFlashSimEraseSector( xCommand.ulAddress );
+				ullBusyUntil = ullTime + ullEraseTime;
+				ucWriteEnabled = 0;
+				break;
+
+			case spisimBE:
+				for( ulSector = 0; ulSector < spisimFLASH_SIZE; ulSector += flashsimSECTOR_SIZE )
+				{
+					vFlashSimEraseSector( ulSector );
+				}
+
+				ullBusyUntil = ullTime + ullEraseTime;
+				ucWriteEnabled = 0;
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	if( pxCommandFunction != NULL )
+	{
+		pxCommandFunction( &xCommand );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvExchange( uint8_t ucOut )
+{
+const uint32_t ulIndex = ulCommandBytes;
+uint8_t ucIn = 0xff;
+
+	if( xSelected == pdFALSE )
+	{
+		/* Nothing drives MISO. */
+		return ucIn;
+	}
+
+	ulCommandBytes++;
+
+	if( ulIndex == 0UL )
+	{
+		xCommand.ucInstruction = ucOut;
+		xCommand.xStartTick = xTaskGetTickCount();
+		xCommand.xRefused = ( ( prvBusy() != pdFALSE ) && ( ucOut != spisimRDSR ) ) ? pdTRUE : pdFALSE;
+
+		return ucIn;
+	}
+
+	switch( xCommand.ucInstruction )
+	{
+		case spisimRDSR:
+			xCommand.ulBytes++;
+			ucIn = prvStatus();
+			break;
+
+		case spisimRDID:
+			if( ulIndex <= 3UL )
+			{
+				ucIn = ( uint8_t ) ( spisimID >> ( 8UL * ( 3UL - ulIndex ) ) );
+			}
+			break;
+
+		case spisimREAD:
+		case spisimFAST_READ:
+		case spisimWRITE:
+		case spisimSE:
+			if( ulIndex <= 3UL )
+			{
+				/* The address, most significant byte first. */
+				xCommand.ulAddress = ( ( xCommand.ulAddress << 8 ) | ucOut ) & ( spisimFLASH_SIZE - 1UL );
+				ulReadAddress = xCommand.ulAddress;
+			}
+			else if( ( xCommand.ucInstruction == spisimFAST_READ ) && ( ulIndex == 4UL ) )
+			{
+				/* The dummy byte. */
+			}
+			else
+			{
+				xCommand.ulBytes++;
+
+				if( xCommand.xRefused != pdFALSE )
+				{
+					/* Ignored. */
+				}
+				else if( xCommand.ucInstruction == spisimWRITE )
+				{
+					ucPage[ ( xCommand.ulAddress + xCommand.ulBytes - 1UL ) % flashsimPAGE_SIZE ] = ucOut;
+				}
+				else if( xCommand.ucInstruction != spisimSE )
+				{
+					vFlashSimRead( ulReadAddress, &ucIn, 1UL );
+					ulReadAddress = ( ulReadAddress + 1UL ) & ( spisimFLASH_SIZE - 1UL );
+				}
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	return ucIn;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvStatus( void )
+{
+	return ( ( prvBusy() != pdFALSE ) ? simSR_WIP : 0 ) | ( ( ucWriteEnabled != 0 ) ? simSR_WEL : 0 );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvBusy( void )
+{
+	return ( ullTime < ullBusyUntil ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvClearFlags( void )
+{
+unsigned int uxShift;
+
+	/* Clearing the global flag of a channel clears each of its flags. */
+	for( uxShift = 0; uxShift < ( simDMA_CHANNELS * 4U ); uxShift += 4U )
+	{
+		if( ( DMA->IFCR & ( simISR_GIF << uxShift ) ) != 0 )
+		{
+			DMA->ISR &= ~( simISR_CHANNEL_FLAGS << uxShift );
+		}
+	}
+
+	DMA->ISR &= ~( DMA->IFCR );
+	DMA->IFCR = 0;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t *prvDMAAddress( DMA_Channel_TypeDef *pxChannel, u32 ulCount )
+{
+u32 ulOffset = 0;
+
+	if( ( pxChannel->CCR & simCCR_MINC ) != 0 )
+	{
+		ulOffset = ulCount - pxChannel->CNDTR;
+	}
+
+	return ( uint8_t * ) ( uintptr_t ) ( pxChannel->CMAR + ulOffset );
+}
+/*-----------------------------------------------------------*/
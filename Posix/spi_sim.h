@@ -0,0 +1,76 @@
+/*
+	Simulated SPI1 and M25P64 for the host build.  See spi_sim.c.
+*/
+
+#ifndef SPI_SIM_H
+#define SPI_SIM_H
+
+/* The size of the M25P64, which flash_sim.c must be opened with. */
+#define spisimFLASH_SIZE			0x800000UL
+
+/* The instructions the simulated M25P64 carries out. */
+#define spisimWRITE					0x02
+#define spisimREAD					0x03
+#define spisimRDSR					0x05
+#define spisimWREN					0x06
+#define spisimFAST_READ				0x0B
+#define spisimRDID					0x9F
+#define spisimBE					0xC7
+#define spisimSE					0xD8
+
+/* The identification returned by RDID. */
+#define spisimID					0x202017UL
+
+/* A command, from the FLASH being selected to it being deselected. */
+typedef struct SPI_SIM_COMMAND
+{
+	uint8_t ucInstruction;
+	uint32_t ulAddress;				/* For the instructions that take one. */
+	uint32_t ulBytes;				/* Read or written after the instruction, address and dummy byte. */
+	uint32_t ulDMABytes;			/* Of ulBytes, those moved by the DMA channels. */
+	TickType_t xStartTick;			/* The tick count when the instruction was sent. */
+	BaseType_t xRefused;			/* pdTRUE if the FLASH was busy, or a write was not enabled. */
+} SPISimCommand_t;
+
+/* The function each command is passed to once the FLASH is deselected. */
+typedef void ( *SPISimCommandFunction_t )( const SPISimCommand_t *pxCommand );
+
+/*
+ * Passes each command to pxCommandFunction, which can be NULL.
+ */
+void vSPISimConnect( SPISimCommandFunction_t pxCommandFunction );
+
+/*
+ * Sets how long the FLASH stays busy after a page program and after an
+ * erase, in microseconds.  The defaults are the typical times of the M25P64,
+ * 1.4ms and 1s.
+ */
+void vSPISimSetBusyTime( uint32_t ulProgramMicroseconds, uint32_t ulEraseMicroseconds );
+
+/*
+ * Stops the DMA channels moving bytes while xHold is pdTRUE, so a transfer
+ * never ends.
+ */
+void vSPISimHoldDMA( BaseType_t xHold );
+
+/*
+ * Moves one tick's worth of bytes on the DMA channels that serve SPI1, at the
+ * SPI clock, and runs the DMA interrupt when a transfer ends.  Called from
+ * the tick hook.
+ */
+void vSPISimTick( void );
+
+/*
+ * Reads the chip select, so a command the FLASH has been deselected from ends,
+ * and is passed to the connected function, now rather than at the next byte
+ * or tick.
+ */
+void vSPISimChipSelect( void );
+
+/*
+ * The DMA transfers started on SPI1, and the interrupts taken at their ends.
+ */
+uint32_t ulSPISimTransfers( void );
+uint32_t ulSPISimInterrupts( void );
+
+#endif /* SPI_SIM_H */
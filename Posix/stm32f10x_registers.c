@@ -0,0 +1,114 @@
+/*
+	The peripheral registers of the STM32F103 for the host build.
+
+	The host build compiles the ST library with DEBUG defined, which makes each
+	peripheral a pointer that debug() sets before the peripheral is used, as
+	ST intended for debugging on the target.  Here debug() maps blocks of RAM
+	at the addresses the registers have on the target, and points the
+	peripherals at them, so drivers that name a peripheral by its base address
+	- as serial/serial.c does - use the same RAM as those that use the library
+	pointers.  A value written to a register is read back, and nothing else
+	happens, so the code that only configures a peripheral - as led.c does the
+	GPIO pins - runs unchanged, while code that waits for the hardware to set a
+	flag never returns.  usart_sim.c makes the USARTs, and the DMA channels
+	that serve them, move data.
+*/
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+/* Define the peripheral pointers here rather than declare them. */
+#define EXT
+
+/* Library includes. */
+#include "stm32f10x_lib.h"
+
+/* Scheduler includes, for vAssertCalled(). */
+#include "FreeRTOS.h"
+
+/* The peripherals on the APB1, APB2 and AHB buses, up to the end of the FLASH
+interface, and the Cortex-M3 system control space. */
+#define regPERIPHERALS_SIZE		( ( size_t ) 0x24000 )
+#define regSCS_SIZE				( ( size_t ) 0x1000 )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Maps xSize bytes of zeroed RAM at ulAddress, which must be free.
+ */
+static void prvMapRegisters( u32 ulAddress, size_t xSize );
+
+/*-----------------------------------------------------------*/
+
+void debug( void )
+{
+	/* The program is linked at a fixed address below both blocks, so they
+	are free. */
+	prvMapRegisters( PERIPH_BASE, regPERIPHERALS_SIZE );
+	prvMapRegisters( SCS_BASE, regSCS_SIZE );
+
+	ADC1 = ( ADC_TypeDef * ) ADC1_BASE;
+	AFIO = ( AFIO_TypeDef * ) AFIO_BASE;
+	DMA = ( DMA_TypeDef * ) DMA_BASE;
+	DMA_Channel1 = ( DMA_Channel_TypeDef * ) DMA_Channel1_BASE;
+	DMA_Channel2 = ( DMA_Channel_TypeDef * ) DMA_Channel2_BASE;
+	DMA_Channel3 = ( DMA_Channel_TypeDef * ) DMA_Channel3_BASE;
+	DMA_Channel4 = ( DMA_Channel_TypeDef * ) DMA_Channel4_BASE;
+	DMA_Channel5 = ( DMA_Channel_TypeDef * ) DMA_Channel5_BASE;
+	DMA_Channel6 = ( DMA_Channel_TypeDef * ) DMA_Channel6_BASE;
+	DMA_Channel7 = ( DMA_Channel_TypeDef * ) DMA_Channel7_BASE;
+	EXTI = ( EXTI_TypeDef * ) EXTI_BASE;
+	GPIOA = ( GPIO_TypeDef * ) GPIOA_BASE;
+	GPIOB = ( GPIO_TypeDef * ) GPIOB_BASE;
+	GPIOC = ( GPIO_TypeDef * ) GPIOC_BASE;
+	GPIOD = ( GPIO_TypeDef * ) GPIOD_BASE;
+	GPIOE = ( GPIO_TypeDef * ) GPIOE_BASE;
+	NVIC = ( NVIC_TypeDef * ) NVIC_BASE;
+	RCC = ( RCC_TypeDef * ) RCC_BASE;
+	SCB = ( SCB_TypeDef * ) SCB_BASE;
+	SPI1 = ( SPI_TypeDef * ) SPI1_BASE;
+	SPI2 = ( SPI_TypeDef * ) SPI2_BASE;
+	SysTick = ( SysTick_TypeDef * ) SysTick_BASE;
+	TIM2 = ( TIM_TypeDef * ) TIM2_BASE;
+	TIM3 = ( TIM_TypeDef * ) TIM3_BASE;
+	TIM4 = ( TIM_TypeDef * ) TIM4_BASE;
+	USART1 = ( USART_TypeDef * ) USART1_BASE;
+	USART2 = ( USART_TypeDef * ) USART2_BASE;
+	USART3 = ( USART_TypeDef * ) USART3_BASE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvMapRegisters( u32 ulAddress, size_t xSize )
+{
+void *pvMapped;
+
+	pvMapped = mmap( ( void * ) ( uintptr_t ) ulAddress, xSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0 );
+
+	if( pvMapped != ( void * ) ( uintptr_t ) ulAddress )
+	{
+		fprintf( stderr, "The registers at 0x%08lx could not be mapped\n", ( unsigned long ) ulAddress );
+		exit( EXIT_FAILURE );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* The core register accessors of cortexm3_macro.s, which the NVIC functions of
+the library call.  Interrupts are masked with the critical sections of the
+port, so these only hold the value written. */
+static u32 ulBASEPRI = 0;
+
+void __SETPRIMASK( void ) {}
+void __RESETPRIMASK( void ) {}
+void __SETFAULTMASK( void ) {}
+void __RESETFAULTMASK( void ) {}
+void __BASEPRICONFIG( u32 NewPriority ) { ulBASEPRI = NewPriority; }
+u32 __GetBASEPRI( void ) { return ulBASEPRI; }
+/*-----------------------------------------------------------*/
+
+void assert_failed( u8 *file, u32 line )
+{
+	/* A parameter check of the library failed. */
+	vAssertCalled( ( const char * ) file, ( unsigned long ) line );
+}
@@ -0,0 +1,492 @@
+/*
+	SIMULATED USARTS FOR THE HOST BUILD.
+
+	Runs the USARTs, and the DMA channels that move data to and from their data
+	registers, in the RAM that stm32f10x_registers.c maps at the register
+	addresses, so serial/serial.c can be tested and benchmarked on the host
+	without changes.  vUSARTSimTick() is called from the tick hook, and moves as
+	many characters as each USART can carry in one tick at the baud rate its
+	BRR register is set to, with ten bits to a character.
+
+	A character is taken from whichever the USART is set up to transmit from:
+
+	+ the DMA channel that writes to its data register, when the Tx DMA request
+	  is enabled in CR3 - the count is decremented, and the half transfer and
+	  transfer complete flags and interrupts of the channel raised, as the
+	  channel would, and a channel that is not circular stops when its count
+	  reaches 0; or
+
+	+ the USART interrupt, when TXEIE is set - the handler is called with TXE
+	  set, and a character it writes to the data register is sent.  TXE is
+	  clear at any other time, as the character being sent fills the data
+	  register.
+
+	A character received, when the transmitter is looped back to the receiver,
+	goes to the DMA channel that reads the data register if the Rx DMA request
+	is enabled, or to the data register with RXNE set and the interrupt
+	called.  When the line goes quiet after a character has been received the
+	idle line flag and interrupt are raised.
+
+	The registers are plain RAM, so a read does not clear a flag as it would on
+	the target.  Instead a flag raised to call a handler is cleared when the
+	handler returns, the DMA flags written to IFCR are cleared from ISR, and a
+	write to the data register is detected by the value left in it.
+
+	Only 8 bit transfers are supported, and the interrupts are called whether
+	or not they are enabled in the NVIC.
+*/
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stddef.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Library includes. */
+#include "stm32f10x_lib.h"
+
+/* Demo application includes. */
+#include "usart_sim.h"
+
+/* Bits of the USART CR1 and CR3 registers. */
+#define simCR1_UE				( ( u16 ) 0x2000 )
+#define simCR1_TXEIE			( ( u16 ) 0x0080 )
+#define simCR1_RXNEIE			( ( u16 ) 0x0020 )
+#define simCR1_IDLEIE			( ( u16 ) 0x0010 )
+#define simCR1_RE				( ( u16 ) 0x0004 )
+#define simCR3_DMAT				( ( u16 ) 0x0080 )
+#define simCR3_DMAR				( ( u16 ) 0x0040 )
+#define simCR3_EIE				( ( u16 ) 0x0001 )
+
+/* Bits of the DMA channel CCR register. */
+#define simCCR_EN				( ( u32 ) 0x0001 )
+#define simCCR_TCIE				( ( u32 ) 0x0002 )
+#define simCCR_HTIE				( ( u32 ) 0x0004 )
+#define simCCR_DIR				( ( u32 ) 0x0010 )
+#define simCCR_CIRC				( ( u32 ) 0x0020 )
+#define simCCR_MINC				( ( u32 ) 0x0080 )
+
+/* The flags of one channel in the DMA ISR register, shifted by four bits for
+each channel. */
+#define simISR_GIF				( ( u32 ) 0x0001 )
+#define simISR_TCIF				( ( u32 ) 0x0002 )
+#define simISR_HTIF				( ( u32 ) 0x0004 )
+
+/* The bits of one character on the line - start, 8 data and stop. */
+#define simBITS_PER_CHAR		10UL
+
+/* A value the data register cannot hold, left in it to detect a write. */
+#define simDR_UNWRITTEN			( ( u16 ) 0xFFFF )
+
+#define simUSARTS				3
+#define simDMA_CHANNELS			7
+
+/*-----------------------------------------------------------*/
+
+/* A simulated USART. */
+typedef struct USART_SIM
+{
+	USART_TypeDef *pxUSART;
+	void ( *pxHandler )( void );		/* The interrupt handler, or NULL. */
+	BaseType_t xOnAPB2;					/* pdTRUE if the USART is clocked by PCLK2 rather than PCLK1. */
+	USARTSimTxFunction_t pxTxFunction;
+	BaseType_t xLoopBack;
+	unsigned long ulBits;				/* Bits the line can still carry this tick. */
+	BaseType_t xRxSinceIdle;			/* pdTRUE if a character has been received since the line was last idle. */
+	unsigned long ulInterrupts;
+} USARTSim_t;
+
+/* The state of a DMA channel that the registers do not hold. */
+typedef struct DMA_CHANNEL_SIM
+{
+	void ( *pxHandler )( void );		/* The interrupt handler, or NULL. */
+	BaseType_t xActive;					/* pdTRUE between a transfer starting and ending. */
+	u32 ulCount;						/* The count the transfer started with. */
+} DMAChannelSim_t;
+
+/*-----------------------------------------------------------*/
+
+/* The handlers of the interrupts the simulation raises.  Those the program
+does not define are NULL. */
+extern void vUARTInterruptHandler( void ) __attribute__( ( weak ) );
+extern void USART2_IRQHandler( void ) __attribute__( ( weak ) );
+extern void USART3_IRQHandler( void ) __attribute__( ( weak ) );
+extern void DMAChannel1_IRQHandler( void ) __attribute__( ( weak ) );
+extern void DMAChannel2_IRQHandler( void ) __attribute__( ( weak ) );
+extern void DMAChannel3_IRQHandler( void ) __attribute__( ( weak ) );
+extern void DMAChannel4_IRQHandler( void ) __attribute__( ( weak ) );
+extern void DMAChannel5_IRQHandler( void ) __attribute__( ( weak ) );
+extern void DMAChannel6_IRQHandler( void ) __attribute__( ( weak ) );
+extern void DMAChannel7_IRQHandler( void ) __attribute__( ( weak ) );
+
+/*
+ * Returns the simulation of pxUSART.
+ */
+static USARTSim_t *prvGetUSART( USART_TypeDef *pxUSART );
+
+/*
+ * Returns the enabled DMA channel that serves pxSim in the direction
+ * ulDirection (simCCR_DIR to the USART, 0 from it), and starts a transfer on
+ * it if one has been set up, or returns -1.
+ */
+static int prvGetDMAChannel( USARTSim_t *pxSim, u32 ulDirection );
+
+/*
+ * Returns the address of the byte the current transfer of a channel is at.
+ */
+static unsigned char *prvDMAAddress( int iChannel );
+
+/*
+ * Counts one byte moved by a channel, and raises the flags and interrupt that
+ * follow.
+ */
+static void prvDMAByteMoved( USARTSim_t *pxSim, int iChannel );
+
+/*
+ * Returns the next character pxSim transmits, or -1 if it has none.
+ */
+static int prvTransmit( USARTSim_t *pxSim );
+
+/*
+ * Receives one character on pxSim.
+ */
+static void prvReceive( USARTSim_t *pxSim, unsigned char ucChar );
+
+/*
+ * Calls the interrupt handler of pxSim, or of one of its DMA channels.
+ */
+static void prvCallHandler( USARTSim_t *pxSim, void ( *pxHandler )( void ) );
+
+/*-----------------------------------------------------------*/
+
+static USARTSim_t xUSARTs[ simUSARTS ];
+static DMAChannelSim_t xDMAChannels[ simDMA_CHANNELS ];
+static DMA_Channel_TypeDef *pxDMAChannelRegisters[ simDMA_CHANNELS ];
+static BaseType_t xInitialised = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+void vUSARTSimConnect( USART_TypeDef *pxUSART, USARTSimTxFunction_t pxTxFunction, BaseType_t xLoopBack )
+{
+USARTSim_t *pxSim;
+
+	taskENTER_CRITICAL();
+	{
+		pxSim = prvGetUSART( pxUSART );
+		pxSim->pxTxFunction = pxTxFunction;
+		pxSim->xLoopBack = xLoopBack;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+unsigned long ulUSARTSimInterrupts( USART_TypeDef *pxUSART )
+{
+unsigned long ulInterrupts;
+
+	taskENTER_CRITICAL();
+	{
+		ulInterrupts = prvGetUSART( pxUSART )->ulInterrupts;
+	}
+	taskEXIT_CRITICAL();
+
+	return ulInterrupts;
+}
+/*-----------------------------------------------------------*/
+
+void vUSARTSimTick( void )
+{
+USARTSim_t *pxSim;
+RCC_ClocksTypeDef xClocks;
+unsigned long ulBaud;
+BaseType_t xIdle;
+int iChar, iUSART;
+
+	RCC_GetClocksFreq( &xClocks );
+
+	for( iUSART = 0; iUSART < simUSARTS; iUSART++ )
+	{
+		pxSim = &( xUSARTs[ iUSART ] );
+
+		if( ( pxSim->pxUSART == NULL ) || ( ( pxSim->pxUSART->CR1 & simCR1_UE ) == 0 ) || ( pxSim->pxUSART->BRR == 0 ) )
+		{
+			continue;
+		}
+
+		/* The baud rate is the clock of the bus the USART is on divided by
+		BRR. */
+		ulBaud = ( ( pxSim->xOnAPB2 != pdFALSE ) ? xClocks.PCLK2_Frequency : xClocks.PCLK1_Frequency ) / pxSim->pxUSART->BRR;
+		pxSim->ulBits += ulBaud / configTICK_RATE_HZ;
+		pxSim->pxUSART->SR |= USART_FLAG_TC;
+		xIdle = pdFALSE;
+
+		while( pxSim->ulBits >= simBITS_PER_CHAR )
+		{
+			iChar = prvTransmit( pxSim );
+
+			if( iChar < 0 )
+			{
+				/* The line is idle for the rest of the tick. */
+				pxSim->ulBits = 0;
+				xIdle = pdTRUE;
+				break;
+			}
+
+			pxSim->ulBits -= simBITS_PER_CHAR;
+
+			if( pxSim->pxTxFunction != NULL )
+			{
+				pxSim->pxTxFunction( pxSim->pxUSART, ( unsigned char ) iChar );
+			}
+
+			if( pxSim->xLoopBack != pdFALSE )
+			{
+				prvReceive( pxSim, ( unsigned char ) iChar );
+			}
+		}
+
+		if( ( xIdle != pdFALSE ) && ( pxSim->xRxSinceIdle != pdFALSE ) )
+		{
+			/* Nothing more arrived, so the line is idle. */
+			pxSim->xRxSinceIdle = pdFALSE;
+
+			if( ( pxSim->pxUSART->CR1 & simCR1_IDLEIE ) != 0 )
+			{
+				pxSim->pxUSART->SR |= USART_FLAG_IDLE;
+				prvCallHandler( pxSim, pxSim->pxHandler );
+				pxSim->pxUSART->SR &= ( u16 ) ~USART_FLAG_IDLE;
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static int prvTransmit( USARTSim_t *pxSim )
+{
+USART_TypeDef * const pxUSART = pxSim->pxUSART;
+int iChannel, iChar = -1;
+
+	if( ( pxUSART->CR3 & simCR3_DMAT ) != 0 )
+	{
+		iChannel = prvGetDMAChannel( pxSim, simCCR_DIR );
+
+		if( iChannel >= 0 )
+		{
+			iChar = *prvDMAAddress( iChannel );
+			prvDMAByteMoved( pxSim, iChannel );
+		}
+	}
+	else if( ( pxUSART->CR1 & simCR1_TXEIE ) != 0 )
+	{
+		/* TXE is only set while the handler can write the character that is
+		sent next, so the receive interrupts see the data register full. */
+		pxUSART->DR = simDR_UNWRITTEN;
+		pxUSART->SR |= USART_FLAG_TXE;
+		prvCallHandler( pxSim, pxSim->pxHandler );
+		pxUSART->SR &= ( u16 ) ~USART_FLAG_TXE;
+
+		if( pxUSART->DR != simDR_UNWRITTEN )
+		{
+			iChar = ( int ) ( pxUSART->DR & 0xFFU );
+		}
+	}
+
+	return iChar;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReceive( USARTSim_t *pxSim, unsigned char ucChar )
+{
+USART_TypeDef * const pxUSART = pxSim->pxUSART;
+int iChannel;
+
+	if( ( pxUSART->CR1 & simCR1_RE ) == 0 )
+	{
+		return;
+	}
+
+	pxSim->xRxSinceIdle = pdTRUE;
+
+	if( ( pxUSART->CR3 & simCR3_DMAR ) != 0 )
+	{
+		iChannel = prvGetDMAChannel( pxSim, 0 );
+
+		if( iChannel >= 0 )
+		{
+			*prvDMAAddress( iChannel ) = ucChar;
+			prvDMAByteMoved( pxSim, iChannel );
+		}
+		else if( ( pxUSART->CR3 & simCR3_EIE ) != 0 )
+		{
+			/* Nothing took the character. */
+			pxUSART->SR |= USART_FLAG_ORE;
+			prvCallHandler( pxSim, pxSim->pxHandler );
+			pxUSART->SR &= ( u16 ) ~USART_FLAG_ORE;
+		}
+	}
+	else
+	{
+		pxUSART->DR = ucChar;
+
+		if( ( pxUSART->CR1 & simCR1_RXNEIE ) != 0 )
+		{
+			/* The handler reads the data register, which clears RXNE. */
+			pxUSART->SR |= USART_FLAG_RXNE;
+			prvCallHandler( pxSim, pxSim->pxHandler );
+			pxUSART->SR &= ( u16 ) ~USART_FLAG_RXNE;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static int prvGetDMAChannel( USARTSim_t *pxSim, u32 ulDirection )
+{
+DMA_Channel_TypeDef *pxChannel;
+int iChannel;
+
+	for( iChannel = 0; iChannel < simDMA_CHANNELS; iChannel++ )
+	{
+		pxChannel = pxDMAChannelRegisters[ iChannel ];
+
+		if( ( pxChannel->CCR & simCCR_EN ) == 0 )
+		{
+			/* A transfer ends when the channel is disabled. */
+			xDMAChannels[ iChannel ].xActive = pdFALSE;
+		}
+		else if( ( pxChannel->CPAR == ( u32 ) ( uintptr_t ) &( pxSim->pxUSART->DR ) ) && ( ( pxChannel->CCR & simCCR_DIR ) == ulDirection ) )
+		{
+			if( ( xDMAChannels[ iChannel ].xActive == pdFALSE ) && ( pxChannel->CNDTR != 0 ) )
+			{
+				/* The channel has been enabled with a new count since its last
+				transfer ended. */
+				xDMAChannels[ iChannel ].xActive = pdTRUE;
+				xDMAChannels[ iChannel ].ulCount = pxChannel->CNDTR;
+			}
+
+			if( xDMAChannels[ iChannel ].xActive != pdFALSE )
+			{
+				return iChannel;
+			}
+		}
+	}
+
+	return -1;
+}
+/*-----------------------------------------------------------*/
+
+static unsigned char *prvDMAAddress( int iChannel )
+{
+DMA_Channel_TypeDef * const pxChannel = pxDMAChannelRegisters[ iChannel ];
+u32 ulOffset = 0;
+
+	if( ( pxChannel->CCR & simCCR_MINC ) != 0 )
+	{
+		ulOffset = xDMAChannels[ iChannel ].ulCount - pxChannel->CNDTR;
+	}
+
+	return ( unsigned char * ) ( uintptr_t ) ( pxChannel->CMAR + ulOffset );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDMAByteMoved( USARTSim_t *pxSim, int iChannel )
+{
+DMA_Channel_TypeDef * const pxChannel = pxDMAChannelRegisters[ iChannel ];
+DMAChannelSim_t * const pxChannelSim = &( xDMAChannels[ iChannel ] );
+const unsigned int uxShift = ( unsigned int ) iChannel * 4U;
+u32 ulFlags = 0, ulEnabled = 0;
+
+	pxChannel->CNDTR--;
+
+	if( pxChannel->CNDTR == ( pxChannelSim->ulCount / 2U ) )
+	{
+		ulFlags |= simISR_HTIF;
+		ulEnabled |= ( pxChannel->CCR & simCCR_HTIE );
+	}
+
+	if( pxChannel->CNDTR == 0 )
+	{
+		ulFlags |= simISR_TCIF;
+		ulEnabled |= ( pxChannel->CCR & simCCR_TCIE );
+
+		if( ( pxChannel->CCR & simCCR_CIRC ) != 0 )
+		{
+			pxChannel->CNDTR = pxChannelSim->ulCount;
+		}
+		else
+		{
+			pxChannelSim->xActive = pdFALSE;
+		}
+	}
+
+	if( ulFlags != 0 )
+	{
+		DMA->ISR |= ( ulFlags | simISR_GIF ) << uxShift;
+
+		if( ulEnabled != 0 )
+		{
+			prvCallHandler( pxSim, pxChannelSim->pxHandler );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCallHandler( USARTSim_t *pxSim, void ( *pxHandler )( void ) )
+{
+	if( pxHandler != NULL )
+	{
+		pxSim->ulInterrupts++;
+		pxHandler();
+
+		/* The flags the handler cleared. */
+		DMA->ISR &= ~( DMA->IFCR );
+		DMA->IFCR = 0;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static USARTSim_t *prvGetUSART( USART_TypeDef *pxUSART )
+{
+int iUSART;
+
+	if( xInitialised == pdFALSE )
+	{
+		xUSARTs[ 0 ].pxUSART = USART1;
+		xUSARTs[ 0 ].pxHandler = vUARTInterruptHandler;
+		xUSARTs[ 0 ].xOnAPB2 = pdTRUE;
+		xUSARTs[ 1 ].pxUSART = USART2;
+		xUSARTs[ 1 ].pxHandler = USART2_IRQHandler;
+		xUSARTs[ 2 ].pxUSART = USART3;
+		xUSARTs[ 2 ].pxHandler = USART3_IRQHandler;
+
+		pxDMAChannelRegisters[ 0 ] = DMA_Channel1;
+		pxDMAChannelRegisters[ 1 ] = DMA_Channel2;
+		pxDMAChannelRegisters[ 2 ] = DMA_Channel3;
+		pxDMAChannelRegisters[ 3 ] = DMA_Channel4;
+		pxDMAChannelRegisters[ 4 ] = DMA_Channel5;
+		pxDMAChannelRegisters[ 5 ] = DMA_Channel6;
+		pxDMAChannelRegisters[ 6 ] = DMA_Channel7;
+		xDMAChannels[ 0 ].pxHandler = DMAChannel1_IRQHandler;
+		xDMAChannels[ 1 ].pxHandler = DMAChannel2_IRQHandler;
+		xDMAChannels[ 2 ].pxHandler = DMAChannel3_IRQHandler;
+		xDMAChannels[ 3 ].pxHandler = DMAChannel4_IRQHandler;
+		xDMAChannels[ 4 ].pxHandler = DMAChannel5_IRQHandler;
+		xDMAChannels[ 5 ].pxHandler = DMAChannel6_IRQHandler;
+		xDMAChannels[ 6 ].pxHandler = DMAChannel7_IRQHandler;
+
+		xInitialised = pdTRUE;
+	}
+
+	for( iUSART = 0; iUSART < simUSARTS; iUSART++ )
+	{
+		if( xUSARTs[ iUSART ].pxUSART == pxUSART )
+		{
+			break;
+		}
+	}
+
+	configASSERT( iUSART < simUSARTS );
+
+	return &( xUSARTs[ iUSART ] );
+}
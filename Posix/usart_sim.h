@@ -0,0 +1,31 @@
+/*
+	Simulated USARTs for the host build.  See usart_sim.c.
+*/
+
+#ifndef USART_SIM_H
+#define USART_SIM_H
+
+/* The function a simulated USART passes each character it transmits to.
+Called from the tick interrupt. */
+typedef void ( *USARTSimTxFunction_t )( USART_TypeDef *pxUSART, unsigned char ucChar );
+
+/*
+ * Passes each character pxUSART transmits to pxTxFunction, which can be NULL,
+ * and, if xLoopBack is pdTRUE, back to its own receiver.
+ */
+void vUSARTSimConnect( USART_TypeDef *pxUSART, USARTSimTxFunction_t pxTxFunction, BaseType_t xLoopBack );
+
+/*
+ * Moves one tick's worth of characters through each USART, at its baud rate,
+ * and runs the USART and DMA interrupts that causes.  Called from the tick
+ * hook.
+ */
+void vUSARTSimTick( void );
+
+/*
+ * The number of interrupt handlers vUSARTSimTick() has called for pxUSART and
+ * the DMA channels that serve it.
+ */
+unsigned long ulUSARTSimInterrupts( USART_TypeDef *pxUSART );
+
+#endif /* USART_SIM_H */
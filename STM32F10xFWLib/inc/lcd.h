@@ -139,7 +139,28 @@
 #define Horizontal     0x00
 #define Vertical       0x01
 
+/* When 1, and the functions are called from a FreeRTOS task, blocks of pixels
+   are moved to SPI2 by DMA channel 5 while the calling task is blocked. DMA
+   channel 5 also serves the USART1 receiver, so serUSE_DMA must be set to 0
+   for the serial driver, and configTASK_NOTIFICATION_ARRAY_ENTRIES must be at
+   least 2. serial.c and dma_service.c stop the build if they would also use
+   the channel. */
+#ifndef LCD_USE_DMA
+#define LCD_USE_DMA    0
+#endif
+
+/* The number of characters kept expanded into runs of pixels for the text
+   functions, from 1 to 254. Each takes 96 bytes of RAM. */
+#ifndef LCD_GLYPH_CACHE_SIZE
+#define LCD_GLYPH_CACHE_SIZE    8
+#endif
+
 /* Exported macro ------------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+/* The 16x24 font of the characters 0x20 to 0x7E, 24 rows per character and
+   bit n of a row for the pixel n columns to the right of its start */
+extern const uc16 ASCII_Table[];
+
 /* Exported functions ------------------------------------------------------- */
 /*----- High layer function -----*/
 void LCD_Init(void);
@@ -160,10 +181,21 @@ void LCD_DrawCircle(u8 Xpos, u16 Ypos, u16 Radius);
 void LCD_DrawMonoPict(uc32 *Pict);
 void LCD_DrawBMP(u32 BmpAddress);
 
+/*----- Deferred text screen -----*/
+void LCD_DeferChar(u8 Line, u8 Index, u8 Ascii);
+void LCD_DeferStringLine(u8 Line, u8 *ptr);
+void LCD_DeferClearLine(u8 Line);
+void LCD_DeferClear(void);
+void LCD_InvalidateScreen(void);
+void LCD_UpdateScreen(void);
+
 /*----- Medium layer function -----*/
 void LCD_WriteReg(u8 LCD_Reg, u8 LCD_RegValue);
 u8 LCD_ReadReg(u8 LCD_Reg);
 void LCD_WriteRAM(u16 RGB_Code);
+void LCD_WriteRAMBurst(uc16 *pBuffer, u32 NumPixel);
+void LCD_FillRAM(u16 RGB_Code, u32 NumPixel);
+void LCD_DMACmd(FunctionalState NewState);
 u16  LCD_ReadRAM(void);
 void LCD_PowerOn(void);
 void LCD_DisplayOn(void);
@@ -28,6 +28,29 @@
 #define Low     0x00  /* Chip Select line low */
 #define High    0x01  /* Chip Select line high */
 
+/* When 1, and the functions are called from a FreeRTOS task, blocks of data
+   are moved with the SPI1 DMA channels while the calling task is blocked, and
+   the wait for the end of a program or erase operation delays the task
+   between reads of the status register rather than spinning. Set to 0 for the
+   polled driver, which does not depend on FreeRTOS. */
+#ifndef SPI_FLASH_USE_RTOS
+#define SPI_FLASH_USE_RTOS  1
+#endif
+
+/* When 1, reads use the FAST_READ instruction, which is followed by a dummy
+   byte and can be clocked at up to 50MHz, rather than READ, which is limited
+   to 20MHz. */
+#ifndef SPI_FLASH_USE_FAST_READ
+#define SPI_FLASH_USE_FAST_READ  1
+#endif
+
+/* The SPI1 clock is PCLK2 divided by this. The default gives 18MHz, the
+   fastest SPI clock specified for the STM32F10x. SPI_BaudRatePrescaler_2 can
+   only be used with SPI_FLASH_USE_FAST_READ set to 1. */
+#ifndef SPI_FLASH_BaudRatePrescaler
+#define SPI_FLASH_BaudRatePrescaler  SPI_BaudRatePrescaler_4
+#endif
+
 /* Exported macro ------------------------------------------------------------*/
 /* Exported functions ------------------------------------------------------- */
 /*----- High layer function -----*/
@@ -36,9 +59,14 @@ void SPI_FLASH_SectorErase(u32 SectorAddr);
 void SPI_FLASH_BulkErase(void);
 void SPI_FLASH_PageWrite(u8* pBuffer, u32 WriteAddr, u16 NumByteToWrite);
 void SPI_FLASH_BufferWrite(u8* pBuffer, u32 WriteAddr, u16 NumByteToWrite);
-void SPI_FLASH_BufferRead(u8* pBuffer, u32 ReadAddr, u16 NumByteToRead);
+void SPI_FLASH_BufferRead(u8* pBuffer, u32 ReadAddr, u32 NumByteToRead);
 u32 SPI_FLASH_ReadID(void);
 void SPI_FLASH_StartReadSequence(u32 ReadAddr);
+void SPI_FLASH_ReadStream(u8* pBuffer, u32 NumByteToRead);
+void SPI_FLASH_ReadStreamStart(u8* pBuffer, u16 NumByteToRead);
+void SPI_FLASH_ReadStreamWait(void);
+void SPI_FLASH_EndReadSequence(void);
+void SPI_FLASH_DMACmd(FunctionalState NewState);
 
 /*----- Low layer function -----*/
 u8 SPI_FLASH_ReadByte(void);
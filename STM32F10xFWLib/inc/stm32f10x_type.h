@@ -24,27 +24,36 @@
 
 /* Includes ------------------------------------------------------------------*/
 /* Exported types ------------------------------------------------------------*/
-typedef signed long  s32;
+/* long is 32 bits on the target, but 64 bits on a 64 bit host, which uses int
+   instead so that the peripheral structures have the register layout of the
+   target. */
+#if defined(__LP64__)
+#define __STM32F10x_INT32 int
+#else
+#define __STM32F10x_INT32 long
+#endif
+
+typedef signed __STM32F10x_INT32  s32;
 typedef signed short s16;
 typedef signed char  s8;
 
-typedef volatile signed long  vs32;
+typedef volatile signed __STM32F10x_INT32  vs32;
 typedef volatile signed short vs16;
 typedef volatile signed char  vs8;
 
-typedef unsigned long  u32;
+typedef unsigned __STM32F10x_INT32  u32;
 typedef unsigned short u16;
 typedef unsigned char  u8;
 
-typedef unsigned long  const uc32;  /* Read Only */
+typedef unsigned __STM32F10x_INT32  const uc32;  /* Read Only */
 typedef unsigned short const uc16;  /* Read Only */
 typedef unsigned char  const uc8;   /* Read Only */
 
-typedef volatile unsigned long  vu32;
+typedef volatile unsigned __STM32F10x_INT32  vu32;
 typedef volatile unsigned short vu16;
 typedef volatile unsigned char  vu8;
 
-typedef volatile unsigned long  const vuc32;  /* Read Only */
+typedef volatile unsigned __STM32F10x_INT32  const vuc32;  /* Read Only */
 typedef volatile unsigned short const vuc16;  /* Read Only */
 typedef volatile unsigned char  const vuc8;   /* Read Only */
 
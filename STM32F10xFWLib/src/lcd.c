@@ -25,7 +25,67 @@
 #include "task.h"
 
 /* Private typedef -----------------------------------------------------------*/
+/* A character cell of the deferred text screen */
+typedef struct
+{
+  u8 Ascii;
+  u16 TextColor;
+  u16 BackColor;
+} LCD_CellTypeDef;
+
+/* A character of ASCII_Table expanded into runs of pixels of one color */
+typedef struct
+{
+  u8 Ascii;                         /* 0 while the entry holds no character */
+  u8 Rows[24];                      /* For each row, bit 7 set if the first run
+                                       is in the text color, and in bits 0..4
+                                       the number of runs */
+  u8 Runs[68];                      /* The run lengths minus 1, two per byte,
+                                       low nibble first. The character with
+                                       the most runs has 134. */
+  u16 LastUse;                      /* Value of GlyphDraw when last used */
+} LCD_GlyphTypeDef;
+
 /* Private define ------------------------------------------------------------*/
+/* The deferred text screen: 10 lines of 20 characters of 16x24 dots */
+#define LCD_TEXT_LINES      10
+#define LCD_TEXT_COLUMNS    20
+#define LCD_CHAR_HEIGHT     24
+#define LCD_CHAR_WIDTH      16
+#define LCD_ALL_CELLS       ((u32)0x000FFFFF)
+
+/* The pixels expanded or read ahead at a time by LCD_DrawMonoPict,
+   LCD_DrawBMP and LCD_DrawCells, in each of two buffers. A multiple of
+   LCD_CHAR_WIDTH. */
+#define LCD_BufferPixels    128
+
+/* Marks a character that is not in the glyph cache */
+#define LCD_NoGlyph         0xFF
+
+#if LCD_USE_DMA == 1
+/* Blocks shorter than this are polled, as they take less time than setting up
+   the DMA channel and blocking the calling task. */
+#define LCD_DMAThreshold    16
+
+/* The notification index used to signal the end of a DMA transfer to the
+   calling task. It must differ from SPI_FLASH_NotifyIndex, as LCD_DrawBMP has
+   a transfer of each driver in progress at once. */
+#ifndef LCD_NotifyIndex
+#define LCD_NotifyIndex     ( configTASK_NOTIFICATION_ARRAY_ENTRIES - 2 )
+#endif
+
+#if configTASK_NOTIFICATION_ARRAY_ENTRIES < 2
+#error LCD_USE_DMA needs configTASK_NOTIFICATION_ARRAY_ENTRIES to be at least 2
+#endif
+
+/* The largest number of pixels moved by one DMA transfer. Longer blocks are
+   split. */
+#define LCD_DMAMaxBlock     0xFFFF
+
+/* A DMA transfer of 65535 pixels takes 58ms with the SPI clock at 18MHz. */
+#define LCD_DMATimeout      pdMS_TO_TICKS( 100 )
+#endif
+
      /* ASCII Table: each character is 16 column (16dots large)
         and 24 raw (24 dots high) */
      const uc16 ASCII_Table[] =
@@ -416,9 +476,52 @@
   /* Global variables to set the written text color */
 static  vu16 TextColor = 0x0000, BackColor = 0xFFFF;
 
+  /* The characters the deferred text screen should show, and for each line
+     the cells that differ from what the LCD shows (bit n for cell n) */
+static LCD_CellTypeDef TextScreen[LCD_TEXT_LINES][LCD_TEXT_COLUMNS];
+static u32 DirtyCells[LCD_TEXT_LINES];
+
+  /* One buffer is filled while the other is sent */
+static u16 PixelBuffer[2][LCD_BufferPixels];
+
+  /* The characters drawn most recently, and the number of calls of
+     LCD_DrawCells, which marks the entries it uses */
+static LCD_GlyphTypeDef GlyphCache[LCD_GLYPH_CACHE_SIZE];
+static u16 GlyphDraw = 0;
+
+  /* The color sent by LCD_FillRAM, which the DMA reads repeatedly */
+static u16 FillColor;
+
+#if LCD_USE_DMA == 1
+  /* The task waiting for the current DMA transfer to end */
+static TaskHandle_t DMAWaitingTask = NULL;
+
+  /* Whether blocks of pixels use the DMA, see LCD_DMACmd() */
+static FunctionalState DMAState = ENABLE;
+
+  /* Set while a block started by LCD_WriteRAMBlockStart has not been waited
+     for */
+static u8 DMAPending = 0;
+#endif
+
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 static u32 StrLength(u8 *Str);
+static void LCD_UpdateLine(u8 Row);
+static void LCD_DrawCells(u8 Xpos, u16 Ypos, LCD_CellTypeDef *Cells, u8 Count);
+static u8 LCD_GetGlyph(u8 Ascii);
+static u8 LCD_ExpandGlyph(LCD_GlyphTypeDef *Glyph, u8 Ascii);
+static u16 *LCD_SendPixelBuffer(u16 *pBuffer, u16 NumPixel);
+static void LCD_WriteRAMStart(void);
+static void LCD_WriteRAMNext(u16 RGB_Code);
+static void LCD_WriteRAMEnd(void);
+static void LCD_WriteRAMBlockStart(uc16 *pBuffer, u16 NumPixel, u8 Increment);
+static void LCD_WriteRAMBlockWait(void);
+
+#if LCD_USE_DMA == 1
+static u8 LCD_CanBlock(void);
+void DMAChannel5_IRQHandler(void);
+#endif
 
 /*******************************************************************************
 * Function Name  : LCD_Init
@@ -592,14 +695,9 @@ void LCD_ClearLine(u8 Line)
 *******************************************************************************/
 void LCD_Clear(void)
 {
-  u32 index = 0;
-
   LCD_SetCursor(0x00, 0x013F);
 
-  for(index = 0; index < 0x12C00; index++)
-  {
-    LCD_WriteRAM(White);
-  }
+  LCD_FillRAM(White, 0x12C00);
 }
 
 /*******************************************************************************
@@ -668,8 +766,13 @@ void LCD_DrawChar(u8 Xpos, u16 Ypos, uc16 *c)
 *******************************************************************************/
 void LCD_DisplayChar(u8 Line, u16 Column, u8 Ascii)
 {
-  Ascii -= 32;
-  LCD_DrawChar(Line, Column, &ASCII_Table[Ascii * 24]);
+  LCD_CellTypeDef Cell;
+
+  Cell.Ascii = Ascii;
+  Cell.TextColor = TextColor;
+  Cell.BackColor = BackColor;
+
+  LCD_DrawCells(Line, Column, &Cell, 1);
 }
 
 /*******************************************************************************
@@ -684,21 +787,20 @@ void LCD_DisplayChar(u8 Line, u16 Column, u8 Ascii)
 *******************************************************************************/
 void LCD_DisplayStringLine(u8 Line, u8 *ptr)
 {
-  u32 i = 0;
-  u16 refcolumn = 319;
+  LCD_CellTypeDef Cells[LCD_TEXT_COLUMNS];
+  u8 i = 0;
 
-  /* Send the string character by character on lCD */
-  while ((*ptr != 0) & (i < 20))
+  while ((*ptr != 0) && (i < LCD_TEXT_COLUMNS))
   {
-    /* Display one character on LCD */
-    LCD_DisplayChar(Line, refcolumn, *ptr);
-    /* Decrement the column position by 16 */
-    refcolumn -= 16;
-    /* Point on the next character */
+    Cells[i].Ascii = *ptr;
+    Cells[i].TextColor = TextColor;
+    Cells[i].BackColor = BackColor;
     ptr++;
-    /* Increment the character counter */
     i++;
   }
+
+  /* Draw the characters together, row by row */
+  LCD_DrawCells(Line, 319, Cells, i);
 }
 
 /*******************************************************************************
@@ -781,43 +883,191 @@ void LCD_DisplayString(u8 Line, u8 *ptr)
 
 /*******************************************************************************
 * Function Name  : LCD_ScrollText
-* Description    :
-* Input          :
+* Description    : Scrolls a string along a line, one character to the right
+*                  every 100ms, wrapping round to the left. The string is
+*                  padded with spaces to at least 20 characters. Each step is
+*                  drawn through the deferred text screen, so only the
+*                  characters that differ from the last step are written.
+*                  Never returns.
+* Input          : - Line: the Line where to display the string.
+*                    This parameter can be one of the following values:
+*                       - Linex: where x can be 0..9
+*                  - *ptr: pointer to the string to scroll.
 * Output         : None
 * Return         : None
 *******************************************************************************/
 void LCD_ScrollText(u8 Line, u8 *ptr)
 {
-  u32 i = 0, length = 0, x = 0;
-  u16 refcolumn = 319;
+  u32 i = 0, length = 0, ring = 0, offset = 0, index = 0;
+  u8 Row = Line / LCD_CHAR_HEIGHT;
 
   /* Get the string length */
   length = StrLength(ptr);
+  ring = (length < LCD_TEXT_COLUMNS) ? LCD_TEXT_COLUMNS : length;
+
+  if(Row >= LCD_TEXT_LINES)
+  {
+    return;
+  }
+
+  /* The LCD may not show what the deferred text screen holds for the line */
+  DirtyCells[Row] = LCD_ALL_CELLS;
 
   while(1)
   {
-    /* Send the string character by character on lCD */
-    while ((*ptr != 0) & (i < 20))
+    /* Character i of the line shows character i - offset of the ring */
+    for(i = 0; i < LCD_TEXT_COLUMNS; i++)
     {
-      /* Display one character on LCD */
-      LCD_DisplayChar(Line, refcolumn, *ptr);
-      /* Decrement the column position by 16 */
-      refcolumn -= 16;
-      /* Point on the next character */
-      ptr++;
-      /* Increment the character counter */
-      i++;
+      index = (i + ring - offset) % ring;
+      LCD_DeferChar(Line, i, (index < length) ? ptr[index] : ' ');
     }
+
+    LCD_UpdateLine(Row);
+
     vTaskDelay( 100 / portTICK_PERIOD_MS );
-    i = 0;
-    //LCD_ClearLine(Line);
-    ptr -= length;
-    x++;
-    if(refcolumn < 16)
+    offset = (offset + 1) % ring;
+  }
+}
+
+/*******************************************************************************
+* Function Name  : LCD_DeferChar
+* Description    : Sets one character of the deferred text screen, in the
+*                  current Text and Background colors. The LCD is only written
+*                  by LCD_UpdateScreen, and only if the character changed.
+* Input          : - Line: the Line of the character.
+*                    This parameter can be one of the following values:
+*                       - Linex: where x can be 0..9
+*                  - Index: the character position in the line, 0..19 from the
+*                    left, as for LCD_DisplayStringLine.
+*                  - Ascii: character ascii code. Codes outside 0x20..0x7E are
+*                    shown as spaces.
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void LCD_DeferChar(u8 Line, u8 Index, u8 Ascii)
+{
+  LCD_CellTypeDef *Cell;
+  u8 Row = Line / LCD_CHAR_HEIGHT;
+
+  if((Row < LCD_TEXT_LINES) && (Index < LCD_TEXT_COLUMNS))
+  {
+    if((Ascii < 0x20) || (Ascii > 0x7E))
+    {
+      Ascii = ' ';
+    }
+
+    Cell = &TextScreen[Row][Index];
+
+    /* The Text color of a space is not seen */
+    if((Cell->Ascii != Ascii) || (Cell->BackColor != BackColor) ||
+       ((Ascii != ' ') && (Cell->TextColor != TextColor)))
     {
-      x = 0;
+      Cell->Ascii = Ascii;
+      Cell->TextColor = TextColor;
+      Cell->BackColor = BackColor;
+      DirtyCells[Row] |= ((u32)1 << Index);
     }
-    refcolumn = 319 - (x * 16);
+  }
+}
+
+/*******************************************************************************
+* Function Name  : LCD_DeferStringLine
+* Description    : Sets a maximum of 20 char of the deferred text screen, as
+*                  LCD_DisplayStringLine displays them.
+* Input          : - Line: the Line where to display the string.
+*                    This parameter can be one of the following values:
+*                       - Linex: where x can be 0..9
+*                  - *ptr: pointer to string to display on LCD.
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void LCD_DeferStringLine(u8 Line, u8 *ptr)
+{
+  u8 i = 0;
+
+  while ((*ptr != 0) && (i < LCD_TEXT_COLUMNS))
+  {
+    LCD_DeferChar(Line, i, *ptr);
+    ptr++;
+    i++;
+  }
+}
+
+/*******************************************************************************
+* Function Name  : LCD_DeferClearLine
+* Description    : Clears one line of the deferred text screen to the current
+*                  Background color.
+* Input          : - Line: the Line to be cleared.
+*                    This parameter can be one of the following values:
+*                       - Linex: where x can be 0..9
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void LCD_DeferClearLine(u8 Line)
+{
+  u8 i = 0;
+
+  for(i = 0; i < LCD_TEXT_COLUMNS; i++)
+  {
+    LCD_DeferChar(Line, i, ' ');
+  }
+}
+
+/*******************************************************************************
+* Function Name  : LCD_DeferClear
+* Description    : Clears the whole deferred text screen to the current
+*                  Background color.
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void LCD_DeferClear(void)
+{
+  u8 Row = 0;
+
+  for(Row = 0; Row < LCD_TEXT_LINES; Row++)
+  {
+    LCD_DeferClearLine(Row * LCD_CHAR_HEIGHT);
+  }
+}
+
+/*******************************************************************************
+* Function Name  : LCD_InvalidateScreen
+* Description    : Makes the next LCD_UpdateScreen redraw every character, for
+*                  example after LCD_Init or after drawing with the other
+*                  functions of this driver.
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void LCD_InvalidateScreen(void)
+{
+  u8 Row = 0;
+
+  for(Row = 0; Row < LCD_TEXT_LINES; Row++)
+  {
+    DirtyCells[Row] = LCD_ALL_CELLS;
+  }
+}
+
+/*******************************************************************************
+* Function Name  : LCD_UpdateScreen
+* Description    : Draws the characters of the deferred text screen that
+*                  changed since the last update. Each run of changed
+*                  characters in a line is drawn as one rectangle whose rows
+*                  are streamed with the chip select held, and unchanged
+*                  characters are not written.
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void LCD_UpdateScreen(void)
+{
+  u8 Row = 0;
+
+  for(Row = 0; Row < LCD_TEXT_LINES; Row++)
+  {
+    LCD_UpdateLine(Row);
   }
 }
 
@@ -965,24 +1215,31 @@ void LCD_DrawCircle(u8 Xpos, u16 Ypos, u16 Radius)
 *******************************************************************************/
 void LCD_DrawMonoPict(uc32 *Pict)
 {
-  u32 index = 0, i = 0;
+  u32 index = 0, i = 0, j = 0;
+  u16 *pBuffer;
 
   LCD_SetCursor(0, 319);
+  LCD_WriteRAMStart();
 
-  for(index = 0; index < 2400; index++)
+  /* Expand the next words into one buffer while the other is sent */
+  for(index = 0; index < 2400; index += (LCD_BufferPixels / 32))
   {
-    for(i = 0; i < 32; i++)
+    pBuffer = PixelBuffer[(index / (LCD_BufferPixels / 32)) & 1];
+
+    for(j = 0; j < (LCD_BufferPixels / 32); j++)
     {
-      if((Pict[index] & (1 << i)) == 0x00)
-      {
-        LCD_WriteRAM(BackColor);
-      }
-      else
+      for(i = 0; i < 32; i++)
       {
-        LCD_WriteRAM(TextColor);
+        *pBuffer++ = ((Pict[index + j] & (1 << i)) == 0x00) ? BackColor : TextColor;
       }
     }
+
+    LCD_WriteRAMBlockWait();
+    LCD_WriteRAMBlockStart(PixelBuffer[(index / (LCD_BufferPixels / 32)) & 1], LCD_BufferPixels, 1);
   }
+
+  LCD_WriteRAMBlockWait();
+  LCD_WriteRAMEnd();
 }
 
 /*******************************************************************************
@@ -1001,29 +1258,31 @@ void LCD_DrawBMP(u32 BmpAddress)
 
   LCD_SetCursor(239, 0x013F);
 
+  /* The pixels are stored low byte first, so the bytes read from the FLASH
+     are the pixels in memory order. The FLASH reads the next buffer while the
+     LCD is sent the last one. */
   SPI_FLASH_StartReadSequence(BmpAddress);
+  SPI_FLASH_ReadStreamStart((u8*)PixelBuffer[0], LCD_BufferPixels * 2);
 
-  /* Disable SPI1  */
-  SPI_Cmd(SPI1, DISABLE);
-  /* SPI in 16-bit mode */
-  SPI_DataSizeConfig(SPI1, SPI_DataSize_16b);
-  /* Enable SPI1  */
-  SPI_Cmd(SPI1, ENABLE);
+  LCD_WriteRAMStart();
 
-  for(i = 0; i < 76800; i++)
+  for(i = 0; i < (76800 / LCD_BufferPixels); i++)
   {
-    LCD_WriteRAM(__REV_HalfWord(SPI_FLASH_SendHalfWord(0xA5A5)));
+    SPI_FLASH_ReadStreamWait();
+    LCD_WriteRAMBlockWait();
+
+    if((i + 1) < (76800 / LCD_BufferPixels))
+    {
+      SPI_FLASH_ReadStreamStart((u8*)PixelBuffer[(i + 1) & 1], LCD_BufferPixels * 2);
+    }
+
+    LCD_WriteRAMBlockStart(PixelBuffer[i & 1], LCD_BufferPixels, 1);
   }
 
-  /* Deselect the FLASH: Chip Select high */
-  SPI_FLASH_ChipSelect(1);
+  LCD_WriteRAMBlockWait();
+  LCD_WriteRAMEnd();
 
-  /* Disable SPI1  */
-  SPI_Cmd(SPI1, DISABLE);
-  /* SPI in 8-bit mode */
-  SPI_DataSizeConfig(SPI1, SPI_DataSize_8b);
-  /* Enable SPI1  */
-  SPI_Cmd(SPI1, ENABLE);
+  SPI_FLASH_EndReadSequence();
 }
 
 /*******************************************************************************
@@ -1110,6 +1369,138 @@ void LCD_WriteRAM(u16 RGB_Code)
   LCD_CtrlLinesWrite(GPIOB, CtrlPin_NCS, Bit_SET);
 }
 
+/*******************************************************************************
+* Function Name  : LCD_WriteRAMStart
+* Description    : Selects the LCD RAM for a stream of pixels written with
+*                  LCD_WriteRAMNext. The chip select stays low until
+*                  LCD_WriteRAMEnd.
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCD_WriteRAMStart(void)
+{
+  LCD_CtrlLinesWrite(GPIOD, CtrlPin_NWR, Bit_RESET);
+  LCD_CtrlLinesWrite(GPIOD, CtrlPin_RS, Bit_SET);
+  LCD_CtrlLinesWrite(GPIOB, CtrlPin_NCS, Bit_RESET);
+}
+
+/*******************************************************************************
+* Function Name  : LCD_WriteRAMNext
+* Description    : Writes the next pixel of a stream started by
+*                  LCD_WriteRAMStart. The frame is queued as soon as the SPI
+*                  transmit buffer is free, so frames are sent back to back.
+* Input          : - RGB_Code: the pixel color in RGB mode (5-6-5).
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCD_WriteRAMNext(u16 RGB_Code)
+{
+  while(SPI_GetFlagStatus(SPI2, SPI_FLAG_TXE) == RESET)
+  {
+  }
+  SPI_SendData(SPI2, RGB_Code);
+}
+
+/*******************************************************************************
+* Function Name  : LCD_WriteRAMEnd
+* Description    : Ends a stream of pixels once the last frame has been sent.
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCD_WriteRAMEnd(void)
+{
+  while(SPI_GetFlagStatus(SPI2, SPI_FLAG_TXE) == RESET)
+  {
+  }
+  while(SPI_GetFlagStatus(SPI2, SPI_FLAG_BSY) != RESET)
+  {
+  }
+
+  LCD_CtrlLinesWrite(GPIOB, CtrlPin_NCS, Bit_SET);
+}
+
+/*******************************************************************************
+* Function Name  : LCD_WriteRAMBurst
+* Description    : Writes a block of pixels to the LCD RAM from the current
+*                  cursor position, keeping the LCD selected for the whole
+*                  block. When LCD_USE_DMA is 1 the block is moved by the DMA
+*                  while the calling task is blocked.
+* Input          : - pBuffer: pointer to the pixels, in RGB mode (5-6-5).
+*                  - NumPixel: number of pixels to write.
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void LCD_WriteRAMBurst(uc16 *pBuffer, u32 NumPixel)
+{
+  u16 Block = 0;
+
+  LCD_WriteRAMStart();
+
+  while(NumPixel > 0)
+  {
+    Block = (NumPixel > 0xFFFF) ? 0xFFFF : (u16)NumPixel;
+
+    LCD_WriteRAMBlockStart(pBuffer, Block, 1);
+    LCD_WriteRAMBlockWait();
+
+    pBuffer += Block;
+    NumPixel -= Block;
+  }
+
+  LCD_WriteRAMEnd();
+}
+
+/*******************************************************************************
+* Function Name  : LCD_FillRAM
+* Description    : Writes NumPixel pixels of one color to the LCD RAM from the
+*                  current cursor position, as LCD_WriteRAMBurst.
+* Input          : - RGB_Code: the pixel color in RGB mode (5-6-5).
+*                  - NumPixel: number of pixels to write.
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void LCD_FillRAM(u16 RGB_Code, u32 NumPixel)
+{
+  u16 Block = 0;
+
+  FillColor = RGB_Code;
+
+  LCD_WriteRAMStart();
+
+  while(NumPixel > 0)
+  {
+    Block = (NumPixel > 0xFFFF) ? 0xFFFF : (u16)NumPixel;
+
+    LCD_WriteRAMBlockStart(&FillColor, Block, 0);
+    LCD_WriteRAMBlockWait();
+
+    NumPixel -= Block;
+  }
+
+  LCD_WriteRAMEnd();
+}
+
+/*******************************************************************************
+* Function Name  : LCD_DMACmd
+* Description    : Enables or disables the use of the DMA for blocks of pixels.
+*                  The DMA is only used when LCD_USE_DMA is 1, and the driver
+*                  is called from a task.
+* Input          : NewState: new state of the DMA use.
+*                  This parameter can be: ENABLE or DISABLE.
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void LCD_DMACmd(FunctionalState NewState)
+{
+#if LCD_USE_DMA == 1
+  DMAState = NewState;
+#else
+  (void) NewState;
+#endif
+}
+
 /*******************************************************************************
 * Function Name  : LCD_ReadRAM
 * Description    : Reads the LCD RAM.
@@ -1281,6 +1672,22 @@ void LCD_SPIConfig(void)
 
   /* SPI2 enable */
   SPI_Cmd(SPI2, ENABLE);
+
+#if LCD_USE_DMA == 1
+  {
+    NVIC_InitTypeDef NVIC_InitStructure;
+
+    /* SPI2 Tx is served by DMA channel 5. The received frames are not read. */
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA, ENABLE);
+    SPI_DMACmd(SPI2, SPI_DMAReq_Tx, ENABLE);
+
+    NVIC_InitStructure.NVIC_IRQChannel = DMAChannel5_IRQChannel;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = configLIBRARY_KERNEL_INTERRUPT_PRIORITY;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+  }
+#endif
 }
 
 /*******************************************************************************
@@ -1302,4 +1709,434 @@ static u32 StrLength(u8 *Str)
   return Index;
 }
 
+/*******************************************************************************
+* Function Name  : LCD_WriteRAMBlockStart
+* Description    : Starts sending a block of pixels in a stream started by
+*                  LCD_WriteRAMStart. When the DMA is used the function returns
+*                  before the pixels are sent, and LCD_WriteRAMBlockWait must
+*                  be called before the buffer is changed or another block is
+*                  started. Otherwise the pixels are sent before it returns.
+* Input          : - pBuffer: pointer to the pixels.
+*                  - NumPixel: number of pixels to write.
+*                  - Increment: 0 to send the pixel at pBuffer NumPixel times.
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCD_WriteRAMBlockStart(uc16 *pBuffer, u16 NumPixel, u8 Increment)
+{
+  u32 i = 0;
+
+#if LCD_USE_DMA == 1
+  if((DMAState == ENABLE) && (NumPixel >= LCD_DMAThreshold) && LCD_CanBlock())
+  {
+    DMA_InitTypeDef DMA_InitStructure;
+
+    DMA_DeInit(DMA_Channel5);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)&(SPI2->DR);
+    DMA_InitStructure.DMA_MemoryBaseAddr = (u32)pBuffer;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStructure.DMA_BufferSize = NumPixel;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = (Increment != 0) ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(DMA_Channel5, &DMA_InitStructure);
+    DMA_ITConfig(DMA_Channel5, DMA_IT_TC, ENABLE);
+
+    DMAPending = 1;
+    DMAWaitingTask = xTaskGetCurrentTaskHandle();
+    DMA_Cmd(DMA_Channel5, ENABLE);
+    return;
+  }
+#endif
+
+  for(i = 0; i < NumPixel; i++)
+  {
+    LCD_WriteRAMNext(*pBuffer);
+
+    if(Increment != 0)
+    {
+      pBuffer++;
+    }
+  }
+}
+
+/*******************************************************************************
+* Function Name  : LCD_WriteRAMBlockWait
+* Description    : Waits for the block started by LCD_WriteRAMBlockStart to be
+*                  handed to SPI2. Returns at once if there is none.
+*                  LCD_WriteRAMEnd waits for the last frame to be sent.
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCD_WriteRAMBlockWait(void)
+{
+#if LCD_USE_DMA == 1
+  if(DMAPending != 0)
+  {
+    if(ulTaskNotifyTakeIndexed(LCD_NotifyIndex, pdTRUE, LCD_DMATimeout) == 0)
+    {
+      /* The transfer did not end - stop it, then clear the notification in
+         case the interrupt was taken before the channel was stopped */
+      taskENTER_CRITICAL();
+      {
+        DMA_Cmd(DMA_Channel5, DISABLE);
+        DMAWaitingTask = NULL;
+      }
+      taskEXIT_CRITICAL();
+
+      (void) ulTaskNotifyTakeIndexed(LCD_NotifyIndex, pdTRUE, 0);
+    }
+
+    DMAPending = 0;
+  }
+#endif
+}
+
+#if LCD_USE_DMA == 1
+/*******************************************************************************
+* Function Name  : LCD_CanBlock
+* Description    : Checks whether the driver was called from a task that can
+*                  block.
+* Input          : None
+* Output         : None
+* Return         : 1 if the scheduler is running and the caller is not an
+*                  interrupt, otherwise 0.
+*******************************************************************************/
+static u8 LCD_CanBlock(void)
+{
+  return (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) &&
+         (xPortIsInsideInterrupt() == pdFALSE);
+}
+
+/*******************************************************************************
+* Function Name  : DMAChannel5_IRQHandler
+* Description    : Handles the end of a SPI2 DMA transfer.
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void DMAChannel5_IRQHandler(void)
+{
+  BaseType_t HigherPriorityTaskWoken = pdFALSE;
+
+  if(DMA_GetITStatus(DMA_IT_TC5) != RESET)
+  {
+    DMA_ClearITPendingBit(DMA_IT_GL5);
+    DMA_Cmd(DMA_Channel5, DISABLE);
+
+    if(DMAWaitingTask != NULL)
+    {
+      vTaskNotifyGiveIndexedFromISR(DMAWaitingTask, LCD_NotifyIndex, &HigherPriorityTaskWoken);
+      DMAWaitingTask = NULL;
+    }
+  }
+
+  portEND_SWITCHING_ISR(HigherPriorityTaskWoken);
+}
+#endif /* LCD_USE_DMA */
+
+/*******************************************************************************
+* Function Name  : LCD_UpdateLine
+* Description    : Draws the characters of one line of the deferred text
+*                  screen that changed since the line was last updated.
+* Input          : - Row: the line, 0..9.
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCD_UpdateLine(u8 Row)
+{
+  u32 Dirty = 0;
+  u8 First = 0, Count = 0;
+
+  Dirty = DirtyCells[Row];
+  DirtyCells[Row] = 0;
+
+  while(Dirty != 0)
+  {
+    /* Find the next run of changed characters */
+    while((Dirty & ((u32)1 << First)) == 0)
+    {
+      First++;
+    }
+
+    Count = 0;
+    while(((First + Count) < LCD_TEXT_COLUMNS) && ((Dirty & ((u32)1 << (First + Count))) != 0))
+    {
+      Dirty &= ~((u32)1 << (First + Count));
+      Count++;
+    }
+
+    LCD_DrawCells(Row * LCD_CHAR_HEIGHT, 319 - (First * LCD_CHAR_WIDTH), &TextScreen[Row][First], Count);
+    First += Count;
+  }
+}
+
+/*******************************************************************************
+* Function Name  : LCD_DrawCells
+* Description    : Draws Count characters side by side, from column Ypos
+*                  towards column 0. The pixels of each row of the characters
+*                  are built in the pixel buffers, from the runs of the glyph
+*                  cache, and sent as blocks while the next ones are built.
+*                  Each row is one stream from its rightmost column, and a
+*                  whole line is one stream, as the RAM address wraps to the
+*                  next row.
+* Input          : - Xpos: the first row of the characters.
+*                  - Ypos: the leftmost column of the first character.
+*                  - Cells: the characters and their colors. Codes outside
+*                    0x20..0x7E are shown as spaces.
+*                  - Count: the number of characters, at most 20.
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCD_DrawCells(u8 Xpos, u16 Ypos, LCD_CellTypeDef *Cells, u8 Count)
+{
+  u8 Glyphs[LCD_TEXT_COLUMNS], Cursor[LCD_TEXT_COLUMNS];
+  LCD_GlyphTypeDef *Glyph;
+  u16 Colors[2];
+  u16 *pBuffer = PixelBuffer[0], *pPixel = PixelBuffer[0];
+  u16 Bits = 0;
+  u8 Ascii = 0, r = 0, c = 0, i = 0, Runs = 0, Select = 0, Length = 0, Nibble = 0;
+
+  if(Count == 0)
+  {
+    return;
+  }
+
+  /* Find the characters in the glyph cache once for all their rows */
+  GlyphDraw++;
+
+  for(c = 0; c < Count; c++)
+  {
+    Ascii = Cells[c].Ascii;
+
+    if((Ascii < 0x20) || (Ascii > 0x7E))
+    {
+      Ascii = ' ';
+    }
+
+    Glyphs[c] = LCD_GetGlyph(Ascii);
+    Cursor[c] = 0;
+  }
+
+  if(Count == LCD_TEXT_COLUMNS)
+  {
+    LCD_SetCursor(Xpos, Ypos);
+    LCD_WriteRAMStart();
+  }
+
+  for(r = 0; r < LCD_CHAR_HEIGHT; r++)
+  {
+    if(Count != LCD_TEXT_COLUMNS)
+    {
+      LCD_SetCursor(Xpos + r, Ypos);
+      LCD_WriteRAMStart();
+    }
+
+    for(c = 0; c < Count; c++)
+    {
+      Colors[0] = Cells[c].BackColor;
+      Colors[1] = Cells[c].TextColor;
+
+      if(Glyphs[c] != LCD_NoGlyph)
+      {
+        /* Expand the runs of the row */
+        Glyph = &GlyphCache[Glyphs[c]];
+        Runs = Glyph->Rows[r] & 0x1F;
+        Select = Glyph->Rows[r] >> 7;
+        Nibble = Cursor[c];
+
+        while(Runs-- > 0)
+        {
+          Length = ((Glyph->Runs[Nibble >> 1] >> ((Nibble & 1) << 2)) & 0x0F) + 1;
+          Nibble++;
+
+          while(Length-- > 0)
+          {
+            *pPixel++ = Colors[Select];
+          }
+
+          Select ^= 1;
+        }
+
+        Cursor[c] = Nibble;
+      }
+      else
+      {
+        /* The character could not be cached, expand its bits */
+        Ascii = Cells[c].Ascii;
+
+        if((Ascii < 0x20) || (Ascii > 0x7E))
+        {
+          Ascii = ' ';
+        }
+
+        Bits = ASCII_Table[(Ascii - 32) * LCD_CHAR_HEIGHT + r];
+
+        for(i = 0; i < LCD_CHAR_WIDTH; i++)
+        {
+          *pPixel++ = Colors[(Bits >> i) & 1];
+        }
+      }
+
+      if((pPixel - pBuffer) == LCD_BufferPixels)
+      {
+        pBuffer = LCD_SendPixelBuffer(pBuffer, LCD_BufferPixels);
+        pPixel = pBuffer;
+      }
+    }
+
+    if(Count != LCD_TEXT_COLUMNS)
+    {
+      if(pPixel != pBuffer)
+      {
+        pBuffer = LCD_SendPixelBuffer(pBuffer, (u16)(pPixel - pBuffer));
+        pPixel = pBuffer;
+      }
+
+      LCD_WriteRAMBlockWait();
+      LCD_WriteRAMEnd();
+    }
+  }
+
+  if(Count == LCD_TEXT_COLUMNS)
+  {
+    if(pPixel != pBuffer)
+    {
+      LCD_SendPixelBuffer(pBuffer, (u16)(pPixel - pBuffer));
+    }
+
+    LCD_WriteRAMBlockWait();
+    LCD_WriteRAMEnd();
+  }
+}
+
+/*******************************************************************************
+* Function Name  : LCD_GetGlyph
+* Description    : Finds a character in the glyph cache, expanding it into the
+*                  entry used least recently if it is not there. Entries used
+*                  by the current LCD_DrawCells are not replaced.
+* Input          : - Ascii: character ascii code, between 0x20 and 0x7E.
+* Output         : None
+* Return         : The index of the entry, or LCD_NoGlyph if the character
+*                  could not be cached.
+*******************************************************************************/
+static u8 LCD_GetGlyph(u8 Ascii)
+{
+  u8 i = 0, Victim = LCD_NoGlyph;
+
+  for(i = 0; i < LCD_GLYPH_CACHE_SIZE; i++)
+  {
+    if(GlyphCache[i].Ascii == Ascii)
+    {
+      GlyphCache[i].LastUse = GlyphDraw;
+      return i;
+    }
+  }
+
+  /* Use an empty entry, otherwise the one used least recently */
+  for(i = 0; i < LCD_GLYPH_CACHE_SIZE; i++)
+  {
+    if(GlyphCache[i].Ascii == 0)
+    {
+      Victim = i;
+      break;
+    }
+
+    if((GlyphCache[i].LastUse != GlyphDraw) &&
+       ((Victim == LCD_NoGlyph) ||
+        ((u16)(GlyphDraw - GlyphCache[i].LastUse) > (u16)(GlyphDraw - GlyphCache[Victim].LastUse))))
+    {
+      Victim = i;
+    }
+  }
+
+  if((Victim != LCD_NoGlyph) && (LCD_ExpandGlyph(&GlyphCache[Victim], Ascii) != 0))
+  {
+    GlyphCache[Victim].LastUse = GlyphDraw;
+    return Victim;
+  }
+
+  return LCD_NoGlyph;
+}
+
+/*******************************************************************************
+* Function Name  : LCD_ExpandGlyph
+* Description    : Expands a character of ASCII_Table into runs of pixels.
+* Input          : - Glyph: the glyph cache entry to fill.
+*                  - Ascii: character ascii code, between 0x20 and 0x7E.
+* Output         : None
+* Return         : 1 if the runs fit in the entry, otherwise 0 and the entry
+*                  is left empty.
+*******************************************************************************/
+static u8 LCD_ExpandGlyph(LCD_GlyphTypeDef *Glyph, u8 Ascii)
+{
+  uc16 *c = &ASCII_Table[(Ascii - 32) * LCD_CHAR_HEIGHT];
+  u16 Bits = 0;
+  u8 r = 0, i = 0, Runs = 0, Color = 0, Length = 0, Nibble = 0;
+
+  for(r = 0; r < LCD_CHAR_HEIGHT; r++)
+  {
+    Bits = c[r];
+    Color = Bits & 1;
+    Glyph->Rows[r] = Color << 7;
+    Runs = 0;
+    i = 0;
+
+    while(i < LCD_CHAR_WIDTH)
+    {
+      for(Length = 0; (i < LCD_CHAR_WIDTH) && (((Bits >> i) & 1) == Color); i++)
+      {
+        Length++;
+      }
+
+      if(Nibble >= (sizeof(Glyph->Runs) * 2))
+      {
+        Glyph->Ascii = 0;
+        return 0;
+      }
+
+      if((Nibble & 1) == 0)
+      {
+        Glyph->Runs[Nibble >> 1] = Length - 1;
+      }
+      else
+      {
+        Glyph->Runs[Nibble >> 1] |= (Length - 1) << 4;
+      }
+
+      Nibble++;
+      Runs++;
+      Color ^= 1;
+    }
+
+    Glyph->Rows[r] |= Runs;
+  }
+
+  Glyph->Ascii = Ascii;
+  return 1;
+}
+
+/*******************************************************************************
+* Function Name  : LCD_SendPixelBuffer
+* Description    : Starts sending pixels from one of the two pixel buffers, in
+*                  a stream started by LCD_WriteRAMStart, once the pixels sent
+*                  from the other have gone.
+* Input          : - pBuffer: PixelBuffer[0] or PixelBuffer[1].
+*                  - NumPixel: number of pixels to send.
+* Output         : None
+* Return         : The other buffer, to be filled while the pixels are sent.
+*******************************************************************************/
+static u16 *LCD_SendPixelBuffer(u16 *pBuffer, u16 NumPixel)
+{
+  LCD_WriteRAMBlockWait();
+  LCD_WriteRAMBlockStart(pBuffer, NumPixel, 1);
+
+  return (pBuffer == PixelBuffer[0]) ? PixelBuffer[1] : PixelBuffer[0];
+}
+
 /******************* (C) COPYRIGHT 2007 STMicroelectronics *****END OF FILE****/
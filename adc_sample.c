@@ -0,0 +1,348 @@
+/* Continuous sampling of several ADC1 channels, see adc_sample.h. */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "message_buffer.h"
+
+/* Library includes. */
+#include "stm32f10x_lib.h"
+#include "stm32f10x_tim.h"
+
+/* Demo application includes. */
+#include "dma_service.h"
+#include "adc_sample.h"
+
+#if( adcsampleUSE_STM32 == 1 )
+	/* The period of TIM4 is a 16 bit count of its clock. */
+	#if( ( configCPU_CLOCK_HZ / adcsampleRATE_HZ ) > 65536UL )
+		#error adcsampleRATE_HZ is below configCPU_CLOCK_HZ / 65536, the lowest rate TIM4 can trigger at.
+	#endif
+#endif
+
+/* The message buffer holds the descriptors of both halves, each stored with
+its length. */
+#define adcsampleMESSAGE_BUFFER_SIZE	( 2 * ( sizeof( ADCSampleBlock_t ) + sizeof( configMESSAGE_BUFFER_LENGTH_TYPE ) ) )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Called by the DMA service from the interrupt of DMA channel 1 each time a
+ * half of the buffer has been filled.
+ */
+static void prvDMACallback( DMATransfer_t *pxTransfer, uint32_t ulEvent, BaseType_t *pxHigherPriorityTaskWoken );
+
+/*
+ * Sends the descriptor of the half uxHalf to the processing task, or counts
+ * it as dropped.
+ */
+static void prvBlockFilled( UBaseType_t uxHalf, BaseType_t *pxHigherPriorityTaskWoken );
+
+#if( adcsampleUSE_STM32 == 1 )
+	static void prvSTM32Start( void );
+	static void prvSTM32Stop( void );
+	static void prvSTM32ConfigurePin( uint8_t ucChannel );
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* Both halves, one after the other. */
+static uint16_t usSamples[ 2 * adcsampleBLOCK_SAMPLES ];
+
+static MessageBufferHandle_t xBlocks = NULL;
+static DMAChannelHandle_t xChannel = NULL;
+static DMATransfer_t xTransfer;
+static ADCSampleStats_t xStats;
+
+/* Set while the processing task holds a half, from the interrupt that sends
+it until it is released, and the record of whether the DMA has started to
+refill it in that time. */
+static volatile BaseType_t xHeld[ 2 ];
+static volatile BaseType_t xOverwritten[ 2 ];
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xADCSampleStart( void )
+{
+	if( xBlocks == NULL )
+	{
+		xBlocks = xMessageBufferCreate( adcsampleMESSAGE_BUFFER_SIZE );
+
+		if( xBlocks == NULL )
+		{
+			return pdFAIL;
+		}
+	}
+
+	xChannel = xDMAServiceOpen( eDMARequestADC1, DMA_Priority_VeryHigh );
+
+	if( xChannel == NULL )
+	{
+		return pdFAIL;
+	}
+
+	( void ) xMessageBufferReset( xBlocks );
+	memset( ( void * ) &xStats, 0x00, sizeof( xStats ) );
+	xHeld[ 0 ] = pdFALSE;
+	xHeld[ 1 ] = pdFALSE;
+
+	/* The DMA loops over both halves until it is stopped, and reports the
+	end of each. */
+	memset( ( void * ) &xTransfer, 0x00, sizeof( xTransfer ) );
+	xTransfer.ulMemoryAddress = ( uint32_t ) usSamples;
+	xTransfer.usCount = ( uint16_t ) ( sizeof( usSamples ) / sizeof( usSamples[ 0 ] ) );
+	xTransfer.usConfig = ( uint16_t ) ( DMA_DIR_PeripheralSRC | DMA_PeripheralInc_Disable | DMA_MemoryInc_Enable |
+										DMA_PeripheralDataSize_HalfWord | DMA_MemoryDataSize_HalfWord |
+										DMA_Mode_Circular | DMA_M2M_Disable );
+	xTransfer.pxCallback = prvDMACallback;
+
+	#if( adcsampleUSE_STM32 == 1 )
+	{
+		xTransfer.ulPeripheralAddress = ( uint32_t ) &( ADC1->DR );
+	}
+	#endif
+
+	( void ) xDMAServiceSubmit( xChannel, &xTransfer );
+
+	#if( adcsampleUSE_STM32 == 1 )
+	{
+		/* The DMA is waiting for the first conversion before the timer
+		triggers it. */
+		prvSTM32Start();
+	}
+	#endif
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vADCSampleStop( void )
+{
+	if( xChannel != NULL )
+	{
+		#if( adcsampleUSE_STM32 == 1 )
+		{
+			prvSTM32Stop();
+		}
+		#endif
+
+		/* Fails if a transfer error has already ended the transfer. */
+		( void ) xDMAServiceCancel( xChannel, &xTransfer );
+		( void ) xDMAServiceClose( xChannel );
+		xChannel = NULL;
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xADCSampleReceive( ADCSampleBlock_t *pxBlock, TickType_t xTicksToWait )
+{
+BaseType_t xReturn = pdFAIL;
+
+	if( xMessageBufferReceive( xBlocks, ( void * ) pxBlock, sizeof( *pxBlock ), xTicksToWait ) == sizeof( *pxBlock ) )
+	{
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xADCSampleRelease( const ADCSampleBlock_t *pxBlock )
+{
+UBaseType_t uxHalf;
+BaseType_t xReturn;
+
+	uxHalf = ( pxBlock->pusSamples == usSamples ) ? 0 : 1;
+
+	taskENTER_CRITICAL();
+	{
+		xReturn = ( xOverwritten[ uxHalf ] == pdFALSE ) ? pdPASS : pdFAIL;
+		xHeld[ uxHalf ] = pdFALSE;
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vADCSampleGetStats( ADCSampleStats_t *pxStats )
+{
+	taskENTER_CRITICAL();
+	{
+		*pxStats = xStats;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static void prvDMACallback( DMATransfer_t *pxTransfer, uint32_t ulEvent, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	( void ) pxTransfer;
+
+	if( ulEvent == dmaserviceEVENT_HALF )
+	{
+		prvBlockFilled( 0, pxHigherPriorityTaskWoken );
+	}
+	else if( ulEvent == dmaserviceEVENT_COMPLETE )
+	{
+		prvBlockFilled( 1, pxHigherPriorityTaskWoken );
+	}
+	else
+	{
+		/* The DMA service has stopped the channel and ended the transfer. */
+		xStats.ulErrors++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvBlockFilled( UBaseType_t uxHalf, BaseType_t *pxHigherPriorityTaskWoken )
+{
+ADCSampleBlock_t xBlock;
+UBaseType_t uxOther = 1 - uxHalf;
+
+	xStats.ulBlocksFilled++;
+
+	/* The DMA has moved on to the other half. */
+	if( ( xHeld[ uxOther ] != pdFALSE ) && ( xOverwritten[ uxOther ] == pdFALSE ) )
+	{
+		xOverwritten[ uxOther ] = pdTRUE;
+		xStats.ulBlocksOverwritten++;
+	}
+
+	if( xHeld[ uxHalf ] != pdFALSE )
+	{
+		/* The processing task is a whole half behind. */
+		xStats.ulBlocksDropped++;
+	}
+	else
+	{
+		xBlock.pusSamples = &( usSamples[ uxHalf * adcsampleBLOCK_SAMPLES ] );
+		xBlock.ulSequence = xStats.ulBlocksFilled;
+		xHeld[ uxHalf ] = pdTRUE;
+		xOverwritten[ uxHalf ] = pdFALSE;
+
+		if( xMessageBufferSendFromISR( xBlocks, ( void * ) &xBlock, sizeof( xBlock ), pxHigherPriorityTaskWoken ) == 0 )
+		{
+			xHeld[ uxHalf ] = pdFALSE;
+			xStats.ulBlocksDropped++;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+#if( adcsampleUSE_STM32 == 1 )
+
+	static void prvSTM32Start( void )
+	{
+	static const uint8_t ucChannels[ adcsampleCHANNELS ] = adcsampleCHANNEL_LIST;
+	ADC_InitTypeDef ADC_InitStructure;
+	TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+	TIM_OCInitTypeDef TIM_OCInitStructure;
+	UBaseType_t x;
+
+		/* The ADC clock must not exceed 14MHz. */
+		RCC_ADCCLKConfig( RCC_PCLK2_Div6 );
+		RCC_APB2PeriphClockCmd( RCC_APB2Periph_ADC1 | RCC_APB2Periph_GPIOA | RCC_APB2Periph_GPIOB | RCC_APB2Periph_GPIOC, ENABLE );
+		RCC_APB1PeriphClockCmd( RCC_APB1Periph_TIM4, ENABLE );
+
+		/* Each trigger converts the channels once, in turn.  Continuous
+		conversion would run the ADC flat out after the first trigger, and
+		leave the rate to the sample time. */
+		ADC_DeInit( ADC1 );
+		ADC_InitStructure.ADC_Mode = ADC_Mode_Independent;
+		ADC_InitStructure.ADC_ScanConvMode = ENABLE;
+		ADC_InitStructure.ADC_ContinuousConvMode = DISABLE;
+		ADC_InitStructure.ADC_ExternalTrigConv = ADC_ExternalTrigConv_T4_CC4;
+		ADC_InitStructure.ADC_DataAlign = ADC_DataAlign_Right;
+		ADC_InitStructure.ADC_NbrOfChannel = adcsampleCHANNELS;
+		ADC_Init( ADC1, &ADC_InitStructure );
+
+		for( x = 0; x < adcsampleCHANNELS; x++ )
+		{
+			prvSTM32ConfigurePin( ucChannels[ x ] );
+			ADC_RegularChannelConfig( ADC1, ucChannels[ x ], ( uint8_t ) ( x + 1 ), adcsampleSAMPLE_TIME );
+		}
+
+		ADC_DMACmd( ADC1, ENABLE );
+		ADC_Cmd( ADC1, ENABLE );
+
+		ADC_ResetCalibration( ADC1 );
+		while( ADC_GetResetCalibrationStatus( ADC1 ) != RESET )
+		{
+		}
+
+		ADC_StartCalibration( ADC1 );
+		while( ADC_GetCalibrationStatus( ADC1 ) != RESET )
+		{
+		}
+
+		ADC_ExternalTrigConvCmd( ADC1, ENABLE );
+
+		/* Compare channel 4 of TIM4 ends each period with the edge that
+		triggers the next scan. */
+		TIM_DeInit( TIM4 );
+		TIM_TimeBaseStructInit( &TIM_TimeBaseStructure );
+		TIM_TimeBaseStructure.TIM_Period = ( unsigned short ) ( ( configCPU_CLOCK_HZ / adcsampleRATE_HZ ) - 1UL );
+		TIM_TimeBaseStructure.TIM_Prescaler = 0x0;
+		TIM_TimeBaseStructure.TIM_ClockDivision = 0x0;
+		TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+		TIM_TimeBaseInit( TIM4, &TIM_TimeBaseStructure );
+		TIM_ARRPreloadConfig( TIM4, ENABLE );
+
+		TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_PWM1;
+		TIM_OCInitStructure.TIM_Channel = TIM_Channel_4;
+		TIM_OCInitStructure.TIM_Pulse = ( unsigned short ) ( configCPU_CLOCK_HZ / adcsampleRATE_HZ / 2UL );
+		TIM_OCInitStructure.TIM_OCPolarity = TIM_OCPolarity_High;
+		TIM_OCInit( TIM4, &TIM_OCInitStructure );
+
+		TIM_Cmd( TIM4, ENABLE );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvSTM32Stop( void )
+	{
+		TIM_Cmd( TIM4, DISABLE );
+		ADC_Cmd( ADC1, DISABLE );
+		ADC_DMACmd( ADC1, DISABLE );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvSTM32ConfigurePin( uint8_t ucChannel )
+	{
+	GPIO_InitTypeDef GPIO_InitStructure;
+	GPIO_TypeDef *pxPort;
+
+		/* Channels 0 to 7 are PA0 to PA7, 8 and 9 are PB0 and PB1, and 10 to
+		15 are PC0 to PC5. */
+		if( ucChannel < ADC_Channel_8 )
+		{
+			pxPort = GPIOA;
+		}
+		else if( ucChannel < ADC_Channel_10 )
+		{
+			pxPort = GPIOB;
+			ucChannel -= ADC_Channel_8;
+		}
+		else if( ucChannel < ADC_Channel_16 )
+		{
+			pxPort = GPIOC;
+			ucChannel -= ADC_Channel_10;
+		}
+		else
+		{
+			/* The temperature sensor and the reference are internal. */
+			ADC_TempSensorCmd( ENABLE );
+			return;
+		}
+
+		GPIO_InitStructure.GPIO_Pin = ( u16 ) ( 1U << ucChannel );
+		GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+		GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AIN;
+		GPIO_Init( pxPort, &GPIO_InitStructure );
+	}
+
+#endif /* adcsampleUSE_STM32 */
+/*-----------------------------------------------------------*/
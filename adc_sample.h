@@ -0,0 +1,116 @@
+#ifndef ADC_SAMPLE_H
+#define ADC_SAMPLE_H
+
+#include "FreeRTOS.h"
+
+/*
+ * Continuous sampling of several ADC1 channels.
+ *
+ * Compare channel 4 of TIM4 triggers a scan of the adcsampleCHANNELS channels
+ * of adcsampleCHANNEL_LIST adcsampleRATE_HZ times a second.  DMA channel 1,
+ * opened through the DMA service of dma_service.h, moves each conversion into
+ * a circular buffer of two halves, each holding adcsampleSCANS_PER_BLOCK
+ * scans.  While the DMA fills one half, the other is handed to the processing
+ * task: the interrupt that ends a half sends an ADCSampleBlock_t that points
+ * into the buffer through a message buffer, so the samples are never copied.
+ *
+ * The processing task receives each block with xADCSampleReceive(), and must
+ * pass it back to xADCSampleRelease() before the DMA returns to that half,
+ * that is within the time taken to fill the other half.  A block still held
+ * when the DMA starts to refill it is counted as overwritten, and
+ * xADCSampleRelease() returns pdFAIL for it, as its samples may have
+ * changed while they were processed.  A half that ends while the processing
+ * task still holds it from the time before is not sent, and is counted as
+ * dropped.  The gap shows in the sequence numbers of the blocks received.
+ *
+ * When adcsampleUSE_STM32 is 0 the ADC and the timer are not touched, so the
+ * pipeline can be run on a host against a simulation of the DMA controller
+ * passed to vDMAServiceInit(), which fills the buffer and reports each half.
+ */
+
+/* The number of channels converted by each scan, 1 to 16, and the channels
+themselves, in the order they are converted.  ADC_Channel_16 and
+ADC_Channel_17 are the internal temperature sensor and reference, which need
+a sample time of 17.1us. */
+#ifndef adcsampleCHANNELS
+	#define adcsampleCHANNELS			2
+#endif
+
+#ifndef adcsampleCHANNEL_LIST
+	#define adcsampleCHANNEL_LIST		{ ADC_Channel_14, ADC_Channel_15 }
+#endif
+
+/* The number of scans a second.  TIM4 is clocked at configCPU_CLOCK_HZ and
+has no prescaler, so the rate must be at least configCPU_CLOCK_HZ / 65536,
+which adc_sample.c checks. */
+#ifndef adcsampleRATE_HZ
+	#define adcsampleRATE_HZ			20000UL
+#endif
+
+/* The sample time of each conversion, one of the ADC_SampleTime_ values of
+stm32f10x_adc.h.  With the ADC clocked at 12MHz, a conversion takes the sample
+time plus 12.5 cycles, and a scan must end before the next trigger. */
+#ifndef adcsampleSAMPLE_TIME
+	#define adcsampleSAMPLE_TIME		ADC_SampleTime_28Cycles5
+#endif
+
+/* The number of scans in each block, and so how long the processing task has
+to process one. */
+#ifndef adcsampleSCANS_PER_BLOCK
+	#define adcsampleSCANS_PER_BLOCK	32
+#endif
+
+/* Set to 1 to drive the ADC and TIM4 of the STM32F103. */
+#ifndef adcsampleUSE_STM32
+	#define adcsampleUSE_STM32			1
+#endif
+
+/* The number of samples in a block. */
+#define adcsampleBLOCK_SAMPLES			( adcsampleSCANS_PER_BLOCK * adcsampleCHANNELS )
+
+/* A half of the buffer that holds a full set of scans. */
+typedef struct ADC_SAMPLE_BLOCK
+{
+	const uint16_t *pusSamples;		/* adcsampleBLOCK_SAMPLES samples, a scan of every channel after another. */
+	uint32_t ulSequence;			/* Counts the halves filled, including those dropped. */
+} ADCSampleBlock_t;
+
+typedef struct ADC_SAMPLE_STATS
+{
+	uint32_t ulBlocksFilled;		/* Halves filled by the DMA. */
+	uint32_t ulBlocksDropped;		/* Halves not sent as the processing task still held them. */
+	uint32_t ulBlocksOverwritten;	/* Halves the DMA started to refill while the processing task held them. */
+	uint32_t ulErrors;				/* DMA transfer errors, each of which stops the sampling. */
+} ADCSampleStats_t;
+
+/*
+ * Starts the sampling.  vDMAServiceInit() must have been called, as main()
+ * does, and DMA channel 1 must be free.  Returns pdFAIL if the channel or the message
+ * buffer could not be had.
+ */
+BaseType_t xADCSampleStart( void );
+
+/*
+ * Stops the sampling.  Blocks that have not been received are discarded.
+ */
+void vADCSampleStop( void );
+
+/*
+ * Waits up to xTicksToWait for the next block and copies its descriptor into
+ * *pxBlock.  Returns pdFAIL if no block arrived in time.  Called by a single
+ * processing task.
+ */
+BaseType_t xADCSampleReceive( ADCSampleBlock_t *pxBlock, TickType_t xTicksToWait );
+
+/*
+ * Hands the block back once its samples have been processed.  Returns pdFAIL
+ * if the DMA started to refill the block before it was released.
+ */
+BaseType_t xADCSampleRelease( const ADCSampleBlock_t *pxBlock );
+
+/*
+ * Fills in *pxStats.
+ */
+void vADCSampleGetStats( ADCSampleStats_t *pxStats );
+
+#endif /* ADC_SAMPLE_H */
@@ -0,0 +1,588 @@
+/* Shared DMA channel service, see dma_service.h. */
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Library includes. */
+#include "stm32f10x_lib.h"
+
+/* Demo application includes. */
+#include "dma_service.h"
+
+/* For LCD_USE_DMA and SPI_FLASH_USE_RTOS.  serial.c checks the channels of the
+serial ports against dmaserviceCHANNELS itself. */
+#include "lcd.h"
+#include "spi_flash.h"
+
+/* The interrupt handlers of the channels in dmaserviceCHANNELS are defined
+here, so they must not also be defined by the drivers that use channels
+directly. */
+#if( dmaserviceUSE_STM32 == 1 )
+
+	#if( ( LCD_USE_DMA == 1 ) && ( ( dmaserviceCHANNELS & ( 1UL << 5 ) ) != 0 ) )
+		#error lcd.c uses DMA channel 5.  Remove it from dmaserviceCHANNELS or set LCD_USE_DMA to 0.
+	#endif
+
+	#if( ( SPI_FLASH_USE_RTOS == 1 ) && ( ( dmaserviceCHANNELS & ( ( 1UL << 2 ) | ( 1UL << 3 ) ) ) != 0 ) )
+		#error spi_flash.c uses DMA channels 2 and 3.  Remove them from dmaserviceCHANNELS or set SPI_FLASH_USE_RTOS to 0.
+	#endif
+
+#endif /* dmaserviceUSE_STM32 */
+
+#define dmaserviceNUM_CHANNELS			7
+
+/* The channel of each DMARequest_t, 0 for any channel. */
+static const uint8_t ucRequestChannels[] =
+{
+	1,				/* eDMARequestADC1 */
+	2, 3,			/* eDMARequestSPI1Rx, eDMARequestSPI1Tx */
+	2, 3,			/* eDMARequestUSART3Tx, eDMARequestUSART3Rx */
+	4, 5,			/* eDMARequestSPI2Rx, eDMARequestSPI2Tx */
+	4, 5,			/* eDMARequestUSART1Tx, eDMARequestUSART1Rx */
+	6, 7,			/* eDMARequestUSART2Rx, eDMARequestUSART2Tx */
+	6, 7,			/* eDMARequestI2C1Tx, eDMARequestI2C1Rx */
+	4, 5,			/* eDMARequestI2C2Tx, eDMARequestI2C2Rx */
+	0				/* eDMARequestMemory */
+};
+
+/*-----------------------------------------------------------*/
+
+typedef struct DMA_CHANNEL
+{
+	UBaseType_t uxChannel;			/* 1 to 7. */
+	BaseType_t xOpen;
+	uint32_t ulPriority;			/* The DMA_Priority_ value of the channel. */
+	DMATransfer_t *pxQueue;			/* The chains submitted, the active one first. */
+	DMATransfer_t *pxActive;		/* The descriptor being moved, or NULL while the channel is idle. */
+} DMAChannel_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Adds the chain that starts at pxTransfer to the queue of pxChannel, and
+ * starts it if the channel is idle.  Called with interrupts masked.
+ */
+static BaseType_t prvSubmit( DMAChannel_t *pxChannel, DMATransfer_t *pxTransfer, TaskHandle_t xTask, UBaseType_t uxPriority );
+
+/*
+ * Starts the chain at the head of the queue of pxChannel, if there is one.
+ */
+static void prvStartChain( DMAChannel_t *pxChannel );
+
+/*
+ * Programs pxChannel with pxTransfer and starts it.
+ */
+static void prvStartTransfer( DMAChannel_t *pxChannel, DMATransfer_t *pxTransfer );
+
+/*
+ * Removes the active chain from the queue of pxChannel, notifies the task
+ * that submitted it, and starts the next chain.
+ */
+static void prvEndChain( DMAChannel_t *pxChannel, BaseType_t *pxHigherPriorityTaskWoken );
+
+#if( dmaserviceUSE_STM32 == 1 )
+	static void prvSTM32Enable( UBaseType_t uxChannel, BaseType_t xEnable );
+	static void prvSTM32Start( UBaseType_t uxChannel, const DMATransfer_t *pxTransfer, uint32_t ulConfig );
+	static void prvSTM32Stop( UBaseType_t uxChannel );
+	static uint16_t prvSTM32Remaining( UBaseType_t uxChannel );
+	static void prvSTM32Interrupt( UBaseType_t uxChannel );
+#endif
+
+/*-----------------------------------------------------------*/
+
+#if( dmaserviceUSE_STM32 == 1 )
+	const DMAServiceHardware_t xDMAServiceSTM32Hardware =
+	{
+		prvSTM32Enable,
+		prvSTM32Start,
+		prvSTM32Stop,
+		prvSTM32Remaining
+	};
+#endif
+
+static const DMAServiceHardware_t *pxHardware = NULL;
+static DMAChannel_t xChannels[ dmaserviceNUM_CHANNELS ];
+
+/*-----------------------------------------------------------*/
+
+void vDMAServiceInit( const DMAServiceHardware_t *pxDMAHardware )
+{
+UBaseType_t x;
+
+	pxHardware = pxDMAHardware;
+
+	for( x = 0; x < dmaserviceNUM_CHANNELS; x++ )
+	{
+		xChannels[ x ].uxChannel = x + 1;
+		xChannels[ x ].xOpen = pdFALSE;
+		xChannels[ x ].ulPriority = 0;
+		xChannels[ x ].pxQueue = NULL;
+		xChannels[ x ].pxActive = NULL;
+	}
+}
+/*-----------------------------------------------------------*/
+
+DMAChannelHandle_t xDMAServiceOpen( DMARequest_t eRequest, uint32_t ulPriority )
+{
+DMAChannel_t *pxChannel = NULL;
+UBaseType_t x;
+
+	configASSERT( pxHardware != NULL );
+	configASSERT( ( UBaseType_t ) eRequest < sizeof( ucRequestChannels ) );
+
+	taskENTER_CRITICAL();
+	{
+		for( x = 1; x <= dmaserviceNUM_CHANNELS; x++ )
+		{
+			/* A memory to memory transfer can use any channel, the others
+			only the channel their request is wired to. */
+			if( ( ( ucRequestChannels[ eRequest ] == 0 ) || ( ucRequestChannels[ eRequest ] == x ) ) &&
+				( ( dmaserviceCHANNELS & ( 1UL << x ) ) != 0UL ) &&
+				( xChannels[ x - 1 ].xOpen == pdFALSE ) )
+			{
+				pxChannel = &( xChannels[ x - 1 ] );
+				pxChannel->xOpen = pdTRUE;
+				pxChannel->ulPriority = ulPriority;
+				break;
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if( pxChannel != NULL )
+	{
+		pxHardware->pxEnable( pxChannel->uxChannel, pdTRUE );
+	}
+
+	return pxChannel;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDMAServiceClose( DMAChannelHandle_t xChannel )
+{
+DMAChannel_t * const pxChannel = ( DMAChannel_t * ) xChannel;
+BaseType_t xReturn = pdFAIL;
+
+	taskENTER_CRITICAL();
+	{
+		if( pxChannel->pxQueue == NULL )
+		{
+			pxChannel->xOpen = pdFALSE;
+			xReturn = pdPASS;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if( xReturn != pdFAIL )
+	{
+		pxHardware->pxEnable( pxChannel->uxChannel, pdFALSE );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDMAServiceSubmit( DMAChannelHandle_t xChannel, DMATransfer_t *pxTransfer )
+{
+BaseType_t xReturn;
+
+	taskENTER_CRITICAL();
+	{
+		xReturn = prvSubmit( ( DMAChannel_t * ) xChannel, pxTransfer, xTaskGetCurrentTaskHandle(), uxTaskPriorityGet( NULL ) );
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDMAServiceSubmitFromISR( DMAChannelHandle_t xChannel, DMATransfer_t *pxTransfer )
+{
+BaseType_t xReturn;
+UBaseType_t uxSavedInterruptStatus;
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		xReturn = prvSubmit( ( DMAChannel_t * ) xChannel, pxTransfer, NULL, configMAX_PRIORITIES );
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDMAServiceWait( DMATransfer_t *pxTransfer, TickType_t xTicksToWait )
+{
+TimeOut_t xTimeOut;
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	/* The notification may also have been given by the end of another chain
+	of this task, so the status is checked each time the task wakes. */
+	while( ( pxTransfer->xStatus == dmaserviceSTATUS_QUEUED ) || ( pxTransfer->xStatus == dmaserviceSTATUS_ACTIVE ) )
+	{
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+		{
+			break;
+		}
+
+		( void ) ulTaskNotifyTakeIndexed( dmaserviceNOTIFY_INDEX, pdTRUE, xTicksToWait );
+	}
+
+	return pxTransfer->xStatus;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDMAServiceCancel( DMAChannelHandle_t xChannel, DMATransfer_t *pxTransfer )
+{
+DMAChannel_t * const pxChannel = ( DMAChannel_t * ) xChannel;
+DMATransfer_t **ppxLink;
+BaseType_t xReturn = pdFAIL;
+
+	taskENTER_CRITICAL();
+	{
+		for( ppxLink = &( pxChannel->pxQueue ); *ppxLink != NULL; ppxLink = &( ( *ppxLink )->pxQueueNext ) )
+		{
+			if( *ppxLink == pxTransfer )
+			{
+				*ppxLink = pxTransfer->pxQueueNext;
+				pxTransfer->xStatus = dmaserviceSTATUS_CANCELLED;
+				xReturn = pdPASS;
+
+				/* The first chain is the one being moved. */
+				if( ( ppxLink == &( pxChannel->pxQueue ) ) && ( pxChannel->pxActive != NULL ) )
+				{
+					pxHardware->pxStop( pxChannel->uxChannel );
+					pxChannel->pxActive = NULL;
+					prvStartChain( pxChannel );
+				}
+
+				break;
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint16_t usDMAServiceRemaining( DMAChannelHandle_t xChannel )
+{
+DMAChannel_t * const pxChannel = ( DMAChannel_t * ) xChannel;
+uint16_t usReturn = 0;
+
+	taskENTER_CRITICAL();
+	{
+		if( pxChannel->pxActive != NULL )
+		{
+			usReturn = pxHardware->pxRemaining( pxChannel->uxChannel );
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return usReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vDMAServiceInterrupt( UBaseType_t uxChannel, uint32_t ulEvents )
+{
+DMAChannel_t * const pxChannel = &( xChannels[ uxChannel - 1 ] );
+DMATransfer_t *pxTransfer;
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+UBaseType_t uxSavedInterruptStatus;
+
+	/* A chain can be submitted from a higher priority interrupt. */
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		pxTransfer = pxChannel->pxActive;
+
+		if( pxTransfer == NULL )
+		{
+			/* The chain was cancelled as the transfer ended. */
+		}
+		else if( ( ulEvents & dmaserviceEVENT_ERROR ) != 0UL )
+		{
+			/* The channel has stopped.  Abandon the rest of the chain. */
+			pxHardware->pxStop( uxChannel );
+			pxChannel->pxQueue->xStatus = dmaserviceSTATUS_ERROR;
+
+			if( pxTransfer->pxCallback != NULL )
+			{
+				pxTransfer->pxCallback( pxTransfer, dmaserviceEVENT_ERROR, &xHigherPriorityTaskWoken );
+			}
+
+			prvEndChain( pxChannel, &xHigherPriorityTaskWoken );
+		}
+		else if( ( pxTransfer->usConfig & DMA_Mode_Circular ) != 0U )
+		{
+			/* A circular descriptor runs until it is cancelled. */
+			if( pxTransfer->pxCallback != NULL )
+			{
+				if( ( ulEvents & dmaserviceEVENT_HALF ) != 0UL )
+				{
+					pxTransfer->pxCallback( pxTransfer, dmaserviceEVENT_HALF, &xHigherPriorityTaskWoken );
+				}
+
+				if( ( ulEvents & dmaserviceEVENT_COMPLETE ) != 0UL )
+				{
+					pxTransfer->pxCallback( pxTransfer, dmaserviceEVENT_COMPLETE, &xHigherPriorityTaskWoken );
+				}
+			}
+		}
+		else if( ( ulEvents & dmaserviceEVENT_COMPLETE ) != 0UL )
+		{
+			/* Start the next descriptor of the chain before anything else, to
+			keep the gap between the two short. */
+			if( pxTransfer->pxNext != NULL )
+			{
+				pxChannel->pxActive = pxTransfer->pxNext;
+				prvStartTransfer( pxChannel, pxTransfer->pxNext );
+			}
+			else
+			{
+				pxChannel->pxQueue->xStatus = dmaserviceSTATUS_DONE;
+			}
+
+			if( pxTransfer->pxCallback != NULL )
+			{
+				pxTransfer->pxCallback( pxTransfer, dmaserviceEVENT_COMPLETE, &xHigherPriorityTaskWoken );
+			}
+
+			if( pxTransfer->pxNext == NULL )
+			{
+				prvEndChain( pxChannel, &xHigherPriorityTaskWoken );
+			}
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSubmit( DMAChannel_t *pxChannel, DMATransfer_t *pxTransfer, TaskHandle_t xTask, UBaseType_t uxPriority )
+{
+DMATransfer_t **ppxLink;
+DMATransfer_t *pxDescriptor = pxTransfer;
+
+	configASSERT( pxChannel->xOpen != pdFALSE );
+
+	if( ( pxTransfer->xStatus == dmaserviceSTATUS_QUEUED ) || ( pxTransfer->xStatus == dmaserviceSTATUS_ACTIVE ) )
+	{
+		return pdFAIL;
+	}
+
+	/* The channel would never end a descriptor with nothing to move.  A chain
+	either ends or loops back to its first descriptor. */
+	do
+	{
+		if( pxDescriptor->usCount == 0U )
+		{
+			return pdFAIL;
+		}
+
+		pxDescriptor = pxDescriptor->pxNext;
+	} while( ( pxDescriptor != NULL ) && ( pxDescriptor != pxTransfer ) );
+
+	pxTransfer->xStatus = dmaserviceSTATUS_QUEUED;
+	pxTransfer->xTask = xTask;
+	pxTransfer->uxPriority = uxPriority;
+
+	/* Queue the chain behind the active chain and the chains of the same or
+	higher priority. */
+	ppxLink = &( pxChannel->pxQueue );
+
+	if( pxChannel->pxActive != NULL )
+	{
+		ppxLink = &( pxChannel->pxQueue->pxQueueNext );
+	}
+
+	while( ( *ppxLink != NULL ) && ( ( *ppxLink )->uxPriority >= uxPriority ) )
+	{
+		ppxLink = &( ( *ppxLink )->pxQueueNext );
+	}
+
+	pxTransfer->pxQueueNext = *ppxLink;
+	*ppxLink = pxTransfer;
+
+	if( pxChannel->pxActive == NULL )
+	{
+		prvStartChain( pxChannel );
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvStartChain( DMAChannel_t *pxChannel )
+{
+DMATransfer_t * const pxTransfer = pxChannel->pxQueue;
+
+	if( pxTransfer != NULL )
+	{
+		pxTransfer->xStatus = dmaserviceSTATUS_ACTIVE;
+		pxChannel->pxActive = pxTransfer;
+		prvStartTransfer( pxChannel, pxTransfer );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvStartTransfer( DMAChannel_t *pxChannel, DMATransfer_t *pxTransfer )
+{
+uint32_t ulConfig;
+
+	ulConfig = ( uint32_t ) pxTransfer->usConfig | pxChannel->ulPriority | DMA_IT_TC | DMA_IT_TE;
+
+	if( ( pxTransfer->usConfig & DMA_Mode_Circular ) != 0U )
+	{
+		ulConfig |= DMA_IT_HT;
+	}
+
+	pxHardware->pxStart( pxChannel->uxChannel, pxTransfer, ulConfig );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEndChain( DMAChannel_t *pxChannel, BaseType_t *pxHigherPriorityTaskWoken )
+{
+DMATransfer_t * const pxTransfer = pxChannel->pxQueue;
+
+	pxChannel->pxQueue = pxTransfer->pxQueueNext;
+	pxChannel->pxActive = NULL;
+
+	if( pxTransfer->xTask != NULL )
+	{
+		vTaskNotifyGiveIndexedFromISR( pxTransfer->xTask, dmaserviceNOTIFY_INDEX, pxHigherPriorityTaskWoken );
+	}
+
+	prvStartChain( pxChannel );
+}
+/*-----------------------------------------------------------*/
+
+#if( dmaserviceUSE_STM32 == 1 )
+
+	#define dmaserviceSTM32_CHANNEL( uxChannel )	( ( DMA_Channel_TypeDef * ) ( DMA_Channel1_BASE + ( ( ( uxChannel ) - 1 ) * 0x14UL ) ) )
+	#define dmaserviceSTM32_SHIFT( uxChannel )		( ( ( uxChannel ) - 1 ) * 4UL )
+	#define dmaserviceSTM32_ENABLE					( ( u32 ) 0x00000001 )
+
+	static void prvSTM32Enable( UBaseType_t uxChannel, BaseType_t xEnable )
+	{
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+		/* The controller is shared with the drivers that use it directly, so
+		its clock is never stopped. */
+		RCC_AHBPeriphClockCmd( RCC_AHBPeriph_DMA, ENABLE );
+
+		if( xEnable == pdFALSE )
+		{
+			prvSTM32Stop( uxChannel );
+		}
+
+		NVIC_InitStructure.NVIC_IRQChannel = ( u8 ) ( DMAChannel1_IRQChannel + ( uxChannel - 1 ) );
+		NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = configLIBRARY_KERNEL_INTERRUPT_PRIORITY;
+		NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+		NVIC_InitStructure.NVIC_IRQChannelCmd = ( xEnable != pdFALSE ) ? ENABLE : DISABLE;
+		NVIC_Init( &NVIC_InitStructure );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvSTM32Start( UBaseType_t uxChannel, const DMATransfer_t *pxTransfer, uint32_t ulConfig )
+	{
+	DMA_Channel_TypeDef * const pxDMAChannel = dmaserviceSTM32_CHANNEL( uxChannel );
+
+		/* The channel can only be programmed while it is disabled. */
+		pxDMAChannel->CCR = 0;
+		DMA->IFCR = DMA_IT_GL1 << dmaserviceSTM32_SHIFT( uxChannel );
+		pxDMAChannel->CPAR = pxTransfer->ulPeripheralAddress;
+		pxDMAChannel->CMAR = pxTransfer->ulMemoryAddress;
+		pxDMAChannel->CNDTR = pxTransfer->usCount;
+		pxDMAChannel->CCR = ulConfig | dmaserviceSTM32_ENABLE;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvSTM32Stop( UBaseType_t uxChannel )
+	{
+		dmaserviceSTM32_CHANNEL( uxChannel )->CCR = 0;
+		DMA->IFCR = DMA_IT_GL1 << dmaserviceSTM32_SHIFT( uxChannel );
+	}
+	/*-----------------------------------------------------------*/
+
+	static uint16_t prvSTM32Remaining( UBaseType_t uxChannel )
+	{
+		return ( uint16_t ) dmaserviceSTM32_CHANNEL( uxChannel )->CNDTR;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvSTM32Interrupt( UBaseType_t uxChannel )
+	{
+	uint32_t ulEvents;
+
+		/* The flags of each channel have the layout of the dmaserviceEVENT_
+		values, shifted by four bits per channel. */
+		ulEvents = ( DMA->ISR >> dmaserviceSTM32_SHIFT( uxChannel ) ) & ( dmaserviceEVENT_COMPLETE | dmaserviceEVENT_HALF | dmaserviceEVENT_ERROR );
+		DMA->IFCR = ( ulEvents | DMA_IT_GL1 ) << dmaserviceSTM32_SHIFT( uxChannel );
+
+		vDMAServiceInterrupt( uxChannel, ulEvents );
+	}
+	/*-----------------------------------------------------------*/
+
+	/* The interrupt handlers, named as in the vector table. */
+	#if( ( dmaserviceCHANNELS & ( 1UL << 1 ) ) != 0 )
+		void DMAChannel1_IRQHandler( void );
+		void DMAChannel1_IRQHandler( void )
+		{
+			prvSTM32Interrupt( 1 );
+		}
+	#endif
+
+	#if( ( dmaserviceCHANNELS & ( 1UL << 2 ) ) != 0 )
+		void DMAChannel2_IRQHandler( void );
+		void DMAChannel2_IRQHandler( void )
+		{
+			prvSTM32Interrupt( 2 );
+		}
+	#endif
+
+	#if( ( dmaserviceCHANNELS & ( 1UL << 3 ) ) != 0 )
+		void DMAChannel3_IRQHandler( void );
+		void DMAChannel3_IRQHandler( void )
+		{
+			prvSTM32Interrupt( 3 );
+		}
+	#endif
+
+	#if( ( dmaserviceCHANNELS & ( 1UL << 4 ) ) != 0 )
+		void DMAChannel4_IRQHandler( void );
+		void DMAChannel4_IRQHandler( void )
+		{
+			prvSTM32Interrupt( 4 );
+		}
+	#endif
+
+	#if( ( dmaserviceCHANNELS & ( 1UL << 5 ) ) != 0 )
+		void DMAChannel5_IRQHandler( void );
+		void DMAChannel5_IRQHandler( void )
+		{
+			prvSTM32Interrupt( 5 );
+		}
+	#endif
+
+	#if( ( dmaserviceCHANNELS & ( 1UL << 6 ) ) != 0 )
+		void DMAChannel6_IRQHandler( void );
+		void DMAChannel6_IRQHandler( void )
+		{
+			prvSTM32Interrupt( 6 );
+		}
+	#endif
+
+	#if( ( dmaserviceCHANNELS & ( 1UL << 7 ) ) != 0 )
+		void DMAChannel7_IRQHandler( void );
+		void DMAChannel7_IRQHandler( void )
+		{
+			prvSTM32Interrupt( 7 );
+		}
+	#endif
+
+#endif /* dmaserviceUSE_STM32 */
+/*-----------------------------------------------------------*/
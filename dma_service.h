@@ -0,0 +1,209 @@
+#ifndef DMA_SERVICE_H
+#define DMA_SERVICE_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*
+ * Shared service for the seven channels of the STM32F103 DMA controller.
+ *
+ * Each peripheral request is wired to one fixed channel, and several
+ * requests share each channel (SPI1 and USART3 share channels 2 and 3, SPI2,
+ * USART1 and I2C2 share channels 4 and 5).  A driver opens the channel of its
+ * request with xDMAServiceOpen(), which fails if another driver already has
+ * the channel open, so two drivers can no longer program the same channel.
+ *
+ * Transfers are described by DMATransfer_t descriptors that belong to the
+ * caller and must stay valid until the transfer has ended.  Descriptors can be
+ * linked into a chain through pxNext, and the service starts each descriptor
+ * of a chain from the interrupt of the one before, so a chain of scattered
+ * buffers is moved without the CPU copying them together.  Chains submitted
+ * while the channel is busy wait in a queue held per channel, ordered by the
+ * priority of the submitting task and then by the order they were submitted.
+ *
+ * The task that submitted a chain receives a task notification, at index
+ * dmaserviceNOTIFY_INDEX, once the whole chain has ended, and
+ * xDMAServiceWait() blocks on it.  A descriptor can also name a function that
+ * is called from the interrupt when it ends.  A descriptor configured with
+ * DMA_Mode_Circular runs until it is cancelled, and its function is called
+ * at each half and full buffer, as for double buffering.
+ *
+ * The service reaches the hardware through the functions of a
+ * DMAServiceHardware_t, so it can be run against the DMA controller, or
+ * against a simulation of it on a host that calls vDMAServiceInterrupt() as
+ * the simulated transfers end.
+ */
+
+/* The channels the service owns, bit n set for channel n.  The service
+defines the interrupt handler of each of them when dmaserviceUSE_STM32 is 1, so
+the channels used directly by other drivers must be left out: with their
+default settings serial.c uses channels 4 to 7, and spi_flash.c channels 2 and
+3, and lcd.c uses channel 5 when LCD_USE_DMA is 1.  A channel owned by both
+the service and one of these drivers is an #error.  Channel 1 serves ADC1. */
+#ifndef dmaserviceCHANNELS
+	#define dmaserviceCHANNELS			( 1UL << 1 )
+#endif
+
+/* The task notification index used to signal the end of a chain.  It must not
+be an index the submitting task waits on for another reason while its chains
+are pending - spi_flash.c uses configTASK_NOTIFICATION_ARRAY_ENTRIES - 1 and
+lcd.c configTASK_NOTIFICATION_ARRAY_ENTRIES - 2. */
+#ifndef dmaserviceNOTIFY_INDEX
+	#define dmaserviceNOTIFY_INDEX		0
+#endif
+
+/* Set to 1 to include xDMAServiceSTM32Hardware and the interrupt handlers of
+the channels in dmaserviceCHANNELS. */
+#ifndef dmaserviceUSE_STM32
+	#define dmaserviceUSE_STM32			1
+#endif
+
+/* The values of DMATransfer_t.xStatus. */
+#define dmaserviceSTATUS_IDLE			0	/* Not yet submitted. */
+#define dmaserviceSTATUS_QUEUED			1	/* Waiting for the channel. */
+#define dmaserviceSTATUS_ACTIVE			2	/* Being moved. */
+#define dmaserviceSTATUS_DONE			3
+#define dmaserviceSTATUS_ERROR			4	/* The channel reported a transfer error. */
+#define dmaserviceSTATUS_CANCELLED		5
+
+/* The events passed to DMATransfer_t.pxCallback, and to
+vDMAServiceInterrupt(). */
+#define dmaserviceEVENT_COMPLETE		0x02UL
+#define dmaserviceEVENT_HALF			0x04UL
+#define dmaserviceEVENT_ERROR			0x08UL
+
+/* The peripheral requests of the DMA controller. */
+typedef enum
+{
+	eDMARequestADC1 = 0,		/* Channel 1. */
+	eDMARequestSPI1Rx,			/* Channel 2. */
+	eDMARequestSPI1Tx,			/* Channel 3. */
+	eDMARequestUSART3Tx,		/* Channel 2. */
+	eDMARequestUSART3Rx,		/* Channel 3. */
+	eDMARequestSPI2Rx,			/* Channel 4. */
+	eDMARequestSPI2Tx,			/* Channel 5. */
+	eDMARequestUSART1Tx,		/* Channel 4. */
+	eDMARequestUSART1Rx,		/* Channel 5. */
+	eDMARequestUSART2Rx,		/* Channel 6. */
+	eDMARequestUSART2Tx,		/* Channel 7. */
+	eDMARequestI2C1Tx,			/* Channel 6. */
+	eDMARequestI2C1Rx,			/* Channel 7. */
+	eDMARequestI2C2Tx,			/* Channel 4. */
+	eDMARequestI2C2Rx,			/* Channel 5. */
+	eDMARequestMemory			/* Memory to memory, on any free channel. */
+} DMARequest_t;
+
+typedef struct DMA_TRANSFER
+{
+	/* Set by the caller. */
+	uint32_t ulPeripheralAddress;	/* The peripheral register, or the source of a memory to memory transfer. */
+	uint32_t ulMemoryAddress;
+	uint16_t usCount;				/* The number of items, 1 to 65535. */
+	uint16_t usConfig;				/* The OR of the DMA_DIR_, DMA_PeripheralInc_, DMA_MemoryInc_, DMA_PeripheralDataSize_, DMA_MemoryDataSize_, DMA_Mode_ and DMA_M2M_ values of stm32f10x_dma.h. */
+	struct DMA_TRANSFER *pxNext;	/* The next descriptor of the chain, or NULL. */
+
+	/* Optional, called from the interrupt with dmaserviceEVENT_COMPLETE when
+	the descriptor ends, with dmaserviceEVENT_HALF half way through a circular
+	descriptor, and with dmaserviceEVENT_ERROR if the chain fails. */
+	void ( *pxCallback )( struct DMA_TRANSFER *pxTransfer, uint32_t ulEvent, BaseType_t *pxHigherPriorityTaskWoken );
+	void *pvContext;				/* For use by pxCallback. */
+
+	/* Set by the service.  Only the first descriptor of a chain is updated,
+	and xStatus must be dmaserviceSTATUS_IDLE, or a status the chain ended
+	with, when the chain is submitted. */
+	volatile BaseType_t xStatus;
+	TaskHandle_t xTask;				/* The task notified when the chain ends, or NULL. */
+	UBaseType_t uxPriority;			/* Orders the queue of the channel. */
+	struct DMA_TRANSFER *pxQueueNext;
+} DMATransfer_t;
+
+typedef struct DMA_SERVICE_HARDWARE
+{
+	/* Enables or disables the clock of the controller and the interrupt of
+	uxChannel (1 to 7). */
+	void ( *pxEnable )( UBaseType_t uxChannel, BaseType_t xEnable );
+
+	/* Programs uxChannel with pxTransfer and starts it.  ulConfig holds the
+	value of the channel configuration register: usConfig with the channel
+	priority and the interrupt enable bits added. */
+	void ( *pxStart )( UBaseType_t uxChannel, const DMATransfer_t *pxTransfer, uint32_t ulConfig );
+
+	/* Stops uxChannel. */
+	void ( *pxStop )( UBaseType_t uxChannel );
+
+	/* Returns the number of items uxChannel has still to move. */
+	uint16_t ( *pxRemaining )( UBaseType_t uxChannel );
+} DMAServiceHardware_t;
+
+typedef struct DMA_CHANNEL *DMAChannelHandle_t;
+
+#if( dmaserviceUSE_STM32 == 1 )
+	/* The DMA controller of the STM32F103. */
+	extern const DMAServiceHardware_t xDMAServiceSTM32Hardware;
+#endif
+
+/*
+ * Selects the hardware used by the service.  Must be called before any other
+ * function.
+ */
+void vDMAServiceInit( const DMAServiceHardware_t *pxHardware );
+
+/*
+ * Opens the channel of eRequest for the caller, with ulPriority, one of the
+ * DMA_Priority_ values of stm32f10x_dma.h, as its priority in the DMA
+ * controller.  Returns NULL if the channel is not in dmaserviceCHANNELS, or is
+ * already open.
+ */
+DMAChannelHandle_t xDMAServiceOpen( DMARequest_t eRequest, uint32_t ulPriority );
+
+/*
+ * Closes xChannel.  Returns pdFAIL, and leaves the channel open, if a chain
+ * is active or queued on it.
+ */
+BaseType_t xDMAServiceClose( DMAChannelHandle_t xChannel );
+
+/*
+ * Queues the chain that starts at pxTransfer on xChannel, starting it at once
+ * if the channel is idle.  The calling task is notified when the chain ends.
+ * Returns pdFAIL if a descriptor of the chain has a count of 0, or the chain
+ * is already queued.
+ */
+BaseType_t xDMAServiceSubmit( DMAChannelHandle_t xChannel, DMATransfer_t *pxTransfer );
+
+/*
+ * As xDMAServiceSubmit(), for use from interrupts.  No task is notified, so
+ * the end of the chain is only reported through pxCallback.  The chain is
+ * queued ahead of the chains submitted by tasks.
+ */
+BaseType_t xDMAServiceSubmitFromISR( DMAChannelHandle_t xChannel, DMATransfer_t *pxTransfer );
+
+/*
+ * Waits up to xTicksToWait for the chain that starts at pxTransfer to end, and
+ * returns its status, which is dmaserviceSTATUS_QUEUED or
+ * dmaserviceSTATUS_ACTIVE if it has not ended in time.
+ */
+BaseType_t xDMAServiceWait( DMATransfer_t *pxTransfer, TickType_t xTicksToWait );
+
+/*
+ * Removes the chain that starts at pxTransfer from the queue of xChannel,
+ * stopping it if it is being moved, and starts the next chain.  Returns
+ * pdFAIL if the chain was not queued.  The chain is left
+ * dmaserviceSTATUS_CANCELLED and its task is not notified.
+ */
+BaseType_t xDMAServiceCancel( DMAChannelHandle_t xChannel, DMATransfer_t *pxTransfer );
+
+/*
+ * Returns the number of items the descriptor being moved by xChannel has
+ * still to move, or 0 if the channel is idle.  Used to find how far a
+ * circular descriptor has got.
+ */
+uint16_t usDMAServiceRemaining( DMAChannelHandle_t xChannel );
+
+/*
+ * Called by the interrupt handler of uxChannel (1 to 7), or by a simulation
+ * of the DMA controller, with the OR of the dmaserviceEVENT_ values that have
+ * occurred.
+ */
+void vDMAServiceInterrupt( UBaseType_t uxChannel, uint32_t ulEvents );
+
+#endif /* DMA_SERVICE_H */
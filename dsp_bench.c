@@ -0,0 +1,237 @@
+/* DSP benchmarks, see dsp_bench.h. */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo application includes. */
+#include "KernelBench.h"
+#include "dsp_fixed.h"
+#include "dsp_bench.h"
+
+/* The samples processed by each iteration, and the size of the filters. */
+#define benchDSP_BLOCK			( 64 )
+#define benchDSP_FIR_TAPS		( 32 )
+#define benchDSP_BIQUAD_STAGES	( 2 )
+#define benchDSP_CIC_ORDER		( 3 )
+#define benchDSP_CIC_DECIMATION	( 8 )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Fills the input blocks with noise and initialises the filters.
+ */
+static BaseType_t prvDSPSetUp( uint32_t ulParameter );
+
+/*
+ * Process one block, returning the cycles taken.
+ */
+static uint32_t prvDSPFIRIteration( void );
+static uint32_t prvDSPFIRFloatIteration( void );
+static uint32_t prvDSPBiquadIteration( void );
+static uint32_t prvDSPBiquadFloatIteration( void );
+static uint32_t prvDSPRMSIteration( void );
+static uint32_t prvDSPMinMaxIteration( void );
+static uint32_t prvDSPCICIteration( void );
+
+/*-----------------------------------------------------------*/
+
+static const BenchCase_t xDSPCases[] =
+{
+	{ "DSP FIR Q15 32 taps/64",			prvDSPFIRIteration,			NULL, 0, prvDSPSetUp, NULL, 0 },
+	{ "DSP FIR float 32 taps/64",		prvDSPFIRFloatIteration,	NULL, 0, prvDSPSetUp, NULL, 0 },
+	{ "DSP biquad Q31 2 stages/64",		prvDSPBiquadIteration,		NULL, 0, prvDSPSetUp, NULL, 0 },
+	{ "DSP biquad float 2 stages/64",	prvDSPBiquadFloatIteration,	NULL, 0, prvDSPSetUp, NULL, 0 },
+	{ "DSP RMS Q15/64",					prvDSPRMSIteration,			NULL, 0, prvDSPSetUp, NULL, 0 },
+	{ "DSP min/max Q15/64",				prvDSPMinMaxIteration,		NULL, 0, prvDSPSetUp, NULL, 0 },
+	{ "DSP CIC Q15 N3 R8/64",			prvDSPCICIteration,			NULL, 0, prvDSPSetUp, NULL, 0 },
+};
+
+#define benchDSP_CASES			( sizeof( xDSPCases ) / sizeof( xDSPCases[ 0 ] ) )
+
+static BenchHistogram_t xDSPHistograms[ benchDSP_CASES ];
+
+static BenchSuite_t xDSPSuite = { xDSPCases, xDSPHistograms, ( UBaseType_t ) benchDSP_CASES, pdFALSE, NULL };
+
+/* The blocks and filters.  The float filters have the same coefficients as
+the fixed point ones. */
+static int16_t sDSPIn[ benchDSP_BLOCK ], sDSPOut[ benchDSP_BLOCK ];
+static int32_t lDSPIn[ benchDSP_BLOCK ], lDSPOut[ benchDSP_BLOCK ];
+static float fDSPIn[ benchDSP_BLOCK ], fDSPOut[ benchDSP_BLOCK ];
+static int16_t sFIRCoefficients[ benchDSP_FIR_TAPS ];
+static int16_t sFIRState[ dspFIR_STATE_LENGTH( benchDSP_FIR_TAPS, benchDSP_BLOCK ) ];
+static float fFIRCoefficients[ benchDSP_FIR_TAPS ];
+static float fFIRState[ dspFIR_STATE_LENGTH( benchDSP_FIR_TAPS, benchDSP_BLOCK ) ];
+static int32_t lBiquadCoefficients[ benchDSP_BIQUAD_STAGES * dspBIQUAD_COEFFICIENTS ];
+static int32_t lBiquadState[ benchDSP_BIQUAD_STAGES * dspBIQUAD_STATE ];
+static float fBiquadCoefficients[ benchDSP_BIQUAD_STAGES * dspBIQUAD_COEFFICIENTS ];
+static float fBiquadState[ benchDSP_BIQUAD_STAGES * dspBIQUAD_STATE ];
+static DSPFIRQ15_t xDSPFIR;
+static DSPBiquadQ31_t xDSPBiquad;
+static DSPCICQ15_t xDSPCIC;
+
+/*-----------------------------------------------------------*/
+
+void vStartDSPBenchmarks( UBaseType_t uxPriority )
+{
+	vStartBenchmarkSuite( &xDSPSuite, uxPriority );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDSPSetUp( uint32_t ulParameter )
+{
+/* A Butterworth low pass section with its cut off at 5% of the sample rate,
+in the form used by vDSPBiquadQ31(). */
+static const float fSection[ dspBIQUAD_COEFFICIENTS ] =
+{
+	0.0200833656f, 0.0401667311f, 0.0200833656f, 1.5610180758f, -0.6413515381f
+};
+uint32_t ulRandom = 0x12345678UL;
+uint32_t ul;
+
+	( void ) ulParameter;
+
+	/* Half scale noise. */
+	for( ul = 0; ul < benchDSP_BLOCK; ul++ )
+	{
+		ulRandom = ( ulRandom * 1664525UL ) + 1013904223UL;
+		sDSPIn[ ul ] = ( int16_t ) ( ( int32_t ) ( ulRandom >> 17 ) - 16384L );
+		lDSPIn[ ul ] = ( int32_t ) sDSPIn[ ul ] * 65536L;
+		fDSPIn[ ul ] = ( float ) sDSPIn[ ul ] / 32768.0f;
+	}
+
+	/* A triangular window, which sums to one. */
+	for( ul = 0; ul < benchDSP_FIR_TAPS; ul++ )
+	{
+		sFIRCoefficients[ ul ] = ( int16_t ) ( ( ( ul < ( benchDSP_FIR_TAPS / 2 ) ) ? ( ul + 1UL ) : ( benchDSP_FIR_TAPS - ul ) ) * 32768UL /
+											   ( ( benchDSP_FIR_TAPS / 2 ) * ( ( benchDSP_FIR_TAPS / 2 ) + 1 ) ) );
+		fFIRCoefficients[ ul ] = ( float ) sFIRCoefficients[ ul ] / 32768.0f;
+	}
+
+	/* The coefficients are held halved, so a1 fits in Q31. */
+	for( ul = 0; ul < ( benchDSP_BIQUAD_STAGES * dspBIQUAD_COEFFICIENTS ); ul++ )
+	{
+		fBiquadCoefficients[ ul ] = fSection[ ul % dspBIQUAD_COEFFICIENTS ];
+		lBiquadCoefficients[ ul ] = ( int32_t ) ( fSection[ ul % dspBIQUAD_COEFFICIENTS ] * 1073741824.0f );
+	}
+
+	memset( ( void * ) fFIRState, 0x00, sizeof( fFIRState ) );
+	memset( ( void * ) fBiquadState, 0x00, sizeof( fBiquadState ) );
+	vDSPFIRInitQ15( &xDSPFIR, sFIRCoefficients, benchDSP_FIR_TAPS, 1, sFIRState, benchDSP_BLOCK );
+	vDSPBiquadInitQ31( &xDSPBiquad, lBiquadCoefficients, benchDSP_BIQUAD_STAGES, 1, lBiquadState );
+
+	return xDSPCICInitQ15( &xDSPCIC, benchDSP_CIC_ORDER, benchDSP_CIC_DECIMATION );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvDSPFIRIteration( void )
+{
+uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+	( void ) xDSPFIRQ15( &xDSPFIR, sDSPIn, sDSPOut, benchDSP_BLOCK );
+
+	return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvDSPFIRFloatIteration( void )
+{
+uint32_t ulStart = benchGET_CYCLE_COUNT();
+uint32_t ulSample, ulTap;
+float fAcc;
+
+	/* Structured as xDSPFIRQ15(). */
+	memcpy( ( void * ) &( fFIRState[ benchDSP_FIR_TAPS - 1 ] ), ( const void * ) fDSPIn, sizeof( fDSPIn ) );
+
+	for( ulSample = 0; ulSample < benchDSP_BLOCK; ulSample++ )
+	{
+		fAcc = 0.0f;
+
+		for( ulTap = 0; ulTap < benchDSP_FIR_TAPS; ulTap++ )
+		{
+			fAcc += fFIRCoefficients[ ulTap ] * fFIRState[ ( benchDSP_FIR_TAPS - 1 ) + ulSample - ulTap ];
+		}
+
+		fDSPOut[ ulSample ] = fAcc;
+	}
+
+	memmove( ( void * ) fFIRState, ( const void * ) &( fFIRState[ benchDSP_BLOCK ] ), ( benchDSP_FIR_TAPS - 1 ) * sizeof( float ) );
+
+	return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvDSPBiquadIteration( void )
+{
+uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+	vDSPBiquadQ31( &xDSPBiquad, lDSPIn, lDSPOut, benchDSP_BLOCK );
+
+	return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvDSPBiquadFloatIteration( void )
+{
+uint32_t ulStart = benchGET_CYCLE_COUNT();
+const float *pfIn = fDSPIn;
+const float *pfSection;
+float *pfState;
+float fX, fY;
+uint32_t ulStage, ulSample;
+
+	for( ulStage = 0; ulStage < benchDSP_BIQUAD_STAGES; ulStage++ )
+	{
+		pfSection = &( fBiquadCoefficients[ ulStage * dspBIQUAD_COEFFICIENTS ] );
+		pfState = &( fBiquadState[ ulStage * dspBIQUAD_STATE ] );
+
+		for( ulSample = 0; ulSample < benchDSP_BLOCK; ulSample++ )
+		{
+			fX = pfIn[ ulSample ];
+			fY = ( pfSection[ 0 ] * fX ) + ( pfSection[ 1 ] * pfState[ 0 ] ) + ( pfSection[ 2 ] * pfState[ 1 ] ) +
+				 ( pfSection[ 3 ] * pfState[ 2 ] ) + ( pfSection[ 4 ] * pfState[ 3 ] );
+			pfState[ 1 ] = pfState[ 0 ];
+			pfState[ 0 ] = fX;
+			pfState[ 3 ] = pfState[ 2 ];
+			pfState[ 2 ] = fY;
+			fDSPOut[ ulSample ] = fY;
+		}
+
+		pfIn = fDSPOut;
+	}
+
+	return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvDSPRMSIteration( void )
+{
+uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+	sDSPOut[ 0 ] = sDSPRMSQ15( sDSPIn, benchDSP_BLOCK );
+
+	return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvDSPMinMaxIteration( void )
+{
+uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+	vDSPMinMaxQ15( sDSPIn, benchDSP_BLOCK, &( sDSPOut[ 0 ] ), &( sDSPOut[ 1 ] ) );
+
+	return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvDSPCICIteration( void )
+{
+uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+	( void ) xDSPCICQ15( &xDSPCIC, sDSPIn, sDSPOut, benchDSP_BLOCK );
+
+	return benchGET_CYCLE_COUNT() - ulStart;
+}
@@ -0,0 +1,28 @@
+#ifndef DSP_BENCH_H
+#define DSP_BENCH_H
+
+#include "FreeRTOS.h"
+
+/*
+ * DSP benchmarks, run and reported as a suite of the benchmarks of
+ * KernelBench.h.
+ *
+ * The kernels of dsp_fixed.h are timed on blocks of 64 samples.  The FIR and
+ * biquad filters are also timed written in float, which the Cortex-M3 runs
+ * through the floating point library, to show what the fixed point versions
+ * save.  Dividing the cycles by 64 gives the cycles per sample.
+ */
+
+/* Set to 1 for main.c to run the DSP benchmarks with the kernel
+benchmarks. */
+#ifndef benchDSP
+	#define benchDSP				0
+#endif
+
+/*
+ * Starts the DSP benchmarks, which run once every suite of benchmarks started
+ * before them has been reported.
+ */
+void vStartDSPBenchmarks( UBaseType_t uxPriority );
+
+#endif /* DSP_BENCH_H */
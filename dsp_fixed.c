@@ -0,0 +1,562 @@
+/* Fixed point signal processing of sample blocks, see dsp_fixed.h. */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+
+/* Demo application includes. */
+#include "dsp_fixed.h"
+
+#define dspQ15_MAX						32767L
+#define dspQ15_MIN						( -32768L )
+#define dspQ31_MAX						2147483647LL
+#define dspQ31_MIN						( -2147483647LL - 1LL )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Returns the output of the FIR filter for the sample at psNewest, the
+ * samples before it being held in the words before it.
+ */
+static int16_t prvFIRSampleQ15( const int16_t *psCoefficients, const int16_t *psNewest, uint16_t usTaps );
+
+/*
+ * Saturates a sum of products to Q15 or Q31.
+ */
+static int16_t prvSaturateQ15( int64_t llValue );
+static int32_t prvSaturateQ31( int64_t llValue );
+
+/*
+ * Returns the square root of a sum of Q15 squares, which is Q30, as Q15.
+ */
+static int16_t prvRootQ15( uint32_t ulMeanSquare );
+
+/*-----------------------------------------------------------*/
+
+void vDSPADCToQ15( const uint16_t *pusIn, size_t xStride, int16_t *psOut, size_t xCount )
+{
+	while( xCount > 0 )
+	{
+		*psOut = ( int16_t ) ( ( int32_t ) ( *pusIn << 4 ) + dspQ15_MIN );
+		psOut++;
+		pusIn += xStride;
+		xCount--;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vDSPQ15ToQ31( const int16_t *psIn, int32_t *plOut, size_t xCount )
+{
+	while( xCount > 0 )
+	{
+		*plOut = ( int32_t ) *psIn * 65536L;
+		plOut++;
+		psIn++;
+		xCount--;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vDSPQ31ToQ15( const int32_t *plIn, int16_t *psOut, size_t xCount )
+{
+	while( xCount > 0 )
+	{
+		*psOut = ( int16_t ) ( *plIn >> 16 );
+		psOut++;
+		plIn++;
+		xCount--;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vDSPFIRInitQ15( DSPFIRQ15_t *pxFIR, const int16_t *psCoefficients, uint16_t usTaps, uint8_t ucDecimation, int16_t *psState, uint16_t usBlockSize )
+{
+	configASSERT( ( usTaps > 0U ) && ( ucDecimation > 0U ) && ( usBlockSize > 0U ) );
+	configASSERT( ( usBlockSize % ucDecimation ) == 0U );
+
+	pxFIR->psCoefficients = psCoefficients;
+	pxFIR->psState = psState;
+	pxFIR->usTaps = usTaps;
+	pxFIR->usBlockSize = usBlockSize;
+	pxFIR->ucDecimation = ucDecimation;
+
+	memset( ( void * ) psState, 0x00, dspFIR_STATE_LENGTH( usTaps, usBlockSize ) * sizeof( int16_t ) );
+}
+/*-----------------------------------------------------------*/
+
+size_t xDSPFIRQ15( DSPFIRQ15_t *pxFIR, const int16_t *psIn, int16_t *psOut, size_t xCount )
+{
+int16_t * const psState = pxFIR->psState;
+const size_t xHistory = ( size_t ) pxFIR->usTaps - 1U;
+size_t xBlock, x, xOutputs = 0;
+
+	configASSERT( ( xCount % pxFIR->ucDecimation ) == 0U );
+
+	while( xCount > 0 )
+	{
+		xBlock = ( xCount < pxFIR->usBlockSize ) ? xCount : pxFIR->usBlockSize;
+
+		/* The state holds the last usTaps - 1 samples of the previous block
+		followed by this block, so every output is a straight run over the
+		state. */
+		memcpy( ( void * ) &( psState[ xHistory ] ), ( const void * ) psIn, xBlock * sizeof( int16_t ) );
+
+		for( x = 0; x < xBlock; x += pxFIR->ucDecimation )
+		{
+			psOut[ xOutputs ] = prvFIRSampleQ15( pxFIR->psCoefficients, &( psState[ xHistory + x ] ), pxFIR->usTaps );
+			xOutputs++;
+		}
+
+		memmove( ( void * ) psState, ( const void * ) &( psState[ xBlock ] ), xHistory * sizeof( int16_t ) );
+
+		psIn += xBlock;
+		xCount -= xBlock;
+	}
+
+	return xOutputs;
+}
+/*-----------------------------------------------------------*/
+
+void vDSPBiquadInitQ31( DSPBiquadQ31_t *pxBiquad, const int32_t *plCoefficients, uint8_t ucStages, uint8_t ucPostShift, int32_t *plState )
+{
+	configASSERT( ucPostShift < 31U );
+
+	pxBiquad->plCoefficients = plCoefficients;
+	pxBiquad->plState = plState;
+	pxBiquad->ucStages = ucStages;
+	pxBiquad->ucPostShift = ucPostShift;
+
+	memset( ( void * ) plState, 0x00, ( size_t ) ucStages * dspBIQUAD_STATE * sizeof( int32_t ) );
+}
+/*-----------------------------------------------------------*/
+
+void vDSPBiquadQ31( DSPBiquadQ31_t *pxBiquad, const int32_t *plIn, int32_t *plOut, size_t xCount )
+{
+const int32_t *plCoefficients = pxBiquad->plCoefficients;
+int32_t *plState = pxBiquad->plState;
+const uint32_t ulShift = 31UL - pxBiquad->ucPostShift;
+int32_t lB0, lB1, lB2, lA1, lA2, lX0, lX1, lX2, lY1, lY2;
+int64_t llAcc;
+uint8_t ucStage;
+size_t x;
+
+	for( ucStage = 0; ucStage < pxBiquad->ucStages; ucStage++ )
+	{
+		lB0 = plCoefficients[ 0 ];
+		lB1 = plCoefficients[ 1 ];
+		lB2 = plCoefficients[ 2 ];
+		lA1 = plCoefficients[ 3 ];
+		lA2 = plCoefficients[ 4 ];
+
+		lX1 = plState[ 0 ];
+		lX2 = plState[ 1 ];
+		lY1 = plState[ 2 ];
+		lY2 = plState[ 3 ];
+
+		/* Each output depends on the one before, so the stage runs a sample
+		at a time with its state in registers. */
+		for( x = 0; x < xCount; x++ )
+		{
+			lX0 = plIn[ x ];
+
+			llAcc = ( int64_t ) lB0 * lX0;
+			llAcc += ( int64_t ) lB1 * lX1;
+			llAcc += ( int64_t ) lB2 * lX2;
+			llAcc += ( int64_t ) lA1 * lY1;
+			llAcc += ( int64_t ) lA2 * lY2;
+
+			lX2 = lX1;
+			lX1 = lX0;
+			lY2 = lY1;
+			lY1 = prvSaturateQ31( llAcc >> ulShift );
+
+			plOut[ x ] = lY1;
+		}
+
+		plState[ 0 ] = lX1;
+		plState[ 1 ] = lX2;
+		plState[ 2 ] = lY1;
+		plState[ 3 ] = lY2;
+
+		/* The next stage filters the output of this one. */
+		plIn = plOut;
+		plCoefficients += dspBIQUAD_COEFFICIENTS;
+		plState += dspBIQUAD_STATE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+int16_t sDSPRMSQ15( const int16_t *psIn, size_t xCount )
+{
+uint64_t ullSum = 0;
+size_t x = xCount;
+int32_t lA, lB, lC, lD;
+
+	if( xCount == 0 )
+	{
+		return 0;
+	}
+
+	/* A square is at most 2^30, so each is added to the 64 bit sum on its
+	own. */
+	while( x >= 4U )
+	{
+		lA = psIn[ 0 ];
+		lB = psIn[ 1 ];
+		lC = psIn[ 2 ];
+		lD = psIn[ 3 ];
+		ullSum += ( uint32_t ) ( lA * lA );
+		ullSum += ( uint32_t ) ( lB * lB );
+		ullSum += ( uint32_t ) ( lC * lC );
+		ullSum += ( uint32_t ) ( lD * lD );
+		psIn += 4;
+		x -= 4U;
+	}
+
+	while( x > 0 )
+	{
+		lA = *psIn;
+		ullSum += ( uint32_t ) ( lA * lA );
+		psIn++;
+		x--;
+	}
+
+	return prvRootQ15( ( uint32_t ) ( ullSum / xCount ) );
+}
+/*-----------------------------------------------------------*/
+
+void vDSPMovingRMSInitQ15( DSPMovingRMSQ15_t *pxRMS, int16_t *psWindow, uint16_t usLength )
+{
+	configASSERT( usLength > 0U );
+
+	pxRMS->psWindow = psWindow;
+	pxRMS->ullSumOfSquares = 0;
+	pxRMS->usLength = usLength;
+	pxRMS->usNext = 0;
+
+	memset( ( void * ) psWindow, 0x00, usLength * sizeof( int16_t ) );
+}
+/*-----------------------------------------------------------*/
+
+int16_t sDSPMovingRMSQ15( DSPMovingRMSQ15_t *pxRMS, const int16_t *psIn, size_t xCount )
+{
+int16_t * const psWindow = pxRMS->psWindow;
+uint64_t ullSum = pxRMS->ullSumOfSquares;
+uint16_t usNext = pxRMS->usNext;
+int32_t lNew, lOld;
+
+	while( xCount > 0 )
+	{
+		lNew = *psIn;
+		lOld = psWindow[ usNext ];
+		psWindow[ usNext ] = ( int16_t ) lNew;
+
+		ullSum += ( uint32_t ) ( lNew * lNew );
+		ullSum -= ( uint32_t ) ( lOld * lOld );
+
+		usNext++;
+		if( usNext == pxRMS->usLength )
+		{
+			usNext = 0;
+		}
+
+		psIn++;
+		xCount--;
+	}
+
+	pxRMS->ullSumOfSquares = ullSum;
+	pxRMS->usNext = usNext;
+
+	return prvRootQ15( ( uint32_t ) ( ullSum / pxRMS->usLength ) );
+}
+/*-----------------------------------------------------------*/
+
+void vDSPMinMaxQ15( const int16_t *psIn, size_t xCount, int16_t *psMin, int16_t *psMax )
+{
+int16_t sMin, sMax, sA, sB;
+
+	configASSERT( xCount > 0U );
+
+	sMin = *psIn;
+	sMax = *psIn;
+	psIn++;
+	xCount--;
+
+	/* Comparing a pair with each other first saves a comparison per pair. */
+	while( xCount >= 2U )
+	{
+		sA = psIn[ 0 ];
+		sB = psIn[ 1 ];
+
+		if( sA > sB )
+		{
+			if( sA > sMax )
+			{
+				sMax = sA;
+			}
+			if( sB < sMin )
+			{
+				sMin = sB;
+			}
+		}
+		else
+		{
+			if( sB > sMax )
+			{
+				sMax = sB;
+			}
+			if( sA < sMin )
+			{
+				sMin = sA;
+			}
+		}
+
+		psIn += 2;
+		xCount -= 2U;
+	}
+
+	if( xCount > 0U )
+	{
+		if( *psIn > sMax )
+		{
+			sMax = *psIn;
+		}
+		if( *psIn < sMin )
+		{
+			sMin = *psIn;
+		}
+	}
+
+	*psMin = sMin;
+	*psMax = sMax;
+}
+/*-----------------------------------------------------------*/
+
+void vDSPMinMaxQ31( const int32_t *plIn, size_t xCount, int32_t *plMin, int32_t *plMax )
+{
+int32_t lMin, lMax, lA, lB;
+
+	configASSERT( xCount > 0U );
+
+	lMin = *plIn;
+	lMax = *plIn;
+	plIn++;
+	xCount--;
+
+	while( xCount >= 2U )
+	{
+		lA = plIn[ 0 ];
+		lB = plIn[ 1 ];
+
+		if( lA > lB )
+		{
+			if( lA > lMax )
+			{
+				lMax = lA;
+			}
+			if( lB < lMin )
+			{
+				lMin = lB;
+			}
+		}
+		else
+		{
+			if( lB > lMax )
+			{
+				lMax = lB;
+			}
+			if( lA < lMin )
+			{
+				lMin = lA;
+			}
+		}
+
+		plIn += 2;
+		xCount -= 2U;
+	}
+
+	if( xCount > 0U )
+	{
+		if( *plIn > lMax )
+		{
+			lMax = *plIn;
+		}
+		if( *plIn < lMin )
+		{
+			lMin = *plIn;
+		}
+	}
+
+	*plMin = lMin;
+	*plMax = lMax;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDSPCICInitQ15( DSPCICQ15_t *pxCIC, uint8_t ucOrder, uint8_t ucDecimation )
+{
+uint8_t ucLog2 = 0;
+
+	if( ( ucOrder == 0U ) || ( ucOrder > dspCIC_MAX_ORDER ) || ( ucDecimation < 2U ) || ( ( ucDecimation & ( ucDecimation - 1U ) ) != 0U ) )
+	{
+		return pdFAIL;
+	}
+
+	while( ( 1U << ucLog2 ) < ucDecimation )
+	{
+		ucLog2++;
+	}
+
+	/* The integrators wrap, which does not matter as long as the output fits
+	in them: 16 bits of input and the bits of the gain. */
+	if( ( ucOrder * ucLog2 ) > 16U )
+	{
+		return pdFAIL;
+	}
+
+	memset( ( void * ) pxCIC, 0x00, sizeof( *pxCIC ) );
+	pxCIC->ucOrder = ucOrder;
+	pxCIC->ucDecimation = ucDecimation;
+	pxCIC->ucShift = ( uint8_t ) ( ucOrder * ucLog2 );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+size_t xDSPCICQ15( DSPCICQ15_t *pxCIC, const int16_t *psIn, int16_t *psOut, size_t xCount )
+{
+uint32_t * const pulIntegrators = pxCIC->ulIntegrators;
+uint32_t * const pulCombs = pxCIC->ulCombs;
+const uint8_t ucOrder = pxCIC->ucOrder;
+uint32_t ulValue, ulPrevious;
+size_t xOutputs = 0;
+uint8_t ucStage;
+
+	while( xCount > 0 )
+	{
+		/* Unsigned arithmetic, so the integrators wrap rather than
+		overflow. */
+		ulValue = ( uint32_t ) ( int32_t ) *psIn;
+
+		for( ucStage = 0; ucStage < ucOrder; ucStage++ )
+		{
+			pulIntegrators[ ucStage ] += ulValue;
+			ulValue = pulIntegrators[ ucStage ];
+		}
+
+		pxCIC->ucPhase++;
+
+		if( pxCIC->ucPhase == pxCIC->ucDecimation )
+		{
+			pxCIC->ucPhase = 0;
+
+			for( ucStage = 0; ucStage < ucOrder; ucStage++ )
+			{
+				ulPrevious = pulCombs[ ucStage ];
+				pulCombs[ ucStage ] = ulValue;
+				ulValue -= ulPrevious;
+			}
+
+			psOut[ xOutputs ] = ( int16_t ) ( ( int32_t ) ulValue >> pxCIC->ucShift );
+			xOutputs++;
+		}
+
+		psIn++;
+		xCount--;
+	}
+
+	return xOutputs;
+}
+/*-----------------------------------------------------------*/
+
+static int16_t prvFIRSampleQ15( const int16_t *psCoefficients, const int16_t *psNewest, uint16_t usTaps )
+{
+int64_t llAcc = 0;
+uint32_t ulTap = usTaps;
+
+	/* Each product is 32 bits, and adding it to the 64 bit sum is a single
+	SMLAL. */
+	while( ulTap >= 4UL )
+	{
+		llAcc += ( int64_t ) psCoefficients[ 0 ] * psNewest[ 0 ];
+		llAcc += ( int64_t ) psCoefficients[ 1 ] * psNewest[ -1 ];
+		llAcc += ( int64_t ) psCoefficients[ 2 ] * psNewest[ -2 ];
+		llAcc += ( int64_t ) psCoefficients[ 3 ] * psNewest[ -3 ];
+		psCoefficients += 4;
+		psNewest -= 4;
+		ulTap -= 4UL;
+	}
+
+	while( ulTap > 0UL )
+	{
+		llAcc += ( int64_t ) *psCoefficients * *psNewest;
+		psCoefficients++;
+		psNewest--;
+		ulTap--;
+	}
+
+	return prvSaturateQ15( llAcc >> 15 );
+}
+/*-----------------------------------------------------------*/
+
+static int16_t prvSaturateQ15( int64_t llValue )
+{
+	if( llValue > dspQ15_MAX )
+	{
+		llValue = dspQ15_MAX;
+	}
+	else if( llValue < dspQ15_MIN )
+	{
+		llValue = dspQ15_MIN;
+	}
+
+	return ( int16_t ) llValue;
+}
+/*-----------------------------------------------------------*/
+
+static int32_t prvSaturateQ31( int64_t llValue )
+{
+	if( llValue > dspQ31_MAX )
+	{
+		llValue = dspQ31_MAX;
+	}
+	else if( llValue < dspQ31_MIN )
+	{
+		llValue = dspQ31_MIN;
+	}
+
+	return ( int32_t ) llValue;
+}
+/*-----------------------------------------------------------*/
+
+static int16_t prvRootQ15( uint32_t ulMeanSquare )
+{
+uint32_t ulRoot = 0, ulBit = 1UL << 30;
+
+	/* One bit of the root at a time, from the top. */
+	while( ulBit > ulMeanSquare )
+	{
+		ulBit >>= 2;
+	}
+
+	while( ulBit != 0UL )
+	{
+		if( ulMeanSquare >= ( ulRoot + ulBit ) )
+		{
+			ulMeanSquare -= ulRoot + ulBit;
+			ulRoot = ( ulRoot >> 1 ) + ulBit;
+		}
+		else
+		{
+			ulRoot >>= 1;
+		}
+
+		ulBit >>= 2;
+	}
+
+	/* A full scale square wave of -1 has an RMS of 1, which Q15 cannot
+	hold. */
+	return ( int16_t ) ( ( ulRoot > ( uint32_t ) dspQ15_MAX ) ? dspQ15_MAX : ulRoot );
+}
+/*-----------------------------------------------------------*/
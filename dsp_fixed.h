@@ -0,0 +1,153 @@
+#ifndef DSP_FIXED_H
+#define DSP_FIXED_H
+
+#include "FreeRTOS.h"
+
+/*
+ * Fixed point signal processing of sample blocks, for processors without a
+ * floating point unit.
+ *
+ * Samples are Q15 (int16_t, -1 to 1 - 2^-15) or Q31 (int32_t).  Products are
+ * accumulated in 64 bits, which the Cortex-M3 does with SMULL and SMLAL, so
+ * the FIR and biquad filters cannot overflow part way through a sum.  Results
+ * are rounded towards minus infinity and saturated.  The FIR filter and the
+ * sums of squares are unrolled by four, and min/max takes samples in pairs.
+ *
+ * The filters keep their state in a structure initialised once and passed to
+ * each call, so a stream can be processed a block at a time, for example the
+ * blocks of adc_sample.h after vDSPADCToQ15() has taken one channel out of
+ * them.  Input and output may be the same buffer, except for the FIR filter.
+ */
+
+/* The largest order of a CIC decimator. */
+#define dspCIC_MAX_ORDER				4
+
+/* The number of int16_t a FIR filter of usTaps taps needs for its state to
+process up to usBlockSize samples a pass. */
+#define dspFIR_STATE_LENGTH( usTaps, usBlockSize )	( ( usTaps ) - 1U + ( usBlockSize ) )
+
+/* The number of int32_t held per biquad stage, in the coefficients and in the
+state. */
+#define dspBIQUAD_COEFFICIENTS			5
+#define dspBIQUAD_STATE					4
+
+/* A FIR filter, with optional decimation.  Only the outputs kept are
+computed, which is the same work as a polyphase decimator. */
+typedef struct DSP_FIR_Q15
+{
+	const int16_t *psCoefficients;	/* usTaps coefficients, the one applied to the newest sample first. */
+	int16_t *psState;				/* dspFIR_STATE_LENGTH( usTaps, usBlockSize ) samples. */
+	uint16_t usTaps;
+	uint16_t usBlockSize;			/* The samples copied into the state at a time, a multiple of ucDecimation. */
+	uint8_t ucDecimation;			/* One output is kept for every ucDecimation inputs. */
+} DSPFIRQ15_t;
+
+/* A cascade of direct form I biquad sections.  Each stage has the
+coefficients b0, b1, b2, a1 and a2 of
+
+y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] + a1 y[n-1] + a2 y[n-2]
+
+in Q31 divided by 2^ucPostShift, so coefficients of up to 2^ucPostShift in
+magnitude can be held.  a1 and a2 have the opposite sign to the usual
+denominator coefficients. */
+typedef struct DSP_BIQUAD_Q31
+{
+	const int32_t *plCoefficients;	/* dspBIQUAD_COEFFICIENTS per stage. */
+	int32_t *plState;				/* dspBIQUAD_STATE per stage. */
+	uint8_t ucStages;
+	uint8_t ucPostShift;
+} DSPBiquadQ31_t;
+
+/* The RMS of the last usLength samples. */
+typedef struct DSP_MOVING_RMS_Q15
+{
+	int16_t *psWindow;				/* usLength samples. */
+	uint64_t ullSumOfSquares;
+	uint16_t usLength;
+	uint16_t usNext;				/* The oldest sample in the window. */
+} DSPMovingRMSQ15_t;
+
+/* A cascaded integrator comb decimator, with a differential delay of one. */
+typedef struct DSP_CIC_Q15
+{
+	uint32_t ulIntegrators[ dspCIC_MAX_ORDER ];
+	uint32_t ulCombs[ dspCIC_MAX_ORDER ];	/* The previous input of each comb. */
+	uint8_t ucOrder;
+	uint8_t ucDecimation;
+	uint8_t ucPhase;				/* The inputs integrated since the last output. */
+	uint8_t ucShift;				/* Divides out the gain, ucDecimation ^ ucOrder. */
+} DSPCICQ15_t;
+
+/*
+ * Takes xCount samples of one channel out of an ADC block, in which the
+ * channels follow each other every xStride samples, and converts the right
+ * aligned 12 bit samples into Q15 about the middle of the range.
+ */
+void vDSPADCToQ15( const uint16_t *pusIn, size_t xStride, int16_t *psOut, size_t xCount );
+
+/*
+ * Converts between Q15 and Q31.  Q31 to Q15 truncates.
+ */
+void vDSPQ15ToQ31( const int16_t *psIn, int32_t *plOut, size_t xCount );
+void vDSPQ31ToQ15( const int32_t *plIn, int16_t *psOut, size_t xCount );
+
+/*
+ * Initialises pxFIR and clears its state.  usBlockSize must be a multiple of
+ * ucDecimation.
+ */
+void vDSPFIRInitQ15( DSPFIRQ15_t *pxFIR, const int16_t *psCoefficients, uint16_t usTaps, uint8_t ucDecimation, int16_t *psState, uint16_t usBlockSize );
+
+/*
+ * Filters xCount samples, which must be a multiple of the decimation, and
+ * returns the number of outputs written to psOut, xCount / ucDecimation.
+ * psOut must not overlap psIn.
+ */
+size_t xDSPFIRQ15( DSPFIRQ15_t *pxFIR, const int16_t *psIn, int16_t *psOut, size_t xCount );
+
+/*
+ * Initialises pxBiquad and clears its state.
+ */
+void vDSPBiquadInitQ31( DSPBiquadQ31_t *pxBiquad, const int32_t *plCoefficients, uint8_t ucStages, uint8_t ucPostShift, int32_t *plState );
+
+/*
+ * Filters xCount samples through every stage.
+ */
+void vDSPBiquadQ31( DSPBiquadQ31_t *pxBiquad, const int32_t *plIn, int32_t *plOut, size_t xCount );
+
+/*
+ * Returns the RMS of xCount samples.
+ */
+int16_t sDSPRMSQ15( const int16_t *psIn, size_t xCount );
+
+/*
+ * Initialises pxRMS with a window of usLength zero samples.
+ */
+void vDSPMovingRMSInitQ15( DSPMovingRMSQ15_t *pxRMS, int16_t *psWindow, uint16_t usLength );
+
+/*
+ * Adds xCount samples to the window of pxRMS, and returns the RMS of the
+ * window once they have been added.
+ */
+int16_t sDSPMovingRMSQ15( DSPMovingRMSQ15_t *pxRMS, const int16_t *psIn, size_t xCount );
+
+/*
+ * Finds the smallest and largest of xCount samples, xCount at least 1.
+ */
+void vDSPMinMaxQ15( const int16_t *psIn, size_t xCount, int16_t *psMin, int16_t *psMax );
+void vDSPMinMaxQ31( const int32_t *plIn, size_t xCount, int32_t *plMin, int32_t *plMax );
+
+/*
+ * Initialises pxCIC.  ucDecimation must be a power of two, and the gain
+ * ucDecimation ^ ucOrder at most 2^16 so the integrators cannot overflow.
+ * Returns pdFAIL if they are not.
+ */
+BaseType_t xDSPCICInitQ15( DSPCICQ15_t *pxCIC, uint8_t ucOrder, uint8_t ucDecimation );
+
+/*
+ * Decimates xCount samples and returns the number of outputs written to
+ * psOut.  The count need not be a multiple of the decimation, the phase is
+ * carried to the next call.
+ */
+size_t xDSPCICQ15( DSPCICQ15_t *pxCIC, const int16_t *psIn, int16_t *psOut, size_t xCount );
+
+#endif /* DSP_FIXED_H */
@@ -0,0 +1,374 @@
+/* Write-back cache of SPI FLASH pages, see flash_cache.h. */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* Demo application includes. */
+#include "spi_flash.h"
+#include "flash_cache.h"
+
+/* The size of the sectors erased by SPI_FLASH_SectorErase(). */
+#define flashcacheSECTOR_SIZE		0x10000UL
+
+/* Marks a line that holds no page. */
+#define flashcacheNO_PAGE			0xffffffffUL
+
+#define flashcacheLOCK()			( void ) xSemaphoreTake( xLock, portMAX_DELAY )
+#define flashcacheUNLOCK()			( void ) xSemaphoreGive( xLock )
+
+/*-----------------------------------------------------------*/
+
+typedef struct FLASH_CACHE_LINE
+{
+	uint32_t ulPage;			/* Address of the page held, or flashcacheNO_PAGE. */
+	uint32_t ulLastUse;			/* Value of ulUseCount when the line was last used. */
+	uint16_t usDirtyStart;		/* The bytes changed since the page was last programmed.  Equal when there are none. */
+	uint16_t usDirtyEnd;
+	uint8_t ucData[ flashcachePAGE_SIZE ];
+} FlashCacheLine_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The task that programs the changed pages.
+ */
+static void prvFlushTask( void *pvParameters );
+
+/*
+ * Returns the line holding ulPage, or NULL.
+ */
+static FlashCacheLine_t *prvFindLine( uint32_t ulPage );
+
+/*
+ * Returns a line holding ulPage, reading the page into the line used least
+ * recently if it is not already cached.
+ */
+static FlashCacheLine_t *prvLoadLine( uint32_t ulPage );
+
+/*
+ * Programs the bytes of the line that have changed.
+ */
+static void prvFlushLine( FlashCacheLine_t *pxLine );
+
+/*-----------------------------------------------------------*/
+
+static FlashCacheLine_t xLines[ flashcacheLINES ];
+static FlashCacheStats_t xStats;
+static uint32_t ulUseCount = 0;
+static SemaphoreHandle_t xLock = NULL;
+static TaskHandle_t xFlushTask = NULL;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xFlashCacheInit( UBaseType_t uxPriority )
+{
+BaseType_t xReturn = pdFAIL;
+UBaseType_t x;
+
+	for( x = 0; x < flashcacheLINES; x++ )
+	{
+		xLines[ x ].ulPage = flashcacheNO_PAGE;
+		xLines[ x ].ulLastUse = 0;
+		xLines[ x ].usDirtyStart = 0;
+		xLines[ x ].usDirtyEnd = 0;
+	}
+
+	memset( ( void * ) &xStats, 0x00, sizeof( xStats ) );
+
+	/* Mutexes are not included in this demo, so a binary semaphore guards the
+	lines.  Writers may wait for a page program while holding it. */
+	xLock = xSemaphoreCreateBinary();
+
+	if( xLock != NULL )
+	{
+		( void ) xSemaphoreGive( xLock );
+		xReturn = xTaskCreate( prvFlushTask, "FCache", flashcacheSTACK_SIZE, NULL, uxPriority, &xFlushTask );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vFlashCacheWrite( uint32_t ulAddress, const void *pvData, uint32_t ulLength )
+{
+const uint8_t *pucData = ( const uint8_t * ) pvData;
+FlashCacheLine_t *pxLine;
+uint32_t ulOffset, ulChunk, x;
+BaseType_t xWasClean;
+
+	flashcacheLOCK();
+	{
+		xStats.ulBytesWritten += ulLength;
+
+		while( ulLength > 0UL )
+		{
+			/* The part of the write that falls in this page. */
+			ulOffset = ulAddress % flashcachePAGE_SIZE;
+			ulChunk = flashcachePAGE_SIZE - ulOffset;
+
+			if( ulChunk > ulLength )
+			{
+				ulChunk = ulLength;
+			}
+
+			pxLine = prvFindLine( ulAddress - ulOffset );
+
+			if( pxLine != NULL )
+			{
+				pxLine->ulLastUse = ++ulUseCount;
+				xStats.ulWriteHits++;
+			}
+			else
+			{
+				xStats.ulWriteMisses++;
+				pxLine = prvLoadLine( ulAddress - ulOffset );
+			}
+
+			/* Programming can only clear bits, so the page will hold the AND
+			of what it held and what is written. */
+			for( x = 0; x < ulChunk; x++ )
+			{
+				pxLine->ucData[ ulOffset + x ] &= pucData[ x ];
+			}
+
+			xWasClean = ( pxLine->usDirtyStart == pxLine->usDirtyEnd ) ? pdTRUE : pdFALSE;
+
+			if( xWasClean != pdFALSE )
+			{
+				pxLine->usDirtyStart = ( uint16_t ) ulOffset;
+				pxLine->usDirtyEnd = ( uint16_t ) ( ulOffset + ulChunk );
+			}
+			else
+			{
+				if( ulOffset < pxLine->usDirtyStart )
+				{
+					pxLine->usDirtyStart = ( uint16_t ) ulOffset;
+				}
+
+				if( ( ulOffset + ulChunk ) > pxLine->usDirtyEnd )
+				{
+					pxLine->usDirtyEnd = ( uint16_t ) ( ulOffset + ulChunk );
+				}
+			}
+
+			pucData += ulChunk;
+			ulAddress += ulChunk;
+			ulLength -= ulChunk;
+		}
+	}
+	flashcacheUNLOCK();
+
+	/* Start the delay after which the background task programs the page. */
+	xTaskNotifyGive( xFlushTask );
+}
+/*-----------------------------------------------------------*/
+
+void vFlashCacheRead( uint32_t ulAddress, void *pvBuffer, uint32_t ulLength )
+{
+uint8_t *pucBuffer = ( uint8_t * ) pvBuffer;
+FlashCacheLine_t *pxLine;
+uint32_t ulOffset, ulChunk, ulMissAddress = 0, ulMissLength = 0;
+uint8_t *pucMissBuffer = NULL;
+
+	flashcacheLOCK();
+	{
+		while( ulLength > 0UL )
+		{
+			ulOffset = ulAddress % flashcachePAGE_SIZE;
+			ulChunk = flashcachePAGE_SIZE - ulOffset;
+
+			if( ulChunk > ulLength )
+			{
+				ulChunk = ulLength;
+			}
+
+			pxLine = prvFindLine( ulAddress - ulOffset );
+
+			if( pxLine != NULL )
+			{
+				/* Read the pages missed before this one with one command. */
+				if( ulMissLength > 0UL )
+				{
+					SPI_FLASH_BufferRead( pucMissBuffer, ulMissAddress, ulMissLength );
+					ulMissLength = 0;
+				}
+
+				memcpy( ( void * ) pucBuffer, ( const void * ) &( pxLine->ucData[ ulOffset ] ), ulChunk );
+				pxLine->ulLastUse = ++ulUseCount;
+				xStats.ulReadHits++;
+			}
+			else
+			{
+				if( ulMissLength == 0UL )
+				{
+					ulMissAddress = ulAddress;
+					pucMissBuffer = pucBuffer;
+				}
+
+				ulMissLength += ulChunk;
+				xStats.ulReadMisses++;
+			}
+
+			pucBuffer += ulChunk;
+			ulAddress += ulChunk;
+			ulLength -= ulChunk;
+		}
+
+		if( ulMissLength > 0UL )
+		{
+			SPI_FLASH_BufferRead( pucMissBuffer, ulMissAddress, ulMissLength );
+		}
+	}
+	flashcacheUNLOCK();
+}
+/*-----------------------------------------------------------*/
+
+void vFlashCacheEraseSector( uint32_t ulAddress )
+{
+uint32_t ulSector = ulAddress - ( ulAddress % flashcacheSECTOR_SIZE );
+UBaseType_t x;
+
+	flashcacheLOCK();
+	{
+		/* Whatever was still to be programmed in the sector would be erased
+		anyway. */
+		for( x = 0; x < flashcacheLINES; x++ )
+		{
+			if( ( xLines[ x ].ulPage != flashcacheNO_PAGE ) && ( ( xLines[ x ].ulPage - ( xLines[ x ].ulPage % flashcacheSECTOR_SIZE ) ) == ulSector ) )
+			{
+				xLines[ x ].ulPage = flashcacheNO_PAGE;
+				xLines[ x ].usDirtyStart = 0;
+				xLines[ x ].usDirtyEnd = 0;
+			}
+		}
+
+		SPI_FLASH_SectorErase( ulSector );
+	}
+	flashcacheUNLOCK();
+}
+/*-----------------------------------------------------------*/
+
+void vFlashCacheFlush( void )
+{
+UBaseType_t x;
+
+	flashcacheLOCK();
+	{
+		for( x = 0; x < flashcacheLINES; x++ )
+		{
+			prvFlushLine( &( xLines[ x ] ) );
+		}
+	}
+	flashcacheUNLOCK();
+}
+/*-----------------------------------------------------------*/
+
+void vFlashCacheGetStats( FlashCacheStats_t *pxStats )
+{
+	flashcacheLOCK();
+	{
+		*pxStats = xStats;
+	}
+	flashcacheUNLOCK();
+}
+/*-----------------------------------------------------------*/
+
+static void prvFlushTask( void *pvParameters )
+{
+UBaseType_t x;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		/* Wait for a write, then give later writes to the same pages time to
+		arrive before programming them. */
+		( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+		vTaskDelay( flashcacheFLUSH_DELAY );
+
+		/* The lock is released between pages, so writers are only held up by
+		one page program at a time. */
+		for( x = 0; x < flashcacheLINES; x++ )
+		{
+			flashcacheLOCK();
+			{
+				prvFlushLine( &( xLines[ x ] ) );
+			}
+			flashcacheUNLOCK();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static FlashCacheLine_t *prvFindLine( uint32_t ulPage )
+{
+FlashCacheLine_t *pxLine = NULL;
+UBaseType_t x;
+
+	for( x = 0; x < flashcacheLINES; x++ )
+	{
+		if( xLines[ x ].ulPage == ulPage )
+		{
+			pxLine = &( xLines[ x ] );
+			break;
+		}
+	}
+
+	return pxLine;
+}
+/*-----------------------------------------------------------*/
+
+static FlashCacheLine_t *prvLoadLine( uint32_t ulPage )
+{
+FlashCacheLine_t *pxLine = &( xLines[ 0 ] );
+UBaseType_t x;
+
+	/* Use an empty line, otherwise the one used least recently. */
+	for( x = 0; x < flashcacheLINES; x++ )
+	{
+		if( xLines[ x ].ulPage == flashcacheNO_PAGE )
+		{
+			pxLine = &( xLines[ x ] );
+			break;
+		}
+
+		if( ( ulUseCount - xLines[ x ].ulLastUse ) > ( ulUseCount - pxLine->ulLastUse ) )
+		{
+			pxLine = &( xLines[ x ] );
+		}
+	}
+
+	if( pxLine->usDirtyStart != pxLine->usDirtyEnd )
+	{
+		xStats.ulEvictions++;
+		prvFlushLine( pxLine );
+	}
+
+	SPI_FLASH_BufferRead( pxLine->ucData, ulPage, flashcachePAGE_SIZE );
+	pxLine->ulPage = ulPage;
+	pxLine->ulLastUse = ++ulUseCount;
+
+	return pxLine;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFlushLine( FlashCacheLine_t *pxLine )
+{
+	if( pxLine->usDirtyStart != pxLine->usDirtyEnd )
+	{
+		SPI_FLASH_PageWrite( &( pxLine->ucData[ pxLine->usDirtyStart ] ),
+							 pxLine->ulPage + pxLine->usDirtyStart,
+							 ( u16 ) ( pxLine->usDirtyEnd - pxLine->usDirtyStart ) );
+
+		xStats.ulFlushes++;
+		xStats.ulBytesFlushed += ( uint32_t ) ( pxLine->usDirtyEnd - pxLine->usDirtyStart );
+		pxLine->usDirtyStart = 0;
+		pxLine->usDirtyEnd = 0;
+	}
+}
+/*-----------------------------------------------------------*/
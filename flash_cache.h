@@ -0,0 +1,95 @@
+#ifndef FLASH_CACHE_H
+#define FLASH_CACHE_H
+
+#include "FreeRTOS.h"
+
+/*
+ * Write-back cache of SPI FLASH pages.
+ *
+ * SPI_FLASH_BufferWrite() sends a write enable, a page program and then waits
+ * for the program to end for every page it touches, however few bytes it
+ * writes.  Writes made through vFlashCacheWrite() are instead merged into a
+ * copy of the page held in RAM, and a background task programs each page that
+ * has changed once, with the range of bytes changed since it was last
+ * programmed.  Many small writes to the same page therefore cost one program.
+ *
+ * The copy of a page is read from the FLASH the first time the page is
+ * written, and written bytes are ANDed into it, so the cache always holds
+ * what the FLASH will hold once it has been programmed.  vFlashCacheRead()
+ * serves the pages that are cached from RAM, and reads the others from the
+ * FLASH without caching them.
+ *
+ * When every line holds a page that has still to be programmed, a write to
+ * another page programs the line used least recently before reusing it.
+ * vFlashCacheFlush() programs every changed page, for example before the
+ * power is removed.  Data held only in the cache is lost if the power fails.
+ *
+ * A sector written through the cache must only be written and erased through
+ * these functions, or pages cached from it would no longer match it.
+ */
+
+/* The number of pages held. */
+#ifndef flashcacheLINES
+	#define flashcacheLINES				4
+#endif
+
+/* How long the background task waits after a page is first changed before it
+programs it, so later writes to the same page can be merged. */
+#ifndef flashcacheFLUSH_DELAY
+	#define flashcacheFLUSH_DELAY		pdMS_TO_TICKS( 50 )
+#endif
+
+#ifndef flashcacheSTACK_SIZE
+	#define flashcacheSTACK_SIZE		configMINIMAL_STACK_SIZE
+#endif
+
+/* The size of a FLASH page, and so of a cache line. */
+#define flashcachePAGE_SIZE				256UL
+
+typedef struct FLASH_CACHE_STATS
+{
+	uint32_t ulReadHits;		/* Pages read from the cache. */
+	uint32_t ulReadMisses;		/* Pages read from the FLASH. */
+	uint32_t ulWriteHits;		/* Writes to a page that was already cached. */
+	uint32_t ulWriteMisses;		/* Writes that first read the page into a line. */
+	uint32_t ulEvictions;		/* Changed pages programmed to make room for another. */
+	uint32_t ulFlushes;			/* Page programs issued. */
+	uint32_t ulBytesWritten;	/* Bytes passed to vFlashCacheWrite(). */
+	uint32_t ulBytesFlushed;	/* Bytes programmed, so ulBytesWritten / ulBytesFlushed shows how well writes are merged. */
+} FlashCacheStats_t;
+
+/*
+ * Creates the task that programs the changed pages, at uxPriority.
+ * SPI_FLASH_Init() must have been called first.
+ */
+BaseType_t xFlashCacheInit( UBaseType_t uxPriority );
+
+/*
+ * Writes ulLength bytes from pvData to the FLASH at ulAddress, through the
+ * cache.  The FLASH must have been erased where bits are to be set.
+ */
+void vFlashCacheWrite( uint32_t ulAddress, const void *pvData, uint32_t ulLength );
+
+/*
+ * Reads ulLength bytes from the FLASH at ulAddress into pvBuffer, including
+ * any writes that have still to be programmed.
+ */
+void vFlashCacheRead( uint32_t ulAddress, void *pvBuffer, uint32_t ulLength );
+
+/*
+ * Erases the FLASH sector that contains ulAddress, dropping the cached pages
+ * it holds.
+ */
+void vFlashCacheEraseSector( uint32_t ulAddress );
+
+/*
+ * Programs every changed page now, and returns once they are programmed.
+ */
+void vFlashCacheFlush( void );
+
+/*
+ * Fills in *pxStats.
+ */
+void vFlashCacheGetStats( FlashCacheStats_t *pxStats );
+
+#endif /* FLASH_CACHE_H */
@@ -0,0 +1,891 @@
+/* Log structured key-value store, see flash_kv.h. */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+/* Demo application includes. */
+#include "flash_kv.h"
+
+#if( flashkvUSE_SPI_FLASH == 1 )
+	#include "spi_flash.h"
+#endif
+
+/* The sectors used in the M25P64 by xFlashKVSPIFlashDevice. */
+#ifndef flashkvSPI_FLASH_BASE_ADDRESS
+	#define flashkvSPI_FLASH_BASE_ADDRESS	0x700000UL
+#endif
+
+#ifndef flashkvSPI_FLASH_SECTORS
+	#define flashkvSPI_FLASH_SECTORS		4UL
+#endif
+
+#define flashkvSPI_FLASH_SECTOR_SIZE		0x10000UL
+
+/* Each sector starts with a header holding flashkvSECTOR_MAGIC and the
+sequence number of the sector, which orders the sectors from the oldest to the
+newest.  The magic number is cleared before the sector is erased. */
+#define flashkvSECTOR_MAGIC					0x3156574bUL
+#define flashkvSECTOR_HEADER_SIZE			8UL
+
+/* Each record is a header followed by the value, padded to a multiple of four
+bytes.  The header holds:
+
+	bytes 0-1	key
+	bytes 2-3	length of the value, or flashkvDELETED for a deletion
+	bytes 4-5	CRC16 of the value
+	byte 6		check byte, so a partly programmed header can be recognised
+	byte 7		commit byte, programmed to flashkvCOMMITTED once the rest of
+				the record has been written
+
+All values are stored least significant byte first. */
+#define flashkvRECORD_HEADER_SIZE			8UL
+#define flashkvCOMMIT_OFFSET				7UL
+#define flashkvCOMMITTED					( ( uint8_t ) 0x00 )
+#define flashkvUNCOMMITTED					( ( uint8_t ) 0xff )
+#define flashkvDELETED						( ( uint16_t ) 0x8000 )
+#define flashkvRECORD_SIZE( ulLength )		( ( flashkvRECORD_HEADER_SIZE + ( uint32_t ) ( ulLength ) + 3UL ) & ~3UL )
+
+/* The space skipped after a record whose header was being programmed when
+power failed.  flashkvMAX_VALUE_LENGTH must therefore not be changed once
+records have been written. */
+#define flashkvTORN_SIZE					flashkvRECORD_SIZE( flashkvMAX_VALUE_LENGTH )
+
+/* Marks a key that has no value in the table in RAM. */
+#define flashkvNO_RECORD					0xffffffffUL
+
+/* Marks that no sector is being filled. */
+#define flashkvNO_SECTOR					0xffffffffUL
+
+/* The states of a sector. */
+#define flashkvSECTOR_USED					0	/* Holds a valid sector header. */
+#define flashkvSECTOR_ERASED				1	/* Erased since the store was opened. */
+#define flashkvSECTOR_DIRTY					2	/* Not used, but must be erased before it is. */
+
+/* The results of reading a record header. */
+#define flashkvHEADER_BLANK					0	/* Erased, so the end of the records in the sector. */
+#define flashkvHEADER_INVALID				1	/* Partly programmed, so its length is not known. */
+#define flashkvHEADER_VALID					2
+
+#if( flashkvUSE_LOCK == 1 )
+	#define flashkvLOCK()		( void ) xSemaphoreTake( xLock, portMAX_DELAY )
+	#define flashkvUNLOCK()		( void ) xSemaphoreGive( xLock )
+#else
+	#define flashkvLOCK()
+	#define flashkvUNLOCK()
+#endif
+
+/*-----------------------------------------------------------*/
+
+typedef struct FLASH_KV_RECORD_HEADER
+{
+	uint16_t usKey;
+	uint16_t usLength;		/* Includes flashkvDELETED. */
+	uint16_t usCRC;
+	uint8_t ucCommit;
+	uint32_t ulSize;		/* Size of the whole record in the flash. */
+} FlashKVRecordHeader_t;
+
+typedef struct FLASH_KV_SECTOR
+{
+	uint32_t ulSequence;
+	uint32_t ulUsed;		/* Offset of the end of the records, the sector size once the sector is closed. */
+	uint8_t ucState;
+} FlashKVSector_t;
+
+typedef struct FLASH_KV_ENTRY
+{
+	uint32_t ulAddress;		/* Address of the latest record of the key, or flashkvNO_RECORD. */
+	uint16_t usLength;		/* Length of its value. */
+} FlashKVEntry_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Reads the sector headers and the records they hold, and rebuilds the table
+ * of keys.
+ */
+static void prvMount( void );
+
+/*
+ * Walks the records of a used sector, updating the table of keys from them
+ * and setting the end of the records.
+ */
+static void prvScanSector( uint32_t ulSector );
+
+/*
+ * Reads and checks the record header at ulAddress.  ulEnd is the end of the
+ * sector, which the record must not cross.
+ */
+static BaseType_t prvReadRecordHeader( uint32_t ulAddress, uint32_t ulEnd, FlashKVRecordHeader_t *pxHeader );
+
+/*
+ * Makes room for a record of ulSize bytes in the sector being filled, opening
+ * a new sector, and first collecting the oldest ones if the store is not
+ * already collecting, as needed.
+ */
+static BaseType_t prvReserve( uint32_t ulSize, BaseType_t xCollecting );
+
+/*
+ * Copies the latest records in the oldest sector to the sector being filled,
+ * then erases the oldest sector.
+ */
+static BaseType_t prvCollect( void );
+
+/*
+ * Erases a free sector if needed and starts filling it.
+ */
+static void prvOpenSector( void );
+
+/*
+ * Programs the record in ucRecord at the end of the sector being filled, for
+ * which room has been reserved, then commits it.  Returns its address.
+ */
+static uint32_t prvProgramRecord( uint32_t ulSize );
+
+/*
+ * Appends a record for usKey and points the table at it.
+ */
+static BaseType_t prvWriteRecord( uint16_t usKey, const uint8_t *pucValue, uint16_t usLength, BaseType_t xDelete );
+
+/*
+ * Points the table entry of usKey at a new record, or at none.
+ */
+static void prvSetEntry( uint16_t usKey, uint32_t ulAddress, uint16_t usLength );
+
+static uint32_t prvSectorAddress( uint32_t ulSector );
+static uint16_t prvCRC16( const uint8_t *pucData, uint32_t ulLength );
+static uint8_t prvHeaderCheck( const uint8_t *pucHeader );
+
+#if( flashkvUSE_SPI_FLASH == 1 )
+	static void prvSPIFlashRead( uint32_t ulAddress, uint8_t *pucBuffer, uint32_t ulLength );
+	static void prvSPIFlashProgram( uint32_t ulAddress, const uint8_t *pucData, uint32_t ulLength );
+	static void prvSPIFlashEraseSector( uint32_t ulAddress );
+#endif
+
+/*-----------------------------------------------------------*/
+
+#if( flashkvUSE_SPI_FLASH == 1 )
+	const FlashKVDevice_t xFlashKVSPIFlashDevice =
+	{
+		prvSPIFlashRead,
+		prvSPIFlashProgram,
+		prvSPIFlashEraseSector,
+		flashkvSPI_FLASH_BASE_ADDRESS,
+		flashkvSPI_FLASH_SECTOR_SIZE,
+		flashkvSPI_FLASH_SECTORS
+	};
+#endif
+
+static const FlashKVDevice_t *pxFlash = NULL;
+static FlashKVSector_t xSectors[ flashkvMAX_SECTORS ];
+static FlashKVEntry_t xEntries[ flashkvMAX_KEYS ];
+static FlashKVStats_t xStats;
+
+/* The sector being filled and the sequence number of the next sector to be
+opened. */
+static uint32_t ulActiveSector = flashkvNO_SECTOR;
+static uint32_t ulNextSequence = 0;
+
+/* The size of the latest records of all the keys, which is what garbage
+collection cannot reclaim. */
+static uint32_t ulLiveBytes = 0;
+
+/* Holds the record being written or copied.  Not on the stack as it can be
+large. */
+static uint8_t ucRecord[ flashkvRECORD_SIZE( flashkvMAX_VALUE_LENGTH ) ];
+
+#if( flashkvUSE_LOCK == 1 )
+	static SemaphoreHandle_t xLock = NULL;
+#endif
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xFlashKVInit( const FlashKVDevice_t *pxDevice )
+{
+BaseType_t xReturn = pdFAIL;
+
+	configASSERT( pxDevice );
+	configASSERT( ( pxDevice->ulSectorCount >= 3UL ) && ( pxDevice->ulSectorCount <= flashkvMAX_SECTORS ) );
+	configASSERT( pxDevice->ulSectorSize >= ( flashkvSECTOR_HEADER_SIZE + flashkvRECORD_SIZE( flashkvMAX_VALUE_LENGTH ) ) );
+
+	#if( flashkvUSE_LOCK == 1 )
+	{
+		if( xLock == NULL )
+		{
+			xLock = xSemaphoreCreateBinary();
+
+			if( xLock != NULL )
+			{
+				( void ) xSemaphoreGive( xLock );
+			}
+		}
+
+		if( xLock == NULL )
+		{
+			return pdFAIL;
+		}
+	}
+	#endif
+
+	flashkvLOCK();
+	{
+		pxFlash = pxDevice;
+		prvMount();
+		xReturn = pdPASS;
+	}
+	flashkvUNLOCK();
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xFlashKVWrite( uint16_t usKey, const void *pvValue, uint16_t usLength )
+{
+BaseType_t xReturn = pdFAIL;
+
+	configASSERT( pxFlash );
+
+	if( ( usKey < flashkvMAX_KEYS ) && ( usLength <= flashkvMAX_VALUE_LENGTH ) )
+	{
+		flashkvLOCK();
+		{
+			xReturn = prvWriteRecord( usKey, ( const uint8_t * ) pvValue, usLength, pdFALSE );
+		}
+		flashkvUNLOCK();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xFlashKVRead( uint16_t usKey, void *pvBuffer, uint16_t usBufferLength, uint16_t *pusValueLength )
+{
+BaseType_t xReturn = pdFAIL;
+FlashKVEntry_t xEntry;
+
+	configASSERT( pxFlash );
+
+	if( usKey < flashkvMAX_KEYS )
+	{
+		flashkvLOCK();
+		{
+			xEntry = xEntries[ usKey ];
+
+			if( xEntry.ulAddress != flashkvNO_RECORD )
+			{
+				if( usBufferLength > xEntry.usLength )
+				{
+					usBufferLength = xEntry.usLength;
+				}
+
+				if( usBufferLength > 0U )
+				{
+					pxFlash->pxRead( xEntry.ulAddress + flashkvRECORD_HEADER_SIZE, ( uint8_t * ) pvBuffer, usBufferLength );
+				}
+
+				if( pusValueLength != NULL )
+				{
+					*pusValueLength = xEntry.usLength;
+				}
+
+				xReturn = pdPASS;
+			}
+		}
+		flashkvUNLOCK();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xFlashKVDelete( uint16_t usKey )
+{
+BaseType_t xReturn = pdFAIL;
+
+	configASSERT( pxFlash );
+
+	if( usKey < flashkvMAX_KEYS )
+	{
+		flashkvLOCK();
+		{
+			if( xEntries[ usKey ].ulAddress == flashkvNO_RECORD )
+			{
+				xReturn = pdPASS;
+			}
+			else
+			{
+				xReturn = prvWriteRecord( usKey, NULL, 0U, pdTRUE );
+			}
+		}
+		flashkvUNLOCK();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vFlashKVGetStats( FlashKVStats_t *pxStats )
+{
+uint32_t ulSector;
+
+	configASSERT( pxFlash );
+
+	flashkvLOCK();
+	{
+		*pxStats = xStats;
+		pxStats->ulFreeSectors = 0UL;
+		pxStats->ulFreeBytes = 0UL;
+
+		for( ulSector = 0; ulSector < pxFlash->ulSectorCount; ulSector++ )
+		{
+			if( xSectors[ ulSector ].ucState != flashkvSECTOR_USED )
+			{
+				pxStats->ulFreeSectors++;
+			}
+		}
+
+		if( ulActiveSector != flashkvNO_SECTOR )
+		{
+			pxStats->ulFreeBytes = pxFlash->ulSectorSize - xSectors[ ulActiveSector ].ulUsed;
+		}
+	}
+	flashkvUNLOCK();
+}
+/*-----------------------------------------------------------*/
+
+static void prvMount( void )
+{
+uint8_t ucHeader[ flashkvSECTOR_HEADER_SIZE ];
+uint32_t ulOrder[ flashkvMAX_SECTORS ];
+uint32_t ulSector, ulUsedSectors = 0, ulFreeSectors, x, y;
+
+	memset( ( void * ) &xStats, 0x00, sizeof( xStats ) );
+	ulActiveSector = flashkvNO_SECTOR;
+	ulNextSequence = 0;
+	ulLiveBytes = 0;
+
+	for( x = 0; x < flashkvMAX_KEYS; x++ )
+	{
+		xEntries[ x ].ulAddress = flashkvNO_RECORD;
+		xEntries[ x ].usLength = 0;
+	}
+
+	for( ulSector = 0; ulSector < pxFlash->ulSectorCount; ulSector++ )
+	{
+		pxFlash->pxRead( prvSectorAddress( ulSector ), ucHeader, flashkvSECTOR_HEADER_SIZE );
+
+		if( ( ( uint32_t ) ucHeader[ 0 ] | ( ( uint32_t ) ucHeader[ 1 ] << 8 ) | ( ( uint32_t ) ucHeader[ 2 ] << 16 ) | ( ( uint32_t ) ucHeader[ 3 ] << 24 ) ) == flashkvSECTOR_MAGIC )
+		{
+			xSectors[ ulSector ].ucState = flashkvSECTOR_USED;
+			xSectors[ ulSector ].ulSequence = ( uint32_t ) ucHeader[ 4 ] | ( ( uint32_t ) ucHeader[ 5 ] << 8 ) | ( ( uint32_t ) ucHeader[ 6 ] << 16 ) | ( ( uint32_t ) ucHeader[ 7 ] << 24 );
+
+			/* Insert into the list of used sectors, oldest first.  The
+			difference is signed so the order survives the sequence number
+			wrapping. */
+			for( y = ulUsedSectors; ( y > 0UL ) && ( ( int32_t ) ( xSectors[ ulOrder[ y - 1UL ] ].ulSequence - xSectors[ ulSector ].ulSequence ) > 0 ); y-- )
+			{
+				ulOrder[ y ] = ulOrder[ y - 1UL ];
+			}
+
+			ulOrder[ y ] = ulSector;
+			ulUsedSectors++;
+		}
+		else
+		{
+			/* Blank, or collected while power failed before it was erased. */
+			xSectors[ ulSector ].ucState = flashkvSECTOR_DIRTY;
+			xSectors[ ulSector ].ulSequence = 0;
+		}
+
+		xSectors[ ulSector ].ulUsed = flashkvSECTOR_HEADER_SIZE;
+	}
+
+	/* Later records replace earlier ones, so the sectors are scanned from the
+	oldest.  The newest is the one being filled. */
+	for( x = 0; x < ulUsedSectors; x++ )
+	{
+		prvScanSector( ulOrder[ x ] );
+	}
+
+	if( ulUsedSectors > 0UL )
+	{
+		ulActiveSector = ulOrder[ ulUsedSectors - 1UL ];
+		ulNextSequence = xSectors[ ulActiveSector ].ulSequence + 1UL;
+	}
+
+	/* The free sector is only used while collecting, so there is none if
+	power failed part way through a collection.  Complete it. */
+	ulFreeSectors = pxFlash->ulSectorCount - ulUsedSectors;
+
+	if( ulFreeSectors == 0UL )
+	{
+		( void ) prvCollect();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvScanSector( uint32_t ulSector )
+{
+FlashKVRecordHeader_t xHeader;
+uint32_t ulStart = prvSectorAddress( ulSector );
+uint32_t ulEnd = ulStart + pxFlash->ulSectorSize;
+uint32_t ulOffset = flashkvSECTOR_HEADER_SIZE, ulLength, x;
+uint16_t usLength;
+BaseType_t xResult;
+const uint8_t ucClear[ flashkvRECORD_HEADER_SIZE ] = { 0 };
+
+	while( ( ulOffset + flashkvRECORD_HEADER_SIZE ) <= pxFlash->ulSectorSize )
+	{
+		xResult = prvReadRecordHeader( ulStart + ulOffset, ulEnd, &xHeader );
+
+		if( xResult == flashkvHEADER_BLANK )
+		{
+			/* A program interrupted by a power failure can leave the header
+			erased but not the bytes after it, which must not be appended
+			over. */
+			ulLength = pxFlash->ulSectorSize - ulOffset;
+
+			if( ulLength > flashkvTORN_SIZE )
+			{
+				ulLength = flashkvTORN_SIZE;
+			}
+
+			pxFlash->pxRead( ulStart + ulOffset, ucRecord, ulLength );
+
+			for( x = 0; x < ulLength; x++ )
+			{
+				if( ucRecord[ x ] != 0xffU )
+				{
+					xResult = flashkvHEADER_INVALID;
+					break;
+				}
+			}
+
+			if( xResult == flashkvHEADER_BLANK )
+			{
+				break;
+			}
+		}
+
+		if( xResult == flashkvHEADER_INVALID )
+		{
+			/* Power failed while the header was being programmed, so the
+			length of the record is not known.  Clear the header so it always
+			reads as invalid, and skip the most the record could have
+			occupied. */
+			pxFlash->pxProgram( ulStart + ulOffset, ucClear, flashkvRECORD_HEADER_SIZE );
+			xStats.ulTornRecords++;
+			ulOffset += flashkvTORN_SIZE;
+			continue;
+		}
+
+		if( xHeader.ucCommit != flashkvCOMMITTED )
+		{
+			/* Power failed before the record was complete. */
+			xStats.ulTornRecords++;
+		}
+		else if( xHeader.usKey < flashkvMAX_KEYS )
+		{
+			if( ( xHeader.usLength & flashkvDELETED ) != 0U )
+			{
+				prvSetEntry( xHeader.usKey, flashkvNO_RECORD, 0U );
+			}
+			else
+			{
+				usLength = xHeader.usLength;
+				pxFlash->pxRead( ulStart + ulOffset + flashkvRECORD_HEADER_SIZE, ucRecord, usLength );
+
+				if( prvCRC16( ucRecord, usLength ) == xHeader.usCRC )
+				{
+					prvSetEntry( xHeader.usKey, ulStart + ulOffset, usLength );
+				}
+				else
+				{
+					xStats.ulTornRecords++;
+				}
+			}
+		}
+
+		ulOffset += xHeader.ulSize;
+	}
+
+	if( ulOffset > pxFlash->ulSectorSize )
+	{
+		ulOffset = pxFlash->ulSectorSize;
+	}
+
+	xSectors[ ulSector ].ulUsed = ulOffset;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvReadRecordHeader( uint32_t ulAddress, uint32_t ulEnd, FlashKVRecordHeader_t *pxHeader )
+{
+uint8_t ucHeader[ flashkvRECORD_HEADER_SIZE ];
+uint32_t x, ulLength;
+BaseType_t xReturn = flashkvHEADER_BLANK;
+
+	if( ( ulAddress + flashkvRECORD_HEADER_SIZE ) > ulEnd )
+	{
+		/* The sector is full. */
+		return flashkvHEADER_INVALID;
+	}
+
+	pxFlash->pxRead( ulAddress, ucHeader, flashkvRECORD_HEADER_SIZE );
+
+	for( x = 0; x < flashkvRECORD_HEADER_SIZE; x++ )
+	{
+		if( ucHeader[ x ] != 0xffU )
+		{
+			xReturn = flashkvHEADER_INVALID;
+			break;
+		}
+	}
+
+	if( ( xReturn == flashkvHEADER_INVALID ) && ( prvHeaderCheck( ucHeader ) == ucHeader[ 6 ] ) )
+	{
+		pxHeader->usKey = ( uint16_t ) ( ucHeader[ 0 ] | ( ucHeader[ 1 ] << 8 ) );
+		pxHeader->usLength = ( uint16_t ) ( ucHeader[ 2 ] | ( ucHeader[ 3 ] << 8 ) );
+		pxHeader->usCRC = ( uint16_t ) ( ucHeader[ 4 ] | ( ucHeader[ 5 ] << 8 ) );
+		pxHeader->ucCommit = ucHeader[ flashkvCOMMIT_OFFSET ];
+
+		ulLength = ( ( pxHeader->usLength & flashkvDELETED ) != 0U ) ? 0UL : pxHeader->usLength;
+		pxHeader->ulSize = flashkvRECORD_SIZE( ulLength );
+
+		if( ( ulLength <= flashkvMAX_VALUE_LENGTH ) && ( ( ulAddress + pxHeader->ulSize ) <= ulEnd ) )
+		{
+			xReturn = flashkvHEADER_VALID;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvReserve( uint32_t ulSize, BaseType_t xCollecting )
+{
+uint32_t ulSector, ulFreeSectors, ulAttempts = 0;
+
+	for( ;; )
+	{
+		if( ( ulActiveSector != flashkvNO_SECTOR ) && ( ( xSectors[ ulActiveSector ].ulUsed + ulSize ) <= pxFlash->ulSectorSize ) )
+		{
+			return pdPASS;
+		}
+
+		ulFreeSectors = 0;
+
+		for( ulSector = 0; ulSector < pxFlash->ulSectorCount; ulSector++ )
+		{
+			if( xSectors[ ulSector ].ucState != flashkvSECTOR_USED )
+			{
+				ulFreeSectors++;
+			}
+		}
+
+		if( ( xCollecting == pdFALSE ) && ( ulFreeSectors < 2UL ) )
+		{
+			/* Opening the last free sector would leave nowhere to copy to when
+			collecting, so collect first.  Each collection either frees a
+			sector or leaves room in the sector being filled. */
+			if( ( ulAttempts >= pxFlash->ulSectorCount ) || ( prvCollect() != pdPASS ) )
+			{
+				return pdFAIL;
+			}
+
+			ulAttempts++;
+		}
+		else if( ulFreeSectors == 0UL )
+		{
+			return pdFAIL;
+		}
+		else
+		{
+			prvOpenSector();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCollect( void )
+{
+FlashKVRecordHeader_t xHeader;
+uint32_t ulSector, ulVictim = flashkvNO_SECTOR, ulStart, ulEnd, ulOffset, ulAddress;
+const uint8_t ucClear[ 4 ] = { 0x00, 0x00, 0x00, 0x00 };
+BaseType_t xResult;
+
+	/* Find the oldest sector. */
+	for( ulSector = 0; ulSector < pxFlash->ulSectorCount; ulSector++ )
+	{
+		if( ( xSectors[ ulSector ].ucState == flashkvSECTOR_USED ) && ( ulSector != ulActiveSector ) )
+		{
+			if( ( ulVictim == flashkvNO_SECTOR ) || ( ( int32_t ) ( xSectors[ ulSector ].ulSequence - xSectors[ ulVictim ].ulSequence ) < 0 ) )
+			{
+				ulVictim = ulSector;
+			}
+		}
+	}
+
+	if( ulVictim == flashkvNO_SECTOR )
+	{
+		return pdFAIL;
+	}
+
+	ulStart = prvSectorAddress( ulVictim );
+	ulEnd = ulStart + pxFlash->ulSectorSize;
+
+	/* Copy the records that are still the latest of their key.  Deletions and
+	replaced records are dropped, as there is nothing older left for them to
+	hide once this sector has gone. */
+	for( ulOffset = flashkvSECTOR_HEADER_SIZE; ulOffset < xSectors[ ulVictim ].ulUsed; ulOffset += xHeader.ulSize )
+	{
+		ulAddress = ulStart + ulOffset;
+		xResult = prvReadRecordHeader( ulAddress, ulEnd, &xHeader );
+
+		if( xResult == flashkvHEADER_BLANK )
+		{
+			break;
+		}
+		else if( xResult == flashkvHEADER_INVALID )
+		{
+			/* Skipped in the same way as when the sector was scanned. */
+			xHeader.usKey = flashkvMAX_KEYS;
+			xHeader.ulSize = flashkvTORN_SIZE;
+			continue;
+		}
+
+		if( ( xHeader.usKey < flashkvMAX_KEYS ) && ( xEntries[ xHeader.usKey ].ulAddress == ulAddress ) )
+		{
+			if( prvReserve( xHeader.ulSize, pdTRUE ) != pdPASS )
+			{
+				return pdFAIL;
+			}
+
+			pxFlash->pxRead( ulAddress, ucRecord, xHeader.ulSize );
+			ucRecord[ flashkvCOMMIT_OFFSET ] = flashkvUNCOMMITTED;
+			prvSetEntry( xHeader.usKey, prvProgramRecord( xHeader.ulSize ), xHeader.usLength );
+			xStats.ulRecordsCopied++;
+		}
+	}
+
+	/* The sector is invalidated before it is erased, so if power fails during
+	the erase it is not mistaken for a sector holding records. */
+	pxFlash->pxProgram( ulStart, ucClear, sizeof( ucClear ) );
+	pxFlash->pxEraseSector( ulStart );
+	xSectors[ ulVictim ].ucState = flashkvSECTOR_ERASED;
+	xSectors[ ulVictim ].ulUsed = flashkvSECTOR_HEADER_SIZE;
+	xStats.ulSectorsErased++;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvOpenSector( void )
+{
+uint8_t ucHeader[ flashkvSECTOR_HEADER_SIZE ];
+uint32_t ulSector, x;
+
+	/* Take the free sectors in turn after the one being filled, so the
+	sectors are used, and worn, evenly. */
+	ulSector = ( ulActiveSector == flashkvNO_SECTOR ) ? 0UL : ulActiveSector;
+
+	for( x = 0; x < pxFlash->ulSectorCount; x++ )
+	{
+		ulSector = ( ulSector + 1UL ) % pxFlash->ulSectorCount;
+
+		if( xSectors[ ulSector ].ucState != flashkvSECTOR_USED )
+		{
+			break;
+		}
+	}
+
+	configASSERT( xSectors[ ulSector ].ucState != flashkvSECTOR_USED );
+
+	if( xSectors[ ulSector ].ucState == flashkvSECTOR_DIRTY )
+	{
+		pxFlash->pxEraseSector( prvSectorAddress( ulSector ) );
+		xStats.ulSectorsErased++;
+	}
+
+	ucHeader[ 0 ] = ( uint8_t ) flashkvSECTOR_MAGIC;
+	ucHeader[ 1 ] = ( uint8_t ) ( flashkvSECTOR_MAGIC >> 8 );
+	ucHeader[ 2 ] = ( uint8_t ) ( flashkvSECTOR_MAGIC >> 16 );
+	ucHeader[ 3 ] = ( uint8_t ) ( flashkvSECTOR_MAGIC >> 24 );
+	ucHeader[ 4 ] = ( uint8_t ) ulNextSequence;
+	ucHeader[ 5 ] = ( uint8_t ) ( ulNextSequence >> 8 );
+	ucHeader[ 6 ] = ( uint8_t ) ( ulNextSequence >> 16 );
+	ucHeader[ 7 ] = ( uint8_t ) ( ulNextSequence >> 24 );
+	pxFlash->pxProgram( prvSectorAddress( ulSector ), ucHeader, flashkvSECTOR_HEADER_SIZE );
+
+	/* Whatever space is left in the previous sector is not used. */
+	xSectors[ ulSector ].ucState = flashkvSECTOR_USED;
+	xSectors[ ulSector ].ulSequence = ulNextSequence;
+	xSectors[ ulSector ].ulUsed = flashkvSECTOR_HEADER_SIZE;
+	ulNextSequence++;
+	ulActiveSector = ulSector;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvProgramRecord( uint32_t ulSize )
+{
+uint32_t ulAddress = prvSectorAddress( ulActiveSector ) + xSectors[ ulActiveSector ].ulUsed;
+const uint8_t ucCommit = flashkvCOMMITTED;
+
+	/* The record is only valid once the commit byte has been programmed, after
+	the rest of it. */
+	pxFlash->pxProgram( ulAddress, ucRecord, ulSize );
+	pxFlash->pxProgram( ulAddress + flashkvCOMMIT_OFFSET, &ucCommit, 1UL );
+	xSectors[ ulActiveSector ].ulUsed += ulSize;
+
+	return ulAddress;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvWriteRecord( uint16_t usKey, const uint8_t *pucValue, uint16_t usLength, BaseType_t xDelete )
+{
+uint32_t ulSize = flashkvRECORD_SIZE( usLength ), ulReplaced = 0, ulAddress;
+uint16_t usLengthField = ( xDelete != pdFALSE ) ? flashkvDELETED : usLength;
+uint16_t usCRC;
+
+	if( xEntries[ usKey ].ulAddress != flashkvNO_RECORD )
+	{
+		ulReplaced = flashkvRECORD_SIZE( xEntries[ usKey ].usLength );
+	}
+
+	/* Fail before anything is written if the values would not fit once the
+	sectors had been collected. */
+	if( ( xDelete == pdFALSE ) && ( ( ulLiveBytes - ulReplaced + ulSize ) > ( ( pxFlash->ulSectorCount - 2UL ) * ( pxFlash->ulSectorSize - flashkvSECTOR_HEADER_SIZE ) ) ) )
+	{
+		return pdFAIL;
+	}
+
+	/* Collecting uses ucRecord, so room is made before the record is built. */
+	if( prvReserve( ulSize, pdFALSE ) != pdPASS )
+	{
+		return pdFAIL;
+	}
+
+	memset( ( void * ) ucRecord, 0xff, ulSize );
+
+	if( usLength > 0U )
+	{
+		memcpy( ( void * ) &( ucRecord[ flashkvRECORD_HEADER_SIZE ] ), ( const void * ) pucValue, usLength );
+	}
+
+	usCRC = prvCRC16( &( ucRecord[ flashkvRECORD_HEADER_SIZE ] ), usLength );
+	ucRecord[ 0 ] = ( uint8_t ) usKey;
+	ucRecord[ 1 ] = ( uint8_t ) ( usKey >> 8 );
+	ucRecord[ 2 ] = ( uint8_t ) usLengthField;
+	ucRecord[ 3 ] = ( uint8_t ) ( usLengthField >> 8 );
+	ucRecord[ 4 ] = ( uint8_t ) usCRC;
+	ucRecord[ 5 ] = ( uint8_t ) ( usCRC >> 8 );
+	ucRecord[ 6 ] = prvHeaderCheck( ucRecord );
+	ucRecord[ flashkvCOMMIT_OFFSET ] = flashkvUNCOMMITTED;
+
+	ulAddress = prvProgramRecord( ulSize );
+	xStats.ulRecordsWritten++;
+
+	if( xDelete != pdFALSE )
+	{
+		prvSetEntry( usKey, flashkvNO_RECORD, 0U );
+	}
+	else
+	{
+		prvSetEntry( usKey, ulAddress, usLength );
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetEntry( uint16_t usKey, uint32_t ulAddress, uint16_t usLength )
+{
+	if( xEntries[ usKey ].ulAddress != flashkvNO_RECORD )
+	{
+		ulLiveBytes -= flashkvRECORD_SIZE( xEntries[ usKey ].usLength );
+	}
+
+	if( ulAddress != flashkvNO_RECORD )
+	{
+		ulLiveBytes += flashkvRECORD_SIZE( usLength );
+	}
+
+	xEntries[ usKey ].ulAddress = ulAddress;
+	xEntries[ usKey ].usLength = usLength;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSectorAddress( uint32_t ulSector )
+{
+	return pxFlash->ulBaseAddress + ( ulSector * pxFlash->ulSectorSize );
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t prvCRC16( const uint8_t *pucData, uint32_t ulLength )
+{
+uint16_t usCRC = 0xffffU;
+uint32_t x;
+uint8_t ucBit;
+
+	/* CRC-16/CCITT, computed a bit at a time as the values are small. */
+	for( x = 0; x < ulLength; x++ )
+	{
+		usCRC ^= ( uint16_t ) ( ( uint16_t ) pucData[ x ] << 8 );
+
+		for( ucBit = 0; ucBit < 8U; ucBit++ )
+		{
+			if( ( usCRC & 0x8000U ) != 0U )
+			{
+				usCRC = ( uint16_t ) ( ( usCRC << 1 ) ^ 0x1021U );
+			}
+			else
+			{
+				usCRC = ( uint16_t ) ( usCRC << 1 );
+			}
+		}
+	}
+
+	return usCRC;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t prvHeaderCheck( const uint8_t *pucHeader )
+{
+uint8_t ucSum = 0;
+uint32_t x;
+
+	/* Neither an erased header nor a cleared one has a matching check byte. */
+	for( x = 0; x < 6UL; x++ )
+	{
+		ucSum = ( uint8_t ) ( ucSum + pucHeader[ x ] );
+	}
+
+	return ( uint8_t ) ~ucSum;
+}
+/*-----------------------------------------------------------*/
+
+#if( flashkvUSE_SPI_FLASH == 1 )
+
+	static void prvSPIFlashRead( uint32_t ulAddress, uint8_t *pucBuffer, uint32_t ulLength )
+	{
+		SPI_FLASH_BufferRead( pucBuffer, ulAddress, ulLength );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvSPIFlashProgram( uint32_t ulAddress, const uint8_t *pucData, uint32_t ulLength )
+	{
+		/* SPI_FLASH_BufferWrite() splits the data at page boundaries. */
+		SPI_FLASH_BufferWrite( ( u8 * ) pucData, ulAddress, ( u16 ) ulLength );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvSPIFlashEraseSector( uint32_t ulAddress )
+	{
+		SPI_FLASH_SectorErase( ulAddress );
+	}
+
+#endif /* flashkvUSE_SPI_FLASH */
+/*-----------------------------------------------------------*/
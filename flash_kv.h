@@ -0,0 +1,126 @@
+#ifndef FLASH_KV_H
+#define FLASH_KV_H
+
+#include "FreeRTOS.h"
+
+/*
+ * Log structured key-value store for small values kept in NOR flash, such as
+ * configuration and counters.
+ *
+ * Keys are numbers from 0 to flashkvMAX_KEYS - 1.  Writing a key appends a
+ * record holding the new value to the sector being filled, so an update costs
+ * one program of the record's bytes, not the erase and rewrite of a sector.
+ * A table in RAM holds the flash address of the latest record of every key,
+ * so a read is one flash read of the value.
+ *
+ * Once the sectors are used up the sector written least recently is garbage
+ * collected: the records in it that are still the latest of their key are
+ * copied to the sector being filled, and it is erased.  Sectors are therefore
+ * erased in turn, which spreads the wear evenly.  One sector is kept free so
+ * the copies always have somewhere to go.  The values held cannot exceed the
+ * size of flashkvSectorCount - 2 sectors.
+ *
+ * A record is only valid once its commit byte, which is programmed after the
+ * rest of the record, has been written.  A record that was being written when
+ * power failed is ignored when the store is next opened, so a key reads as
+ * either its old or its new value.  A sector is invalidated before it is
+ * erased, so a collection interrupted by a power failure can be completed
+ * when the store is next opened.
+ *
+ * The store reaches the flash through the functions of a FlashKVDevice_t, so
+ * it can be run against the SPI FLASH driver, or against the emulation of the
+ * flash in Posix/flash_sim.c on a host.
+ */
+
+/* The number of keys, which sets the size of the table in RAM. */
+#ifndef flashkvMAX_KEYS
+	#define flashkvMAX_KEYS				64
+#endif
+
+/* The largest value that can be stored. */
+#ifndef flashkvMAX_VALUE_LENGTH
+	#define flashkvMAX_VALUE_LENGTH		128
+#endif
+
+/* The largest number of sectors the store can use. */
+#ifndef flashkvMAX_SECTORS
+	#define flashkvMAX_SECTORS			8
+#endif
+
+/* Set to 0 when the store is only used by one task, or on a host. */
+#ifndef flashkvUSE_LOCK
+	#define flashkvUSE_LOCK				1
+#endif
+
+/* Set to 1 to include xFlashKVSPIFlashDevice, which stores the values in the
+M25P64 through spi_flash.c. */
+#ifndef flashkvUSE_SPI_FLASH
+	#define flashkvUSE_SPI_FLASH		1
+#endif
+
+typedef struct FLASH_KV_DEVICE
+{
+	/* Reads ulLength bytes starting at ulAddress. */
+	void ( *pxRead )( uint32_t ulAddress, uint8_t *pucBuffer, uint32_t ulLength );
+
+	/* Programs ulLength bytes starting at ulAddress, which may cross page
+	boundaries.  Programming can only clear bits, as on NOR flash. */
+	void ( *pxProgram )( uint32_t ulAddress, const uint8_t *pucData, uint32_t ulLength );
+
+	/* Erases the sector that starts at ulAddress, setting every bit. */
+	void ( *pxEraseSector )( uint32_t ulAddress );
+
+	uint32_t ulBaseAddress;		/* Address of the first sector used by the store. */
+	uint32_t ulSectorSize;		/* Size of each sector, in bytes. */
+	uint32_t ulSectorCount;		/* Number of sectors used, from 3 to flashkvMAX_SECTORS. */
+} FlashKVDevice_t;
+
+typedef struct FLASH_KV_STATS
+{
+	uint32_t ulFreeSectors;		/* Erased sectors, including the one kept free. */
+	uint32_t ulFreeBytes;		/* Bytes left in the sector being filled. */
+	uint32_t ulRecordsWritten;	/* Records appended by writes and deletes. */
+	uint32_t ulRecordsCopied;	/* Records moved by garbage collection. */
+	uint32_t ulSectorsErased;	/* Sectors erased since the store was opened. */
+	uint32_t ulTornRecords;		/* Uncommitted records found when the store was opened. */
+} FlashKVStats_t;
+
+#if( flashkvUSE_SPI_FLASH == 1 )
+	/* The sectors of the M25P64 at flashkvSPI_FLASH_BASE_ADDRESS. */
+	extern const FlashKVDevice_t xFlashKVSPIFlashDevice;
+#endif
+
+/*
+ * Opens the store on pxDevice, rebuilding the table in RAM from the records
+ * in the flash.  Sectors that do not hold a valid sector header are treated
+ * as free, so blank flash holds an empty store.  Must be called before any
+ * other function.
+ */
+BaseType_t xFlashKVInit( const FlashKVDevice_t *pxDevice );
+
+/*
+ * Stores usLength bytes from pvValue as the value of usKey.  Returns pdFAIL
+ * if the key or length are out of range, or the store is full.
+ */
+BaseType_t xFlashKVWrite( uint16_t usKey, const void *pvValue, uint16_t usLength );
+
+/*
+ * Copies the value of usKey into pvBuffer, which is usBufferLength bytes
+ * long, and sets *pusValueLength to the length of the value, which may be
+ * larger than what was copied.  pusValueLength can be NULL.  Returns pdFAIL if
+ * the key has no value.
+ */
+BaseType_t xFlashKVRead( uint16_t usKey, void *pvBuffer, uint16_t usBufferLength, uint16_t *pusValueLength );
+
+/*
+ * Removes the value of usKey.  Returns pdFAIL if the key is out of range or
+ * the store is full.  Deleting a key that has no value does nothing.
+ */
+BaseType_t xFlashKVDelete( uint16_t usKey );
+
+/*
+ * Fills in *pxStats.
+ */
+void vFlashKVGetStats( FlashKVStats_t *pxStats );
+
+#endif /* FLASH_KV_H */
@@ -0,0 +1,651 @@
+/* Circular telemetry log in the SPI FLASH, see flash_log.h. */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "message_buffer.h"
+
+/* Demo application includes. */
+#include "spi_flash.h"
+#include "flash_log.h"
+
+/* The geometry of the M25P64. */
+#define flashlogSECTOR_SIZE			0x10000UL
+#define flashlogPAGE_SIZE			256UL
+
+/* A sector header is the magic number, the sequence number of the sector and
+its inverse, all little endian.  The inverse shows a header that was being
+programmed when power failed. */
+#define flashlogMAGIC				0x31474f4cUL
+#define flashlogSECTOR_HEADER_SIZE	12UL
+
+/* A record header is the length of the record, its CRC, little endian, and a
+check byte, which is the inverse of the sum of the other three.  Erased bytes
+follow the last record. */
+#define flashlogRECORD_HEADER_SIZE	4UL
+
+#define flashlogLOCK()				( void ) xSemaphoreTake( xLock, portMAX_DELAY )
+#define flashlogUNLOCK()			( void ) xSemaphoreGive( xLock )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The task that moves the records from the message buffer to the FLASH.
+ */
+static void prvDrainTask( void *pvParameters );
+
+/*
+ * Finds the end of the log in the FLASH, or starts a new log.
+ */
+static void prvOpen( void );
+
+/*
+ * Moves the log into ulSector, which must be erased, and erases the sector
+ * after it.
+ */
+static void prvStartSector( uint32_t ulSector, uint32_t ulSequence );
+
+/*
+ * Adds a record to the page buffer, moving to the next sector first if the
+ * record does not fit in this one.
+ */
+static void prvAppendRecord( const uint8_t *pucRecord, uint16_t usLength );
+
+/*
+ * Adds bytes to the page buffer, programming the page each time it fills.
+ */
+static void prvAppendBytes( const uint8_t *pucData, uint32_t ulLength );
+
+/*
+ * Programs the bytes added to the page buffer since it was last programmed.
+ */
+static void prvProgramPage( void );
+
+/*
+ * Reads the sector header of ulSector, and returns pdTRUE if it is valid.
+ */
+static BaseType_t prvReadSectorHeader( uint32_t ulSector, uint32_t *pulSequence );
+
+/*
+ * Returns pdTRUE if ulLength bytes from ulAddress are erased.
+ */
+static BaseType_t prvIsBlank( uint32_t ulAddress, uint32_t ulLength );
+
+static void prvEraseSector( uint32_t ulSector );
+static uint32_t prvSectorAddress( uint32_t ulSector );
+static uint32_t prvSectorOfSequence( uint32_t ulSequence );
+static BaseType_t prvIsBlankHeader( const uint8_t *pucHeader );
+static BaseType_t prvIsValidHeader( const uint8_t *pucHeader );
+static uint16_t prvCRC16( const uint8_t *pucData, uint32_t ulLength );
+
+/*-----------------------------------------------------------*/
+
+/* CRC-16/CCITT of each nibble, so the drain task computes the CRC four bits
+at a time. */
+static const uint16_t usCRCTable[ 16 ] =
+{
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+	0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+};
+
+static MessageBufferHandle_t xStaging = NULL;
+static SemaphoreHandle_t xLock = NULL;
+static FlashLogStats_t xStats;
+
+/* The sector being filled, and the oldest sector that has not been erased. */
+static uint32_t ulHeadSector = 0, ulHeadSequence = 0, ulOldestSequence = 0;
+
+/* The page being filled.  The bytes from usPageStart to usPageFill have still
+to be programmed, and have been since xPendingSince. */
+static uint8_t ucPage[ flashlogPAGE_SIZE ];
+static uint32_t ulPageAddress = 0;
+static uint16_t usPageStart = 0, usPageFill = 0;
+static TickType_t xPendingSince = 0;
+
+/* The record being moved by the drain task, and the record being read by
+xFlashLogReadNext(). */
+static uint8_t ucDrainRecord[ flashlogMAX_RECORD_SIZE ];
+static uint8_t ucReadRecord[ flashlogMAX_RECORD_SIZE ];
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xFlashLogInit( UBaseType_t uxPriority )
+{
+BaseType_t xReturn = pdFAIL;
+
+	memset( ( void * ) &xStats, 0x00, sizeof( xStats ) );
+
+	/* Mutexes are not included in this demo, so a binary semaphore guards the
+	FLASH and the state of the log.  The drain task holds it while a sector is
+	erased, so a reader can wait for an erase. */
+	xLock = xSemaphoreCreateBinary();
+	xStaging = xMessageBufferCreate( flashlogSTAGING_SIZE );
+
+	if( ( xLock != NULL ) && ( xStaging != NULL ) )
+	{
+		xStats.xStagingMinimumFree = xMessageBufferSpacesAvailable( xStaging );
+		prvOpen();
+		( void ) xSemaphoreGive( xLock );
+		xReturn = xTaskCreate( prvDrainTask, "FLog", flashlogSTACK_SIZE, NULL, uxPriority, NULL );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xFlashLogWrite( const void *pvRecord, size_t xLength )
+{
+size_t xSent = 0, xFree;
+
+	if( ( xLength > 0 ) && ( xLength <= flashlogMAX_RECORD_SIZE ) )
+	{
+		/* A message buffer only has room for one writer at a time, so writes
+		from more than one task are made in a critical section, and do not
+		block. */
+		taskENTER_CRITICAL();
+		{
+			xSent = xMessageBufferSend( xStaging, pvRecord, xLength, 0 );
+
+			if( xSent != 0 )
+			{
+				xStats.ulRecordsWritten++;
+				xFree = xMessageBufferSpacesAvailable( xStaging );
+
+				if( xFree < xStats.xStagingMinimumFree )
+				{
+					xStats.xStagingMinimumFree = xFree;
+				}
+			}
+			else
+			{
+				xStats.ulRecordsDropped++;
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+
+	return ( xSent != 0 ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xFlashLogWriteFromISR( const void *pvRecord, size_t xLength, BaseType_t *pxHigherPriorityTaskWoken )
+{
+size_t xSent = 0, xFree;
+UBaseType_t uxSavedInterruptStatus;
+
+	if( ( xLength > 0 ) && ( xLength <= flashlogMAX_RECORD_SIZE ) )
+	{
+		/* Keeps out the interrupts that can also write. */
+		uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+		{
+			xSent = xMessageBufferSendFromISR( xStaging, pvRecord, xLength, pxHigherPriorityTaskWoken );
+
+			if( xSent != 0 )
+			{
+				xStats.ulRecordsWritten++;
+				xFree = xMessageBufferSpacesAvailable( xStaging );
+
+				if( xFree < xStats.xStagingMinimumFree )
+				{
+					xStats.xStagingMinimumFree = xFree;
+				}
+			}
+			else
+			{
+				xStats.ulRecordsDropped++;
+			}
+		}
+		taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+	}
+
+	return ( xSent != 0 ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+void vFlashLogReaderInit( FlashLogReader_t *pxReader )
+{
+	flashlogLOCK();
+	{
+		pxReader->ulSequence = ulOldestSequence;
+		pxReader->ulOffset = flashlogSECTOR_HEADER_SIZE;
+	}
+	flashlogUNLOCK();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xFlashLogReadNext( FlashLogReader_t *pxReader, void *pvBuffer, size_t xBufferLength, size_t *pxRecordLength )
+{
+BaseType_t xReturn = pdFAIL, xDone = pdFALSE;
+uint8_t ucHeader[ flashlogRECORD_HEADER_SIZE ];
+uint32_t ulSector, ulSequence;
+uint16_t usLength;
+
+	flashlogLOCK();
+	{
+		while( xDone == pdFALSE )
+		{
+			/* Move on to the oldest record if the sector being read has been
+			erased since. */
+			if( ( pxReader->ulSequence < ulOldestSequence ) || ( pxReader->ulSequence > ulHeadSequence ) )
+			{
+				pxReader->ulSequence = ulOldestSequence;
+				pxReader->ulOffset = flashlogSECTOR_HEADER_SIZE;
+			}
+
+			ulSector = prvSectorOfSequence( pxReader->ulSequence );
+
+			if( pxReader->ulOffset == flashlogSECTOR_HEADER_SIZE )
+			{
+				/* A sector can be missing if power failed while the log was
+				moving into it. */
+				if( ( prvReadSectorHeader( ulSector, &ulSequence ) == pdFALSE ) || ( ulSequence != pxReader->ulSequence ) )
+				{
+					memset( ( void * ) ucHeader, 0xff, sizeof( ucHeader ) );
+				}
+				else
+				{
+					SPI_FLASH_BufferRead( ucHeader, prvSectorAddress( ulSector ) + pxReader->ulOffset, flashlogRECORD_HEADER_SIZE );
+				}
+			}
+			else if( ( pxReader->ulOffset + flashlogRECORD_HEADER_SIZE ) <= flashlogSECTOR_SIZE )
+			{
+				SPI_FLASH_BufferRead( ucHeader, prvSectorAddress( ulSector ) + pxReader->ulOffset, flashlogRECORD_HEADER_SIZE );
+			}
+			else
+			{
+				memset( ( void * ) ucHeader, 0xff, sizeof( ucHeader ) );
+			}
+
+			if( ( prvIsValidHeader( ucHeader ) != pdFALSE ) &&
+				( ( pxReader->ulOffset + flashlogRECORD_HEADER_SIZE + ucHeader[ 0 ] ) <= flashlogSECTOR_SIZE ) )
+			{
+				usLength = ucHeader[ 0 ];
+				SPI_FLASH_BufferRead( ucReadRecord, prvSectorAddress( ulSector ) + pxReader->ulOffset + flashlogRECORD_HEADER_SIZE, usLength );
+				pxReader->ulOffset += flashlogRECORD_HEADER_SIZE + usLength;
+
+				/* Records that were being programmed when power failed are
+				skipped. */
+				if( prvCRC16( ucReadRecord, usLength ) == ( uint16_t ) ( ucHeader[ 1 ] | ( ucHeader[ 2 ] << 8 ) ) )
+				{
+					memcpy( pvBuffer, ( const void * ) ucReadRecord, ( usLength < xBufferLength ) ? usLength : xBufferLength );
+					*pxRecordLength = usLength;
+					xReturn = pdPASS;
+					xDone = pdTRUE;
+				}
+			}
+			else if( pxReader->ulSequence == ulHeadSequence )
+			{
+				/* Every record programmed so far has been read. */
+				xDone = pdTRUE;
+			}
+			else
+			{
+				/* The end of a full sector, or a record header that was being
+				programmed when power failed. */
+				pxReader->ulSequence++;
+				pxReader->ulOffset = flashlogSECTOR_HEADER_SIZE;
+			}
+		}
+	}
+	flashlogUNLOCK();
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vFlashLogGetStats( FlashLogStats_t *pxStats )
+{
+	taskENTER_CRITICAL();
+	{
+		*pxStats = xStats;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static void prvDrainTask( void *pvParameters )
+{
+size_t xLength;
+TickType_t xWait, xWaited;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		/* Only wait for the next record for as long as the bytes waiting to be
+		programmed can be left. */
+		xWait = portMAX_DELAY;
+
+		if( usPageFill != usPageStart )
+		{
+			xWaited = xTaskGetTickCount() - xPendingSince;
+			xWait = ( xWaited < flashlogFLUSH_DELAY ) ? ( flashlogFLUSH_DELAY - xWaited ) : 0;
+		}
+
+		xLength = xMessageBufferReceive( xStaging, ( void * ) ucDrainRecord, sizeof( ucDrainRecord ), xWait );
+
+		flashlogLOCK();
+		{
+			if( xLength > 0 )
+			{
+				prvAppendRecord( ucDrainRecord, ( uint16_t ) xLength );
+				xStats.ulRecordsLogged++;
+			}
+
+			if( ( usPageFill != usPageStart ) && ( ( xTaskGetTickCount() - xPendingSince ) >= flashlogFLUSH_DELAY ) )
+			{
+				prvProgramPage();
+			}
+		}
+		flashlogUNLOCK();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvOpen( void )
+{
+uint8_t ucHeader[ flashlogRECORD_HEADER_SIZE ];
+uint32_t ulSector, ulSequence, ulOffset, ulNext;
+BaseType_t xFound = pdFALSE, xUsable = pdTRUE;
+
+	/* The sector being filled is the one with the highest sequence number. */
+	for( ulSector = 0; ulSector < flashlogSECTORS; ulSector++ )
+	{
+		if( prvReadSectorHeader( ulSector, &ulSequence ) != pdFALSE )
+		{
+			if( ( xFound == pdFALSE ) || ( ulSequence > ulHeadSequence ) )
+			{
+				ulHeadSector = ulSector;
+				ulHeadSequence = ulSequence;
+				xFound = pdTRUE;
+			}
+		}
+	}
+
+	if( xFound == pdFALSE )
+	{
+		/* Blank, or holding something else. */
+		ulOldestSequence = 0;
+		prvEraseSector( 0 );
+		prvStartSector( 0, 0 );
+	}
+	else
+	{
+		/* The oldest sector still in sequence with it, ignoring the sector
+		after it, which is erased below. */
+		ulOldestSequence = ulHeadSequence;
+
+		for( ulSector = 0; ulSector < flashlogSECTORS; ulSector++ )
+		{
+			if( ( prvReadSectorHeader( ulSector, &ulSequence ) != pdFALSE ) &&
+				( ulSequence < ulOldestSequence ) &&
+				( ( ulHeadSequence - ulSequence ) < ( flashlogSECTORS - 1UL ) ) &&
+				( prvSectorOfSequence( ulSequence ) == ulSector ) )
+			{
+				ulOldestSequence = ulSequence;
+			}
+		}
+
+		/* Walk the records of the sector being filled to find its end. */
+		ulOffset = flashlogSECTOR_HEADER_SIZE;
+
+		while( ( ulOffset + flashlogRECORD_HEADER_SIZE ) <= flashlogSECTOR_SIZE )
+		{
+			SPI_FLASH_BufferRead( ucHeader, prvSectorAddress( ulHeadSector ) + ulOffset, flashlogRECORD_HEADER_SIZE );
+
+			if( prvIsBlankHeader( ucHeader ) != pdFALSE )
+			{
+				break;
+			}
+
+			if( ( prvIsValidHeader( ucHeader ) == pdFALSE ) ||
+				( ( ulOffset + flashlogRECORD_HEADER_SIZE + ucHeader[ 0 ] ) > flashlogSECTOR_SIZE ) )
+			{
+				xUsable = pdFALSE;
+				break;
+			}
+
+			ulOffset += flashlogRECORD_HEADER_SIZE + ucHeader[ 0 ];
+		}
+
+		/* A program interrupted by a power failure can leave bytes after the
+		end programmed, and the next record would be programmed over them. */
+		if( ( xUsable != pdFALSE ) && ( ulOffset < flashlogSECTOR_SIZE ) )
+		{
+			ulNext = flashlogRECORD_HEADER_SIZE + flashlogMAX_RECORD_SIZE;
+
+			if( ( ulOffset + ulNext ) > flashlogSECTOR_SIZE )
+			{
+				ulNext = flashlogSECTOR_SIZE - ulOffset;
+			}
+
+			xUsable = prvIsBlank( prvSectorAddress( ulHeadSector ) + ulOffset, ulNext );
+		}
+
+		/* Power can have failed before the sector after the one being filled
+		was erased. */
+		ulNext = ( ulHeadSector + 1UL ) % flashlogSECTORS;
+
+		if( prvIsBlank( prvSectorAddress( ulNext ), flashlogSECTOR_SIZE ) == pdFALSE )
+		{
+			prvEraseSector( ulNext );
+		}
+
+		if( xUsable != pdFALSE )
+		{
+			ulPageAddress = prvSectorAddress( ulHeadSector ) + ( ulOffset & ~( flashlogPAGE_SIZE - 1UL ) );
+			usPageStart = ( uint16_t ) ( ulOffset & ( flashlogPAGE_SIZE - 1UL ) );
+			usPageFill = usPageStart;
+		}
+		else
+		{
+			prvStartSector( ulNext, ulHeadSequence + 1UL );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvStartSector( uint32_t ulSector, uint32_t ulSequence )
+{
+uint32_t ulNext = ( ulSector + 1UL ) % flashlogSECTORS;
+
+	ucPage[ 0 ] = ( uint8_t ) flashlogMAGIC;
+	ucPage[ 1 ] = ( uint8_t ) ( flashlogMAGIC >> 8 );
+	ucPage[ 2 ] = ( uint8_t ) ( flashlogMAGIC >> 16 );
+	ucPage[ 3 ] = ( uint8_t ) ( flashlogMAGIC >> 24 );
+	ucPage[ 4 ] = ( uint8_t ) ulSequence;
+	ucPage[ 5 ] = ( uint8_t ) ( ulSequence >> 8 );
+	ucPage[ 6 ] = ( uint8_t ) ( ulSequence >> 16 );
+	ucPage[ 7 ] = ( uint8_t ) ( ulSequence >> 24 );
+	ucPage[ 8 ] = ( uint8_t ) ~ucPage[ 4 ];
+	ucPage[ 9 ] = ( uint8_t ) ~ucPage[ 5 ];
+	ucPage[ 10 ] = ( uint8_t ) ~ucPage[ 6 ];
+	ucPage[ 11 ] = ( uint8_t ) ~ucPage[ 7 ];
+
+	SPI_FLASH_PageWrite( ucPage, prvSectorAddress( ulSector ), ( u16 ) flashlogSECTOR_HEADER_SIZE );
+	xStats.ulPagesProgrammed++;
+
+	ulHeadSector = ulSector;
+	ulHeadSequence = ulSequence;
+	ulPageAddress = prvSectorAddress( ulSector );
+	usPageStart = ( uint16_t ) flashlogSECTOR_HEADER_SIZE;
+	usPageFill = usPageStart;
+
+	/* Erase the sector after this one now, so it is ready when this one is
+	full.  It holds the oldest records. */
+	if( ( ulSequence + 2UL ) > flashlogSECTORS )
+	{
+		if( ulOldestSequence < ( ulSequence + 2UL - flashlogSECTORS ) )
+		{
+			ulOldestSequence = ulSequence + 2UL - flashlogSECTORS;
+		}
+	}
+
+	prvEraseSector( ulNext );
+}
+/*-----------------------------------------------------------*/
+
+static void prvAppendRecord( const uint8_t *pucRecord, uint16_t usLength )
+{
+uint8_t ucHeader[ flashlogRECORD_HEADER_SIZE ];
+uint16_t usCRC = prvCRC16( pucRecord, usLength );
+uint32_t ulOffset = ( ulPageAddress - prvSectorAddress( ulHeadSector ) ) + usPageFill;
+
+	/* Records do not cross into the next sector. */
+	if( ( ulOffset + flashlogRECORD_HEADER_SIZE + usLength ) > flashlogSECTOR_SIZE )
+	{
+		prvProgramPage();
+		prvStartSector( ( ulHeadSector + 1UL ) % flashlogSECTORS, ulHeadSequence + 1UL );
+	}
+
+	ucHeader[ 0 ] = ( uint8_t ) usLength;
+	ucHeader[ 1 ] = ( uint8_t ) usCRC;
+	ucHeader[ 2 ] = ( uint8_t ) ( usCRC >> 8 );
+	ucHeader[ 3 ] = ( uint8_t ) ~( ucHeader[ 0 ] + ucHeader[ 1 ] + ucHeader[ 2 ] );
+
+	prvAppendBytes( ucHeader, flashlogRECORD_HEADER_SIZE );
+	prvAppendBytes( pucRecord, usLength );
+}
+/*-----------------------------------------------------------*/
+
+static void prvAppendBytes( const uint8_t *pucData, uint32_t ulLength )
+{
+uint32_t ulChunk;
+
+	while( ulLength > 0UL )
+	{
+		if( usPageFill == usPageStart )
+		{
+			xPendingSince = xTaskGetTickCount();
+		}
+
+		ulChunk = flashlogPAGE_SIZE - usPageFill;
+
+		if( ulChunk > ulLength )
+		{
+			ulChunk = ulLength;
+		}
+
+		memcpy( ( void * ) &( ucPage[ usPageFill ] ), ( const void * ) pucData, ulChunk );
+		usPageFill += ( uint16_t ) ulChunk;
+		pucData += ulChunk;
+		ulLength -= ulChunk;
+
+		if( usPageFill == flashlogPAGE_SIZE )
+		{
+			prvProgramPage();
+			ulPageAddress += flashlogPAGE_SIZE;
+			usPageStart = 0;
+			usPageFill = 0;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvProgramPage( void )
+{
+	if( usPageFill != usPageStart )
+	{
+		SPI_FLASH_PageWrite( &( ucPage[ usPageStart ] ), ulPageAddress + usPageStart, ( u16 ) ( usPageFill - usPageStart ) );
+		xStats.ulPagesProgrammed++;
+		usPageStart = usPageFill;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvReadSectorHeader( uint32_t ulSector, uint32_t *pulSequence )
+{
+uint8_t ucHeader[ flashlogSECTOR_HEADER_SIZE ];
+uint32_t ulMagic, ulInverse;
+
+	SPI_FLASH_BufferRead( ucHeader, prvSectorAddress( ulSector ), flashlogSECTOR_HEADER_SIZE );
+
+	ulMagic = ( uint32_t ) ucHeader[ 0 ] | ( ( uint32_t ) ucHeader[ 1 ] << 8 ) | ( ( uint32_t ) ucHeader[ 2 ] << 16 ) | ( ( uint32_t ) ucHeader[ 3 ] << 24 );
+	*pulSequence = ( uint32_t ) ucHeader[ 4 ] | ( ( uint32_t ) ucHeader[ 5 ] << 8 ) | ( ( uint32_t ) ucHeader[ 6 ] << 16 ) | ( ( uint32_t ) ucHeader[ 7 ] << 24 );
+	ulInverse = ( uint32_t ) ucHeader[ 8 ] | ( ( uint32_t ) ucHeader[ 9 ] << 8 ) | ( ( uint32_t ) ucHeader[ 10 ] << 16 ) | ( ( uint32_t ) ucHeader[ 11 ] << 24 );
+
+	return ( ( ulMagic == flashlogMAGIC ) && ( *pulSequence == ~ulInverse ) ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsBlank( uint32_t ulAddress, uint32_t ulLength )
+{
+BaseType_t xBlank = pdTRUE;
+uint32_t ulChunk, x;
+
+	/* The page buffer is free whenever this is called. */
+	while( ( ulLength > 0UL ) && ( xBlank != pdFALSE ) )
+	{
+		ulChunk = ( ulLength < flashlogPAGE_SIZE ) ? ulLength : flashlogPAGE_SIZE;
+		SPI_FLASH_BufferRead( ucPage, ulAddress, ulChunk );
+
+		for( x = 0; x < ulChunk; x++ )
+		{
+			if( ucPage[ x ] != 0xff )
+			{
+				xBlank = pdFALSE;
+				break;
+			}
+		}
+
+		ulAddress += ulChunk;
+		ulLength -= ulChunk;
+	}
+
+	return xBlank;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEraseSector( uint32_t ulSector )
+{
+	SPI_FLASH_SectorErase( prvSectorAddress( ulSector ) );
+	xStats.ulSectorsErased++;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSectorAddress( uint32_t ulSector )
+{
+	return flashlogBASE_ADDRESS + ( ulSector * flashlogSECTOR_SIZE );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSectorOfSequence( uint32_t ulSequence )
+{
+	/* Sectors are filled in turn, so their sequence numbers follow the head
+	back around the sectors. */
+	return ( ulHeadSector + flashlogSECTORS - ( ( ulHeadSequence - ulSequence ) % flashlogSECTORS ) ) % flashlogSECTORS;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsBlankHeader( const uint8_t *pucHeader )
+{
+	return ( ( pucHeader[ 0 ] & pucHeader[ 1 ] & pucHeader[ 2 ] & pucHeader[ 3 ] ) == 0xff ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsValidHeader( const uint8_t *pucHeader )
+{
+	return ( ( pucHeader[ 0 ] > 0U ) &&
+			 ( pucHeader[ 0 ] <= flashlogMAX_RECORD_SIZE ) &&
+			 ( pucHeader[ 3 ] == ( uint8_t ) ~( pucHeader[ 0 ] + pucHeader[ 1 ] + pucHeader[ 2 ] ) ) ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static uint16_t prvCRC16( const uint8_t *pucData, uint32_t ulLength )
+{
+uint16_t usCRC = 0xffffU;
+uint32_t x;
+
+	for( x = 0; x < ulLength; x++ )
+	{
+		usCRC = ( uint16_t ) ( usCRC << 4 ) ^ usCRCTable[ ( usCRC >> 12 ) ^ ( pucData[ x ] >> 4 ) ];
+		usCRC = ( uint16_t ) ( usCRC << 4 ) ^ usCRCTable[ ( usCRC >> 12 ) ^ ( pucData[ x ] & 0x0fU ) ];
+	}
+
+	return usCRC;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,118 @@
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include "FreeRTOS.h"
+
+/*
+ * Circular telemetry log in the SPI FLASH.
+ *
+ * Tasks and interrupts add records with xFlashLogWrite() and
+ * xFlashLogWriteFromISR(), which copy the record into a message buffer in
+ * RAM and never block.  A record that does not fit in the message buffer is
+ * dropped and counted.  A task of low priority drains the message buffer,
+ * packs the records into whole pages and programs each page once it is full,
+ * or once no record has arrived for flashlogFLUSH_DELAY.
+ *
+ * The log occupies flashlogSECTORS sectors used in turn.  Each sector starts
+ * with a header holding its sequence number, and records do not cross from
+ * one sector to the next.  When the log moves into a sector, the sector after
+ * it, which holds the oldest records, is erased, so there is always an erased
+ * sector ahead of the log and the log never waits for an erase when it
+ * reaches the end of a sector.  The records of flashlogSECTORS - 2 full
+ * sectors are therefore kept.
+ *
+ * While a sector is erased, and while a page is programmed, the records
+ * produced collect in the message buffer, so flashlogSTAGING_SIZE must hold
+ * the records produced in the time taken to erase a sector (typically 1s for
+ * the M25P64, 3s at most).
+ *
+ * When the log is opened it finds the newest sector from the sector headers,
+ * and only walks the records of that sector to find where to continue.
+ * Records that were being programmed when power failed fail their CRC and are
+ * skipped when the log is read.
+ */
+
+/* The sectors of the M25P64 used by the log. */
+#ifndef flashlogBASE_ADDRESS
+	#define flashlogBASE_ADDRESS		0x600000UL
+#endif
+
+#ifndef flashlogSECTORS
+	#define flashlogSECTORS				16UL
+#endif
+
+/* The size of the message buffer the records are written to. */
+#ifndef flashlogSTAGING_SIZE
+	#define flashlogSTAGING_SIZE		1024U
+#endif
+
+/* The largest record, at most 255 bytes. */
+#ifndef flashlogMAX_RECORD_SIZE
+	#define flashlogMAX_RECORD_SIZE		64U
+#endif
+
+/* The longest a record waits in RAM before it is programmed. */
+#ifndef flashlogFLUSH_DELAY
+	#define flashlogFLUSH_DELAY			pdMS_TO_TICKS( 100 )
+#endif
+
+#ifndef flashlogSTACK_SIZE
+	#define flashlogSTACK_SIZE			configMINIMAL_STACK_SIZE
+#endif
+
+typedef struct FLASH_LOG_STATS
+{
+	uint32_t ulRecordsWritten;	/* Records accepted by xFlashLogWrite() and xFlashLogWriteFromISR(). */
+	uint32_t ulRecordsDropped;	/* Records that did not fit in the message buffer. */
+	uint32_t ulRecordsLogged;	/* Records moved from the message buffer to the FLASH. */
+	uint32_t ulPagesProgrammed;	/* Page programs issued. */
+	uint32_t ulSectorsErased;
+	size_t xStagingMinimumFree;	/* The least free space seen in the message buffer, to size flashlogSTAGING_SIZE. */
+} FlashLogStats_t;
+
+/* Used by xFlashLogReadNext() to walk the log, see vFlashLogReaderInit(). */
+typedef struct FLASH_LOG_READER
+{
+	uint32_t ulSequence;		/* Sequence number of the sector being read. */
+	uint32_t ulOffset;			/* Offset of the next record in it. */
+} FlashLogReader_t;
+
+/*
+ * Opens the log, erasing the sectors it uses if they do not hold a log, and
+ * creates the task that drains the message buffer at uxPriority.  Must be
+ * called from a task once SPI_FLASH_Init() has been called.
+ */
+BaseType_t xFlashLogInit( UBaseType_t uxPriority );
+
+/*
+ * Queues a record of xLength bytes to be logged.  Never blocks.  Returns
+ * pdFAIL, and counts the record as dropped, if it does not fit.  Can be called
+ * by any number of tasks.
+ */
+BaseType_t xFlashLogWrite( const void *pvRecord, size_t xLength );
+
+/*
+ * As xFlashLogWrite(), for use from interrupts.
+ */
+BaseType_t xFlashLogWriteFromISR( const void *pvRecord, size_t xLength, BaseType_t *pxHigherPriorityTaskWoken );
+
+/*
+ * Positions pxReader at the oldest record in the log.
+ */
+void vFlashLogReaderInit( FlashLogReader_t *pxReader );
+
+/*
+ * Copies the next record in the log into pvBuffer, which is xBufferLength
+ * bytes long, and sets *pxRecordLength to its length.  Returns pdFAIL once
+ * every record programmed so far has been read, and can be called again later
+ * to read the records programmed since.  If the records the reader had got to
+ * have been overwritten it moves on to the oldest record.
+ */
+BaseType_t xFlashLogReadNext( FlashLogReader_t *pxReader, void *pvBuffer, size_t xBufferLength, size_t *pxRecordLength );
+
+/*
+ * Fills in *pxStats.
+ */
+void vFlashLogGetStats( FlashLogStats_t *pxStats );
+
+#endif /* FLASH_LOG_H */
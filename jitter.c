@@ -0,0 +1,233 @@
+/* Interrupt latency and jitter histogram, see jitter.h. */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+
+/* Demo application includes. */
+#include "serial.h"
+#include "jitter.h"
+
+/* The first deviation that is counted in the log2 buckets. */
+#define jitterLINEAR_LIMIT		( ( unsigned long ) jitterLINEAR_BUCKETS * jitterLINEAR_WIDTH )
+
+/* Long enough for the CSV line of one histogram. */
+#define jitterLINE_LENGTH		( 64 + ( jitterNUM_BUCKETS * 11 ) )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Returns the bucket that counts ulDeviation.
+ */
+static unsigned long prvBucketIndex( unsigned long ulDeviation );
+
+/*
+ * Returns the largest deviation counted in bucket ulBucket.
+ */
+static unsigned long prvBucketUpperBound( unsigned long ulBucket );
+
+/*-----------------------------------------------------------*/
+
+void vJitterInit( JitterHistogram_t *pxJitter, unsigned long ulExpectedPeriod, unsigned long ulCounterMask, unsigned long ulSettleCount )
+{
+	memset( ( void * ) pxJitter, 0x00, sizeof( JitterHistogram_t ) );
+	pxJitter->ulExpectedPeriod = ulExpectedPeriod;
+	pxJitter->ulCounterMask = ulCounterMask;
+	pxJitter->ulSettleCount = ulSettleCount;
+
+	/* The first interrupt has no previous count to measure from. */
+	if( pxJitter->ulSettleCount == 0UL )
+	{
+		pxJitter->ulSettleCount = 1UL;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vJitterRecordFromISR( JitterHistogram_t *pxJitter, unsigned long ulCount )
+{
+unsigned long ulDifference, ulDeviation;
+
+	if( pxJitter->ulSettleCount > 0UL )
+	{
+		/* Don't bother storing any values for the first couple of
+		interrupts. */
+		pxJitter->ulSettleCount--;
+	}
+	else
+	{
+		/* The mask makes the subtraction wrap at the width of the counter. */
+		ulDifference = ( ulCount - pxJitter->ulLastCount ) & pxJitter->ulCounterMask;
+
+		if( ulDifference >= pxJitter->ulExpectedPeriod )
+		{
+			ulDeviation = ulDifference - pxJitter->ulExpectedPeriod;
+		}
+		else
+		{
+			ulDeviation = pxJitter->ulExpectedPeriod - ulDifference;
+		}
+
+		pxJitter->ulBuckets[ prvBucketIndex( ulDeviation ) ]++;
+		pxJitter->ulSamples++;
+
+		if( ulDeviation > pxJitter->ulMaxDeviation )
+		{
+			pxJitter->ulMaxDeviation = ulDeviation;
+			pxJitter->ulWorstSample = pxJitter->ulSamples;
+			pxJitter->ulWorstCount = ulCount;
+		}
+
+		pxJitter->ulSequence++;
+	}
+
+	/* Remember what the counter value was this time through, so we can
+	calculate the difference the next time through. */
+	pxJitter->ulLastCount = ulCount;
+}
+/*-----------------------------------------------------------*/
+
+void vJitterSnapshot( const JitterHistogram_t *pxJitter, JitterHistogram_t *pxCopy )
+{
+const volatile JitterHistogram_t *pxSource = pxJitter;
+unsigned long ulSequence, x;
+
+	/* The writer is an interrupt, so it always runs to completion before the
+	reader continues.  Copy again if it ran part way through the copy. */
+	do
+	{
+		ulSequence = pxSource->ulSequence;
+
+		pxCopy->ulExpectedPeriod = pxSource->ulExpectedPeriod;
+		pxCopy->ulCounterMask = pxSource->ulCounterMask;
+		pxCopy->ulSettleCount = pxSource->ulSettleCount;
+		pxCopy->ulLastCount = pxSource->ulLastCount;
+		pxCopy->ulSamples = pxSource->ulSamples;
+		pxCopy->ulMaxDeviation = pxSource->ulMaxDeviation;
+		pxCopy->ulWorstSample = pxSource->ulWorstSample;
+		pxCopy->ulWorstCount = pxSource->ulWorstCount;
+
+		for( x = 0; x < jitterNUM_BUCKETS; x++ )
+		{
+			pxCopy->ulBuckets[ x ] = pxSource->ulBuckets[ x ];
+		}
+
+		pxCopy->ulSequence = ulSequence;
+	} while( ulSequence != pxSource->ulSequence );
+}
+/*-----------------------------------------------------------*/
+
+unsigned long ulJitterPercentile( const JitterHistogram_t *pxJitter, unsigned long ulPerTenThousand )
+{
+unsigned long ulBucket, ulSeen = 0, ulTarget, ulUpperBound;
+
+	/* The number of samples at or below the percentile, rounded up. */
+	ulTarget = ( unsigned long ) ( ( ( ( unsigned long long ) pxJitter->ulSamples * ulPerTenThousand ) + 9999ULL ) / 10000ULL );
+
+	for( ulBucket = 0; ulBucket < jitterNUM_BUCKETS; ulBucket++ )
+	{
+		ulSeen += pxJitter->ulBuckets[ ulBucket ];
+
+		if( ( ulSeen >= ulTarget ) && ( ulSeen > 0UL ) )
+		{
+			break;
+		}
+	}
+
+	if( ulBucket >= jitterNUM_BUCKETS )
+	{
+		/* No samples yet. */
+		ulUpperBound = 0UL;
+	}
+	else
+	{
+		ulUpperBound = prvBucketUpperBound( ulBucket );
+	}
+
+	/* The bucket bound can be larger than any sample actually seen. */
+	if( ulUpperBound > pxJitter->ulMaxDeviation )
+	{
+		ulUpperBound = pxJitter->ulMaxDeviation;
+	}
+
+	return ulUpperBound;
+}
+/*-----------------------------------------------------------*/
+
+void vJitterReport( const JitterHistogram_t *pxJitter, const char *pcName )
+{
+static char cLine[ jitterLINE_LENGTH ];
+static JitterHistogram_t xCopy;
+size_t xLength;
+unsigned long ulBucket;
+
+	vJitterSnapshot( pxJitter, &xCopy );
+
+	xLength = ( size_t ) sprintf( cLine, "jitter,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu", pcName,
+								  xCopy.ulSamples,
+								  xCopy.ulMaxDeviation,
+								  xCopy.ulWorstSample,
+								  xCopy.ulWorstCount,
+								  ulJitterPercentile( &xCopy, 5000UL ),
+								  ulJitterPercentile( &xCopy, 9900UL ),
+								  ulJitterPercentile( &xCopy, 9990UL ) );
+
+	for( ulBucket = 0; ulBucket < jitterNUM_BUCKETS; ulBucket++ )
+	{
+		xLength += ( size_t ) sprintf( &( cLine[ xLength ] ), ",%lu", xCopy.ulBuckets[ ulBucket ] );
+	}
+
+	xLength += ( size_t ) sprintf( &( cLine[ xLength ] ), "\r\n" );
+	vSerialPutString( NULL, ( const signed char * ) cLine, ( unsigned short ) xLength );
+}
+/*-----------------------------------------------------------*/
+
+static unsigned long prvBucketIndex( unsigned long ulDeviation )
+{
+unsigned long ulBucket, ulLimit;
+
+	if( ulDeviation < jitterLINEAR_LIMIT )
+	{
+		ulBucket = ulDeviation / jitterLINEAR_WIDTH;
+	}
+	else
+	{
+		/* Each log2 bucket is twice as wide as the one before it.  The last
+		bucket also counts everything larger. */
+		ulBucket = jitterLINEAR_BUCKETS;
+		ulLimit = jitterLINEAR_LIMIT << 1UL;
+
+		while( ( ulDeviation >= ulLimit ) && ( ulBucket < ( jitterNUM_BUCKETS - 1 ) ) )
+		{
+			ulLimit <<= 1UL;
+			ulBucket++;
+		}
+	}
+
+	return ulBucket;
+}
+/*-----------------------------------------------------------*/
+
+static unsigned long prvBucketUpperBound( unsigned long ulBucket )
+{
+unsigned long ulUpperBound;
+
+	if( ulBucket < jitterLINEAR_BUCKETS )
+	{
+		ulUpperBound = ( ( ulBucket + 1UL ) * jitterLINEAR_WIDTH ) - 1UL;
+	}
+	else if( ulBucket < ( jitterNUM_BUCKETS - 1 ) )
+	{
+		ulUpperBound = ( jitterLINEAR_LIMIT << ( ulBucket - jitterLINEAR_BUCKETS + 1UL ) ) - 1UL;
+	}
+	else
+	{
+		/* The last bucket is open ended. */
+		ulUpperBound = 0xffffffffUL;
+	}
+
+	return ulUpperBound;
+}
+/*-----------------------------------------------------------*/
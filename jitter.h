@@ -0,0 +1,84 @@
+#ifndef JITTER_H
+#define JITTER_H
+
+#include "FreeRTOS.h"
+
+/*
+ * Interrupt latency and jitter histogram.
+ *
+ * A timer interrupt handler calls vJitterRecordFromISR() on entry and passes
+ * the value of a free running counter.  The time between consecutive calls is
+ * compared with the expected period.  The absolute deviation is counted in a
+ * histogram, which has jitterLINEAR_BUCKETS buckets of jitterLINEAR_WIDTH
+ * counts followed by jitterLOG2_BUCKETS buckets that each double in width.
+ *
+ * Any number of histograms can be used, one per interrupt source.  Only one
+ * interrupt may write to a given histogram.  Tasks can read it at any time
+ * with vJitterSnapshot(), which does not mask the interrupt.
+ */
+
+#ifndef jitterLINEAR_BUCKETS
+	#define jitterLINEAR_BUCKETS	16
+#endif
+
+/* jitterLINEAR_BUCKETS * jitterLINEAR_WIDTH must be a power of two. */
+#ifndef jitterLINEAR_WIDTH
+	#define jitterLINEAR_WIDTH		4
+#endif
+
+#ifndef jitterLOG2_BUCKETS
+	#define jitterLOG2_BUCKETS		16
+#endif
+
+#define jitterNUM_BUCKETS			( jitterLINEAR_BUCKETS + jitterLOG2_BUCKETS )
+
+typedef struct JITTER_HISTOGRAM
+{
+	/* Configuration, set by vJitterInit(). */
+	unsigned long ulExpectedPeriod;	/* Expected counts between interrupts. */
+	unsigned long ulCounterMask;	/* 0xffff for a 16-bit timer, 0xffffffff for DWT_CYCCNT. */
+	unsigned long ulSettleCount;	/* Interrupts to ignore before recording. */
+
+	/* Incremented by each update so a reader can detect that the interrupt
+	ran while it was taking a copy. */
+	volatile unsigned long ulSequence;
+
+	unsigned long ulLastCount;
+	unsigned long ulSamples;
+	unsigned long ulMaxDeviation;
+	unsigned long ulWorstSample;	/* Sample number at which ulMaxDeviation was seen. */
+	unsigned long ulWorstCount;		/* Counter value at which ulMaxDeviation was seen. */
+	unsigned long ulBuckets[ jitterNUM_BUCKETS ];
+} JitterHistogram_t;
+
+/*
+ * Clears pxJitter and sets the period it expects between interrupts.
+ */
+void vJitterInit( JitterHistogram_t *pxJitter, unsigned long ulExpectedPeriod, unsigned long ulCounterMask, unsigned long ulSettleCount );
+
+/*
+ * Call on entry to the interrupt handler with the current counter value.
+ */
+void vJitterRecordFromISR( JitterHistogram_t *pxJitter, unsigned long ulCount );
+
+/*
+ * Takes a consistent copy of pxJitter into pxCopy.  Must not be called from
+ * the interrupt that writes pxJitter.
+ */
+void vJitterSnapshot( const JitterHistogram_t *pxJitter, JitterHistogram_t *pxCopy );
+
+/*
+ * Returns the upper bound, in counter counts, of the bucket that holds the
+ * given percentile.  ulPerTenThousand is 5000 for p50, 9900 for p99 and 9990
+ * for p99.9.
+ */
+unsigned long ulJitterPercentile( const JitterHistogram_t *pxJitter, unsigned long ulPerTenThousand );
+
+/*
+ * Writes one CSV line for the histogram over the serial port:
+ *
+ * jitter,<name>,<samples>,<max>,<worst sample>,<worst count>,<p50>,<p99>,<p999>,<bucket 0>,...
+ */
+void vJitterReport( const JitterHistogram_t *pxJitter, const char *pcName );
+
+#endif /* JITTER_H */
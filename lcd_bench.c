@@ -0,0 +1,136 @@
+/* LCD drawing benchmarks, see lcd_bench.h. */
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Library includes. */
+#include "lcd.h"
+
+/* Demo application includes. */
+#include "KernelBench.h"
+#include "lcd_bench.h"
+
+/* The number of pixels written by each clear iteration. */
+#define benchLCD_PIXELS			( 320UL * 240UL )
+
+/* The line drawn by the text benchmarks. */
+#define benchLCD_TEXT			"Temp 23.5C  Rx 1024 "
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Initialises the LCD the first time it is called, and selects polling or the
+ * DMA.
+ */
+static BaseType_t prvLCDSetUp( uint32_t ulUseDMA );
+
+/*
+ * Clear the LCD, returning the cycles taken.
+ */
+static uint32_t prvLCDClearPixelIteration( void );
+static uint32_t prvLCDClearFillIteration( void );
+
+/*
+ * Draw benchLCD_TEXT on the first line, returning the cycles taken.
+ */
+static uint32_t prvLCDTextCharIteration( void );
+static uint32_t prvLCDTextLineIteration( void );
+
+/*-----------------------------------------------------------*/
+
+static const BenchCase_t xLCDCases[] =
+{
+	{ "LCD clear per pixel",	prvLCDClearPixelIteration,	NULL, 0, prvLCDSetUp, NULL, 0 },
+	{ "LCD clear fill polled",	prvLCDClearFillIteration,	NULL, 0, prvLCDSetUp, NULL, 0 },
+	#if ( LCD_USE_DMA == 1 )
+		{ "LCD clear fill DMA",	prvLCDClearFillIteration,	NULL, 0, prvLCDSetUp, NULL, 1 },
+	#endif
+	{ "LCD text per char",		prvLCDTextCharIteration,	NULL, 0, prvLCDSetUp, NULL, 0 },
+	{ "LCD text line polled",	prvLCDTextLineIteration,	NULL, 0, prvLCDSetUp, NULL, 0 },
+	#if ( LCD_USE_DMA == 1 )
+		{ "LCD text line DMA",	prvLCDTextLineIteration,	NULL, 0, prvLCDSetUp, NULL, 1 },
+	#endif
+};
+
+#define benchLCD_CASES			( sizeof( xLCDCases ) / sizeof( xLCDCases[ 0 ] ) )
+
+static BenchHistogram_t xLCDHistograms[ benchLCD_CASES ];
+
+static BenchSuite_t xLCDSuite = { xLCDCases, xLCDHistograms, ( UBaseType_t ) benchLCD_CASES, pdFALSE, NULL };
+
+/*-----------------------------------------------------------*/
+
+void vStartLCDBenchmarks( UBaseType_t uxPriority )
+{
+	vStartBenchmarkSuite( &xLCDSuite, uxPriority );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvLCDSetUp( uint32_t ulUseDMA )
+{
+static BaseType_t xInitialised = pdFALSE;
+
+	if( xInitialised == pdFALSE )
+	{
+		LCD_Init();
+		xInitialised = pdTRUE;
+	}
+
+	LCD_DMACmd( ( ulUseDMA != 0UL ) ? ENABLE : DISABLE );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvLCDClearPixelIteration( void )
+{
+uint32_t ulStart = benchGET_CYCLE_COUNT();
+uint32_t ulPixel;
+
+	LCD_SetCursor( 0x00, 0x013F );
+
+	for( ulPixel = 0; ulPixel < benchLCD_PIXELS; ulPixel++ )
+	{
+		LCD_WriteRAM( White );
+	}
+
+	return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvLCDClearFillIteration( void )
+{
+uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+	LCD_SetCursor( 0x00, 0x013F );
+	LCD_FillRAM( White, benchLCD_PIXELS );
+
+	return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvLCDTextCharIteration( void )
+{
+static const char cText[] = benchLCD_TEXT;
+uint32_t ulStart = benchGET_CYCLE_COUNT();
+uint32_t ulChar;
+
+	for( ulChar = 0; ulChar < ( sizeof( cText ) - 1 ); ulChar++ )
+	{
+		LCD_DrawChar( Line0, ( u16 ) ( 319 - ( ulChar * 16 ) ), &ASCII_Table[ ( cText[ ulChar ] - 32 ) * 24 ] );
+	}
+
+	return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvLCDTextLineIteration( void )
+{
+uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+	LCD_DisplayStringLine( Line0, ( u8 * ) benchLCD_TEXT );
+
+	return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,33 @@
+#ifndef LCD_BENCH_H
+#define LCD_BENCH_H
+
+#include "FreeRTOS.h"
+
+/*
+ * LCD drawing benchmarks, run and reported as a suite of the benchmarks of
+ * KernelBench.h.
+ *
+ * The time taken to clear the whole LCD is measured, once with one
+ * LCD_WriteRAM() per pixel, as LCD_Clear() used to, and once with
+ * LCD_FillRAM(), polled and, when LCD_USE_DMA is 1, with the DMA.  The time
+ * taken to draw a line of 20 characters is measured in the same ways, once
+ * with one LCD_DrawChar() per character, as LCD_DisplayStringLine() used to,
+ * and once with LCD_DisplayStringLine(), so the characters per second are
+ * 20 * configCPU_CLOCK_HZ divided by the cycles taken.  Each clear iteration
+ * writes 76800 pixels, so benchITERATIONS should be lowered when these
+ * benchmarks are run.
+ */
+
+/* Set to 1 for main.c to run the LCD benchmarks with the kernel
+benchmarks. */
+#ifndef benchLCD
+	#define benchLCD				0
+#endif
+
+/*
+ * Starts the LCD benchmarks, which run once every suite of benchmarks started
+ * before them has been reported.
+ */
+void vStartLCDBenchmarks( UBaseType_t uxPriority );
+
+#endif /* LCD_BENCH_H */
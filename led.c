@@ -8,9 +8,8 @@
 
 static bool isInit = false;
 static void ledTask(void *param);
-static GPIO_TypeDef* ledPorts[] = {
-    LED_GPIO_GREEN_PORT
-};
+// Set by ledInit(), as with DEBUG the ST library's GPIOC is a variable.
+static GPIO_TypeDef* ledPorts[LED_NUM];
 
 static unsigned int ledPins[] = {
     LED_GPIO_GREEN
@@ -59,6 +58,8 @@ void ledInit(void)
         return;
     }
 
+    ledPorts[LED_GREEN] = LED_GPIO_GREEN_PORT;
+
     RCC_APB2PeriphClockCmd(LED_GPIO_PERIF, ENABLE );
     for(i = 0; i < LED_NUM; i++) // DO MAKE SURE LED_NUM is legal
     {
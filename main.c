@@ -4,9 +4,42 @@
 // #include "stm32f10x_gpio.h"
 // #include <stdbool.h>
 #include "stm32f10x_conf.h"
+#include "stm32f10x_lib.h"
 // #include "FreeRTOS.h"
 #include "led.h"
 #include "task.h"
+#include "serial.h"
+#include "KernelBench.h"
+#include "spi_flash_bench.h"
+#include "lcd_bench.h"
+#include "dsp_bench.h"
+#include "dma_service.h"
+
+/* Set to 1 to run the kernel micro-benchmarks and print CSV results on USART1.
+   The driver and DSP benchmarks selected by benchSPI_FLASH, benchLCD and
+   benchDSP run after them. */
+#ifndef mainRUN_KERNEL_BENCHMARK
+#define mainRUN_KERNEL_BENCHMARK        0
+#endif
+/* Set to 1 to end the scheduler once the benchmarks are reported, so that a
+   host build exits with the results. */
+#ifndef mainEND_AFTER_BENCHMARK
+#define mainEND_AFTER_BENCHMARK         0
+#endif
+/* Set to 1 to start the high frequency timer test of timertest.c, which
+   measures the jitter of the TIM2 interrupt, and write its histogram as a CSV
+   line on USART1 each time the green LED is lit. On the host build the
+   timers never count, so the histogram stays empty. */
+#ifndef mainRUN_TIMER_TEST
+#define mainRUN_TIMER_TEST              0
+#endif
+#define mainBENCHMARK_BAUD_RATE         115200
+#define mainBENCHMARK_SERIAL_QUEUE_LEN  256
+#define mainBENCHMARK_PRIORITY          ( tskIDLE_PRIORITY + 2 )
+
+/* In timertest.c. */
+extern void vSetupTimerTest(void);
+extern void vTimerTestReportJitter(void);
 
 bool isInit = false;
 void systemInit()
@@ -24,9 +57,16 @@ void systemTask(void *param) {
 
   while (1) {
     ledSetGreen(1);
+#if mainRUN_TIMER_TEST
+    vTimerTestReportJitter();
+#endif
     vTaskDelay(M2T(1000));
     ledSetGreen(0);
     vTaskDelay(M2T(1000));
+#if mainRUN_KERNEL_BENCHMARK && mainEND_AFTER_BENCHMARK
+    if (xAreBenchmarksComplete() == pdTRUE)
+      vTaskEndScheduler();
+#endif
   }
 
   // Should never reach this point!
@@ -37,9 +77,34 @@ void systemTask(void *param) {
 void systemLaunch() {
   xTaskCreate(systemTask, "SYSTEM", configMINIMAL_STACK_SIZE << 1, NULL,
               configMAX_PRIORITIES - 1, NULL);
+
+#if mainRUN_KERNEL_BENCHMARK || mainRUN_TIMER_TEST
+  xSerialPortInitMinimal(mainBENCHMARK_BAUD_RATE, mainBENCHMARK_SERIAL_QUEUE_LEN);
+#endif
+#if mainRUN_TIMER_TEST
+  vSetupTimerTest();
+#endif
+#if mainRUN_KERNEL_BENCHMARK
+  vStartKernelBenchmarkTask(mainBENCHMARK_PRIORITY);
+#if benchSPI_FLASH
+  vStartSPIFlashBenchmarks(mainBENCHMARK_PRIORITY);
+#endif
+#if benchLCD
+  vStartLCDBenchmarks(mainBENCHMARK_PRIORITY);
+#endif
+#if benchDSP
+  vStartDSPBenchmarks(mainBENCHMARK_PRIORITY);
+#endif
+#endif
 }
 
 int main() {
+#ifdef DEBUG
+  // The ST library reaches each peripheral through a pointer set up here.
+  debug();
+#endif
+  // Before any driver opens a DMA channel, as adc_sample.c does.
+  vDMAServiceInit(&xDMAServiceSTM32Hardware);
   systemLaunch();
   vTaskStartScheduler();
 }
@@ -1,5 +1,5 @@
 /*
- * FreeRTOS V202112.00
+ * FreeRTOS Kernel V10.4.3 LTS Patch 2
  * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy of
@@ -25,36 +25,331 @@
  */
 
 /*
-	BASIC INTERRUPT DRIVEN SERIAL PORT DRIVER FOR UART0.
+	SERIAL PORT DRIVER FOR USART1, USART2 AND USART3.
+
+	Each port is described by a constant xSerialHardware structure, naming its
+	USART, pins, clocks and DMA channels, and has its own xSerialPort control
+	block holding its buffers, DMA state and error counters.  All the driver
+	code is shared - the interrupt handlers of each port only pass its control
+	block to the common handler - so each extra port costs only its control
+	block and buffers.  Ports do not share any state, so activity on one never
+	waits for another.
+
+	USART1 (PA9/PA10) is always included, as it is the port opened by
+	xSerialPortInitMinimal() and used when a NULL port handle is passed.
+	USART2 (PA2/PA3) and USART3 (PB10/PB11) are included when serUSE_USART2 and
+	serUSE_USART3 are 1.
+
+	When serUSE_DMA is 1 (the default) the driver moves data with the DMA
+	controller rather than one interrupt and one queue operation per character:
+
+	+ Received bytes are written by the receive DMA channel of the port into
+	  ucRxDMABuffer, which it treats as a circular buffer.  The half transfer
+	  and transfer complete interrupts of the channel, and the USART idle line
+	  interrupt, copy whatever has arrived since the last of them into
+	  xRxStreamBuffer, from which tasks read.  The idle line interrupt means the
+	  end of a message is handed to the tasks one character time after it
+	  arrives, however short the message.
+
+	+ Characters to transmit are written to xTxStreamBuffer.  Whenever the
+	  transmit DMA channel is idle the driver moves as much as fits of the
+	  stream buffer into ucTxDMABuffer and sends it as one block, so a whole
+	  string costs one interrupt rather than one per character.
+
+	Tasks can move whole blocks with xSerialWrite() and xSerialRead().  A writer
+	blocked on a full transmit buffer is unblocked once per DMA block, and a
+	reader is unblocked once the receive trigger level set by
+	xSerialSetRxTriggerLevel() is reached, rather than once per character.
+
+	A stream buffer can only have one writer at a time, and several tasks write
+	to USART1, so each port has a mutex that a task holds while it writes.  It
+	also keeps each block that is written in one piece, rather than mixed with
+	the bytes of another writer when the block does not fit in the buffer.
+
+	Setting serUSE_DMA to 0 selects the original driver, which passes each
+	character through a queue from the USART interrupt.
 */
 
 /* Scheduler includes. */
 #include "FreeRTOS.h"
 #include "queue.h"
 #include "semphr.h"
+#include "stream_buffer.h"
 
 /* Library includes. */
 #include "stm32f10x_lib.h"
 
 /* Demo application includes. */
 #include "serial.h"
+#include "dma_service.h"
+
+/* For LCD_USE_DMA and SPI_FLASH_USE_RTOS, which select the drivers that also
+define DMA channel interrupt handlers. */
+#include "lcd.h"
+#include "spi_flash.h"
 /*-----------------------------------------------------------*/
 
+/* Set to 0 to use the interrupt per character driver. */
+#ifndef serUSE_DMA
+	#define serUSE_DMA					1
+#endif
+
+/* Set to 1 to include the port.  In DMA mode USART3 uses DMA channels 2 and 3,
+which are also the channels the SPI FLASH driver (spi_flash.c) uses for SPI1. */
+#ifndef serUSE_USART2
+	#define serUSE_USART2				1
+#endif
+
+#ifndef serUSE_USART3
+	#define serUSE_USART3				0
+#endif
+
+/* In DMA mode the driver defines the interrupt handlers of the DMA channels of
+its ports - 4 and 5 for USART1, 6 and 7 for USART2, and 2 and 3 for USART3 - so
+no other driver can use those channels. */
+#if serUSE_DMA == 1
+
+	#if LCD_USE_DMA == 1
+		#error lcd.c uses DMA channel 5, which serves the USART1 receiver.  Set serUSE_DMA or LCD_USE_DMA to 0.
+	#endif
+
+	#if ( serUSE_USART3 == 1 ) && ( SPI_FLASH_USE_RTOS == 1 )
+		#error spi_flash.c uses DMA channels 2 and 3, which serve USART3.  Set serUSE_USART3 or SPI_FLASH_USE_RTOS to 0.
+	#endif
+
+	#if ( dmaserviceUSE_STM32 == 1 ) && ( ( dmaserviceCHANNELS & ( ( 1UL << 4 ) | ( 1UL << 5 ) ) ) != 0 )
+		#error dma_service.c cannot own DMA channels 4 and 5, which serve USART1.  Remove them from dmaserviceCHANNELS.
+	#endif
+
+	#if ( serUSE_USART2 == 1 ) && ( dmaserviceUSE_STM32 == 1 ) && ( ( dmaserviceCHANNELS & ( ( 1UL << 6 ) | ( 1UL << 7 ) ) ) != 0 )
+		#error dma_service.c cannot own DMA channels 6 and 7, which serve USART2.  Remove them from dmaserviceCHANNELS or set serUSE_USART2 to 0.
+	#endif
+
+	#if ( serUSE_USART3 == 1 ) && ( dmaserviceUSE_STM32 == 1 ) && ( ( dmaserviceCHANNELS & ( ( 1UL << 2 ) | ( 1UL << 3 ) ) ) != 0 )
+		#error dma_service.c cannot own DMA channels 2 and 3, which serve USART3.  Remove them from dmaserviceCHANNELS or set serUSE_USART3 to 0.
+	#endif
+
+#endif /* serUSE_DMA */
+
 /* Misc defines. */
 #define serINVALID_QUEUE				( ( QueueHandle_t ) 0 )
 #define serNO_BLOCK						( ( TickType_t ) 0 )
 #define serTX_BLOCK_TIME				( 40 / portTICK_PERIOD_MS )
 
+#if serUSE_DMA == 1
+
+	/* The size of the circular buffer written by the receive DMA channel of
+	each port.  The half and full interrupts mean the buffer is emptied twice
+	per lap, so it must hold the characters that can arrive while a task holds
+	interrupts masked - 32 bytes is about 350us at 921600 baud. */
+	#ifndef serRX_DMA_BUFFER_SIZE
+		#define serRX_DMA_BUFFER_SIZE	64
+	#endif
+
+	/* The largest block sent by one transmit DMA transfer. */
+	#ifndef serTX_DMA_BUFFER_SIZE
+		#define serTX_DMA_BUFFER_SIZE	64
+	#endif
+
+#endif /* serUSE_DMA */
+
 /*-----------------------------------------------------------*/
 
-/* The queue used to hold received characters. */
-static QueueHandle_t xRxedChars;
-static QueueHandle_t xCharsForTx;
+/* The hardware used by one port.  The peripherals are named by their base
+addresses so the structures can be constant. */
+typedef struct xSERIAL_HARDWARE
+{
+	USART_TypeDef *pxUSART;
+	GPIO_TypeDef *pxGPIO;
+	u16 usTxPin;
+	u16 usRxPin;
+	u32 ulAPB1Clocks;					/* The APB1 clocks to enable, or 0. */
+	u32 ulAPB2Clocks;					/* The APB2 clocks to enable. */
+	u8 ucIRQChannel;
+
+	#if serUSE_DMA == 1
+		DMA_Channel_TypeDef *pxTxDMAChannel;
+		DMA_Channel_TypeDef *pxRxDMAChannel;
+		u8 ucTxDMAIRQChannel;
+		u8 ucRxDMAIRQChannel;
+		u32 ulTxDMAITTC;
+		u32 ulTxDMAITGL;
+		u32 ulRxDMAITHT;
+		u32 ulRxDMAITTC;
+		u32 ulRxDMAITGL;
+	#endif
+} xSerialHardware;
+
+/* The state of one port.  The port handles returned by the driver point to
+these structures. */
+typedef struct xSERIAL_PORT
+{
+	const xSerialHardware * const pxHardware;
+
+	#if serUSE_DMA == 1
+		/* The stream buffers through which tasks receive and transmit. */
+		StreamBufferHandle_t xRxStreamBuffer;
+		StreamBufferHandle_t xTxStreamBuffer;
+
+		/* The index into ucRxDMABuffer of the first byte not yet passed to
+		xRxStreamBuffer. */
+		size_t xRxDMAReadIndex;
+
+		/* pdTRUE while the transmit DMA channel is sending ucTxDMABuffer. */
+		volatile portBASE_TYPE xTxDMABusy;
+
+		/* The memory accessed by the DMA channels. */
+		unsigned char ucRxDMABuffer[ serRX_DMA_BUFFER_SIZE ];
+		unsigned char ucTxDMABuffer[ serTX_DMA_BUFFER_SIZE ];
+	#else
+		/* The queues used to hold received characters and characters to
+		transmit. */
+		QueueHandle_t xRxedChars;
+		QueueHandle_t xCharsForTx;
+	#endif
+
+	/* Held by the task writing to the port. */
+	SemaphoreHandle_t xTxMutex;
+
+	/* The error counters.  Updated by the interrupts, so only read with them
+	masked. */
+	SerialStats_t xStats;
+} xSerialPort;
 
 /*-----------------------------------------------------------*/
 
-/* UART interrupt handler. */
+static const xSerialHardware xUSART1Hardware =
+{
+	( USART_TypeDef * ) USART1_BASE, ( GPIO_TypeDef * ) GPIOA_BASE, GPIO_Pin_9, GPIO_Pin_10,
+	0, RCC_APB2Periph_USART1 | RCC_APB2Periph_GPIOA, USART1_IRQChannel,
+
+	#if serUSE_DMA == 1
+		( DMA_Channel_TypeDef * ) DMA_Channel4_BASE, ( DMA_Channel_TypeDef * ) DMA_Channel5_BASE,
+		DMAChannel4_IRQChannel, DMAChannel5_IRQChannel,
+		DMA_IT_TC4, DMA_IT_GL4, DMA_IT_HT5, DMA_IT_TC5, DMA_IT_GL5
+	#endif
+};
+
+static xSerialPort xUSART1Port = { &xUSART1Hardware };
+
+#if serUSE_USART2 == 1
+
+	static const xSerialHardware xUSART2Hardware =
+	{
+		( USART_TypeDef * ) USART2_BASE, ( GPIO_TypeDef * ) GPIOA_BASE, GPIO_Pin_2, GPIO_Pin_3,
+		RCC_APB1Periph_USART2, RCC_APB2Periph_GPIOA, USART2_IRQChannel,
+
+		#if serUSE_DMA == 1
+			( DMA_Channel_TypeDef * ) DMA_Channel7_BASE, ( DMA_Channel_TypeDef * ) DMA_Channel6_BASE,
+			DMAChannel7_IRQChannel, DMAChannel6_IRQChannel,
+			DMA_IT_TC7, DMA_IT_GL7, DMA_IT_HT6, DMA_IT_TC6, DMA_IT_GL6
+		#endif
+	};
+
+	static xSerialPort xUSART2Port = { &xUSART2Hardware };
+
+#endif /* serUSE_USART2 */
+
+#if serUSE_USART3 == 1
+
+	static const xSerialHardware xUSART3Hardware =
+	{
+		( USART_TypeDef * ) USART3_BASE, ( GPIO_TypeDef * ) GPIOB_BASE, GPIO_Pin_10, GPIO_Pin_11,
+		RCC_APB1Periph_USART3, RCC_APB2Periph_GPIOB, USART3_IRQChannel,
+
+		#if serUSE_DMA == 1
+			( DMA_Channel_TypeDef * ) DMA_Channel2_BASE, ( DMA_Channel_TypeDef * ) DMA_Channel3_BASE,
+			DMAChannel2_IRQChannel, DMAChannel3_IRQChannel,
+			DMA_IT_TC2, DMA_IT_GL2, DMA_IT_HT3, DMA_IT_TC3, DMA_IT_GL3
+		#endif
+	};
+
+	static xSerialPort xUSART3Port = { &xUSART3Hardware };
+
+#endif /* serUSE_USART3 */
+
+/* The baud rates of the eBaud values. */
+static const unsigned long ulBaudRates[] =
+{
+	50UL, 75UL, 110UL, 134UL, 150UL, 200UL, 300UL, 600UL, 1200UL, 1800UL,
+	2400UL, 4800UL, 9600UL, 19200UL, 38400UL, 57600UL, 115200UL
+};
+
+/*-----------------------------------------------------------*/
+
+/* Interrupt handlers, named as in the vector table.  Each passes the control
+block of its port to the common handler. */
 void vUARTInterruptHandler( void );
+void USART2_IRQHandler( void );
+void USART3_IRQHandler( void );
+
+#if serUSE_DMA == 1
+	void DMAChannel2_IRQHandler( void );
+	void DMAChannel3_IRQHandler( void );
+	void DMAChannel4_IRQHandler( void );
+	void DMAChannel5_IRQHandler( void );
+	void DMAChannel6_IRQHandler( void );
+	void DMAChannel7_IRQHandler( void );
+#endif
+
+/*
+ * Map a port handle onto its control block.  NULL selects USART1.
+ */
+static xSerialPort *prvGetPort( xComPortHandle xPort );
+
+/*
+ * Map a port number onto its control block, or NULL if the port is not
+ * included.
+ */
+static xSerialPort *prvGetPortFromNumber( eCOMPort ePort );
+
+/*
+ * Configure the hardware of a port and create its buffers.
+ */
+static xComPortHandle prvPortOpen( xSerialPort *pxPort, unsigned long ulWantedBaud, u16 usWordLength, u16 usParity, u16 usStopBits, unsigned portBASE_TYPE uxBufferLength );
+
+/*
+ * The interrupt handler shared by all the USARTs.
+ */
+static void prvUSARTHandler( xSerialPort *pxPort );
+
+#if serUSE_DMA == 1
+
+	/*
+	 * Configure the two DMA channels of a port and their interrupts.
+	 */
+	static void prvSetupDMA( xSerialPort *pxPort );
+
+	/*
+	 * Pass the bytes written into ucRxDMABuffer since the last call, up to the
+	 * index xWriteIndex, to xRxStreamBuffer.  The DMA position is a parameter
+	 * so the function depends on nothing but the buffers.
+	 */
+	static portBASE_TYPE prvRxDMAProcess( xSerialPort *pxPort, size_t xWriteIndex );
+
+	/*
+	 * The position the receive DMA channel of a port will write to next.
+	 */
+	static size_t prvRxDMAWriteIndex( const xSerialPort *pxPort );
+
+	/*
+	 * Start a transmit DMA transfer of the data waiting in xTxStreamBuffer if
+	 * the channel is idle.  Must be called with interrupts masked.
+	 */
+	static portBASE_TYPE prvTxDMAStart( xSerialPort *pxPort );
+
+	/*
+	 * Start a transmit DMA transfer, if there is not one already, from a task.
+	 */
+	static void prvTxKick( xSerialPort *pxPort );
+
+	/*
+	 * The DMA interrupt handlers shared by all the ports.
+	 */
+	static void prvTxDMAHandler( xSerialPort *pxPort );
+	static void prvRxDMAHandler( xSerialPort *pxPort );
+
+#endif /* serUSE_DMA */
 
 /*-----------------------------------------------------------*/
 
@@ -63,37 +358,190 @@ void vUARTInterruptHandler( void );
  */
 xComPortHandle xSerialPortInitMinimal( unsigned long ulWantedBaud, unsigned portBASE_TYPE uxQueueLength )
 {
+	return prvPortOpen( &xUSART1Port, ulWantedBaud, USART_WordLength_8b, USART_Parity_No, USART_StopBits_1, uxQueueLength );
+}
+/*-----------------------------------------------------------*/
+
+xComPortHandle xSerialPortInit( eCOMPort ePort, eBaud eWantedBaud, eParity eWantedParity, eDataBits eWantedDataBits, eStopBits eWantedStopBits, unsigned portBASE_TYPE uxBufferLength )
+{
+xSerialPort * const pxPort = prvGetPortFromNumber( ePort );
+xComPortHandle xReturn = ( xComPortHandle ) 0;
+u16 usWordLength, usParity, usStopBits;
+
+	/* The USART word length includes the parity bit, so supports 8 data bits
+	without parity, and 7 or 8 with even or odd parity. */
+	if( eWantedParity == serNO_PARITY )
+	{
+		usParity = USART_Parity_No;
+		usWordLength = ( eWantedDataBits == serBITS_8 ) ? USART_WordLength_8b : 0;
+	}
+	else if( ( eWantedParity == serEVEN_PARITY ) || ( eWantedParity == serODD_PARITY ) )
+	{
+		usParity = ( eWantedParity == serEVEN_PARITY ) ? USART_Parity_Even : USART_Parity_Odd;
+
+		if( eWantedDataBits == serBITS_7 )
+		{
+			usWordLength = USART_WordLength_8b;
+		}
+		else if( eWantedDataBits == serBITS_8 )
+		{
+			usWordLength = USART_WordLength_9b;
+		}
+		else
+		{
+			usWordLength = 0;
+		}
+	}
+	else
+	{
+		usParity = 0;
+		usWordLength = 0;
+	}
+
+	usStopBits = ( eWantedStopBits == serSTOP_2 ) ? USART_StopBits_2 : USART_StopBits_1;
+
+	if( ( pxPort != NULL ) && ( usWordLength != 0 ) && ( ( unsigned long ) eWantedBaud < ( sizeof( ulBaudRates ) / sizeof( ulBaudRates[ 0 ] ) ) ) )
+	{
+		xReturn = prvPortOpen( pxPort, ulBaudRates[ eWantedBaud ], usWordLength, usParity, usStopBits, uxBufferLength );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+xComPortHandle xSerialPortInitBaud( eCOMPort ePort, unsigned long ulWantedBaud, unsigned portBASE_TYPE uxBufferLength )
+{
+xSerialPort * const pxPort = prvGetPortFromNumber( ePort );
+
+	if( pxPort != NULL )
+	{
+		return prvPortOpen( pxPort, ulWantedBaud, USART_WordLength_8b, USART_Parity_No, USART_StopBits_1, uxBufferLength );
+	}
+	else
+	{
+		return ( xComPortHandle ) 0;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static xSerialPort *prvGetPortFromNumber( eCOMPort ePort )
+{
+xSerialPort *pxPort;
+
+	switch( ePort )
+	{
+		case serCOM1 :	pxPort = &xUSART1Port;
+						break;
+
+		#if serUSE_USART2 == 1
+			case serCOM2 :	pxPort = &xUSART2Port;
+							break;
+		#endif
+
+		#if serUSE_USART3 == 1
+			case serCOM3 :	pxPort = &xUSART3Port;
+							break;
+		#endif
+
+		default :		pxPort = NULL;
+						break;
+	}
+
+	return pxPort;
+}
+/*-----------------------------------------------------------*/
+
+static xSerialPort *prvGetPort( xComPortHandle xPort )
+{
+	if( xPort == NULL )
+	{
+		return &xUSART1Port;
+	}
+	else
+	{
+		return ( xSerialPort * ) xPort;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static xComPortHandle prvPortOpen( xSerialPort *pxPort, unsigned long ulWantedBaud, u16 usWordLength, u16 usParity, u16 usStopBits, unsigned portBASE_TYPE uxBufferLength )
+{
+const xSerialHardware * const pxHardware = pxPort->pxHardware;
 xComPortHandle xReturn;
 USART_InitTypeDef USART_InitStructure;
 NVIC_InitTypeDef NVIC_InitStructure;
 GPIO_InitTypeDef GPIO_InitStructure;
+portBASE_TYPE xBuffersCreated;
+
+	/* The buffers are created the first time the port is opened, and kept if
+	it is opened again with a new format. */
+	#if serUSE_DMA == 1
+	{
+		/* A task reading one character at a time is unblocked by each one. */
+		if( pxPort->xRxStreamBuffer == NULL )
+		{
+			pxPort->xRxStreamBuffer = xStreamBufferCreate( ( size_t ) uxBufferLength, 1 );
+		}
+
+		if( pxPort->xTxStreamBuffer == NULL )
+		{
+			pxPort->xTxStreamBuffer = xStreamBufferCreate( ( size_t ) uxBufferLength, 1 );
+		}
+
+		xBuffersCreated = ( ( pxPort->xRxStreamBuffer != NULL ) && ( pxPort->xTxStreamBuffer != NULL ) );
+	}
+	#else
+	{
+		if( pxPort->xRxedChars == serINVALID_QUEUE )
+		{
+			pxPort->xRxedChars = xQueueCreate( uxBufferLength, ( unsigned portBASE_TYPE ) sizeof( signed char ) );
+		}
 
-	/* Create the queues used to hold Rx/Tx characters. */
-	xRxedChars = xQueueCreate( uxQueueLength, ( unsigned portBASE_TYPE ) sizeof( signed char ) );
-	xCharsForTx = xQueueCreate( uxQueueLength + 1, ( unsigned portBASE_TYPE ) sizeof( signed char ) );
+		if( pxPort->xCharsForTx == serINVALID_QUEUE )
+		{
+			pxPort->xCharsForTx = xQueueCreate( uxBufferLength + 1, ( unsigned portBASE_TYPE ) sizeof( signed char ) );
+		}
+
+		xBuffersCreated = ( ( pxPort->xRxedChars != serINVALID_QUEUE ) && ( pxPort->xCharsForTx != serINVALID_QUEUE ) );
+	}
+	#endif
+
+	if( pxPort->xTxMutex == NULL )
+	{
+		pxPort->xTxMutex = xSemaphoreCreateMutex();
+	}
+
+	xBuffersCreated = ( xBuffersCreated && ( pxPort->xTxMutex != NULL ) );
 	
 	/* If the queue/semaphore was created correctly then setup the serial port
 	hardware. */
-	if( ( xRxedChars != serINVALID_QUEUE ) && ( xCharsForTx != serINVALID_QUEUE ) )
+	if( xBuffersCreated )
 	{
-		/* Enable USART1 clock */
-		RCC_APB2PeriphClockCmd( RCC_APB2Periph_USART1 | RCC_APB2Periph_GPIOA, ENABLE );	
+		/* Enable the USART and GPIO clocks. */
+		if( pxHardware->ulAPB1Clocks != 0 )
+		{
+			RCC_APB1PeriphClockCmd( pxHardware->ulAPB1Clocks, ENABLE );
+		}
+
+		RCC_APB2PeriphClockCmd( pxHardware->ulAPB2Clocks, ENABLE );	
 
-		/* Configure USART1 Rx (PA10) as input floating */
-		GPIO_InitStructure.GPIO_Pin = GPIO_Pin_10;
+		/* Configure Rx as input floating */
+		GPIO_InitStructure.GPIO_Pin = pxHardware->usRxPin;
 		GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
-		GPIO_Init( GPIOA, &GPIO_InitStructure );
+		GPIO_Init( pxHardware->pxGPIO, &GPIO_InitStructure );
 		
-		/* Configure USART1 Tx (PA9) as alternate function push-pull */
-		GPIO_InitStructure.GPIO_Pin = GPIO_Pin_9;
+		/* Configure Tx as alternate function push-pull */
+		GPIO_InitStructure.GPIO_Pin = pxHardware->usTxPin;
 		GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
 		GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
-		GPIO_Init( GPIOA, &GPIO_InitStructure );
+		GPIO_Init( pxHardware->pxGPIO, &GPIO_InitStructure );
+
+		USART_Cmd( pxHardware->pxUSART, DISABLE );
 
 		USART_InitStructure.USART_BaudRate = ulWantedBaud;
-		USART_InitStructure.USART_WordLength = USART_WordLength_8b;
-		USART_InitStructure.USART_StopBits = USART_StopBits_1;
-		USART_InitStructure.USART_Parity = USART_Parity_No ;
+		USART_InitStructure.USART_WordLength = usWordLength;
+		USART_InitStructure.USART_StopBits = usStopBits;
+		USART_InitStructure.USART_Parity = usParity;
 		USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
 		USART_InitStructure.USART_Mode = USART_Mode_Rx | USART_Mode_Tx;
 		USART_InitStructure.USART_Clock = USART_Clock_Disable;
@@ -101,84 +549,265 @@ GPIO_InitTypeDef GPIO_InitStructure;
 		USART_InitStructure.USART_CPHA = USART_CPHA_2Edge;
 		USART_InitStructure.USART_LastBit = USART_LastBit_Disable;
 		
-		USART_Init( USART1, &USART_InitStructure );
-		
-		USART_ITConfig( USART1, USART_IT_RXNE, ENABLE );
+		USART_Init( pxHardware->pxUSART, &USART_InitStructure );
+
+		#if serUSE_DMA == 1
+		{
+			prvSetupDMA( pxPort );
+
+			/* The USART interrupt is only used to detect the idle line that
+			follows a message, and overrun errors. */
+			USART_DMACmd( pxHardware->pxUSART, USART_DMAReq_Rx | USART_DMAReq_Tx, ENABLE );
+			USART_ITConfig( pxHardware->pxUSART, USART_IT_IDLE, ENABLE );
+			USART_ITConfig( pxHardware->pxUSART, USART_IT_ERR, ENABLE );
+		}
+		#else
+		{
+			USART_ITConfig( pxHardware->pxUSART, USART_IT_RXNE, ENABLE );
+		}
+		#endif
 		
-		NVIC_InitStructure.NVIC_IRQChannel = USART1_IRQChannel;
+		NVIC_InitStructure.NVIC_IRQChannel = pxHardware->ucIRQChannel;
 		NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = configLIBRARY_KERNEL_INTERRUPT_PRIORITY;
 		NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
 		NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
 		NVIC_Init( &NVIC_InitStructure );
 		
-		USART_Cmd( USART1, ENABLE );		
+		USART_Cmd( pxHardware->pxUSART, ENABLE );		
+
+		xReturn = ( xComPortHandle ) pxPort;
 	}
 	else
 	{
 		xReturn = ( xComPortHandle ) 0;
 	}
 
-	/* This demo file only supports a single port but we have to return
-	something to comply with the standard demo header file. */
 	return xReturn;
 }
 /*-----------------------------------------------------------*/
 
 signed portBASE_TYPE xSerialGetChar( xComPortHandle pxPort, signed char *pcRxedChar, TickType_t xBlockTime )
 {
-	/* The port handle is not required as this driver only supports one port. */
-	( void ) pxPort;
+xSerialPort * const pxSerialPort = prvGetPort( pxPort );
 
 	/* Get the next character from the buffer.  Return false if no characters
 	are available, or arrive before xBlockTime expires. */
-	if( xQueueReceive( xRxedChars, pcRxedChar, xBlockTime ) )
+	#if serUSE_DMA == 1
 	{
-		return pdTRUE;
+		if( xStreamBufferReceive( pxSerialPort->xRxStreamBuffer, pcRxedChar, sizeof( signed char ), xBlockTime ) == sizeof( signed char ) )
+		{
+			return pdTRUE;
+		}
+		else
+		{
+			return pdFALSE;
+		}
 	}
-	else
+	#else
 	{
-		return pdFALSE;
+		if( xQueueReceive( pxSerialPort->xRxedChars, pcRxedChar, xBlockTime ) )
+		{
+			return pdTRUE;
+		}
+		else
+		{
+			return pdFALSE;
+		}
 	}
+	#endif
 }
 /*-----------------------------------------------------------*/
 
 void vSerialPutString( xComPortHandle pxPort, const signed char * const pcString, unsigned short usStringLength )
 {
-signed char *pxNext;
+xSerialPort * const pxSerialPort = prvGetPort( pxPort );
+const signed char *pxNext;
+size_t xLength, xWritten;
 
-	/* A couple of parameters that this port does not use. */
+	/* A parameter that this port does not use. */
 	( void ) usStringLength;
-	( void ) pxPort;
-
-	/* NOTE: This implementation does not handle the queue being full as no
-	block time is used! */
-
-	/* The port handle is not required as this driver only supports UART1. */
-	( void ) pxPort;
 
-	/* Send each character in the string, one at a time. */
-	pxNext = ( signed char * ) pcString;
+	/* NOTE: This implementation does not block, so drops whatever does not fit
+	in the transmit buffer, or all of the string if another task is writing to
+	the port.  The dropped bytes are counted in ulTxDroppedBytes.  Use
+	xSerialWrite() to block until there is space. */
+	pxNext = pcString;
 	while( *pxNext )
 	{
-		xSerialPutChar( pxPort, *pxNext, serNO_BLOCK );
 		pxNext++;
 	}
+
+	xLength = ( size_t ) ( pxNext - pcString );
+	xWritten = xSerialWrite( pxPort, pcString, xLength, serNO_BLOCK );
+
+	if( xWritten < xLength )
+	{
+		portENTER_CRITICAL();
+		{
+			pxSerialPort->xStats.ulTxDroppedBytes += ( uint32_t ) ( xLength - xWritten );
+		}
+		portEXIT_CRITICAL();
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xSerialWrite( xComPortHandle pxPort, const void *pvBuffer, size_t xLength, TickType_t xBlockTime )
+{
+xSerialPort * const pxSerialPort = prvGetPort( pxPort );
+const signed char *pcNext = ( const signed char * ) pvBuffer;
+size_t xWritten = 0, xSent;
+TimeOut_t xTimeOut;
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	/* Wait for any other writer to finish, within the same block time. */
+	if( xSemaphoreTake( pxSerialPort->xTxMutex, xBlockTime ) != pdPASS )
+	{
+		return 0;
+	}
+
+	( void ) xTaskCheckForTimeOut( &xTimeOut, &xBlockTime );
+
+	while( xWritten < xLength )
+	{
+		#if serUSE_DMA == 1
+		{
+			/* Write as much as fits, blocking until there is space for all of
+			it, and start a DMA transfer of it if one is not already running.
+			A block larger than the stream buffer is written in parts. */
+			xSent = xStreamBufferSend( pxSerialPort->xTxStreamBuffer, &( pcNext[ xWritten ] ), xLength - xWritten, xBlockTime );
+
+			if( xSent > 0 )
+			{
+				prvTxKick( pxSerialPort );
+			}
+		}
+		#else
+		{
+			if( xSerialPutChar( pxSerialPort, pcNext[ xWritten ], xBlockTime ) == pdPASS )
+			{
+				xSent = 1;
+			}
+			else
+			{
+				xSent = 0;
+			}
+		}
+		#endif
+
+		if( xSent == 0 )
+		{
+			/* The block time expired with the buffer still full. */
+			break;
+		}
+
+		xWritten += xSent;
+
+		/* Work out how much of the block time remains.  Once it has expired
+		xBlockTime is 0, so only what fits without blocking is written. */
+		( void ) xTaskCheckForTimeOut( &xTimeOut, &xBlockTime );
+	}
+
+	xSemaphoreGive( pxSerialPort->xTxMutex );
+
+	return xWritten;
+}
+/*-----------------------------------------------------------*/
+
+size_t xSerialRead( xComPortHandle pxPort, void *pvBuffer, size_t xLength, TickType_t xBlockTime )
+{
+xSerialPort * const pxSerialPort = prvGetPort( pxPort );
+size_t xReceived;
+
+	#if serUSE_DMA == 1
+	{
+		/* The stream buffer only unblocks the task once the trigger level is
+		reached, or the block time expires. */
+		xReceived = xStreamBufferReceive( pxSerialPort->xRxStreamBuffer, pvBuffer, xLength, xBlockTime );
+	}
+	#else
+	{
+	signed char *pcNext = ( signed char * ) pvBuffer;
+
+		/* Wait for the first character, then take any others that have
+		already arrived. */
+		xReceived = 0;
+		while( ( xReceived < xLength ) && ( xQueueReceive( pxSerialPort->xRxedChars, &( pcNext[ xReceived ] ), xBlockTime ) == pdPASS ) )
+		{
+			xReceived++;
+			xBlockTime = serNO_BLOCK;
+		}
+	}
+	#endif
+
+	return xReceived;
+}
+/*-----------------------------------------------------------*/
+
+portBASE_TYPE xSerialSetRxTriggerLevel( xComPortHandle pxPort, size_t xTriggerLevel )
+{
+xSerialPort * const pxSerialPort = prvGetPort( pxPort );
+
+	#if serUSE_DMA == 1
+	{
+		return xStreamBufferSetTriggerLevel( pxSerialPort->xRxStreamBuffer, xTriggerLevel );
+	}
+	#else
+	{
+		/* Each character is queued separately, so the reader is always
+		unblocked by the first. */
+		( void ) pxSerialPort;
+		( void ) xTriggerLevel;
+		return pdFAIL;
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+void vSerialGetStats( xComPortHandle pxPort, SerialStats_t *pxStats )
+{
+xSerialPort * const pxSerialPort = prvGetPort( pxPort );
+
+	portENTER_CRITICAL();
+	{
+		*pxStats = pxSerialPort->xStats;
+	}
+	portEXIT_CRITICAL();
 }
 /*-----------------------------------------------------------*/
 
 signed portBASE_TYPE xSerialPutChar( xComPortHandle pxPort, signed char cOutChar, TickType_t xBlockTime )
 {
+xSerialPort * const pxSerialPort = prvGetPort( pxPort );
 signed portBASE_TYPE xReturn;
 
-	if( xQueueSend( xCharsForTx, &cOutChar, xBlockTime ) == pdPASS )
+	#if serUSE_DMA == 1
 	{
-		xReturn = pdPASS;
-		USART_ITConfig( USART1, USART_IT_TXE, ENABLE );
+		/* Written under the mutex of the port, as any other block. */
+		( void ) pxSerialPort;
+
+		if( xSerialWrite( pxPort, &cOutChar, sizeof( signed char ), xBlockTime ) == sizeof( signed char ) )
+		{
+			xReturn = pdPASS;
+		}
+		else
+		{
+			xReturn = pdFAIL;
+		}
 	}
-	else
+	#else
 	{
-		xReturn = pdFAIL;
+		if( xQueueSend( pxSerialPort->xCharsForTx, &cOutChar, xBlockTime ) == pdPASS )
+		{
+			xReturn = pdPASS;
+			USART_ITConfig( pxSerialPort->pxHardware->pxUSART, USART_IT_TXE, ENABLE );
+		}
+		else
+		{
+			xReturn = pdFAIL;
+		}
 	}
+	#endif
 
 	return xReturn;
 }
@@ -192,36 +821,323 @@ void vSerialClose( xComPortHandle xPort )
 
 void vUARTInterruptHandler( void )
 {
-portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
-char cChar;
+	prvUSARTHandler( &xUSART1Port );
+}
+/*-----------------------------------------------------------*/
+
+#if serUSE_USART2 == 1
+
+	void USART2_IRQHandler( void )
+	{
+		prvUSARTHandler( &xUSART2Port );
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* serUSE_USART2 */
+
+#if serUSE_USART3 == 1
+
+	void USART3_IRQHandler( void )
+	{
+		prvUSARTHandler( &xUSART3Port );
+	}
+	/*-----------------------------------------------------------*/
 
-	if( USART_GetITStatus( USART1, USART_IT_TXE ) == SET )
+#endif /* serUSE_USART3 */
+
+#if serUSE_DMA == 1
+
+	void DMAChannel4_IRQHandler( void )
+	{
+		prvTxDMAHandler( &xUSART1Port );
+	}
+	/*-----------------------------------------------------------*/
+
+	void DMAChannel5_IRQHandler( void )
 	{
-		/* The interrupt was caused by the THR becoming empty.  Are there any
-		more characters to transmit? */
-		if( xQueueReceiveFromISR( xCharsForTx, &cChar, &xHigherPriorityTaskWoken ) == pdTRUE )
+		prvRxDMAHandler( &xUSART1Port );
+	}
+	/*-----------------------------------------------------------*/
+
+	#if serUSE_USART2 == 1
+
+		void DMAChannel7_IRQHandler( void )
 		{
-			/* A character was retrieved from the queue so can be sent to the
-			THR now. */
-			USART_SendData( USART1, cChar );
+			prvTxDMAHandler( &xUSART2Port );
 		}
-		else
+		/*-----------------------------------------------------------*/
+
+		void DMAChannel6_IRQHandler( void )
 		{
-			USART_ITConfig( USART1, USART_IT_TXE, DISABLE );		
-		}		
+			prvRxDMAHandler( &xUSART2Port );
+		}
+		/*-----------------------------------------------------------*/
+
+	#endif /* serUSE_USART2 */
+
+	#if serUSE_USART3 == 1
+
+		void DMAChannel2_IRQHandler( void )
+		{
+			prvTxDMAHandler( &xUSART3Port );
+		}
+		/*-----------------------------------------------------------*/
+
+		void DMAChannel3_IRQHandler( void )
+		{
+			prvRxDMAHandler( &xUSART3Port );
+		}
+		/*-----------------------------------------------------------*/
+
+	#endif /* serUSE_USART3 */
+
+	static void prvSetupDMA( xSerialPort *pxPort )
+	{
+	const xSerialHardware * const pxHardware = pxPort->pxHardware;
+	DMA_InitTypeDef DMA_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+		RCC_AHBPeriphClockCmd( RCC_AHBPeriph_DMA, ENABLE );
+
+		/* Rx - the USART DR into the circular ucRxDMABuffer, forever. */
+		DMA_DeInit( pxHardware->pxRxDMAChannel );
+		DMA_InitStructure.DMA_PeripheralBaseAddr = ( u32 ) &( pxHardware->pxUSART->DR );
+		DMA_InitStructure.DMA_MemoryBaseAddr = ( u32 ) pxPort->ucRxDMABuffer;
+		DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+		DMA_InitStructure.DMA_BufferSize = serRX_DMA_BUFFER_SIZE;
+		DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+		DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+		DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+		DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+		DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+		DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+		DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+		DMA_Init( pxHardware->pxRxDMAChannel, &DMA_InitStructure );
+		DMA_ITConfig( pxHardware->pxRxDMAChannel, DMA_IT_HT | DMA_IT_TC, ENABLE );
+
+		/* Tx - blocks of ucTxDMABuffer into the USART DR.  The length is set,
+		and the channel enabled, for each block. */
+		DMA_DeInit( pxHardware->pxTxDMAChannel );
+		DMA_InitStructure.DMA_MemoryBaseAddr = ( u32 ) pxPort->ucTxDMABuffer;
+		DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+		DMA_InitStructure.DMA_BufferSize = serTX_DMA_BUFFER_SIZE;
+		DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+		DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+		DMA_Init( pxHardware->pxTxDMAChannel, &DMA_InitStructure );
+		DMA_ITConfig( pxHardware->pxTxDMAChannel, DMA_IT_TC, ENABLE );
+
+		/* Both DMA interrupts share the priority of the USART interrupt, so
+		none of the handlers of the port can interrupt another. */
+		NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = configLIBRARY_KERNEL_INTERRUPT_PRIORITY;
+		NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+		NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+		NVIC_InitStructure.NVIC_IRQChannel = pxHardware->ucTxDMAIRQChannel;
+		NVIC_Init( &NVIC_InitStructure );
+		NVIC_InitStructure.NVIC_IRQChannel = pxHardware->ucRxDMAIRQChannel;
+		NVIC_Init( &NVIC_InitStructure );
+
+		pxPort->xRxDMAReadIndex = 0;
+		pxPort->xTxDMABusy = pdFALSE;
+		DMA_Cmd( pxHardware->pxRxDMAChannel, ENABLE );
 	}
-	
-	if( USART_GetITStatus( USART1, USART_IT_RXNE ) == SET )
+	/*-----------------------------------------------------------*/
+
+	static size_t prvRxDMAWriteIndex( const xSerialPort *pxPort )
 	{
-		cChar = USART_ReceiveData( USART1 );
-		xQueueSendFromISR( xRxedChars, &cChar, &xHigherPriorityTaskWoken );
-	}	
-	
-	portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
-}
+		/* The DMA channel counts down the bytes left before it wraps. */
+		return serRX_DMA_BUFFER_SIZE - ( size_t ) DMA_GetCurrDataCounter( pxPort->pxHardware->pxRxDMAChannel );
+	}
+	/*-----------------------------------------------------------*/
 
+	static portBASE_TYPE prvRxDMAProcess( xSerialPort *pxPort, size_t xWriteIndex )
+	{
+	portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+	size_t xBytes, xSent;
+	const size_t xReadIndex = pxPort->xRxDMAReadIndex;
 
+		/* The DMA channel counts down, so reaches the end of the buffer as the
+		counter reloads - treat that as index 0. */
+		if( xWriteIndex >= serRX_DMA_BUFFER_SIZE )
+		{
+			xWriteIndex = 0;
+		}
 
+		if( xWriteIndex != xReadIndex )
+		{
+			if( xWriteIndex > xReadIndex )
+			{
+				/* The new bytes are contiguous. */
+				xBytes = xWriteIndex - xReadIndex;
+				xSent = xStreamBufferSendFromISR( pxPort->xRxStreamBuffer, &( pxPort->ucRxDMABuffer[ xReadIndex ] ), xBytes, &xHigherPriorityTaskWoken );
+			}
+			else
+			{
+				/* The new bytes wrap around the end of the buffer, or end
+				exactly at it. */
+				xBytes = ( serRX_DMA_BUFFER_SIZE - xReadIndex ) + xWriteIndex;
+				xSent = xStreamBufferSendFromISR( pxPort->xRxStreamBuffer, &( pxPort->ucRxDMABuffer[ xReadIndex ] ), serRX_DMA_BUFFER_SIZE - xReadIndex, &xHigherPriorityTaskWoken );
 
+				if( xWriteIndex > 0 )
+				{
+					xSent += xStreamBufferSendFromISR( pxPort->xRxStreamBuffer, pxPort->ucRxDMABuffer, xWriteIndex, &xHigherPriorityTaskWoken );
+				}
+			}
 
-	
+			/* Anything that did not fit in the stream buffer is lost. */
+			pxPort->xStats.ulRxDroppedBytes += ( uint32_t ) ( xBytes - xSent );
+			pxPort->xRxDMAReadIndex = xWriteIndex;
+		}
+
+		return xHigherPriorityTaskWoken;
+	}
+	/*-----------------------------------------------------------*/
+
+	static portBASE_TYPE prvTxDMAStart( xSerialPort *pxPort )
+	{
+	DMA_Channel_TypeDef * const pxChannel = pxPort->pxHardware->pxTxDMAChannel;
+	portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+	size_t xBytes;
+
+		if( pxPort->xTxDMABusy == pdFALSE )
+		{
+			xBytes = xStreamBufferReceiveFromISR( pxPort->xTxStreamBuffer, pxPort->ucTxDMABuffer, sizeof( pxPort->ucTxDMABuffer ), &xHigherPriorityTaskWoken );
+
+			if( xBytes > 0 )
+			{
+				pxPort->xTxDMABusy = pdTRUE;
+				DMA_Cmd( pxChannel, DISABLE );
+				pxChannel->CNDTR = ( u32 ) xBytes;
+				DMA_Cmd( pxChannel, ENABLE );
+			}
+		}
+
+		return xHigherPriorityTaskWoken;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTxKick( xSerialPort *pxPort )
+	{
+	portBASE_TYPE xHigherPriorityTaskWoken;
+
+		/* The transmit stream buffer is read both here and from the DMA
+		interrupt, so the read and the channel update are made with interrupts
+		masked. */
+		portENTER_CRITICAL();
+		{
+			xHigherPriorityTaskWoken = prvTxDMAStart( pxPort );
+		}
+		portEXIT_CRITICAL();
+
+		/* Space was made in the stream buffer, which may have unblocked a
+		writer. */
+		if( xHigherPriorityTaskWoken != pdFALSE )
+		{
+			taskYIELD();
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTxDMAHandler( xSerialPort *pxPort )
+	{
+	const xSerialHardware * const pxHardware = pxPort->pxHardware;
+	portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+
+		if( DMA_GetITStatus( pxHardware->ulTxDMAITTC ) == SET )
+		{
+			/* The block has been written to the USART.  Send the next one, if
+			there is one. */
+			DMA_ClearITPendingBit( pxHardware->ulTxDMAITGL );
+			pxPort->xTxDMABusy = pdFALSE;
+			xHigherPriorityTaskWoken = prvTxDMAStart( pxPort );
+		}
+
+		portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvRxDMAHandler( xSerialPort *pxPort )
+	{
+	const xSerialHardware * const pxHardware = pxPort->pxHardware;
+	portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+
+		if( ( DMA_GetITStatus( pxHardware->ulRxDMAITHT ) == SET ) || ( DMA_GetITStatus( pxHardware->ulRxDMAITTC ) == SET ) )
+		{
+			/* Half or all of the buffer has been filled. */
+			DMA_ClearITPendingBit( pxHardware->ulRxDMAITGL );
+			xHigherPriorityTaskWoken = prvRxDMAProcess( pxPort, prvRxDMAWriteIndex( pxPort ) );
+		}
+
+		portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvUSARTHandler( xSerialPort *pxPort )
+	{
+	USART_TypeDef * const pxUSART = pxPort->pxHardware->pxUSART;
+	portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+
+		if( USART_GetFlagStatus( pxUSART, USART_FLAG_ORE ) == SET )
+		{
+			/* The DMA channel was held off for longer than a character time.
+			The flag is cleared by reading the data register. */
+			pxPort->xStats.ulRxOverruns++;
+			( void ) USART_ReceiveData( pxUSART );
+		}
+
+		if( USART_GetITStatus( pxUSART, USART_IT_IDLE ) == SET )
+		{
+			/* The line has been idle for a character time, so a message has
+			ended part way through the DMA buffer.  The flag is cleared by
+			reading the status register, done above, then the data register. */
+			( void ) USART_ReceiveData( pxUSART );
+			xHigherPriorityTaskWoken = prvRxDMAProcess( pxPort, prvRxDMAWriteIndex( pxPort ) );
+		}
+
+		portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+	}
+
+#else /* serUSE_DMA */
+
+	static void prvUSARTHandler( xSerialPort *pxPort )
+	{
+	USART_TypeDef * const pxUSART = pxPort->pxHardware->pxUSART;
+	portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+	char cChar;
+
+		if( USART_GetITStatus( pxUSART, USART_IT_TXE ) == SET )
+		{
+			/* The interrupt was caused by the THR becoming empty.  Are there any
+			more characters to transmit? */
+			if( xQueueReceiveFromISR( pxPort->xCharsForTx, &cChar, &xHigherPriorityTaskWoken ) == pdTRUE )
+			{
+				/* A character was retrieved from the queue so can be sent to the
+				THR now. */
+				USART_SendData( pxUSART, cChar );
+			}
+			else
+			{
+				USART_ITConfig( pxUSART, USART_IT_TXE, DISABLE );		
+			}		
+		}
+
+		if( USART_GetFlagStatus( pxUSART, USART_FLAG_ORE ) == SET )
+		{
+			/* A character arrived before the last was read.  The flag is
+			cleared by the read of the data register below. */
+			pxPort->xStats.ulRxOverruns++;
+		}
+		
+		if( USART_GetITStatus( pxUSART, USART_IT_RXNE ) == SET )
+		{
+			cChar = USART_ReceiveData( pxUSART );
+
+			if( xQueueSendFromISR( pxPort->xRxedChars, &cChar, &xHigherPriorityTaskWoken ) != pdPASS )
+			{
+				pxPort->xStats.ulRxDroppedBytes++;
+			}
+		}	
+		
+		portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+	}
+
+#endif /* serUSE_DMA */
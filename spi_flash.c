@@ -20,6 +20,11 @@
 /* Includes ------------------------------------------------------------------*/
 #include "spi_flash.h"
 
+#if SPI_FLASH_USE_RTOS == 1
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+
 /* Private typedef -----------------------------------------------------------*/
 #define SPI_FLASH_PageSize 256
 
@@ -28,6 +33,7 @@
 #define WREN       0x06  /* Write enable instruction */
 
 #define READ       0x03  /* Read from Memory instruction */
+#define FAST_READ  0x0B  /* Read from Memory at higher speed instruction */
 #define RDSR       0x05  /* Read Status Register instruction  */
 #define RDID       0x9F  /* Read identification */
 #define SE         0xD8  /* Sector Erase instruction */
@@ -38,9 +44,61 @@
 #define Dummy_Byte 0xA5
 
 /* Private define ------------------------------------------------------------*/
+#if SPI_FLASH_USE_RTOS == 1
+/* Transfers shorter than this are polled, as they take less time than setting
+   up the DMA channels and blocking the calling task. */
+#define SPI_FLASH_DMAThreshold   16
+
+/* The notification index used to signal the end of a DMA transfer to the
+   calling task. The driver must be the only user of this index. */
+#ifndef SPI_FLASH_NotifyIndex
+#define SPI_FLASH_NotifyIndex    ( configTASK_NOTIFICATION_ARRAY_ENTRIES - 1 )
+#endif
+
+/* The largest number of bytes moved by one DMA transfer. Longer blocks are
+   split. */
+#define SPI_FLASH_DMAMaxBlock    0xFFFF
+
+/* A DMA transfer of 65535 bytes takes 29ms with the SPI clock at 18MHz. */
+#define SPI_FLASH_DMATimeout     pdMS_TO_TICKS( 100 )
+
+/* The longest delay between two reads of the status register while the FLASH
+   is busy. The delay starts at one tick and doubles up to this value, so a page
+   program (about 1.4ms) is seen to end within a tick or two, while a sector
+   erase (about 1s) is polled a few dozen times. */
+#define SPI_FLASH_WIPMaxDelay    pdMS_TO_TICKS( 32 )
+#endif
+
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+#if SPI_FLASH_USE_RTOS == 1
+/* The task waiting for the current DMA transfer to end. */
+static TaskHandle_t DMAWaitingTask = NULL;
+
+/* Whether bulk transfers use the DMA, see SPI_FLASH_DMACmd(). */
+static FunctionalState DMAState = ENABLE;
+
+/* The byte sent by the DMA while reading, and the byte received into while
+   writing. */
+static u8 DMADummyTx = Dummy_Byte;
+static u8 DMADummyRx;
+
+/* Set while a transfer started by SPI_FLASH_ReadStreamStart() has not been
+   waited for. */
+static u8 DMAStreamPending = 0;
+#endif
+
 /* Private function prototypes -----------------------------------------------*/
+static void SPI_FLASH_TransferBlock(u8* pTxBuffer, u8* pRxBuffer, u32 NumByte);
+static u8 SPI_FLASH_ReadStatus(void);
+
+#if SPI_FLASH_USE_RTOS == 1
+static u8 SPI_FLASH_CanBlock(void);
+static void SPI_FLASH_DMAStart(u8* pTxBuffer, u8* pRxBuffer, u16 NumByte);
+static void SPI_FLASH_DMAWait(void);
+void DMAChannel2_IRQHandler(void);
+#endif
+
 /* Private functions ---------------------------------------------------------*/
 
 /*******************************************************************************
@@ -80,13 +138,50 @@ void SPI_FLASH_Init(void)
   SPI_InitStructure.SPI_CPOL = SPI_CPOL_High;
   SPI_InitStructure.SPI_CPHA = SPI_CPHA_2Edge;
   SPI_InitStructure.SPI_NSS = SPI_NSS_Soft;
-  SPI_InitStructure.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_4;
+  SPI_InitStructure.SPI_BaudRatePrescaler = SPI_FLASH_BaudRatePrescaler;
   SPI_InitStructure.SPI_FirstBit = SPI_FirstBit_MSB;
   SPI_InitStructure.SPI_CRCPolynomial = 7;
   SPI_Init(SPI1, &SPI_InitStructure);
   
   /* Enable SPI1  */
   SPI_Cmd(SPI1, ENABLE);   
+
+#if SPI_FLASH_USE_RTOS == 1
+  {
+    NVIC_InitTypeDef NVIC_InitStructure;
+
+    /* SPI1 Rx is served by DMA channel 2 and Tx by DMA channel 3. The end of a
+       transfer is signalled by the Rx channel, as the last byte received is
+       the end of the last byte sent. */
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA, ENABLE);
+    SPI_DMACmd(SPI1, SPI_DMAReq_Rx | SPI_DMAReq_Tx, ENABLE);
+
+    NVIC_InitStructure.NVIC_IRQChannel = DMAChannel2_IRQChannel;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = configLIBRARY_KERNEL_INTERRUPT_PRIORITY;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+  }
+#endif
+}
+
+/*******************************************************************************
+* Function Name  : SPI_FLASH_DMACmd
+* Description    : Enables or disables the use of the DMA for bulk transfers.
+*                  The DMA is only used when SPI_FLASH_USE_RTOS is 1, and the
+*                  driver is called from a task.
+* Input          : NewState: new state of the DMA use.
+*                  This parameter can be: ENABLE or DISABLE.
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void SPI_FLASH_DMACmd(FunctionalState NewState)
+{
+#if SPI_FLASH_USE_RTOS == 1
+  DMAState = NewState;
+#else
+  (void) NewState;
+#endif
 }
 
 /*******************************************************************************
@@ -172,14 +267,8 @@ void SPI_FLASH_PageWrite(u8* pBuffer, u32 WriteAddr, u16 NumByteToWrite)
   /* Send WriteAddr low nibble address byte to write to */
   SPI_FLASH_SendByte(WriteAddr & 0xFF);             
   
-  /* while there is data to be written on the FLASH */
-  while(NumByteToWrite--) 
-  {
-    /* Send the current byte */			
-    SPI_FLASH_SendByte(*pBuffer); 	               
-    /* Point on the next byte to be written */
-    pBuffer++; 
-  }		
+  /* Send the data to be written on the FLASH */
+  SPI_FLASH_TransferBlock(pBuffer, 0, NumByteToWrite);
   
   /* Deselect the FLASH: Chip Select high */
   SPI_FLASH_ChipSelect(High);
@@ -277,34 +366,18 @@ void SPI_FLASH_BufferWrite(u8* pBuffer, u32 WriteAddr, u16 NumByteToWrite)
 *                    from the FLASH.
 *                  - ReadAddr : FLASH's internal address to read from.
 *                  - NumByteToRead : number of bytes to read from the FLASH.
+*                    The whole FLASH can be read with a single call.
 * Output         : None
 * Return         : None
 *******************************************************************************/
-void SPI_FLASH_BufferRead(u8* pBuffer, u32 ReadAddr, u16 NumByteToRead)
+void SPI_FLASH_BufferRead(u8* pBuffer, u32 ReadAddr, u32 NumByteToRead)
 {
-  /* Select the FLASH: Chip Select low */
-  SPI_FLASH_ChipSelect(Low);	   
-  
-  /* Send "Read from Memory " instruction */
-  SPI_FLASH_SendByte(READ);	 
-  
-  /* Send ReadAddr high nibble address byte to read from */
-  SPI_FLASH_SendByte((ReadAddr & 0xFF0000) >> 16);
-  /* Send ReadAddr medium nibble address byte to read from */
-  SPI_FLASH_SendByte((ReadAddr& 0xFF00) >> 8);  
-  /* Send ReadAddr low nibble address byte to read from */
-  SPI_FLASH_SendByte(ReadAddr & 0xFF);     
-   	
-  while(NumByteToRead--) /* while there is data to be read */
-  {
-    /* Read a byte from the FLASH */			
-    *pBuffer = SPI_FLASH_SendByte(Dummy_Byte);   
-    /* Point to the next location where the byte read will be saved */
-    pBuffer++;
-  }	
-  
-  /* Deselect the FLASH: Chip Select high */
-  SPI_FLASH_ChipSelect(High);		
+  SPI_FLASH_StartReadSequence(ReadAddr);
+
+  /* Read the data from the FLASH */
+  SPI_FLASH_ReadStream(pBuffer, NumByteToRead);
+
+  SPI_FLASH_EndReadSequence();
 }
 
 /*******************************************************************************
@@ -349,6 +422,8 @@ u32 SPI_FLASH_ReadID(void)
 *                  address. This function exit and keep the /CS line low, so the
 *                  Flash still being selected. With this technique the whole
 *                  content of the Flash is read with a single READ instruction.
+*                  When SPI_FLASH_USE_FAST_READ is 1 the FAST_READ instruction
+*                  and its dummy byte are sent instead.
 * Input          : - ReadAddr : FLASH's internal address to read from.
 * Output         : None
 * Return         : None
@@ -358,8 +433,13 @@ void SPI_FLASH_StartReadSequence(u32 ReadAddr)
   /* Select the FLASH: Chip Select low */
   SPI_FLASH_ChipSelect(Low);	   
   
+#if SPI_FLASH_USE_FAST_READ == 1
+  /* Send "Read from Memory at higher speed" instruction */
+  SPI_FLASH_SendByte(FAST_READ);
+#else
   /* Send "Read from Memory " instruction */
   SPI_FLASH_SendByte(READ);	 
+#endif
 
 /* Send the 24-bit address of the address to read from -----------------------*/  
   /* Send ReadAddr high nibble address byte */
@@ -368,6 +448,99 @@ void SPI_FLASH_StartReadSequence(u32 ReadAddr)
   SPI_FLASH_SendByte((ReadAddr& 0xFF00) >> 8);  
   /* Send ReadAddr low nibble address byte */
   SPI_FLASH_SendByte(ReadAddr & 0xFF);  
+
+#if SPI_FLASH_USE_FAST_READ == 1
+  /* Send the dummy byte that gives the FLASH time to fetch the first byte */
+  SPI_FLASH_SendByte(Dummy_Byte);
+#endif
+}
+
+/*******************************************************************************
+* Function Name  : SPI_FLASH_ReadStream
+* Description    : Reads the next bytes of a read sequence started by
+*                  SPI_FLASH_StartReadSequence(). The FLASH's address is
+*                  incremented after each byte, so successive calls return
+*                  successive blocks of the FLASH, across page and sector
+*                  boundaries.
+* Input          : - pBuffer : pointer to the buffer that receives the data read
+*                    from the FLASH.
+*                  - NumByteToRead : number of bytes to read from the FLASH.
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void SPI_FLASH_ReadStream(u8* pBuffer, u32 NumByteToRead)
+{
+  /* Finish any block started by SPI_FLASH_ReadStreamStart() first */
+  SPI_FLASH_ReadStreamWait();
+
+  SPI_FLASH_TransferBlock(0, pBuffer, NumByteToRead);
+}
+
+/*******************************************************************************
+* Function Name  : SPI_FLASH_ReadStreamStart
+* Description    : Starts reading the next bytes of a read sequence into
+*                  pBuffer and, when the DMA is used, returns before they have
+*                  arrived. The calling task can then work on the block read
+*                  before, and calls SPI_FLASH_ReadStreamWait() before using
+*                  pBuffer. When the DMA is not used the bytes are read before
+*                  the function returns.
+*                  Only the task that started the block may wait for it.
+* Input          : - pBuffer : pointer to the buffer that receives the data read
+*                    from the FLASH.
+*                  - NumByteToRead : number of bytes to read from the FLASH.
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void SPI_FLASH_ReadStreamStart(u8* pBuffer, u16 NumByteToRead)
+{
+  /* Only one block can be in progress */
+  SPI_FLASH_ReadStreamWait();
+
+#if SPI_FLASH_USE_RTOS == 1
+  if((DMAState == ENABLE) && (NumByteToRead >= SPI_FLASH_DMAThreshold) && SPI_FLASH_CanBlock())
+  {
+    DMAStreamPending = 1;
+    SPI_FLASH_DMAStart(0, pBuffer, NumByteToRead);
+    return;
+  }
+#endif
+
+  SPI_FLASH_TransferBlock(0, pBuffer, NumByteToRead);
+}
+
+/*******************************************************************************
+* Function Name  : SPI_FLASH_ReadStreamWait
+* Description    : Waits for the block started by SPI_FLASH_ReadStreamStart()
+*                  to be read. Returns at once if there is none.
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void SPI_FLASH_ReadStreamWait(void)
+{
+#if SPI_FLASH_USE_RTOS == 1
+  if(DMAStreamPending != 0)
+  {
+    SPI_FLASH_DMAWait();
+    DMAStreamPending = 0;
+  }
+#endif
+}
+
+/*******************************************************************************
+* Function Name  : SPI_FLASH_EndReadSequence
+* Description    : Ends a read sequence started by SPI_FLASH_StartReadSequence()
+*                  by driving the /CS line high.
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void SPI_FLASH_EndReadSequence(void)
+{
+  SPI_FLASH_ReadStreamWait();
+
+  /* Deselect the FLASH: Chip Select high */
+  SPI_FLASH_ChipSelect(High);
 }
 
 /*******************************************************************************
@@ -474,6 +647,27 @@ void SPI_FLASH_WriteEnable(void)
 void SPI_FLASH_WaitForWriteEnd(void) 
 {
   u8 FLASH_Status = 0;
+
+#if SPI_FLASH_USE_RTOS == 1
+  TickType_t Delay = 1;
+
+  if(SPI_FLASH_CanBlock())
+  {
+    /* Let other tasks run while the FLASH is busy, reading the status
+       register less and less often the longer the operation takes */
+    while((SPI_FLASH_ReadStatus() & WIP_Flag) == SET)
+    {
+      vTaskDelay(Delay);
+
+      if(Delay < SPI_FLASH_WIPMaxDelay)
+      {
+        Delay <<= 1;
+      }
+    }
+
+    return;
+  }
+#endif
   
   /* Select the FLASH: Chip Select low */
   SPI_FLASH_ChipSelect(Low);
@@ -495,4 +689,203 @@ void SPI_FLASH_WaitForWriteEnd(void)
   SPI_FLASH_ChipSelect(High);	 	
 }
 
+/*******************************************************************************
+* Function Name  : SPI_FLASH_ReadStatus
+* Description    : Reads the FLASH's status register.
+* Input          : None
+* Output         : None
+* Return         : The value of the status register.
+*******************************************************************************/
+static u8 SPI_FLASH_ReadStatus(void)
+{
+  u8 FLASH_Status = 0;
+
+  /* Select the FLASH: Chip Select low */
+  SPI_FLASH_ChipSelect(Low);
+
+  /* Send "Read Status Register" instruction */
+  SPI_FLASH_SendByte(RDSR);
+
+  /* Send a dummy byte to generate the clock needed by the FLASH */
+  FLASH_Status = SPI_FLASH_SendByte(Dummy_Byte);
+
+  /* Deselect the FLASH: Chip Select high */
+  SPI_FLASH_ChipSelect(High);
+
+  return FLASH_Status;
+}
+
+/*******************************************************************************
+* Function Name  : SPI_FLASH_TransferBlock
+* Description    : Sends and receives a block of bytes through the SPI
+*                  interface, with the DMA if it can be used, otherwise one
+*                  byte at a time.
+* Input          : - pTxBuffer : the bytes to send, or 0 to send dummy bytes.
+*                  - pRxBuffer : the buffer that receives the bytes read, or 0
+*                    to discard them.
+*                  - NumByte : number of bytes to transfer.
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void SPI_FLASH_TransferBlock(u8* pTxBuffer, u8* pRxBuffer, u32 NumByte)
+{
+  u8 Byte;
+
+#if SPI_FLASH_USE_RTOS == 1
+  u16 Block;
+
+  if((DMAState == ENABLE) && (NumByte >= SPI_FLASH_DMAThreshold) && SPI_FLASH_CanBlock())
+  {
+    while(NumByte != 0)
+    {
+      Block = (NumByte > SPI_FLASH_DMAMaxBlock) ? SPI_FLASH_DMAMaxBlock : (u16)NumByte;
+
+      SPI_FLASH_DMAStart(pTxBuffer, pRxBuffer, Block);
+      SPI_FLASH_DMAWait();
+
+      if(pTxBuffer != 0)
+      {
+        pTxBuffer += Block;
+      }
+
+      if(pRxBuffer != 0)
+      {
+        pRxBuffer += Block;
+      }
+
+      NumByte -= Block;
+    }
+
+    return;
+  }
+#endif
+
+  while(NumByte--)
+  {
+    Byte = SPI_FLASH_SendByte((pTxBuffer != 0) ? *pTxBuffer++ : Dummy_Byte);
+
+    if(pRxBuffer != 0)
+    {
+      *pRxBuffer++ = Byte;
+    }
+  }
+}
+
+#if SPI_FLASH_USE_RTOS == 1
+/*******************************************************************************
+* Function Name  : SPI_FLASH_CanBlock
+* Description    : Checks whether the driver was called from a task that can
+*                  block.
+* Input          : None
+* Output         : None
+* Return         : 1 if the scheduler is running and the caller is not an
+*                  interrupt, otherwise 0.
+*******************************************************************************/
+static u8 SPI_FLASH_CanBlock(void)
+{
+  return (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) &&
+         (xPortIsInsideInterrupt() == pdFALSE);
+}
+
+/*******************************************************************************
+* Function Name  : SPI_FLASH_DMAStart
+* Description    : Starts the transfer of a block of bytes with DMA channels 2
+*                  and 3. SPI_FLASH_DMAWait() must be called by the same task
+*                  before the next transfer is started.
+* Input          : - pTxBuffer : the bytes to send, or 0 to send dummy bytes.
+*                  - pRxBuffer : the buffer that receives the bytes read, or 0
+*                    to discard them.
+*                  - NumByte : number of bytes to transfer.
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void SPI_FLASH_DMAStart(u8* pTxBuffer, u8* pRxBuffer, u16 NumByte)
+{
+  DMA_InitTypeDef DMA_InitStructure;
+
+  DMA_InitStructure.DMA_PeripheralBaseAddr = (u32)&(SPI1->DR);
+  DMA_InitStructure.DMA_BufferSize = NumByte;
+  DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+  DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+  DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+  DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+  DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+
+  /* Rx: SPI1 DR into the buffer, or into a single dummy byte */
+  DMA_DeInit(DMA_Channel2);
+  DMA_InitStructure.DMA_MemoryBaseAddr = (pRxBuffer != 0) ? (u32)pRxBuffer : (u32)&DMADummyRx;
+  DMA_InitStructure.DMA_MemoryInc = (pRxBuffer != 0) ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+  DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+  DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+  DMA_Init(DMA_Channel2, &DMA_InitStructure);
+  DMA_ITConfig(DMA_Channel2, DMA_IT_TC, ENABLE);
+
+  /* Tx: the buffer, or the same dummy byte repeatedly, into SPI1 DR */
+  DMA_DeInit(DMA_Channel3);
+  DMA_InitStructure.DMA_MemoryBaseAddr = (pTxBuffer != 0) ? (u32)pTxBuffer : (u32)&DMADummyTx;
+  DMA_InitStructure.DMA_MemoryInc = (pTxBuffer != 0) ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+  DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+  DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+  DMA_Init(DMA_Channel3, &DMA_InitStructure);
+
+  /* Start the Rx channel first so no received byte is missed */
+  DMAWaitingTask = xTaskGetCurrentTaskHandle();
+  DMA_Cmd(DMA_Channel2, ENABLE);
+  DMA_Cmd(DMA_Channel3, ENABLE);
+}
+
+/*******************************************************************************
+* Function Name  : SPI_FLASH_DMAWait
+* Description    : Blocks the calling task until the transfer started by
+*                  SPI_FLASH_DMAStart() has ended.
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void SPI_FLASH_DMAWait(void)
+{
+  if(ulTaskNotifyTakeIndexed(SPI_FLASH_NotifyIndex, pdTRUE, SPI_FLASH_DMATimeout) == 0)
+  {
+    /* The transfer did not end - stop it, then clear the notification in case
+       the interrupt was taken before the channels were stopped */
+    taskENTER_CRITICAL();
+    {
+      DMA_Cmd(DMA_Channel3, DISABLE);
+      DMA_Cmd(DMA_Channel2, DISABLE);
+      DMAWaitingTask = NULL;
+    }
+    taskEXIT_CRITICAL();
+
+    (void) ulTaskNotifyTakeIndexed(SPI_FLASH_NotifyIndex, pdTRUE, 0);
+  }
+}
+
+/*******************************************************************************
+* Function Name  : DMAChannel2_IRQHandler
+* Description    : Handles the end of a SPI1 DMA transfer.
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+void DMAChannel2_IRQHandler(void)
+{
+  BaseType_t HigherPriorityTaskWoken = pdFALSE;
+
+  if(DMA_GetITStatus(DMA_IT_TC2) != RESET)
+  {
+    DMA_ClearITPendingBit(DMA_IT_GL2);
+    DMA_Cmd(DMA_Channel3, DISABLE);
+    DMA_Cmd(DMA_Channel2, DISABLE);
+
+    if(DMAWaitingTask != NULL)
+    {
+      vTaskNotifyGiveIndexedFromISR(DMAWaitingTask, SPI_FLASH_NotifyIndex, &HigherPriorityTaskWoken);
+      DMAWaitingTask = NULL;
+    }
+  }
+
+  portEND_SWITCHING_ISR(HigherPriorityTaskWoken);
+}
+#endif /* SPI_FLASH_USE_RTOS */
+
 /******************* (C) COPYRIGHT 2007 STMicroelectronics *****END OF FILE****/
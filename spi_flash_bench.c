@@ -0,0 +1,112 @@
+/* SPI FLASH throughput benchmarks, see spi_flash_bench.h. */
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Library includes. */
+#include "spi_flash.h"
+
+/* Demo application includes. */
+#include "KernelBench.h"
+#include "spi_flash_bench.h"
+
+/* The size of the sectors and of the pages written. */
+#define benchSPI_FLASH_SECTOR_SIZE	( 0x10000UL )
+#define benchSPI_FLASH_PAGE_SIZE	( 256UL )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Initialises the driver the first time it is called, and selects polling or
+ * the DMA.
+ */
+static BaseType_t prvSPIFlashSetUp( uint32_t ulUseDMA );
+
+/*
+ * Read or write one page, returning the cycles taken.
+ */
+static uint32_t prvSPIFlashReadIteration( void );
+static uint32_t prvSPIFlashWriteIteration( void );
+
+/*-----------------------------------------------------------*/
+
+static const BenchCase_t xSPIFlashCases[] =
+{
+	{ "SPI_FLASH_BufferRead 256 polled",  prvSPIFlashReadIteration,  NULL, 0, prvSPIFlashSetUp, NULL, 0 },
+	{ "SPI_FLASH_BufferRead 256 DMA",     prvSPIFlashReadIteration,  NULL, 0, prvSPIFlashSetUp, NULL, 1 },
+	{ "SPI_FLASH_BufferWrite 256 polled", prvSPIFlashWriteIteration, NULL, 0, prvSPIFlashSetUp, NULL, 0 },
+	{ "SPI_FLASH_BufferWrite 256 DMA",    prvSPIFlashWriteIteration, NULL, 0, prvSPIFlashSetUp, NULL, 1 }
+};
+
+#define benchSPI_FLASH_CASES	( sizeof( xSPIFlashCases ) / sizeof( xSPIFlashCases[ 0 ] ) )
+
+static BenchHistogram_t xSPIFlashHistograms[ benchSPI_FLASH_CASES ];
+
+static BenchSuite_t xSPIFlashSuite = { xSPIFlashCases, xSPIFlashHistograms, ( UBaseType_t ) benchSPI_FLASH_CASES, pdFALSE, NULL };
+
+/* The page read and written. */
+static u8 ucPage[ benchSPI_FLASH_PAGE_SIZE ];
+
+/* The next address written by the write benchmarks, relative to
+benchSPI_FLASH_ADDRESS.  The sector is erased each time it is full. */
+static uint32_t ulSPIFlashOffset = 0;
+
+/*-----------------------------------------------------------*/
+
+void vStartSPIFlashBenchmarks( UBaseType_t uxPriority )
+{
+	vStartBenchmarkSuite( &xSPIFlashSuite, uxPriority );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvSPIFlashSetUp( uint32_t ulUseDMA )
+{
+static BaseType_t xInitialised = pdFALSE;
+
+	if( xInitialised == pdFALSE )
+	{
+		SPI_FLASH_Init();
+		xInitialised = pdTRUE;
+	}
+
+	SPI_FLASH_DMACmd( ( ulUseDMA != 0UL ) ? ENABLE : DISABLE );
+
+	/* Start each write benchmark on a freshly erased sector. */
+	ulSPIFlashOffset = benchSPI_FLASH_SECTOR_SIZE;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSPIFlashReadIteration( void )
+{
+uint32_t ulStart = benchGET_CYCLE_COUNT();
+
+	SPI_FLASH_BufferRead( ucPage, benchSPI_FLASH_ADDRESS, ( u32 ) benchSPI_FLASH_PAGE_SIZE );
+
+	return benchGET_CYCLE_COUNT() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSPIFlashWriteIteration( void )
+{
+uint32_t ulStart;
+
+	if( ulSPIFlashOffset >= benchSPI_FLASH_SECTOR_SIZE )
+	{
+		SPI_FLASH_SectorErase( benchSPI_FLASH_ADDRESS );
+		ulSPIFlashOffset = 0;
+	}
+
+	ucPage[ 0 ]++;
+	ulStart = benchGET_CYCLE_COUNT();
+
+	SPI_FLASH_BufferWrite( ucPage, benchSPI_FLASH_ADDRESS + ulSPIFlashOffset, ( u16 ) benchSPI_FLASH_PAGE_SIZE );
+
+	ulStart = benchGET_CYCLE_COUNT() - ulStart;
+	ulSPIFlashOffset += benchSPI_FLASH_PAGE_SIZE;
+
+	return ulStart;
+}
+/*-----------------------------------------------------------*/
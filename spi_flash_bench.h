@@ -0,0 +1,35 @@
+#ifndef SPI_FLASH_BENCH_H
+#define SPI_FLASH_BENCH_H
+
+#include "FreeRTOS.h"
+
+/*
+ * SPI FLASH throughput benchmarks, run and reported as a suite of the
+ * benchmarks of KernelBench.h.
+ *
+ * The throughput of SPI_FLASH_BufferRead() and SPI_FLASH_BufferWrite() is
+ * measured for 256 byte pages, once polled and once with the DMA selected by
+ * SPI_FLASH_DMACmd().  Each write iteration includes the wait for the page
+ * program to end.  The sector at benchSPI_FLASH_ADDRESS is erased by the
+ * write benchmarks, so it must not hold anything needed.  Erasing is not
+ * included in the times.
+ */
+
+/* Set to 1 for main.c to run the SPI FLASH benchmarks with the kernel
+benchmarks. */
+#ifndef benchSPI_FLASH
+	#define benchSPI_FLASH			0
+#endif
+
+/* The sector used by the benchmarks. */
+#ifndef benchSPI_FLASH_ADDRESS
+	#define benchSPI_FLASH_ADDRESS	( 0x7F0000UL )
+#endif
+
+/*
+ * Starts the SPI FLASH benchmarks, which run once every suite of benchmarks
+ * started before them has been reported.
+ */
+void vStartSPIFlashBenchmarks( UBaseType_t uxPriority );
+
+#endif /* SPI_FLASH_BENCH_H */
@@ -34,6 +34,9 @@
 #include "stm32f10x_tim.h"
 #include "stm32f10x_map.h"
 
+/* Demo application includes. */
+#include "jitter.h"
+
 /* The set frequency of the interrupt.  Deviations from this are measured as
 the jitter. */
 #define timerINTERRUPT_FREQUENCY		( ( unsigned short ) 20000 )
@@ -47,6 +50,7 @@ zero. */
 
 /* Misc defines. */
 #define timerMAX_32BIT_VALUE			( 0xffffffffUL )
+#define timerMAX_16BIT_VALUE			( 0xffffUL )
 #define timerTIMER_1_COUNT_VALUE		( * ( ( unsigned long * ) ( TIMER1_BASE + 0x48 ) ) )
 
 /* The number of interrupts to pass before we start looking at the jitter. */
@@ -62,9 +66,17 @@ void vSetupTimerTest( void );
 /* Interrupt handler in which the jitter is measured. */
 void vTimer2IntHandler( void );
 
+/*
+ * Writes the timer 2 jitter histogram over the serial port.
+ */
+void vTimerTestReportJitter( void );
+
 /* Stores the value of the maximum recorded jitter between interrupts. */
 volatile unsigned short usMaxJitter = 0;
 
+/* The distribution of the jitter between interrupts. */
+static JitterHistogram_t xTimer2Jitter;
+
 /*-----------------------------------------------------------*/
 
 void vSetupTimerTest( void )
@@ -74,6 +86,8 @@ TIM_TimeBaseInitTypeDef  TIM_TimeBaseStructure;
 NVIC_InitTypeDef NVIC_InitStructure;
 
 
+	vJitterInit( &xTimer2Jitter, timerEXPECTED_DIFFERENCE_VALUE, timerMAX_16BIT_VALUE, timerSETTLE_TIME );
+
 	/* Enable timer clocks */
 	RCC_APB1PeriphClockCmd( RCC_APB1Periph_TIM2, ENABLE );
 	RCC_APB1PeriphClockCmd( RCC_APB1Periph_TIM3, ENABLE );
@@ -115,46 +129,19 @@ NVIC_InitTypeDef NVIC_InitStructure;
 
 void vTimer2IntHandler( void )
 {
-static unsigned short usLastCount = 0, usSettleCount = 0, usMaxDifference = 0;
-unsigned short usThisCount, usDifference;
-
 	/* Capture the free running timer 3 value as we enter the interrupt. */
-	usThisCount = TIM3->CNT;
-	
-	if( usSettleCount >= timerSETTLE_TIME )
-	{
-		/* What is the difference between the timer value in this interrupt
-		and the value from the last interrupt. */
-		usDifference = usThisCount - usLastCount;
-
-		/* Store the difference in the timer values if it is larger than the
-		currently stored largest value.  The difference over and above the
-		expected difference will give the 'jitter' in the processing of these
-		interrupts. */
-		if( usDifference > usMaxDifference )
-		{
-			usMaxDifference = usDifference;
-			usMaxJitter = usMaxDifference - timerEXPECTED_DIFFERENCE_VALUE;
-		}
-	}
-	else
-	{
-		/* Don't bother storing any values for the first couple of
-		interrupts. */
-		usSettleCount++;
-	}
-
-	/* Remember what the timer value was this time through, so we can calculate
-	the difference the next time through. */
-	usLastCount = usThisCount;
+	vJitterRecordFromISR( &xTimer2Jitter, TIM3->CNT );
+
+	/* The difference over and above the expected difference gives the
+	'jitter' in the processing of these interrupts. */
+	usMaxJitter = ( unsigned short ) xTimer2Jitter.ulMaxDeviation;
 
     TIM_ClearITPendingBit( TIM2, TIM_IT_Update );
 }
+/*-----------------------------------------------------------*/
 
-
-
-
-
-
-
-
+void vTimerTestReportJitter( void )
+{
+	vJitterReport( &xTimer2Jitter, "TIM2" );
+}
+/*-----------------------------------------------------------*/